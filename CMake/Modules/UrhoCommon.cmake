@@ -167,6 +167,8 @@ if (CMAKE_PROJECT_NAME STREQUAL Urho3D)
     # On Windows platform Direct3D11 can be optionally chosen
     # Using Direct3D11 on non-MSVC compiler may require copying and renaming Microsoft official libraries (.lib to .a), else link failures or non-functioning graphics may result
     cmake_dependent_option (URHO3D_D3D11 "Use Direct3D11 instead of Direct3D9 (Windows platform only); overrides URHO3D_OPENGL option" FALSE "WIN32" FALSE)
+    # The null graphics backend runs the whole rendering pipeline without a GPU device, e.g. for profiling and regression testing on build servers
+    option (URHO3D_NULL_GRAPHICS "Use the null graphics backend which records draw calls and state changes instead of rendering; overrides URHO3D_OPENGL and URHO3D_D3D11 options")
     if (MINGW AND CMAKE_CXX_COMPILER_VERSION VERSION_LESS 4.9.1)
         if (NOT DEFINED URHO3D_SSE)     # Only give the warning once during initial configuration
             # Certain MinGW versions fail to compile SSE code. This is the initial guess for known "bad" version range, and can be tightened later
@@ -346,7 +348,11 @@ if (RPI)
     set_property (CACHE RPI_ABI PROPERTY STRINGS ${RPI_SUPPORTED_ABIS})
 endif ()
 # Handle mutually exclusive options and implied options
-if (URHO3D_D3D11)
+if (URHO3D_NULL_GRAPHICS)
+    set (URHO3D_D3D11 0)
+    unset (URHO3D_D3D11 CACHE)
+endif ()
+if (URHO3D_D3D11 OR URHO3D_NULL_GRAPHICS)
     set (URHO3D_OPENGL 0)
     unset (URHO3D_OPENGL CACHE)
 endif ()
@@ -460,7 +466,7 @@ endforeach ()
 if (WIN32 AND NOT CMAKE_PROJECT_NAME MATCHES ^Urho3D-ExternalProject-)
     set (DIRECTX_REQUIRED_COMPONENTS)
     set (DIRECTX_OPTIONAL_COMPONENTS DInput DSound XAudio2 XInput)
-    if (NOT URHO3D_OPENGL)
+    if (NOT URHO3D_OPENGL AND NOT URHO3D_NULL_GRAPHICS)
         if (URHO3D_D3D11)
             list (APPEND DIRECTX_REQUIRED_COMPONENTS D3D11)
         else ()
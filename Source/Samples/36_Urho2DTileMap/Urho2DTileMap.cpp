@@ -30,8 +30,8 @@
 #include <Urho3D/Graphics/Renderer.h>
 #include <Urho3D/Resource/ResourceCache.h>
 #include <Urho3D/Scene/Scene.h>
-#include <Urho3D/Urho2D/StaticSprite2D.h>
 #include <Urho3D/UI/Text.h>
+#include <Urho3D/Urho2D/StaticSprite2D.h>
 #include <Urho3D/Urho2D/TileMap2D.h>
 #include <Urho3D/Urho2D/TileMapLayer2D.h>
 #include <Urho3D/Urho2D/TmxFile2D.h>
@@ -202,20 +202,19 @@ void Urho2DTileMap::HandleMouseButtonDown(StringHash eventType, VariantMap& even
     int x, y;
     if (map->PositionToTileIndex(x, y, pos))
     {
-        // Get tile's sprite. Note that layer.GetTile(x, y).sprite is read-only, so we get the sprite through tile's node
-        Node* n = layer->GetTileNode(x, y);
-        if (!n)
+        // Tiles are drawn in chunks rather than through a node per tile, so they are replaced through the layer
+        Tile2D* tile = layer->GetTile(x, y);
+        if (!tile)
             return;
-        StaticSprite2D* sprite = n->GetComponent<StaticSprite2D>();
 
         if (input->GetMouseButtonDown(MOUSEB_RIGHT))
         {
             // Swap grass and water
-            if (layer->GetTile(x, y)->GetGid() < 9) // First 8 sprites in the "isometric_grass_and_water.png" tileset are mostly grass and from 9 to 24 they are mostly water
-                sprite->SetSprite(layer->GetTile(0, 0)->GetSprite()); // Replace grass by water sprite used in top tile
-            else sprite->SetSprite(layer->GetTile(24, 24)->GetSprite()); // Replace water by grass sprite used in bottom tile
+            if (tile->GetGid() < 9) // First 8 sprites in the "isometric_grass_and_water.png" tileset are mostly grass and from 9 to 24 they are mostly water
+                layer->SetTile(x, y, layer->GetTile(0, 0)); // Replace grass by water tile used in top tile
+            else layer->SetTile(x, y, layer->GetTile(24, 24)); // Replace water by grass tile used in bottom tile
         }
-        else sprite->SetSprite(NULL); // 'Remove' sprite
+        else layer->SetTile(x, y, 0); // Remove tile
     }
 }
 
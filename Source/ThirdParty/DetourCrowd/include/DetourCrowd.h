@@ -191,6 +191,8 @@ enum UpdateFlags
 	DT_CROWD_SEPARATION = 4,
 	DT_CROWD_OPTIMIZE_VIS = 8,			///< Use #dtPathCorridor::optimizePathVisibility() to optimize the agent path.
 	DT_CROWD_OPTIMIZE_TOPO = 16,		///< Use dtPathCorridor::optimizePathTopology() to optimize the agent path.
+	// Urho3D: Add support for skipping velocity sampling
+	DT_CROWD_SKIP_AVOIDANCE = 32,		///< Keep the previous avoidance velocity instead of sampling a new one during this update.
 };
 
 struct dtCrowdAgentDebugInfo
@@ -204,6 +206,13 @@ struct dtCrowdAgentDebugInfo
 /// Type for the update callback.
 typedef void (*dtUpdateCallback)(dtCrowdAgent* ag, float dt);
 
+// Urho3D: Add parallel update support
+class dtCrowd;
+/// Type for the parallel update callback. It must call dtCrowd::updateAgents() for ranges covering all the
+/// given agents, giving each concurrently executing range a distinct thread index, and return only after all
+/// the ranges have been processed.
+typedef void (*dtParallelUpdateCallback)(dtCrowd* crowd, dtCrowdAgent** agents, const int nagents, void* userData);
+
 /// Provides local steering behaviors for a group of agents. 
 /// @ingroup crowd
 class dtCrowd
@@ -234,6 +243,21 @@ class dtCrowd
 
 	dtNavMeshQuery* m_navquery;
 
+	// Urho3D: Add parallel update support
+	dtParallelUpdateCallback m_parallelCallback;
+	void* m_parallelUserData;
+	int m_maxThreads;
+	dtNavMeshQuery** m_threadNavQueries;
+	dtObstacleAvoidanceQuery** m_threadObstacleQueries;
+	int* m_threadVelocitySampleCounts;
+	int m_numActiveAgents;
+	int m_updatePhase;
+	float m_updateDt;
+	dtCrowdAgentDebugInfo* m_updateDebug;
+
+	void runUpdatePhase(const int phase, dtCrowdAgent** agents, const int nagents);
+	void purgeThreads();
+
 	void updateTopologyOptimization(dtCrowdAgent** agents, const int nagents, const float dt);
 	void updateMoveRequest(const float dt);
 	void checkPathValidity(dtCrowdAgent** agents, const int nagents, const float dt);
@@ -330,6 +354,26 @@ public:
 	///  @param[in]		dt		The time, in seconds, to update the simulation. [Limit: > 0]
 	///  @param[out]	debug	A debug object to load with debug information. [Opt]
 	void update(const float dt, dtCrowdAgentDebugInfo* debug);
+
+	// Urho3D: Add parallel update support
+	/// Allocates the per-thread query objects and sets the callback used to run the per-agent update phases in parallel.
+	///  @param[in]		maxThreads	The maximum number of concurrently executing ranges, including the calling thread. [Limit: >= 1]
+	///  @param[in]		cb			The parallel update callback, or null to update serially.
+	///  @param[in]		userData	User data passed to the callback.
+	/// @return True if the initialization succeeded.
+	bool initThreads(const int maxThreads, dtParallelUpdateCallback cb, void* userData);
+
+	// Urho3D: Add parallel update support
+	/// Runs the current update phase for a range of the agents passed to the parallel update callback.
+	///  @param[in]		begin		The first agent of the range.
+	///  @param[in]		end			One past the last agent of the range.
+	///  @param[in]		threadIndex	The index of the executing thread. [Limits: 0 <= value < maxThreads given to #initThreads()]
+	void updateAgents(dtCrowdAgent** begin, dtCrowdAgent** end, const int threadIndex);
+
+	// Urho3D: Add parallel update support
+	/// The maximum number of concurrently executing ranges the crowd has been initialized for.
+	/// @return The maximum number of threads.
+	int getMaxThreads() const { return m_maxThreads; }
 	
 	/// Gets the filter used by the crowd.
 	/// @return The filter used by the crowd.
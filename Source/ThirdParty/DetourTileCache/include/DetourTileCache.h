@@ -119,6 +119,16 @@ public:
 	
 	dtStatus buildNavMeshTile(const dtCompressedTileRef ref, class dtNavMesh* navmesh);
 	
+	// Urho3D: added functions for building the pending tile updates outside the tile cache, e.g. on worker threads
+	void processObstacleRequests();
+	int getUpdateCount() const { return m_nupdate; }
+	dtCompressedTileRef getUpdate(const int i) const { return m_update[i]; }
+	dtStatus buildNavMeshTileData(const dtCompressedTileRef ref, struct dtTileCacheAlloc* talloc,
+								  unsigned char** navData, int* navDataSize) const;
+	dtStatus addNavMeshTileData(const dtCompressedTileRef ref, unsigned char* navData, const int navDataSize,
+								class dtNavMesh* navmesh);
+	void completeUpdates(const int count);
+	
 	void calcTightTileBounds(const struct dtTileCacheLayerHeader* header, float* bmin, float* bmax) const;
 	
 	void getObstacleBounds(const struct dtTileCacheObstacle* ob, float* bmin, float* bmax) const;
@@ -126,6 +136,12 @@ public:
     // Urho3D: added function to know when we have too many obstacle requests without update
     bool isObstacleQueueFull() const { return m_nreqs >= MAX_REQUESTS; }
 
+    // Urho3D: added function to know whether there are obstacle requests or tile updates pending
+    bool isUpToDate() const { return m_nreqs == 0 && m_nupdate == 0; }
+
+    // Urho3D: added function to know the number of obstacle requests not yet turned into tile updates
+    int getRequestCount() const { return m_nreqs; }
+
 	/// Encodes a tile id.
 	inline dtCompressedTileRef encodeTileId(unsigned int salt, unsigned int it) const
 	{
@@ -204,7 +220,8 @@ private:
 	ObstacleRequest m_reqs[MAX_REQUESTS];
 	int m_nreqs;
 	
-	static const int MAX_UPDATE = 64;
+	// Urho3D: increased from 64 so that large obstacle batches are coalesced into one update list
+	static const int MAX_UPDATE = 1024;
 	dtCompressedTileRef m_update[MAX_UPDATE];
 	int m_nupdate;
 	
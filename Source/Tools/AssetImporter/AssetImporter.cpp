@@ -170,7 +170,12 @@ bool noOverwriteTexture_ = false;
 bool noOverwriteNewerTexture_ = false;
 bool checkUniqueModel_ = true;
 bool moveToBindPose_ = false;
+bool compressAnimations_ = false;
 unsigned maxBones_ = 64;
+unsigned lodLevels_ = 0;
+float lodRatio_ = 0.5f;
+float lodDistance_ = 10.0f;
+unsigned lodStreamLevels_ = 0;
 Vector<String> nonSkinningBoneIncludes_;
 Vector<String> nonSkinningBoneExcludes_;
 
@@ -310,9 +315,17 @@ void Run(const Vector<String>& arguments)
             "-ctn        Check and do not overwrite if texture has newer timestamp\n"
             "-am         Export all meshes even if identical (scene mode only)\n"
             "-bp         Move bones to bind pose before saving model\n"
+            "-ca         Compress animations: quantize keyframes and remove redundant ones\n"
             "-split <start> <end> (animation model only)\n"
             "            Split animation, will only import from start frame to end frame\n"
             "-np         Do not suppress $fbx pivot nodes (FBX files only)\n"
+            "-lod <x>    Generate x simplified LOD levels for models\n"
+            "-lodratio <x> Triangle ratio of each generated LOD level to the previous. Default 0.5\n"
+            "-loddist <x> LOD distance of the first generated level, doubled for each\n"
+            "            further level. Default 10\n"
+            "-lodstream <x> Save the full LOD chain as a separate <output>_Detail.mdl model and\n"
+            "            leave out the x finest levels from the output model. The detail\n"
+            "            model is streamed in when the finer levels are needed\n"
         );
     }
 
@@ -412,6 +425,26 @@ void Run(const Vector<String>& arguments)
 
                 }
             }
+            else if (argument == "lod" && !value.Empty())
+            {
+                lodLevels_ = ToUInt(value);
+                ++i;
+            }
+            else if (argument == "lodratio" && !value.Empty())
+            {
+                lodRatio_ = ToFloat(value);
+                ++i;
+            }
+            else if (argument == "loddist" && !value.Empty())
+            {
+                lodDistance_ = ToFloat(value);
+                ++i;
+            }
+            else if (argument == "lodstream" && !value.Empty())
+            {
+                lodStreamLevels_ = ToUInt(value);
+                ++i;
+            }
             else if (argument == "mb" && !value.Empty())
             {
                 maxBones_ = ToUInt(value);
@@ -463,6 +496,8 @@ void Run(const Vector<String>& arguments)
                 checkUniqueModel_ = false;
             else if (argument == "bp")
                 moveToBindPose_ = true;
+            else if (argument == "ca")
+                compressAnimations_ = true;
             else if (argument == "split")
             {
                 String value2 = i + 2 < arguments.Size() ? arguments[i + 2] : String::EMPTY;
@@ -1225,6 +1260,33 @@ void BuildAndSaveModel(OutModel& model)
             outModel->SetGeometryBoneMappings(allBoneMappings);
     }
 
+    if (lodLevels_)
+    {
+        if (!outModel->GenerateLodLevels(lodLevels_, lodRatio_, lodDistance_))
+            PrintLine("Warning: could not generate LOD levels for model " + model.outName_);
+        else if (lodStreamLevels_)
+        {
+            // Save the full LOD chain as the detail model, then keep only the coarse levels in the output model
+            String detailOutName = GetPath(model.outName_) + GetFileName(model.outName_) + "_Detail.mdl";
+            File detailFile(context_);
+            if (!detailFile.Open(detailOutName, FILE_WRITE))
+                ErrorExit("Could not open output file " + detailOutName);
+            outModel->Save(detailFile);
+
+            String detailResourceName = detailOutName.StartsWith(resourcePath_) ?
+                detailOutName.Substring(resourcePath_.Length()) :
+                (useSubdirs_ ? "Models/" : "") + GetFileNameAndExtension(detailOutName);
+            SharedPtr<Model> coarseModel = outModel->CloneLodLevels(lodStreamLevels_);
+            if (coarseModel)
+            {
+                coarseModel->AddMetadata("DetailModel", detailResourceName);
+                outModel = coarseModel;
+            }
+            else
+                PrintLine("Warning: could not split streamed LOD levels of model " + model.outName_);
+        }
+    }
+
     File outFile(context_);
     if (!outFile.Open(model.outName_, FILE_WRITE))
         ErrorExit("Could not open output file " + model.outName_);
@@ -1486,6 +1548,9 @@ void BuildAndSaveAnimations(OutModel* model)
             }
         }
 
+        if (compressAnimations_)
+            outAnim->Compress();
+
         File outFile(context_);
         if (!outFile.Open(animOutName, FILE_WRITE))
             ErrorExit("Could not open output file " + animOutName);
@@ -0,0 +1,552 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifdef URHO3D_ANGELSCRIPT
+#include <Urho3D/AngelScript/Script.h>
+#endif
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/Main.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Graphics.h>
+#ifdef URHO3D_NULL_GRAPHICS
+#include <Urho3D/Graphics/GraphicsImpl.h>
+#endif
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/Renderer.h>
+#include <Urho3D/Graphics/Viewport.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#ifdef URHO3D_LUA
+#include <Urho3D/LuaScript/LuaScript.h>
+#endif
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Resource/JSONFile.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include "Urho3DBenchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+URHO3D_DEFINE_APPLICATION_MAIN(Urho3DBenchmark);
+
+static const unsigned DEFAULT_FRAMES = 1000;
+static const unsigned DEFAULT_WARMUP_FRAMES = 10;
+static const float DEFAULT_TIMESTEP = 1.0f / 60.0f;
+static const unsigned DEFAULT_SEED = 1;
+
+Urho3DBenchmark::Urho3DBenchmark(Context* context) :
+    Application(context),
+    numFrames_(DEFAULT_FRAMES),
+    numWarmupFrames_(DEFAULT_WARMUP_FRAMES),
+    timeStep_(DEFAULT_TIMESTEP),
+    seed_(DEFAULT_SEED),
+    threadedSubmission_(false),
+    visibilityCaching_(true),
+    finished_(false)
+{
+}
+
+void Urho3DBenchmark::Setup()
+{
+    if (!ParseOptions())
+    {
+        ErrorExit("Usage: Urho3DBenchmark <scenefile> [options]\n\n"
+            "Loads the scene and runs it headless for a fixed number of frames with a fixed timestep, then writes "
+            "per-frame timings of the main engine phases as JSON. When built with the null graphics backend, the scene "
+            "is also rendered and the view update and render timings and draw counts are included.\n"
+            "\nBenchmark options:\n"
+            "-frames <num>    Number of measured frames, default 1000\n"
+            "-warmup <num>    Number of unmeasured frames to run first, default 10\n"
+            "-timestep <sec>  Fixed frame timestep in seconds, default 1/60\n"
+            "-seed <num>      Random seed, default 1\n"
+            "-input <file>    Recorded controls (JSON) to replay, sent as ReplayControls events\n"
+            "-output <file>   Write the report to a file instead of the standard output\n"
+            "-camera <name>   Camera node used for drawable updates, default first camera in the scene or a\n"
+            "                 camera overlooking the scene origin when rendering\n"
+            "-threadedsubmission\n"
+            "                 Record the rendering and replay it on the render submission thread\n"
+            "-novisibilitycache\n"
+            "                 Query the octree for visible drawables from scratch on every frame\n"
+            "\nEngine options such as -p, -pp, -pf, -log and -nothreads are also accepted.\n"
+        );
+        return;
+    }
+
+    // The benchmark is always headless, silent and free-running; timing comes from the fixed timestep. The null graphics
+    // backend needs no window or GPU, so then the render pipeline is run and measured too
+#ifdef URHO3D_NULL_GRAPHICS
+    engineParameters_[EP_HEADLESS] = false;
+#else
+    engineParameters_[EP_HEADLESS] = true;
+#endif
+    engineParameters_[EP_SOUND] = false;
+    engineParameters_[EP_FRAME_LIMITER] = false;
+    if (!engineParameters_.Contains(EP_LOG_QUIET))
+        engineParameters_[EP_LOG_QUIET] = outputFileName_.Empty();
+    engineParameters_[EP_LOG_NAME] = GetSubsystem<FileSystem>()->GetAppPreferencesDir("urho3d", "logs") +
+        GetFileNameAndExtension(sceneFileName_) + ".benchmark.log";
+
+    if (!engineParameters_.Contains(EP_RESOURCE_PREFIX_PATHS))
+        engineParameters_[EP_RESOURCE_PREFIX_PATHS] = ";../share/Resources;../share/Urho3D/Resources";
+}
+
+void Urho3DBenchmark::Start()
+{
+    if (!GetSubsystem<Profiler>())
+    {
+        ErrorExit("Profiling is not enabled; rebuild with URHO3D_PROFILING to run benchmarks");
+        return;
+    }
+
+    // Script subsystems must exist before the scene is loaded, so that script instances can be created
+#ifdef URHO3D_ANGELSCRIPT
+    context_->RegisterSubsystem(new Script(context_));
+#endif
+#ifdef URHO3D_LUA
+    context_->RegisterSubsystem(new LuaScript(context_));
+#endif
+
+    // Seed before loading, as components may use random numbers already while being created
+    SetRandomSeed(seed_);
+
+    if (!LoadScene() || !LoadControls())
+    {
+        ErrorExit();
+        return;
+    }
+
+    BenchmarkPhase phase;
+    phase.name_ = "Scene";
+    phase.blocks_.Push("UpdateScene");
+    phases_.Push(phase);
+    phase.name_ = "Physics";
+    phase.blocks_.Clear();
+    phase.blocks_.Push("UpdatePhysics");
+    phase.blocks_.Push("UpdatePhysics2D");
+    phases_.Push(phase);
+    phase.name_ = "Octree";
+    phase.blocks_.Clear();
+    phase.blocks_.Push("UpdateOctree");
+    phases_.Push(phase);
+    phase.name_ = "Network";
+    phase.blocks_.Clear();
+    phase.blocks_.Push("UpdateNetwork");
+    phase.blocks_.Push("PostUpdateNetwork");
+    phases_.Push(phase);
+    phase.name_ = "Script";
+    phase.blocks_.Clear();
+    phase.blocks_.Push("ExecuteFunction");
+    phase.blocks_.Push("ExecuteMethod");
+    phases_.Push(phase);
+
+    Renderer* renderer = GetSubsystem<Renderer>();
+    if (renderer)
+    {
+        // The renderer updates the octree as part of the view update, so the Octree phase is included in ViewUpdate
+        renderer->SetViewport(0, new Viewport(context_, scene_, camera_));
+        renderer->SetThreadedSubmission(threadedSubmission_);
+        renderer->SetVisibilityCaching(visibilityCaching_);
+
+        phase.name_ = "ViewUpdate";
+        phase.blocks_.Clear();
+        phase.blocks_.Push("UpdateViews");
+        phases_.Push(phase);
+        phase.name_ = "ViewRender";
+        phase.blocks_.Clear();
+        phase.blocks_.Push("RenderViews");
+        phases_.Push(phase);
+
+        const char* counterNames[] = {
+            "Batches",
+            "Primitives",
+            "VisibilityCacheHits",
+            "VisibilityCacheMisses",
+#ifdef URHO3D_NULL_GRAPHICS
+            "ShaderChanges",
+            "ShaderParameterUpdates",
+            "TextureChanges",
+            "RenderTargetChanges",
+            "StateChanges",
+            "BufferUpdateBytes",
+#endif
+            0
+        };
+        for (unsigned i = 0; counterNames[i]; ++i)
+        {
+            BenchmarkCounter counter;
+            counter.name_ = counterNames[i];
+            counters_.Push(counter);
+        }
+    }
+    else
+        SubscribeToEvent(E_RENDERUPDATE, URHO3D_HANDLER(Urho3DBenchmark, HandleRenderUpdate));
+
+    // Drive the frames here instead of the application main loop, so that the timestep can be overridden before each
+    // frame and the profiler data read right after it
+    unsigned totalFrames = numWarmupFrames_ + numFrames_;
+    for (unsigned i = 0; i < totalFrames && !engine_->IsExiting(); ++i)
+    {
+        HiresTimer frameTimer;
+        RunFrame(i);
+        if (i >= numWarmupFrames_)
+        {
+            CollectTimings(frameTimer.GetUSec(false));
+            CollectCounters();
+        }
+    }
+
+    finished_ = frameTimes_.Size() == numFrames_;
+    if (!finished_)
+        URHO3D_LOGERROR("Benchmark was interrupted after " + String(frameTimes_.Size()) + " measured frames");
+
+    engine_->Exit();
+}
+
+void Urho3DBenchmark::Stop()
+{
+    if (scene_)
+        WriteReport();
+
+    scene_.Reset();
+}
+
+bool Urho3DBenchmark::ParseOptions()
+{
+    const Vector<String>& arguments = GetArguments();
+
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].Length() > 1 && arguments[i][0] == '-')
+        {
+            String argument = arguments[i].Substring(1).ToLower();
+            String value = i + 1 < arguments.Size() ? arguments[i + 1] : String::EMPTY;
+
+            if (argument == "frames" && !value.Empty())
+            {
+                numFrames_ = Max(ToUInt(value), 1U);
+                ++i;
+            }
+            else if (argument == "warmup" && !value.Empty())
+            {
+                numWarmupFrames_ = ToUInt(value);
+                ++i;
+            }
+            else if (argument == "timestep" && !value.Empty())
+            {
+                timeStep_ = Max(ToFloat(value), M_EPSILON);
+                ++i;
+            }
+            else if (argument == "seed" && !value.Empty())
+            {
+                seed_ = ToUInt(value);
+                ++i;
+            }
+            else if (argument == "input" && !value.Empty())
+            {
+                controlsFileName_ = GetInternalPath(value);
+                ++i;
+            }
+            else if (argument == "output" && !value.Empty())
+            {
+                outputFileName_ = GetInternalPath(value);
+                ++i;
+            }
+            else if (argument == "camera" && !value.Empty())
+            {
+                cameraNodeName_ = value;
+                ++i;
+            }
+            else if (argument == "threadedsubmission")
+                threadedSubmission_ = true;
+            else if (argument == "novisibilitycache")
+                visibilityCaching_ = false;
+        }
+        else if (i == 0)
+            sceneFileName_ = GetInternalPath(arguments[0]);
+    }
+
+    return !sceneFileName_.Empty();
+}
+
+bool Urho3DBenchmark::LoadScene()
+{
+    SharedPtr<File> file = GetSubsystem<ResourceCache>()->GetFile(sceneFileName_);
+    if (!file)
+        return false;
+
+    scene_ = new Scene(context_);
+
+    String extension = GetExtension(sceneFileName_);
+    bool success;
+    if (extension == ".xml")
+        success = scene_->LoadXML(*file);
+    else if (extension == ".json")
+        success = scene_->LoadJSON(*file);
+    else
+        success = scene_->Load(*file);
+
+    if (!success)
+    {
+        URHO3D_LOGERROR("Failed to load scene " + sceneFileName_);
+        return false;
+    }
+
+    if (!scene_->GetComponent<Octree>())
+        URHO3D_LOGWARNING("Scene " + sceneFileName_ + " has no octree, drawable updates are not measured");
+
+    Node* cameraNode = cameraNodeName_.Empty() ? 0 : scene_->GetChild(cameraNodeName_, true);
+    if (cameraNode)
+        camera_ = cameraNode->GetComponent<Camera>();
+    else if (!cameraNodeName_.Empty())
+        URHO3D_LOGWARNING("Camera node " + cameraNodeName_ + " not found");
+    if (!camera_)
+        camera_ = scene_->GetComponent<Camera>(true);
+
+    // Scene files usually leave the camera to the application. When rendering, add a local camera overlooking the scene
+    // origin so that there is something to draw
+    if (!camera_ && GetSubsystem<Renderer>())
+    {
+        Node* defaultCameraNode = scene_->CreateChild("BenchmarkCamera", LOCAL);
+        defaultCameraNode->SetPosition(Vector3(0.0f, 10.0f, -20.0f));
+        defaultCameraNode->LookAt(Vector3::ZERO);
+        camera_ = defaultCameraNode->CreateComponent<Camera>(LOCAL);
+    }
+
+    return true;
+}
+
+bool Urho3DBenchmark::LoadControls()
+{
+    if (controlsFileName_.Empty())
+        return true;
+
+    SharedPtr<JSONFile> controlsFile(new JSONFile(context_));
+    File file(context_, controlsFileName_);
+    if (!file.IsOpen() || !controlsFile->Load(file))
+    {
+        URHO3D_LOGERROR("Failed to load recorded controls " + controlsFileName_);
+        return false;
+    }
+
+    const JSONArray& frames = controlsFile->GetRoot().Get("frames").GetArray();
+    for (unsigned i = 0; i < frames.Size(); ++i)
+    {
+        const JSONValue& frame = frames[i];
+        Controls controls;
+        controls.buttons_ = frame.Get("buttons").GetUInt();
+        controls.yaw_ = frame.Get("yaw").GetFloat();
+        controls.pitch_ = frame.Get("pitch").GetFloat();
+        if (frame.Contains("extraData"))
+            controls.extraData_ = frame.Get("extraData").GetVariantMap();
+        recordedControls_[frame.Get("frame").GetUInt()] = controls;
+    }
+
+    URHO3D_LOGINFO("Loaded " + String(recordedControls_.Size()) + " recorded controls frames");
+    return true;
+}
+
+void Urho3DBenchmark::RunFrame(unsigned frameNumber)
+{
+    SendControls(frameNumber);
+
+    // Any timestep computed by the frame limiter is overridden, so the simulation is identical from run to run
+    engine_->SetNextTimeStep(timeStep_);
+    engine_->RunFrame();
+}
+
+void Urho3DBenchmark::SendControls(unsigned frameNumber)
+{
+    if (recordedControls_.Empty())
+        return;
+
+    HashMap<unsigned, Controls>::ConstIterator i = recordedControls_.Find(frameNumber);
+    if (i != recordedControls_.End())
+        controls_ = i->second_;
+
+    using namespace ReplayControls;
+
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_FRAME] = (int)frameNumber;
+    eventData[P_SCENE] = scene_.Get();
+    eventData[P_BUTTONS] = controls_.buttons_;
+    eventData[P_YAW] = controls_.yaw_;
+    eventData[P_PITCH] = controls_.pitch_;
+    eventData[P_EXTRADATA] = controls_.extraData_;
+    SendEvent(E_REPLAYCONTROLS, eventData);
+}
+
+void Urho3DBenchmark::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
+{
+    Octree* octree = scene_->GetComponent<Octree>();
+    if (!octree)
+        return;
+
+    using namespace RenderUpdate;
+
+    FrameInfo frame;
+    frame.frameNumber_ = GetSubsystem<Time>()->GetFrameNumber();
+    frame.timeStep_ = eventData[P_TIMESTEP].GetFloat();
+    frame.viewSize_ = IntVector2::ZERO;
+    frame.camera_ = camera_;
+    octree->Update(frame);
+}
+
+void Urho3DBenchmark::CollectTimings(long long frameTime)
+{
+    const ProfilerBlock* root = GetSubsystem<Profiler>()->GetRootBlock();
+
+    for (unsigned i = 0; i < phases_.Size(); ++i)
+        phases_[i].times_.Push(GetBlockTime(root, phases_[i].blocks_));
+    frameTimes_.Push(frameTime);
+}
+
+void Urho3DBenchmark::CollectCounters()
+{
+    if (counters_.Empty())
+        return;
+
+    // With threaded submission Engine::RunFrame() has already waited for the replay, so the counters are complete
+    Renderer* renderer = GetSubsystem<Renderer>();
+
+    Graphics* graphics = GetSubsystem<Graphics>();
+    unsigned index = 0;
+    counters_[index++].values_.Push(graphics->GetNumBatches());
+    counters_[index++].values_.Push(graphics->GetNumPrimitives());
+    counters_[index++].values_.Push(renderer->GetNumVisibilityCacheHits(true));
+    counters_[index++].values_.Push(renderer->GetNumVisibilityCacheMisses(true));
+#ifdef URHO3D_NULL_GRAPHICS
+    const NullGraphicsStatistics& stats = graphics->GetImpl()->GetFrameStatistics();
+    counters_[index++].values_.Push(stats.shaderChanges_);
+    counters_[index++].values_.Push(stats.shaderParameterUpdates_);
+    counters_[index++].values_.Push(stats.textureChanges_ + stats.samplerChanges_);
+    counters_[index++].values_.Push(stats.renderTargetChanges_ + stats.viewportChanges_);
+    counters_[index++].values_.Push(stats.renderStateChanges_);
+    counters_[index++].values_.Push(stats.bufferUpdateBytes_);
+#endif
+}
+
+long long Urho3DBenchmark::GetBlockTime(const ProfilerBlock* block, const Vector<String>& names) const
+{
+    long long time = 0;
+
+    for (PODVector<ProfilerBlock*>::ConstIterator i = block->children_.Begin(); i != block->children_.End(); ++i)
+    {
+        const ProfilerBlock* child = *i;
+        if (names.Contains(String(child->name_)))
+            time += child->frameTime_;
+        else
+            time += GetBlockTime(child, names);
+    }
+
+    return time;
+}
+
+void Urho3DBenchmark::WriteReport()
+{
+    SharedPtr<JSONFile> report(new JSONFile(context_));
+    JSONValue& root = report->GetRoot();
+
+    root.Set("scene", sceneFileName_);
+    root.Set("frames", frameTimes_.Size());
+    root.Set("warmupFrames", numWarmupFrames_);
+    root.Set("timeStep", timeStep_);
+    root.Set("seed", seed_);
+    root.Set("finished", finished_);
+
+    JSONValue summary;
+    JSONValue total;
+    WriteSummary(total, frameTimes_);
+    summary.Set("Total", total);
+    for (unsigned i = 0; i < phases_.Size(); ++i)
+    {
+        JSONValue phase;
+        WriteSummary(phase, phases_[i].times_);
+        summary.Set(phases_[i].name_, phase);
+    }
+    root.Set("summary", summary);
+
+    if (counters_.Size())
+    {
+        JSONValue counterSummary;
+        for (unsigned i = 0; i < counters_.Size(); ++i)
+        {
+            JSONValue counter;
+            WriteSummary(counter, counters_[i].values_);
+            counterSummary.Set(counters_[i].name_, counter);
+        }
+        root.Set("counters", counterSummary);
+    }
+
+    JSONArray frames;
+    frames.Reserve(frameTimes_.Size());
+    for (unsigned i = 0; i < frameTimes_.Size(); ++i)
+    {
+        JSONValue frame;
+        frame.Set("frame", i);
+        frame.Set("Total", (double)frameTimes_[i]);
+        for (unsigned j = 0; j < phases_.Size(); ++j)
+            frame.Set(phases_[j].name_, (double)phases_[j].times_[i]);
+        for (unsigned j = 0; j < counters_.Size(); ++j)
+            frame.Set(counters_[j].name_, (double)counters_[j].values_[i]);
+        frames.Push(frame);
+    }
+    root.Set("frameTimes", frames);
+
+    if (!outputFileName_.Empty())
+    {
+        File file(context_, outputFileName_, FILE_WRITE);
+        if (!file.IsOpen() || !report->Save(file))
+            URHO3D_LOGERROR("Failed to write benchmark report " + outputFileName_);
+    }
+    else
+    {
+        VectorBuffer buffer;
+        report->Save(buffer);
+        PrintLine(String((const char*)buffer.GetData(), buffer.GetSize()));
+    }
+}
+
+void Urho3DBenchmark::WriteSummary(JSONValue& dest, const PODVector<long long>& times) const
+{
+    long long minTime = times.Size() ? M_MAX_INT : 0;
+    long long maxTime = 0;
+    long long sum = 0;
+
+    for (unsigned i = 0; i < times.Size(); ++i)
+    {
+        minTime = Min(minTime, times[i]);
+        maxTime = Max(maxTime, times[i]);
+        sum += times[i];
+    }
+
+    dest.Set("min", (double)minTime);
+    dest.Set("max", (double)maxTime);
+    dest.Set("avg", times.Size() ? (double)sum / times.Size() : 0.0);
+}
@@ -0,0 +1,147 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Engine/Application.h>
+#include <Urho3D/Input/Controls.h>
+
+namespace Urho3D
+{
+
+class Camera;
+class JSONValue;
+class ProfilerBlock;
+class Scene;
+
+}
+
+using namespace Urho3D;
+
+/// Recorded controls replayed to the scene before each benchmark frame. Scene logic (script objects or custom components) can subscribe to this instead of reading Input.
+URHO3D_EVENT(E_REPLAYCONTROLS, ReplayControls)
+{
+    URHO3D_PARAM(P_FRAME, Frame);                  // int
+    URHO3D_PARAM(P_SCENE, Scene);                  // Scene pointer
+    URHO3D_PARAM(P_BUTTONS, Buttons);              // unsigned
+    URHO3D_PARAM(P_YAW, Yaw);                      // float
+    URHO3D_PARAM(P_PITCH, Pitch);                  // float
+    URHO3D_PARAM(P_EXTRADATA, ExtraData);          // VariantMap
+}
+
+/// Measured subsystem phase, identified by the profiler block names that are summed into it.
+struct BenchmarkPhase
+{
+    /// Phase name used in the JSON output.
+    String name_;
+    /// Profiler block names belonging to the phase.
+    Vector<String> blocks_;
+    /// Per-frame times in microseconds.
+    PODVector<long long> times_;
+};
+
+/// Per-frame rendering count, such as draw calls or state changes.
+struct BenchmarkCounter
+{
+    /// Counter name used in the JSON output.
+    String name_;
+    /// Per-frame values.
+    PODVector<long long> values_;
+};
+
+/// Urho3DBenchmark application loads a scene and runs it headless for a fixed number of frames with a fixed timestep, writing per-frame subsystem timings as JSON. When built with the null graphics backend, the scene is also rendered and the render phases and draw counts are measured.
+class Urho3DBenchmark : public Application
+{
+    URHO3D_OBJECT(Urho3DBenchmark, Application);
+
+public:
+    /// Construct.
+    Urho3DBenchmark(Context* context);
+
+    /// Setup before engine initialization. Parse the benchmark options and force headless, deterministic engine configuration.
+    virtual void Setup();
+    /// Setup after engine initialization. Load the scene and the recorded controls, then run the benchmark frames.
+    virtual void Start();
+    /// Cleanup after the main loop. Write the timing report.
+    virtual void Stop();
+
+private:
+    /// Parse the benchmark options from the command line. Return false if the scene file is missing.
+    bool ParseOptions();
+    /// Load the scene. Return true if successful.
+    bool LoadScene();
+    /// Load the recorded controls stream. Return true if successful.
+    bool LoadControls();
+    /// Run one benchmark frame.
+    void RunFrame(unsigned frameNumber);
+    /// Send the recorded controls for the frame.
+    void SendControls(unsigned frameNumber);
+    /// Handle render update event. Update the octree explicitly, as the Renderer subsystem which normally does it does not exist in headless mode.
+    void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    /// Collect the profiler data of the finished frame.
+    void CollectTimings(long long frameTime);
+    /// Collect the rendering counts of the finished frame.
+    void CollectCounters();
+    /// Return the summed last frame time of profiler blocks with the given names, not counting nested blocks twice.
+    long long GetBlockTime(const ProfilerBlock* block, const Vector<String>& names) const;
+    /// Write the timing report to the output file or standard output.
+    void WriteReport();
+    /// Add minimum, maximum and average of a timing series to a JSON object.
+    void WriteSummary(JSONValue& dest, const PODVector<long long>& times) const;
+
+    /// Scene file name.
+    String sceneFileName_;
+    /// Recorded controls file name. Empty if not used.
+    String controlsFileName_;
+    /// Report output file name. Empty to print to standard output.
+    String outputFileName_;
+    /// Name of the camera node used for the octree update. Empty to use the first camera found in the scene.
+    String cameraNodeName_;
+    /// Number of measured frames.
+    unsigned numFrames_;
+    /// Number of unmeasured warm-up frames run before the measured frames.
+    unsigned numWarmupFrames_;
+    /// Fixed frame timestep in seconds.
+    float timeStep_;
+    /// Random seed.
+    unsigned seed_;
+    /// Threaded render submission flag.
+    bool threadedSubmission_;
+    /// Visibility caching flag.
+    bool visibilityCaching_;
+    /// Scene.
+    SharedPtr<Scene> scene_;
+    /// Camera used for the octree update.
+    WeakPtr<Camera> camera_;
+    /// Recorded controls keyed by frame number. Frames without an entry repeat the previous controls.
+    HashMap<unsigned, Controls> recordedControls_;
+    /// Controls sent on the current frame.
+    Controls controls_;
+    /// Measured phases.
+    Vector<BenchmarkPhase> phases_;
+    /// Measured rendering counts. Empty unless rendering.
+    Vector<BenchmarkCounter> counters_;
+    /// Total per-frame times in microseconds.
+    PODVector<long long> frameTimes_;
+    /// Benchmark finished flag.
+    bool finished_;
+};
@@ -35,8 +35,10 @@
 #include "../Graphics/Graphics.h"
 #include "../Graphics/IndexBuffer.h"
 #include "../Graphics/Light.h"
+#include "../Graphics/LightClusters.h"
 #include "../Graphics/Material.h"
 #include "../Graphics/Octree.h"
+#include "../Graphics/PagedTerrain.h"
 #include "../Graphics/ParticleEffect.h"
 #include "../Graphics/ParticleEmitter.h"
 #include "../Graphics/Renderer.h"
@@ -379,6 +381,7 @@ static void RegisterRenderPath(asIScriptEngine* engine)
     engine->RegisterObjectProperty("RenderPathCommand", "bool markToStencil", offsetof(RenderPathCommand, markToStencil_));
     engine->RegisterObjectProperty("RenderPathCommand", "bool vertexLights", offsetof(RenderPathCommand, vertexLights_));
     engine->RegisterObjectProperty("RenderPathCommand", "bool useLitBase", offsetof(RenderPathCommand, useLitBase_));
+    engine->RegisterObjectProperty("RenderPathCommand", "bool clusteredLights", offsetof(RenderPathCommand, clusteredLights_));
     engine->RegisterObjectProperty("RenderPathCommand", "String vertexShaderName", offsetof(RenderPathCommand, vertexShaderName_));
     engine->RegisterObjectProperty("RenderPathCommand", "String pixelShaderName", offsetof(RenderPathCommand, pixelShaderName_));
     engine->RegisterObjectProperty("RenderPathCommand", "String vertexShaderDefines", offsetof(RenderPathCommand, vertexShaderDefines_));
@@ -872,6 +875,8 @@ static void RegisterMaterial(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Pass", "bool get_depthWrite() const", asMETHOD(Pass, GetDepthWrite), asCALL_THISCALL);
     engine->RegisterObjectMethod("Pass", "void set_alphaToCoverage(bool)", asMETHOD(Pass, SetAlphaToCoverage), asCALL_THISCALL);
     engine->RegisterObjectMethod("Pass", "bool get_alphaToCoverage() const", asMETHOD(Pass, GetAlphaToCoverage), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Pass", "void set_clusteredLights(bool)", asMETHOD(Pass, SetClusteredLights), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Pass", "bool get_clusteredLights() const", asMETHOD(Pass, GetClusteredLights), asCALL_THISCALL);
     engine->RegisterObjectMethod("Pass", "void set_desktop(bool)", asMETHOD(Technique, SetIsDesktop), asCALL_THISCALL);
     engine->RegisterObjectMethod("Pass", "bool get_desktop() const", asMETHOD(Technique, IsDesktop), asCALL_THISCALL);
     engine->RegisterObjectMethod("Pass", "void set_vertexShader(const String&in)", asMETHOD(Pass, SetVertexShader), asCALL_THISCALL);
@@ -973,6 +978,14 @@ static Model* ModelClone(const String& cloneName, Model* ptr)
     return clone.Get();
 }
 
+static Model* ModelCloneLodLevels(unsigned firstLevel, const String& cloneName, Model* ptr)
+{
+    SharedPtr<Model> clone = ptr->CloneLodLevels(firstLevel, cloneName);
+    if (clone)
+        clone->AddRef();
+    return clone.Get();
+}
+
 static bool ModelSetVertexBuffers(CScriptArray* vertexBuffers, CScriptArray* morphRangeStarts, CScriptArray* morphRangeCounts, Model* ptr)
 {
     Vector<VertexBuffer*> vbRawPtrs = ArrayToVector<VertexBuffer*>(vertexBuffers);
@@ -997,6 +1010,8 @@ static void RegisterModel(asIScriptEngine* engine)
 {
     RegisterResourceWithMetadata<Model>(engine, "Model");
     engine->RegisterObjectMethod("Model", "Model@ Clone(const String&in cloneName = String()) const", asFUNCTION(ModelClone), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("Model", "Model@ CloneLodLevels(uint, const String&in cloneName = String()) const", asFUNCTION(ModelCloneLodLevels), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("Model", "bool GenerateLodLevels(uint, float triangleRatio = 0.5f, float lodDistance = 10.0f)", asMETHOD(Model, GenerateLodLevels), asCALL_THISCALL);
     engine->RegisterObjectMethod("Model", "bool SetVertexBuffers(Array<VertexBuffer@>@+, Array<uint>@+, Array<uint>@+)", asFUNCTION(ModelSetVertexBuffers), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Model", "bool SetIndexBuffers(Array<IndexBuffer@>@+)", asFUNCTION(ModelSetIndexBuffers), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Model", "bool SetGeometry(uint, uint, Geometry@+)", asMETHOD(Model, SetGeometry), asCALL_THISCALL);
@@ -1028,17 +1043,19 @@ static void DestructAnimationKeyFrame(AnimationKeyFrame* ptr)
     ptr->~AnimationKeyFrame();
 }
 
-static AnimationKeyFrame* AnimationTrackGetKeyFrame(unsigned index, AnimationTrack* ptr)
+static AnimationKeyFrame AnimationTrackReadKeyFrame(unsigned index, AnimationTrack* ptr)
 {
+    // Decode a copy, so that reading a compressed track does not decompress it
+    AnimationKeyFrame ret;
     if (index >= ptr->GetNumKeyFrames())
     {
         asIScriptContext* context = asGetActiveContext();
         if (context)
             context->SetException("Index out of bounds");
-        return 0;
     }
     else
-        return ptr->GetKeyFrame(index);
+        ptr->ReadKeyFrame(index, ret);
+    return ret;
 }
 
 static void ConstructAnimationTriggerPoint(AnimationTriggerPoint* ptr)
@@ -1100,9 +1117,11 @@ static void RegisterAnimation(asIScriptEngine* engine)
     engine->RegisterObjectMethod("AnimationTrack", "void InsertKeyFrame(uint, const AnimationKeyFrame&in)", asMETHOD(AnimationTrack, InsertKeyFrame), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimationTrack", "void RemoveKeyFrame(uint)", asMETHOD(AnimationTrack, RemoveKeyFrame), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimationTrack", "void RemoveAllKeyFrames()", asMETHOD(AnimationTrack, RemoveAllKeyFrames), asCALL_THISCALL);
+    engine->RegisterObjectMethod("AnimationTrack", "void Decompress()", asMETHOD(AnimationTrack, Decompress), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimationTrack", "void set_keyFrames(uint, const AnimationKeyFrame&in)", asMETHOD(AnimationTrack, SetKeyFrame), asCALL_THISCALL);
-    engine->RegisterObjectMethod("AnimationTrack", "const AnimationKeyFrame& get_keyFrames(uint) const", asMETHOD(AnimationTrack, GetKeyFrame), asCALL_THISCALL);
+    engine->RegisterObjectMethod("AnimationTrack", "AnimationKeyFrame get_keyFrames(uint) const", asFUNCTION(AnimationTrackReadKeyFrame), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("AnimationTrack", "uint get_numKeyFrames() const", asMETHOD(AnimationTrack, GetNumKeyFrames), asCALL_THISCALL);
+    engine->RegisterObjectMethod("AnimationTrack", "bool get_compressed() const", asMETHOD(AnimationTrack, IsCompressed), asCALL_THISCALL);
     engine->RegisterObjectProperty("AnimationTrack", "uint8 channelMask", offsetof(AnimationTrack, channelMask_));
     engine->RegisterObjectProperty("AnimationTrack", "const String name", offsetof(AnimationTrack, name_));
     engine->RegisterObjectProperty("AnimationTrack", "const StringHash nameHash", offsetof(AnimationTrack, nameHash_));
@@ -1123,6 +1142,9 @@ static void RegisterAnimation(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Animation", "void RemoveTrigger(uint)", asMETHOD(Animation, RemoveTrigger), asCALL_THISCALL);
     engine->RegisterObjectMethod("Animation", "void RemoveAllTriggers()", asMETHOD(Animation, RemoveAllTriggers), asCALL_THISCALL);
     engine->RegisterObjectMethod("Animation", "Animation@ Clone(const String&in cloneName = String()) const", asFUNCTION(AnimationClone), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("Animation", "void Compress(float positionTolerance = 0.001, float rotationTolerance = 0.1, float scaleTolerance = 0.001)", asMETHOD(Animation, Compress), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Animation", "void Decompress()", asMETHOD(Animation, Decompress), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Animation", "bool get_compressed() const", asMETHOD(Animation, IsCompressed), asCALL_THISCALL);
     engine->RegisterObjectMethod("Animation", "void set_animationName(const String&in) const", asMETHOD(Animation, SetAnimationName), asCALL_THISCALL);
     engine->RegisterObjectMethod("Animation", "const String& get_animationName() const", asMETHOD(Animation, GetAnimationName), asCALL_THISCALL);
     engine->RegisterObjectMethod("Animation", "void set_length(float)", asMETHOD(Animation, SetLength), asCALL_THISCALL);
@@ -1254,6 +1276,9 @@ static void RegisterLight(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Light", "Texture@+ get_rampTexture() const", asMETHOD(Light, GetRampTexture), asCALL_THISCALL);
     engine->RegisterObjectMethod("Light", "void set_shapeTexture(Texture@+)", asMETHOD(Light, SetShapeTexture), asCALL_THISCALL);
     engine->RegisterObjectMethod("Light", "Texture@+ get_shapeTexture() const", asMETHOD(Light, GetShapeTexture), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Light", "void set_staticShadows(bool)", asMETHOD(Light, SetStaticShadows), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Light", "bool get_staticShadows() const", asMETHOD(Light, GetStaticShadows), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Light", "void MarkStaticShadowsDirty()", asMETHOD(Light, MarkStaticShadowsDirty), asCALL_THISCALL);
     engine->RegisterObjectMethod("Light", "Frustum get_frustum() const", asMETHOD(Light, GetFrustum), asCALL_THISCALL);
     engine->RegisterObjectMethod("Light", "int get_numShadowSplits() const", asMETHOD(Light, GetNumShadowSplits), asCALL_THISCALL);
     engine->RegisterObjectMethod("Light", "bool get_negative() const", asMETHOD(Light, IsNegative), asCALL_THISCALL);
@@ -1262,6 +1287,43 @@ static void RegisterLight(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Light", "float get_effectiveSpecularIntensity() const", asMETHOD(Light, GetEffectiveSpecularIntensity), asCALL_THISCALL);
 }
 
+static void LightClustersUpdate(Camera* camera, CScriptArray* lights, LightClusters* ptr)
+{
+    ptr->Update(camera, ArrayToPODVector<Light*>(lights));
+}
+
+static CScriptArray* LightClustersGetLights(LightClusters* ptr)
+{
+    return VectorToHandleArray<Light>(ptr->GetLights(), "Array<Light@>");
+}
+
+static CScriptArray* LightClustersGetClusterLights(unsigned index, LightClusters* ptr)
+{
+    PODVector<Light*> lights;
+    ptr->GetClusterLights(lights, index);
+    return VectorToHandleArray<Light>(lights, "Array<Light@>");
+}
+
+static void RegisterLightClusters(asIScriptEngine* engine)
+{
+    RegisterObject<LightClusters>(engine, "LightClusters");
+    RegisterObjectConstructor<LightClusters>(engine, "LightClusters");
+    engine->RegisterObjectMethod("LightClusters", "void Update(Camera@+, Array<Light@>@+)", asFUNCTION(LightClustersUpdate), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("LightClusters", "void UpdateTextures()", asMETHOD(LightClusters, UpdateTextures), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LightClusters", "uint GetClusterIndex(const Vector3&in) const", asMETHOD(LightClusters, GetClusterIndex), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LightClusters", "uint GetClusterNumLights(uint) const", asMETHOD(LightClusters, GetClusterNumLights), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LightClusters", "Array<Light@>@ GetClusterLights(uint) const", asFUNCTION(LightClustersGetClusterLights), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("LightClusters", "void set_gridSize(const IntVector3&in)", asMETHOD(LightClusters, SetGridSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LightClusters", "const IntVector3& get_gridSize() const", asMETHOD(LightClusters, GetGridSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LightClusters", "void set_maxClusterLights(uint)", asMETHOD(LightClusters, SetMaxClusterLights), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LightClusters", "uint get_maxClusterLights() const", asMETHOD(LightClusters, GetMaxClusterLights), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LightClusters", "uint get_numClusters() const", asMETHOD(LightClusters, GetNumClusters), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LightClusters", "uint get_numLightIndices() const", asMETHOD(LightClusters, GetNumLightIndices), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LightClusters", "Array<Light@>@ get_lights() const", asFUNCTION(LightClustersGetLights), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("LightClusters", "Texture2D@+ get_clusterTexture() const", asMETHOD(LightClusters, GetClusterTexture), asCALL_THISCALL);
+    engine->RegisterObjectMethod("LightClusters", "Texture2D@+ get_lightTexture() const", asMETHOD(LightClusters, GetLightTexture), asCALL_THISCALL);
+}
+
 static void RegisterZone(asIScriptEngine* engine)
 {
     RegisterDrawable<Zone>(engine, "Zone");
@@ -1311,6 +1373,9 @@ static void RegisterStaticModel(asIScriptEngine* engine)
     engine->RegisterObjectMethod("StaticModel", "bool IsInsideLocal(const Vector3&in) const", asMETHOD(StaticModel, IsInsideLocal), asCALL_THISCALL);
     engine->RegisterObjectMethod("StaticModel", "void set_model(Model@+)", asFUNCTION(StaticModelSetModel), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("StaticModel", "Model@+ get_model() const", asMETHOD(StaticModel, GetModel), asCALL_THISCALL);
+    engine->RegisterObjectMethod("StaticModel", "Model@+ get_detailModel() const", asMETHOD(StaticModel, GetDetailModel), asCALL_THISCALL);
+    engine->RegisterObjectMethod("StaticModel", "void set_detailReleaseTime(float)", asMETHOD(StaticModel, SetDetailReleaseTime), asCALL_THISCALL);
+    engine->RegisterObjectMethod("StaticModel", "float get_detailReleaseTime() const", asMETHOD(StaticModel, GetDetailReleaseTime), asCALL_THISCALL);
     engine->RegisterObjectMethod("StaticModel", "void set_material(Material@+)", asMETHODPR(StaticModel, SetMaterial, (Material*), void), asCALL_THISCALL);
     engine->RegisterObjectMethod("StaticModel", "bool set_materials(uint, Material@+)", asMETHODPR(StaticModel, SetMaterial, (unsigned, Material*), bool), asCALL_THISCALL);
     engine->RegisterObjectMethod("StaticModel", "Material@+ get_materials(uint) const", asMETHOD(StaticModel, GetMaterial), asCALL_THISCALL);
@@ -1411,6 +1476,9 @@ static void RegisterAnimatedModel(asIScriptEngine* engine)
     engine->RegisterObjectMethod("AnimatedModel", "void set_model(Model@+)", asFUNCTION(AnimatedModelSetModel), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("AnimatedModel", "void set_animationLodBias(float)", asMETHOD(AnimatedModel, SetAnimationLodBias), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimatedModel", "float get_animationLodBias() const", asMETHOD(AnimatedModel, GetAnimationLodBias), asCALL_THISCALL);
+    engine->RegisterObjectMethod("AnimatedModel", "void AddAnimationLodTier(float, float, uint maxBoneDepth = 0)", asMETHOD(AnimatedModel, AddAnimationLodTier), asCALL_THISCALL);
+    engine->RegisterObjectMethod("AnimatedModel", "void RemoveAllAnimationLodTiers()", asMETHOD(AnimatedModel, RemoveAllAnimationLodTiers), asCALL_THISCALL);
+    engine->RegisterObjectMethod("AnimatedModel", "uint get_animationLodTier() const", asMETHOD(AnimatedModel, GetAnimationLodTier), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimatedModel", "void set_updateInvisible(bool)", asMETHOD(AnimatedModel, SetUpdateInvisible), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimatedModel", "bool get_updateInvisible() const", asMETHOD(AnimatedModel, GetUpdateInvisible), asCALL_THISCALL);
     engine->RegisterObjectMethod("AnimatedModel", "Skeleton@+ get_skeleton()", asMETHOD(AnimatedModel, GetSkeleton), asCALL_THISCALL);
@@ -1781,6 +1849,9 @@ static void RegisterDecalSet(asIScriptEngine* engine)
 static void RegisterTerrain(asIScriptEngine* engine)
 {
     RegisterDrawable<TerrainPatch>(engine, "TerrainPatch");
+    engine->RegisterObjectMethod("TerrainPatch", "const IntVector2& get_coordinates() const", asMETHOD(TerrainPatch, GetCoordinates), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TerrainPatch", "uint get_lodLevel() const", asMETHOD(TerrainPatch, GetLodLevel), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TerrainPatch", "float get_morph() const", asMETHOD(TerrainPatch, GetMorph), asCALL_THISCALL);
     RegisterComponent<Terrain>(engine, "Terrain");
     engine->RegisterObjectMethod("Terrain", "void ApplyHeightMap()", asMETHOD(Terrain, ApplyHeightMap), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "float GetHeight(const Vector3&in) const", asMETHOD(Terrain, GetHeight), asCALL_THISCALL);
@@ -1798,6 +1869,8 @@ static void RegisterTerrain(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Terrain", "uint get_occlusionLodLevel() const", asMETHOD(Terrain, GetOcclusionLodLevel), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "void set_smoothing(bool)", asMETHOD(Terrain, SetSmoothing), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "bool get_smoothing() const", asMETHOD(Terrain, GetSmoothing), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Terrain", "void set_geomorph(bool)", asMETHOD(Terrain, SetGeomorph), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Terrain", "bool get_geomorph() const", asMETHOD(Terrain, GetGeomorph), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "void set_heightMap(Image@+)", asMETHOD(Terrain, SetHeightMap), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "Image@+ get_heightMap() const", asMETHOD(Terrain, GetHeightMap), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "void set_patchSize(int)", asMETHOD(Terrain, SetPatchSize), asCALL_THISCALL);
@@ -1837,6 +1910,37 @@ static void RegisterTerrain(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Terrain", "Terrain@+ get_westNeighbor() const", asMETHOD(Terrain, GetEastNeighbor), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "void set_eastNeighbor(Terrain@+)", asMETHOD(Terrain, SetWestNeighbor), asCALL_THISCALL);
     engine->RegisterObjectMethod("Terrain", "Terrain@+ get_eastNeighbor() const", asMETHOD(Terrain, GetWestNeighbor), asCALL_THISCALL);
+
+    RegisterComponent<PagedTerrain>(engine, "PagedTerrain");
+    engine->RegisterObjectMethod("PagedTerrain", "void UpdateTiles(const Vector3&in)", asMETHOD(PagedTerrain, UpdateTiles), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "Terrain@+ GetTile(int, int) const", asMETHOD(PagedTerrain, GetTile), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_heightMapPattern(const String&in)", asMETHOD(PagedTerrain, SetHeightMapPattern), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "const String& get_heightMapPattern() const", asMETHOD(PagedTerrain, GetHeightMapPattern), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_numTiles(const IntVector2&in)", asMETHOD(PagedTerrain, SetNumTiles), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "const IntVector2& get_numTiles() const", asMETHOD(PagedTerrain, GetNumTiles), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_tileResolution(int)", asMETHOD(PagedTerrain, SetTileResolution), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "int get_tileResolution() const", asMETHOD(PagedTerrain, GetTileResolution), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "float get_tileSize() const", asMETHOD(PagedTerrain, GetTileSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_material(Material@+)", asMETHOD(PagedTerrain, SetMaterial), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "Material@+ get_material() const", asMETHOD(PagedTerrain, GetMaterial), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_spacing(const Vector3&in)", asMETHOD(PagedTerrain, SetSpacing), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "const Vector3& get_spacing() const", asMETHOD(PagedTerrain, GetSpacing), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_patchSize(int)", asMETHOD(PagedTerrain, SetPatchSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "int get_patchSize() const", asMETHOD(PagedTerrain, GetPatchSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_maxLodLevels(uint)", asMETHOD(PagedTerrain, SetMaxLodLevels), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "uint get_maxLodLevels() const", asMETHOD(PagedTerrain, GetMaxLodLevels), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_smoothing(bool)", asMETHOD(PagedTerrain, SetSmoothing), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "bool get_smoothing() const", asMETHOD(PagedTerrain, GetSmoothing), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_geomorph(bool)", asMETHOD(PagedTerrain, SetGeomorph), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "bool get_geomorph() const", asMETHOD(PagedTerrain, GetGeomorph), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_loadDistance(float)", asMETHOD(PagedTerrain, SetLoadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "float get_loadDistance() const", asMETHOD(PagedTerrain, GetLoadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_unloadDistance(float)", asMETHOD(PagedTerrain, SetUnloadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "float get_unloadDistance() const", asMETHOD(PagedTerrain, GetUnloadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "void set_focus(Node@+)", asMETHOD(PagedTerrain, SetFocus), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "Node@+ get_focus() const", asMETHOD(PagedTerrain, GetFocus), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "uint get_numLoadedTiles() const", asMETHOD(PagedTerrain, GetNumLoadedTiles), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PagedTerrain", "uint get_numLoadingTiles() const", asMETHOD(PagedTerrain, GetNumLoadingTiles), asCALL_THISCALL);
 }
 
 
@@ -2015,6 +2119,10 @@ static void RegisterRenderer(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Renderer", "float get_occluderSizeThreshold() const", asMETHOD(Renderer, GetOccluderSizeThreshold), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "void set_threadedOcclusion(bool)", asMETHOD(Renderer, SetThreadedOcclusion), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "bool get_threadedOcclusion() const", asMETHOD(Renderer, GetThreadedOcclusion), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "void set_visibilityCaching(bool)", asMETHOD(Renderer, SetVisibilityCaching), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "bool get_visibilityCaching() const", asMETHOD(Renderer, GetVisibilityCaching), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "void set_threadedSubmission(bool)", asMETHOD(Renderer, SetThreadedSubmission), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "bool get_threadedSubmission() const", asMETHOD(Renderer, GetThreadedSubmission), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "void set_mobileShadowBiasMul(float)", asMETHOD(Renderer, SetMobileShadowBiasMul), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "float get_mobileShadowBiasMul() const", asMETHOD(Renderer, GetMobileShadowBiasMul), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "void set_mobileShadowBiasAdd(float)", asMETHOD(Renderer, SetMobileShadowBiasAdd), asCALL_THISCALL);
@@ -2028,6 +2136,8 @@ static void RegisterRenderer(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Renderer", "uint get_numLights(bool) const", asMETHOD(Renderer, GetNumLights), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "uint get_numShadowMaps(bool) const", asMETHOD(Renderer, GetNumShadowMaps), asCALL_THISCALL);
     engine->RegisterObjectMethod("Renderer", "uint get_numOccluders(bool) const", asMETHOD(Renderer, GetNumOccluders), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "uint get_numVisibilityCacheHits(bool) const", asMETHOD(Renderer, GetNumVisibilityCacheHits), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Renderer", "uint get_numVisibilityCacheMisses(bool) const", asMETHOD(Renderer, GetNumVisibilityCacheMisses), asCALL_THISCALL);
     engine->RegisterGlobalFunction("Renderer@+ get_renderer()", asFUNCTION(GetRenderer), asCALL_CDECL);
 }
 
@@ -2185,6 +2295,8 @@ static void RegisterOctree(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Octree", "void DrawDebugGeometry(bool) const", asMETHODPR(Octree, DrawDebugGeometry, (bool), void), asCALL_THISCALL);
     engine->RegisterObjectMethod("Octree", "void AddManualDrawable(Drawable@+)", asMETHOD(Octree, AddManualDrawable), asCALL_THISCALL);
     engine->RegisterObjectMethod("Octree", "void RemoveManualDrawable(Drawable@+)", asMETHOD(Octree, RemoveManualDrawable), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Octree", "void set_animationBoneBudget(uint)", asMETHOD(Octree, SetAnimationBoneBudget), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Octree", "uint get_animationBoneBudget() const", asMETHOD(Octree, GetAnimationBoneBudget), asCALL_THISCALL);
     engine->RegisterObjectMethod("Octree", "Array<RayQueryResult>@ Raycast(const Ray&in, RayQueryLevel level = RAY_TRIANGLE, float maxDistance = M_INFINITY, uint8 drawableFlags = DRAWABLE_ANY, uint viewMask = DEFAULT_VIEWMASK) const", asFUNCTION(OctreeRaycast), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Octree", "RayQueryResult RaycastSingle(const Ray&in, RayQueryLevel level = RAY_TRIANGLE, float maxDistance = M_INFINITY, uint8 drawableFlags = DRAWABLE_ANY, uint viewMask = DEFAULT_VIEWMASK) const", asFUNCTION(OctreeRaycastSingle), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("Octree", "Array<Drawable@>@ GetDrawables(const Vector3&in, uint8 drawableFlags = DRAWABLE_ANY, uint viewMask = DEFAULT_VIEWMASK)", asFUNCTION(OctreeGetDrawablesPoint), asCALL_CDECL_OBJLAST);
@@ -2222,6 +2334,7 @@ void RegisterGraphicsAPI(asIScriptEngine* engine)
     RegisterAnimation(engine);
     RegisterDrawable(engine);
     RegisterLight(engine);
+    RegisterLightClusters(engine);
     RegisterZone(engine);
     RegisterStaticModel(engine);
     RegisterStaticModelGroup(engine);
@@ -28,6 +28,7 @@
 #include "../IK/IKSolver.h"
 #include "../IK/IKEffector.h"
 #include "../IK/IKConstraint.h"
+#include "../IK/IKSolverManager.h"
 
 namespace Urho3D
 {
@@ -97,6 +98,13 @@ static void RegisterIKEffector(asIScriptEngine* engine)
     engine->RegisterObjectMethod("IKEffector", "void DrawDebugGeometry(bool)", asMETHODPR(IKEffector, DrawDebugGeometry, (bool), void), asCALL_THISCALL);
 }
 
+static void RegisterIKSolverManager(asIScriptEngine* engine)
+{
+    RegisterComponent<IKSolverManager>(engine, "IKSolverManager");
+    engine->RegisterObjectMethod("IKSolverManager", "void Solve()", asMETHOD(IKSolverManager, Solve), asCALL_THISCALL);
+    engine->RegisterObjectMethod("IKSolverManager", "uint get_numSolvers() const", asMETHOD(IKSolverManager, GetNumSolvers), asCALL_THISCALL);
+}
+
 static void RegisterIKConstraint(asIScriptEngine* engine)
 {
     RegisterComponent<IKConstraint>(engine, "IKConstraint");
@@ -106,6 +114,7 @@ void RegisterIKAPI(asIScriptEngine* engine)
 {
     RegisterIKEnumerations(engine);
     RegisterIKSolver(engine);
+    RegisterIKSolverManager(engine);
     RegisterIKEffector(engine);
     //RegisterIKConstraint(engine);
 }
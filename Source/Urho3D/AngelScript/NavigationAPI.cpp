@@ -49,6 +49,13 @@ static CScriptArray* NavigationMeshFindPath(const Vector3& start, const Vector3&
     return VectorToArray<Vector3>(dest, "Array<Vector3>");
 }
 
+static CScriptArray* NavigationMeshFindHierarchicalPath(const Vector3& start, const Vector3& end, const Vector3& extents, unsigned refineClusters, NavigationMesh* ptr)
+{
+    PODVector<Vector3> dest;
+    ptr->FindHierarchicalPath(dest, start, end, extents, 0, refineClusters);
+    return VectorToArray<Vector3>(dest, "Array<Vector3>");
+}
+
 static CScriptArray* DynamicNavigationMeshFindPath(const Vector3& start, const Vector3& end, const Vector3& extents, DynamicNavigationMesh* ptr)
 {
     PODVector<Vector3> dest;
@@ -92,6 +99,53 @@ static Vector3 NavigationMeshRaycast(const Vector3& start, const Vector3& end, c
     return ptr->Raycast(start, end, extents);
 }
 
+static void ConstructNavigationQuery(NavigationQuery* ptr)
+{
+    new(ptr) NavigationQuery();
+}
+
+static void ConstructNavigationQueryCopy(const NavigationQuery& query, NavigationQuery* ptr)
+{
+    new(ptr) NavigationQuery(query);
+}
+
+static void DestructNavigationQuery(NavigationQuery* ptr)
+{
+    ptr->~NavigationQuery();
+}
+
+static CScriptArray* NavigationQueryGetPath(NavigationQuery* ptr)
+{
+    return VectorToArray<Vector3>(ptr->path_, "Array<Vector3>");
+}
+
+static void NavigationMeshExecuteQueries(CScriptArray* queries, NavigationMesh* ptr)
+{
+    if (!queries)
+        return;
+
+    Vector<NavigationQuery> queryVector = ArrayToVector<NavigationQuery>(queries);
+    ptr->ExecuteQueries(queryVector);
+    for (unsigned i = 0; i < queryVector.Size(); ++i)
+        *static_cast<NavigationQuery*>(queries->At(i)) = queryVector[i];
+}
+
+static bool NavigationMeshGetQueryResult(unsigned id, NavigationQuery& dest, NavigationMesh* ptr)
+{
+    const NavigationQuery* query = ptr->GetQueryResult(id);
+    if (!query)
+        return false;
+
+    dest = *query;
+    return true;
+}
+
+static void NavigationMeshUpdateTileRegions(CScriptArray* worldPositions, NavigationMesh* ptr)
+{
+    if (worldPositions)
+        ptr->UpdateTileRegions(ArrayToPODVector<Vector3>(worldPositions));
+}
+
 static Vector3 CrowdManagerGetRandomPoint(int queryFilterType, CrowdManager* crowdManager)
 {
     return crowdManager->GetRandomPoint(queryFilterType);
@@ -114,6 +168,34 @@ template<class T> static void RegisterNavMeshBase(asIScriptEngine* engine, const
     engine->RegisterObjectMethod(name, "Vector3 GetRandomPointInCircle(const Vector3&in, float, const Vector3&in extents = Vector3(1.0, 1.0, 1.0))", asFUNCTION(NavigationMeshGetRandomPointInCircle), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod(name, "float GetDistanceToWall(const Vector3&in, float, const Vector3&in extents = Vector3(1.0, 1.0, 1.0))", asFUNCTION(NavigationMeshGetDistanceToWall), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod(name, "Vector3 Raycast(const Vector3&in, const Vector3&in, const Vector3&in extents = Vector3(1.0, 1.0, 1.0))", asFUNCTION(NavigationMeshRaycast), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod(name, "Array<Vector3>@ FindHierarchicalPath(const Vector3&in, const Vector3&in, const Vector3&in extents = Vector3(1.0, 1.0, 1.0), uint refineClusters = 4)", asFUNCTION(NavigationMeshFindHierarchicalPath), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod(name, "void ExecuteQueries(Array<NavigationQuery>@+)", asFUNCTION(NavigationMeshExecuteQueries), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod(name, "uint SubmitQuery(const NavigationQuery&in)", asMETHOD(T, SubmitQuery), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "bool GetQueryResult(uint, NavigationQuery&out)", asFUNCTION(NavigationMeshGetQueryResult), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod(name, "uint get_numPendingQueries() const", asMETHOD(T, GetNumPendingQueries), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void AddStreamingObserver(Node@+)", asMETHOD(T, AddStreamingObserver), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void RemoveStreamingObserver(Node@+)", asMETHOD(T, RemoveStreamingObserver), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void RemoveAllStreamingObservers()", asMETHOD(T, RemoveAllStreamingObservers), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void UpdateTileRegions(Array<Vector3>@+)", asFUNCTION(NavigationMeshUpdateTileRegions), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod(name, "bool LoadTileRegion(const IntVector2&in)", asMETHOD(T, LoadTileRegion), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void UnloadTileRegion(const IntVector2&in)", asMETHOD(T, UnloadTileRegion), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void UnloadAllTileRegions()", asMETHOD(T, UnloadAllTileRegions), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "bool SaveTileRegions(const String&in) const", asMETHOD(T, SaveTileRegions), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "IntVector2 GetTileRegion(const Vector3&in) const", asMETHOD(T, GetTileRegion), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "bool IsTileRegionLoaded(const IntVector2&in) const", asMETHOD(T, IsTileRegionLoaded), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void set_tileRegionPattern(const String&in)", asMETHOD(T, SetTileRegionPattern), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "const String& get_tileRegionPattern() const", asMETHOD(T, GetTileRegionPattern), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void set_tileRegionSize(int)", asMETHOD(T, SetTileRegionSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "int get_tileRegionSize() const", asMETHOD(T, GetTileRegionSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void set_streamingLoadDistance(float)", asMETHOD(T, SetStreamingLoadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "float get_streamingLoadDistance() const", asMETHOD(T, GetStreamingLoadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "void set_streamingUnloadDistance(float)", asMETHOD(T, SetStreamingUnloadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "float get_streamingUnloadDistance() const", asMETHOD(T, GetStreamingUnloadDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "uint get_numStreamingObservers() const", asMETHOD(T, GetNumStreamingObservers), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "IntVector2 get_numTileRegions() const", asMETHOD(T, GetNumTileRegions), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "uint get_numLoadedTileRegions() const", asMETHOD(T, GetNumLoadedTileRegions), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "uint get_numLoadingTileRegions() const", asMETHOD(T, GetNumLoadingTileRegions), asCALL_THISCALL);
+    engine->RegisterObjectMethod(name, "bool get_supportsTileRegions() const", asMETHOD(T, SupportsTileRegions), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "void DrawDebugGeometry(bool)", asMETHODPR(NavigationMesh, DrawDebugGeometry, (bool), void), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "void set_tileSize(int)", asMETHOD(T, SetTileSize), asCALL_THISCALL);
     engine->RegisterObjectMethod(name, "int get_tileSize() const", asMETHOD(T, GetTileSize), asCALL_THISCALL);
@@ -161,6 +243,26 @@ void RegisterNavigationMesh(asIScriptEngine* engine)
     engine->RegisterEnumValue("NavmeshPartitionType", "NAVMESH_PARTITION_WATERSHED", NAVMESH_PARTITION_WATERSHED);
     engine->RegisterEnumValue("NavmeshPartitionType", "NAVMESH_PARTITION_MONOTONE", NAVMESH_PARTITION_MONOTONE);
 
+    engine->RegisterEnum("NavigationQueryType");
+    engine->RegisterEnumValue("NavigationQueryType", "NAVQUERY_FINDPATH", NAVQUERY_FINDPATH);
+    engine->RegisterEnumValue("NavigationQueryType", "NAVQUERY_RAYCAST", NAVQUERY_RAYCAST);
+    engine->RegisterEnumValue("NavigationQueryType", "NAVQUERY_NEARESTPOINT", NAVQUERY_NEARESTPOINT);
+    engine->RegisterEnumValue("NavigationQueryType", "NAVQUERY_MOVEALONGSURFACE", NAVQUERY_MOVEALONGSURFACE);
+
+    engine->RegisterObjectType("NavigationQuery", sizeof(NavigationQuery), asOBJ_VALUE | asOBJ_APP_CLASS_CDAK);
+    engine->RegisterObjectBehaviour("NavigationQuery", asBEHAVE_CONSTRUCT, "void f()", asFUNCTION(ConstructNavigationQuery), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectBehaviour("NavigationQuery", asBEHAVE_CONSTRUCT, "void f(const NavigationQuery&in)", asFUNCTION(ConstructNavigationQueryCopy), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectBehaviour("NavigationQuery", asBEHAVE_DESTRUCT, "void f()", asFUNCTION(DestructNavigationQuery), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("NavigationQuery", "NavigationQuery& opAssign(const NavigationQuery&in)", asMETHODPR(NavigationQuery, operator =, (const NavigationQuery&), NavigationQuery&), asCALL_THISCALL);
+    engine->RegisterObjectProperty("NavigationQuery", "NavigationQueryType type", offsetof(NavigationQuery, type_));
+    engine->RegisterObjectProperty("NavigationQuery", "Vector3 start", offsetof(NavigationQuery, start_));
+    engine->RegisterObjectProperty("NavigationQuery", "Vector3 end", offsetof(NavigationQuery, end_));
+    engine->RegisterObjectProperty("NavigationQuery", "Vector3 extents", offsetof(NavigationQuery, extents_));
+    engine->RegisterObjectProperty("NavigationQuery", "Vector3 position", offsetof(NavigationQuery, position_));
+    engine->RegisterObjectProperty("NavigationQuery", "Vector3 normal", offsetof(NavigationQuery, normal_));
+    engine->RegisterObjectProperty("NavigationQuery", "bool success", offsetof(NavigationQuery, success_));
+    engine->RegisterObjectMethod("NavigationQuery", "Array<Vector3>@ get_path() const", asFUNCTION(NavigationQueryGetPath), asCALL_CDECL_OBJLAST);
+
     RegisterComponent<NavigationMesh>(engine, "NavigationMesh");
     RegisterNavMeshBase<NavigationMesh>(engine, "NavigationMesh");
     engine->RegisterObjectMethod("NavigationMesh", "Array<Vector3>@ FindPath(const Vector3&in, const Vector3&in, const Vector3&in extents = Vector3(1.0, 1.0, 1.0))", asFUNCTION(NavigationMeshFindPath), asCALL_CDECL_OBJLAST);
@@ -178,6 +280,11 @@ void RegisterDynamicNavigationMesh(asIScriptEngine* engine)
     engine->RegisterObjectMethod("DynamicNavigationMesh", "bool get_maxLayers() const", asMETHOD(DynamicNavigationMesh, GetMaxLayers), asCALL_THISCALL);
     engine->RegisterObjectMethod("DynamicNavigationMesh", "void set_maxObstacles(uint)", asMETHOD(DynamicNavigationMesh, SetMaxObstacles), asCALL_THISCALL);
     engine->RegisterObjectMethod("DynamicNavigationMesh", "uint get_maxObstacles() const", asMETHOD(DynamicNavigationMesh, GetMaxObstacles), asCALL_THISCALL);
+    engine->RegisterObjectMethod("DynamicNavigationMesh", "void set_tileUpdateMs(int)", asMETHOD(DynamicNavigationMesh, SetTileUpdateMs), asCALL_THISCALL);
+    engine->RegisterObjectMethod("DynamicNavigationMesh", "int get_tileUpdateMs() const", asMETHOD(DynamicNavigationMesh, GetTileUpdateMs), asCALL_THISCALL);
+    engine->RegisterObjectMethod("DynamicNavigationMesh", "uint get_numPendingTiles() const", asMETHOD(DynamicNavigationMesh, GetNumPendingTiles), asCALL_THISCALL);
+    engine->RegisterObjectMethod("DynamicNavigationMesh", "uint get_numPendingObstacleRequests() const", asMETHOD(DynamicNavigationMesh, GetNumPendingObstacleRequests), asCALL_THISCALL);
+    engine->RegisterObjectMethod("DynamicNavigationMesh", "uint get_numUpdatedTiles() const", asMETHOD(DynamicNavigationMesh, GetNumUpdatedTiles), asCALL_THISCALL);
 }
 
 void RegisterOffMeshConnection(asIScriptEngine* engine)
@@ -259,6 +366,17 @@ void RegisterCrowdManager(asIScriptEngine* engine)
     engine->RegisterObjectMethod("CrowdManager", "uint get_numQueryFilterTypes() const", asMETHOD(CrowdManager, GetNumQueryFilterTypes), asCALL_THISCALL);
     engine->RegisterObjectMethod("CrowdManager", "uint get_numAreas(uint) const", asMETHOD(CrowdManager, GetNumAreas), asCALL_THISCALL);
     engine->RegisterObjectMethod("CrowdManager", "uint get_numObstacleAvoidanceTypes() const", asMETHOD(CrowdManager, GetNumObstacleAvoidanceTypes), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "void AddLodObserver(Node@+)", asMETHOD(CrowdManager, AddLodObserver), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "void RemoveLodObserver(Node@+)", asMETHOD(CrowdManager, RemoveLodObserver), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "void RemoveAllLodObservers()", asMETHOD(CrowdManager, RemoveAllLodObservers), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "uint get_numLodObservers() const", asMETHOD(CrowdManager, GetNumLodObservers), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "void set_lodDistance(float)", asMETHOD(CrowdManager, SetLodDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "float get_lodDistance() const", asMETHOD(CrowdManager, GetLodDistance), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "void set_lodObstacleAvoidanceType(uint)", asMETHOD(CrowdManager, SetLodObstacleAvoidanceType), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "uint get_lodObstacleAvoidanceType() const", asMETHOD(CrowdManager, GetLodObstacleAvoidanceType), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "void set_lodUpdateInterval(uint)", asMETHOD(CrowdManager, SetLodUpdateInterval), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "uint get_lodUpdateInterval() const", asMETHOD(CrowdManager, GetLodUpdateInterval), asCALL_THISCALL);
+    engine->RegisterObjectMethod("CrowdManager", "uint get_numLodAgents() const", asMETHOD(CrowdManager, GetNumLodAgents), asCALL_THISCALL);
 }
 
 void RegisterCrowdAgent(asIScriptEngine* engine)
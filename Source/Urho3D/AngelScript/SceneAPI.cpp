@@ -27,6 +27,7 @@
 #include "../IO/PackageFile.h"
 #include "../Scene/ObjectAnimation.h"
 #include "../Scene/Scene.h"
+#include "../Scene/InterpolatedTransform.h"
 #include "../Scene/SmoothedTransform.h"
 #include "../Scene/SplinePath.h"
 #include "../Scene/ValueAnimation.h"
@@ -180,6 +181,13 @@ static CScriptArray* SceneGetNodesWithTag(const String& tag, Scene* ptr)
     return VectorToHandleArray<Node>(nodes, "Array<Node@>");
 }
 
+static CScriptArray* SceneGetComponentsByType(const String& typeName, bool derived, Scene* ptr)
+{
+    PODVector<Component*> components;
+    ptr->GetComponentsByType(components, typeName, derived);
+    return VectorToHandleArray<Component>(components, "Array<Component@>");
+}
+
 static bool SceneLoadJSONVectorBuffer(VectorBuffer& buffer, Scene* ptr)
 {
     return ptr->LoadJSON(buffer);
@@ -323,6 +331,19 @@ static void RegisterSmoothedTransform(asIScriptEngine* engine)
     engine->RegisterObjectMethod("SmoothedTransform", "bool get_inProgress() const", asMETHOD(SmoothedTransform, IsInProgress), asCALL_THISCALL);
 }
 
+static void RegisterInterpolatedTransform(asIScriptEngine* engine)
+{
+    RegisterComponent<InterpolatedTransform>(engine, "InterpolatedTransform");
+    engine->RegisterObjectMethod("InterpolatedTransform", "void Store()", asMETHOD(InterpolatedTransform, Store), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterpolatedTransform", "void Update(float)", asMETHOD(InterpolatedTransform, Update), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterpolatedTransform", "void Restore()", asMETHOD(InterpolatedTransform, Restore), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterpolatedTransform", "const Vector3& get_previousPosition() const", asMETHOD(InterpolatedTransform, GetPreviousPosition), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterpolatedTransform", "const Quaternion& get_previousRotation() const", asMETHOD(InterpolatedTransform, GetPreviousRotation), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterpolatedTransform", "const Vector3& get_currentPosition() const", asMETHOD(InterpolatedTransform, GetCurrentPosition), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterpolatedTransform", "const Quaternion& get_currentRotation() const", asMETHOD(InterpolatedTransform, GetCurrentRotation), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterpolatedTransform", "bool get_interpolated() const", asMETHOD(InterpolatedTransform, IsInterpolated), asCALL_THISCALL);
+}
+
 static void RegisterSplinePath(asIScriptEngine* engine)
 {
     RegisterComponent<SplinePath>(engine, "SplinePath");
@@ -392,11 +413,15 @@ static void RegisterScene(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Scene", "void UnregisterAllVars(const String&in)", asMETHOD(Scene, UnregisterAllVars), asCALL_THISCALL);
 
     engine->RegisterObjectMethod("Scene", "Array<Node@>@ GetNodesWithTag(const String&in) const", asFUNCTION(SceneGetNodesWithTag), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("Scene", "Array<Component@>@ GetComponentsByType(const String&in, bool derived = false) const", asFUNCTION(SceneGetComponentsByType), asCALL_CDECL_OBJLAST);
 
     engine->RegisterObjectMethod("Scene", "Component@+ GetComponent(uint) const", asMETHODPR(Scene, GetComponent, (unsigned) const, Component*), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "Node@+ GetNode(uint) const", asMETHOD(Scene, GetNode), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "const String& GetVarName(StringHash) const", asMETHOD(Scene, GetVarName), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void Update(float)", asMETHOD(Scene, Update), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void FixedUpdate(float)", asMETHOD(Scene, FixedUpdate), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void UpdateInterpolation(float)", asMETHOD(Scene, UpdateInterpolation), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void UpdateTransforms()", asMETHODPR(Scene, UpdateTransforms, (), void), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void set_updateEnabled(bool)", asMETHOD(Scene, SetUpdateEnabled), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "bool get_updateEnabled() const", asMETHOD(Scene, IsUpdateEnabled), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void set_timeScale(float)", asMETHOD(Scene, SetTimeScale), asCALL_THISCALL);
@@ -407,6 +432,15 @@ static void RegisterScene(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Scene", "float get_smoothingConstant() const", asMETHOD(Scene, GetSmoothingConstant), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void set_snapThreshold(float)", asMETHOD(Scene, SetSnapThreshold), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "float get_snapThreshold() const", asMETHOD(Scene, GetSnapThreshold), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void set_fixedUpdateFps(int)", asMETHOD(Scene, SetFixedUpdateFps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "int get_fixedUpdateFps() const", asMETHOD(Scene, GetFixedUpdateFps), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void set_maxFixedUpdates(int)", asMETHOD(Scene, SetMaxFixedUpdates), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "int get_maxFixedUpdates() const", asMETHOD(Scene, GetMaxFixedUpdates), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void set_fixedUpdateInterpolation(bool)", asMETHOD(Scene, SetFixedUpdateInterpolation), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "bool get_fixedUpdateInterpolation() const", asMETHOD(Scene, GetFixedUpdateInterpolation), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "float get_fixedUpdateFactor() const", asMETHOD(Scene, GetFixedUpdateFactor), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void set_batchedTransformUpdate(bool)", asMETHOD(Scene, SetBatchedTransformUpdate), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "bool get_batchedTransformUpdate() const", asMETHOD(Scene, GetBatchedTransformUpdate), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "bool get_asyncLoading() const", asMETHOD(Scene, IsAsyncLoading), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "float get_asyncProgress() const", asMETHOD(Scene, GetAsyncProgress), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "LoadMode get_asyncLoadMode() const", asMETHOD(Scene, GetAsyncLoadMode), asCALL_THISCALL);
@@ -431,6 +465,7 @@ void RegisterSceneAPI(asIScriptEngine* engine)
     RegisterAnimatable(engine);
     RegisterNode(engine);
     RegisterSmoothedTransform(engine);
+    RegisterInterpolatedTransform(engine);
     RegisterSplinePath(engine);
     RegisterScene(engine);
 }
@@ -0,0 +1,143 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/LinearAllocator.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+LinearAllocator::LinearAllocator(unsigned blockSize) :
+    current_(0),
+    blockSize_(blockSize ? blockSize : 1),
+    peakSize_(0)
+{
+}
+
+LinearAllocator::~LinearAllocator()
+{
+    FreeBlocks();
+}
+
+void* LinearAllocator::Allocate(unsigned size, unsigned alignment)
+{
+    if (!alignment)
+        alignment = 1;
+
+    if (current_)
+    {
+        unsigned char* data = reinterpret_cast<unsigned char*>(current_) + sizeof(LinearAllocatorBlock);
+        size_t address = reinterpret_cast<size_t>(data + current_->used_);
+        unsigned padding = (unsigned)((alignment - (address & (alignment - 1))) & (alignment - 1));
+        if (current_->used_ + padding + size <= current_->size_)
+        {
+            void* ptr = data + current_->used_ + padding;
+            current_->used_ += padding + size;
+            return ptr;
+        }
+    }
+
+    // Does not fit; grow geometrically so that a burst of allocations does not create many small blocks. Clamp the growth
+    // so that the block size including its header does not overflow
+    const unsigned maxBlockSize = 0xffffffff - (unsigned)sizeof(LinearAllocatorBlock);
+    if (size > maxBlockSize - alignment)
+        return 0;
+
+    unsigned minSize = size + alignment;
+    unsigned newSize = current_ ? current_->size_ : blockSize_;
+    if (current_)
+        newSize = newSize <= maxBlockSize / 2 ? newSize * 2 : maxBlockSize;
+    while (newSize < minSize)
+        newSize = newSize <= maxBlockSize / 2 ? newSize * 2 : maxBlockSize;
+    AddBlock(newSize);
+
+    return Allocate(size, alignment);
+}
+
+void LinearAllocator::Reset()
+{
+    if (!current_)
+        return;
+
+    unsigned usedSize = GetUsedSize();
+    if (usedSize > peakSize_)
+        peakSize_ = usedSize;
+
+    if (current_->next_)
+    {
+        // Coalesce into one block for the next round
+        unsigned capacity = GetCapacity();
+        FreeBlocks();
+        AddBlock(capacity);
+    }
+    else
+        current_->used_ = 0;
+}
+
+unsigned LinearAllocator::GetUsedSize() const
+{
+    unsigned size = 0;
+    for (LinearAllocatorBlock* block = current_; block; block = block->next_)
+        size += block->used_;
+    return size;
+}
+
+unsigned LinearAllocator::GetCapacity() const
+{
+    unsigned size = 0;
+    for (LinearAllocatorBlock* block = current_; block; block = block->next_)
+        size += block->size_;
+    return size;
+}
+
+unsigned LinearAllocator::GetNumBlocks() const
+{
+    unsigned count = 0;
+    for (LinearAllocatorBlock* block = current_; block; block = block->next_)
+        ++count;
+    return count;
+}
+
+void LinearAllocator::AddBlock(unsigned size)
+{
+    unsigned char* blockPtr = new unsigned char[sizeof(LinearAllocatorBlock) + size];
+    LinearAllocatorBlock* newBlock = reinterpret_cast<LinearAllocatorBlock*>(blockPtr);
+    newBlock->size_ = size;
+    newBlock->used_ = 0;
+    newBlock->next_ = current_;
+    current_ = newBlock;
+}
+
+void LinearAllocator::FreeBlocks()
+{
+    while (current_)
+    {
+        LinearAllocatorBlock* next = current_->next_;
+        delete[] reinterpret_cast<unsigned char*>(current_);
+        current_ = next;
+    }
+}
+
+}
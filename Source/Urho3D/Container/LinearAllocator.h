@@ -0,0 +1,99 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#ifdef URHO3D_IS_BUILDING
+#include "Urho3D.h"
+#else
+#include <Urho3D/Urho3D.h>
+#endif
+
+#include <stddef.h>
+
+namespace Urho3D
+{
+
+/// %Linear allocator memory block.
+struct LinearAllocatorBlock
+{
+    /// Size of the data area in bytes.
+    unsigned size_;
+    /// Bytes used from the data area.
+    unsigned used_;
+    /// Next (older) block.
+    LinearAllocatorBlock* next_;
+    /// Data follows.
+};
+
+/// %Linear (bump) allocator for transient data. Allocations are not freed individually; instead all memory is released at once by Reset(), after which the storage is reused. Not thread-safe, use one allocator per thread.
+class URHO3D_API LinearAllocator
+{
+public:
+    /// Construct with the size of the first block. No memory is allocated until the first allocation.
+    LinearAllocator(unsigned blockSize = 64 * 1024);
+    /// Destruct. Free all blocks.
+    ~LinearAllocator();
+
+    /// Allocate uninitialized memory with the specified alignment, which must be a power of two. Adds a new block if necessary. Return null if the size can not be represented.
+    void* Allocate(unsigned size, unsigned alignment = sizeof(void*));
+    /// Release all allocations. If more than one block was needed, the blocks are replaced with a single block large enough for all of them, so that a steady workload does not allocate after the first few resets.
+    void Reset();
+
+    /// Allocate and default-construct an array of objects, aligned for SIMD use. Destructors are never called, so use only for types that do not need them.
+    template <class T> T* AllocateArray(unsigned count)
+    {
+        T* ptr = static_cast<T*>(Allocate(count * (unsigned)sizeof(T), 16));
+        for (unsigned i = 0; i < count; ++i)
+            new(ptr + i) T();
+        return ptr;
+    }
+
+    /// Return bytes allocated since the last reset, including alignment padding.
+    unsigned GetUsedSize() const;
+    /// Return total size of the blocks.
+    unsigned GetCapacity() const;
+    /// Return number of blocks.
+    unsigned GetNumBlocks() const;
+    /// Return the highest used size seen at a reset.
+    unsigned GetPeakSize() const { return peakSize_; }
+
+private:
+    /// Prevent copy construction.
+    LinearAllocator(const LinearAllocator& rhs);
+    /// Prevent assignment.
+    LinearAllocator& operator =(const LinearAllocator& rhs);
+
+    /// Add a new block of at least the specified size and make it current.
+    void AddBlock(unsigned size);
+    /// Free all blocks.
+    void FreeBlocks();
+
+    /// Current block. Older blocks are chained through next_.
+    LinearAllocatorBlock* current_;
+    /// Minimum size of a new block.
+    unsigned blockSize_;
+    /// Highest used size seen at a reset.
+    unsigned peakSize_;
+};
+
+}
@@ -0,0 +1,175 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/LinearAllocator.h"
+#include "../Container/VectorBase.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// %Vector of POD types which takes its storage from a LinearAllocator, for transient data that does not outlive the allocator's next reset. Growing abandons the old storage to the allocator instead of freeing it. Never deletes its buffer, so it can be simply dropped.
+template <class T> class LinearVector
+{
+public:
+    typedef T ValueType;
+    typedef RandomAccessIterator<T> Iterator;
+    typedef RandomAccessConstIterator<T> ConstIterator;
+
+    /// Construct empty with the allocator and optional initial capacity.
+    explicit LinearVector(LinearAllocator* allocator, unsigned capacity = 0) :
+        allocator_(allocator),
+        buffer_(0),
+        size_(0),
+        capacity_(0)
+    {
+        assert(allocator_);
+        Reserve(capacity);
+    }
+
+    /// Return element at index.
+    T& operator [](unsigned index)
+    {
+        assert(index < size_);
+        return buffer_[index];
+    }
+
+    /// Return const element at index.
+    const T& operator [](unsigned index) const
+    {
+        assert(index < size_);
+        return buffer_[index];
+    }
+
+    /// Add an element at the end.
+    void Push(const T& value)
+    {
+        if (size_ >= capacity_)
+            Reserve(capacity_ ? capacity_ * 2 : 8);
+        buffer_[size_++] = value;
+    }
+
+    /// Remove the last element.
+    void Pop()
+    {
+        if (size_)
+            --size_;
+    }
+
+    /// Resize the vector. New elements are left uninitialized.
+    void Resize(unsigned newSize)
+    {
+        if (newSize > capacity_)
+            Reserve(newSize > capacity_ * 2 ? newSize : capacity_ * 2);
+        size_ = newSize;
+    }
+
+    /// Set new capacity. Never shrinks.
+    void Reserve(unsigned newCapacity)
+    {
+        if (newCapacity <= capacity_)
+            return;
+
+        T* newBuffer = static_cast<T*>(allocator_->Allocate(newCapacity * (unsigned)sizeof(T), 16));
+        if (size_)
+            memcpy(newBuffer, buffer_, size_ * sizeof(T));
+        buffer_ = newBuffer;
+        capacity_ = newCapacity;
+    }
+
+    /// Clear the vector. Keeps the storage.
+    void Clear() { size_ = 0; }
+
+    /// Return whether contains a specific value.
+    bool Contains(const T& value) const
+    {
+        for (unsigned i = 0; i < size_; ++i)
+        {
+            if (buffer_[i] == value)
+                return true;
+        }
+        return false;
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(buffer_); }
+
+    /// Return const iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(buffer_); }
+
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(buffer_ + size_); }
+
+    /// Return const iterator to the end.
+    ConstIterator End() const { return ConstIterator(buffer_ + size_); }
+
+    /// Return first element.
+    T& Front() { return buffer_[0]; }
+
+    /// Return const first element.
+    const T& Front() const { return buffer_[0]; }
+
+    /// Return last element.
+    T& Back()
+    {
+        assert(size_);
+        return buffer_[size_ - 1];
+    }
+
+    /// Return const last element.
+    const T& Back() const
+    {
+        assert(size_);
+        return buffer_[size_ - 1];
+    }
+
+    /// Return the buffer.
+    T* Buffer() const { return buffer_; }
+
+    /// Return size of vector.
+    unsigned Size() const { return size_; }
+
+    /// Return capacity of vector.
+    unsigned Capacity() const { return capacity_; }
+
+    /// Return whether vector is empty.
+    bool Empty() const { return size_ == 0; }
+
+    /// Return the allocator.
+    LinearAllocator* GetAllocator() const { return allocator_; }
+
+private:
+    /// Allocator the storage is taken from.
+    LinearAllocator* allocator_;
+    /// Element storage.
+    T* buffer_;
+    /// Number of elements.
+    unsigned size_;
+    /// Capacity of the storage.
+    unsigned capacity_;
+};
+
+}
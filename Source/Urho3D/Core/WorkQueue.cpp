@@ -71,6 +71,7 @@ WorkQueue::WorkQueue(Context* context) :
     maxNonThreadedWorkMs_(5)
 {
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(WorkQueue, HandleBeginFrame));
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(WorkQueue, HandleEndFrame));
 }
 
 WorkQueue::~WorkQueue()
@@ -421,4 +422,9 @@ void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
     PurgePool();
 }
 
+void WorkQueue::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    frameAllocator_.Reset();
+}
+
 }
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Container/LinearAllocator.h"
 #include "../Container/List.h"
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
@@ -110,6 +111,9 @@ public:
     /// Return number of worker threads.
     unsigned GetNumThreads() const { return threads_.Size(); }
 
+    /// Return the per-frame linear allocator. Memory allocated from it is valid until the end of the frame, and may only be used by the main thread.
+    LinearAllocator* GetFrameAllocator() { return &frameAllocator_; }
+
     /// Return whether all work with at least the specified priority is finished.
     bool IsCompleted(unsigned priority) const;
     /// Return whether the queue is currently completing work in the main thread.
@@ -132,9 +136,13 @@ private:
     void ReturnToPool(SharedPtr<WorkItem>& item);
     /// Handle frame start event. Purge completed work from the main thread queue, and perform work if no threads at all.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
+    /// Handle frame end event. Reset the per-frame allocator.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
 
     /// Worker threads.
     Vector<SharedPtr<WorkerThread> > threads_;
+    /// Per-frame linear allocator for the main thread.
+    LinearAllocator frameAllocator_;
     /// Work item pool for reuse to cut down on allocation. The bool is a flag for item pooling and whether it is available or not.
     List<SharedPtr<WorkItem> > poolItems_;
     /// Work item collection. Accessed only by the main thread.
@@ -522,6 +522,12 @@ void Engine::RunFrame()
     Render();
     ApplyFrameLimit();
 
+    // Recorded rendering may still be replayed on the render submission thread. Let it finish before the frame ends, as the
+    // next frame's update may already use Graphics, for example to update vertex buffers or release textures
+    Renderer* renderer = GetSubsystem<Renderer>();
+    if (renderer)
+        renderer->FinishSubmission();
+
     time->EndFrame();
 }
 
@@ -713,12 +719,15 @@ void Engine::Render()
 
     // If device is lost, BeginFrame will fail and we skip rendering
     Graphics* graphics = GetSubsystem<Graphics>();
+    Renderer* renderer = GetSubsystem<Renderer>();
     if (!graphics->BeginFrame())
         return;
 
-    GetSubsystem<Renderer>()->Render();
+    renderer->Render();
     GetSubsystem<UI>()->Render();
-    graphics->EndFrame();
+    // If the recorded commands went to the submission thread, the frame is ended once they have been replayed in RunFrame()
+    if (!renderer->SubmitCommands())
+        graphics->EndFrame();
 }
 
 void Engine::ApplyFrameLimit()
@@ -986,6 +995,10 @@ void Engine::HandleExitRequested(StringHash eventType, VariantMap& eventData)
 
 void Engine::DoExit()
 {
+    Renderer* renderer = GetSubsystem<Renderer>();
+    if (renderer)
+        renderer->FinishSubmission();
+
     Graphics* graphics = GetSubsystem<Graphics>();
     if (graphics)
         graphics->Close();
@@ -66,6 +66,11 @@ static bool CompareAnimationOrder(const SharedPtr<AnimationState>& lhs, const Sh
     return lhs->GetLayer() < rhs->GetLayer();
 }
 
+static bool CompareAnimationLodTiers(const AnimationLodTier& lhs, const AnimationLodTier& rhs)
+{
+    return lhs.distance_ < rhs.distance_;
+}
+
 static const unsigned MAX_ANIMATION_STATES = 256;
 
 AnimatedModel::AnimatedModel(Context* context) :
@@ -75,6 +80,9 @@ AnimatedModel::AnimatedModel(Context* context) :
     animationLodBias_(1.0f),
     animationLodTimer_(-1.0f),
     animationLodDistance_(0.0f),
+    animationLodTier_(M_MAX_UNSIGNED),
+    animationBudgetDeferrals_(0),
+    animationBudgetDeferred_(false),
     updateInvisible_(false),
     animationDirty_(false),
     animationOrderDirty_(false),
@@ -116,6 +124,8 @@ void AnimatedModel::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Shadow Distance", GetShadowDistance, SetShadowDistance, float, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("LOD Bias", GetLodBias, SetLodBias, float, 1.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Animation LOD Bias", GetAnimationLodBias, SetAnimationLodBias, float, 1.0f, AM_DEFAULT);
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Animation LOD Tiers", GetAnimationLodTiersAttr, SetAnimationLodTiersAttr, VariantVector,
+        Variant::emptyVariantVector, AM_DEFAULT | AM_NOEDIT);
     URHO3D_COPY_BASE_ATTRIBUTES(Drawable);
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Bone Animation Enabled", GetBonesEnabledAttr, SetBonesEnabledAttr, VariantVector,
         Variant::emptyVariantVector, AM_FILE | AM_NOEDIT);
@@ -228,6 +238,9 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
 
 void AnimatedModel::Update(const FrameInfo& frame)
 {
+    bool budgetDeferred = animationBudgetDeferred_;
+    animationBudgetDeferred_ = false;
+
     // If node was invisible last frame, need to decide animation LOD distance here
     // If headless, retain the current animation distance (should be 0)
     if (frame.camera_ && abs((int)frame.frameNumber_ - (int)viewFrameNumber_) > 1)
@@ -251,7 +264,8 @@ void AnimatedModel::Update(const FrameInfo& frame)
         animationLodDistance_ = frame.camera_->GetLodDistance(distance, scale, lodBias_);
     }
 
-    if (animationDirty_ || animationOrderDirty_)
+    // If the bone budget deferred the animation update, the octree queues the model again for the next frame
+    if ((animationDirty_ || animationOrderDirty_) && !budgetDeferred)
         UpdateAnimation(frame);
     else if (boneBoundingBoxDirty_)
         UpdateBoneBoundingBox();
@@ -543,6 +557,20 @@ void AnimatedModel::SetAnimationLodBias(float bias)
     MarkNetworkUpdate();
 }
 
+void AnimatedModel::AddAnimationLodTier(float distance, float updateInterval, unsigned maxBoneDepth)
+{
+    animationLodTiers_.Push(AnimationLodTier(Max(distance, 0.0f), Max(updateInterval, 0.0f), maxBoneDepth));
+    Sort(animationLodTiers_.Begin(), animationLodTiers_.End(), CompareAnimationLodTiers);
+    MarkNetworkUpdate();
+}
+
+void AnimatedModel::RemoveAllAnimationLodTiers()
+{
+    animationLodTiers_.Clear();
+    animationLodTier_ = M_MAX_UNSIGNED;
+    MarkNetworkUpdate();
+}
+
 void AnimatedModel::SetUpdateInvisible(bool enable)
 {
     updateInvisible_ = enable;
@@ -738,6 +766,7 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
             RemoveRootBone();
 
         skeleton_.Define(skeleton);
+        pose_.Define(skeleton_);
 
         // Merge bounding boxes from non-master models
         FinalizeBoneBoundingBoxes();
@@ -860,6 +889,19 @@ void AnimatedModel::SetMorphsAttr(const PODVector<unsigned char>& value)
         SetMorphWeight(index, (float)value[index] / 255.0f);
 }
 
+void AnimatedModel::SetAnimationLodTiersAttr(const VariantVector& value)
+{
+    animationLodTiers_.Clear();
+    animationLodTier_ = M_MAX_UNSIGNED;
+
+    // Each tier is stored as a Vector3 of distance, update interval and maximum bone depth
+    for (unsigned i = 0; i < value.Size(); ++i)
+    {
+        Vector3 tier = value[i].GetVector3();
+        AddAnimationLodTier(tier.x_, tier.y_, (unsigned)Max(tier.z_, 0.0f));
+    }
+}
+
 ResourceRef AnimatedModel::GetModelAttr() const
 {
     return GetResourceRef(model_, Model::GetTypeStatic());
@@ -904,6 +946,16 @@ const PODVector<unsigned char>& AnimatedModel::GetMorphsAttr() const
     return attrBuffer_.GetBuffer();
 }
 
+VariantVector AnimatedModel::GetAnimationLodTiersAttr() const
+{
+    VariantVector ret;
+    ret.Reserve(animationLodTiers_.Size());
+    for (PODVector<AnimationLodTier>::ConstIterator i = animationLodTiers_.Begin(); i != animationLodTiers_.End(); ++i)
+        ret.Push(Vector3(i->distance_, i->updateInterval_, (float)i->maxBoneDepth_));
+
+    return ret;
+}
+
 void AnimatedModel::UpdateBoneBoundingBox()
 {
     if (skeleton_.GetNumBones())
@@ -1255,15 +1307,20 @@ void AnimatedModel::SetGeometryBoneMappings()
 
 void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
 {
+    animationLodTier_ = SelectAnimationLodTier();
+
     // If using animation LOD, accumulate time and see if it is time to update
-    if (animationLodBias_ > 0.0f && animationLodDistance_ > 0.0f)
+    float interval;
+    float advance;
+    GetAnimationLodTiming(frame.timeStep_, interval, advance);
+    if (interval > 0.0f)
     {
         // Perform the first update always regardless of LOD timer
         if (animationLodTimer_ >= 0.0f)
         {
-            animationLodTimer_ += animationLodBias_ * frame.timeStep_ * ANIMATION_LOD_BASESCALE;
-            if (animationLodTimer_ >= animationLodDistance_)
-                animationLodTimer_ = fmodf(animationLodTimer_, animationLodDistance_);
+            animationLodTimer_ += advance;
+            if (animationLodTimer_ >= interval)
+                animationLodTimer_ = fmodf(animationLodTimer_, interval);
             else
                 return;
         }
@@ -1274,6 +1331,106 @@ void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
     ApplyAnimation();
 }
 
+unsigned AnimatedModel::SelectAnimationLodTier() const
+{
+    // Closer than the first tier's distance no tier applies, and the animation is updated every frame with all bones
+    if (animationLodTiers_.Empty() || animationLodDistance_ < animationLodTiers_[0].distance_)
+        return M_MAX_UNSIGNED;
+
+    unsigned tier = 0;
+    for (unsigned i = 1; i < animationLodTiers_.Size() && animationLodDistance_ >= animationLodTiers_[i].distance_; ++i)
+        tier = i;
+
+    return tier;
+}
+
+void AnimatedModel::GetAnimationLodTiming(float timeStep, float& interval, float& advance) const
+{
+    interval = 0.0f;
+    advance = 0.0f;
+
+    if (animationLodBias_ <= 0.0f)
+        return;
+
+    if (!animationLodTiers_.Empty())
+    {
+        unsigned tier = SelectAnimationLodTier();
+        interval = tier < animationLodTiers_.Size() ? animationLodTiers_[tier].updateInterval_ : 0.0f;
+        advance = animationLodBias_ * timeStep;
+    }
+    else if (animationLodDistance_ > 0.0f)
+    {
+        interval = animationLodDistance_;
+        advance = animationLodBias_ * timeStep * ANIMATION_LOD_BASESCALE;
+    }
+}
+
+unsigned AnimatedModel::GetAnimationUpdateCost(const FrameInfo& frame) const
+{
+    if (!isMaster_ || !(animationDirty_ || animationOrderDirty_))
+        return 0;
+
+    // Invisible models skip the update unless set to update when invisible
+    if (frame.camera_ && abs((int)frame.frameNumber_ - (int)viewFrameNumber_) > 1 && !updateInvisible_)
+        return 0;
+
+    float interval;
+    float advance;
+    GetAnimationLodTiming(frame.timeStep_, interval, advance);
+    if (interval > 0.0f && animationLodTimer_ >= 0.0f && animationLodTimer_ + advance < interval)
+        return 0;
+
+    if (!pose_.GetNumBones())
+        return skeleton_.GetNumBones();
+
+    unsigned tier = SelectAnimationLodTier();
+    unsigned maxBoneDepth = tier < animationLodTiers_.Size() ? animationLodTiers_[tier].maxBoneDepth_ : 0;
+    return pose_.GetNumEvaluatedBones(maxBoneDepth);
+}
+
+void AnimatedModel::ApplyAnimationBudget(const PODVector<Drawable*>& drawables, unsigned boneBudget, const FrameInfo& frame,
+    PODVector<Drawable*>& deferred)
+{
+    // Collect the models due for an animation update. A smaller LOD distance means a larger screen size; models that have
+    // been deferred gain priority each frame so that none of them starves
+    PODVector<Pair<float, AnimatedModel*> > candidates;
+    for (PODVector<Drawable*>::ConstIterator i = drawables.Begin(); i != drawables.End(); ++i)
+    {
+        Drawable* drawable = *i;
+        if (!drawable->IsInstanceOf<AnimatedModel>())
+            continue;
+
+        AnimatedModel* model = static_cast<AnimatedModel*>(drawable);
+        if (model->GetAnimationUpdateCost(frame))
+        {
+            float priority = (model->animationLodDistance_ + M_EPSILON) / (float)(model->animationBudgetDeferrals_ + 1);
+            candidates.Push(MakePair(priority, model));
+        }
+    }
+
+    Sort(candidates.Begin(), candidates.End());
+
+    unsigned bonesUsed = 0;
+    for (PODVector<Pair<float, AnimatedModel*> >::ConstIterator i = candidates.Begin(); i != candidates.End(); ++i)
+    {
+        AnimatedModel* model = i->second_;
+        unsigned cost = model->GetAnimationUpdateCost(frame);
+
+        // Always let the first model through, so that a budget smaller than one skeleton does not stop all animation
+        if (!bonesUsed || bonesUsed + cost <= boneBudget)
+        {
+            bonesUsed += cost;
+            model->animationBudgetDeferrals_ = 0;
+        }
+        else
+        {
+            model->animationBudgetDeferred_ = true;
+            ++model->animationBudgetDeferrals_;
+            deferred.Push(model);
+        }
+    }
+}
+
 void AnimatedModel::ApplyAnimation()
 {
     // Make sure animations are in ascending priority order
@@ -1287,13 +1444,22 @@ void AnimatedModel::ApplyAnimation()
     // (first AnimatedModel in a node)
     if (isMaster_)
     {
-        skeleton_.ResetSilent();
+        // Blend all animations into a contiguous pose first, then write each animated bone node only once
+        unsigned maxBoneDepth = animationLodTier_ < animationLodTiers_.Size() ? animationLodTiers_[animationLodTier_].maxBoneDepth_ : 0;
+        pose_.Reset(skeleton_, maxBoneDepth);
         for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
-            (*i)->Apply();
+            (*i)->ApplyToPose(pose_);
+        pose_.ApplyToSkeleton(skeleton_);
 
-        // Skeleton reset and animations apply the node transforms "silently" to avoid repeated marking dirty. Mark dirty now
+        // The pose is applied to the node transforms "silently" to avoid repeated marking dirty. Mark dirty now
         node_->MarkDirty();
 
+        // The scene's batched transform update has already run for this frame, so update the moved bones in hierarchy order
+        // here, before the bounding box and skinning need them
+        Scene* scene = GetScene();
+        if (scene && scene->GetBatchedTransformUpdate())
+            pose_.UpdateWorldTransforms(skeleton_);
+
         // Calculate new bone bounding box
         UpdateBoneBoundingBox();
     }
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Graphics/AnimationState.h"
 #include "../Graphics/Model.h"
 #include "../Graphics/Skeleton.h"
 #include "../Graphics/StaticModel.h"
@@ -32,6 +33,33 @@ namespace Urho3D
 class Animation;
 class AnimationState;
 
+/// %Animation LOD tier of an animated model, selected by the model's LOD distance.
+struct AnimationLodTier
+{
+    /// Construct with defaults.
+    AnimationLodTier() :
+        distance_(0.0f),
+        updateInterval_(0.0f),
+        maxBoneDepth_(0)
+    {
+    }
+
+    /// Construct with parameters.
+    AnimationLodTier(float distance, float updateInterval, unsigned maxBoneDepth) :
+        distance_(distance),
+        updateInterval_(updateInterval),
+        maxBoneDepth_(maxBoneDepth)
+    {
+    }
+
+    /// LOD distance from which the tier is used. Closer than the first tier, the animation is updated every frame with all bones.
+    float distance_;
+    /// Time in seconds between animation updates, 0 to update every frame.
+    float updateInterval_;
+    /// Maximum depth of evaluated bones in the skeleton hierarchy, root bone being 1. Deeper bones keep their last pose. 0 evaluates all bones.
+    unsigned maxBoneDepth_;
+};
+
 /// Animated model component.
 class URHO3D_API AnimatedModel : public StaticModel
 {
@@ -86,6 +114,10 @@ public:
     void RemoveAllAnimationStates();
     /// Set animation LOD bias.
     void SetAnimationLodBias(float bias);
+    /// Add an animation LOD tier. When tiers exist, they replace the distance-proportional update rate.
+    void AddAnimationLodTier(float distance, float updateInterval, unsigned maxBoneDepth = 0);
+    /// Remove all animation LOD tiers.
+    void RemoveAllAnimationLodTiers();
     /// Set whether to update animation and the bounding box when not visible. Recommended to enable for physically controlled models like ragdolls.
     void SetUpdateInvisible(bool enable);
     /// Set vertex morph weight by index.
@@ -120,6 +152,12 @@ public:
     /// Return animation LOD bias.
     float GetAnimationLodBias() const { return animationLodBias_; }
 
+    /// Return animation LOD tiers.
+    const PODVector<AnimationLodTier>& GetAnimationLodTiers() const { return animationLodTiers_; }
+
+    /// Return index of the animation LOD tier used on the last update, or M_MAX_UNSIGNED if the model was closer than the first tier or has no tiers.
+    unsigned GetAnimationLodTier() const { return animationLodTier_; }
+
     /// Return whether to update animation when not visible.
     bool GetUpdateInvisible() const { return updateInvisible_; }
 
@@ -150,6 +188,8 @@ public:
     void SetAnimationStatesAttr(const VariantVector& value);
     /// Set morphs attribute.
     void SetMorphsAttr(const PODVector<unsigned char>& value);
+    /// Set animation LOD tiers attribute.
+    void SetAnimationLodTiersAttr(const VariantVector& value);
     /// Return model attribute.
     ResourceRef GetModelAttr() const;
     /// Return bones' animation enabled attribute.
@@ -158,6 +198,8 @@ public:
     VariantVector GetAnimationStatesAttr() const;
     /// Return morphs attribute.
     const PODVector<unsigned char>& GetMorphsAttr() const;
+    /// Return animation LOD tiers attribute.
+    VariantVector GetAnimationLodTiersAttr() const;
 
     /// Return per-geometry bone mappings.
     const Vector<PODVector<unsigned> >& GetGeometryBoneMappings() const { return geometryBoneMappings_; }
@@ -168,6 +210,10 @@ public:
     /// Recalculate the bone bounding box. Normally called internally, but can also be manually called if up-to-date information before rendering is necessary.
     void UpdateBoneBoundingBox();
 
+    /// Limit the number of bones evaluated this frame among the drawables queued for update. Models with the largest screen size (and those deferred the longest) are evaluated first; the rest are returned in deferred and skip their animation update. Called by Octree from the main thread.
+    static void ApplyAnimationBudget(const PODVector<Drawable*>& drawables, unsigned boneBudget, const FrameInfo& frame,
+        PODVector<Drawable*>& deferred);
+
 protected:
     /// Handle node being assigned.
     virtual void OnNodeSet(Node* node);
@@ -199,6 +245,12 @@ private:
     void CopyMorphVertices(void* dest, void* src, unsigned vertexCount, VertexBuffer* clone, VertexBuffer* original);
     /// Recalculate animations. Called from Update().
     void UpdateAnimation(const FrameInfo& frame);
+    /// Return animation LOD tier index for the current animation LOD distance, or M_MAX_UNSIGNED if closer than the first tier.
+    unsigned SelectAnimationLodTier() const;
+    /// Return animation LOD update interval and how much the LOD timer advances in a time step. An interval of 0 means updating every frame.
+    void GetAnimationLodTiming(float timeStep, float& interval, float& advance) const;
+    /// Return number of bones the animation update would evaluate this frame, or 0 if no update is due.
+    unsigned GetAnimationUpdateCost(const FrameInfo& frame) const;
     /// Recalculate skinning.
     void UpdateSkinning();
     /// Reapply all vertex morphs.
@@ -217,6 +269,8 @@ private:
     Vector<ModelMorph> morphs_;
     /// Animation states.
     Vector<SharedPtr<AnimationState> > animationStates_;
+    /// Blended bone pose, reused between frames.
+    AnimationPose pose_;
     /// Skinning matrices.
     PODVector<Matrix3x4> skinMatrices_;
     /// Mapping of subgeometry bone indices, used if more bones than skinning shader can manage.
@@ -239,6 +293,14 @@ private:
     float animationLodTimer_;
     /// Animation LOD distance, the minimum of all LOD view distances last frame.
     float animationLodDistance_;
+    /// Animation LOD tiers sorted by distance.
+    PODVector<AnimationLodTier> animationLodTiers_;
+    /// Animation LOD tier used on the last update.
+    unsigned animationLodTier_;
+    /// Number of consecutive frames the animation update was deferred by the bone budget.
+    unsigned animationBudgetDeferrals_;
+    /// Animation update deferred by the bone budget this frame flag.
+    bool animationBudgetDeferred_;
     /// Update animation when invisible flag.
     bool updateInvisible_;
     /// Animation dirty flag.
@@ -49,8 +49,190 @@ inline bool CompareKeyFrames(AnimationKeyFrame& lhs, AnimationKeyFrame& rhs)
     return lhs.time_ < rhs.time_;
 }
 
+/// Largest quantized value of times, positions and scales.
+static const float QUANTIZE_MAX = 65535.0f;
+/// Largest quantized value of rotation components. The top bit is reserved for the index of the omitted component.
+static const float ROTATION_QUANTIZE_MAX = 32767.0f;
+/// Largest magnitude of the three smallest components of a unit quaternion.
+static const float ROTATION_RANGE = 0.70710678f;
+
+/// Quantize a value in the 0-1 range.
+static unsigned short Quantize(float value, float max)
+{
+    return (unsigned short)Clamp(RoundToInt(value * max), 0, (int)max);
+}
+
+static unsigned short QuantizeStep(float value, float min, float step)
+{
+    return step > 0.0f ? Quantize((value - min) / (step * QUANTIZE_MAX), QUANTIZE_MAX) : (unsigned short)0;
+}
+
+static void PackVector3(const Vector3& value, const Vector3& min, const Vector3& step, unsigned short* dest)
+{
+    dest[0] = QuantizeStep(value.x_, min.x_, step.x_);
+    dest[1] = QuantizeStep(value.y_, min.y_, step.y_);
+    dest[2] = QuantizeStep(value.z_, min.z_, step.z_);
+}
+
+static Vector3 UnpackVector3(const unsigned short* src, const Vector3& min, const Vector3& step)
+{
+    return Vector3(min.x_ + src[0] * step.x_, min.y_ + src[1] * step.y_, min.z_ + src[2] * step.z_);
+}
+
+static void PackRotation(const Quaternion& rotation, unsigned short* dest)
+{
+    Quaternion normalized = rotation.Normalized();
+    const float* src = normalized.Data();
+
+    // Omit the largest component and make it positive, so that it can be reconstructed from the other three
+    unsigned largest = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(src[i]) > Abs(src[largest]))
+            largest = i;
+    }
+    float sign = src[largest] < 0.0f ? -1.0f : 1.0f;
+
+    unsigned j = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i != largest)
+            dest[j++] = Quantize((src[i] * sign / ROTATION_RANGE + 1.0f) * 0.5f, ROTATION_QUANTIZE_MAX);
+    }
+
+    dest[0] |= (largest & 1) << 15;
+    dest[1] |= (largest >> 1) << 15;
+}
+
+static Quaternion UnpackRotation(const unsigned short* src)
+{
+    unsigned largest = (unsigned)((src[0] >> 15) | ((src[1] >> 15) << 1));
+    float components[4];
+    float sumSquares = 0.0f;
+
+    unsigned j = 0;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        if (i != largest)
+        {
+            float value = ((src[j++] & 0x7fff) / ROTATION_QUANTIZE_MAX * 2.0f - 1.0f) * ROTATION_RANGE;
+            components[i] = value;
+            sumSquares += value * value;
+        }
+    }
+    components[largest] = sqrtf(Max(1.0f - sumSquares, 0.0f));
+
+    return Quaternion(components[0], components[1], components[2], components[3]);
+}
+
+/// Return the channels in which two keyframes differ by more than the tolerances.
+static unsigned char GetDifferingChannels(const AnimationKeyFrame& lhs, const AnimationKeyFrame& rhs, unsigned char channelMask,
+    float positionTolerance, float rotationTolerance, float scaleTolerance)
+{
+    unsigned char result = 0;
+
+    if ((channelMask & CHANNEL_POSITION) && (lhs.position_ - rhs.position_).Length() > positionTolerance)
+        result |= CHANNEL_POSITION;
+    if ((channelMask & CHANNEL_ROTATION) && 2.0f * Acos(Abs(lhs.rotation_.DotProduct(rhs.rotation_))) > rotationTolerance)
+        result |= CHANNEL_ROTATION;
+    if ((channelMask & CHANNEL_SCALE) && (lhs.scale_ - rhs.scale_).Length() > scaleTolerance)
+        result |= CHANNEL_SCALE;
+
+    return result;
+}
+
+/// Interpolate between two keyframes the same way AnimationState does.
+static void InterpolateKeyFrame(const AnimationKeyFrame& from, const AnimationKeyFrame& to, float time, unsigned char channelMask,
+    AnimationKeyFrame& dest)
+{
+    float timeInterval = to.time_ - from.time_;
+    float t = timeInterval > 0.0f ? (time - from.time_) / timeInterval : 1.0f;
+
+    dest.time_ = time;
+    if (channelMask & CHANNEL_POSITION)
+        dest.position_ = from.position_.Lerp(to.position_, t);
+    if (channelMask & CHANNEL_ROTATION)
+        dest.rotation_ = from.rotation_.Slerp(to.rotation_, t);
+    if (channelMask & CHANNEL_SCALE)
+        dest.scale_ = from.scale_.Lerp(to.scale_, t);
+}
+
+/// Write the keyframes of a track in the compressed format.
+static void WriteCompressedKeyFrames(Serializer& dest, const AnimationTrack& track, float length)
+{
+    // Tracks that were not compressed are only quantized, without removing keyframes
+    AnimationTrack quantized;
+    if (!track.IsCompressed())
+    {
+        quantized.channelMask_ = track.channelMask_;
+        quantized.keyFrames_ = track.keyFrames_;
+        quantized.Compress(length, 0.0f, 0.0f, 0.0f);
+    }
+
+    const AnimationCompressedKeyFrames& compressed = track.IsCompressed() ? track.compressed_ : quantized.compressed_;
+    unsigned char channelMask = track.channelMask_;
+    unsigned keyFrames = compressed.GetNumKeyFrames();
+
+    dest.WriteUByte(compressed.constantMask_);
+    dest.WriteUInt(keyFrames);
+    dest.WriteFloat(compressed.timeStep_);
+    dest.Write(compressed.times_.Buffer(), keyFrames * sizeof(unsigned short));
+
+    if (channelMask & CHANNEL_POSITION)
+    {
+        if (compressed.constantMask_ & CHANNEL_POSITION)
+            dest.WriteVector3(compressed.constant_.position_);
+        else
+        {
+            dest.WriteVector3(compressed.positionMin_);
+            dest.WriteVector3(compressed.positionStep_);
+            dest.Write(compressed.positions_.Buffer(), keyFrames * 3 * sizeof(unsigned short));
+        }
+    }
+    if (channelMask & CHANNEL_ROTATION)
+    {
+        if (compressed.constantMask_ & CHANNEL_ROTATION)
+            dest.WriteQuaternion(compressed.constant_.rotation_);
+        else
+            dest.Write(compressed.rotations_.Buffer(), keyFrames * 3 * sizeof(unsigned short));
+    }
+    if (channelMask & CHANNEL_SCALE)
+    {
+        if (compressed.constantMask_ & CHANNEL_SCALE)
+            dest.WriteVector3(compressed.constant_.scale_);
+        else
+        {
+            dest.WriteVector3(compressed.scaleMin_);
+            dest.WriteVector3(compressed.scaleStep_);
+            dest.Write(compressed.scales_.Buffer(), keyFrames * 3 * sizeof(unsigned short));
+        }
+    }
+}
+
+void AnimationCompressedKeyFrames::GetKeyFrame(unsigned index, unsigned char channelMask, AnimationKeyFrame& dest) const
+{
+    dest.time_ = GetTime(index);
+
+    if (channelMask & CHANNEL_POSITION)
+    {
+        dest.position_ = (constantMask_ & CHANNEL_POSITION) ? constant_.position_ :
+            UnpackVector3(&positions_[index * 3], positionMin_, positionStep_);
+    }
+    if (channelMask & CHANNEL_ROTATION)
+        dest.rotation_ = (constantMask_ & CHANNEL_ROTATION) ? constant_.rotation_ : UnpackRotation(&rotations_[index * 3]);
+    if (channelMask & CHANNEL_SCALE)
+        dest.scale_ = (constantMask_ & CHANNEL_SCALE) ? constant_.scale_ : UnpackVector3(&scales_[index * 3], scaleMin_, scaleStep_);
+}
+
+unsigned AnimationCompressedKeyFrames::GetMemoryUse() const
+{
+    return (times_.Size() + positions_.Size() + rotations_.Size() + scales_.Size()) * sizeof(unsigned short);
+}
+
 void AnimationTrack::SetKeyFrame(unsigned index, const AnimationKeyFrame& keyFrame)
 {
+    Decompress();
+
     if (index < keyFrames_.Size())
     {
         keyFrames_[index] = keyFrame;
@@ -62,6 +244,8 @@ void AnimationTrack::SetKeyFrame(unsigned index, const AnimationKeyFrame& keyFra
 
 void AnimationTrack::AddKeyFrame(const AnimationKeyFrame& keyFrame)
 {
+    Decompress();
+
     bool needSort = keyFrames_.Size() ? keyFrames_.Back().time_ > keyFrame.time_ : false;
     keyFrames_.Push(keyFrame);
     if (needSort)
@@ -70,39 +254,164 @@ void AnimationTrack::AddKeyFrame(const AnimationKeyFrame& keyFrame)
 
 void AnimationTrack::InsertKeyFrame(unsigned index, const AnimationKeyFrame& keyFrame)
 {
+    Decompress();
+
     keyFrames_.Insert(index, keyFrame);
     Urho3D::Sort(keyFrames_.Begin(), keyFrames_.End(), CompareKeyFrames);
 }
 
 void AnimationTrack::RemoveKeyFrame(unsigned index)
 {
+    Decompress();
+
     keyFrames_.Erase(index);
 }
 
 void AnimationTrack::RemoveAllKeyFrames()
 {
     keyFrames_.Clear();
+    compressed_ = AnimationCompressedKeyFrames();
+}
+
+void AnimationTrack::Compress(float length, float positionTolerance, float rotationTolerance, float scaleTolerance)
+{
+    if (IsCompressed() || keyFrames_.Empty())
+        return;
+
+    AnimationCompressedKeyFrames compressed;
+    const AnimationKeyFrame& first = keyFrames_[0];
+    unsigned numKeyFrames = keyFrames_.Size();
+
+    // Channels which stay within tolerance of their first value are stored only once
+    compressed.constantMask_ = channelMask_;
+    compressed.constant_ = first;
+    for (unsigned i = 1; i < numKeyFrames && compressed.constantMask_; ++i)
+    {
+        compressed.constantMask_ &= ~GetDifferingChannels(keyFrames_[i], first, compressed.constantMask_, positionTolerance,
+            rotationTolerance, scaleTolerance);
+    }
+    unsigned char varyingMask = channelMask_ & ~compressed.constantMask_;
+
+    // Remove keyframes that interpolation between the previous kept keyframe and the next keyframe reproduces
+    PODVector<unsigned> kept;
+    kept.Push(0);
+    if (varyingMask)
+    {
+        unsigned start = 0;
+        AnimationKeyFrame interpolated;
+        for (unsigned i = 1; i + 1 < numKeyFrames; ++i)
+        {
+            for (unsigned j = start + 1; j <= i; ++j)
+            {
+                InterpolateKeyFrame(keyFrames_[start], keyFrames_[i + 1], keyFrames_[j].time_, varyingMask, interpolated);
+                if (GetDifferingChannels(interpolated, keyFrames_[j], varyingMask, positionTolerance, rotationTolerance,
+                    scaleTolerance))
+                {
+                    kept.Push(i);
+                    start = i;
+                    break;
+                }
+            }
+        }
+        if (numKeyFrames > 1)
+            kept.Push(numKeyFrames - 1);
+    }
+
+    unsigned numKept = kept.Size();
+    float maxTime = Max(length, keyFrames_.Back().time_);
+    compressed.timeStep_ = maxTime / QUANTIZE_MAX;
+    compressed.times_.Resize(numKept);
+    for (unsigned i = 0; i < numKept; ++i)
+        compressed.times_[i] = maxTime > 0.0f ? Quantize(keyFrames_[kept[i]].time_ / maxTime, QUANTIZE_MAX) : 0;
+
+    if (varyingMask & CHANNEL_POSITION)
+    {
+        Vector3 max = compressed.positionMin_ = keyFrames_[kept[0]].position_;
+        for (unsigned i = 1; i < numKept; ++i)
+        {
+            const Vector3& position = keyFrames_[kept[i]].position_;
+            compressed.positionMin_ = VectorMin(compressed.positionMin_, position);
+            max = VectorMax(max, position);
+        }
+        compressed.positionStep_ = (max - compressed.positionMin_) / QUANTIZE_MAX;
+
+        compressed.positions_.Resize(numKept * 3);
+        for (unsigned i = 0; i < numKept; ++i)
+        {
+            PackVector3(keyFrames_[kept[i]].position_, compressed.positionMin_, compressed.positionStep_,
+                &compressed.positions_[i * 3]);
+        }
+    }
+    if (varyingMask & CHANNEL_ROTATION)
+    {
+        compressed.rotations_.Resize(numKept * 3);
+        for (unsigned i = 0; i < numKept; ++i)
+            PackRotation(keyFrames_[kept[i]].rotation_, &compressed.rotations_[i * 3]);
+    }
+    if (varyingMask & CHANNEL_SCALE)
+    {
+        Vector3 max = compressed.scaleMin_ = keyFrames_[kept[0]].scale_;
+        for (unsigned i = 1; i < numKept; ++i)
+        {
+            const Vector3& scale = keyFrames_[kept[i]].scale_;
+            compressed.scaleMin_ = VectorMin(compressed.scaleMin_, scale);
+            max = VectorMax(max, scale);
+        }
+        compressed.scaleStep_ = (max - compressed.scaleMin_) / QUANTIZE_MAX;
+
+        compressed.scales_.Resize(numKept * 3);
+        for (unsigned i = 0; i < numKept; ++i)
+            PackVector3(keyFrames_[kept[i]].scale_, compressed.scaleMin_, compressed.scaleStep_, &compressed.scales_[i * 3]);
+    }
+
+    // Release the float keyframes
+    compressed_ = compressed;
+    Vector<AnimationKeyFrame>().Swap(keyFrames_);
+}
+
+void AnimationTrack::Decompress()
+{
+    if (!IsCompressed())
+        return;
+
+    Vector<AnimationKeyFrame> keyFrames(compressed_.GetNumKeyFrames());
+    for (unsigned i = 0; i < keyFrames.Size(); ++i)
+        compressed_.GetKeyFrame(i, channelMask_, keyFrames[i]);
+
+    keyFrames_.Swap(keyFrames);
+    compressed_ = AnimationCompressedKeyFrames();
 }
 
 AnimationKeyFrame* AnimationTrack::GetKeyFrame(unsigned index)
 {
+    Decompress();
+
     return index < keyFrames_.Size() ? &keyFrames_[index] : (AnimationKeyFrame*)0;
 }
 
+void AnimationTrack::ReadKeyFrame(unsigned index, AnimationKeyFrame& dest) const
+{
+    if (IsCompressed())
+        compressed_.GetKeyFrame(index, channelMask_, dest);
+    else
+        dest = keyFrames_[index];
+}
+
 void AnimationTrack::GetKeyFrameIndex(float time, unsigned& index) const
 {
     if (time < 0.0f)
         time = 0.0f;
 
-    if (index >= keyFrames_.Size())
-        index = keyFrames_.Size() - 1;
+    unsigned numKeyFrames = GetNumKeyFrames();
+    if (index >= numKeyFrames)
+        index = numKeyFrames - 1;
 
     // Check for being too far ahead
-    while (index && time < keyFrames_[index].time_)
+    while (index && time < GetKeyFrameTime(index))
         --index;
 
     // Check for being too far behind
-    while (index < keyFrames_.Size() - 1 && time >= keyFrames_[index + 1].time_)
+    while (index < numKeyFrames - 1 && time >= GetKeyFrameTime(index + 1))
         ++index;
 }
 
@@ -126,7 +435,8 @@ bool Animation::BeginLoad(Deserializer& source)
     unsigned memoryUse = sizeof(Animation);
 
     // Check ID
-    if (source.ReadFileID() != "UANI")
+    String fileID = source.ReadFileID();
+    if (fileID != "UANI" && fileID != "UANC")
     {
         URHO3D_LOGERROR(source.GetName() + " is not a valid animation file");
         return false;
@@ -138,32 +448,11 @@ bool Animation::BeginLoad(Deserializer& source)
     length_ = source.ReadFloat();
     tracks_.Clear();
 
-    unsigned tracks = source.ReadUInt();
-    memoryUse += tracks * sizeof(AnimationTrack);
-
     // Read tracks
-    for (unsigned i = 0; i < tracks; ++i)
-    {
-        AnimationTrack* newTrack = CreateTrack(source.ReadString());
-        newTrack->channelMask_ = source.ReadUByte();
-
-        unsigned keyFrames = source.ReadUInt();
-        newTrack->keyFrames_.Resize(keyFrames);
-        memoryUse += keyFrames * sizeof(AnimationKeyFrame);
-
-        // Read keyframes of the track
-        for (unsigned j = 0; j < keyFrames; ++j)
-        {
-            AnimationKeyFrame& newKeyFrame = newTrack->keyFrames_[j];
-            newKeyFrame.time_ = source.ReadFloat();
-            if (newTrack->channelMask_ & CHANNEL_POSITION)
-                newKeyFrame.position_ = source.ReadVector3();
-            if (newTrack->channelMask_ & CHANNEL_ROTATION)
-                newKeyFrame.rotation_ = source.ReadQuaternion();
-            if (newTrack->channelMask_ & CHANNEL_SCALE)
-                newKeyFrame.scale_ = source.ReadVector3();
-        }
-    }
+    if (fileID == "UANC")
+        ReadCompressedTracks(source, memoryUse);
+    else
+        ReadTracks(source, memoryUse);
 
     // Optionally read triggers from an XML file
     ResourceCache* cache = GetSubsystem<ResourceCache>();
@@ -225,8 +514,9 @@ bool Animation::BeginLoad(Deserializer& source)
 
 bool Animation::Save(Serializer& dest) const
 {
-    // Write ID, name and length
-    dest.WriteFileID("UANI");
+    // Write ID, name and length. If any track is compressed, all tracks are written in the compressed format
+    bool compressed = IsCompressed();
+    dest.WriteFileID(compressed ? "UANC" : "UANI");
     dest.WriteString(animationName_);
     dest.WriteFloat(length_);
 
@@ -237,6 +527,12 @@ bool Animation::Save(Serializer& dest) const
         const AnimationTrack& track = i->second_;
         dest.WriteString(track.name_);
         dest.WriteUByte(track.channelMask_);
+        if (compressed)
+        {
+            WriteCompressedKeyFrames(dest, track, length_);
+            continue;
+        }
+
         dest.WriteUInt(track.keyFrames_.Size());
 
         // Write keyframes of the track
@@ -383,6 +679,24 @@ SharedPtr<Animation> Animation::Clone(const String& cloneName) const
     return ret;
 }
 
+void Animation::Compress(float positionTolerance, float rotationTolerance, float scaleTolerance)
+{
+    URHO3D_PROFILE(CompressAnimation);
+
+    for (HashMap<StringHash, AnimationTrack>::Iterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+        i->second_.Compress(length_, positionTolerance, rotationTolerance, scaleTolerance);
+
+    UpdateMemoryUse();
+}
+
+void Animation::Decompress()
+{
+    for (HashMap<StringHash, AnimationTrack>::Iterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+        i->second_.Decompress();
+
+    UpdateMemoryUse();
+}
+
 AnimationTrack* Animation::GetTrack(unsigned index)
 {
     if (index >= GetNumTracks())
@@ -417,4 +731,114 @@ AnimationTriggerPoint* Animation::GetTrigger(unsigned index)
     return index < triggers_.Size() ? &triggers_[index] : (AnimationTriggerPoint*)0;
 }
 
+bool Animation::IsCompressed() const
+{
+    for (HashMap<StringHash, AnimationTrack>::ConstIterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+    {
+        if (i->second_.IsCompressed())
+            return true;
+    }
+
+    return false;
+}
+
+void Animation::ReadTracks(Deserializer& source, unsigned& memoryUse)
+{
+    unsigned tracks = source.ReadUInt();
+    memoryUse += tracks * sizeof(AnimationTrack);
+
+    for (unsigned i = 0; i < tracks; ++i)
+    {
+        AnimationTrack* newTrack = CreateTrack(source.ReadString());
+        newTrack->channelMask_ = source.ReadUByte();
+
+        unsigned keyFrames = source.ReadUInt();
+        newTrack->keyFrames_.Resize(keyFrames);
+        memoryUse += keyFrames * sizeof(AnimationKeyFrame);
+
+        // Read keyframes of the track
+        for (unsigned j = 0; j < keyFrames; ++j)
+        {
+            AnimationKeyFrame& newKeyFrame = newTrack->keyFrames_[j];
+            newKeyFrame.time_ = source.ReadFloat();
+            if (newTrack->channelMask_ & CHANNEL_POSITION)
+                newKeyFrame.position_ = source.ReadVector3();
+            if (newTrack->channelMask_ & CHANNEL_ROTATION)
+                newKeyFrame.rotation_ = source.ReadQuaternion();
+            if (newTrack->channelMask_ & CHANNEL_SCALE)
+                newKeyFrame.scale_ = source.ReadVector3();
+        }
+    }
+}
+
+void Animation::ReadCompressedTracks(Deserializer& source, unsigned& memoryUse)
+{
+    unsigned tracks = source.ReadUInt();
+    memoryUse += tracks * sizeof(AnimationTrack);
+
+    for (unsigned i = 0; i < tracks; ++i)
+    {
+        AnimationTrack* newTrack = CreateTrack(source.ReadString());
+        newTrack->channelMask_ = source.ReadUByte();
+
+        AnimationCompressedKeyFrames& compressed = newTrack->compressed_;
+        compressed.constantMask_ = source.ReadUByte();
+        unsigned keyFrames = source.ReadUInt();
+        compressed.timeStep_ = source.ReadFloat();
+        compressed.times_.Resize(keyFrames);
+        source.Read(compressed.times_.Buffer(), keyFrames * sizeof(unsigned short));
+
+        if (newTrack->channelMask_ & CHANNEL_POSITION)
+        {
+            if (compressed.constantMask_ & CHANNEL_POSITION)
+                compressed.constant_.position_ = source.ReadVector3();
+            else
+            {
+                compressed.positionMin_ = source.ReadVector3();
+                compressed.positionStep_ = source.ReadVector3();
+                compressed.positions_.Resize(keyFrames * 3);
+                source.Read(compressed.positions_.Buffer(), keyFrames * 3 * sizeof(unsigned short));
+            }
+        }
+        if (newTrack->channelMask_ & CHANNEL_ROTATION)
+        {
+            if (compressed.constantMask_ & CHANNEL_ROTATION)
+                compressed.constant_.rotation_ = source.ReadQuaternion();
+            else
+            {
+                compressed.rotations_.Resize(keyFrames * 3);
+                source.Read(compressed.rotations_.Buffer(), keyFrames * 3 * sizeof(unsigned short));
+            }
+        }
+        if (newTrack->channelMask_ & CHANNEL_SCALE)
+        {
+            if (compressed.constantMask_ & CHANNEL_SCALE)
+                compressed.constant_.scale_ = source.ReadVector3();
+            else
+            {
+                compressed.scaleMin_ = source.ReadVector3();
+                compressed.scaleStep_ = source.ReadVector3();
+                compressed.scales_.Resize(keyFrames * 3);
+                source.Read(compressed.scales_.Buffer(), keyFrames * 3 * sizeof(unsigned short));
+            }
+        }
+
+        memoryUse += compressed.GetMemoryUse();
+    }
+}
+
+void Animation::UpdateMemoryUse()
+{
+    unsigned memoryUse = sizeof(Animation);
+
+    for (HashMap<StringHash, AnimationTrack>::ConstIterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+    {
+        const AnimationTrack& track = i->second_;
+        memoryUse += sizeof(AnimationTrack) + track.keyFrames_.Size() * sizeof(AnimationKeyFrame) + track.compressed_.GetMemoryUse();
+    }
+    memoryUse += triggers_.Size() * sizeof(AnimationTriggerPoint);
+
+    SetMemoryUse(memoryUse);
+}
+
 }
@@ -50,6 +50,51 @@ struct AnimationKeyFrame
     Vector3 scale_;
 };
 
+/// Quantized keyframes of a compressed animation track. Times are stored as 16-bit fractions of the animation length,
+/// positions and scales as 16-bit fractions of the track's value range, and rotations in the smallest-three encoding using
+/// 48 bits. Channels that do not change are stored once as a constant.
+struct URHO3D_API AnimationCompressedKeyFrames
+{
+    /// Construct.
+    AnimationCompressedKeyFrames() :
+        constantMask_(0),
+        timeStep_(0.0f)
+    {
+    }
+
+    /// Decode keyframe at index.
+    void GetKeyFrame(unsigned index, unsigned char channelMask, AnimationKeyFrame& dest) const;
+    /// Return keyframe time at index.
+    float GetTime(unsigned index) const { return times_[index] * timeStep_; }
+    /// Return number of keyframes.
+    unsigned GetNumKeyFrames() const { return times_.Size(); }
+    /// Return memory use in bytes.
+    unsigned GetMemoryUse() const;
+
+    /// Bitmask of constant channels.
+    unsigned char constantMask_;
+    /// Time quantization step.
+    float timeStep_;
+    /// Values of the constant channels.
+    AnimationKeyFrame constant_;
+    /// Position range minimum.
+    Vector3 positionMin_;
+    /// Position quantization step.
+    Vector3 positionStep_;
+    /// Scale range minimum.
+    Vector3 scaleMin_;
+    /// Scale quantization step.
+    Vector3 scaleStep_;
+    /// Quantized times.
+    PODVector<unsigned short> times_;
+    /// Quantized positions, 3 values per keyframe.
+    PODVector<unsigned short> positions_;
+    /// Quantized rotations, 3 values per keyframe.
+    PODVector<unsigned short> rotations_;
+    /// Quantized scales, 3 values per keyframe.
+    PODVector<unsigned short> scales_;
+};
+
 /// Skeletal animation track, stores keyframes of a single bone.
 struct URHO3D_API AnimationTrack
 {
@@ -69,11 +114,28 @@ struct URHO3D_API AnimationTrack
     void RemoveKeyFrame(unsigned index);
     /// Remove all keyframes.
     void RemoveAllKeyFrames();
+    /// Compress the keyframes. Removes keyframes that interpolation reproduces within the tolerances, detects constant channels
+    /// and quantizes the rest. Tolerances are in units for position and scale and in degrees for rotation.
+    void Compress(float length, float positionTolerance, float rotationTolerance, float scaleTolerance);
+    /// Decompress back to float keyframes.
+    void Decompress();
 
-    /// Return keyframe at index, or null if not found.
+    /// Return keyframe at index, or null if not found. Decompresses the track if compressed.
     AnimationKeyFrame* GetKeyFrame(unsigned index);
+    /// Copy keyframe at index to dest, decoding it if the track is compressed.
+    void ReadKeyFrame(unsigned index, AnimationKeyFrame& dest) const;
+    /// Return keyframe time at index.
+    float GetKeyFrameTime(unsigned index) const
+    {
+        return IsCompressed() ? compressed_.GetTime(index) : keyFrames_[index].time_;
+    }
+
     /// Return number of keyframes.
-    unsigned GetNumKeyFrames() const { return keyFrames_.Size(); }
+    unsigned GetNumKeyFrames() const { return IsCompressed() ? compressed_.GetNumKeyFrames() : keyFrames_.Size(); }
+
+    /// Return whether the keyframes are compressed.
+    bool IsCompressed() const { return !compressed_.times_.Empty(); }
+
     /// Return keyframe index based on time and previous index.
     void GetKeyFrameIndex(float time, unsigned& index) const;
 
@@ -85,6 +147,8 @@ struct URHO3D_API AnimationTrack
     unsigned char channelMask_;
     /// Keyframes.
     Vector<AnimationKeyFrame> keyFrames_;
+    /// Compressed keyframes. When non-empty, used instead of keyFrames_.
+    AnimationCompressedKeyFrames compressed_;
 };
 
 /// %Animation trigger point.
@@ -148,6 +212,11 @@ public:
     void SetNumTriggers(unsigned num);
     /// Clone the animation.
     SharedPtr<Animation> Clone(const String& cloneName = String::EMPTY) const;
+    /// Compress all tracks. Tolerances are in units for position and scale and in degrees for rotation. A compressed animation
+    /// is sampled directly from the quantized data and saved in the compressed format.
+    void Compress(float positionTolerance = 0.001f, float rotationTolerance = 0.1f, float scaleTolerance = 0.001f);
+    /// Decompress all tracks back to float keyframes.
+    void Decompress();
 
     /// Return animation name.
     const String& GetAnimationName() const { return animationName_; }
@@ -181,7 +250,17 @@ public:
     /// Return a trigger point by index.
     AnimationTriggerPoint* GetTrigger(unsigned index);
 
+    /// Return whether any track is compressed.
+    bool IsCompressed() const;
+
 private:
+    /// Read float keyframe tracks.
+    void ReadTracks(Deserializer& source, unsigned& memoryUse);
+    /// Read compressed keyframe tracks.
+    void ReadCompressedTracks(Deserializer& source, unsigned& memoryUse);
+    /// Recalculate memory use after compressing or decompressing.
+    void UpdateMemoryUse();
+
     /// Animation name.
     String animationName_;
     /// Animation name hash.
@@ -27,6 +27,7 @@
 #include "../Graphics/AnimationState.h"
 #include "../Graphics/DrawableEvents.h"
 #include "../IO/Log.h"
+#include "../Scene/Node.h"
 
 #include "../DebugNew.h"
 
@@ -37,7 +38,8 @@ AnimationStateTrack::AnimationStateTrack() :
     track_(0),
     bone_(0),
     weight_(1.0f),
-    keyFrame_(0)
+    keyFrame_(0),
+    boneIndex_(M_MAX_UNSIGNED)
 {
 }
 
@@ -45,6 +47,105 @@ AnimationStateTrack::~AnimationStateTrack()
 {
 }
 
+void AnimationPose::Define(const Skeleton& skeleton)
+{
+    const Vector<Bone>& bones = skeleton.GetBones();
+    unsigned numBones = bones.Size();
+
+    positions_.Resize(numBones);
+    rotations_.Resize(numBones);
+    scales_.Resize(numBones);
+    depths_.Resize(numBones);
+    order_.Clear();
+
+    unsigned maxDepth = 0;
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        // Walk up to the root, guarding against malformed parent indices
+        unsigned depth = 1;
+        unsigned index = i;
+        while (bones[index].parentIndex_ != index && bones[index].parentIndex_ < numBones && depth <= numBones)
+        {
+            index = bones[index].parentIndex_;
+            ++depth;
+        }
+        depths_[i] = depth;
+        maxDepth = Max(maxDepth, depth);
+    }
+
+    for (unsigned depth = 1; depth <= maxDepth; ++depth)
+    {
+        for (unsigned i = 0; i < numBones; ++i)
+        {
+            if (depths_[i] == depth)
+                order_.Push(i);
+        }
+    }
+}
+
+void AnimationPose::Reset(const Skeleton& skeleton, unsigned maxDepth)
+{
+    const Vector<Bone>& bones = skeleton.GetBones();
+    unsigned numBones = bones.Size();
+    if (numBones != positions_.Size())
+        Define(skeleton);
+
+    maxDepth_ = maxDepth;
+
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        if (!IsEvaluated(i))
+            continue;
+
+        const Bone& bone = bones[i];
+        positions_[i] = bone.initialPosition_;
+        rotations_[i] = bone.initialRotation_;
+        scales_[i] = bone.initialScale_;
+    }
+}
+
+void AnimationPose::ApplyToSkeleton(const Skeleton& skeleton) const
+{
+    const Vector<Bone>& bones = skeleton.GetBones();
+    unsigned numBones = Min(bones.Size(), positions_.Size());
+
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        const Bone& bone = bones[i];
+        if (bone.animated_ && bone.node_ && IsEvaluated(i))
+            bone.node_->SetTransformSilent(positions_[i], rotations_[i], scales_[i]);
+    }
+}
+
+void AnimationPose::UpdateWorldTransforms(const Skeleton& skeleton) const
+{
+    const Vector<Bone>& bones = skeleton.GetBones();
+    if (bones.Size() != order_.Size())
+        return;
+
+    for (PODVector<unsigned>::ConstIterator i = order_.Begin(); i != order_.End(); ++i)
+    {
+        Node* boneNode = bones[*i].node_;
+        if (boneNode)
+            boneNode->GetWorldTransform();
+    }
+}
+
+unsigned AnimationPose::GetNumEvaluatedBones(unsigned maxDepth) const
+{
+    if (!maxDepth)
+        return depths_.Size();
+
+    unsigned count = 0;
+    for (unsigned i = 0; i < depths_.Size(); ++i)
+    {
+        if (depths_[i] <= maxDepth)
+            ++count;
+    }
+
+    return count;
+}
+
 AnimationState::AnimationState(AnimatedModel* model, Animation* animation) :
     model_(model),
     animation_(animation),
@@ -153,6 +254,7 @@ void AnimationState::SetStartBone(Bone* startBone)
         if (trackBone && trackBone->node_)
         {
             stateTrack.bone_ = trackBone;
+            stateTrack.boneIndex_ = (unsigned)(trackBone - &skeleton.GetModifiableBones()[0]);
             stateTrack.node_ = trackBone->node_;
             stateTracks_.Push(stateTrack);
         }
@@ -456,6 +558,60 @@ void AnimationState::Apply()
         ApplyToNodes();
 }
 
+void AnimationState::ApplyToPose(AnimationPose& pose)
+{
+    if (!animation_ || !model_ || !IsEnabled())
+        return;
+
+    // Read and write the pose arrays instead of the bone nodes, so that blending several states does not touch the scene graph
+    Vector3* positions = pose.positions_.Buffer();
+    Quaternion* rotations = pose.rotations_.Buffer();
+    Vector3* scales = pose.scales_.Buffer();
+    unsigned numBones = pose.GetNumBones();
+    bool additive = blendingMode_ == ABM_ADDITIVE;
+
+    for (Vector<AnimationStateTrack>::Iterator i = stateTracks_.Begin(); i != stateTracks_.End(); ++i)
+    {
+        AnimationStateTrack& stateTrack = *i;
+        float weight = weight_ * stateTrack.weight_;
+        unsigned index = stateTrack.boneIndex_;
+
+        if (Equals(weight, 0.0f) || index >= numBones || !stateTrack.bone_->animated_ || !pose.IsEvaluated(index))
+            continue;
+
+        Vector3 newPosition;
+        Quaternion newRotation;
+        Vector3 newScale;
+        if (!SampleTrack(stateTrack, newPosition, newRotation, newScale))
+            continue;
+
+        unsigned char channelMask = stateTrack.track_->channelMask_;
+        const Bone& bone = *stateTrack.bone_;
+        bool fullWeight = Equals(weight, 1.0f);
+
+        if (channelMask & CHANNEL_POSITION)
+        {
+            if (additive)
+                positions[index] += (newPosition - bone.initialPosition_) * weight;
+            else
+                positions[index] = fullWeight ? newPosition : positions[index].Lerp(newPosition, weight);
+        }
+        if (channelMask & CHANNEL_ROTATION)
+        {
+            if (additive)
+                newRotation = (newRotation * bone.initialRotation_.Inverse() * rotations[index]).Normalized();
+            rotations[index] = fullWeight ? newRotation : rotations[index].Slerp(newRotation, weight);
+        }
+        if (channelMask & CHANNEL_SCALE)
+        {
+            if (additive)
+                scales[index] += (newScale - bone.initialScale_) * weight;
+            else
+                scales[index] = fullWeight ? newScale : scales[index].Lerp(newScale, weight);
+        }
+    }
+}
+
 void AnimationState::ApplyToModel()
 {
     for (Vector<AnimationStateTrack>::Iterator i = stateTracks_.Begin(); i != stateTracks_.End(); ++i)
@@ -480,61 +636,18 @@ void AnimationState::ApplyToNodes()
 
 void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, bool silent)
 {
-    const AnimationTrack* track = stateTrack.track_;
     Node* node = stateTrack.node_;
-
-    if (track->keyFrames_.Empty() || !node)
+    if (!node)
         return;
 
-    unsigned& frame = stateTrack.keyFrame_;
-    track->GetKeyFrameIndex(time_, frame);
-
-    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
-    unsigned nextFrame = frame + 1;
-    bool interpolate = true;
-    if (nextFrame >= track->keyFrames_.Size())
-    {
-        if (!looped_)
-        {
-            nextFrame = frame;
-            interpolate = false;
-        }
-        else
-            nextFrame = 0;
-    }
-
-    const AnimationKeyFrame* keyFrame = &track->keyFrames_[frame];
-    unsigned char channelMask = track->channelMask_;
-
     Vector3 newPosition;
     Quaternion newRotation;
     Vector3 newScale;
+    if (!SampleTrack(stateTrack, newPosition, newRotation, newScale))
+        return;
 
-    if (interpolate)
-    {
-        const AnimationKeyFrame* nextKeyFrame = &track->keyFrames_[nextFrame];
-        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
-        if (timeInterval < 0.0f)
-            timeInterval += animation_->GetLength();
-        float t = timeInterval > 0.0f ? (time_ - keyFrame->time_) / timeInterval : 1.0f;
+    unsigned char channelMask = stateTrack.track_->channelMask_;
 
-        if (channelMask & CHANNEL_POSITION)
-            newPosition = keyFrame->position_.Lerp(nextKeyFrame->position_, t);
-        if (channelMask & CHANNEL_ROTATION)
-            newRotation = keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t);
-        if (channelMask & CHANNEL_SCALE)
-            newScale = keyFrame->scale_.Lerp(nextKeyFrame->scale_, t);
-    }
-    else
-    {
-        if (channelMask & CHANNEL_POSITION)
-            newPosition = keyFrame->position_;
-        if (channelMask & CHANNEL_ROTATION)
-            newRotation = keyFrame->rotation_;
-        if (channelMask & CHANNEL_SCALE)
-            newScale = keyFrame->scale_;
-    }
-    
     if (blendingMode_ == ABM_ADDITIVE) // not ABM_LERP
     {
         if (channelMask & CHANNEL_POSITION)
@@ -588,4 +701,71 @@ void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, b
     }
 }
 
+bool AnimationState::SampleTrack(AnimationStateTrack& stateTrack, Vector3& newPosition, Quaternion& newRotation,
+    Vector3& newScale)
+{
+    const AnimationTrack* track = stateTrack.track_;
+    unsigned numKeyFrames = track->GetNumKeyFrames();
+    if (!numKeyFrames)
+        return false;
+
+    unsigned& frame = stateTrack.keyFrame_;
+    track->GetKeyFrameIndex(time_, frame);
+
+    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
+    unsigned nextFrame = frame + 1;
+    bool interpolate = true;
+    if (nextFrame >= numKeyFrames)
+    {
+        if (!looped_)
+        {
+            nextFrame = frame;
+            interpolate = false;
+        }
+        else
+            nextFrame = 0;
+    }
+
+    // Compressed tracks are decoded into temporary keyframes, float tracks are read in place
+    AnimationKeyFrame decoded[2];
+    bool compressed = track->IsCompressed();
+    const AnimationKeyFrame* keyFrame = &decoded[0];
+    if (compressed)
+        track->ReadKeyFrame(frame, decoded[0]);
+    else
+        keyFrame = &track->keyFrames_[frame];
+    unsigned char channelMask = track->channelMask_;
+
+    if (interpolate)
+    {
+        const AnimationKeyFrame* nextKeyFrame = &decoded[1];
+        if (compressed)
+            track->ReadKeyFrame(nextFrame, decoded[1]);
+        else
+            nextKeyFrame = &track->keyFrames_[nextFrame];
+        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
+        if (timeInterval < 0.0f)
+            timeInterval += animation_->GetLength();
+        float t = timeInterval > 0.0f ? (time_ - keyFrame->time_) / timeInterval : 1.0f;
+
+        if (channelMask & CHANNEL_POSITION)
+            newPosition = keyFrame->position_.Lerp(nextKeyFrame->position_, t);
+        if (channelMask & CHANNEL_ROTATION)
+            newRotation = keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t);
+        if (channelMask & CHANNEL_SCALE)
+            newScale = keyFrame->scale_.Lerp(nextKeyFrame->scale_, t);
+    }
+    else
+    {
+        if (channelMask & CHANNEL_POSITION)
+            newPosition = keyFrame->position_;
+        if (channelMask & CHANNEL_ROTATION)
+            newRotation = keyFrame->rotation_;
+        if (channelMask & CHANNEL_SCALE)
+            newScale = keyFrame->scale_;
+    }
+
+    return true;
+}
+
 }
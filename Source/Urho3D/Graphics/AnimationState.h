@@ -24,6 +24,8 @@
 
 #include "../Container/HashMap.h"
 #include "../Container/Ptr.h"
+#include "../Math/Quaternion.h"
+#include "../Math/StringHash.h"
 
 namespace Urho3D
 {
@@ -31,6 +33,7 @@ namespace Urho3D
 class Animation;
 class AnimatedModel;
 class Deserializer;
+class Node;
 class Serializer;
 class Skeleton;
 struct AnimationTrack;
@@ -63,6 +66,49 @@ struct AnimationStateTrack
     float weight_;
     /// Last key frame.
     unsigned keyFrame_;
+    /// Bone index in the skeleton (model mode.)
+    unsigned boneIndex_;
+};
+
+/// Local bone transforms of an animated model, stored as contiguous arrays indexed by bone index. Animation states are blended into the pose, which is then written to the bone nodes in one pass. Skin matrices are not calculated from the pose, as the bone nodes may still be moved afterward, for example by IK.
+struct URHO3D_API AnimationPose
+{
+    /// Construct.
+    AnimationPose() :
+        maxDepth_(0)
+    {
+    }
+
+    /// Resize to the skeleton and calculate bone depths in the hierarchy.
+    void Define(const Skeleton& skeleton);
+    /// Set the initial (bind) pose to the bones that will be evaluated. Bones deeper than maxDepth are skipped, 0 evaluates all.
+    void Reset(const Skeleton& skeleton, unsigned maxDepth = 0);
+    /// Write the pose to the nodes of evaluated animated bones silently.
+    void ApplyToSkeleton(const Skeleton& skeleton) const;
+    /// Query the world transforms of the bone nodes with parents before their children. The on-demand update of each bone then finds its parent already updated and does not recurse further.
+    void UpdateWorldTransforms(const Skeleton& skeleton) const;
+
+    /// Return number of bones.
+    unsigned GetNumBones() const { return positions_.Size(); }
+
+    /// Return whether a bone is evaluated with the current depth limit.
+    bool IsEvaluated(unsigned index) const { return !maxDepth_ || depths_[index] <= maxDepth_; }
+
+    /// Return number of bones that a depth limit would evaluate, 0 for no limit.
+    unsigned GetNumEvaluatedBones(unsigned maxDepth) const;
+
+    /// Bone positions.
+    PODVector<Vector3> positions_;
+    /// Bone rotations.
+    PODVector<Quaternion> rotations_;
+    /// Bone scales.
+    PODVector<Vector3> scales_;
+    /// Bone depths in the hierarchy, root bone is 1.
+    PODVector<unsigned> depths_;
+    /// Bone indices sorted by depth.
+    PODVector<unsigned> order_;
+    /// Current depth limit.
+    unsigned maxDepth_;
 };
 
 /// %Animation instance.
@@ -144,6 +190,8 @@ public:
 
     /// Apply the animation at the current time position.
     void Apply();
+    /// Blend the animation at the current time position into a skeleton pose. Model mode only. Partial weights are blended with normalized lerp.
+    void ApplyToPose(AnimationPose& pose);
 
 private:
     /// Apply animation to a skeleton. Transform changes are applied silently, so the model needs to dirty its root model afterward.
@@ -152,6 +200,8 @@ private:
     void ApplyToNodes();
     /// Apply track.
     void ApplyTrack(AnimationStateTrack& stateTrack, float weight, bool silent);
+    /// Sample the track's channels at the current time position. Return false if the track has no keyframes.
+    bool SampleTrack(AnimationStateTrack& stateTrack, Vector3& newPosition, Quaternion& newRotation, Vector3& newScale);
 
     /// Animated model (model mode.)
     WeakPtr<AnimatedModel> model_;
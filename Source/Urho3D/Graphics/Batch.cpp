@@ -26,13 +26,17 @@
 #include "../Graphics/Geometry.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/GraphicsImpl.h"
+#include "../Graphics/LightClusters.h"
 #include "../Graphics/Material.h"
+#include "../Graphics/RenderCommandList.h"
 #include "../Graphics/Renderer.h"
+#include "../Graphics/ShaderParameterBlock.h"
 #include "../Graphics/ShaderVariation.h"
 #include "../Graphics/Technique.h"
 #include "../Graphics/Texture2D.h"
 #include "../Graphics/VertexBuffer.h"
 #include "../Graphics/View.h"
+#include "../Graphics/Zone.h"
 #include "../Scene/Scene.h"
 
 #include "../DebugNew.h"
@@ -159,6 +163,238 @@ void CalculateSpotMatrix(Matrix4& dest, Light* light)
     dest = texAdjust * spotProj * spotView;
 }
 
+static void BuildLightShaderParameters(ShaderParameterBlock* dest, LightBatchQueue* lightQueue, Camera* camera, Renderer* renderer,
+    bool shadowMapSampled)
+{
+    Light* light = lightQueue->light_;
+    Texture2D* shadowMap = lightQueue->shadowMap_;
+
+    Node* lightNode = light->GetNode();
+    float atten = 1.0f / Max(light->GetRange(), M_EPSILON);
+    Vector3 lightDir(lightNode->GetWorldRotation() * Vector3::BACK);
+    Vector4 lightPos(lightNode->GetWorldPosition(), atten);
+
+    dest->AddParameter(VSP_LIGHTDIR, lightDir);
+    dest->AddParameter(VSP_LIGHTPOS, lightPos);
+
+    // Calculate the light matrices once for both shader stages. Spot light shadow matrices are only set to vertex shaders
+    // that sample the shadow map
+    Matrix4 lightMatrices[MAX_CASCADE_SPLITS > 1 ? MAX_CASCADE_SPLITS : 2];
+    unsigned vsMatrixCount = 0;
+    unsigned psMatrixCount = 0;
+
+    switch (light->GetLightType())
+    {
+    case LIGHT_DIRECTIONAL:
+        {
+            unsigned numSplits = Min(MAX_CASCADE_SPLITS, lightQueue->shadowSplits_.Size());
+
+            for (unsigned i = 0; i < numSplits; ++i)
+                CalculateShadowMatrix(lightMatrices[i], lightQueue, i, renderer);
+
+            vsMatrixCount = psMatrixCount = 16 * numSplits;
+        }
+        break;
+
+    case LIGHT_SPOT:
+        CalculateSpotMatrix(lightMatrices[0], light);
+        if (shadowMap)
+            CalculateShadowMatrix(lightMatrices[1], lightQueue, 0, renderer);
+
+        vsMatrixCount = shadowMap && shadowMapSampled ? 32 : 16;
+        psMatrixCount = shadowMap ? 32 : 16;
+        break;
+
+    case LIGHT_POINT:
+        lightMatrices[0] = Matrix4(lightNode->GetWorldRotation().RotationMatrix());
+        // HLSL compiler will pack the parameters as if the matrix is only 3x4, so must be careful to not overwrite
+        // the next parameter
+#ifdef URHO3D_OPENGL
+        vsMatrixCount = psMatrixCount = 16;
+#else
+        vsMatrixCount = psMatrixCount = 12;
+#endif
+        break;
+    }
+
+    dest->AddParameter(VSP_LIGHTMATRICES, lightMatrices[0].Data(), vsMatrixCount);
+
+    float fade = 1.0f;
+    float fadeEnd = light->GetDrawDistance();
+    float fadeStart = light->GetFadeDistance();
+
+    // Do fade calculation for light if both fade & draw distance defined
+    if (light->GetLightType() != LIGHT_DIRECTIONAL && fadeEnd > 0.0f && fadeStart > 0.0f && fadeStart < fadeEnd)
+        fade = Min(1.0f - (light->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 1.0f);
+
+    // Negative lights will use subtract blending, so write absolute RGB values to the shader parameter
+    dest->AddParameter(PSP_LIGHTCOLOR, Color(light->GetEffectiveColor().Abs(),
+        light->GetEffectiveSpecularIntensity()) * fade);
+    dest->AddParameter(PSP_LIGHTDIR, lightDir);
+    dest->AddParameter(PSP_LIGHTPOS, lightPos);
+    dest->AddParameter(PSP_LIGHTRAD, light->GetRadius());
+    dest->AddParameter(PSP_LIGHTLENGTH, light->GetLength());
+
+    dest->AddParameter(PSP_LIGHTMATRICES, lightMatrices[0].Data(), psMatrixCount);
+
+    // Set shadow mapping shader parameters
+    if (shadowMap)
+    {
+        {
+            // Calculate point light shadow sampling offsets (unrolled cube map)
+            unsigned faceWidth = (unsigned)(shadowMap->GetWidth() / 2);
+            unsigned faceHeight = (unsigned)(shadowMap->GetHeight() / 3);
+            float width = (float)shadowMap->GetWidth();
+            float height = (float)shadowMap->GetHeight();
+#ifdef URHO3D_OPENGL
+            float mulX = (float)(faceWidth - 3) / width;
+            float mulY = (float)(faceHeight - 3) / height;
+            float addX = 1.5f / width;
+            float addY = 1.5f / height;
+#else
+            float mulX = (float)(faceWidth - 4) / width;
+            float mulY = (float)(faceHeight - 4) / height;
+            float addX = 2.5f / width;
+            float addY = 2.5f / height;
+#endif
+            // If using 4 shadow samples, offset the position diagonally by half pixel
+            if (renderer->GetShadowQuality() == SHADOWQUALITY_PCF_16BIT || renderer->GetShadowQuality() == SHADOWQUALITY_PCF_24BIT)
+            {
+                addX -= 0.5f / width;
+                addY -= 0.5f / height;
+            }
+            dest->AddParameter(PSP_SHADOWCUBEADJUST, Vector4(mulX, mulY, addX, addY));
+        }
+
+        {
+            // Calculate shadow camera depth parameters for point light shadows and shadow fade parameters for
+            //  directional light shadows, stored in the same uniform
+            Camera* shadowCamera = lightQueue->shadowSplits_[0].shadowCamera_;
+            float nearClip = shadowCamera->GetNearClip();
+            float farClip = shadowCamera->GetFarClip();
+            float q = farClip / (farClip - nearClip);
+            float r = -q * nearClip;
+
+            const CascadeParameters& parameters = light->GetShadowCascade();
+            float viewFarClip = camera->GetFarClip();
+            float shadowRange = parameters.GetShadowRange();
+            float fadeStart = parameters.fadeStart_ * shadowRange / viewFarClip;
+            float fadeEnd = shadowRange / viewFarClip;
+            float fadeRange = fadeEnd - fadeStart;
+
+            dest->AddParameter(PSP_SHADOWDEPTHFADE, Vector4(q, r, fadeStart, 1.0f / fadeRange));
+        }
+
+        {
+            float intensity = light->GetShadowIntensity();
+            float fadeStart = light->GetShadowFadeDistance();
+            float fadeEnd = light->GetShadowDistance();
+            if (fadeStart > 0.0f && fadeEnd > 0.0f && fadeEnd > fadeStart)
+                intensity =
+                    Lerp(intensity, 1.0f, Clamp((light->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 0.0f, 1.0f));
+            float pcfValues = (1.0f - intensity);
+            float samples = 1.0f;
+            if (renderer->GetShadowQuality() == SHADOWQUALITY_PCF_16BIT || renderer->GetShadowQuality() == SHADOWQUALITY_PCF_24BIT)
+                samples = 4.0f;
+            dest->AddParameter(PSP_SHADOWINTENSITY, Vector4(pcfValues / samples, intensity, 0.0f, 0.0f));
+        }
+
+        float sizeX = 1.0f / (float)shadowMap->GetWidth();
+        float sizeY = 1.0f / (float)shadowMap->GetHeight();
+        dest->AddParameter(PSP_SHADOWMAPINVSIZE, Vector2(sizeX, sizeY));
+
+        Vector4 lightSplits(M_LARGE_VALUE, M_LARGE_VALUE, M_LARGE_VALUE, M_LARGE_VALUE);
+        if (lightQueue->shadowSplits_.Size() > 1)
+            lightSplits.x_ = lightQueue->shadowSplits_[0].farSplit_ / camera->GetFarClip();
+        if (lightQueue->shadowSplits_.Size() > 2)
+            lightSplits.y_ = lightQueue->shadowSplits_[1].farSplit_ / camera->GetFarClip();
+        if (lightQueue->shadowSplits_.Size() > 3)
+            lightSplits.z_ = lightQueue->shadowSplits_[2].farSplit_ / camera->GetFarClip();
+
+        dest->AddParameter(PSP_SHADOWSPLITS, lightSplits);
+
+        dest->AddParameter(PSP_VSMSHADOWPARAMS, renderer->GetVSMShadowParameters());
+
+        if (light->GetShadowBias().normalOffset_ > 0.0f)
+        {
+            Vector4 normalOffsetScale(Vector4::ZERO);
+
+            // Scale normal offset strength with the width of the shadow camera view
+            if (light->GetLightType() != LIGHT_DIRECTIONAL)
+            {
+                Camera* shadowCamera = lightQueue->shadowSplits_[0].shadowCamera_;
+                normalOffsetScale.x_ = 2.0f * tanf(shadowCamera->GetFov() * M_DEGTORAD * 0.5f) * shadowCamera->GetFarClip();
+            }
+            else
+            {
+                normalOffsetScale.x_ = lightQueue->shadowSplits_[0].shadowCamera_->GetOrthoSize();
+                if (lightQueue->shadowSplits_.Size() > 1)
+                    normalOffsetScale.y_ = lightQueue->shadowSplits_[1].shadowCamera_->GetOrthoSize();
+                if (lightQueue->shadowSplits_.Size() > 2)
+                    normalOffsetScale.z_ = lightQueue->shadowSplits_[2].shadowCamera_->GetOrthoSize();
+                if (lightQueue->shadowSplits_.Size() > 3)
+                    normalOffsetScale.w_ = lightQueue->shadowSplits_[3].shadowCamera_->GetOrthoSize();
+            }
+
+            normalOffsetScale *= light->GetShadowBias().normalOffset_;
+#ifdef GL_ES_VERSION_2_0
+            normalOffsetScale *= renderer->GetMobileNormalOffsetMul();
+#endif
+            dest->AddParameter(VSP_NORMALOFFSETSCALE, normalOffsetScale);
+            dest->AddParameter(PSP_NORMALOFFSETSCALE, normalOffsetScale);
+        }
+    }
+}
+
+static void BuildVertexLightShaderParameters(ShaderParameterBlock* dest, const PODVector<Light*>& lights)
+{
+    Vector4 vertexLights[MAX_VERTEX_LIGHTS * 3];
+
+    for (unsigned i = 0; i < lights.Size(); ++i)
+    {
+        Light* vertexLight = lights[i];
+        Node* vertexLightNode = vertexLight->GetNode();
+        LightType type = vertexLight->GetLightType();
+
+        // Attenuation
+        float invRange, cutoff, invCutoff;
+        if (type == LIGHT_DIRECTIONAL)
+            invRange = 0.0f;
+        else
+            invRange = 1.0f / Max(vertexLight->GetRange(), M_EPSILON);
+        if (type == LIGHT_SPOT)
+        {
+            cutoff = Cos(vertexLight->GetFov() * 0.5f);
+            invCutoff = 1.0f / (1.0f - cutoff);
+        }
+        else
+        {
+            cutoff = -1.0f;
+            invCutoff = 1.0f;
+        }
+
+        // Color
+        float fade = 1.0f;
+        float fadeEnd = vertexLight->GetDrawDistance();
+        float fadeStart = vertexLight->GetFadeDistance();
+
+        // Do fade calculation for light if both fade & draw distance defined
+        if (vertexLight->GetLightType() != LIGHT_DIRECTIONAL && fadeEnd > 0.0f && fadeStart > 0.0f && fadeStart < fadeEnd)
+            fade = Min(1.0f - (vertexLight->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 1.0f);
+
+        Color color = vertexLight->GetEffectiveColor() * fade;
+        vertexLights[i * 3] = Vector4(color.r_, color.g_, color.b_, invRange);
+
+        // Direction
+        vertexLights[i * 3 + 1] = Vector4(-(vertexLightNode->GetWorldDirection()), cutoff);
+
+        // Position
+        vertexLights[i * 3 + 2] = Vector4(vertexLightNode->GetWorldPosition(), invCutoff);
+    }
+
+    dest->AddParameter(VSP_VERTEXLIGHTS, vertexLights[0].Data(), lights.Size() * 3 * 4);
+}
+
 void Batch::CalculateSortKey()
 {
     unsigned shaderID = (unsigned)(
@@ -180,14 +416,14 @@ void Batch::Prepare(View* view, Camera* camera, bool setModelTransform, bool all
     if (!vertexShader_ || !pixelShader_)
         return;
 
-    Graphics* graphics = view->GetGraphics();
+    RenderCommandList* commandList = view->GetCommandList();
     Renderer* renderer = view->GetRenderer();
     Node* cameraNode = camera ? camera->GetNode() : 0;
     Light* light = lightQueue_ ? lightQueue_->light_ : 0;
     Texture2D* shadowMap = lightQueue_ ? lightQueue_->shadowMap_ : 0;
 
     // Set shaders first. The available shader parameters and their register/uniform positions depend on the currently set shaders
-    graphics->SetShaders(vertexShader_, pixelShader_);
+    commandList->SetShaders(vertexShader_, pixelShader_);
 
     // Set pass / material-specific renderstates
     if (pass_ && material_)
@@ -201,8 +437,8 @@ void Batch::Prepare(View* view, Camera* camera, bool setModelTransform, bool all
             else if (blend == BLEND_ADDALPHA)
                 blend = BLEND_SUBTRACTALPHA;
         }
-        graphics->SetBlendMode(blend, pass_->GetAlphaToCoverage() || material_->GetAlphaToCoverage());
-        graphics->SetLineAntiAlias(material_->GetLineAntiAlias());
+        commandList->SetBlendMode(blend, pass_->GetAlphaToCoverage() || material_->GetAlphaToCoverage());
+        commandList->SetLineAntiAlias(material_->GetLineAntiAlias());
 
         bool isShadowPass = pass_->GetIndex() == Technique::shadowPassIndex;
         CullMode effectiveCullMode = pass_->GetCullMode();
@@ -214,25 +450,25 @@ void Batch::Prepare(View* view, Camera* camera, bool setModelTransform, bool all
         if (!isShadowPass)
         {
             const BiasParameters& depthBias = material_->GetDepthBias();
-            graphics->SetDepthBias(depthBias.constantBias_, depthBias.slopeScaledBias_);
+            commandList->SetDepthBias(depthBias.constantBias_, depthBias.slopeScaledBias_);
         }
 
         // Use the "least filled" fill mode combined from camera & material
-        graphics->SetFillMode((FillMode)(Max(camera->GetFillMode(), material_->GetFillMode())));
-        graphics->SetDepthTest(pass_->GetDepthTestMode());
-        graphics->SetDepthWrite(pass_->GetDepthWrite() && allowDepthWrite);
+        commandList->SetFillMode((FillMode)(Max(camera->GetFillMode(), material_->GetFillMode())));
+        commandList->SetDepthTest(pass_->GetDepthTestMode());
+        commandList->SetDepthWrite(pass_->GetDepthWrite() && allowDepthWrite);
     }
 
     // Set global (per-frame) shader parameters
-    if (graphics->NeedParameterUpdate(SP_FRAME, (void*)0))
+    if (commandList->NeedParameterUpdate(SP_FRAME, (void*)0))
         view->SetGlobalShaderParameters();
 
     // Set camera & viewport shader parameters
     unsigned cameraHash = (unsigned)(size_t)camera;
-    IntRect viewport = graphics->GetViewport();
+    IntRect viewport = commandList->GetViewport();
     IntVector2 viewSize = IntVector2(viewport.Width(), viewport.Height());
     unsigned viewportHash = (unsigned)(viewSize.x_ | (viewSize.y_ << 16));
-    if (graphics->NeedParameterUpdate(SP_CAMERA, reinterpret_cast<const void*>(cameraHash + viewportHash)))
+    if (commandList->NeedParameterUpdate(SP_CAMERA, reinterpret_cast<const void*>(cameraHash + viewportHash)))
     {
         view->SetCameraShaderParameters(camera);
         // During renderpath commands the G-Buffer or viewport texture is assumed to always be viewport-sized
@@ -240,51 +476,34 @@ void Batch::Prepare(View* view, Camera* camera, bool setModelTransform, bool all
     }
 
     // Set model or skinning transforms
-    if (setModelTransform && graphics->NeedParameterUpdate(SP_OBJECT, worldTransform_))
+    if (setModelTransform && commandList->NeedParameterUpdate(SP_OBJECT, worldTransform_))
     {
         if (geometryType_ == GEOM_SKINNED)
         {
-            graphics->SetShaderParameter(VSP_SKINMATRICES, reinterpret_cast<const float*>(worldTransform_),
+            commandList->SetShaderParameter(VSP_SKINMATRICES, reinterpret_cast<const float*>(worldTransform_),
                 12 * numWorldTransforms_);
         }
         else
-            graphics->SetShaderParameter(VSP_MODEL, *worldTransform_);
+            commandList->SetShaderParameter(VSP_MODEL, *worldTransform_);
 
         // Set the orientation for billboards, either from the object itself or from the camera
         if (geometryType_ == GEOM_BILLBOARD)
         {
             if (numWorldTransforms_ > 1)
-                graphics->SetShaderParameter(VSP_BILLBOARDROT, worldTransform_[1].RotationMatrix());
+                commandList->SetShaderParameter(VSP_BILLBOARDROT, worldTransform_[1].RotationMatrix());
             else
-                graphics->SetShaderParameter(VSP_BILLBOARDROT, cameraNode->GetWorldRotation().RotationMatrix());
+                commandList->SetShaderParameter(VSP_BILLBOARDROT, cameraNode->GetWorldRotation().RotationMatrix());
         }
     }
 
     // Set zone-related shader parameters
-    BlendMode blend = graphics->GetBlendMode();
+    BlendMode blend = commandList->GetBlendMode();
     // If the pass is additive, override fog color to black so that shaders do not need a separate additive path
     bool overrideFogColorToBlack = blend == BLEND_ADD || blend == BLEND_ADDALPHA;
-    unsigned zoneHash = (unsigned)(size_t)zone_;
-    if (overrideFogColorToBlack)
-        zoneHash += 0x80000000;
-    if (zone_ && graphics->NeedParameterUpdate(SP_ZONE, reinterpret_cast<const void*>(zoneHash)))
+    ShaderParameterBlock* zoneParameters = zone_ ? zone_->GetShaderParameterBlock(overrideFogColorToBlack) : 0;
+    if (zoneParameters && commandList->NeedParameterUpdate(SP_ZONE, reinterpret_cast<const void*>(zoneParameters->GetVersion())))
     {
-        graphics->SetShaderParameter(VSP_AMBIENTSTARTCOLOR, zone_->GetAmbientStartColor());
-        graphics->SetShaderParameter(VSP_AMBIENTENDCOLOR,
-            zone_->GetAmbientEndColor().ToVector4() - zone_->GetAmbientStartColor().ToVector4());
-
-        const BoundingBox& box = zone_->GetBoundingBox();
-        Vector3 boxSize = box.Size();
-        Matrix3x4 adjust(Matrix3x4::IDENTITY);
-        adjust.SetScale(Vector3(1.0f / boxSize.x_, 1.0f / boxSize.y_, 1.0f / boxSize.z_));
-        adjust.SetTranslation(Vector3(0.5f, 0.5f, 0.5f));
-        Matrix3x4 zoneTransform = adjust * zone_->GetInverseWorldTransform();
-        graphics->SetShaderParameter(VSP_ZONE, zoneTransform);
-
-        graphics->SetShaderParameter(PSP_AMBIENTCOLOR, zone_->GetAmbientColor());
-        graphics->SetShaderParameter(PSP_FOGCOLOR, overrideFogColorToBlack ? Color::BLACK : zone_->GetFogColor());
-        graphics->SetShaderParameter(PSP_ZONEMIN, zone_->GetBoundingBox().min_);
-        graphics->SetShaderParameter(PSP_ZONEMAX, zone_->GetBoundingBox().max_);
+        commandList->SetShaderParameters(zoneParameters);
 
         float farClip = camera->GetFarClip();
         float fogStart = Min(zone_->GetFogStart(), farClip);
@@ -302,333 +521,91 @@ void Batch::Prepare(View* view, Camera* camera, bool setModelTransform, bool all
             fogParams.w_ = zone_->GetFogHeightScale() / Max(zoneNode->GetWorldScale().y_, M_EPSILON);
         }
 
-        graphics->SetShaderParameter(PSP_FOGPARAMS, fogParams);
+        commandList->SetShaderParameter(PSP_FOGPARAMS, fogParams);
     }
 
     // Set light-related shader parameters
     if (lightQueue_)
     {
-        if (light && graphics->NeedParameterUpdate(SP_LIGHT, lightQueue_))
+        if (light)
         {
-            Node* lightNode = light->GetNode();
-            float atten = 1.0f / Max(light->GetRange(), M_EPSILON);
-            Vector3 lightDir(lightNode->GetWorldRotation() * Vector3::BACK);
-            Vector4 lightPos(lightNode->GetWorldPosition(), atten);
-
-            graphics->SetShaderParameter(VSP_LIGHTDIR, lightDir);
-            graphics->SetShaderParameter(VSP_LIGHTPOS, lightPos);
-
-            if (graphics->HasShaderParameter(VSP_LIGHTMATRICES))
+            // Spot light shadow matrices must only be set to vertex shaders that sample the shadow map, so a separate
+            // block is built for those that do not
+            unsigned blockIndex = shadowMap && light->GetLightType() == LIGHT_SPOT && !commandList->HasTextureUnit(TU_SHADOWMAP) ? 1 : 0;
+            SharedPtr<ShaderParameterBlock>& lightParameters = lightQueue_->shaderParameters_[blockIndex];
+            if (!lightParameters)
             {
-                switch (light->GetLightType())
-                {
-                case LIGHT_DIRECTIONAL:
-                    {
-                        Matrix4 shadowMatrices[MAX_CASCADE_SPLITS];
-                        unsigned numSplits = Min(MAX_CASCADE_SPLITS, lightQueue_->shadowSplits_.Size());
-
-                        for (unsigned i = 0; i < numSplits; ++i)
-                            CalculateShadowMatrix(shadowMatrices[i], lightQueue_, i, renderer);
-
-                        graphics->SetShaderParameter(VSP_LIGHTMATRICES, shadowMatrices[0].Data(), 16 * numSplits);
-                    }
-                    break;
-
-                case LIGHT_SPOT:
-                    {
-                        Matrix4 shadowMatrices[2];
-
-                        CalculateSpotMatrix(shadowMatrices[0], light);
-                        bool isShadowed = shadowMap && graphics->HasTextureUnit(TU_SHADOWMAP);
-                        if (isShadowed)
-                            CalculateShadowMatrix(shadowMatrices[1], lightQueue_, 0, renderer);
-
-                        graphics->SetShaderParameter(VSP_LIGHTMATRICES, shadowMatrices[0].Data(), isShadowed ? 32 : 16);
-                    }
-                    break;
-
-                case LIGHT_POINT:
-                    {
-                        Matrix4 lightVecRot(lightNode->GetWorldRotation().RotationMatrix());
-                        // HLSL compiler will pack the parameters as if the matrix is only 3x4, so must be careful to not overwrite
-                        // the next parameter
-#ifdef URHO3D_OPENGL
-                        graphics->SetShaderParameter(VSP_LIGHTMATRICES, lightVecRot.Data(), 16);
-#else
-                        graphics->SetShaderParameter(VSP_LIGHTMATRICES, lightVecRot.Data(), 12);
-#endif
-                    }
-                    break;
-                }
-            }
-
-            float fade = 1.0f;
-            float fadeEnd = light->GetDrawDistance();
-            float fadeStart = light->GetFadeDistance();
-
-            // Do fade calculation for light if both fade & draw distance defined
-            if (light->GetLightType() != LIGHT_DIRECTIONAL && fadeEnd > 0.0f && fadeStart > 0.0f && fadeStart < fadeEnd)
-                fade = Min(1.0f - (light->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 1.0f);
-
-            // Negative lights will use subtract blending, so write absolute RGB values to the shader parameter
-            graphics->SetShaderParameter(PSP_LIGHTCOLOR, Color(light->GetEffectiveColor().Abs(),
-                light->GetEffectiveSpecularIntensity()) * fade);
-            graphics->SetShaderParameter(PSP_LIGHTDIR, lightDir);
-            graphics->SetShaderParameter(PSP_LIGHTPOS, lightPos);
-            graphics->SetShaderParameter(PSP_LIGHTRAD, light->GetRadius());
-            graphics->SetShaderParameter(PSP_LIGHTLENGTH, light->GetLength());
-
-            if (graphics->HasShaderParameter(PSP_LIGHTMATRICES))
-            {
-                switch (light->GetLightType())
-                {
-                case LIGHT_DIRECTIONAL:
-                    {
-                        Matrix4 shadowMatrices[MAX_CASCADE_SPLITS];
-                        unsigned numSplits = Min(MAX_CASCADE_SPLITS, lightQueue_->shadowSplits_.Size());
-
-                        for (unsigned i = 0; i < numSplits; ++i)
-                            CalculateShadowMatrix(shadowMatrices[i], lightQueue_, i, renderer);
-
-                        graphics->SetShaderParameter(PSP_LIGHTMATRICES, shadowMatrices[0].Data(), 16 * numSplits);
-                    }
-                    break;
-
-                case LIGHT_SPOT:
-                    {
-                        Matrix4 shadowMatrices[2];
-
-                        CalculateSpotMatrix(shadowMatrices[0], light);
-                        bool isShadowed = lightQueue_->shadowMap_ != 0;
-                        if (isShadowed)
-                            CalculateShadowMatrix(shadowMatrices[1], lightQueue_, 0, renderer);
-
-                        graphics->SetShaderParameter(PSP_LIGHTMATRICES, shadowMatrices[0].Data(), isShadowed ? 32 : 16);
-                    }
-                    break;
-
-                case LIGHT_POINT:
-                    {
-                        Matrix4 lightVecRot(lightNode->GetWorldRotation().RotationMatrix());
-                        // HLSL compiler will pack the parameters as if the matrix is only 3x4, so must be careful to not overwrite
-                        // the next parameter
-#ifdef URHO3D_OPENGL
-                        graphics->SetShaderParameter(PSP_LIGHTMATRICES, lightVecRot.Data(), 16);
-#else
-                        graphics->SetShaderParameter(PSP_LIGHTMATRICES, lightVecRot.Data(), 12);
-#endif
-                    }
-                    break;
-                }
-            }
-
-            // Set shadow mapping shader parameters
-            if (shadowMap)
-            {
-                {
-                    // Calculate point light shadow sampling offsets (unrolled cube map)
-                    unsigned faceWidth = (unsigned)(shadowMap->GetWidth() / 2);
-                    unsigned faceHeight = (unsigned)(shadowMap->GetHeight() / 3);
-                    float width = (float)shadowMap->GetWidth();
-                    float height = (float)shadowMap->GetHeight();
-#ifdef URHO3D_OPENGL
-                    float mulX = (float)(faceWidth - 3) / width;
-                    float mulY = (float)(faceHeight - 3) / height;
-                    float addX = 1.5f / width;
-                    float addY = 1.5f / height;
-#else
-                    float mulX = (float)(faceWidth - 4) / width;
-                    float mulY = (float)(faceHeight - 4) / height;
-                    float addX = 2.5f / width;
-                    float addY = 2.5f / height;
-#endif
-                    // If using 4 shadow samples, offset the position diagonally by half pixel
-                    if (renderer->GetShadowQuality() == SHADOWQUALITY_PCF_16BIT || renderer->GetShadowQuality() == SHADOWQUALITY_PCF_24BIT)
-                    {
-                        addX -= 0.5f / width;
-                        addY -= 0.5f / height;
-                    }
-                    graphics->SetShaderParameter(PSP_SHADOWCUBEADJUST, Vector4(mulX, mulY, addX, addY));
-                }
-
-                {
-                    // Calculate shadow camera depth parameters for point light shadows and shadow fade parameters for
-                    //  directional light shadows, stored in the same uniform
-                    Camera* shadowCamera = lightQueue_->shadowSplits_[0].shadowCamera_;
-                    float nearClip = shadowCamera->GetNearClip();
-                    float farClip = shadowCamera->GetFarClip();
-                    float q = farClip / (farClip - nearClip);
-                    float r = -q * nearClip;
-
-                    const CascadeParameters& parameters = light->GetShadowCascade();
-                    float viewFarClip = camera->GetFarClip();
-                    float shadowRange = parameters.GetShadowRange();
-                    float fadeStart = parameters.fadeStart_ * shadowRange / viewFarClip;
-                    float fadeEnd = shadowRange / viewFarClip;
-                    float fadeRange = fadeEnd - fadeStart;
-
-                    graphics->SetShaderParameter(PSP_SHADOWDEPTHFADE, Vector4(q, r, fadeStart, 1.0f / fadeRange));
-                }
-
-                {
-                    float intensity = light->GetShadowIntensity();
-                    float fadeStart = light->GetShadowFadeDistance();
-                    float fadeEnd = light->GetShadowDistance();
-                    if (fadeStart > 0.0f && fadeEnd > 0.0f && fadeEnd > fadeStart)
-                        intensity =
-                            Lerp(intensity, 1.0f, Clamp((light->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 0.0f, 1.0f));
-                    float pcfValues = (1.0f - intensity);
-                    float samples = 1.0f;
-                    if (renderer->GetShadowQuality() == SHADOWQUALITY_PCF_16BIT || renderer->GetShadowQuality() == SHADOWQUALITY_PCF_24BIT)
-                        samples = 4.0f;
-                    graphics->SetShaderParameter(PSP_SHADOWINTENSITY, Vector4(pcfValues / samples, intensity, 0.0f, 0.0f));
-                }
-
-                float sizeX = 1.0f / (float)shadowMap->GetWidth();
-                float sizeY = 1.0f / (float)shadowMap->GetHeight();
-                graphics->SetShaderParameter(PSP_SHADOWMAPINVSIZE, Vector2(sizeX, sizeY));
-
-                Vector4 lightSplits(M_LARGE_VALUE, M_LARGE_VALUE, M_LARGE_VALUE, M_LARGE_VALUE);
-                if (lightQueue_->shadowSplits_.Size() > 1)
-                    lightSplits.x_ = lightQueue_->shadowSplits_[0].farSplit_ / camera->GetFarClip();
-                if (lightQueue_->shadowSplits_.Size() > 2)
-                    lightSplits.y_ = lightQueue_->shadowSplits_[1].farSplit_ / camera->GetFarClip();
-                if (lightQueue_->shadowSplits_.Size() > 3)
-                    lightSplits.z_ = lightQueue_->shadowSplits_[2].farSplit_ / camera->GetFarClip();
-
-                graphics->SetShaderParameter(PSP_SHADOWSPLITS, lightSplits);
-
-                if (graphics->HasShaderParameter(PSP_VSMSHADOWPARAMS))
-                    graphics->SetShaderParameter(PSP_VSMSHADOWPARAMS, renderer->GetVSMShadowParameters());
-
-                if (light->GetShadowBias().normalOffset_ > 0.0f)
-                {
-                    Vector4 normalOffsetScale(Vector4::ZERO);
-
-                    // Scale normal offset strength with the width of the shadow camera view
-                    if (light->GetLightType() != LIGHT_DIRECTIONAL)
-                    {
-                        Camera* shadowCamera = lightQueue_->shadowSplits_[0].shadowCamera_;
-                        normalOffsetScale.x_ = 2.0f * tanf(shadowCamera->GetFov() * M_DEGTORAD * 0.5f) * shadowCamera->GetFarClip();
-                    }
-                    else
-                    {
-                        normalOffsetScale.x_ = lightQueue_->shadowSplits_[0].shadowCamera_->GetOrthoSize();
-                        if (lightQueue_->shadowSplits_.Size() > 1)
-                            normalOffsetScale.y_ = lightQueue_->shadowSplits_[1].shadowCamera_->GetOrthoSize();
-                        if (lightQueue_->shadowSplits_.Size() > 2)
-                            normalOffsetScale.z_ = lightQueue_->shadowSplits_[2].shadowCamera_->GetOrthoSize();
-                        if (lightQueue_->shadowSplits_.Size() > 3)
-                            normalOffsetScale.w_ = lightQueue_->shadowSplits_[3].shadowCamera_->GetOrthoSize();
-                    }
-
-                    normalOffsetScale *= light->GetShadowBias().normalOffset_;
-#ifdef GL_ES_VERSION_2_0
-                    normalOffsetScale *= renderer->GetMobileNormalOffsetMul();
-#endif
-                    graphics->SetShaderParameter(VSP_NORMALOFFSETSCALE, normalOffsetScale);
-                    graphics->SetShaderParameter(PSP_NORMALOFFSETSCALE, normalOffsetScale);
-                }
+                lightParameters = new ShaderParameterBlock();
+                BuildLightShaderParameters(lightParameters, lightQueue_, camera, renderer, blockIndex == 0);
             }
+            if (commandList->NeedParameterUpdate(SP_LIGHT, reinterpret_cast<const void*>(lightParameters->GetVersion())))
+                commandList->SetShaderParameters(lightParameters);
         }
-        else if (lightQueue_->vertexLights_.Size() && graphics->HasShaderParameter(VSP_VERTEXLIGHTS) &&
-                 graphics->NeedParameterUpdate(SP_LIGHT, lightQueue_))
+        else if (lightQueue_->vertexLights_.Size() && commandList->HasShaderParameter(VSP_VERTEXLIGHTS))
         {
-            Vector4 vertexLights[MAX_VERTEX_LIGHTS * 3];
-            const PODVector<Light*>& lights = lightQueue_->vertexLights_;
-
-            for (unsigned i = 0; i < lights.Size(); ++i)
+            SharedPtr<ShaderParameterBlock>& lightParameters = lightQueue_->shaderParameters_[0];
+            if (!lightParameters)
             {
-                Light* vertexLight = lights[i];
-                Node* vertexLightNode = vertexLight->GetNode();
-                LightType type = vertexLight->GetLightType();
-
-                // Attenuation
-                float invRange, cutoff, invCutoff;
-                if (type == LIGHT_DIRECTIONAL)
-                    invRange = 0.0f;
-                else
-                    invRange = 1.0f / Max(vertexLight->GetRange(), M_EPSILON);
-                if (type == LIGHT_SPOT)
-                {
-                    cutoff = Cos(vertexLight->GetFov() * 0.5f);
-                    invCutoff = 1.0f / (1.0f - cutoff);
-                }
-                else
-                {
-                    cutoff = -1.0f;
-                    invCutoff = 1.0f;
-                }
-
-                // Color
-                float fade = 1.0f;
-                float fadeEnd = vertexLight->GetDrawDistance();
-                float fadeStart = vertexLight->GetFadeDistance();
-
-                // Do fade calculation for light if both fade & draw distance defined
-                if (vertexLight->GetLightType() != LIGHT_DIRECTIONAL && fadeEnd > 0.0f && fadeStart > 0.0f && fadeStart < fadeEnd)
-                    fade = Min(1.0f - (vertexLight->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 1.0f);
-
-                Color color = vertexLight->GetEffectiveColor() * fade;
-                vertexLights[i * 3] = Vector4(color.r_, color.g_, color.b_, invRange);
-
-                // Direction
-                vertexLights[i * 3 + 1] = Vector4(-(vertexLightNode->GetWorldDirection()), cutoff);
-
-                // Position
-                vertexLights[i * 3 + 2] = Vector4(vertexLightNode->GetWorldPosition(), invCutoff);
+                lightParameters = new ShaderParameterBlock();
+                BuildVertexLightShaderParameters(lightParameters, lightQueue_->vertexLights_);
             }
-
-            graphics->SetShaderParameter(VSP_VERTEXLIGHTS, vertexLights[0].Data(), lights.Size() * 3 * 4);
+            if (commandList->NeedParameterUpdate(SP_LIGHT, reinterpret_cast<const void*>(lightParameters->GetVersion())))
+                commandList->SetShaderParameters(lightParameters);
         }
     }
 
     // Set zone texture if necessary
 #ifndef GL_ES_VERSION_2_0
-    if (zone_ && graphics->HasTextureUnit(TU_ZONE))
-        graphics->SetTexture(TU_ZONE, zone_->GetZoneTexture());
+    if (zone_ && commandList->HasTextureUnit(TU_ZONE))
+        commandList->SetTexture(TU_ZONE, zone_->GetZoneTexture());
 #else
     // On OpenGL ES set the zone texture to the environment unit instead
-    if (zone_ && zone_->GetZoneTexture() && graphics->HasTextureUnit(TU_ENVIRONMENT))
-        graphics->SetTexture(TU_ENVIRONMENT, zone_->GetZoneTexture());
+    if (zone_ && zone_->GetZoneTexture() && commandList->HasTextureUnit(TU_ENVIRONMENT))
+        commandList->SetTexture(TU_ENVIRONMENT, zone_->GetZoneTexture());
 #endif
 
     // Set material-specific shader parameters and textures
     if (material_)
     {
-        if (graphics->NeedParameterUpdate(SP_MATERIAL, reinterpret_cast<const void*>(material_->GetShaderParameterHash())))
-        {
-            const HashMap<StringHash, MaterialShaderParameter>& parameters = material_->GetShaderParameters();
-            for (HashMap<StringHash, MaterialShaderParameter>::ConstIterator i = parameters.Begin(); i != parameters.End(); ++i)
-                graphics->SetShaderParameter(i->first_, i->second_.value_);
-        }
+        if (commandList->NeedParameterUpdate(SP_MATERIAL, reinterpret_cast<const void*>(material_->GetShaderParameterHash())))
+            commandList->SetShaderParameters(material_->GetShaderParameterBlock());
 
         const HashMap<TextureUnit, SharedPtr<Texture> >& textures = material_->GetTextures();
         for (HashMap<TextureUnit, SharedPtr<Texture> >::ConstIterator i = textures.Begin(); i != textures.End(); ++i)
         {
-            if (graphics->HasTextureUnit(i->first_))
-                graphics->SetTexture(i->first_, i->second_.Get());
+            if (commandList->HasTextureUnit(i->first_))
+                commandList->SetTexture(i->first_, i->second_.Get());
         }
     }
 
+    // Set the light cluster textures for clustered forward lighting
+    LightClusters* clusters = light ? (LightClusters*)0 : view->GetLightClusters();
+    if (clusters && clusters->GetClusterTexture())
+    {
+        if (commandList->HasTextureUnit(TU_LIGHTRAMP))
+            commandList->SetTexture(TU_LIGHTRAMP, clusters->GetClusterTexture());
+        if (commandList->HasTextureUnit(TU_LIGHTSHAPE))
+            commandList->SetTexture(TU_LIGHTSHAPE, clusters->GetLightTexture());
+    }
+
     // Set light-related textures
     if (light)
     {
-        if (shadowMap && graphics->HasTextureUnit(TU_SHADOWMAP))
-            graphics->SetTexture(TU_SHADOWMAP, shadowMap);
-        if (graphics->HasTextureUnit(TU_LIGHTRAMP))
+        if (shadowMap && commandList->HasTextureUnit(TU_SHADOWMAP))
+            commandList->SetTexture(TU_SHADOWMAP, shadowMap);
+        if (commandList->HasTextureUnit(TU_LIGHTRAMP))
         {
             Texture* rampTexture = light->GetRampTexture();
             if (!rampTexture)
                 rampTexture = renderer->GetDefaultLightRamp();
-            graphics->SetTexture(TU_LIGHTRAMP, rampTexture);
+            commandList->SetTexture(TU_LIGHTRAMP, rampTexture);
         }
-        if (graphics->HasTextureUnit(TU_LIGHTSHAPE))
+        if (commandList->HasTextureUnit(TU_LIGHTSHAPE))
         {
             Texture* shapeTexture = light->GetShapeTexture();
             if (!shapeTexture && light->GetLightType() == LIGHT_SPOT)
                 shapeTexture = renderer->GetDefaultLightSpot();
-            graphics->SetTexture(TU_LIGHTSHAPE, shapeTexture);
+            commandList->SetTexture(TU_LIGHTSHAPE, shapeTexture);
         }
     }
 }
@@ -638,24 +615,43 @@ void Batch::Draw(View* view, Camera* camera, bool allowDepthWrite) const
     if (!geometry_->IsEmpty())
     {
         Prepare(view, camera, true, allowDepthWrite);
-        geometry_->Draw(view->GetGraphics());
+        view->GetCommandList()->Draw(geometry_);
     }
 }
 
 void BatchGroup::SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex)
 {
     // Do not use up buffer space if not going to draw as instanced
-    if (geometryType_ != GEOM_INSTANCED)
+    if (geometryType_ != GEOM_INSTANCED && geometryType_ != GEOM_SKINNED_INSTANCED)
         return;
 
     startIndex_ = freeIndex;
     unsigned char* buffer = static_cast<unsigned char*>(lockedData) + startIndex_ * stride;
 
+    // For skinned instancing, pack the skin matrices of all instances so that each draw call can set a contiguous range
+    unsigned instancesPerDraw = 0;
+    if (geometryType_ == GEOM_SKINNED_INSTANCED)
+    {
+        instancesPerDraw = GetSkinnedInstancesPerDraw();
+        skinMatrices_.Resize(instances_.Size() * numWorldTransforms_);
+    }
+
     for (unsigned i = 0; i < instances_.Size(); ++i)
     {
         const InstanceData& instance = instances_[i];
 
-        memcpy(buffer, instance.worldTransform_, sizeof(Matrix3x4));
+        if (instancesPerDraw)
+        {
+            memcpy(&skinMatrices_[i * numWorldTransforms_], instance.worldTransform_,
+                Min(instance.numWorldTransforms_, numWorldTransforms_) * sizeof(Matrix3x4));
+
+            // In place of the world transform, store the bone offset of the instance within its draw call
+            Matrix3x4 boneOffset(Matrix3x4::ZERO);
+            boneOffset.m00_ = (float)((i % instancesPerDraw) * numWorldTransforms_);
+            memcpy(buffer, &boneOffset, sizeof(Matrix3x4));
+        }
+        else
+            memcpy(buffer, instance.worldTransform_, sizeof(Matrix3x4));
         if (instance.instancingData_)
             memcpy(buffer + sizeof(Matrix3x4), instance.instancingData_, stride - sizeof(Matrix3x4));
 
@@ -667,26 +663,36 @@ void BatchGroup::SetInstancingData(void* lockedData, unsigned stride, unsigned&
 
 void BatchGroup::Draw(View* view, Camera* camera, bool allowDepthWrite) const
 {
-    Graphics* graphics = view->GetGraphics();
+    RenderCommandList* commandList = view->GetCommandList();
     Renderer* renderer = view->GetRenderer();
 
     if (instances_.Size() && !geometry_->IsEmpty())
     {
         // Draw as individual objects if instancing not supported or could not fill the instancing buffer
         VertexBuffer* instanceBuffer = renderer->GetInstancingBuffer();
-        if (!instanceBuffer || geometryType_ != GEOM_INSTANCED || startIndex_ == M_MAX_UNSIGNED)
+        if (!instanceBuffer || (geometryType_ != GEOM_INSTANCED && geometryType_ != GEOM_SKINNED_INSTANCED) ||
+            startIndex_ == M_MAX_UNSIGNED)
         {
             Batch::Prepare(view, camera, false, allowDepthWrite);
 
-            graphics->SetIndexBuffer(geometry_->GetIndexBuffer());
-            graphics->SetVertexBuffers(geometry_->GetVertexBuffers());
+            commandList->SetIndexBuffer(geometry_->GetIndexBuffer());
+            commandList->SetVertexBuffers(geometry_->GetVertexBuffers());
 
             for (unsigned i = 0; i < instances_.Size(); ++i)
             {
-                if (graphics->NeedParameterUpdate(SP_OBJECT, instances_[i].worldTransform_))
-                    graphics->SetShaderParameter(VSP_MODEL, *instances_[i].worldTransform_);
+                const InstanceData& instance = instances_[i];
+                if (commandList->NeedParameterUpdate(SP_OBJECT, instance.worldTransform_))
+                {
+                    if (geometryType_ == GEOM_SKINNED || geometryType_ == GEOM_SKINNED_INSTANCED)
+                    {
+                        commandList->SetShaderParameter(VSP_SKINMATRICES, reinterpret_cast<const float*>(instance.worldTransform_),
+                            12 * instance.numWorldTransforms_);
+                    }
+                    else
+                        commandList->SetShaderParameter(VSP_MODEL, *instance.worldTransform_);
+                }
 
-                graphics->Draw(geometry_->GetPrimitiveType(), geometry_->GetIndexStart(), geometry_->GetIndexCount(),
+                commandList->Draw(geometry_->GetPrimitiveType(), geometry_->GetIndexStart(), geometry_->GetIndexCount(),
                     geometry_->GetVertexStart(), geometry_->GetVertexCount());
             }
         }
@@ -700,10 +706,33 @@ void BatchGroup::Draw(View* view, Camera* camera, bool allowDepthWrite) const
                 geometry_->GetVertexBuffers());
             vertexBuffers.Push(SharedPtr<VertexBuffer>(instanceBuffer));
 
-            graphics->SetIndexBuffer(geometry_->GetIndexBuffer());
-            graphics->SetVertexBuffers(vertexBuffers, startIndex_);
-            graphics->DrawInstanced(geometry_->GetPrimitiveType(), geometry_->GetIndexStart(), geometry_->GetIndexCount(),
-                geometry_->GetVertexStart(), geometry_->GetVertexCount(), instances_.Size());
+            commandList->SetIndexBuffer(geometry_->GetIndexBuffer());
+
+            if (geometryType_ == GEOM_SKINNED_INSTANCED)
+            {
+                // Draw as many instances at a time as their skin matrices fit into the shader's bone array
+                unsigned instancesPerDraw = GetSkinnedInstancesPerDraw();
+                for (unsigned i = 0; i < instances_.Size(); i += instancesPerDraw)
+                {
+                    unsigned numInstances = Min(instancesPerDraw, instances_.Size() - i);
+                    const Matrix3x4* skinMatrices = &skinMatrices_[i * numWorldTransforms_];
+                    if (commandList->NeedParameterUpdate(SP_OBJECT, skinMatrices))
+                    {
+                        commandList->SetShaderParameter(VSP_SKINMATRICES, reinterpret_cast<const float*>(skinMatrices),
+                            12 * numInstances * numWorldTransforms_);
+                    }
+
+                    commandList->SetVertexBuffers(vertexBuffers, startIndex_ + i);
+                    commandList->DrawInstanced(geometry_->GetPrimitiveType(), geometry_->GetIndexStart(),
+                        geometry_->GetIndexCount(), geometry_->GetVertexStart(), geometry_->GetVertexCount(), numInstances);
+                }
+            }
+            else
+            {
+                commandList->SetVertexBuffers(vertexBuffers, startIndex_);
+                commandList->DrawInstanced(geometry_->GetPrimitiveType(), geometry_->GetIndexStart(), geometry_->GetIndexCount(),
+                    geometry_->GetVertexStart(), geometry_->GetVertexCount(), instances_.Size());
+            }
 
             // Remove the instancing buffer & element mask now
             vertexBuffers.Pop();
@@ -711,6 +740,11 @@ void BatchGroup::Draw(View* view, Camera* camera, bool allowDepthWrite) const
     }
 }
 
+unsigned BatchGroup::GetSkinnedInstancesPerDraw() const
+{
+    return numWorldTransforms_ ? Max(Graphics::GetMaxBones() / numWorldTransforms_, 1U) : 1;
+}
+
 unsigned BatchGroupKey::ToHash() const
 {
     return (unsigned)((size_t)zone_ / sizeof(Zone) + (size_t)lightQueue_ / sizeof(LightBatchQueue) + (size_t)pass_ / sizeof(Pass) +
@@ -847,17 +881,17 @@ void BatchQueue::SetInstancingData(void* lockedData, unsigned stride, unsigned&
 
 void BatchQueue::Draw(View* view, Camera* camera, bool markToStencil, bool usingLightOptimization, bool allowDepthWrite) const
 {
-    Graphics* graphics = view->GetGraphics();
+    RenderCommandList* commandList = view->GetCommandList();
     Renderer* renderer = view->GetRenderer();
 
     // If View has set up its own light optimizations, do not disturb the stencil/scissor test settings
     if (!usingLightOptimization)
     {
-        graphics->SetScissorTest(false);
+        commandList->SetScissorTest(false);
 
         // During G-buffer rendering, mark opaque pixels' lightmask to stencil buffer if requested
         if (!markToStencil)
-            graphics->SetStencilTest(false);
+            commandList->SetStencilTest(false);
     }
 
     // Instanced
@@ -865,7 +899,7 @@ void BatchQueue::Draw(View* view, Camera* camera, bool markToStencil, bool using
     {
         BatchGroup* group = *i;
         if (markToStencil)
-            graphics->SetStencilTest(true, CMP_ALWAYS, OP_REF, OP_KEEP, OP_KEEP, group->lightMask_);
+            commandList->SetStencilTest(true, CMP_ALWAYS, OP_REF, OP_KEEP, OP_KEEP, group->lightMask_);
 
         group->Draw(view, camera, allowDepthWrite);
     }
@@ -874,14 +908,14 @@ void BatchQueue::Draw(View* view, Camera* camera, bool markToStencil, bool using
     {
         Batch* batch = *i;
         if (markToStencil)
-            graphics->SetStencilTest(true, CMP_ALWAYS, OP_REF, OP_KEEP, OP_KEEP, batch->lightMask_);
+            commandList->SetStencilTest(true, CMP_ALWAYS, OP_REF, OP_KEEP, OP_KEEP, batch->lightMask_);
         if (!usingLightOptimization)
         {
             // If drawing an alpha batch, we can optimize fillrate by scissor test
             if (!batch->isBase_ && batch->lightQueue_)
                 renderer->OptimizeLightByScissor(batch->lightQueue_->light_, camera);
             else
-                graphics->SetScissorTest(false);
+                commandList->SetScissorTest(false);
         }
 
         batch->Draw(view, camera, allowDepthWrite);
@@ -894,7 +928,8 @@ unsigned BatchQueue::GetNumInstances() const
 
     for (HashMap<BatchGroupKey, BatchGroup>::ConstIterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
     {
-        if (i->second_.geometryType_ == GEOM_INSTANCED)
+        GeometryType type = i->second_.geometryType_;
+        if (type == GEOM_INSTANCED || type == GEOM_SKINNED_INSTANCED)
             total += i->second_.instances_.Size();
     }
 
@@ -123,13 +123,16 @@ struct InstanceData
     /// Construct with transform, instancing data and distance.
     InstanceData(const Matrix3x4* worldTransform, const void* instancingData, float distance) :
         worldTransform_(worldTransform),
+        numWorldTransforms_(1),
         instancingData_(instancingData),
         distance_(distance)
     {
     }
 
-    /// World transform.
+    /// World transform. For a skinned instance, these are the bone transforms.
     const Matrix3x4* worldTransform_;
+    /// Number of world transforms.
+    unsigned numWorldTransforms_;
     /// Instancing data buffer.
     const void* instancingData_;
     /// Distance from camera.
@@ -164,6 +167,16 @@ struct BatchGroup : public Batch
         newInstance.distance_ = batch.distance_;
         newInstance.instancingData_ = batch.instancingData_;
 
+        // A skinned batch is one instance which refers to all of its bone transforms
+        if (batch.geometryType_ == GEOM_SKINNED_INSTANCED)
+        {
+            newInstance.worldTransform_ = batch.worldTransform_;
+            newInstance.numWorldTransforms_ = batch.numWorldTransforms_;
+            instances_.Push(newInstance);
+            return;
+        }
+
+        newInstance.numWorldTransforms_ = 1;
         for (unsigned i = 0; i < batch.numWorldTransforms_; ++i)
         {
             newInstance.worldTransform_ = &batch.worldTransform_[i];
@@ -175,9 +188,13 @@ struct BatchGroup : public Batch
     void SetInstancingData(void* lockedData, unsigned stride, unsigned& freeIndex);
     /// Prepare and draw.
     void Draw(View* view, Camera* camera, bool allowDepthWrite) const;
+    /// Return how many skinned instances fit into one draw call.
+    unsigned GetSkinnedInstancesPerDraw() const;
 
     /// Instance data.
     PODVector<InstanceData> instances_;
+    /// Skin matrices of all instances packed back-to-back for skinned instancing.
+    PODVector<Matrix3x4> skinMatrices_;
     /// Instance stream start index, or M_MAX_UNSIGNED if transforms not pre-set.
     unsigned startIndex_;
 };
@@ -273,6 +290,8 @@ public:
     unsigned maxSortedInstances_;
     /// Whether the pass command contains extra shader defines.
     bool hasExtraDefines_;
+    /// Whether the pass command applies clustered lights. Only passes that support them get the CLUSTERED define.
+    bool clustered_;
     /// Vertex shader extra defines.
     String vsExtraDefines_;
     /// Pixel shader extra defines.
@@ -305,6 +324,8 @@ struct LightBatchQueue
     Light* light_;
     /// Light negative flag.
     bool negative_;
+    /// Light binned to clusters flag. Only passes that can not apply clustered lights get lit batches.
+    bool clustered_;
     /// Shadow map depth texture.
     Texture2D* shadowMap_;
     /// Lit geometry draw calls, base (replace blend mode)
@@ -313,10 +334,14 @@ struct LightBatchQueue
     BatchQueue litBatches_;
     /// Shadow map split queues.
     Vector<ShadowBatchQueue> shadowSplits_;
+    /// Bitmask of shadow map splits to clear and render. Lights with static shadows leave out the splits that did not change.
+    unsigned dirtyShadowSplits_;
     /// Per-vertex lights.
     PODVector<Light*> vertexLights_;
     /// Light volume draw calls.
     PODVector<Batch> volumeBatches_;
+    /// Light shader parameters, built on first use. The second block is for spot lights with shaders that do not sample the shadow map.
+    SharedPtr<ShaderParameterBlock> shaderParameters_[2];
 };
 
 }
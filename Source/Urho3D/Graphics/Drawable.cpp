@@ -89,6 +89,7 @@ Drawable::Drawable(Context* context, unsigned char drawableFlags) :
     occluder_(false),
     occludee_(true),
     updateQueued_(false),
+    updatedInOctree_(false),
     zoneDirty_(false),
     octant_(0),
     zone_(0),
@@ -211,6 +212,8 @@ void Drawable::SetLodBias(float bias)
 void Drawable::SetViewMask(unsigned mask)
 {
     viewMask_ = mask;
+    if (octant_)
+        octant_->GetRoot()->MarkStructureChanged();
     MarkNetworkUpdate();
 }
 
@@ -223,6 +226,8 @@ void Drawable::SetLightMask(unsigned mask)
 void Drawable::SetShadowMask(unsigned mask)
 {
     shadowMask_ = mask;
+    if (octant_)
+        octant_->GetRoot()->MarkStructureChanged();
     MarkNetworkUpdate();
 }
 
@@ -243,12 +248,16 @@ void Drawable::SetMaxLights(unsigned num)
 void Drawable::SetCastShadows(bool enable)
 {
     castShadows_ = enable;
+    if (octant_)
+        octant_->GetRoot()->MarkStructureChanged();
     MarkNetworkUpdate();
 }
 
 void Drawable::SetOccluder(bool enable)
 {
     occluder_ = enable;
+    if (octant_)
+        octant_->GetRoot()->MarkStructureChanged();
     MarkNetworkUpdate();
 }
 
@@ -413,7 +422,10 @@ void Drawable::AddToOctree()
     {
         Octree* octree = scene->GetComponent<Octree>();
         if (octree)
+        {
             octree->InsertDrawable(this);
+            octree->MarkStructureChanged();
+        }
         else
             URHO3D_LOGERROR("No Octree component in scene, drawable will not render");
     }
@@ -431,11 +443,15 @@ void Drawable::RemoveFromOctree()
         Octree* octree = octant_->GetRoot();
         if (updateQueued_)
             octree->CancelUpdate(this);
+        // Views that cache their visibility or static shadow casters read the updated drawables, so do not leave a dangling pointer
+        if (updatedInOctree_)
+            octree->RemoveUpdatedDrawable(this);
 
         // Perform subclass specific deinitialization if necessary
         OnRemoveFromOctree();
 
         octant_->RemoveDrawable(this);
+        octree->MarkStructureChanged();
     }
 }
 
@@ -340,6 +340,8 @@ protected:
     bool occludee_;
     /// Octree update queued flag.
     bool updateQueued_;
+    /// In the octree's list of drawables updated on its last update flag.
+    bool updatedInOctree_;
     /// Zone inconclusive or dirtied flag.
     bool zoneDirty_;
     /// Octree octant.
@@ -89,6 +89,9 @@ extern URHO3D_API const StringHash PSP_LIGHTRAD("LightRad");
 extern URHO3D_API const StringHash PSP_LIGHTLENGTH("LightLength");
 extern URHO3D_API const StringHash PSP_ZONEMIN("ZoneMin");
 extern URHO3D_API const StringHash PSP_ZONEMAX("ZoneMax");
+extern URHO3D_API const StringHash PSP_CLUSTERPARAMS("ClusterParams");
+extern URHO3D_API const StringHash PSP_CLUSTERDEPTHPARAMS("ClusterDepthParams");
+extern URHO3D_API const StringHash PSP_CLUSTERINVTEXSIZE("ClusterInvTexSize");
 
 extern URHO3D_API const Vector3 DOT_SCALE(1 / 3.0f, 1 / 3.0f, 1 / 3.0f);
 
@@ -58,9 +58,10 @@ enum GeometryType
     GEOM_DIRBILLBOARD = 4,
     GEOM_TRAIL_FACE_CAMERA = 5,
     GEOM_TRAIL_BONE = 6,
-    MAX_GEOMETRYTYPES = 7,
+    GEOM_SKINNED_INSTANCED = 7,
+    MAX_GEOMETRYTYPES = 8,
     // This is not a real geometry type for VS, but used to mark objects that do not desire to be instanced
-    GEOM_STATIC_NOINSTANCING = 7,
+    GEOM_STATIC_NOINSTANCING = 8,
 };
 
 /// Blending mode.
@@ -426,6 +427,9 @@ extern URHO3D_API const StringHash PSP_LIGHTRAD;
 extern URHO3D_API const StringHash PSP_LIGHTLENGTH;
 extern URHO3D_API const StringHash PSP_ZONEMIN;
 extern URHO3D_API const StringHash PSP_ZONEMAX;
+extern URHO3D_API const StringHash PSP_CLUSTERPARAMS;
+extern URHO3D_API const StringHash PSP_CLUSTERDEPTHPARAMS;
+extern URHO3D_API const StringHash PSP_CLUSTERINVTEXSIZE;
 
 // Scale calculation from bounding box diagonal.
 extern URHO3D_API const Vector3 DOT_SCALE;
@@ -89,6 +89,16 @@ void FocusParameters::Validate()
     minView_ = Max(minView_, SHADOW_MIN_VIEW);
 }
 
+void StaticShadowCache::Reset()
+{
+    shadowMap_.Reset();
+    octree_.Reset();
+    shadowCasters_.Clear();
+    shadowCasterSet_.Clear();
+    numSplits_ = 0;
+    dirtySplits_ = M_MAX_UNSIGNED;
+}
+
 Light::Light(Context* context) :
     Drawable(context, DRAWABLE_LIGHT),
     lightType_(DEFAULT_LIGHTTYPE),
@@ -111,7 +121,8 @@ Light::Light(Context* context) :
     shadowNearFarRatio_(DEFAULT_SHADOWNEARFARRATIO),
     shadowMaxExtrusion_(DEFAULT_SHADOWMAXEXTRUSION),
     perVertex_(false),
-    usePhysicalValues_(false)
+    usePhysicalValues_(false),
+    staticShadows_(false)
 {
 }
 
@@ -149,6 +160,7 @@ void Light::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Shadow Fade Distance", GetShadowFadeDistance, SetShadowFadeDistance, float, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Shadow Intensity", GetShadowIntensity, SetShadowIntensity, float, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Shadow Resolution", GetShadowResolution, SetShadowResolution, float, 1.0f, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Static Shadows", GetStaticShadows, SetStaticShadows, bool, false, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Focus To Scene", bool, shadowFocus_.focus_, true, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Non-uniform View", bool, shadowFocus_.nonUniform_, true, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Auto-Reduce Size", bool, shadowFocus_.autoSize_, true, AM_DEFAULT);
@@ -373,6 +385,20 @@ void Light::SetShadowMaxExtrusion(float extrusion)
     MarkNetworkUpdate();
 }
 
+void Light::SetStaticShadows(bool enable)
+{
+    staticShadows_ = enable;
+    // Release the persistent shadow map when no longer needed
+    if (!enable)
+        staticShadowCache_.Reset();
+    MarkNetworkUpdate();
+}
+
+void Light::MarkStaticShadowsDirty()
+{
+    staticShadowCache_.dirtySplits_ = M_MAX_UNSIGNED;
+}
+
 void Light::SetFadeDistance(float distance)
 {
     fadeDistance_ = Max(distance, 0.0f);
@@ -22,15 +22,17 @@
 
 #pragma once
 
+#include "../Container/HashSet.h"
 #include "../Math/Color.h"
 #include "../Graphics/Drawable.h"
 #include "../Math/Frustum.h"
-#include "../Graphics/Texture.h"
+#include "../Graphics/Texture2D.h"
 
 namespace Urho3D
 {
 
 class Camera;
+class Octree;
 struct LightBatchQueue;
 
 /// %Light types.
@@ -150,6 +152,65 @@ struct URHO3D_API FocusParameters
     float minView_;
 };
 
+/// Shadow map and shadow casters kept between frames for a point or spot light with static shadows.
+struct URHO3D_API StaticShadowCache
+{
+    /// Construct.
+    StaticShadowCache() :
+        shadowMapVersion_(0),
+        structureVersion_(0),
+        updateVersion_(0),
+        lightMask_(0),
+        viewMask_(0),
+        shadowBias_(0.0f, 0.0f),
+        numSplits_(0),
+        dirtySplits_(M_MAX_UNSIGNED)
+    {
+    }
+
+    /// Release the shadow map and forget the shadow casters.
+    void Reset();
+
+    /// Persistent shadow map.
+    SharedPtr<Texture2D> shadowMap_;
+    /// Renderer shadow map version the shadow map was created for.
+    unsigned shadowMapVersion_;
+    /// Octree the shadow casters were collected from.
+    WeakPtr<Octree> octree_;
+    /// Octree structure version at the time the shadow casters were collected.
+    unsigned structureVersion_;
+    /// Octree update version at the time the shadow casters were checked.
+    unsigned updateVersion_;
+    /// Light mask the shadow casters were collected with.
+    unsigned lightMask_;
+    /// View mask the shadow casters were collected with.
+    unsigned viewMask_;
+    /// Shadow camera view matrices the shadow casters were collected with.
+    Matrix3x4 shadowViews_[MAX_LIGHT_SPLITS];
+    /// Shadow camera projection matrices before finalization.
+    Matrix4 shadowProjections_[MAX_LIGHT_SPLITS];
+    /// Shadow camera zoom after finalization, used to detect focus changes.
+    float shadowZooms_[MAX_LIGHT_SPLITS];
+    /// Shadow split viewports in the shadow map.
+    IntRect shadowViewports_[MAX_LIGHT_SPLITS];
+    /// Depth bias the shadow map was rendered with.
+    BiasParameters shadowBias_;
+    /// Shadow casters of all splits.
+    PODVector<Drawable*> shadowCasters_;
+    /// Shadow casters of all splits for fast lookup of moved drawables.
+    HashSet<Drawable*> shadowCasterSet_;
+    /// Shadow caster start indices.
+    unsigned shadowCasterBegin_[MAX_LIGHT_SPLITS];
+    /// Shadow caster end indices.
+    unsigned shadowCasterEnd_[MAX_LIGHT_SPLITS];
+    /// Combined bounding box of shadow casters in light projection space. Only used for focused spot lights.
+    BoundingBox shadowCasterBox_[MAX_LIGHT_SPLITS];
+    /// Shadow split count.
+    unsigned numSplits_;
+    /// Bitmask of splits that need to be cleared and rendered again.
+    unsigned dirtySplits_;
+};
+
 /// %Light component.
 class URHO3D_API Light : public Drawable
 {
@@ -218,6 +279,10 @@ public:
     void SetRampTexture(Texture* texture);
     /// Set spotlight attenuation texture.
     void SetShapeTexture(Texture* texture);
+    /// Set static shadows for a point or spot light. When enabled, the shadow map and its shadow casters are kept between frames and only the shadow map splits whose casters changed are rendered again.
+    void SetStaticShadows(bool enable);
+    /// Force the static shadow map to be rendered again, for example after changing the materials of the shadow casters.
+    void MarkStaticShadowsDirty();
 
     /// Return light type.
     LightType GetLightType() const { return lightType_; }
@@ -297,6 +362,9 @@ public:
     /// Return spotlight attenuation texture.
     Texture* GetShapeTexture() const { return shapeTexture_; }
 
+    /// Return whether static shadows are enabled.
+    bool GetStaticShadows() const { return staticShadows_; }
+
     /// Return spotlight frustum.
     Frustum GetFrustum() const;
     /// Return spotlight frustum in the specified view space.
@@ -320,6 +388,9 @@ public:
     /// Return light queue. Called by View.
     LightBatchQueue* GetLightQueue() const { return lightQueue_; }
 
+    /// Return static shadow map cache. Called by View and Renderer.
+    StaticShadowCache& GetStaticShadowCache() { return staticShadowCache_; }
+
     /// Return a divisor value based on intensity for calculating the sort value.
     float GetIntensityDivisor(float attenuation = 1.0f) const
     {
@@ -367,6 +438,8 @@ private:
     SharedPtr<Texture> shapeTexture_;
     /// Light queue.
     LightBatchQueue* lightQueue_;
+    /// Static shadow map cache.
+    StaticShadowCache staticShadowCache_;
     /// Specular intensity.
     float specularIntensity_;
     /// Brightness multiplier.
@@ -393,6 +466,8 @@ private:
     bool perVertex_;
     /// Use physical light values flag.
     bool usePhysicalValues_;
+    /// Static shadows flag.
+    bool staticShadows_;
 };
 
 inline bool CompareLights(Light* lhs, Light* rhs)
@@ -0,0 +1,472 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
+#include "../Graphics/Camera.h"
+#include "../Graphics/Graphics.h"
+#include "../Graphics/Light.h"
+#include "../Graphics/LightClusters.h"
+#include "../Graphics/Texture2D.h"
+#include "../Scene/Node.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const IntVector3 DEFAULT_GRID_SIZE(16, 9, 24);
+static const unsigned DEFAULT_MAX_CLUSTER_LIGHTS = 32;
+static const unsigned MAX_CLUSTER_LIGHTS = 64;
+static const int CLUSTER_TEXTURE_WIDTH = 1024;
+static const int LIGHT_TEXTURE_WIDTH = 3;
+static const float POINT_LIGHT_CUTOFF = -2.0f;
+
+void BinLightClustersWork(const WorkItem* item, unsigned threadIndex)
+{
+    LightClusters* clusters = reinterpret_cast<LightClusters*>(item->aux_);
+    int startSlice = (int)(size_t)item->start_;
+    int endSlice = (int)(size_t)item->end_;
+    clusters->BinSlices(startSlice, endSlice);
+}
+
+LightClusters::LightClusters(Context* context) :
+    Object(context),
+    gridSize_(DEFAULT_GRID_SIZE),
+    maxClusterLights_(DEFAULT_MAX_CLUSTER_LIGHTS),
+    nearClip_(0.0f),
+    farClip_(0.0f),
+    depthScale_(0.0f),
+    orthographic_(false),
+    flipVertical_(false),
+    texturesDirty_(false)
+{
+}
+
+LightClusters::~LightClusters()
+{
+}
+
+void LightClusters::SetGridSize(const IntVector3& size)
+{
+    gridSize_ = IntVector3(Max(size.x_, 1), Max(size.y_, 1), Max(size.z_, 1));
+    clusterRanges_.Clear();
+    lightIndices_.Clear();
+}
+
+void LightClusters::SetMaxClusterLights(unsigned num)
+{
+    maxClusterLights_ = Clamp(num, 1U, MAX_CLUSTER_LIGHTS);
+}
+
+void LightClusters::Update(Camera* camera, const PODVector<Light*>& lights)
+{
+    URHO3D_PROFILE(BinLightClusters);
+
+    lights_.Clear();
+    lightBounds_.Clear();
+    lightIndices_.Clear();
+    texturesDirty_ = true;
+
+    unsigned numClusters = GetNumClusters();
+    clusterRanges_.Resize(numClusters * 2);
+    for (unsigned i = 0; i < clusterRanges_.Size(); ++i)
+        clusterRanges_[i] = 0;
+
+    if (!camera)
+        return;
+
+    projection_ = camera->GetProjection();
+    nearClip_ = camera->GetNearClip();
+    farClip_ = camera->GetFarClip();
+    orthographic_ = camera->IsOrthographic();
+    flipVertical_ = camera->GetFlipVertical();
+    if (orthographic_)
+        depthScale_ = (float)gridSize_.z_ / Max(farClip_ - nearClip_, M_EPSILON);
+    else
+        depthScale_ = (float)gridSize_.z_ / logf(Max(farClip_ / nearClip_, 1.0f + M_EPSILON));
+
+    clusterParams_ = Vector4((float)gridSize_.x_, (float)gridSize_.y_, (float)gridSize_.z_, (float)CLUSTER_TEXTURE_WIDTH);
+    depthParams_ = Vector4(nearClip_, depthScale_, orthographic_ ? 1.0f : 0.0f, 1.0f);
+
+    const Matrix3x4& view = camera->GetView();
+    for (PODVector<Light*>::ConstIterator i = lights.Begin(); i != lights.End(); ++i)
+    {
+        Light* light = *i;
+        if (!light || light->GetLightType() == LIGHT_DIRECTIONAL || !light->GetNode())
+            continue;
+
+        LightClusterBounds bounds;
+        Node* lightNode = light->GetNode();
+        float range = light->GetRange();
+        if (light->GetLightType() == LIGHT_SPOT)
+        {
+            // Use the bounding sphere of the spot cone
+            float halfAngle = light->GetFov() * 0.5f;
+            float cosAngle = Cos(halfAngle);
+            Vector3 direction = lightNode->GetWorldDirection();
+            if (halfAngle > 45.0f)
+            {
+                bounds.sphere_ = Sphere(lightNode->GetWorldPosition() + direction * range * cosAngle, range * Sin(halfAngle));
+            }
+            else
+            {
+                float radius = range / (2.0f * cosAngle);
+                bounds.sphere_ = Sphere(lightNode->GetWorldPosition() + direction * radius, radius);
+            }
+        }
+        else
+            bounds.sphere_ = Sphere(lightNode->GetWorldPosition(), range);
+
+        bounds.sphere_.center_ = view * bounds.sphere_.center_;
+        if (!CalculateLightBounds(bounds))
+            continue;
+
+        lights_.Push(light);
+        lightBounds_.Push(bounds);
+    }
+
+    if (lights_.Empty())
+        return;
+
+    slices_.Resize((unsigned)gridSize_.z_);
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    int numWorkItems = Min((int)queue->GetNumThreads() + 1, gridSize_.z_); // Worker threads + main thread
+    int slicesPerItem = gridSize_.z_ / numWorkItems;
+
+    for (int i = 0; i < numWorkItems; ++i)
+    {
+        int start = i * slicesPerItem;
+        int end = i < numWorkItems - 1 ? start + slicesPerItem : gridSize_.z_;
+
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = BinLightClustersWork;
+        item->aux_ = this;
+        item->start_ = (void*)(size_t)start;
+        item->end_ = (void*)(size_t)end;
+        queue->AddWorkItem(item);
+    }
+
+    queue->Complete(M_MAX_UNSIGNED);
+
+    // Merge the per-slice light index lists, offsetting the cluster ranges to index the combined list
+    unsigned clustersPerSlice = (unsigned)(gridSize_.x_ * gridSize_.y_);
+    for (unsigned z = 0; z < slices_.Size(); ++z)
+    {
+        unsigned offset = lightIndices_.Size();
+        unsigned* ranges = &clusterRanges_[z * clustersPerSlice * 2];
+        for (unsigned i = 0; i < clustersPerSlice; ++i)
+            ranges[i * 2] += offset;
+
+        const PODVector<unsigned>& sliceIndices = slices_[z].lightIndices_;
+        if (!sliceIndices.Empty())
+            lightIndices_.Insert(lightIndices_.End(), sliceIndices.Begin(), sliceIndices.End());
+    }
+}
+
+void LightClusters::UpdateTextures()
+{
+    if (!texturesDirty_)
+        return;
+
+    texturesDirty_ = false;
+
+    URHO3D_PROFILE(UpdateLightClusterTextures);
+
+    unsigned numClusters = GetNumClusters();
+    unsigned numTexels = numClusters + lightIndices_.Size();
+    int clusterHeight = (int)((numTexels + CLUSTER_TEXTURE_WIDTH - 1) / CLUSTER_TEXTURE_WIDTH);
+
+    if (!clusterTexture_)
+    {
+        clusterTexture_ = new Texture2D(context_);
+        clusterTexture_->SetNumLevels(1);
+        clusterTexture_->SetFilterMode(FILTER_NEAREST);
+        clusterTexture_->SetAddressMode(COORD_U, ADDRESS_CLAMP);
+        clusterTexture_->SetAddressMode(COORD_V, ADDRESS_CLAMP);
+    }
+    // Grow the textures in power of two steps to avoid reallocating them each frame
+    if (clusterTexture_->GetHeight() < clusterHeight)
+        clusterTexture_->SetSize(CLUSTER_TEXTURE_WIDTH, NextPowerOfTwo((unsigned)clusterHeight), Graphics::GetRGFloat32Format(),
+            TEXTURE_DYNAMIC);
+
+    // Cluster texels contain the start texel and count of the cluster's light indices, light index texels the light index
+    clusterData_.Resize((unsigned)(clusterHeight * CLUSTER_TEXTURE_WIDTH * 2));
+    float* dest = &clusterData_[0];
+    for (unsigned i = 0; i < numClusters; ++i)
+    {
+        *dest++ = (float)(clusterRanges_[i * 2] + numClusters);
+        *dest++ = (float)clusterRanges_[i * 2 + 1];
+    }
+    for (unsigned i = 0; i < lightIndices_.Size(); ++i)
+    {
+        *dest++ = (float)lightIndices_[i];
+        *dest++ = 0.0f;
+    }
+    for (float* end = &clusterData_[0] + clusterData_.Size(); dest < end;)
+        *dest++ = 0.0f;
+
+    clusterTexture_->SetData(0, 0, 0, CLUSTER_TEXTURE_WIDTH, clusterHeight, &clusterData_[0]);
+
+    int lightHeight = Max((int)lights_.Size(), 1);
+    if (!lightTexture_)
+    {
+        lightTexture_ = new Texture2D(context_);
+        lightTexture_->SetNumLevels(1);
+        lightTexture_->SetFilterMode(FILTER_NEAREST);
+        lightTexture_->SetAddressMode(COORD_U, ADDRESS_CLAMP);
+        lightTexture_->SetAddressMode(COORD_V, ADDRESS_CLAMP);
+    }
+    if (lightTexture_->GetHeight() < lightHeight)
+        lightTexture_->SetSize(LIGHT_TEXTURE_WIDTH, NextPowerOfTwo((unsigned)lightHeight), Graphics::GetRGBAFloat32Format(),
+            TEXTURE_DYNAMIC);
+
+    // Each light uses one row: position & inverse range, color & specular intensity, negated direction & spot cutoff.
+    // Point lights use a cutoff below -1 to skip the spot attenuation
+    lightData_.Resize((unsigned)(lightHeight * LIGHT_TEXTURE_WIDTH * 4));
+    dest = &lightData_[0];
+    for (unsigned i = 0; i < lights_.Size(); ++i)
+    {
+        Light* light = lights_[i];
+        Node* lightNode = light->GetNode();
+
+        float fade = 1.0f;
+        float fadeEnd = light->GetDrawDistance();
+        float fadeStart = light->GetFadeDistance();
+
+        // Do fade calculation for light if both fade & draw distance defined
+        if (fadeEnd > 0.0f && fadeStart > 0.0f && fadeStart < fadeEnd)
+            fade = Min(1.0f - (light->GetDistance() - fadeStart) / (fadeEnd - fadeStart), 1.0f);
+
+        Vector3 position = lightNode->GetWorldPosition();
+        Color color = light->GetEffectiveColor() * fade;
+        Vector3 direction = -lightNode->GetWorldDirection();
+        float cutoff = light->GetLightType() == LIGHT_SPOT ? Cos(light->GetFov() * 0.5f) : POINT_LIGHT_CUTOFF;
+
+        *dest++ = position.x_;
+        *dest++ = position.y_;
+        *dest++ = position.z_;
+        *dest++ = 1.0f / Max(light->GetRange(), M_EPSILON);
+        *dest++ = color.r_;
+        *dest++ = color.g_;
+        *dest++ = color.b_;
+        *dest++ = light->GetEffectiveSpecularIntensity() * fade;
+        *dest++ = direction.x_;
+        *dest++ = direction.y_;
+        *dest++ = direction.z_;
+        *dest++ = cutoff;
+    }
+    for (float* end = &lightData_[0] + lightData_.Size(); dest < end;)
+        *dest++ = 0.0f;
+
+    lightTexture_->SetData(0, 0, 0, LIGHT_TEXTURE_WIDTH, lightHeight, &lightData_[0]);
+
+    invTextureSize_ = Vector4(1.0f / (float)CLUSTER_TEXTURE_WIDTH, 1.0f / (float)Max(clusterTexture_->GetHeight(), 1),
+        1.0f / (float)LIGHT_TEXTURE_WIDTH, 1.0f / (float)Max(lightTexture_->GetHeight(), 1));
+}
+
+unsigned LightClusters::GetClusterIndex(const Vector3& viewPosition) const
+{
+    if (clusterRanges_.Empty() || viewPosition.z_ < nearClip_ || viewPosition.z_ > farClip_)
+        return M_MAX_UNSIGNED;
+
+    Vector4 clipPosition = projection_ * Vector4(viewPosition, 1.0f);
+    if (clipPosition.w_ <= 0.0f)
+        return M_MAX_UNSIGNED;
+
+    int x = GetGridCoordinate(clipPosition.x_ / clipPosition.w_, gridSize_.x_);
+    int y = GetGridCoordinate(clipPosition.y_ / clipPosition.w_, gridSize_.y_);
+    int z = Min((int)GetSlice(viewPosition.z_), gridSize_.z_ - 1);
+    if (x < 0 || y < 0 || z < 0 || x >= gridSize_.x_ || y >= gridSize_.y_)
+        return M_MAX_UNSIGNED;
+
+    return (unsigned)((z * gridSize_.y_ + y) * gridSize_.x_ + x);
+}
+
+unsigned LightClusters::GetClusterNumLights(unsigned index) const
+{
+    return index * 2 + 1 < clusterRanges_.Size() ? clusterRanges_[index * 2 + 1] : 0;
+}
+
+void LightClusters::GetClusterLights(PODVector<Light*>& dest, unsigned index) const
+{
+    dest.Clear();
+    if (index * 2 + 1 >= clusterRanges_.Size())
+        return;
+
+    unsigned start = clusterRanges_[index * 2];
+    unsigned count = clusterRanges_[index * 2 + 1];
+    for (unsigned i = start; i < start + count; ++i)
+        dest.Push(lights_[lightIndices_[i]]);
+}
+
+bool LightClusters::CalculateLightBounds(LightClusterBounds& bounds) const
+{
+    const Vector3& center = bounds.sphere_.center_;
+    float radius = bounds.sphere_.radius_;
+    float minZ = center.z_ - radius;
+    float maxZ = center.z_ + radius;
+    if (maxZ < nearClip_ || minZ > farClip_)
+        return false;
+
+    bounds.min_.z_ = Clamp((int)GetSlice(Max(minZ, nearClip_)), 0, gridSize_.z_ - 1);
+    bounds.max_.z_ = Clamp((int)GetSlice(Min(maxZ, farClip_)), 0, gridSize_.z_ - 1);
+
+    // Crossing the camera plane in a perspective view, the light may cover any part of the screen
+    if (!orthographic_ && minZ <= M_EPSILON)
+    {
+        bounds.min_.x_ = 0;
+        bounds.min_.y_ = 0;
+        bounds.max_.x_ = gridSize_.x_ - 1;
+        bounds.max_.y_ = gridSize_.y_ - 1;
+        return true;
+    }
+
+    // Project the corners of the sphere's bounding box to get its screen extents
+    Vector2 minNdc(M_INFINITY, M_INFINITY);
+    Vector2 maxNdc(-M_INFINITY, -M_INFINITY);
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        Vector3 corner(i & 1 ? center.x_ + radius : center.x_ - radius, i & 2 ? center.y_ + radius : center.y_ - radius,
+            i & 4 ? maxZ : minZ);
+        Vector4 clipPosition = projection_ * Vector4(corner, 1.0f);
+        Vector2 ndc(clipPosition.x_ / clipPosition.w_, clipPosition.y_ / clipPosition.w_);
+        minNdc.x_ = Min(minNdc.x_, ndc.x_);
+        minNdc.y_ = Min(minNdc.y_, ndc.y_);
+        maxNdc.x_ = Max(maxNdc.x_, ndc.x_);
+        maxNdc.y_ = Max(maxNdc.y_, ndc.y_);
+    }
+
+    bounds.min_.x_ = GetGridCoordinate(minNdc.x_, gridSize_.x_);
+    bounds.min_.y_ = GetGridCoordinate(minNdc.y_, gridSize_.y_);
+    bounds.max_.x_ = GetGridCoordinate(maxNdc.x_, gridSize_.x_);
+    bounds.max_.y_ = GetGridCoordinate(maxNdc.y_, gridSize_.y_);
+    if (bounds.max_.x_ < 0 || bounds.max_.y_ < 0 || bounds.min_.x_ >= gridSize_.x_ || bounds.min_.y_ >= gridSize_.y_)
+        return false;
+
+    bounds.min_.x_ = Max(bounds.min_.x_, 0);
+    bounds.min_.y_ = Max(bounds.min_.y_, 0);
+    bounds.max_.x_ = Min(bounds.max_.x_, gridSize_.x_ - 1);
+    bounds.max_.y_ = Min(bounds.max_.y_, gridSize_.y_ - 1);
+    return true;
+}
+
+float LightClusters::GetSlice(float depth) const
+{
+    if (orthographic_)
+        return (depth - nearClip_) * depthScale_;
+    else
+        return logf(Max(depth, nearClip_) / nearClip_) * depthScale_;
+}
+
+float LightClusters::GetSliceDepth(int slice) const
+{
+    if (orthographic_)
+        return nearClip_ + (float)slice / depthScale_;
+    else
+        return nearClip_ * expf((float)slice / depthScale_);
+}
+
+float LightClusters::GetViewCoordinate(float ndc, float depth, unsigned row) const
+{
+    const float* m = projection_.Data() + row * 4;
+    float w = orthographic_ ? 1.0f : depth;
+    return (ndc * w - m[2] * depth - m[3]) / m[row];
+}
+
+void LightClusters::BinSlices(int startSlice, int endSlice)
+{
+    unsigned clustersPerSlice = (unsigned)(gridSize_.x_ * gridSize_.y_);
+
+    for (int z = startSlice; z < endSlice; ++z)
+    {
+        LightClusterSlice& slice = slices_[z];
+        slice.lightIndices_.Clear();
+        slice.sliceLights_.Clear();
+
+        for (unsigned i = 0; i < lightBounds_.Size(); ++i)
+        {
+            if (lightBounds_[i].min_.z_ <= z && lightBounds_[i].max_.z_ >= z)
+                slice.sliceLights_.Push(i);
+        }
+
+        unsigned* ranges = &clusterRanges_[z * clustersPerSlice * 2];
+        if (slice.sliceLights_.Empty())
+        {
+            for (unsigned i = 0; i < clustersPerSlice; ++i)
+            {
+                ranges[i * 2] = 0;
+                ranges[i * 2 + 1] = 0;
+            }
+            continue;
+        }
+
+        float nearDepth = GetSliceDepth(z);
+        float farDepth = z < gridSize_.z_ - 1 ? GetSliceDepth(z + 1) : farClip_;
+
+        for (int y = 0; y < gridSize_.y_; ++y)
+        {
+            float bottomNdc = (float)y / (float)gridSize_.y_ * 2.0f - 1.0f;
+            float topNdc = (float)(y + 1) / (float)gridSize_.y_ * 2.0f - 1.0f;
+
+            for (int x = 0; x < gridSize_.x_; ++x)
+            {
+                float leftNdc = (float)x / (float)gridSize_.x_ * 2.0f - 1.0f;
+                float rightNdc = (float)(x + 1) / (float)gridSize_.x_ * 2.0f - 1.0f;
+
+                // View-space bounding box of the cluster
+                BoundingBox box;
+                box.Merge(Vector3(GetViewCoordinate(leftNdc, nearDepth, 0), GetViewCoordinate(bottomNdc, nearDepth, 1), nearDepth));
+                box.Merge(Vector3(GetViewCoordinate(rightNdc, nearDepth, 0), GetViewCoordinate(topNdc, nearDepth, 1), nearDepth));
+                box.Merge(Vector3(GetViewCoordinate(leftNdc, farDepth, 0), GetViewCoordinate(bottomNdc, farDepth, 1), farDepth));
+                box.Merge(Vector3(GetViewCoordinate(rightNdc, farDepth, 0), GetViewCoordinate(topNdc, farDepth, 1), farDepth));
+
+                unsigned clusterIndex = (unsigned)(y * gridSize_.x_ + x);
+                unsigned start = slice.lightIndices_.Size();
+                unsigned count = 0;
+
+                for (unsigned i = 0; i < slice.sliceLights_.Size() && count < maxClusterLights_; ++i)
+                {
+                    unsigned lightIndex = slice.sliceLights_[i];
+                    const LightClusterBounds& bounds = lightBounds_[lightIndex];
+                    if (x < bounds.min_.x_ || x > bounds.max_.x_ || y < bounds.min_.y_ || y > bounds.max_.y_)
+                        continue;
+                    if (bounds.sphere_.IsInsideFast(box) == OUTSIDE)
+                        continue;
+
+                    slice.lightIndices_.Push(lightIndex);
+                    ++count;
+                }
+
+                ranges[clusterIndex * 2] = start;
+                ranges[clusterIndex * 2 + 1] = count;
+            }
+        }
+    }
+}
+
+}
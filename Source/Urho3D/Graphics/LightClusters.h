@@ -0,0 +1,179 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Core/Object.h"
+#include "../Math/BoundingBox.h"
+#include "../Math/Matrix4.h"
+#include "../Math/Sphere.h"
+#include "../Math/Vector4.h"
+
+namespace Urho3D
+{
+
+class Camera;
+class Light;
+class Texture2D;
+struct WorkItem;
+
+/// Light bounds in cluster grid space.
+struct LightClusterBounds
+{
+    /// View-space bounding sphere.
+    Sphere sphere_;
+    /// Minimum cluster coordinates.
+    IntVector3 min_;
+    /// Maximum cluster coordinates.
+    IntVector3 max_;
+};
+
+/// Light index lists of a range of depth slices, built by one work item.
+struct LightClusterSlice
+{
+    /// Light indices of the slice's clusters, in cluster order.
+    PODVector<unsigned> lightIndices_;
+    /// Lights overlapping the slice.
+    PODVector<unsigned> sliceLights_;
+};
+
+/// Lights binned into a 3D grid of clusters in a camera's view frustum, for shading many lights in one pass. The grid is divided evenly on the screen and logarithmically in depth.
+class URHO3D_API LightClusters : public Object
+{
+    URHO3D_OBJECT(LightClusters, Object);
+
+    friend void BinLightClustersWork(const WorkItem* item, unsigned threadIndex);
+
+public:
+    /// Construct.
+    LightClusters(Context* context);
+    /// Destruct.
+    virtual ~LightClusters();
+
+    /// Set number of clusters along screen X and Y and depth.
+    void SetGridSize(const IntVector3& size);
+    /// Set maximum number of lights per cluster. Lights beyond the limit are dropped from the cluster. This can be between 1-64.
+    void SetMaxClusterLights(unsigned num);
+    /// Bin lights to the clusters of the camera's view. Point and spot lights are binned, other lights are skipped. Uses worker threads if available.
+    void Update(Camera* camera, const PODVector<Light*>& lights);
+    /// Upload the cluster and light data to the textures read by shaders. Must be called from the main thread.
+    void UpdateTextures();
+
+    /// Return number of clusters along screen X and Y and depth.
+    const IntVector3& GetGridSize() const { return gridSize_; }
+
+    /// Return maximum number of lights per cluster.
+    unsigned GetMaxClusterLights() const { return maxClusterLights_; }
+
+    /// Return total number of clusters.
+    unsigned GetNumClusters() const { return (unsigned)(gridSize_.x_ * gridSize_.y_ * gridSize_.z_); }
+
+    /// Return binned lights.
+    const PODVector<Light*>& GetLights() const { return lights_; }
+
+    /// Return total number of light indices in all clusters.
+    unsigned GetNumLightIndices() const { return lightIndices_.Size(); }
+
+    /// Return index of the cluster containing a view-space position, or M_MAX_UNSIGNED if outside the grid.
+    unsigned GetClusterIndex(const Vector3& viewPosition) const;
+    /// Return number of lights in a cluster.
+    unsigned GetClusterNumLights(unsigned index) const;
+    /// Return lights of a cluster.
+    void GetClusterLights(PODVector<Light*>& dest, unsigned index) const;
+
+    /// Return texture with the light index ranges of the clusters, followed by the light indices.
+    Texture2D* GetClusterTexture() const { return clusterTexture_; }
+
+    /// Return texture with the position, color and spot parameters of the lights.
+    Texture2D* GetLightTexture() const { return lightTexture_; }
+
+    /// Return grid size and cluster texture width shader parameter.
+    const Vector4& GetClusterParams() const { return clusterParams_; }
+
+    /// Return depth slicing shader parameter.
+    const Vector4& GetDepthParams() const { return depthParams_; }
+
+    /// Return inverse texture sizes shader parameter.
+    const Vector4& GetInvTextureSize() const { return invTextureSize_; }
+
+    /// Return whether the camera projection was flipped vertically when binning.
+    bool GetFlipVertical() const { return flipVertical_; }
+
+private:
+    /// Calculate the bounds of a light in the cluster grid. Return false if outside the grid.
+    bool CalculateLightBounds(LightClusterBounds& bounds) const;
+    /// Return the depth slice of a view-space depth, not clamped to the grid.
+    float GetSlice(float depth) const;
+    /// Return the view-space depth at the start of a depth slice.
+    float GetSliceDepth(int slice) const;
+    /// Return the view-space X (row 0) or Y (row 1) coordinate of a normalized device coordinate at a view-space depth.
+    float GetViewCoordinate(float ndc, float depth, unsigned row) const;
+    /// Return the cluster grid coordinate of a normalized device coordinate, not clamped to the grid.
+    int GetGridCoordinate(float ndc, int size) const { return (int)floorf((ndc * 0.5f + 0.5f) * size); }
+    /// Bin the lights of depth slices to their clusters.
+    void BinSlices(int startSlice, int endSlice);
+
+    /// Cluster texture.
+    SharedPtr<Texture2D> clusterTexture_;
+    /// Light data texture.
+    SharedPtr<Texture2D> lightTexture_;
+    /// Binned lights.
+    PODVector<Light*> lights_;
+    /// Light bounds.
+    PODVector<LightClusterBounds> lightBounds_;
+    /// Per depth slice binning results.
+    Vector<LightClusterSlice> slices_;
+    /// Light index range start and count of each cluster.
+    PODVector<unsigned> clusterRanges_;
+    /// Light indices of all clusters.
+    PODVector<unsigned> lightIndices_;
+    /// Cluster texture data.
+    PODVector<float> clusterData_;
+    /// Light texture data.
+    PODVector<float> lightData_;
+    /// Camera projection.
+    Matrix4 projection_;
+    /// Grid size and cluster texture width shader parameter.
+    Vector4 clusterParams_;
+    /// Depth slicing shader parameter.
+    Vector4 depthParams_;
+    /// Inverse texture sizes shader parameter.
+    Vector4 invTextureSize_;
+    /// Number of clusters along screen X and Y and depth.
+    IntVector3 gridSize_;
+    /// Maximum number of lights per cluster.
+    unsigned maxClusterLights_;
+    /// Camera near clip distance.
+    float nearClip_;
+    /// Camera far clip distance.
+    float farClip_;
+    /// Scale from view-space depth to depth slice.
+    float depthScale_;
+    /// Orthographic camera flag.
+    bool orthographic_;
+    /// Camera vertical flip flag.
+    bool flipVertical_;
+    /// Texture data dirty flag.
+    bool texturesDirty_;
+};
+
+}
@@ -1173,6 +1173,8 @@ SharedPtr<Material> Material::Clone(const String& cloneName) const
     ret->pixelShaderDefines_ = pixelShaderDefines_;
     ret->shaderParameters_ = shaderParameters_;
     ret->shaderParameterHash_ = shaderParameterHash_;
+    // The block is immutable, so it can be shared until either material changes its parameters
+    ret->shaderParameterBlock_ = shaderParameterBlock_;
     ret->textures_ = textures_;
     ret->depthBias_ = depthBias_;
     ret->alphaToCoverage_ = alphaToCoverage_;
@@ -1249,6 +1251,19 @@ Scene* Material::GetScene() const
     return scene_;
 }
 
+ShaderParameterBlock* Material::GetShaderParameterBlock()
+{
+    if (!shaderParameterBlock_)
+    {
+        shaderParameterBlock_ = new ShaderParameterBlock();
+        for (HashMap<StringHash, MaterialShaderParameter>::ConstIterator i = shaderParameters_.Begin();
+             i != shaderParameters_.End(); ++i)
+            shaderParameterBlock_->AddParameter(i->first_, i->second_.value_);
+    }
+
+    return shaderParameterBlock_;
+}
+
 String Material::GetTextureUnitName(TextureUnit unit)
 {
     return textureUnitNames[unit];
@@ -1304,6 +1319,9 @@ void Material::ResetToDefaults()
 
 void Material::RefreshShaderParameterHash()
 {
+    // A block already used for rendering may still be referenced, so build a new one instead of modifying it
+    shaderParameterBlock_.Reset();
+
     VectorBuffer temp;
     for (HashMap<StringHash, MaterialShaderParameter>::ConstIterator i = shaderParameters_.Begin();
          i != shaderParameters_.End(); ++i)
@@ -24,6 +24,7 @@
 
 #include "../Graphics/GraphicsDefs.h"
 #include "../Graphics/Light.h"
+#include "../Graphics/ShaderParameterBlock.h"
 #include "../Math/Vector4.h"
 #include "../Resource/Resource.h"
 #include "../Scene/ValueAnimationInfo.h"
@@ -254,6 +255,8 @@ public:
 
     /// Return shader parameter hash value. Used as an optimization to avoid setting shader parameters unnecessarily.
     unsigned GetShaderParameterHash() const { return shaderParameterHash_; }
+    /// Return the shader parameters baked into a block for rendering. The block is rebuilt on the next call after the parameters change.
+    ShaderParameterBlock* GetShaderParameterBlock();
 
     /// Return name for texture unit.
     static String GetTextureUnitName(TextureUnit unit);
@@ -307,6 +310,8 @@ private:
     unsigned auxViewFrameNumber_;
     /// Shader parameter hash value.
     unsigned shaderParameterHash_;
+    /// %Shader parameters baked for rendering. Null when needs rebuild.
+    SharedPtr<ShaderParameterBlock> shaderParameterBlock_;
     /// Alpha-to-coverage flag.
     bool alphaToCoverage_;
     /// Line antialiasing flag.
@@ -0,0 +1,351 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/HashMap.h"
+#include "../Container/Sort.h"
+#include "../Graphics/MeshSimplifier.h"
+#include "../Math/Vector3.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned MAX_SIMPLIFY_PASSES = 64;
+
+/// Symmetric 4x4 matrix measuring the squared distance of a point to a set of planes.
+struct SimplifyQuadric
+{
+    /// Construct as zero.
+    SimplifyQuadric()
+    {
+        for (unsigned i = 0; i < 10; ++i)
+            a_[i] = 0.0;
+    }
+
+    /// Add a weighted plane.
+    void AddPlane(const Vector3& normal, float d, float weight)
+    {
+        double a = normal.x_;
+        double b = normal.y_;
+        double c = normal.z_;
+
+        a_[0] += weight * a * a;
+        a_[1] += weight * a * b;
+        a_[2] += weight * a * c;
+        a_[3] += weight * a * d;
+        a_[4] += weight * b * b;
+        a_[5] += weight * b * c;
+        a_[6] += weight * b * d;
+        a_[7] += weight * c * c;
+        a_[8] += weight * c * d;
+        a_[9] += weight * (double)d * d;
+    }
+
+    /// Add another quadric.
+    void Add(const SimplifyQuadric& rhs)
+    {
+        for (unsigned i = 0; i < 10; ++i)
+            a_[i] += rhs.a_[i];
+    }
+
+    /// Return error of a point.
+    double Evaluate(const Vector3& point) const
+    {
+        double x = point.x_;
+        double y = point.y_;
+        double z = point.z_;
+
+        return a_[0] * x * x + 2.0 * a_[1] * x * y + 2.0 * a_[2] * x * z + 2.0 * a_[3] * x + a_[4] * y * y +
+            2.0 * a_[5] * y * z + 2.0 * a_[6] * y + a_[7] * z * z + 2.0 * a_[8] * z + a_[9];
+    }
+
+    /// Matrix elements.
+    double a_[10];
+};
+
+/// Candidate collapse of a vertex onto a neighbour.
+struct SimplifyCollapse
+{
+    /// Vertex to remove.
+    unsigned from_;
+    /// Vertex to collapse to.
+    unsigned to_;
+    /// Error caused by the collapse.
+    float cost_;
+};
+
+/// Vertex ordering by position for welding.
+struct SimplifyPositionCompare
+{
+    SimplifyPositionCompare(const PODVector<Vector3>& positions) :
+        positions_(positions)
+    {
+    }
+
+    bool operator ()(unsigned lhs, unsigned rhs) const
+    {
+        const Vector3& a = positions_[lhs];
+        const Vector3& b = positions_[rhs];
+        if (a.x_ != b.x_)
+            return a.x_ < b.x_;
+        if (a.y_ != b.y_)
+            return a.y_ < b.y_;
+        if (a.z_ != b.z_)
+            return a.z_ < b.z_;
+        return lhs < rhs;
+    }
+
+    const PODVector<Vector3>& positions_;
+};
+
+static bool CompareCollapses(const SimplifyCollapse& lhs, const SimplifyCollapse& rhs)
+{
+    return lhs.cost_ < rhs.cost_;
+}
+
+static unsigned long long MakeEdgeKey(unsigned a, unsigned b)
+{
+    return a < b ? ((unsigned long long)a << 32) | b : ((unsigned long long)b << 32) | a;
+}
+
+unsigned SimplifyMesh(PODVector<unsigned>& dest, const void* vertexData, unsigned vertexSize, unsigned positionOffset,
+    const void* indexData, unsigned indexSize, unsigned indexStart, unsigned indexCount, unsigned targetIndexCount)
+{
+    dest.Clear();
+    indexCount -= indexCount % 3;
+    if (!vertexData || !indexData || !indexCount)
+        return 0;
+
+    // Read the indices
+    unsigned numVertices = 0;
+    dest.Resize(indexCount);
+    for (unsigned i = 0; i < indexCount; ++i)
+    {
+        if (indexSize == sizeof(unsigned short))
+            dest[i] = ((const unsigned short*)indexData)[indexStart + i];
+        else
+            dest[i] = ((const unsigned*)indexData)[indexStart + i];
+        numVertices = Max(numVertices, dest[i] + 1);
+    }
+
+    unsigned numTriangles = indexCount / 3;
+    unsigned targetTriangles = targetIndexCount / 3;
+    if (numTriangles <= targetTriangles)
+        return numTriangles;
+
+    PODVector<Vector3> positions(numVertices);
+    for (unsigned i = 0; i < numVertices; ++i)
+        positions[i] = *((const Vector3*)((const unsigned char*)vertexData + i * vertexSize + positionOffset));
+
+    // Weld vertices with the same position. Quadrics and borders are tracked per welded vertex
+    PODVector<unsigned> order(numVertices);
+    for (unsigned i = 0; i < numVertices; ++i)
+        order[i] = i;
+    Sort(order.Begin(), order.End(), SimplifyPositionCompare(positions));
+
+    PODVector<unsigned> weld(numVertices);
+    PODVector<unsigned> weldCount(numVertices, 0);
+    for (unsigned i = 0; i < numVertices; ++i)
+    {
+        unsigned v = order[i];
+        weld[v] = (i > 0 && positions[order[i - 1]] == positions[v]) ? weld[order[i - 1]] : v;
+    }
+    // Count only vertices that are actually referenced, so that unused duplicates do not create false seams
+    PODVector<bool> used(numVertices, false);
+    for (unsigned i = 0; i < indexCount; ++i)
+        used[dest[i]] = true;
+    for (unsigned i = 0; i < numVertices; ++i)
+    {
+        if (used[i])
+            ++weldCount[weld[i]];
+    }
+
+    // Lock attribute seams and open borders, as moving them would tear or shrink the mesh
+    PODVector<bool> locked(numVertices, false);
+    for (unsigned i = 0; i < numVertices; ++i)
+        locked[i] = weldCount[i] > 1;
+
+    HashMap<unsigned long long, unsigned> edgeCounts;
+    for (unsigned i = 0; i < indexCount; i += 3)
+    {
+        for (unsigned j = 0; j < 3; ++j)
+            ++edgeCounts[MakeEdgeKey(weld[dest[i + j]], weld[dest[i + (j + 1) % 3]])];
+    }
+    for (HashMap<unsigned long long, unsigned>::ConstIterator i = edgeCounts.Begin(); i != edgeCounts.End(); ++i)
+    {
+        if (i->second_ == 1)
+        {
+            locked[(unsigned)(i->first_ >> 32)] = true;
+            locked[(unsigned)(i->first_ & 0xffffffff)] = true;
+        }
+    }
+
+    // Accumulate the area-weighted planes of the adjacent triangles to each welded vertex
+    Vector<SimplifyQuadric> quadrics(numVertices);
+    for (unsigned i = 0; i < indexCount; i += 3)
+    {
+        const Vector3& p0 = positions[dest[i]];
+        Vector3 normal = (positions[dest[i + 1]] - p0).CrossProduct(positions[dest[i + 2]] - p0);
+        float area = normal.Length();
+        if (area < M_EPSILON)
+            continue;
+        normal /= area;
+        float d = -normal.DotProduct(p0);
+        for (unsigned j = 0; j < 3; ++j)
+            quadrics[weld[dest[i + j]]].AddPlane(normal, d, area);
+    }
+
+    PODVector<SimplifyCollapse> collapses;
+    PODVector<unsigned> remap(numVertices);
+    PODVector<bool> touched(numVertices);
+    PODVector<unsigned> adjacencyStart(numVertices + 1);
+    PODVector<unsigned> adjacency;
+
+    for (unsigned pass = 0; pass < MAX_SIMPLIFY_PASSES && numTriangles > targetTriangles; ++pass)
+    {
+        // Gather candidate collapses from the current triangles, cheapest first
+        collapses.Clear();
+        for (unsigned i = 0; i < dest.Size(); i += 3)
+        {
+            for (unsigned j = 0; j < 3; ++j)
+            {
+                unsigned a = dest[i + j];
+                unsigned b = dest[i + (j + 1) % 3];
+                for (unsigned k = 0; k < 2; ++k)
+                {
+                    unsigned from = k ? b : a;
+                    unsigned to = k ? a : b;
+                    if (locked[weld[from]])
+                        continue;
+
+                    SimplifyQuadric quadric = quadrics[weld[from]];
+                    quadric.Add(quadrics[weld[to]]);
+                    SimplifyCollapse collapse;
+                    collapse.from_ = from;
+                    collapse.to_ = to;
+                    collapse.cost_ = (float)quadric.Evaluate(positions[to]);
+                    collapses.Push(collapse);
+                }
+            }
+        }
+        if (collapses.Empty())
+            break;
+        Sort(collapses.Begin(), collapses.End(), CompareCollapses);
+
+        // Build vertex to triangle adjacency for the flip check
+        for (unsigned i = 0; i <= numVertices; ++i)
+            adjacencyStart[i] = 0;
+        for (unsigned i = 0; i < dest.Size(); ++i)
+            ++adjacencyStart[dest[i] + 1];
+        for (unsigned i = 0; i < numVertices; ++i)
+            adjacencyStart[i + 1] += adjacencyStart[i];
+        adjacency.Resize(dest.Size());
+        {
+            PODVector<unsigned> fill(adjacencyStart.Buffer(), numVertices);
+            for (unsigned i = 0; i < dest.Size(); ++i)
+                adjacency[fill[dest[i]]++] = i / 3;
+        }
+
+        for (unsigned i = 0; i < numVertices; ++i)
+        {
+            remap[i] = i;
+            touched[i] = false;
+        }
+
+        // Apply the cheapest collapses whose neighbourhoods do not overlap. Each removes about two triangles
+        unsigned removed = 0;
+        unsigned maxRemoved = numTriangles - targetTriangles;
+        for (unsigned i = 0; i < collapses.Size() && removed < maxRemoved; ++i)
+        {
+            const SimplifyCollapse& collapse = collapses[i];
+            unsigned from = collapse.from_;
+            unsigned to = collapse.to_;
+            if (touched[weld[from]] || touched[weld[to]])
+                continue;
+
+            // Reject collapses that would flip a remaining triangle
+            const Vector3& newPosition = positions[to];
+            unsigned degenerate = 0;
+            bool flips = false;
+            for (unsigned j = adjacencyStart[from]; j < adjacencyStart[from + 1] && !flips; ++j)
+            {
+                unsigned t = adjacency[j] * 3;
+                unsigned v0 = dest[t];
+                unsigned v1 = dest[t + 1];
+                unsigned v2 = dest[t + 2];
+                if (weld[v0] == weld[to] || weld[v1] == weld[to] || weld[v2] == weld[to])
+                {
+                    ++degenerate;
+                    continue;
+                }
+
+                const Vector3& p0 = positions[v0];
+                Vector3 oldNormal = (positions[v1] - p0).CrossProduct(positions[v2] - p0);
+                const Vector3& q0 = v0 == from ? newPosition : positions[v0];
+                const Vector3& q1 = v1 == from ? newPosition : positions[v1];
+                const Vector3& q2 = v2 == from ? newPosition : positions[v2];
+                Vector3 newNormal = (q1 - q0).CrossProduct(q2 - q0);
+                if (oldNormal.DotProduct(newNormal) <= 0.0f)
+                    flips = true;
+            }
+            if (flips)
+                continue;
+
+            remap[from] = to;
+            quadrics[weld[to]].Add(quadrics[weld[from]]);
+            removed += degenerate;
+
+            // Lock the neighbourhood for the rest of the pass, as its triangles are about to change
+            for (unsigned j = adjacencyStart[from]; j < adjacencyStart[from + 1]; ++j)
+            {
+                unsigned t = adjacency[j] * 3;
+                for (unsigned k = 0; k < 3; ++k)
+                    touched[weld[dest[t + k]]] = true;
+            }
+        }
+        if (!removed)
+            break;
+
+        // Rebuild the triangle list without the collapsed triangles
+        unsigned writeIndex = 0;
+        for (unsigned i = 0; i < dest.Size(); i += 3)
+        {
+            unsigned v0 = remap[dest[i]];
+            unsigned v1 = remap[dest[i + 1]];
+            unsigned v2 = remap[dest[i + 2]];
+            if (weld[v0] == weld[v1] || weld[v1] == weld[v2] || weld[v2] == weld[v0])
+                continue;
+            dest[writeIndex++] = v0;
+            dest[writeIndex++] = v1;
+            dest[writeIndex++] = v2;
+        }
+        dest.Resize(writeIndex);
+        numTriangles = writeIndex / 3;
+    }
+
+    return numTriangles;
+}
+
+}
@@ -26,6 +26,7 @@
 #include "../Core/Profiler.h"
 #include "../Graphics/Geometry.h"
 #include "../Graphics/IndexBuffer.h"
+#include "../Graphics/MeshSimplifier.h"
 #include "../Graphics/Model.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/VertexBuffer.h"
@@ -735,6 +736,271 @@ SharedPtr<Model> Model::Clone(const String& cloneName) const
     return ret;
 }
 
+bool Model::GenerateLodLevels(unsigned numLevels, float triangleRatio, float lodDistance)
+{
+    URHO3D_PROFILE(GenerateLodLevels);
+
+    triangleRatio = Clamp(triangleRatio, 0.01f, 0.99f);
+    unsigned memoryUse = GetMemoryUse();
+    bool generated = false;
+
+    for (unsigned i = 0; i < geometries_.Size(); ++i)
+    {
+        Geometry* original = geometries_[i].Size() ? geometries_[i][0].Get() : 0;
+        if (!original || original->GetPrimitiveType() != TRIANGLE_LIST)
+            continue;
+
+        VertexBuffer* vertexBuffer = original->GetVertexBuffer(0);
+        IndexBuffer* indexBuffer = original->GetIndexBuffer();
+        if (!vertexBuffer || !indexBuffer || !vertexBuffer->GetShadowData() || !indexBuffer->GetShadowData())
+        {
+            URHO3D_LOGWARNING("Geometry " + String(i) + " has no shadowed vertex and index data, can not generate LOD levels");
+            continue;
+        }
+        unsigned positionOffset = vertexBuffer->GetElementOffset(TYPE_VECTOR3, SEM_POSITION);
+        if (positionOffset == M_MAX_UNSIGNED)
+            continue;
+
+        // Simplify each level from the previous one. Stop early if the mesh can not be reduced further
+        Vector<PODVector<unsigned> > levels;
+        unsigned totalIndices = 0;
+        unsigned indexCount = original->GetIndexCount();
+        for (unsigned j = 0; j < numLevels; ++j)
+        {
+            PODVector<unsigned> simplified;
+            unsigned targetIndexCount = (unsigned)(indexCount * triangleRatio);
+            if (levels.Empty())
+            {
+                SimplifyMesh(simplified, vertexBuffer->GetShadowData(), vertexBuffer->GetVertexSize(), positionOffset,
+                    indexBuffer->GetShadowData(), indexBuffer->GetIndexSize(), original->GetIndexStart(), indexCount,
+                    targetIndexCount);
+            }
+            else
+            {
+                SimplifyMesh(simplified, vertexBuffer->GetShadowData(), vertexBuffer->GetVertexSize(), positionOffset,
+                    levels.Back().Buffer(), sizeof(unsigned), 0, indexCount, targetIndexCount);
+            }
+            if (simplified.Empty() || simplified.Size() >= indexCount)
+                break;
+
+            indexCount = simplified.Size();
+            totalIndices += indexCount;
+            levels.Push(simplified);
+        }
+        if (levels.Empty())
+            continue;
+
+        // Store all the levels of the geometry in one new index buffer, keeping the original index size
+        unsigned indexSize = indexBuffer->GetIndexSize();
+        SharedArrayPtr<unsigned char> indexData(new unsigned char[totalIndices * indexSize]);
+        unsigned char* dest = indexData.Get();
+        for (unsigned j = 0; j < levels.Size(); ++j)
+        {
+            const PODVector<unsigned>& level = levels[j];
+            for (unsigned k = 0; k < level.Size(); ++k)
+            {
+                if (indexSize == sizeof(unsigned short))
+                    *((unsigned short*)dest) = (unsigned short)level[k];
+                else
+                    *((unsigned*)dest) = level[k];
+                dest += indexSize;
+            }
+        }
+
+        SharedPtr<IndexBuffer> lodBuffer(new IndexBuffer(context_));
+        lodBuffer->SetShadowed(true);
+        lodBuffer->SetSize(totalIndices, indexSize == sizeof(unsigned));
+        lodBuffer->SetData(indexData.Get());
+        indexBuffers_.Push(lodBuffer);
+        memoryUse += totalIndices * indexSize;
+
+        geometries_[i].Resize(levels.Size() + 1);
+        unsigned indexStart = 0;
+        for (unsigned j = 0; j < levels.Size(); ++j)
+        {
+            SharedPtr<Geometry> geometry(new Geometry(context_));
+            geometry->SetNumVertexBuffers(original->GetNumVertexBuffers());
+            for (unsigned k = 0; k < original->GetNumVertexBuffers(); ++k)
+                geometry->SetVertexBuffer(k, original->GetVertexBuffer(k));
+            geometry->SetIndexBuffer(lodBuffer);
+            geometry->SetDrawRange(TRIANGLE_LIST, indexStart, levels[j].Size());
+            geometry->SetLodDistance(lodDistance * (float)(1u << j));
+            geometries_[i][j + 1] = geometry;
+            indexStart += levels[j].Size();
+        }
+
+        generated = true;
+    }
+
+    if (generated)
+    {
+        // Drop the index buffers of replaced LOD levels so that they are not saved
+        Vector<SharedPtr<IndexBuffer> > usedBuffers;
+        for (unsigned i = 0; i < indexBuffers_.Size(); ++i)
+        {
+            IndexBuffer* buffer = indexBuffers_[i];
+            bool used = false;
+            for (unsigned j = 0; j < geometries_.Size() && !used; ++j)
+            {
+                for (unsigned k = 0; k < geometries_[j].Size() && !used; ++k)
+                    used = geometries_[j][k] && geometries_[j][k]->GetIndexBuffer() == buffer;
+            }
+
+            if (used)
+                usedBuffers.Push(indexBuffers_[i]);
+            else
+                memoryUse -= Min(memoryUse, buffer->GetIndexCount() * buffer->GetIndexSize());
+        }
+        indexBuffers_ = usedBuffers;
+        SetMemoryUse(memoryUse);
+    }
+
+    return generated;
+}
+
+SharedPtr<Model> Model::CloneLodLevels(unsigned firstLevel, const String& cloneName) const
+{
+    if (!morphs_.Empty())
+    {
+        URHO3D_LOGERROR("Can not clone LOD levels of a model with vertex morphs");
+        return SharedPtr<Model>();
+    }
+
+    // Renumber the vertices of each vertex buffer in the order the kept LOD levels use them
+    Vector<PODVector<unsigned> > vertexRemaps(vertexBuffers_.Size());
+    PODVector<unsigned> vertexCounts(vertexBuffers_.Size(), 0);
+    unsigned totalIndices = 0;
+    for (unsigned i = 0; i < geometries_.Size(); ++i)
+    {
+        for (unsigned j = Min(firstLevel, geometries_[i].Size() - 1); j < geometries_[i].Size(); ++j)
+        {
+            Geometry* geometry = geometries_[i][j];
+            VertexBuffer* vertexBuffer = geometry ? geometry->GetVertexBuffer(0) : 0;
+            IndexBuffer* indexBuffer = geometry ? geometry->GetIndexBuffer() : 0;
+            if (!vertexBuffer || !indexBuffer || !vertexBuffer->GetShadowData() || !indexBuffer->GetShadowData() ||
+                geometry->GetNumVertexBuffers() != 1)
+            {
+                URHO3D_LOGERROR("Can not clone LOD levels without shadowed single vertex buffer geometries");
+                return SharedPtr<Model>();
+            }
+
+            unsigned bufferIndex = LookupVertexBuffer(vertexBuffer, vertexBuffers_);
+            PODVector<unsigned>& remap = vertexRemaps[bufferIndex];
+            if (remap.Empty())
+                remap = PODVector<unsigned>(vertexBuffer->GetVertexCount(), M_MAX_UNSIGNED);
+
+            const unsigned char* indexData = indexBuffer->GetShadowData();
+            unsigned indexSize = indexBuffer->GetIndexSize();
+            unsigned indexEnd = geometry->GetIndexStart() + geometry->GetIndexCount();
+            for (unsigned k = geometry->GetIndexStart(); k < indexEnd; ++k)
+            {
+                unsigned vertex = indexSize == sizeof(unsigned short) ? ((const unsigned short*)indexData)[k] :
+                    ((const unsigned*)indexData)[k];
+                if (remap[vertex] == M_MAX_UNSIGNED)
+                    remap[vertex] = vertexCounts[bufferIndex]++;
+            }
+            totalIndices += geometry->GetIndexCount();
+        }
+    }
+
+    SharedPtr<Model> ret(new Model(context_));
+
+    ret->SetName(cloneName);
+    ret->boundingBox_ = boundingBox_;
+    ret->skeleton_ = skeleton_;
+    ret->geometryBoneMappings_ = geometryBoneMappings_;
+    ret->geometryCenters_ = geometryCenters_;
+
+    // Copy the used vertices into compacted vertex buffers
+    unsigned memoryUse = sizeof(Model);
+    bool largeIndices = false;
+    Vector<SharedPtr<VertexBuffer> > cloneBuffers(vertexBuffers_.Size());
+    for (unsigned i = 0; i < vertexBuffers_.Size(); ++i)
+    {
+        if (!vertexCounts[i])
+            continue;
+
+        VertexBuffer* origBuffer = vertexBuffers_[i];
+        const PODVector<unsigned>& remap = vertexRemaps[i];
+        unsigned vertexSize = origBuffer->GetVertexSize();
+        SharedArrayPtr<unsigned char> vertexData(new unsigned char[vertexCounts[i] * vertexSize]);
+        for (unsigned j = 0; j < remap.Size(); ++j)
+        {
+            if (remap[j] != M_MAX_UNSIGNED)
+                memcpy(vertexData.Get() + remap[j] * vertexSize, origBuffer->GetShadowData() + j * vertexSize, vertexSize);
+        }
+
+        SharedPtr<VertexBuffer> cloneBuffer(new VertexBuffer(context_));
+        cloneBuffer->SetShadowed(true);
+        cloneBuffer->SetSize(vertexCounts[i], origBuffer->GetElements());
+        cloneBuffer->SetData(vertexData.Get());
+        cloneBuffers[i] = cloneBuffer;
+        ret->vertexBuffers_.Push(cloneBuffer);
+        ret->morphRangeStarts_.Push(0);
+        ret->morphRangeCounts_.Push(0);
+
+        memoryUse += vertexCounts[i] * vertexSize;
+        if (vertexCounts[i] > 65535)
+            largeIndices = true;
+    }
+
+    // Gather the remapped indices of all kept LOD levels into one index buffer
+    unsigned indexSize = largeIndices ? sizeof(unsigned) : sizeof(unsigned short);
+    SharedArrayPtr<unsigned char> cloneIndexData(new unsigned char[totalIndices * indexSize]);
+    unsigned char* dest = cloneIndexData.Get();
+    for (unsigned i = 0; i < geometries_.Size(); ++i)
+    {
+        for (unsigned j = Min(firstLevel, geometries_[i].Size() - 1); j < geometries_[i].Size(); ++j)
+        {
+            Geometry* geometry = geometries_[i][j];
+            IndexBuffer* indexBuffer = geometry->GetIndexBuffer();
+            const PODVector<unsigned>& remap = vertexRemaps[LookupVertexBuffer(geometry->GetVertexBuffer(0), vertexBuffers_)];
+            const unsigned char* indexData = indexBuffer->GetShadowData();
+            unsigned origIndexSize = indexBuffer->GetIndexSize();
+            unsigned indexEnd = geometry->GetIndexStart() + geometry->GetIndexCount();
+            for (unsigned k = geometry->GetIndexStart(); k < indexEnd; ++k)
+            {
+                unsigned vertex = remap[origIndexSize == sizeof(unsigned short) ? ((const unsigned short*)indexData)[k] :
+                    ((const unsigned*)indexData)[k]];
+                if (largeIndices)
+                    *((unsigned*)dest) = vertex;
+                else
+                    *((unsigned short*)dest) = (unsigned short)vertex;
+                dest += indexSize;
+            }
+        }
+    }
+
+    SharedPtr<IndexBuffer> cloneIndexBuffer(new IndexBuffer(context_));
+    cloneIndexBuffer->SetShadowed(true);
+    cloneIndexBuffer->SetSize(totalIndices, largeIndices);
+    cloneIndexBuffer->SetData(cloneIndexData.Get());
+    ret->indexBuffers_.Push(cloneIndexBuffer);
+    memoryUse += totalIndices * indexSize;
+
+    // Kept LOD levels retain their distances, so the first one tells from how far the clone suffices
+    unsigned indexStart = 0;
+    ret->geometries_.Resize(geometries_.Size());
+    for (unsigned i = 0; i < geometries_.Size(); ++i)
+    {
+        for (unsigned j = Min(firstLevel, geometries_[i].Size() - 1); j < geometries_[i].Size(); ++j)
+        {
+            Geometry* origGeometry = geometries_[i][j];
+            SharedPtr<Geometry> cloneGeometry(new Geometry(context_));
+            cloneGeometry->SetVertexBuffer(0, cloneBuffers[LookupVertexBuffer(origGeometry->GetVertexBuffer(0), vertexBuffers_)]);
+            cloneGeometry->SetIndexBuffer(cloneIndexBuffer);
+            cloneGeometry->SetDrawRange(origGeometry->GetPrimitiveType(), indexStart, origGeometry->GetIndexCount());
+            cloneGeometry->SetLodDistance(origGeometry->GetLodDistance());
+            ret->geometries_[i].Push(cloneGeometry);
+            indexStart += origGeometry->GetIndexCount();
+        }
+    }
+
+    ret->SetMemoryUse(memoryUse);
+
+    return ret;
+}
+
 unsigned Model::GetNumGeometryLodLevels(unsigned index) const
 {
     return index < geometries_.Size() ? geometries_[index].Size() : 0;
@@ -147,6 +147,10 @@ public:
     void SetMorphs(const Vector<ModelMorph>& morphs);
     /// Clone the model. The geometry data is deep-copied and can be modified in the clone without affecting the original.
     SharedPtr<Model> Clone(const String& cloneName = String::EMPTY) const;
+    /// Generate LOD levels for the triangle list geometries by simplifying their first LOD level, replacing any existing further levels. Each level keeps triangleRatio of the previous level's triangles and reuses the original vertices. The first generated level is used from lodDistance on and each further level doubles the distance. Requires shadowed vertex and index data. Return true if any geometry received LOD levels.
+    bool GenerateLodLevels(unsigned numLevels, float triangleRatio = 0.5f, float lodDistance = 10.0f);
+    /// Clone only the LOD levels from firstLevel on, compacting the vertex and index data to what they use. Geometries with fewer levels keep their last level. Used to split off a small resident model for LOD streaming. Not supported for models with vertex morphs.
+    SharedPtr<Model> CloneLodLevels(unsigned firstLevel, const String& cloneName = String::EMPTY) const;
 
     /// Return bounding box.
     const BoundingBox& GetBoundingBox() const { return boundingBox_; }
@@ -0,0 +1,94 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../../Precompiled.h"
+
+#include "../../Graphics/Graphics.h"
+#include "../../Graphics/GraphicsImpl.h"
+
+#include "../../DebugNew.h"
+
+namespace Urho3D
+{
+
+void NullGraphicsStatistics::Reset()
+{
+    draws_ = 0;
+    instancedDraws_ = 0;
+    instances_ = 0;
+    primitives_ = 0;
+    vertices_ = 0;
+    clears_ = 0;
+    shaderChanges_ = 0;
+    shaderParameterUpdates_ = 0;
+    vertexBufferChanges_ = 0;
+    indexBufferChanges_ = 0;
+    textureChanges_ = 0;
+    samplerChanges_ = 0;
+    renderTargetChanges_ = 0;
+    viewportChanges_ = 0;
+    renderStateChanges_ = 0;
+    bufferUpdates_ = 0;
+    bufferUpdateBytes_ = 0;
+    textureUpdates_ = 0;
+}
+
+NullGraphicsStatistics& NullGraphicsStatistics::operator +=(const NullGraphicsStatistics& rhs)
+{
+    draws_ += rhs.draws_;
+    instancedDraws_ += rhs.instancedDraws_;
+    instances_ += rhs.instances_;
+    primitives_ += rhs.primitives_;
+    vertices_ += rhs.vertices_;
+    clears_ += rhs.clears_;
+    shaderChanges_ += rhs.shaderChanges_;
+    shaderParameterUpdates_ += rhs.shaderParameterUpdates_;
+    vertexBufferChanges_ += rhs.vertexBufferChanges_;
+    indexBufferChanges_ += rhs.indexBufferChanges_;
+    textureChanges_ += rhs.textureChanges_;
+    samplerChanges_ += rhs.samplerChanges_;
+    renderTargetChanges_ += rhs.renderTargetChanges_;
+    viewportChanges_ += rhs.viewportChanges_;
+    renderStateChanges_ += rhs.renderStateChanges_;
+    bufferUpdates_ += rhs.bufferUpdates_;
+    bufferUpdateBytes_ += rhs.bufferUpdateBytes_;
+    textureUpdates_ += rhs.textureUpdates_;
+    return *this;
+}
+
+GraphicsImpl::GraphicsImpl() :
+    shaderProgram_(0),
+    initialized_(false)
+{
+    for (unsigned i = 0; i < MAX_VERTEX_STREAMS; ++i)
+        streamOffsets_[i] = 0;
+    for (unsigned i = 0; i < MAX_TEXTURE_UNITS; ++i)
+    {
+        filterModes_[i] = FILTER_DEFAULT;
+        addressModes_[i][COORD_U] = ADDRESS_WRAP;
+        addressModes_[i][COORD_V] = ADDRESS_WRAP;
+        addressModes_[i][COORD_W] = ADDRESS_WRAP;
+        maxAnisotropy_[i] = 0;
+    }
+}
+
+}
@@ -0,0 +1,162 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../../Core/Mutex.h"
+#include "../../Graphics/ShaderProgram.h"
+
+namespace Urho3D
+{
+
+typedef HashMap<Pair<ShaderVariation*, ShaderVariation*>, SharedPtr<ShaderProgram> > ShaderProgramMap;
+
+/// Texture formats of the null graphics backend. Only used to tell formats apart and to calculate data sizes.
+enum NullTextureFormat
+{
+    NULLFMT_NONE = 0,
+    NULLFMT_A8,
+    NULLFMT_L8,
+    NULLFMT_L8A8,
+    NULLFMT_RGB8,
+    NULLFMT_RGBA8,
+    NULLFMT_RGBA16,
+    NULLFMT_RGBA16F,
+    NULLFMT_RGBA32F,
+    NULLFMT_RG16,
+    NULLFMT_RG16F,
+    NULLFMT_RG32F,
+    NULLFMT_R16F,
+    NULLFMT_R32F,
+    NULLFMT_D16,
+    NULLFMT_D24S8,
+    NULLFMT_DXT1,
+    NULLFMT_DXT3,
+    NULLFMT_DXT5
+};
+
+/// Draw call and state change counts recorded by the null graphics backend.
+struct URHO3D_API NullGraphicsStatistics
+{
+    /// Construct with zero counts.
+    NullGraphicsStatistics()
+    {
+        Reset();
+    }
+
+    /// Reset all counts to zero.
+    void Reset();
+    /// Add counts from another statistics object.
+    NullGraphicsStatistics& operator +=(const NullGraphicsStatistics& rhs);
+
+    /// Draw calls, including instanced draw calls.
+    unsigned draws_;
+    /// Instanced draw calls.
+    unsigned instancedDraws_;
+    /// Instances drawn by instanced draw calls.
+    unsigned instances_;
+    /// Primitives drawn.
+    unsigned primitives_;
+    /// Vertices or indices submitted by draw calls.
+    unsigned vertices_;
+    /// Clear calls.
+    unsigned clears_;
+    /// Shader program changes.
+    unsigned shaderChanges_;
+    /// Shader parameter updates that reached a shader constant.
+    unsigned shaderParameterUpdates_;
+    /// Vertex buffer binding changes.
+    unsigned vertexBufferChanges_;
+    /// Index buffer binding changes.
+    unsigned indexBufferChanges_;
+    /// Texture binding changes.
+    unsigned textureChanges_;
+    /// Texture sampler state changes.
+    unsigned samplerChanges_;
+    /// Rendertarget and depth-stencil binding changes.
+    unsigned renderTargetChanges_;
+    /// Viewport changes.
+    unsigned viewportChanges_;
+    /// Rasterizer, blend, depth and stencil state changes.
+    unsigned renderStateChanges_;
+    /// Vertex and index buffer data updates.
+    unsigned bufferUpdates_;
+    /// Bytes written by vertex and index buffer data updates.
+    unsigned bufferUpdateBytes_;
+    /// Texture data updates.
+    unsigned textureUpdates_;
+};
+
+/// %Graphics implementation. Holds API-specific objects.
+class URHO3D_API GraphicsImpl
+{
+    friend class Graphics;
+
+public:
+    /// Construct.
+    GraphicsImpl();
+
+    /// Record a vertex or index buffer data update.
+    void RecordBufferUpdate(unsigned bytes)
+    {
+        ++frameStatistics_.bufferUpdates_;
+        frameStatistics_.bufferUpdateBytes_ += bytes;
+    }
+
+    /// Record a texture data update.
+    void RecordTextureUpdate() { ++frameStatistics_.textureUpdates_; }
+
+    /// Return statistics of the last completed frame.
+    const NullGraphicsStatistics& GetFrameStatistics() const { return lastFrameStatistics_; }
+
+    /// Return statistics accumulated over all completed frames since the last reset.
+    const NullGraphicsStatistics& GetTotalStatistics() const { return totalStatistics_; }
+
+    /// Reset the accumulated statistics.
+    void ResetTotalStatistics() { totalStatistics_.Reset(); }
+
+private:
+    /// Counts of the frame in progress.
+    NullGraphicsStatistics frameStatistics_;
+    /// Counts of the last completed frame.
+    NullGraphicsStatistics lastFrameStatistics_;
+    /// Accumulated counts.
+    NullGraphicsStatistics totalStatistics_;
+    /// Stream offsets by vertex buffer.
+    unsigned streamOffsets_[MAX_VERTEX_STREAMS];
+    /// Texture filter modes in use.
+    TextureFilterMode filterModes_[MAX_TEXTURE_UNITS];
+    /// Texture U, V and W coordinate addressing modes in use.
+    TextureAddressMode addressModes_[MAX_TEXTURE_UNITS][MAX_COORDS];
+    /// Texture anisotropy setting in use.
+    unsigned maxAnisotropy_[MAX_TEXTURE_UNITS];
+    /// Shader programs.
+    ShaderProgramMap shaderPrograms_;
+    /// Mutex for the shader programs, as shader variations may be released on the main thread during threaded submission.
+    Mutex shaderProgramMutex_;
+    /// Shader program in use.
+    ShaderProgram* shaderProgram_;
+    /// Screen mode set flag.
+    bool initialized_;
+};
+
+}
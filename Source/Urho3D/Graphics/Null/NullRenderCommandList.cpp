@@ -0,0 +1,1345 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../../Precompiled.h"
+
+#include "../../Core/Context.h"
+#include "../../Core/Profiler.h"
+#include "../../Core/Timer.h"
+#include "../../Graphics/Geometry.h"
+#include "../../Graphics/Graphics.h"
+#include "../../Graphics/IndexBuffer.h"
+#include "../../Graphics/RenderCommandList.h"
+#include "../../Graphics/RenderSurface.h"
+#include "../../Graphics/ShaderParameterBlock.h"
+#include "../../Graphics/ShaderVariation.h"
+#include "../../Graphics/Texture2D.h"
+#include "../../Graphics/TextureCube.h"
+#include "../../Graphics/VertexBuffer.h"
+#include "../../IO/Log.h"
+#include "../../Math/Plane.h"
+
+#include "../../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const void* UNKNOWN_SOURCE = (const void*)M_MAX_UNSIGNED;
+
+static unsigned GetPrimitiveCount(PrimitiveType type, unsigned elementCount)
+{
+    switch (type)
+    {
+    case TRIANGLE_LIST:
+        return elementCount / 3;
+
+    case LINE_LIST:
+        return elementCount / 2;
+
+    case POINT_LIST:
+        return elementCount;
+
+    case TRIANGLE_STRIP:
+    case TRIANGLE_FAN:
+        return elementCount > 2 ? elementCount - 2 : 0;
+
+    case LINE_STRIP:
+        return elementCount > 1 ? elementCount - 1 : 0;
+    }
+
+    return 0;
+}
+
+static ShaderVariation* PrepareShader(ShaderVariation* variation, ShaderType type)
+{
+    if (!variation)
+        return 0;
+
+    // Create the shader now as Graphics::SetShaders would, so that its parameters and texture units are known while recording
+    if (!variation->GetGPUObject())
+    {
+        // If already attempted, do not retry
+        if (!variation->GetCompilerOutput().Empty())
+            return 0;
+
+        if (!variation->Create())
+        {
+            URHO3D_LOGERROR("Failed to compile " + String(type == VS ? "vertex" : "pixel") + " shader " + variation->GetFullName() +
+                ":\n" + variation->GetCompilerOutput());
+            return 0;
+        }
+    }
+
+    return variation->GetShaderType() == type ? variation : 0;
+}
+
+RenderCommandList::RenderCommandList(Context* context) :
+    Object(context),
+    graphics_(GetSubsystem<Graphics>()),
+    vertexShader_(0),
+    pixelShader_(0),
+    depthStencil_(0),
+    blendMode_(BLEND_REPLACE),
+    numPrimitives_(0),
+    numBatches_(0),
+    recording_(false)
+{
+    for (unsigned i = 0; i < MAX_SHADER_PARAMETER_GROUPS; ++i)
+        shaderParameterSources_[i] = UNKNOWN_SOURCE;
+    for (unsigned i = 0; i < MAX_RENDERTARGETS; ++i)
+        renderTargets_[i] = 0;
+}
+
+RenderCommandList::~RenderCommandList()
+{
+    ClearCommands();
+}
+
+void RenderCommandList::BeginRecording()
+{
+    if (recording_ || !graphics_)
+        return;
+
+    recording_ = true;
+    SyncState();
+}
+
+void RenderCommandList::EndRecording()
+{
+    recording_ = false;
+}
+
+void RenderCommandList::Replay()
+{
+    Graphics* graphics = graphics_;
+    if (!graphics || commands_.Empty())
+        return;
+
+    URHO3D_PROFILE(ReplayRenderCommands);
+
+    for (PODVector<RecordedCommand>::ConstIterator i = commands_.Begin(); i != commands_.End(); ++i)
+    {
+        const RecordedCommand& cmd = *i;
+        const unsigned* args = cmd.args_;
+        const float* data = data_.Empty() ? (const float*)0 : &data_[0] + cmd.dataStart_;
+
+        switch (cmd.type_)
+        {
+        case RCMD_CLEAR:
+            graphics->Clear(args[0], Color(data), data[4], args[1]);
+            break;
+
+        case RCMD_RESOLVETOTEXTURE:
+            graphics->ResolveToTexture(static_cast<Texture2D*>(cmd.object_), IntRect((int)args[0], (int)args[1], (int)args[2],
+                (int)args[3]));
+            break;
+
+        case RCMD_RESOLVETOTEXTURE2D:
+            graphics->ResolveToTexture(static_cast<Texture2D*>(cmd.object_));
+            break;
+
+        case RCMD_RESOLVETOTEXTURECUBE:
+            graphics->ResolveToTexture(static_cast<TextureCube*>(cmd.object_));
+            break;
+
+        case RCMD_DRAW:
+            graphics->Draw((PrimitiveType)args[0], args[1], args[2]);
+            break;
+
+        case RCMD_DRAWINDEXED:
+            if (args[6])
+                graphics->Draw((PrimitiveType)args[0], args[1], args[2], args[3], args[4], args[5]);
+            else
+                graphics->Draw((PrimitiveType)args[0], args[1], args[2], args[4], args[5]);
+            break;
+
+        case RCMD_DRAWINSTANCED:
+            if (args[7])
+                graphics->DrawInstanced((PrimitiveType)args[0], args[1], args[2], args[3], args[4], args[5], args[6]);
+            else
+                graphics->DrawInstanced((PrimitiveType)args[0], args[1], args[2], args[4], args[5], args[6]);
+            break;
+
+        case RCMD_SETVERTEXBUFFERS:
+            replayVertexBuffers_.Resize(args[1]);
+            for (unsigned j = 0; j < args[1]; ++j)
+                replayVertexBuffers_[j] = vertexBuffers_[args[0] + j];
+            graphics->SetVertexBuffers(replayVertexBuffers_, args[2]);
+            break;
+
+        case RCMD_SETINDEXBUFFER:
+            graphics->SetIndexBuffer(static_cast<IndexBuffer*>(cmd.object_));
+            break;
+
+        case RCMD_SETSHADERS:
+            graphics->SetShaders(static_cast<ShaderVariation*>(cmd.object_), static_cast<ShaderVariation*>(cmd.object2_));
+            break;
+
+        case RCMD_SETSHADERPARAMETER:
+            {
+                StringHash param(args[0]);
+                switch (args[1])
+                {
+                case SPO_FLOATS:
+                    graphics->SetShaderParameter(param, data, args[2]);
+                    break;
+
+                case SPO_FLOAT:
+                    graphics->SetShaderParameter(param, data[0]);
+                    break;
+
+                case SPO_INT:
+                    graphics->SetShaderParameter(param, (int)args[2]);
+                    break;
+
+                case SPO_BOOL:
+                    graphics->SetShaderParameter(param, args[2] != 0);
+                    break;
+
+                case SPO_COLOR:
+                    graphics->SetShaderParameter(param, Color(data));
+                    break;
+
+                case SPO_VECTOR2:
+                    graphics->SetShaderParameter(param, Vector2(data));
+                    break;
+
+                case SPO_MATRIX3:
+                    graphics->SetShaderParameter(param, Matrix3(data));
+                    break;
+
+                case SPO_VECTOR3:
+                    graphics->SetShaderParameter(param, Vector3(data));
+                    break;
+
+                case SPO_MATRIX4:
+                    graphics->SetShaderParameter(param, Matrix4(data));
+                    break;
+
+                case SPO_VECTOR4:
+                    graphics->SetShaderParameter(param, Vector4(data));
+                    break;
+
+                case SPO_MATRIX3X4:
+                    graphics->SetShaderParameter(param, Matrix3x4(data));
+                    break;
+                }
+            }
+            break;
+
+        case RCMD_SETSHADERPARAMETERS:
+            static_cast<ShaderParameterBlock*>(cmd.object_)->Apply(graphics);
+            break;
+
+        case RCMD_CLEARPARAMETERSOURCE:
+            graphics->ClearParameterSource((ShaderParameterGroup)args[0]);
+            break;
+
+        case RCMD_CLEARPARAMETERSOURCES:
+            graphics->ClearParameterSources();
+            break;
+
+        case RCMD_CLEARTRANSFORMSOURCES:
+            graphics->ClearTransformSources();
+            break;
+
+        case RCMD_SETTEXTURE:
+            graphics->SetTexture(args[0], static_cast<Texture*>(cmd.object_));
+            break;
+
+        case RCMD_RESETRENDERTARGETS:
+            graphics->ResetRenderTargets();
+            break;
+
+        case RCMD_SETRENDERTARGET:
+            graphics->SetRenderTarget(args[0], static_cast<RenderSurface*>(cmd.object_));
+            break;
+
+        case RCMD_SETDEPTHSTENCIL:
+            graphics->SetDepthStencil(static_cast<RenderSurface*>(cmd.object_));
+            break;
+
+        case RCMD_SETVIEWPORT:
+            graphics->SetViewport(IntRect((int)args[0], (int)args[1], (int)args[2], (int)args[3]));
+            break;
+
+        case RCMD_SETBLENDMODE:
+            graphics->SetBlendMode((BlendMode)args[0], args[1] != 0);
+            break;
+
+        case RCMD_SETCOLORWRITE:
+            graphics->SetColorWrite(args[0] != 0);
+            break;
+
+        case RCMD_SETCULLMODE:
+            graphics->SetCullMode((CullMode)args[0]);
+            break;
+
+        case RCMD_SETDEPTHBIAS:
+            graphics->SetDepthBias(data[0], data[1]);
+            break;
+
+        case RCMD_SETDEPTHTEST:
+            graphics->SetDepthTest((CompareMode)args[0]);
+            break;
+
+        case RCMD_SETDEPTHWRITE:
+            graphics->SetDepthWrite(args[0] != 0);
+            break;
+
+        case RCMD_SETFILLMODE:
+            graphics->SetFillMode((FillMode)args[0]);
+            break;
+
+        case RCMD_SETLINEANTIALIAS:
+            graphics->SetLineAntiAlias(args[0] != 0);
+            break;
+
+        case RCMD_SETSCISSORTEST:
+            graphics->SetScissorTest(args[0] != 0, Rect(data[0], data[1], data[2], data[3]), args[1] != 0);
+            break;
+
+        case RCMD_SETSCISSORRECT:
+            graphics->SetScissorTest(args[0] != 0, IntRect((int)args[1], (int)args[2], (int)args[3], (int)args[4]));
+            break;
+
+        case RCMD_SETSTENCILTEST:
+            graphics->SetStencilTest(args[0] != 0, (CompareMode)args[1], (StencilOp)args[2], (StencilOp)args[3], (StencilOp)args[4],
+                args[5], args[6], args[7]);
+            break;
+
+        case RCMD_SETCLIPPLANE:
+            if (args[0])
+                graphics->SetClipPlane(true, Plane(Vector4(data)), Matrix3x4(data + 4), Matrix4(data + 16));
+            else
+                graphics->SetClipPlane(false);
+            break;
+        }
+    }
+}
+
+void RenderCommandList::ClearCommands()
+{
+    for (PODVector<RefCounted*>::Iterator i = references_.Begin(); i != references_.End(); ++i)
+        (*i)->ReleaseRef();
+
+    commands_.Clear();
+    data_.Clear();
+    vertexBuffers_.Clear();
+    references_.Clear();
+    numPrimitives_ = 0;
+    numBatches_ = 0;
+}
+
+bool RenderCommandList::Suspend()
+{
+    if (!recording_)
+        return false;
+
+    Replay();
+    ClearCommands();
+    recording_ = false;
+    return true;
+}
+
+bool RenderCommandList::SuspendForEvent(Object* sender, StringHash eventType)
+{
+    if (!recording_)
+        return false;
+
+    EventReceiverGroup* group = context_->GetEventReceivers(sender, eventType);
+    if (!group || group->receivers_.Empty())
+        group = context_->GetEventReceivers(eventType);
+    return group && !group->receivers_.Empty() ? Suspend() : false;
+}
+
+void RenderCommandList::Clear(unsigned flags, const Color& color, float depth, unsigned stencil)
+{
+    if (!recording_)
+    {
+        graphics_->Clear(flags, color, depth, stencil);
+        return;
+    }
+
+    RecordedCommand& cmd = AddCommand(RCMD_CLEAR);
+    cmd.args_[0] = flags;
+    cmd.args_[1] = stencil;
+    float values[5] = { color.r_, color.g_, color.b_, color.a_, depth };
+    AddData(cmd, values, 5);
+}
+
+void RenderCommandList::ResolveToTexture(Texture2D* destination, const IntRect& viewport)
+{
+    if (!recording_)
+    {
+        graphics_->ResolveToTexture(destination, viewport);
+        return;
+    }
+
+    RecordedCommand& cmd = AddCommand(RCMD_RESOLVETOTEXTURE);
+    cmd.object_ = destination;
+    cmd.args_[0] = (unsigned)viewport.left_;
+    cmd.args_[1] = (unsigned)viewport.top_;
+    cmd.args_[2] = (unsigned)viewport.right_;
+    cmd.args_[3] = (unsigned)viewport.bottom_;
+    AddReference(destination);
+}
+
+void RenderCommandList::ResolveToTexture(Texture2D* texture)
+{
+    if (!recording_)
+    {
+        graphics_->ResolveToTexture(texture);
+        return;
+    }
+
+    AddCommand(RCMD_RESOLVETOTEXTURE2D).object_ = texture;
+    AddReference(texture);
+}
+
+void RenderCommandList::ResolveToTexture(TextureCube* texture)
+{
+    if (!recording_)
+    {
+        graphics_->ResolveToTexture(texture);
+        return;
+    }
+
+    AddCommand(RCMD_RESOLVETOTEXTURECUBE).object_ = texture;
+    AddReference(texture);
+}
+
+void RenderCommandList::Draw(PrimitiveType type, unsigned vertexStart, unsigned vertexCount)
+{
+    if (!recording_)
+    {
+        graphics_->Draw(type, vertexStart, vertexCount);
+        return;
+    }
+
+    if (!vertexCount)
+        return;
+
+    RecordedCommand& cmd = AddCommand(RCMD_DRAW);
+    cmd.args_[0] = type;
+    cmd.args_[1] = vertexStart;
+    cmd.args_[2] = vertexCount;
+    CountDraw(type, vertexCount, 1);
+}
+
+void RenderCommandList::Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned minVertex, unsigned vertexCount)
+{
+    if (!recording_)
+    {
+        graphics_->Draw(type, indexStart, indexCount, minVertex, vertexCount);
+        return;
+    }
+
+    if (!indexCount)
+        return;
+
+    RecordedCommand& cmd = AddCommand(RCMD_DRAWINDEXED);
+    cmd.args_[0] = type;
+    cmd.args_[1] = indexStart;
+    cmd.args_[2] = indexCount;
+    cmd.args_[3] = 0;
+    cmd.args_[4] = minVertex;
+    cmd.args_[5] = vertexCount;
+    cmd.args_[6] = 0;
+    CountDraw(type, indexCount, 1);
+}
+
+void RenderCommandList::Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned baseVertexIndex, unsigned minVertex,
+    unsigned vertexCount)
+{
+    if (!recording_)
+    {
+        graphics_->Draw(type, indexStart, indexCount, baseVertexIndex, minVertex, vertexCount);
+        return;
+    }
+
+    if (!indexCount)
+        return;
+
+    RecordedCommand& cmd = AddCommand(RCMD_DRAWINDEXED);
+    cmd.args_[0] = type;
+    cmd.args_[1] = indexStart;
+    cmd.args_[2] = indexCount;
+    cmd.args_[3] = baseVertexIndex;
+    cmd.args_[4] = minVertex;
+    cmd.args_[5] = vertexCount;
+    cmd.args_[6] = 1;
+    CountDraw(type, indexCount, 1);
+}
+
+void RenderCommandList::DrawInstanced(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned minVertex,
+    unsigned vertexCount, unsigned instanceCount)
+{
+    if (!recording_)
+    {
+        graphics_->DrawInstanced(type, indexStart, indexCount, minVertex, vertexCount, instanceCount);
+        return;
+    }
+
+    if (!indexCount || !instanceCount)
+        return;
+
+    RecordedCommand& cmd = AddCommand(RCMD_DRAWINSTANCED);
+    cmd.args_[0] = type;
+    cmd.args_[1] = indexStart;
+    cmd.args_[2] = indexCount;
+    cmd.args_[3] = 0;
+    cmd.args_[4] = minVertex;
+    cmd.args_[5] = vertexCount;
+    cmd.args_[6] = instanceCount;
+    cmd.args_[7] = 0;
+    CountDraw(type, indexCount, instanceCount);
+}
+
+void RenderCommandList::DrawInstanced(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned baseVertexIndex,
+    unsigned minVertex, unsigned vertexCount, unsigned instanceCount)
+{
+    if (!recording_)
+    {
+        graphics_->DrawInstanced(type, indexStart, indexCount, baseVertexIndex, minVertex, vertexCount, instanceCount);
+        return;
+    }
+
+    if (!indexCount || !instanceCount)
+        return;
+
+    RecordedCommand& cmd = AddCommand(RCMD_DRAWINSTANCED);
+    cmd.args_[0] = type;
+    cmd.args_[1] = indexStart;
+    cmd.args_[2] = indexCount;
+    cmd.args_[3] = baseVertexIndex;
+    cmd.args_[4] = minVertex;
+    cmd.args_[5] = vertexCount;
+    cmd.args_[6] = instanceCount;
+    cmd.args_[7] = 1;
+    CountDraw(type, indexCount, instanceCount);
+}
+
+void RenderCommandList::Draw(Geometry* geometry)
+{
+    if (!recording_)
+    {
+        geometry->Draw(graphics_);
+        return;
+    }
+
+    // Record the buffers and draw range as they are now, as the geometry may change before the replay
+    IndexBuffer* indexBuffer = geometry->GetIndexBuffer();
+    if (indexBuffer && geometry->GetIndexCount() > 0)
+    {
+        SetIndexBuffer(indexBuffer);
+        SetVertexBuffers(geometry->GetVertexBuffers());
+        Draw(geometry->GetPrimitiveType(), geometry->GetIndexStart(), geometry->GetIndexCount(), geometry->GetVertexStart(),
+            geometry->GetVertexCount());
+    }
+    else if (geometry->GetVertexCount() > 0)
+    {
+        SetVertexBuffers(geometry->GetVertexBuffers());
+        Draw(geometry->GetPrimitiveType(), geometry->GetVertexStart(), geometry->GetVertexCount());
+    }
+}
+
+void RenderCommandList::SetVertexBuffer(VertexBuffer* buffer)
+{
+    if (!recording_)
+    {
+        graphics_->SetVertexBuffer(buffer);
+        return;
+    }
+
+    RecordedCommand& cmd = AddCommand(RCMD_SETVERTEXBUFFERS);
+    cmd.args_[0] = vertexBuffers_.Size();
+    cmd.args_[1] = 1;
+    cmd.args_[2] = 0;
+    vertexBuffers_.Push(buffer);
+    AddReference(buffer);
+}
+
+void RenderCommandList::SetVertexBuffers(const PODVector<VertexBuffer*>& buffers, unsigned instanceOffset)
+{
+    if (!recording_)
+    {
+        graphics_->SetVertexBuffers(buffers, instanceOffset);
+        return;
+    }
+
+    RecordedCommand& cmd = AddCommand(RCMD_SETVERTEXBUFFERS);
+    cmd.args_[0] = vertexBuffers_.Size();
+    cmd.args_[1] = buffers.Size();
+    cmd.args_[2] = instanceOffset;
+    for (unsigned i = 0; i < buffers.Size(); ++i)
+    {
+        vertexBuffers_.Push(buffers[i]);
+        AddReference(buffers[i]);
+    }
+}
+
+void RenderCommandList::SetVertexBuffers(const Vector<SharedPtr<VertexBuffer> >& buffers, unsigned instanceOffset)
+{
+    if (!recording_)
+    {
+        graphics_->SetVertexBuffers(buffers, instanceOffset);
+        return;
+    }
+
+    RecordedCommand& cmd = AddCommand(RCMD_SETVERTEXBUFFERS);
+    cmd.args_[0] = vertexBuffers_.Size();
+    cmd.args_[1] = buffers.Size();
+    cmd.args_[2] = instanceOffset;
+    for (unsigned i = 0; i < buffers.Size(); ++i)
+    {
+        vertexBuffers_.Push(buffers[i].Get());
+        AddReference(buffers[i].Get());
+    }
+}
+
+void RenderCommandList::SetIndexBuffer(IndexBuffer* buffer)
+{
+    if (!recording_)
+    {
+        graphics_->SetIndexBuffer(buffer);
+        return;
+    }
+
+    AddCommand(RCMD_SETINDEXBUFFER).object_ = buffer;
+    AddReference(buffer);
+}
+
+void RenderCommandList::SetShaders(ShaderVariation* vs, ShaderVariation* ps)
+{
+    if (!recording_)
+    {
+        graphics_->SetShaders(vs, ps);
+        return;
+    }
+
+    if (vs == vertexShader_ && ps == pixelShader_)
+        return;
+
+    RecordedCommand& cmd = AddCommand(RCMD_SETSHADERS);
+    cmd.object_ = vs;
+    cmd.object2_ = ps;
+    AddReference(vs);
+    AddReference(ps);
+
+    // Track the shaders Graphics will end up using, and forget parameter sources like Graphics does on a shader change
+    vertexShader_ = PrepareShader(vs, VS);
+    pixelShader_ = PrepareShader(ps, PS);
+    for (unsigned i = 0; i < MAX_SHADER_PARAMETER_GROUPS; ++i)
+        shaderParameterSources_[i] = UNKNOWN_SOURCE;
+}
+
+void RenderCommandList::SetShaderParameter(StringHash param, const float* data, unsigned count)
+{
+    if (!recording_)
+        graphics_->SetShaderParameter(param, data, count);
+    else
+        AddShaderParameter(param, SPO_FLOATS, data, count);
+}
+
+void RenderCommandList::SetShaderParameter(StringHash param, float value)
+{
+    if (!recording_)
+        graphics_->SetShaderParameter(param, value);
+    else
+        AddShaderParameter(param, SPO_FLOAT, &value, 1);
+}
+
+void RenderCommandList::SetShaderParameter(StringHash param, int value)
+{
+    if (!recording_)
+    {
+        graphics_->SetShaderParameter(param, value);
+        return;
+    }
+
+    RecordedCommand& cmd = AddCommand(RCMD_SETSHADERPARAMETER);
+    cmd.args_[0] = param.Value();
+    cmd.args_[1] = SPO_INT;
+    cmd.args_[2] = (unsigned)value;
+}
+
+void RenderCommandList::SetShaderParameter(StringHash param, bool value)
+{
+    if (!recording_)
+    {
+        graphics_->SetShaderParameter(param, value);
+        return;
+    }
+
+    RecordedCommand& cmd = AddCommand(RCMD_SETSHADERPARAMETER);
+    cmd.args_[0] = param.Value();
+    cmd.args_[1] = SPO_BOOL;
+    cmd.args_[2] = value ? 1 : 0;
+}
+
+void RenderCommandList::SetShaderParameter(StringHash param, const Color& color)
+{
+    if (!recording_)
+        graphics_->SetShaderParameter(param, color);
+    else
+        AddShaderParameter(param, SPO_COLOR, color.Data(), 4);
+}
+
+void RenderCommandList::SetShaderParameter(StringHash param, const Vector2& vector)
+{
+    if (!recording_)
+        graphics_->SetShaderParameter(param, vector);
+    else
+        AddShaderParameter(param, SPO_VECTOR2, vector.Data(), 2);
+}
+
+void RenderCommandList::SetShaderParameter(StringHash param, const Matrix3& matrix)
+{
+    if (!recording_)
+        graphics_->SetShaderParameter(param, matrix);
+    else
+        AddShaderParameter(param, SPO_MATRIX3, matrix.Data(), 9);
+}
+
+void RenderCommandList::SetShaderParameter(StringHash param, const Vector3& vector)
+{
+    if (!recording_)
+        graphics_->SetShaderParameter(param, vector);
+    else
+        AddShaderParameter(param, SPO_VECTOR3, vector.Data(), 3);
+}
+
+void RenderCommandList::SetShaderParameter(StringHash param, const Matrix4& matrix)
+{
+    if (!recording_)
+        graphics_->SetShaderParameter(param, matrix);
+    else
+        AddShaderParameter(param, SPO_MATRIX4, matrix.Data(), 16);
+}
+
+void RenderCommandList::SetShaderParameter(StringHash param, const Vector4& vector)
+{
+    if (!recording_)
+        graphics_->SetShaderParameter(param, vector);
+    else
+        AddShaderParameter(param, SPO_VECTOR4, vector.Data(), 4);
+}
+
+void RenderCommandList::SetShaderParameter(StringHash param, const Matrix3x4& matrix)
+{
+    if (!recording_)
+        graphics_->SetShaderParameter(param, matrix);
+    else
+        AddShaderParameter(param, SPO_MATRIX3X4, matrix.Data(), 12);
+}
+
+void RenderCommandList::SetShaderParameter(StringHash param, const Variant& value)
+{
+    if (!recording_)
+    {
+        graphics_->SetShaderParameter(param, value);
+        return;
+    }
+
+    // Decompose into the typed overloads the same way Graphics does
+    switch (value.GetType())
+    {
+    case VAR_BOOL:
+        SetShaderParameter(param, value.GetBool());
+        break;
+
+    case VAR_INT:
+        SetShaderParameter(param, value.GetInt());
+        break;
+
+    case VAR_FLOAT:
+    case VAR_DOUBLE:
+        SetShaderParameter(param, value.GetFloat());
+        break;
+
+    case VAR_VECTOR2:
+        SetShaderParameter(param, value.GetVector2());
+        break;
+
+    case VAR_VECTOR3:
+        SetShaderParameter(param, value.GetVector3());
+        break;
+
+    case VAR_VECTOR4:
+        SetShaderParameter(param, value.GetVector4());
+        break;
+
+    case VAR_COLOR:
+        SetShaderParameter(param, value.GetColor());
+        break;
+
+    case VAR_MATRIX3:
+        SetShaderParameter(param, value.GetMatrix3());
+        break;
+
+    case VAR_MATRIX3X4:
+        SetShaderParameter(param, value.GetMatrix3x4());
+        break;
+
+    case VAR_MATRIX4:
+        SetShaderParameter(param, value.GetMatrix4());
+        break;
+
+    case VAR_BUFFER:
+        {
+            const PODVector<unsigned char>& buffer = value.GetBuffer();
+            if (buffer.Size() >= sizeof(float))
+                SetShaderParameter(param, reinterpret_cast<const float*>(&buffer[0]), buffer.Size() / sizeof(float));
+        }
+        break;
+
+    default:
+        // Unsupported parameter type, do nothing
+        break;
+    }
+}
+
+void RenderCommandList::SetShaderParameters(ShaderParameterBlock* block)
+{
+    if (!block)
+        return;
+
+    if (!recording_)
+    {
+        block->Apply(graphics_);
+        return;
+    }
+
+    RecordedCommand& cmd = AddCommand(RCMD_SETSHADERPARAMETERS);
+    cmd.object_ = block;
+    AddReference(block);
+}
+
+bool RenderCommandList::NeedParameterUpdate(ShaderParameterGroup group, const void* source)
+{
+    if (!recording_)
+        return graphics_->NeedParameterUpdate(group, source);
+
+    if (shaderParameterSources_[group] == UNKNOWN_SOURCE || shaderParameterSources_[group] != source)
+    {
+        shaderParameterSources_[group] = source;
+        return true;
+    }
+    else
+        return false;
+}
+
+bool RenderCommandList::HasShaderParameter(StringHash param)
+{
+    if (!recording_)
+        return graphics_->HasShaderParameter(param);
+
+    return vertexShader_ && pixelShader_ && (vertexShader_->HasParameter(param) || pixelShader_->HasParameter(param));
+}
+
+bool RenderCommandList::HasTextureUnit(TextureUnit unit)
+{
+    if (!recording_)
+        return graphics_->HasTextureUnit(unit);
+
+    return pixelShader_ && pixelShader_->HasTextureUnit(unit);
+}
+
+void RenderCommandList::ClearParameterSource(ShaderParameterGroup group)
+{
+    if (!recording_)
+    {
+        graphics_->ClearParameterSource(group);
+        return;
+    }
+
+    AddCommand(RCMD_CLEARPARAMETERSOURCE).args_[0] = group;
+    shaderParameterSources_[group] = UNKNOWN_SOURCE;
+}
+
+void RenderCommandList::ClearParameterSources()
+{
+    if (!recording_)
+    {
+        graphics_->ClearParameterSources();
+        return;
+    }
+
+    AddCommand(RCMD_CLEARPARAMETERSOURCES);
+    for (unsigned i = 0; i < MAX_SHADER_PARAMETER_GROUPS; ++i)
+        shaderParameterSources_[i] = UNKNOWN_SOURCE;
+}
+
+void RenderCommandList::ClearTransformSources()
+{
+    if (!recording_)
+    {
+        graphics_->ClearTransformSources();
+        return;
+    }
+
+    AddCommand(RCMD_CLEARTRANSFORMSOURCES);
+    shaderParameterSources_[SP_CAMERA] = UNKNOWN_SOURCE;
+    shaderParameterSources_[SP_OBJECT] = UNKNOWN_SOURCE;
+}
+
+void RenderCommandList::SetTexture(unsigned index, Texture* texture)
+{
+    if (!recording_)
+    {
+        graphics_->SetTexture(index, texture);
+        return;
+    }
+
+    if (index >= MAX_TEXTURE_UNITS)
+        return;
+
+    RecordedCommand& cmd = AddCommand(RCMD_SETTEXTURE);
+    cmd.object_ = texture;
+    cmd.args_[0] = index;
+    AddReference(texture);
+}
+
+void RenderCommandList::ResetRenderTargets()
+{
+    if (!recording_)
+    {
+        graphics_->ResetRenderTargets();
+        return;
+    }
+
+    AddCommand(RCMD_RESETRENDERTARGETS);
+    for (unsigned i = 0; i < MAX_RENDERTARGETS; ++i)
+        renderTargets_[i] = 0;
+    depthStencil_ = 0;
+    viewport_ = IntRect(0, 0, graphics_->GetWidth(), graphics_->GetHeight());
+}
+
+void RenderCommandList::SetRenderTarget(unsigned index, RenderSurface* renderTarget)
+{
+    if (!recording_)
+    {
+        graphics_->SetRenderTarget(index, renderTarget);
+        return;
+    }
+
+    if (index >= MAX_RENDERTARGETS || (renderTarget && renderTarget->GetUsage() != TEXTURE_RENDERTARGET))
+        return;
+
+    RecordedCommand& cmd = AddCommand(RCMD_SETRENDERTARGET);
+    cmd.object_ = renderTarget;
+    cmd.args_[0] = index;
+    AddReference(renderTarget);
+
+    if (renderTarget != renderTargets_[index])
+    {
+        renderTargets_[index] = renderTarget;
+        // Setting the first rendertarget causes viewport to be reset
+        if (!index)
+        {
+            IntVector2 rtSize = GetRenderTargetDimensions();
+            viewport_ = IntRect(0, 0, rtSize.x_, rtSize.y_);
+        }
+    }
+}
+
+void RenderCommandList::SetRenderTarget(unsigned index, Texture2D* texture)
+{
+    SetRenderTarget(index, texture ? texture->GetRenderSurface() : (RenderSurface*)0);
+}
+
+void RenderCommandList::SetDepthStencil(RenderSurface* depthStencil)
+{
+    if (!recording_)
+    {
+        graphics_->SetDepthStencil(depthStencil);
+        return;
+    }
+
+    AddCommand(RCMD_SETDEPTHSTENCIL).object_ = depthStencil;
+    AddReference(depthStencil);
+    depthStencil_ = depthStencil;
+}
+
+void RenderCommandList::SetDepthStencil(Texture2D* texture)
+{
+    SetDepthStencil(texture ? texture->GetRenderSurface() : (RenderSurface*)0);
+}
+
+void RenderCommandList::SetViewport(const IntRect& rect)
+{
+    if (!recording_)
+    {
+        graphics_->SetViewport(rect);
+        return;
+    }
+
+    RecordedCommand& cmd = AddCommand(RCMD_SETVIEWPORT);
+    cmd.args_[0] = (unsigned)rect.left_;
+    cmd.args_[1] = (unsigned)rect.top_;
+    cmd.args_[2] = (unsigned)rect.right_;
+    cmd.args_[3] = (unsigned)rect.bottom_;
+
+    // Clamp to the rendertarget the same way Graphics does
+    IntVector2 size = GetRenderTargetDimensions();
+    IntRect rectCopy = rect;
+    if (rectCopy.right_ <= rectCopy.left_)
+        rectCopy.right_ = rectCopy.left_ + 1;
+    if (rectCopy.bottom_ <= rectCopy.top_)
+        rectCopy.bottom_ = rectCopy.top_ + 1;
+    rectCopy.left_ = Clamp(rectCopy.left_, 0, size.x_);
+    rectCopy.top_ = Clamp(rectCopy.top_, 0, size.y_);
+    rectCopy.right_ = Clamp(rectCopy.right_, 0, size.x_);
+    rectCopy.bottom_ = Clamp(rectCopy.bottom_, 0, size.y_);
+    viewport_ = rectCopy;
+}
+
+void RenderCommandList::SetBlendMode(BlendMode mode, bool alphaToCoverage)
+{
+    if (!recording_)
+    {
+        graphics_->SetBlendMode(mode, alphaToCoverage);
+        return;
+    }
+
+    RecordedCommand& cmd = AddCommand(RCMD_SETBLENDMODE);
+    cmd.args_[0] = mode;
+    cmd.args_[1] = alphaToCoverage ? 1 : 0;
+    blendMode_ = mode;
+}
+
+void RenderCommandList::SetColorWrite(bool enable)
+{
+    if (!recording_)
+        graphics_->SetColorWrite(enable);
+    else
+        AddCommand(RCMD_SETCOLORWRITE).args_[0] = enable ? 1 : 0;
+}
+
+void RenderCommandList::SetCullMode(CullMode mode)
+{
+    if (!recording_)
+        graphics_->SetCullMode(mode);
+    else
+        AddCommand(RCMD_SETCULLMODE).args_[0] = mode;
+}
+
+void RenderCommandList::SetDepthBias(float constantBias, float slopeScaledBias)
+{
+    if (!recording_)
+    {
+        graphics_->SetDepthBias(constantBias, slopeScaledBias);
+        return;
+    }
+
+    float values[2] = { constantBias, slopeScaledBias };
+    AddData(AddCommand(RCMD_SETDEPTHBIAS), values, 2);
+}
+
+void RenderCommandList::SetDepthTest(CompareMode mode)
+{
+    if (!recording_)
+        graphics_->SetDepthTest(mode);
+    else
+        AddCommand(RCMD_SETDEPTHTEST).args_[0] = mode;
+}
+
+void RenderCommandList::SetDepthWrite(bool enable)
+{
+    if (!recording_)
+        graphics_->SetDepthWrite(enable);
+    else
+        AddCommand(RCMD_SETDEPTHWRITE).args_[0] = enable ? 1 : 0;
+}
+
+void RenderCommandList::SetFillMode(FillMode mode)
+{
+    if (!recording_)
+        graphics_->SetFillMode(mode);
+    else
+        AddCommand(RCMD_SETFILLMODE).args_[0] = mode;
+}
+
+void RenderCommandList::SetLineAntiAlias(bool enable)
+{
+    if (!recording_)
+        graphics_->SetLineAntiAlias(enable);
+    else
+        AddCommand(RCMD_SETLINEANTIALIAS).args_[0] = enable ? 1 : 0;
+}
+
+void RenderCommandList::SetScissorTest(bool enable, const Rect& rect, bool borderInclusive)
+{
+    if (!recording_)
+    {
+        graphics_->SetScissorTest(enable, rect, borderInclusive);
+        return;
+    }
+
+    RecordedCommand& cmd = AddCommand(RCMD_SETSCISSORTEST);
+    cmd.args_[0] = enable ? 1 : 0;
+    cmd.args_[1] = borderInclusive ? 1 : 0;
+    float values[4] = { rect.min_.x_, rect.min_.y_, rect.max_.x_, rect.max_.y_ };
+    AddData(cmd, values, 4);
+}
+
+void RenderCommandList::SetScissorTest(bool enable, const IntRect& rect)
+{
+    if (!recording_)
+    {
+        graphics_->SetScissorTest(enable, rect);
+        return;
+    }
+
+    RecordedCommand& cmd = AddCommand(RCMD_SETSCISSORRECT);
+    cmd.args_[0] = enable ? 1 : 0;
+    cmd.args_[1] = (unsigned)rect.left_;
+    cmd.args_[2] = (unsigned)rect.top_;
+    cmd.args_[3] = (unsigned)rect.right_;
+    cmd.args_[4] = (unsigned)rect.bottom_;
+}
+
+void RenderCommandList::SetStencilTest(bool enable, CompareMode mode, StencilOp pass, StencilOp fail, StencilOp zFail,
+    unsigned stencilRef, unsigned compareMask, unsigned writeMask)
+{
+    if (!recording_)
+    {
+        graphics_->SetStencilTest(enable, mode, pass, fail, zFail, stencilRef, compareMask, writeMask);
+        return;
+    }
+
+    RecordedCommand& cmd = AddCommand(RCMD_SETSTENCILTEST);
+    cmd.args_[0] = enable ? 1 : 0;
+    cmd.args_[1] = mode;
+    cmd.args_[2] = pass;
+    cmd.args_[3] = fail;
+    cmd.args_[4] = zFail;
+    cmd.args_[5] = stencilRef;
+    cmd.args_[6] = compareMask;
+    cmd.args_[7] = writeMask;
+}
+
+void RenderCommandList::SetClipPlane(bool enable, const Plane& clipPlane, const Matrix3x4& view, const Matrix4& projection)
+{
+    if (!recording_)
+    {
+        graphics_->SetClipPlane(enable, clipPlane, view, projection);
+        return;
+    }
+
+    RecordedCommand& cmd = AddCommand(RCMD_SETCLIPPLANE);
+    cmd.args_[0] = enable ? 1 : 0;
+    if (enable)
+    {
+        float values[32];
+        Vector4 plane = clipPlane.ToVector4();
+        memcpy(values, plane.Data(), 4 * sizeof(float));
+        memcpy(values + 4, view.Data(), 12 * sizeof(float));
+        memcpy(values + 16, projection.Data(), 16 * sizeof(float));
+        AddData(cmd, values, 32);
+    }
+}
+
+void RenderCommandList::SetClipPlane(bool enable)
+{
+    if (!recording_)
+        graphics_->SetClipPlane(enable);
+    else
+        SetClipPlane(enable, Plane::UP, Matrix3x4::IDENTITY, Matrix4::IDENTITY);
+}
+
+RenderSurface* RenderCommandList::GetRenderTarget(unsigned index) const
+{
+    if (!recording_)
+        return graphics_->GetRenderTarget(index);
+
+    return index < MAX_RENDERTARGETS ? renderTargets_[index] : (RenderSurface*)0;
+}
+
+RenderSurface* RenderCommandList::GetDepthStencil() const
+{
+    return recording_ ? depthStencil_ : graphics_->GetDepthStencil();
+}
+
+IntRect RenderCommandList::GetViewport() const
+{
+    return recording_ ? viewport_ : graphics_->GetViewport();
+}
+
+BlendMode RenderCommandList::GetBlendMode() const
+{
+    return recording_ ? blendMode_ : graphics_->GetBlendMode();
+}
+
+IntVector2 RenderCommandList::GetRenderTargetDimensions() const
+{
+    if (!recording_)
+        return graphics_->GetRenderTargetDimensions();
+
+    if (renderTargets_[0])
+        return IntVector2(renderTargets_[0]->GetWidth(), renderTargets_[0]->GetHeight());
+    else if (depthStencil_)
+        return IntVector2(depthStencil_->GetWidth(), depthStencil_->GetHeight());
+    else
+        return IntVector2(graphics_->GetWidth(), graphics_->GetHeight());
+}
+
+void RenderCommandList::SyncState()
+{
+    vertexShader_ = graphics_->GetVertexShader();
+    pixelShader_ = graphics_->GetPixelShader();
+    for (unsigned i = 0; i < MAX_SHADER_PARAMETER_GROUPS; ++i)
+        shaderParameterSources_[i] = UNKNOWN_SOURCE;
+    for (unsigned i = 0; i < MAX_RENDERTARGETS; ++i)
+        renderTargets_[i] = graphics_->GetRenderTarget(i);
+    depthStencil_ = graphics_->GetDepthStencil();
+    viewport_ = graphics_->GetViewport();
+    blendMode_ = graphics_->GetBlendMode();
+
+    // Graphics keeps using these until the replay changes them, so they must stay alive as well
+    AddReference(vertexShader_);
+    AddReference(pixelShader_);
+    AddReference(graphics_->GetIndexBuffer());
+    for (unsigned i = 0; i < MAX_VERTEX_STREAMS; ++i)
+        AddReference(graphics_->GetVertexBuffer(i));
+    for (unsigned i = 0; i < MAX_TEXTURE_UNITS; ++i)
+        AddReference(graphics_->GetTexture(i));
+    for (unsigned i = 0; i < MAX_RENDERTARGETS; ++i)
+        AddReference(renderTargets_[i]);
+    AddReference(depthStencil_);
+}
+
+RecordedCommand& RenderCommandList::AddCommand(RecordedCommandType type)
+{
+    commands_.Resize(commands_.Size() + 1);
+    RecordedCommand& cmd = commands_.Back();
+    cmd.type_ = type;
+    cmd.object_ = 0;
+    cmd.object2_ = 0;
+    cmd.dataStart_ = data_.Size();
+    return cmd;
+}
+
+void RenderCommandList::AddData(RecordedCommand& command, const float* data, unsigned count)
+{
+    command.dataStart_ = data_.Size();
+    data_.Resize(command.dataStart_ + count);
+    memcpy(&data_[command.dataStart_], data, count * sizeof(float));
+}
+
+void RenderCommandList::AddShaderParameter(StringHash param, unsigned overload, const float* data, unsigned count)
+{
+    RecordedCommand& cmd = AddCommand(RCMD_SETSHADERPARAMETER);
+    cmd.args_[0] = param.Value();
+    cmd.args_[1] = overload;
+    cmd.args_[2] = count;
+    AddData(cmd, data, count);
+}
+
+void RenderCommandList::AddReference(RefCounted* object)
+{
+    if (object)
+    {
+        object->AddRef();
+        references_.Push(object);
+    }
+}
+
+void RenderCommandList::AddReference(RenderSurface* surface)
+{
+    if (surface)
+    {
+        AddReference(static_cast<RefCounted*>(surface));
+        AddReference(surface->GetParentTexture());
+    }
+}
+
+void RenderCommandList::CountDraw(PrimitiveType type, unsigned elementCount, unsigned instanceCount)
+{
+    numPrimitives_ += GetPrimitiveCount(type, elementCount) * instanceCount;
+    ++numBatches_;
+}
+
+RenderSubmitThread::RenderSubmitThread() :
+    pending_(0),
+    replaying_(0)
+{
+}
+
+RenderSubmitThread::~RenderSubmitThread()
+{
+    Wait();
+    Stop();
+}
+
+void RenderSubmitThread::ThreadFunction()
+{
+    while (shouldRun_)
+    {
+        submitMutex_.Acquire();
+        RenderCommandList* commandList = replaying_ = pending_;
+        pending_ = 0;
+        submitMutex_.Release();
+
+        if (commandList)
+        {
+            commandList->Replay();
+
+            MutexLock lock(submitMutex_);
+            replaying_ = 0;
+        }
+        else
+            Time::Sleep(1);
+    }
+}
+
+void RenderSubmitThread::Submit(RenderCommandList* commandList)
+{
+    MutexLock lock(submitMutex_);
+    pending_ = commandList;
+}
+
+void RenderSubmitThread::Wait()
+{
+    for (;;)
+    {
+        submitMutex_.Acquire();
+        RenderCommandList* commandList = pending_;
+        bool replaying = replaying_ != 0;
+        pending_ = 0;
+        submitMutex_.Release();
+
+        // If the thread has not picked up the command list yet, it is faster to replay it here than to wait
+        if (commandList)
+        {
+            commandList->Replay();
+            return;
+        }
+        if (!replaying)
+            return;
+
+        Time::Sleep(0);
+    }
+}
+
+}
@@ -0,0 +1,340 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../../Container/Ptr.h"
+#include "../../Core/Mutex.h"
+#include "../../Core/Object.h"
+#include "../../Core/Thread.h"
+#include "../../Graphics/GraphicsDefs.h"
+#include "../../Math/Color.h"
+#include "../../Math/Rect.h"
+
+namespace Urho3D
+{
+
+class Geometry;
+class Graphics;
+class IndexBuffer;
+class Matrix3;
+class Matrix3x4;
+class Matrix4;
+class Plane;
+class RenderSurface;
+class ShaderParameterBlock;
+class ShaderVariation;
+class Texture;
+class Texture2D;
+class TextureCube;
+class Variant;
+class VertexBuffer;
+
+/// Recorded render command type.
+enum RecordedCommandType
+{
+    RCMD_CLEAR = 0,
+    RCMD_RESOLVETOTEXTURE,
+    RCMD_RESOLVETOTEXTURE2D,
+    RCMD_RESOLVETOTEXTURECUBE,
+    RCMD_DRAW,
+    RCMD_DRAWINDEXED,
+    RCMD_DRAWINSTANCED,
+    RCMD_SETVERTEXBUFFERS,
+    RCMD_SETINDEXBUFFER,
+    RCMD_SETSHADERS,
+    RCMD_SETSHADERPARAMETER,
+    RCMD_SETSHADERPARAMETERS,
+    RCMD_CLEARPARAMETERSOURCE,
+    RCMD_CLEARPARAMETERSOURCES,
+    RCMD_CLEARTRANSFORMSOURCES,
+    RCMD_SETTEXTURE,
+    RCMD_RESETRENDERTARGETS,
+    RCMD_SETRENDERTARGET,
+    RCMD_SETDEPTHSTENCIL,
+    RCMD_SETVIEWPORT,
+    RCMD_SETBLENDMODE,
+    RCMD_SETCOLORWRITE,
+    RCMD_SETCULLMODE,
+    RCMD_SETDEPTHBIAS,
+    RCMD_SETDEPTHTEST,
+    RCMD_SETDEPTHWRITE,
+    RCMD_SETFILLMODE,
+    RCMD_SETLINEANTIALIAS,
+    RCMD_SETSCISSORTEST,
+    RCMD_SETSCISSORRECT,
+    RCMD_SETSTENCILTEST,
+    RCMD_SETCLIPPLANE
+};
+
+/// Recorded render command. Values that do not fit the integer arguments are stored in the command list's float data.
+struct RecordedCommand
+{
+    /// Command type.
+    RecordedCommandType type_;
+    /// Object argument: texture, rendersurface, buffer or shader.
+    void* object_;
+    /// Second object argument.
+    void* object2_;
+    /// Integer arguments.
+    unsigned args_[8];
+    /// Start offset of the command's float data.
+    unsigned dataStart_;
+};
+
+/// %Render command list. Either forwards rendering calls to Graphics immediately, or records them for a later replay, which may happen on the render submission thread. While recording, the state queries needed by view rendering are answered from state tracked by the list.
+class URHO3D_API RenderCommandList : public Object
+{
+    URHO3D_OBJECT(RenderCommandList, Object);
+
+public:
+    /// Construct.
+    RenderCommandList(Context* context);
+    /// Destruct.
+    virtual ~RenderCommandList();
+
+    /// Begin recording. The tracked state is initialized from Graphics, so the previously recorded commands must have been replayed.
+    void BeginRecording();
+    /// End recording. The recorded commands are kept until replayed and cleared.
+    void EndRecording();
+    /// Replay the recorded commands to Graphics. Does not modify the list, so can be called from the render submission thread.
+    void Replay();
+    /// Clear the recorded commands and release the resources they refer to. Must be called from the main thread.
+    void ClearCommands();
+    /// Replay and clear the commands recorded so far and forward further calls to Graphics immediately, so that code rendering to Graphics directly can run. Recording is continued with BeginRecording(). Return true if was recording.
+    bool Suspend();
+    /// Suspend if an event has receivers, which may render to Graphics directly. Return true if suspended.
+    bool SuspendForEvent(Object* sender, StringHash eventType);
+
+    /// Clear any or all of rendertarget, depth buffer and stencil buffer.
+    void Clear(unsigned flags, const Color& color = Color(0.0f, 0.0f, 0.0f, 0.0f), float depth = 1.0f, unsigned stencil = 0);
+    /// Resolve multisampled backbuffer to a texture rendertarget.
+    void ResolveToTexture(Texture2D* destination, const IntRect& viewport);
+    /// Resolve a multisampled texture on itself.
+    void ResolveToTexture(Texture2D* texture);
+    /// Resolve a multisampled cube texture on itself.
+    void ResolveToTexture(TextureCube* texture);
+    /// Draw non-indexed geometry.
+    void Draw(PrimitiveType type, unsigned vertexStart, unsigned vertexCount);
+    /// Draw indexed geometry.
+    void Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned minVertex, unsigned vertexCount);
+    /// Draw indexed geometry with vertex index offset.
+    void Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned baseVertexIndex, unsigned minVertex, unsigned vertexCount);
+    /// Draw indexed, instanced geometry. An instancing vertex buffer must be set.
+    void DrawInstanced(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned minVertex, unsigned vertexCount,
+        unsigned instanceCount);
+    /// Draw indexed, instanced geometry with vertex index offset.
+    void DrawInstanced(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned baseVertexIndex, unsigned minVertex,
+        unsigned vertexCount, unsigned instanceCount);
+    /// Draw a geometry using its current buffers and draw range.
+    void Draw(Geometry* geometry);
+    /// Set vertex buffer.
+    void SetVertexBuffer(VertexBuffer* buffer);
+    /// Set multiple vertex buffers.
+    void SetVertexBuffers(const PODVector<VertexBuffer*>& buffers, unsigned instanceOffset = 0);
+    /// Set multiple vertex buffers.
+    void SetVertexBuffers(const Vector<SharedPtr<VertexBuffer> >& buffers, unsigned instanceOffset = 0);
+    /// Set index buffer.
+    void SetIndexBuffer(IndexBuffer* buffer);
+    /// Set shaders.
+    void SetShaders(ShaderVariation* vs, ShaderVariation* ps);
+    /// Set shader float constants.
+    void SetShaderParameter(StringHash param, const float* data, unsigned count);
+    /// Set shader float constant.
+    void SetShaderParameter(StringHash param, float value);
+    /// Set shader integer constant.
+    void SetShaderParameter(StringHash param, int value);
+    /// Set shader boolean constant.
+    void SetShaderParameter(StringHash param, bool value);
+    /// Set shader color constant.
+    void SetShaderParameter(StringHash param, const Color& color);
+    /// Set shader 2D vector constant.
+    void SetShaderParameter(StringHash param, const Vector2& vector);
+    /// Set shader 3x3 matrix constant.
+    void SetShaderParameter(StringHash param, const Matrix3& matrix);
+    /// Set shader 3D vector constant.
+    void SetShaderParameter(StringHash param, const Vector3& vector);
+    /// Set shader 4x4 matrix constant.
+    void SetShaderParameter(StringHash param, const Matrix4& matrix);
+    /// Set shader 4D vector constant.
+    void SetShaderParameter(StringHash param, const Vector4& vector);
+    /// Set shader 3x4 matrix constant.
+    void SetShaderParameter(StringHash param, const Matrix3x4& matrix);
+    /// Set shader constant from a variant. Supported variant types are bool, float, vector2, vector3, vector4, color and buffer.
+    void SetShaderParameter(StringHash param, const Variant& value);
+    /// Set all shader constants of a parameter block. While recording, the block is referenced until the commands are cleared.
+    void SetShaderParameters(ShaderParameterBlock* block);
+    /// Check whether a shader parameter group needs update. While recording, the answer may be conservative, which only causes redundant parameter updates.
+    bool NeedParameterUpdate(ShaderParameterGroup group, const void* source);
+    /// Check whether the current shader program uses a shader parameter. While recording, may return true if not known yet.
+    bool HasShaderParameter(StringHash param);
+    /// Check whether the current pixel shader uses a texture unit. While recording, may return true if not known yet.
+    bool HasTextureUnit(TextureUnit unit);
+    /// Clear remembered shader parameter source for a group.
+    void ClearParameterSource(ShaderParameterGroup group);
+    /// Clear remembered shader parameter sources.
+    void ClearParameterSources();
+    /// Clear remembered transform shader parameter sources.
+    void ClearTransformSources();
+    /// Set texture.
+    void SetTexture(unsigned index, Texture* texture);
+    /// Reset all rendertargets, depth-stencil surface and viewport.
+    void ResetRenderTargets();
+    /// Set rendertarget.
+    void SetRenderTarget(unsigned index, RenderSurface* renderTarget);
+    /// Set rendertarget.
+    void SetRenderTarget(unsigned index, Texture2D* texture);
+    /// Set depth-stencil surface.
+    void SetDepthStencil(RenderSurface* depthStencil);
+    /// Set depth-stencil surface.
+    void SetDepthStencil(Texture2D* texture);
+    /// Set viewport.
+    void SetViewport(const IntRect& rect);
+    /// Set blending and alpha-to-coverage modes. Alpha-to-coverage is not supported on Direct3D9.
+    void SetBlendMode(BlendMode mode, bool alphaToCoverage = false);
+    /// Set color write on/off.
+    void SetColorWrite(bool enable);
+    /// Set hardware culling mode.
+    void SetCullMode(CullMode mode);
+    /// Set depth bias.
+    void SetDepthBias(float constantBias, float slopeScaledBias);
+    /// Set depth compare.
+    void SetDepthTest(CompareMode mode);
+    /// Set depth write on/off.
+    void SetDepthWrite(bool enable);
+    /// Set polygon fill mode.
+    void SetFillMode(FillMode mode);
+    /// Set line antialiasing on/off.
+    void SetLineAntiAlias(bool enable);
+    /// Set scissor test.
+    void SetScissorTest(bool enable, const Rect& rect = Rect::FULL, bool borderInclusive = true);
+    /// Set scissor test.
+    void SetScissorTest(bool enable, const IntRect& rect);
+    /// Set stencil test.
+    void SetStencilTest
+        (bool enable, CompareMode mode = CMP_ALWAYS, StencilOp pass = OP_KEEP, StencilOp fail = OP_KEEP, StencilOp zFail = OP_KEEP,
+            unsigned stencilRef = 0, unsigned compareMask = M_MAX_UNSIGNED, unsigned writeMask = M_MAX_UNSIGNED);
+    /// Set a custom clipping plane. The plane is specified in world space, but is dependent on the view and projection matrices.
+    void SetClipPlane(bool enable, const Plane& clipPlane, const Matrix3x4& view, const Matrix4& projection);
+    /// Disable the custom clipping plane.
+    void SetClipPlane(bool enable);
+
+    /// Return whether is recording.
+    bool IsRecording() const { return recording_; }
+
+    /// Return number of recorded commands waiting for replay.
+    unsigned GetNumCommands() const { return commands_.Size(); }
+
+    /// Return number of primitives in the recorded draw calls.
+    unsigned GetNumPrimitives() const { return numPrimitives_; }
+
+    /// Return number of recorded draw calls.
+    unsigned GetNumBatches() const { return numBatches_; }
+
+    /// Return rendertarget by index.
+    RenderSurface* GetRenderTarget(unsigned index) const;
+    /// Return depth-stencil surface.
+    RenderSurface* GetDepthStencil() const;
+    /// Return the viewport.
+    IntRect GetViewport() const;
+    /// Return blending mode.
+    BlendMode GetBlendMode() const;
+    /// Return the current rendertarget width and height.
+    IntVector2 GetRenderTargetDimensions() const;
+
+private:
+    /// Initialize the tracked state from Graphics and reference the resources Graphics currently uses.
+    void SyncState();
+    /// Add a command and return it for filling in the arguments.
+    RecordedCommand& AddCommand(RecordedCommandType type);
+    /// Copy float data for the last added command.
+    void AddData(RecordedCommand& command, const float* data, unsigned count);
+    /// Record a shader parameter of the given Graphics overload.
+    void AddShaderParameter(StringHash param, unsigned overload, const float* data, unsigned count);
+    /// Keep a resource alive until the commands have been replayed.
+    void AddReference(RefCounted* object);
+    /// Keep a rendersurface and its parent texture alive until the commands have been replayed.
+    void AddReference(RenderSurface* surface);
+    /// Record the draw call count and primitive count of a draw.
+    void CountDraw(PrimitiveType type, unsigned elementCount, unsigned instanceCount);
+
+    /// Graphics subsystem.
+    WeakPtr<Graphics> graphics_;
+    /// Recorded commands.
+    PODVector<RecordedCommand> commands_;
+    /// Float data of the recorded commands.
+    PODVector<float> data_;
+    /// Vertex buffer lists of the recorded commands.
+    PODVector<VertexBuffer*> vertexBuffers_;
+    /// Scratch vertex buffer list for replay.
+    PODVector<VertexBuffer*> replayVertexBuffers_;
+    /// Resources referenced by the recorded commands. Released in ClearCommands().
+    PODVector<RefCounted*> references_;
+    /// Tracked vertex shader.
+    ShaderVariation* vertexShader_;
+    /// Tracked pixel shader.
+    ShaderVariation* pixelShader_;
+    /// Tracked shader parameter sources.
+    const void* shaderParameterSources_[MAX_SHADER_PARAMETER_GROUPS];
+    /// Tracked rendertargets.
+    RenderSurface* renderTargets_[MAX_RENDERTARGETS];
+    /// Tracked depth-stencil surface.
+    RenderSurface* depthStencil_;
+    /// Tracked viewport.
+    IntRect viewport_;
+    /// Tracked blending mode.
+    BlendMode blendMode_;
+    /// Primitives in the recorded draw calls.
+    unsigned numPrimitives_;
+    /// Recorded draw calls.
+    unsigned numBatches_;
+    /// Recording flag.
+    bool recording_;
+};
+
+/// %Render submission thread. Replays one recorded command list at a time while the main thread continues with the next frame.
+class URHO3D_API RenderSubmitThread : public RefCounted, public Thread
+{
+public:
+    /// Construct. Does not start the thread yet.
+    RenderSubmitThread();
+    /// Destruct. Wait for the submission in progress and stop the thread.
+    ~RenderSubmitThread();
+
+    /// Submission loop.
+    virtual void ThreadFunction();
+
+    /// Queue a command list for replay. The previous submission must have been waited for.
+    void Submit(RenderCommandList* commandList);
+    /// Wait until the submitted command list has been replayed. If the thread has not started on it yet, replay it on the calling thread instead.
+    void Wait();
+
+private:
+    /// Mutex for the submission state.
+    Mutex submitMutex_;
+    /// Command list waiting for replay.
+    RenderCommandList* pending_;
+    /// Command list being replayed.
+    RenderCommandList* replaying_;
+};
+
+}
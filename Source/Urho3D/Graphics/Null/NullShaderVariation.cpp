@@ -0,0 +1,431 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../../Precompiled.h"
+
+#include "../../Graphics/Graphics.h"
+#include "../../Graphics/GraphicsImpl.h"
+#include "../../Graphics/Shader.h"
+#include "../../Graphics/ShaderVariation.h"
+#include "../../IO/Log.h"
+
+#include <cctype>
+
+#include "../../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Result of evaluating a preprocessor condition. Conditions that depend on macro values are unknown.
+enum ConditionResult
+{
+    CONDITION_FALSE = 0,
+    CONDITION_TRUE,
+    CONDITION_UNKNOWN
+};
+
+/// Conditional block state of the shader source scan.
+struct ConditionalBlock
+{
+    /// Enclosing block active flag.
+    bool parentActive_;
+    /// Current branch active flag.
+    bool active_;
+    /// A branch has been taken for certain.
+    bool taken_;
+};
+
+static void SkipSpace(const char*& pos)
+{
+    while (*pos == ' ' || *pos == '\t')
+        ++pos;
+}
+
+static String ReadIdentifier(const char*& pos)
+{
+    const char* start = pos;
+    while (isalnum((unsigned char)*pos) || *pos == '_')
+        ++pos;
+    return String(start, (unsigned)(pos - start));
+}
+
+static ConditionResult EvaluateOr(const char*& pos, const HashMap<String, String>& defines);
+
+static ConditionResult EvaluateUnary(const char*& pos, const HashMap<String, String>& defines)
+{
+    SkipSpace(pos);
+
+    if (*pos == '!' && pos[1] != '=')
+    {
+        ++pos;
+        ConditionResult result = EvaluateUnary(pos, defines);
+        return result == CONDITION_UNKNOWN ? result : (result == CONDITION_TRUE ? CONDITION_FALSE : CONDITION_TRUE);
+    }
+
+    if (*pos == '(')
+    {
+        ++pos;
+        ConditionResult result = EvaluateOr(pos, defines);
+        SkipSpace(pos);
+        if (*pos == ')')
+            ++pos;
+        return result;
+    }
+
+    if (!strncmp(pos, "defined", 7) && !isalnum((unsigned char)pos[7]) && pos[7] != '_')
+    {
+        pos += 7;
+        SkipSpace(pos);
+        bool paren = *pos == '(';
+        if (paren)
+            ++pos;
+        SkipSpace(pos);
+        String name = ReadIdentifier(pos);
+        SkipSpace(pos);
+        if (paren && *pos == ')')
+            ++pos;
+        return defines.Contains(name) ? CONDITION_TRUE : CONDITION_FALSE;
+    }
+
+    // Macro values and comparisons are not evaluated
+    while (*pos && *pos != ')' && strncmp(pos, "&&", 2) && strncmp(pos, "||", 2))
+        ++pos;
+    return CONDITION_UNKNOWN;
+}
+
+static ConditionResult EvaluateAnd(const char*& pos, const HashMap<String, String>& defines)
+{
+    ConditionResult result = EvaluateUnary(pos, defines);
+    for (;;)
+    {
+        SkipSpace(pos);
+        if (strncmp(pos, "&&", 2))
+            return result;
+        pos += 2;
+        ConditionResult rhs = EvaluateUnary(pos, defines);
+        if (result == CONDITION_FALSE || rhs == CONDITION_FALSE)
+            result = CONDITION_FALSE;
+        else if (result == CONDITION_UNKNOWN || rhs == CONDITION_UNKNOWN)
+            result = CONDITION_UNKNOWN;
+    }
+}
+
+static ConditionResult EvaluateOr(const char*& pos, const HashMap<String, String>& defines)
+{
+    ConditionResult result = EvaluateAnd(pos, defines);
+    for (;;)
+    {
+        SkipSpace(pos);
+        if (strncmp(pos, "||", 2))
+            return result;
+        pos += 2;
+        ConditionResult rhs = EvaluateAnd(pos, defines);
+        if (result == CONDITION_TRUE || rhs == CONDITION_TRUE)
+            result = CONDITION_TRUE;
+        else if (result == CONDITION_UNKNOWN || rhs == CONDITION_UNKNOWN)
+            result = CONDITION_UNKNOWN;
+    }
+}
+
+static unsigned EvaluateArraySize(const String& expression, const HashMap<String, String>& defines)
+{
+    unsigned size = 1;
+    Vector<String> factors = expression.Split('*');
+    for (unsigned i = 0; i < factors.Size(); ++i)
+    {
+        String factor = factors[i].Trimmed();
+        HashMap<String, String>::ConstIterator j = defines.Find(factor);
+        if (j != defines.End())
+            factor = j->second_;
+        size *= Max(ToUInt(factor), 1U);
+    }
+    return size;
+}
+
+void ShaderVariation::OnDeviceLost()
+{
+    // No-op on the null backend
+}
+
+bool ShaderVariation::Create()
+{
+    Release();
+
+    if (!graphics_)
+        return false;
+
+    if (!owner_)
+    {
+        compilerOutput_ = "Owner shader has expired";
+        return false;
+    }
+
+    if (!Compile())
+        return false;
+
+    // There is no device object; use the variation itself as a unique non-null handle
+    object_.ptr_ = this;
+    return true;
+}
+
+void ShaderVariation::Release()
+{
+    if (object_.ptr_ && graphics_)
+    {
+        graphics_->CleanupShaderPrograms(this);
+
+        if (type_ == VS)
+        {
+            if (graphics_->GetVertexShader() == this)
+                graphics_->SetShaders(0, 0);
+        }
+        else
+        {
+            if (graphics_->GetPixelShader() == this)
+                graphics_->SetShaders(0, 0);
+        }
+    }
+
+    object_.ptr_ = 0;
+
+    compilerOutput_.Clear();
+
+    for (unsigned i = 0; i < MAX_TEXTURE_UNITS; ++i)
+        useTextureUnit_[i] = false;
+    parameters_.Clear();
+}
+
+void ShaderVariation::SetDefines(const String& defines)
+{
+    defines_ = defines;
+}
+
+bool ShaderVariation::Compile()
+{
+    // There is no shader compiler. Instead run a light preprocessor over the HLSL source and collect the uniforms and
+    // samplers that are declared and referenced in the active code, which approximates the reflection data of a compiled
+    // Direct3D9 shader
+    const String& sourceCode = owner_->GetSourceCode(type_);
+    if (sourceCode.Empty())
+    {
+        compilerOutput_ = "Empty shader source";
+        return false;
+    }
+
+    HashMap<String, String> defines;
+    Vector<String> defineList = defines_.Split(' ');
+    for (unsigned i = 0; i < defineList.Size(); ++i)
+    {
+        unsigned equalsPos = defineList[i].Find('=');
+        if (equalsPos != String::NPOS)
+            defines[defineList[i].Substring(0, equalsPos)] = defineList[i].Substring(equalsPos + 1);
+        else
+            defines[defineList[i]] = "1";
+    }
+    defines[type_ == VS ? "COMPILEVS" : "COMPILEPS"] = "1";
+    defines["MAXBONES"] = String(Graphics::GetMaxBones());
+
+    PODVector<ConditionalBlock> blocks;
+    HashMap<String, unsigned> references;
+    Vector<String> uniformNames;
+    PODVector<unsigned> uniformSizes;
+    Vector<String> samplerNames;
+    PODVector<unsigned> samplerUnits;
+    bool active = true;
+    bool inComment = false;
+
+    Vector<String> lines = sourceCode.Split('\n');
+    for (unsigned i = 0; i < lines.Size(); ++i)
+    {
+        // Strip comments, which include the commented out entry point of the other shader stage
+        const String& rawLine = lines[i];
+        String line;
+        for (unsigned j = 0; j < rawLine.Length(); ++j)
+        {
+            if (inComment)
+            {
+                if (rawLine[j] == '*' && j + 1 < rawLine.Length() && rawLine[j + 1] == '/')
+                {
+                    inComment = false;
+                    ++j;
+                }
+            }
+            else if (rawLine[j] == '/' && j + 1 < rawLine.Length() && rawLine[j + 1] == '*')
+            {
+                inComment = true;
+                ++j;
+            }
+            else if (rawLine[j] == '/' && j + 1 < rawLine.Length() && rawLine[j + 1] == '/')
+                break;
+            else
+                line += rawLine[j];
+        }
+        line = line.Trimmed();
+        if (line.Empty())
+            continue;
+
+        if (line[0] == '#')
+        {
+            const char* pos = line.CString() + 1;
+            SkipSpace(pos);
+            String directive = ReadIdentifier(pos);
+            SkipSpace(pos);
+
+            if (directive == "if" || directive == "ifdef" || directive == "ifndef")
+            {
+                ConditionResult result;
+                if (directive == "if")
+                    result = EvaluateOr(pos, defines);
+                else
+                {
+                    bool defined = defines.Contains(ReadIdentifier(pos));
+                    result = defined == (directive == "ifdef") ? CONDITION_TRUE : CONDITION_FALSE;
+                }
+
+                ConditionalBlock block;
+                block.parentActive_ = active;
+                block.active_ = active && result != CONDITION_FALSE;
+                block.taken_ = result == CONDITION_TRUE;
+                blocks.Push(block);
+                active = block.active_;
+            }
+            else if (directive == "elif" && blocks.Size())
+            {
+                ConditionalBlock& block = blocks.Back();
+                ConditionResult result = EvaluateOr(pos, defines);
+                block.active_ = block.parentActive_ && !block.taken_ && result != CONDITION_FALSE;
+                block.taken_ |= result == CONDITION_TRUE;
+                active = block.active_;
+            }
+            else if (directive == "else" && blocks.Size())
+            {
+                ConditionalBlock& block = blocks.Back();
+                block.active_ = block.parentActive_ && !block.taken_;
+                block.taken_ = true;
+                active = block.active_;
+            }
+            else if (directive == "endif" && blocks.Size())
+            {
+                active = blocks.Back().parentActive_;
+                blocks.Pop();
+            }
+            else if (active && directive == "define")
+            {
+                String name = ReadIdentifier(pos);
+                SkipSpace(pos);
+                // Function-like macros only matter for being defined
+                defines[name] = *pos == '(' ? String("1") : String(pos).Trimmed();
+            }
+            else if (active && directive == "undef")
+                defines.Erase(ReadIdentifier(pos));
+
+            continue;
+        }
+
+        if (!active)
+            continue;
+
+        // Count identifier references of the active code
+        const char* pos = line.CString();
+        Vector<String> tokens;
+        while (*pos)
+        {
+            if (isalpha((unsigned char)*pos) || *pos == '_')
+            {
+                String token = ReadIdentifier(pos);
+                ++references[token];
+                if (tokens.Size() < 3)
+                    tokens.Push(token);
+            }
+            else
+                ++pos;
+        }
+
+        // Uniform declaration: uniform <type> c<Name>[<size>];
+        if (tokens.Size() >= 3 && tokens[0] == "uniform" && tokens[2].Length() > 1 && tokens[2][0] == 'c')
+        {
+            const String& type = tokens[1];
+            // Matrices take one register per column
+            unsigned size = type.Contains('x') ? ToUInt(type.Substring(type.Length() - 1)) : 1;
+            unsigned bracketPos = line.Find('[');
+            if (bracketPos != String::NPOS)
+            {
+                unsigned endPos = line.Find(']', bracketPos);
+                if (endPos != String::NPOS)
+                    size *= EvaluateArraySize(line.Substring(bracketPos + 1, endPos - bracketPos - 1), defines);
+            }
+            uniformNames.Push(tokens[2]);
+            uniformSizes.Push(Max(size, 1U));
+        }
+        // Sampler declaration: sampler<type> s<Name> : register(s<unit>);
+        else if (tokens.Size() >= 2 && tokens[0].StartsWith("sampler") && tokens[1].Length() > 1 && tokens[1][0] == 's')
+        {
+            unsigned registerPos = line.Find("register(s");
+            if (registerPos != String::NPOS)
+            {
+                samplerNames.Push(tokens[1]);
+                samplerUnits.Push(ToUInt(line.CString() + registerPos + 10));
+            }
+        }
+    }
+
+    // Keep declarations that are referenced beyond the declaration itself, as the compiler would strip the rest
+    unsigned reg = 0;
+    for (unsigned i = 0; i < uniformNames.Size(); ++i)
+    {
+        if (references[uniformNames[i]] < 2)
+            continue;
+
+        ShaderParameter parameter;
+        parameter.type_ = type_;
+        parameter.name_ = uniformNames[i].Substring(1);
+        parameter.register_ = reg;
+        parameter.regCount_ = uniformSizes[i];
+        parameters_[StringHash(parameter.name_)] = parameter;
+        reg += uniformSizes[i];
+    }
+
+    for (unsigned i = 0; i < samplerNames.Size(); ++i)
+    {
+        // Samplers are referenced either directly or through the sampling macros with the leading 's' removed
+        String name = samplerNames[i].Substring(1);
+        if (references[samplerNames[i]] < 2 && !references.Contains(name))
+            continue;
+
+        // Skip if it's a G-buffer sampler, which are aliases for the standard texture units
+        if (samplerUnits[i] < MAX_TEXTURE_UNITS && name != "AlbedoBuffer" && name != "NormalBuffer" && name != "DepthBuffer" &&
+            name != "LightBuffer")
+            useTextureUnit_[samplerUnits[i]] = true;
+    }
+
+    if (blocks.Size())
+        URHO3D_LOGWARNING("Unterminated conditional block in shader " + GetFullName());
+
+    if (type_ == VS)
+        URHO3D_LOGDEBUG("Scanned vertex shader " + GetFullName());
+    else
+        URHO3D_LOGDEBUG("Scanned pixel shader " + GetFullName());
+
+    return true;
+}
+
+}
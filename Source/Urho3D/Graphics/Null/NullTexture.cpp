@@ -0,0 +1,110 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../../Precompiled.h"
+
+#include "../../Core/StringUtils.h"
+#include "../../Graphics/Graphics.h"
+#include "../../Graphics/GraphicsImpl.h"
+#include "../../Graphics/Material.h"
+#include "../../IO/FileSystem.h"
+#include "../../Resource/ResourceCache.h"
+#include "../../Resource/XMLFile.h"
+
+#include "../../DebugNew.h"
+
+namespace Urho3D
+{
+
+void Texture::SetSRGB(bool enable)
+{
+    if (graphics_)
+        enable &= graphics_->GetSRGBSupport();
+
+    sRGB_ = enable;
+}
+
+void Texture::UpdateParameters()
+{
+    // No-op on the null backend, sampler settings are tracked by Graphics instead
+}
+
+bool Texture::GetParametersDirty() const
+{
+    return false;
+}
+
+bool Texture::IsCompressed() const
+{
+    return format_ == NULLFMT_DXT1 || format_ == NULLFMT_DXT3 || format_ == NULLFMT_DXT5;
+}
+
+unsigned Texture::GetRowDataSize(int width) const
+{
+    switch (format_)
+    {
+    case NULLFMT_A8:
+    case NULLFMT_L8:
+        return (unsigned)width;
+
+    case NULLFMT_D16:
+    case NULLFMT_L8A8:
+    case NULLFMT_R16F:
+        return (unsigned)(width * 2);
+
+    case NULLFMT_RGB8:
+        return (unsigned)(width * 3);
+
+    case NULLFMT_RGBA8:
+    case NULLFMT_RG16:
+    case NULLFMT_R32F:
+    case NULLFMT_RG16F:
+    case NULLFMT_D24S8:
+        return (unsigned)(width * 4);
+
+    case NULLFMT_RGBA16:
+    case NULLFMT_RGBA16F:
+    case NULLFMT_RG32F:
+        return (unsigned)(width * 8);
+
+    case NULLFMT_RGBA32F:
+        return (unsigned)(width * 16);
+
+    case NULLFMT_DXT1:
+        return (unsigned)(((width + 3) >> 2) * 8);
+
+    case NULLFMT_DXT3:
+    case NULLFMT_DXT5:
+        return (unsigned)(((width + 3) >> 2) * 16);
+
+    default:
+        return 0;
+    }
+}
+
+void Texture::RegenerateLevels()
+{
+    // No-op on the null backend
+    levelsDirty_ = false;
+}
+
+}
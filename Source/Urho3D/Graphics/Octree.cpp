@@ -27,6 +27,7 @@
 #include "../Core/Profiler.h"
 #include "../Core/Thread.h"
 #include "../Core/WorkQueue.h"
+#include "../Graphics/AnimatedModel.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/Octree.h"
@@ -315,7 +316,10 @@ void Octant::GetDrawablesOnlyInternal(RayOctreeQuery& query, PODVector<Drawable*
 Octree::Octree(Context* context) :
     Component(context),
     Octant(BoundingBox(-DEFAULT_OCTREE_SIZE, DEFAULT_OCTREE_SIZE), 0, 0, this),
-    numLevels_(DEFAULT_OCTREE_LEVELS)
+    numLevels_(DEFAULT_OCTREE_LEVELS),
+    animationBoneBudget_(0),
+    structureVersion_(0),
+    updateVersion_(0)
 {
     // If the engine is running headless, subscribe to RenderUpdate events for manually updating the octree
     // to allow raycasts and animation update
@@ -327,6 +331,8 @@ Octree::~Octree()
 {
     // Reset root pointer from all child octants now so that they do not move their drawables to root
     drawableUpdates_.Clear();
+    for (PODVector<Drawable*>::Iterator i = updatedDrawables_.Begin(); i != updatedDrawables_.End(); ++i)
+        (*i)->updatedInOctree_ = false;
     ResetRoot();
 }
 
@@ -340,13 +346,16 @@ void Octree::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Bounding Box Min", Vector3, worldBoundingBox_.min_, defaultBoundsMin, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Bounding Box Max", Vector3, worldBoundingBox_.max_, defaultBoundsMax, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Number of Levels", int, numLevels_, DEFAULT_OCTREE_LEVELS, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Animation Bone Budget", GetAnimationBoneBudget, SetAnimationBoneBudget, unsigned, 0, AM_DEFAULT);
 }
 
 void Octree::OnSetAttribute(const AttributeInfo& attr, const Variant& src)
 {
-    // If any of the (size) attributes change, resize the octree
     Serializable::OnSetAttribute(attr, src);
-    SetSize(worldBoundingBox_, numLevels_);
+
+    // If any of the size attributes change, resize the octree. These are the attributes without accessors
+    if (!attr.accessor_)
+        SetSize(worldBoundingBox_, numLevels_);
 }
 
 void Octree::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
@@ -380,14 +389,25 @@ void Octree::Update(const FrameInfo& frame)
         return;
     }
 
+    URHO3D_PROFILE(UpdateOctree);
+
+    // Update the world transforms of moved nodes in one pass, so that the drawable updates find them up to date
+    Scene* scene = GetScene();
+    if (scene && scene->GetBatchedTransformUpdate())
+        scene->UpdateTransforms();
+
     // Let drawables update themselves before reinsertion. This can be used for animation
     if (!drawableUpdates_.Empty())
     {
         URHO3D_PROFILE(UpdateDrawables);
 
+        // Defer the lowest priority animation updates exceeding the bone budget. This is done before the threaded update
+        // so that the selection is deterministic
+        if (animationBoneBudget_)
+            AnimatedModel::ApplyAnimationBudget(drawableUpdates_, animationBoneBudget_, frame, deferredDrawableUpdates_);
+
         // Perform updates in worker threads. Notify the scene that a threaded update is going on and components
         // (for example physics objects) should not perform non-threadsafe work when marked dirty
-        Scene* scene = GetScene();
         WorkQueue* queue = GetSubsystem<WorkQueue>();
         scene->BeginThreadedUpdate();
 
@@ -437,7 +457,6 @@ void Octree::Update(const FrameInfo& frame)
     }
 
     // Notify drawable update being finished. Custom animation (eg. IK) can be done at this point
-    Scene* scene = GetScene();
     if (scene)
     {
         using namespace SceneDrawableUpdateFinished;
@@ -482,7 +501,36 @@ void Octree::Update(const FrameInfo& frame)
         }
     }
 
+    // Keep the updated drawables for views which cache their visibility results
+    if (!drawableUpdates_.Empty())
+    {
+        for (PODVector<Drawable*>::Iterator i = updatedDrawables_.Begin(); i != updatedDrawables_.End(); ++i)
+            (*i)->updatedInOctree_ = false;
+        Swap(updatedDrawables_, drawableUpdates_);
+        for (PODVector<Drawable*>::Iterator i = updatedDrawables_.Begin(); i != updatedDrawables_.End(); ++i)
+            (*i)->updatedInOctree_ = true;
+        ++updateVersion_;
+    }
     drawableUpdates_.Clear();
+
+    // Queue the deferred animation updates for the next frame
+    if (!deferredDrawableUpdates_.Empty())
+    {
+        for (PODVector<Drawable*>::ConstIterator i = deferredDrawableUpdates_.Begin(); i != deferredDrawableUpdates_.End(); ++i)
+        {
+            Drawable* drawable = *i;
+            if (!drawable->updateQueued_ && drawable->GetOctant())
+                QueueUpdate(drawable);
+        }
+
+        deferredDrawableUpdates_.Clear();
+    }
+}
+
+void Octree::SetAnimationBoneBudget(unsigned bones)
+{
+    animationBoneBudget_ = bones;
+    MarkNetworkUpdate();
 }
 
 void Octree::AddManualDrawable(Drawable* drawable)
@@ -491,6 +539,7 @@ void Octree::AddManualDrawable(Drawable* drawable)
         return;
 
     AddDrawable(drawable);
+    MarkStructureChanged();
 }
 
 void Octree::RemoveManualDrawable(Drawable* drawable)
@@ -500,7 +549,10 @@ void Octree::RemoveManualDrawable(Drawable* drawable)
 
     Octant* octant = drawable->GetOctant();
     if (octant && octant->GetRoot() == this)
+    {
         octant->RemoveDrawable(drawable);
+        MarkStructureChanged();
+    }
 }
 
 void Octree::GetDrawables(OctreeQuery& query) const
@@ -577,9 +629,17 @@ void Octree::CancelUpdate(Drawable* drawable)
     // This doesn't have to take into account scene being in threaded update, because it is called only
     // when removing a drawable from octree, which should only ever happen from the main thread.
     drawableUpdates_.Remove(drawable);
+    deferredDrawableUpdates_.Remove(drawable);
     drawable->updateQueued_ = false;
 }
 
+void Octree::RemoveUpdatedDrawable(Drawable* drawable)
+{
+    // The order of the updated drawables does not matter
+    updatedDrawables_.RemoveSwap(drawable);
+    drawable->updatedInOctree_ = false;
+}
+
 void Octree::DrawDebugGeometry(bool depthTest)
 {
     DebugRenderer* debug = GetComponent<DebugRenderer>();
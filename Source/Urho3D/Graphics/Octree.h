@@ -184,6 +184,8 @@ public:
     void AddManualDrawable(Drawable* drawable);
     /// Remove a manually added drawable.
     void RemoveManualDrawable(Drawable* drawable);
+    /// Set maximum number of animated model bones to evaluate per frame, 0 for unlimited. Models over the budget with the smallest screen size are updated on a later frame.
+    void SetAnimationBoneBudget(unsigned bones);
 
     /// Return drawable objects by a query.
     void GetDrawables(OctreeQuery& query) const;
@@ -195,10 +197,26 @@ public:
     /// Return subdivision levels.
     unsigned GetNumLevels() const { return numLevels_; }
 
+    /// Return animation bone budget per frame.
+    unsigned GetAnimationBoneBudget() const { return animationBoneBudget_; }
+
+    /// Return structure version. Changes when drawables are added or removed, or their view mask, occluder or shadow caster flags change.
+    unsigned GetStructureVersion() const { return structureVersion_; }
+
+    /// Return update version. Changes on each Update() that updated drawables.
+    unsigned GetUpdateVersion() const { return updateVersion_; }
+
+    /// Return the drawables updated on the last Update() that changed the update version.
+    const PODVector<Drawable*>& GetUpdatedDrawables() const { return updatedDrawables_; }
+
     /// Mark drawable object as requiring an update and a reinsertion.
     void QueueUpdate(Drawable* drawable);
     /// Cancel drawable object's update.
     void CancelUpdate(Drawable* drawable);
+    /// Remove drawable object from the drawables updated on the last update. Called when the drawable is removed from the octree.
+    void RemoveUpdatedDrawable(Drawable* drawable);
+    /// Mark that drawables have been added, removed or changed in a way that affects visibility queries.
+    void MarkStructureChanged() { ++structureVersion_; }
     /// Visualize the component as debug geometry.
     void DrawDebugGeometry(bool depthTest);
 
@@ -210,12 +228,22 @@ private:
     PODVector<Drawable*> drawableUpdates_;
     /// Drawable objects that were inserted during threaded update phase.
     PODVector<Drawable*> threadedDrawableUpdates_;
+    /// Drawable objects whose animation update was deferred by the bone budget.
+    PODVector<Drawable*> deferredDrawableUpdates_;
+    /// Drawable objects updated on the last update.
+    PODVector<Drawable*> updatedDrawables_;
     /// Mutex for octree reinsertions.
     Mutex octreeMutex_;
     /// Ray query temporary list of drawables.
     mutable PODVector<Drawable*> rayQueryDrawables_;
     /// Subdivision level.
     unsigned numLevels_;
+    /// Animation bone budget per frame.
+    unsigned animationBoneBudget_;
+    /// Structure version.
+    unsigned structureVersion_;
+    /// Update version.
+    unsigned updateVersion_;
 };
 
 }
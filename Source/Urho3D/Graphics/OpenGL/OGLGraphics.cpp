@@ -3279,6 +3279,8 @@ void Graphics::SetTextureUnitMappings()
     textureUnits_["LightRampMap"] = TU_LIGHTRAMP;
     textureUnits_["LightSpotMap"] = TU_LIGHTSHAPE;
     textureUnits_["LightCubeMap"] = TU_LIGHTSHAPE;
+    textureUnits_["ClusterMap"] = TU_LIGHTRAMP;
+    textureUnits_["ClusterLightMap"] = TU_LIGHTSHAPE;
     textureUnits_["ShadowMap"] = TU_SHADOWMAP;
 #ifndef GL_ES_VERSION_2_0
     textureUnits_["VolumeMap"] = TU_VOLUMEMAP;
@@ -0,0 +1,530 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Graphics/Material.h"
+#include "../Graphics/PagedTerrain.h"
+#include "../Graphics/Terrain.h"
+#include "../IO/Log.h"
+#include "../Resource/Image.h"
+#include "../Resource/ResourceCache.h"
+#include "../Resource/ResourceEvents.h"
+#include "../Scene/Node.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* GEOMETRY_CATEGORY;
+
+static const Vector3 DEFAULT_SPACING(1.0f, 0.25f, 1.0f);
+static const int DEFAULT_TILE_RESOLUTION = 257;
+static const int DEFAULT_PATCH_SIZE = 32;
+static const unsigned DEFAULT_MAX_LOD_LEVELS = 4;
+static const float DEFAULT_LOAD_DISTANCE = 500.0f;
+static const float DEFAULT_UNLOAD_DISTANCE = 600.0f;
+
+PagedTerrain::PagedTerrain(Context* context) :
+    Component(context),
+    numTiles_(IntVector2::ZERO),
+    spacing_(DEFAULT_SPACING),
+    tileResolution_(DEFAULT_TILE_RESOLUTION),
+    patchSize_(DEFAULT_PATCH_SIZE),
+    maxLodLevels_(DEFAULT_MAX_LOD_LEVELS),
+    loadDistance_(DEFAULT_LOAD_DISTANCE),
+    unloadDistance_(DEFAULT_UNLOAD_DISTANCE),
+    focusID_(0),
+    smoothing_(false),
+    geomorph_(false),
+    subscribed_(false),
+    focusDirty_(false),
+    recreateTiles_(false)
+{
+}
+
+PagedTerrain::~PagedTerrain()
+{
+}
+
+void PagedTerrain::RegisterObject(Context* context)
+{
+    context->RegisterFactory<PagedTerrain>(GEOMETRY_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, bool, true, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Height Map Pattern", String, heightMapPattern_, String::EMPTY, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Number of Tiles", IntVector2, numTiles_, IntVector2::ZERO, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Tile Resolution", int, tileResolution_, DEFAULT_TILE_RESOLUTION, AM_DEFAULT);
+    URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Material", GetMaterialAttr, SetMaterialAttr, ResourceRef, ResourceRef(Material::GetTypeStatic()),
+        AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Vertex Spacing", Vector3, spacing_, DEFAULT_SPACING, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Patch Size", int, patchSize_, DEFAULT_PATCH_SIZE, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Max LOD Levels", unsigned, maxLodLevels_, DEFAULT_MAX_LOD_LEVELS, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Smooth Height Map", bool, smoothing_, false, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Geomorph", bool, geomorph_, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Load Distance", GetLoadDistance, SetLoadDistance, float, DEFAULT_LOAD_DISTANCE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Unload Distance", GetUnloadDistance, SetUnloadDistance, float, DEFAULT_UNLOAD_DISTANCE, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Focus NodeID", unsigned, focusID_, 0, AM_DEFAULT | AM_NODEID);
+}
+
+void PagedTerrain::OnSetAttribute(const AttributeInfo& attr, const Variant& src)
+{
+    Serializable::OnSetAttribute(attr, src);
+
+    // Change of the layout requires recreating the tiles, while other non-accessor attributes are applied to the loaded tiles
+    if (!attr.accessor_)
+    {
+        if (attr.mode_ & AM_NODEID)
+            focusDirty_ = true;
+        else
+            recreateTiles_ = true;
+    }
+}
+
+void PagedTerrain::ApplyAttributes()
+{
+    if (recreateTiles_)
+    {
+        RemoveAllTiles();
+        recreateTiles_ = false;
+    }
+
+    if (focusDirty_)
+    {
+        Scene* scene = GetScene();
+        SetFocus(scene ? scene->GetNode(focusID_) : (Node*)0);
+        focusDirty_ = false;
+    }
+}
+
+void PagedTerrain::OnSetEnabled()
+{
+    bool enabled = IsEnabledEffective();
+
+    for (HashMap<IntVector2, PagedTerrainTile>::Iterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+    {
+        if (i->second_.terrain_)
+            i->second_.terrain_->SetEnabled(enabled);
+    }
+
+    UpdateEventSubscription();
+}
+
+void PagedTerrain::SetHeightMapPattern(const String& pattern)
+{
+    if (pattern != heightMapPattern_)
+    {
+        heightMapPattern_ = pattern;
+        RemoveAllTiles();
+        MarkNetworkUpdate();
+    }
+}
+
+void PagedTerrain::SetNumTiles(const IntVector2& numTiles)
+{
+    if (numTiles != numTiles_)
+    {
+        numTiles_ = numTiles;
+        RemoveAllTiles();
+        MarkNetworkUpdate();
+    }
+}
+
+void PagedTerrain::SetTileResolution(int resolution)
+{
+    if (resolution < 2)
+        return;
+
+    if (resolution != tileResolution_)
+    {
+        tileResolution_ = resolution;
+        RemoveAllTiles();
+        MarkNetworkUpdate();
+    }
+}
+
+void PagedTerrain::SetMaterial(Material* material)
+{
+    material_ = material;
+    ApplyAllTileSettings();
+    MarkNetworkUpdate();
+}
+
+void PagedTerrain::SetSpacing(const Vector3& spacing)
+{
+    if (spacing != spacing_)
+    {
+        spacing_ = spacing;
+        // Tile positions depend on the spacing
+        RemoveAllTiles();
+        MarkNetworkUpdate();
+    }
+}
+
+void PagedTerrain::SetPatchSize(int size)
+{
+    if (size != patchSize_)
+    {
+        patchSize_ = size;
+        ApplyAllTileSettings();
+        MarkNetworkUpdate();
+    }
+}
+
+void PagedTerrain::SetMaxLodLevels(unsigned levels)
+{
+    if (levels != maxLodLevels_)
+    {
+        maxLodLevels_ = levels;
+        ApplyAllTileSettings();
+        MarkNetworkUpdate();
+    }
+}
+
+void PagedTerrain::SetSmoothing(bool enable)
+{
+    if (enable != smoothing_)
+    {
+        smoothing_ = enable;
+        ApplyAllTileSettings();
+        MarkNetworkUpdate();
+    }
+}
+
+void PagedTerrain::SetGeomorph(bool enable)
+{
+    if (enable != geomorph_)
+    {
+        geomorph_ = enable;
+        ApplyAllTileSettings();
+        MarkNetworkUpdate();
+    }
+}
+
+void PagedTerrain::SetLoadDistance(float distance)
+{
+    loadDistance_ = Max(distance, 0.0f);
+    unloadDistance_ = Max(unloadDistance_, loadDistance_);
+    MarkNetworkUpdate();
+}
+
+void PagedTerrain::SetUnloadDistance(float distance)
+{
+    unloadDistance_ = Max(distance, loadDistance_);
+    MarkNetworkUpdate();
+}
+
+void PagedTerrain::SetFocus(Node* focus)
+{
+    focus_ = focus;
+    focusID_ = focus ? focus->GetID() : 0;
+    UpdateEventSubscription();
+    MarkNetworkUpdate();
+}
+
+void PagedTerrain::UpdateTiles(const Vector3& worldPosition)
+{
+    if (!node_ || heightMapPattern_.Empty() || numTiles_.x_ <= 0 || numTiles_.y_ <= 0)
+        return;
+
+    URHO3D_PROFILE(UpdatePagedTerrain);
+
+    // Distances are measured on the XZ plane in the local space of the scene node
+    Vector3 position = node_->GetWorldTransform().Inverse() * worldPosition;
+    float tileSizeX = (float)(tileResolution_ - 1) * spacing_.x_;
+    float tileSizeZ = (float)(tileResolution_ - 1) * spacing_.z_;
+    if (tileSizeX <= 0.0f || tileSizeZ <= 0.0f)
+        return;
+
+    // Unload tiles that are too far. Tiles with heightmaps still loading are kept until the load finishes
+    PODVector<IntVector2> removeTiles;
+    for (HashMap<IntVector2, PagedTerrainTile>::ConstIterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+    {
+        if (i->second_.loading_)
+            continue;
+
+        Rect tileRect(i->first_.x_ * tileSizeX, i->first_.y_ * tileSizeZ, (i->first_.x_ + 1) * tileSizeX,
+            (i->first_.y_ + 1) * tileSizeZ);
+        Vector2 offset(Max(Max(tileRect.min_.x_ - position.x_, position.x_ - tileRect.max_.x_), 0.0f),
+            Max(Max(tileRect.min_.y_ - position.z_, position.z_ - tileRect.max_.y_), 0.0f));
+        if (offset.Length() > unloadDistance_)
+            removeTiles.Push(i->first_);
+    }
+    for (unsigned i = 0; i < removeTiles.Size(); ++i)
+        RemoveTile(removeTiles[i]);
+
+    // Request tiles within the load distance
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    int minX = Max(FloorToInt((position.x_ - loadDistance_) / tileSizeX), 0);
+    int maxX = Min(FloorToInt((position.x_ + loadDistance_) / tileSizeX), numTiles_.x_ - 1);
+    int minZ = Max(FloorToInt((position.z_ - loadDistance_) / tileSizeZ), 0);
+    int maxZ = Min(FloorToInt((position.z_ + loadDistance_) / tileSizeZ), numTiles_.y_ - 1);
+
+    for (int z = minZ; z <= maxZ; ++z)
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            IntVector2 coords(x, z);
+            if (tiles_.Contains(coords))
+                continue;
+
+            Vector2 offset(Max(Max(x * tileSizeX - position.x_, position.x_ - (x + 1) * tileSizeX), 0.0f),
+                Max(Max(z * tileSizeZ - position.z_, position.z_ - (z + 1) * tileSizeZ), 0.0f));
+            if (offset.Length() > loadDistance_)
+                continue;
+
+            // A tile whose heightmap fails to load stays in the map without a terrain, so that loading is not retried
+            // until it has gone out of range
+            PagedTerrainTile& tile = tiles_[coords];
+            tile.heightMapName_ = GetTileHeightMapName(coords);
+
+            Image* heightMap = cache->GetExistingResource<Image>(tile.heightMapName_);
+            if (!heightMap && cache->BackgroundLoadResource<Image>(tile.heightMapName_, true, 0))
+            {
+                // If threading is not available, the resource was loaded immediately
+                heightMap = cache->GetExistingResource<Image>(tile.heightMapName_);
+                if (!heightMap)
+                    tile.loading_ = true;
+            }
+
+            if (heightMap)
+                CreateTile(coords, heightMap);
+        }
+    }
+}
+
+Material* PagedTerrain::GetMaterial() const
+{
+    return material_;
+}
+
+Node* PagedTerrain::GetFocus() const
+{
+    return focus_;
+}
+
+Terrain* PagedTerrain::GetTile(int x, int z) const
+{
+    HashMap<IntVector2, PagedTerrainTile>::ConstIterator i = tiles_.Find(IntVector2(x, z));
+    return i != tiles_.End() ? i->second_.terrain_.Get() : (Terrain*)0;
+}
+
+unsigned PagedTerrain::GetNumLoadedTiles() const
+{
+    unsigned num = 0;
+    for (HashMap<IntVector2, PagedTerrainTile>::ConstIterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+    {
+        if (i->second_.terrain_)
+            ++num;
+    }
+
+    return num;
+}
+
+unsigned PagedTerrain::GetNumLoadingTiles() const
+{
+    unsigned num = 0;
+    for (HashMap<IntVector2, PagedTerrainTile>::ConstIterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+    {
+        if (i->second_.loading_)
+            ++num;
+    }
+
+    return num;
+}
+
+void PagedTerrain::SetMaterialAttr(const ResourceRef& value)
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    SetMaterial(cache->GetResource<Material>(value.name_));
+}
+
+ResourceRef PagedTerrain::GetMaterialAttr() const
+{
+    return GetResourceRef(material_, Material::GetTypeStatic());
+}
+
+void PagedTerrain::OnSceneSet(Scene* scene)
+{
+    if (!scene)
+        RemoveAllTiles();
+
+    UpdateEventSubscription();
+}
+
+String PagedTerrain::GetTileHeightMapName(const IntVector2& coords) const
+{
+    return heightMapPattern_.Replaced("{x}", String(coords.x_)).Replaced("{z}", String(coords.y_));
+}
+
+void PagedTerrain::CreateTile(const IntVector2& coords, Image* heightMap)
+{
+    PagedTerrainTile& tile = tiles_[coords];
+    tile.loading_ = false;
+
+    if (!node_ || !heightMap)
+        return;
+
+    if (heightMap->GetWidth() != tileResolution_ || heightMap->GetHeight() != tileResolution_)
+    {
+        URHO3D_LOGWARNING("Paged terrain tile heightmap " + heightMap->GetName() + " does not match the tile resolution " +
+            String(tileResolution_));
+    }
+
+    // Tiles are created as local temporary nodes, as they are recreated from the heightmaps when needed
+    Node* tileNode = node_->CreateTemporaryChild("Tile_" + String(coords.x_) + "_" + String(coords.y_), LOCAL);
+    tileNode->SetPosition(Vector3((coords.x_ + 0.5f) * (tileResolution_ - 1) * spacing_.x_, 0.0f,
+        (coords.y_ + 0.5f) * (tileResolution_ - 1) * spacing_.z_));
+
+    Terrain* terrain = tileNode->CreateComponent<Terrain>(LOCAL);
+    ApplyTileSettings(terrain);
+    terrain->SetEnabled(IsEnabledEffective());
+    terrain->SetHeightMap(heightMap);
+
+    tile.node_ = tileNode;
+    tile.terrain_ = terrain;
+
+    UpdateTileNeighbors(coords);
+}
+
+void PagedTerrain::RemoveTile(const IntVector2& coords)
+{
+    HashMap<IntVector2, PagedTerrainTile>::Iterator i = tiles_.Find(coords);
+    if (i == tiles_.End())
+        return;
+
+    String heightMapName = i->second_.heightMapName_;
+    bool loading = i->second_.loading_;
+    if (i->second_.node_)
+        i->second_.node_->Remove();
+    tiles_.Erase(i);
+
+    UpdateTileNeighbors(coords);
+
+    // Release the heightmap unless it is still loading or also used elsewhere
+    if (!loading)
+        GetSubsystem<ResourceCache>()->ReleaseResource<Image>(heightMapName);
+}
+
+void PagedTerrain::RemoveAllTiles()
+{
+    // Keep tiles with heightmaps still loading in the map, so that the finished heightmaps can be released
+    PODVector<IntVector2> removeTiles;
+    for (HashMap<IntVector2, PagedTerrainTile>::ConstIterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+    {
+        if (!i->second_.loading_)
+            removeTiles.Push(i->first_);
+    }
+
+    for (unsigned i = 0; i < removeTiles.Size(); ++i)
+        RemoveTile(removeTiles[i]);
+}
+
+void PagedTerrain::ApplyTileSettings(Terrain* terrain) const
+{
+    terrain->SetSpacing(spacing_);
+    terrain->SetPatchSize(patchSize_);
+    terrain->SetMaxLodLevels(maxLodLevels_);
+    terrain->SetSmoothing(smoothing_);
+    terrain->SetGeomorph(geomorph_);
+    terrain->SetMaterial(material_);
+}
+
+void PagedTerrain::ApplyAllTileSettings()
+{
+    for (HashMap<IntVector2, PagedTerrainTile>::ConstIterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+    {
+        if (i->second_.terrain_)
+            ApplyTileSettings(i->second_.terrain_);
+    }
+}
+
+void PagedTerrain::UpdateTileNeighbors(const IntVector2& coords)
+{
+    static const IntVector2 offsets[] = { IntVector2::ZERO, IntVector2::UP, IntVector2::DOWN, IntVector2::LEFT, IntVector2::RIGHT };
+
+    for (unsigned i = 0; i < 5; ++i)
+    {
+        IntVector2 c = coords + offsets[i];
+        Terrain* terrain = GetTile(c.x_, c.y_);
+        if (terrain)
+            terrain->SetNeighbors(GetTile(c.x_, c.y_ + 1), GetTile(c.x_, c.y_ - 1), GetTile(c.x_ - 1, c.y_), GetTile(c.x_ + 1, c.y_));
+    }
+}
+
+void PagedTerrain::UpdateEventSubscription()
+{
+    Scene* scene = GetScene();
+    bool enabled = scene && focus_ && IsEnabledEffective();
+
+    if (enabled && !subscribed_)
+    {
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(PagedTerrain, HandleScenePostUpdate));
+        subscribed_ = true;
+    }
+    else if (!enabled && subscribed_)
+    {
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+        subscribed_ = false;
+    }
+
+    // Background load notifications are needed also when updating tiles manually
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    if (scene)
+        SubscribeToEvent(cache, E_RESOURCEBACKGROUNDLOADED, URHO3D_HANDLER(PagedTerrain, HandleResourceBackgroundLoaded));
+    else
+        UnsubscribeFromEvent(cache, E_RESOURCEBACKGROUNDLOADED);
+}
+
+void PagedTerrain::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    if (focus_)
+        UpdateTiles(focus_->GetWorldPosition());
+}
+
+void PagedTerrain::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ResourceBackgroundLoaded;
+
+    const String& name = eventData[P_RESOURCENAME].GetString();
+    for (HashMap<IntVector2, PagedTerrainTile>::Iterator i = tiles_.Begin(); i != tiles_.End(); ++i)
+    {
+        PagedTerrainTile& tile = i->second_;
+        if (!tile.loading_ || tile.heightMapName_ != name)
+            continue;
+
+        Resource* resource = static_cast<Resource*>(eventData[P_RESOURCE].GetPtr());
+        if (eventData[P_SUCCESS].GetBool() && resource && resource->GetType() == Image::GetTypeStatic())
+            CreateTile(i->first_, static_cast<Image*>(resource));
+        else
+            tile.loading_ = false;
+        break;
+    }
+}
+
+}
@@ -0,0 +1,214 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Scene/Component.h"
+
+namespace Urho3D
+{
+
+class Image;
+class Material;
+class Terrain;
+
+/// Loaded or loading tile of a paged terrain.
+struct PagedTerrainTile
+{
+    /// Construct.
+    PagedTerrainTile() :
+        loading_(false)
+    {
+    }
+
+    /// Heightmap resource name.
+    String heightMapName_;
+    /// Tile scene node.
+    SharedPtr<Node> node_;
+    /// Tile terrain component.
+    WeakPtr<Terrain> terrain_;
+    /// Heightmap background load in progress flag.
+    bool loading_;
+};
+
+/// Component that pages a grid of heightmap tiles in and out as terrains around a focus node.
+class URHO3D_API PagedTerrain : public Component
+{
+    URHO3D_OBJECT(PagedTerrain, Component);
+
+public:
+    /// Construct.
+    PagedTerrain(Context* context);
+    /// Destruct.
+    ~PagedTerrain();
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Handle attribute write access.
+    virtual void OnSetAttribute(const AttributeInfo& attr, const Variant& src);
+    /// Apply attribute changes that can not be applied immediately. Called after scene load or a network update.
+    virtual void ApplyAttributes();
+    /// Handle enabled/disabled state change.
+    virtual void OnSetEnabled();
+
+    /// Set tile heightmap resource name pattern. The strings {x} and {z} are replaced with the tile coordinates.
+    void SetHeightMapPattern(const String& pattern);
+    /// Set number of tiles in X and Z directions. Tile (0, 0) is the southwest corner.
+    void SetNumTiles(const IntVector2& numTiles);
+    /// Set tile heightmap size in pixels. All tile heightmaps should have this size, which should be a power of two + 1.
+    void SetTileResolution(int resolution);
+    /// Set material for the tiles.
+    void SetMaterial(Material* material);
+    /// Set vertex (XZ) and height (Y) spacing for the tiles.
+    void SetSpacing(const Vector3& spacing);
+    /// Set patch quads per side for the tiles.
+    void SetPatchSize(int size);
+    /// Set maximum number of LOD levels for the tiles.
+    void SetMaxLodLevels(unsigned levels);
+    /// Set smoothing of tile heightmaps.
+    void SetSmoothing(bool enable);
+    /// Set geomorphing for the tiles.
+    void SetGeomorph(bool enable);
+    /// Set distance from the focus within which tiles are loaded.
+    void SetLoadDistance(float distance);
+    /// Set distance from the focus beyond which tiles are unloaded. Is clamped to be at least the load distance.
+    void SetUnloadDistance(float distance);
+    /// Set focus node. Tiles are loaded around its position.
+    void SetFocus(Node* focus);
+    /// Load and unload tiles around a position given in world space. Called automatically on scene update when a focus node is set.
+    void UpdateTiles(const Vector3& worldPosition);
+
+    /// Return tile heightmap resource name pattern.
+    const String& GetHeightMapPattern() const { return heightMapPattern_; }
+
+    /// Return number of tiles.
+    const IntVector2& GetNumTiles() const { return numTiles_; }
+
+    /// Return tile heightmap size in pixels.
+    int GetTileResolution() const { return tileResolution_; }
+
+    /// Return material.
+    Material* GetMaterial() const;
+
+    /// Return vertex and height spacing.
+    const Vector3& GetSpacing() const { return spacing_; }
+
+    /// Return patch quads per side.
+    int GetPatchSize() const { return patchSize_; }
+
+    /// Return maximum number of LOD levels.
+    unsigned GetMaxLodLevels() const { return maxLodLevels_; }
+
+    /// Return whether smoothing is in use.
+    bool GetSmoothing() const { return smoothing_; }
+
+    /// Return whether geomorphing is in use.
+    bool GetGeomorph() const { return geomorph_; }
+
+    /// Return load distance.
+    float GetLoadDistance() const { return loadDistance_; }
+
+    /// Return unload distance.
+    float GetUnloadDistance() const { return unloadDistance_; }
+
+    /// Return focus node.
+    Node* GetFocus() const;
+
+    /// Return tile size in world space units.
+    float GetTileSize() const { return (float)(tileResolution_ - 1) * spacing_.x_; }
+
+    /// Return terrain of a loaded tile, or null if not loaded.
+    Terrain* GetTile(int x, int z) const;
+    /// Return number of loaded tiles.
+    unsigned GetNumLoadedTiles() const;
+    /// Return number of tiles with heightmaps still loading.
+    unsigned GetNumLoadingTiles() const;
+
+    /// Set material attribute.
+    void SetMaterialAttr(const ResourceRef& value);
+    /// Return material attribute.
+    ResourceRef GetMaterialAttr() const;
+
+protected:
+    /// Handle scene being assigned.
+    virtual void OnSceneSet(Scene* scene);
+
+private:
+    /// Return heightmap resource name of a tile.
+    String GetTileHeightMapName(const IntVector2& coords) const;
+    /// Create the terrain of a tile whose heightmap has been loaded.
+    void CreateTile(const IntVector2& coords, Image* heightMap);
+    /// Remove a tile and release its heightmap.
+    void RemoveTile(const IntVector2& coords);
+    /// Remove all tiles.
+    void RemoveAllTiles();
+    /// Apply terrain settings to a tile.
+    void ApplyTileSettings(Terrain* terrain) const;
+    /// Apply terrain settings to all loaded tiles.
+    void ApplyAllTileSettings();
+    /// Set neighbor terrains of a tile and of the tiles around it.
+    void UpdateTileNeighbors(const IntVector2& coords);
+    /// Update subscription to scene update and resource loading events.
+    void UpdateEventSubscription();
+    /// Handle scene post-update event.
+    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle resource background loading finished event.
+    void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
+
+    /// Tiles by coordinates.
+    HashMap<IntVector2, PagedTerrainTile> tiles_;
+    /// Material.
+    SharedPtr<Material> material_;
+    /// Focus node.
+    WeakPtr<Node> focus_;
+    /// Tile heightmap resource name pattern.
+    String heightMapPattern_;
+    /// Number of tiles.
+    IntVector2 numTiles_;
+    /// Vertex and height spacing.
+    Vector3 spacing_;
+    /// Tile heightmap size in pixels.
+    int tileResolution_;
+    /// Patch quads per side.
+    int patchSize_;
+    /// Maximum number of LOD levels.
+    unsigned maxLodLevels_;
+    /// Load distance.
+    float loadDistance_;
+    /// Unload distance.
+    float unloadDistance_;
+    /// Focus node ID.
+    unsigned focusID_;
+    /// Smoothing enable flag.
+    bool smoothing_;
+    /// Geomorphing enable flag.
+    bool geomorph_;
+    /// Event subscription flag.
+    bool subscribed_;
+    /// Focus node needs to be resolved from the ID flag.
+    bool focusDirty_;
+    /// Tiles need to be recreated flag.
+    bool recreateTiles_;
+};
+
+}
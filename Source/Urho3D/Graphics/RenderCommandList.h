@@ -0,0 +1,242 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+// Note: only the null graphics backend records render commands for the submission thread. The device-backed backends
+// bind their rendering context to the main thread, so there RenderCommandList only forwards the calls to Graphics.
+
+#if defined(URHO3D_NULL_GRAPHICS)
+#include "Null/NullRenderCommandList.h"
+#else
+
+#include "../Graphics/Geometry.h"
+#include "../Graphics/Graphics.h"
+#include "../Graphics/ShaderParameterBlock.h"
+
+namespace Urho3D
+{
+
+/// %Render command list. Forwards rendering calls to Graphics immediately, as recording is not supported by this graphics backend.
+class URHO3D_API RenderCommandList : public Object
+{
+    URHO3D_OBJECT(RenderCommandList, Object);
+
+public:
+    /// Construct.
+    RenderCommandList(Context* context) :
+        Object(context),
+        graphics_(GetSubsystem<Graphics>())
+    {
+    }
+
+    /// Begin recording. Not supported, does nothing.
+    void BeginRecording() { }
+    /// End recording. Not supported, does nothing.
+    void EndRecording() { }
+    /// Replay the recorded commands. Not supported, does nothing.
+    void Replay() { }
+    /// Clear the recorded commands. Not supported, does nothing.
+    void ClearCommands() { }
+    /// Suspend recording. Return false as is never recording.
+    bool Suspend() { return false; }
+    /// Suspend recording if an event has receivers. Return false as is never recording.
+    bool SuspendForEvent(Object* sender, StringHash eventType) { return false; }
+
+    /// Clear any or all of rendertarget, depth buffer and stencil buffer.
+    void Clear(unsigned flags, const Color& color = Color(0.0f, 0.0f, 0.0f, 0.0f), float depth = 1.0f, unsigned stencil = 0)
+    {
+        graphics_->Clear(flags, color, depth, stencil);
+    }
+    /// Resolve multisampled backbuffer to a texture rendertarget.
+    void ResolveToTexture(Texture2D* destination, const IntRect& viewport) { graphics_->ResolveToTexture(destination, viewport); }
+    /// Resolve a multisampled texture on itself.
+    void ResolveToTexture(Texture2D* texture) { graphics_->ResolveToTexture(texture); }
+    /// Resolve a multisampled cube texture on itself.
+    void ResolveToTexture(TextureCube* texture) { graphics_->ResolveToTexture(texture); }
+    /// Draw non-indexed geometry.
+    void Draw(PrimitiveType type, unsigned vertexStart, unsigned vertexCount) { graphics_->Draw(type, vertexStart, vertexCount); }
+    /// Draw indexed geometry.
+    void Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned minVertex, unsigned vertexCount)
+    {
+        graphics_->Draw(type, indexStart, indexCount, minVertex, vertexCount);
+    }
+    /// Draw indexed geometry with vertex index offset.
+    void Draw(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned baseVertexIndex, unsigned minVertex, unsigned vertexCount)
+    {
+        graphics_->Draw(type, indexStart, indexCount, baseVertexIndex, minVertex, vertexCount);
+    }
+    /// Draw indexed, instanced geometry. An instancing vertex buffer must be set.
+    void DrawInstanced(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned minVertex, unsigned vertexCount,
+        unsigned instanceCount)
+    {
+        graphics_->DrawInstanced(type, indexStart, indexCount, minVertex, vertexCount, instanceCount);
+    }
+    /// Draw indexed, instanced geometry with vertex index offset.
+    void DrawInstanced(PrimitiveType type, unsigned indexStart, unsigned indexCount, unsigned baseVertexIndex, unsigned minVertex,
+        unsigned vertexCount, unsigned instanceCount)
+    {
+        graphics_->DrawInstanced(type, indexStart, indexCount, baseVertexIndex, minVertex, vertexCount, instanceCount);
+    }
+    /// Draw a geometry using its current buffers and draw range.
+    void Draw(Geometry* geometry) { geometry->Draw(graphics_); }
+    /// Set vertex buffer.
+    void SetVertexBuffer(VertexBuffer* buffer) { graphics_->SetVertexBuffer(buffer); }
+    /// Set multiple vertex buffers.
+    void SetVertexBuffers(const PODVector<VertexBuffer*>& buffers, unsigned instanceOffset = 0)
+    {
+        graphics_->SetVertexBuffers(buffers, instanceOffset);
+    }
+    /// Set multiple vertex buffers.
+    void SetVertexBuffers(const Vector<SharedPtr<VertexBuffer> >& buffers, unsigned instanceOffset = 0)
+    {
+        graphics_->SetVertexBuffers(buffers, instanceOffset);
+    }
+    /// Set index buffer.
+    void SetIndexBuffer(IndexBuffer* buffer) { graphics_->SetIndexBuffer(buffer); }
+    /// Set shaders.
+    void SetShaders(ShaderVariation* vs, ShaderVariation* ps) { graphics_->SetShaders(vs, ps); }
+    /// Set shader float constants.
+    void SetShaderParameter(StringHash param, const float* data, unsigned count) { graphics_->SetShaderParameter(param, data, count); }
+    /// Set shader float constant.
+    void SetShaderParameter(StringHash param, float value) { graphics_->SetShaderParameter(param, value); }
+    /// Set shader integer constant.
+    void SetShaderParameter(StringHash param, int value) { graphics_->SetShaderParameter(param, value); }
+    /// Set shader boolean constant.
+    void SetShaderParameter(StringHash param, bool value) { graphics_->SetShaderParameter(param, value); }
+    /// Set shader color constant.
+    void SetShaderParameter(StringHash param, const Color& color) { graphics_->SetShaderParameter(param, color); }
+    /// Set shader 2D vector constant.
+    void SetShaderParameter(StringHash param, const Vector2& vector) { graphics_->SetShaderParameter(param, vector); }
+    /// Set shader 3x3 matrix constant.
+    void SetShaderParameter(StringHash param, const Matrix3& matrix) { graphics_->SetShaderParameter(param, matrix); }
+    /// Set shader 3D vector constant.
+    void SetShaderParameter(StringHash param, const Vector3& vector) { graphics_->SetShaderParameter(param, vector); }
+    /// Set shader 4x4 matrix constant.
+    void SetShaderParameter(StringHash param, const Matrix4& matrix) { graphics_->SetShaderParameter(param, matrix); }
+    /// Set shader 4D vector constant.
+    void SetShaderParameter(StringHash param, const Vector4& vector) { graphics_->SetShaderParameter(param, vector); }
+    /// Set shader 3x4 matrix constant.
+    void SetShaderParameter(StringHash param, const Matrix3x4& matrix) { graphics_->SetShaderParameter(param, matrix); }
+    /// Set shader constant from a variant. Supported variant types are bool, float, vector2, vector3, vector4, color and buffer.
+    void SetShaderParameter(StringHash param, const Variant& value) { graphics_->SetShaderParameter(param, value); }
+    /// Set all shader constants of a parameter block.
+    void SetShaderParameters(ShaderParameterBlock* block)
+    {
+        if (block)
+            block->Apply(graphics_);
+    }
+    /// Check whether a shader parameter group needs update.
+    bool NeedParameterUpdate(ShaderParameterGroup group, const void* source) { return graphics_->NeedParameterUpdate(group, source); }
+    /// Check whether the current shader program uses a shader parameter.
+    bool HasShaderParameter(StringHash param) { return graphics_->HasShaderParameter(param); }
+    /// Check whether the current pixel shader uses a texture unit.
+    bool HasTextureUnit(TextureUnit unit) { return graphics_->HasTextureUnit(unit); }
+    /// Clear remembered shader parameter source for a group.
+    void ClearParameterSource(ShaderParameterGroup group) { graphics_->ClearParameterSource(group); }
+    /// Clear remembered shader parameter sources.
+    void ClearParameterSources() { graphics_->ClearParameterSources(); }
+    /// Clear remembered transform shader parameter sources.
+    void ClearTransformSources() { graphics_->ClearTransformSources(); }
+    /// Set texture.
+    void SetTexture(unsigned index, Texture* texture) { graphics_->SetTexture(index, texture); }
+    /// Reset all rendertargets, depth-stencil surface and viewport.
+    void ResetRenderTargets() { graphics_->ResetRenderTargets(); }
+    /// Set rendertarget.
+    void SetRenderTarget(unsigned index, RenderSurface* renderTarget) { graphics_->SetRenderTarget(index, renderTarget); }
+    /// Set rendertarget.
+    void SetRenderTarget(unsigned index, Texture2D* texture) { graphics_->SetRenderTarget(index, texture); }
+    /// Set depth-stencil surface.
+    void SetDepthStencil(RenderSurface* depthStencil) { graphics_->SetDepthStencil(depthStencil); }
+    /// Set depth-stencil surface.
+    void SetDepthStencil(Texture2D* texture) { graphics_->SetDepthStencil(texture); }
+    /// Set viewport.
+    void SetViewport(const IntRect& rect) { graphics_->SetViewport(rect); }
+    /// Set blending and alpha-to-coverage modes. Alpha-to-coverage is not supported on Direct3D9.
+    void SetBlendMode(BlendMode mode, bool alphaToCoverage = false) { graphics_->SetBlendMode(mode, alphaToCoverage); }
+    /// Set color write on/off.
+    void SetColorWrite(bool enable) { graphics_->SetColorWrite(enable); }
+    /// Set hardware culling mode.
+    void SetCullMode(CullMode mode) { graphics_->SetCullMode(mode); }
+    /// Set depth bias.
+    void SetDepthBias(float constantBias, float slopeScaledBias) { graphics_->SetDepthBias(constantBias, slopeScaledBias); }
+    /// Set depth compare.
+    void SetDepthTest(CompareMode mode) { graphics_->SetDepthTest(mode); }
+    /// Set depth write on/off.
+    void SetDepthWrite(bool enable) { graphics_->SetDepthWrite(enable); }
+    /// Set polygon fill mode.
+    void SetFillMode(FillMode mode) { graphics_->SetFillMode(mode); }
+    /// Set line antialiasing on/off.
+    void SetLineAntiAlias(bool enable) { graphics_->SetLineAntiAlias(enable); }
+    /// Set scissor test.
+    void SetScissorTest(bool enable, const Rect& rect = Rect::FULL, bool borderInclusive = true)
+    {
+        graphics_->SetScissorTest(enable, rect, borderInclusive);
+    }
+    /// Set scissor test.
+    void SetScissorTest(bool enable, const IntRect& rect) { graphics_->SetScissorTest(enable, rect); }
+    /// Set stencil test.
+    void SetStencilTest
+        (bool enable, CompareMode mode = CMP_ALWAYS, StencilOp pass = OP_KEEP, StencilOp fail = OP_KEEP, StencilOp zFail = OP_KEEP,
+            unsigned stencilRef = 0, unsigned compareMask = M_MAX_UNSIGNED, unsigned writeMask = M_MAX_UNSIGNED)
+    {
+        graphics_->SetStencilTest(enable, mode, pass, fail, zFail, stencilRef, compareMask, writeMask);
+    }
+    /// Set a custom clipping plane. The plane is specified in world space, but is dependent on the view and projection matrices.
+    void SetClipPlane(bool enable, const Plane& clipPlane, const Matrix3x4& view, const Matrix4& projection)
+    {
+        graphics_->SetClipPlane(enable, clipPlane, view, projection);
+    }
+    /// Disable the custom clipping plane.
+    void SetClipPlane(bool enable) { graphics_->SetClipPlane(enable); }
+
+    /// Return whether is recording. Always false.
+    bool IsRecording() const { return false; }
+
+    /// Return number of recorded commands waiting for replay. Always zero.
+    unsigned GetNumCommands() const { return 0; }
+
+    /// Return number of primitives in the recorded draw calls. Always zero.
+    unsigned GetNumPrimitives() const { return 0; }
+
+    /// Return number of recorded draw calls. Always zero.
+    unsigned GetNumBatches() const { return 0; }
+
+    /// Return rendertarget by index.
+    RenderSurface* GetRenderTarget(unsigned index) const { return graphics_->GetRenderTarget(index); }
+    /// Return depth-stencil surface.
+    RenderSurface* GetDepthStencil() const { return graphics_->GetDepthStencil(); }
+    /// Return the viewport.
+    IntRect GetViewport() const { return graphics_->GetViewport(); }
+    /// Return blending mode.
+    BlendMode GetBlendMode() const { return graphics_->GetBlendMode(); }
+    /// Return the current rendertarget width and height.
+    IntVector2 GetRenderTargetDimensions() const { return graphics_->GetRenderTargetDimensions(); }
+
+private:
+    /// Graphics subsystem.
+    WeakPtr<Graphics> graphics_;
+};
+
+}
+
+#endif
@@ -119,7 +119,8 @@ struct URHO3D_API RenderPathCommand
         useFogColor_(false),
         markToStencil_(false),
         useLitBase_(true),
-        vertexLights_(false)
+        vertexLights_(false),
+        clusteredLights_(false)
     {
     }
 
@@ -206,6 +207,8 @@ struct URHO3D_API RenderPathCommand
     bool useLitBase_;
     /// Vertex lights flag.
     bool vertexLights_;
+    /// Clustered lights flag. Unshadowed point and spot lights are applied from the view's light clusters in the scene pass.
+    bool clusteredLights_;
     /// Event name.
     String eventName_;
 };
@@ -34,6 +34,7 @@
 #include "../Graphics/Material.h"
 #include "../Graphics/OcclusionBuffer.h"
 #include "../Graphics/Octree.h"
+#include "../Graphics/RenderCommandList.h"
 #include "../Graphics/Renderer.h"
 #include "../Graphics/RenderPath.h"
 #include "../Graphics/ShaderVariation.h"
@@ -183,7 +184,8 @@ static const char* geometryVSVariations[] =
     "BILLBOARD ",
     "DIRBILLBOARD ",
     "TRAILFACECAM ",
-    "TRAILBONE "
+    "TRAILBONE ",
+    "SKINNED INSTANCED "
 };
 
 static const char* lightVSVariations[] =
@@ -275,6 +277,7 @@ Renderer::Renderer(Context* context) :
     textureQuality_(QUALITY_HIGH),
     materialQuality_(QUALITY_HIGH),
     shadowMapSize_(1024),
+    shadowMapVersion_(0),
     shadowQuality_(SHADOWQUALITY_PCF_16BIT),
     shadowSoftness_(1.0f),
     vsmShadowParams_(0.0000001f, 0.9f),
@@ -298,6 +301,9 @@ Renderer::Renderer(Context* context) :
     dynamicInstancing_(true),
     numExtraInstancingBufferElements_(0),
     threadedOcclusion_(false),
+    visibilityCaching_(true),
+    threadedSubmission_(false),
+    submitPending_(false),
     shadersDirty_(true),
     initialized_(false),
     resetViews_(false)
@@ -310,6 +316,10 @@ Renderer::Renderer(Context* context) :
 
 Renderer::~Renderer()
 {
+#ifdef URHO3D_NULL_GRAPHICS
+    // Make sure the submission thread no longer uses the command list
+    submitThread_.Reset();
+#endif
 }
 
 void Renderer::SetNumViewports(unsigned num)
@@ -558,6 +568,16 @@ void Renderer::SetThreadedOcclusion(bool enable)
     }
 }
 
+void Renderer::SetVisibilityCaching(bool enable)
+{
+    visibilityCaching_ = enable;
+}
+
+void Renderer::SetThreadedSubmission(bool enable)
+{
+    threadedSubmission_ = enable;
+}
+
 void Renderer::ReloadShaders()
 {
     shadersDirty_ = true;
@@ -662,6 +682,40 @@ unsigned Renderer::GetNumOccluders(bool allViews) const
     return numOccluders;
 }
 
+unsigned Renderer::GetNumVisibilityCacheHits(bool allViews) const
+{
+    unsigned numHits = 0;
+    unsigned lastView = allViews ? views_.Size() : 1;
+
+    for (unsigned i = 0; i < lastView; ++i)
+    {
+        View* view = GetActualView(views_[i]);
+        if (!view)
+            continue;
+
+        numHits += view->GetNumVisibilityCacheHits();
+    }
+
+    return numHits;
+}
+
+unsigned Renderer::GetNumVisibilityCacheMisses(bool allViews) const
+{
+    unsigned numMisses = 0;
+    unsigned lastView = allViews ? views_.Size() : 1;
+
+    for (unsigned i = 0; i < lastView; ++i)
+    {
+        View* view = GetActualView(views_[i]);
+        if (!view)
+            continue;
+
+        numMisses += view->GetNumVisibilityCacheMisses();
+    }
+
+    return numMisses;
+}
+
 void Renderer::Update(float timeStep)
 {
     URHO3D_PROFILE(UpdateViews);
@@ -721,6 +775,11 @@ void Renderer::Render()
     graphics_->SetDefaultTextureFilterMode(textureFilterMode_);
     graphics_->SetDefaultTextureAnisotropy((unsigned)textureAnisotropy_);
 
+    // When recording, the commands of all views and the UI are replayed in SubmitCommands(). Only the null graphics backend
+    // records, with the others the command list calls Graphics immediately
+    if (threadedSubmission_)
+        commandList_->BeginRecording();
+
     // If no views that render to the backbuffer, clear the screen so that e.g. the UI is not rendered on top of previous frame
     bool hasBackbufferViews = false;
     for (unsigned i = 0; i < views_.Size(); ++i)
@@ -733,13 +792,13 @@ void Renderer::Render()
     }
     if (!hasBackbufferViews)
     {
-        graphics_->SetBlendMode(BLEND_REPLACE);
-        graphics_->SetColorWrite(true);
-        graphics_->SetDepthWrite(true);
-        graphics_->SetScissorTest(false);
-        graphics_->SetStencilTest(false);
-        graphics_->ResetRenderTargets();
-        graphics_->Clear(CLEAR_COLOR | CLEAR_DEPTH | CLEAR_STENCIL, defaultZone_->GetFogColor());
+        commandList_->SetBlendMode(BLEND_REPLACE);
+        commandList_->SetColorWrite(true);
+        commandList_->SetDepthWrite(true);
+        commandList_->SetScissorTest(false);
+        commandList_->SetStencilTest(false);
+        commandList_->ResetRenderTargets();
+        commandList_->Clear(CLEAR_COLOR | CLEAR_DEPTH | CLEAR_STENCIL, defaultZone_->GetFogColor());
     }
 
     // Render views from last to first. Each main (backbuffer) view is rendered after the auxiliary views it depends on
@@ -753,15 +812,58 @@ void Renderer::Render()
         views_[i]->Render();
     }
 
-    // Copy the number of batches & primitives from Graphics so that we can account for 3D geometry only
-    numPrimitives_ = graphics_->GetNumPrimitives();
-    numBatches_ = graphics_->GetNumBatches();
+    // Copy the number of batches & primitives from Graphics so that we can account for 3D geometry only. Include the draws
+    // that are recorded but not replayed yet
+    numPrimitives_ = graphics_->GetNumPrimitives() + commandList_->GetNumPrimitives();
+    numBatches_ = graphics_->GetNumBatches() + commandList_->GetNumBatches();
 
     // Remove unused occlusion buffers and renderbuffers
     RemoveUnusedBuffers();
 
     // All views done, custom rendering can now be done before UI
+    bool suspended = commandList_->SuspendForEvent(this, E_ENDALLVIEWSRENDER);
     SendEvent(E_ENDALLVIEWSRENDER);
+    if (suspended)
+        commandList_->BeginRecording();
+}
+
+void Renderer::FinishSubmission()
+{
+#ifdef URHO3D_NULL_GRAPHICS
+    if (!submitPending_)
+        return;
+
+    URHO3D_PROFILE(FinishSubmission);
+
+    submitThread_->Wait();
+    commandList_->ClearCommands();
+    submitPending_ = false;
+
+    graphics_->EndFrame();
+#endif
+}
+
+bool Renderer::SubmitCommands()
+{
+#ifdef URHO3D_NULL_GRAPHICS
+    if (!commandList_ || !commandList_->IsRecording())
+        return false;
+
+    commandList_->EndRecording();
+
+    if (!submitThread_)
+    {
+        submitThread_ = new RenderSubmitThread();
+        submitThread_->Run();
+    }
+
+    submitThread_->Submit(commandList_);
+    submitPending_ = true;
+    return true;
+#else
+    // The device-backed graphics backends never record, so the frame has been rendered already
+    return false;
+#endif
 }
 
 void Renderer::DrawDebugGeometry(bool depthTest)
@@ -927,6 +1029,42 @@ Texture2D* Renderer::GetShadowMap(Light* light, Camera* camera, unsigned viewWid
         }
     }
 
+    SharedPtr<Texture2D> newShadowMap = CreateShadowMap(width, height);
+
+    shadowMaps_[searchKey].Push(newShadowMap);
+    if (!reuseShadowMaps_)
+        shadowMapAllocations_[searchKey].Push(light);
+
+    return newShadowMap;
+}
+
+Texture2D* Renderer::GetStaticShadowMap(Light* light)
+{
+    StaticShadowCache& cache = light->GetStaticShadowCache();
+
+    // The static shadow map is not reduced with distance, so that it can be shared by all views
+    int width = NextPowerOfTwo((unsigned)((float)shadowMapSize_ * light->GetShadowResolution()));
+    int height = width;
+    if (light->GetLightType() == LIGHT_POINT)
+    {
+        width *= 2;
+        height *= 3;
+    }
+
+    if (cache.shadowMap_ && cache.shadowMapVersion_ == shadowMapVersion_ && cache.shadowMap_->GetWidth() == width &&
+        cache.shadowMap_->GetHeight() == height)
+        return cache.shadowMap_;
+
+    cache.shadowMap_ = CreateShadowMap(width, height);
+    cache.shadowMapVersion_ = shadowMapVersion_;
+    cache.dirtySplits_ = M_MAX_UNSIGNED;
+    return cache.shadowMap_;
+}
+
+SharedPtr<Texture2D> Renderer::CreateShadowMap(int width, int height)
+{
+    int searchKey = (width << 16) | height;
+
     // Find format and usage of the shadow map
     unsigned shadowMapFormat = 0;
     TextureUsage shadowMapUsage = TEXTURE_DEPTHSTENCIL;
@@ -953,7 +1091,7 @@ Texture2D* Renderer::GetShadowMap(Light* light, Camera* camera, unsigned viewWid
     }
 
     if (!shadowMapFormat)
-        return 0;
+        return SharedPtr<Texture2D>();
 
     SharedPtr<Texture2D> newShadowMap(new Texture2D(context_));
     int retries = 3;
@@ -1000,14 +1138,10 @@ Texture2D* Renderer::GetShadowMap(Light* light, Camera* camera, unsigned viewWid
         }
     }
 
-    // If failed to set size, store a null pointer so that we will not retry
+    // If failed to set size, return a null pointer so that the caller will not retry
     if (!retries)
         newShadowMap.Reset();
 
-    shadowMaps_[searchKey].Push(newShadowMap);
-    if (!reuseShadowMaps_)
-        shadowMapAllocations_[searchKey].Push(light);
-
     return newShadowMap;
 }
 
@@ -1068,11 +1202,11 @@ Texture* Renderer::GetScreenBuffer(int width, int height, unsigned format, int m
             if (persistentKey && Texture::GetDataType(format) == GL_FLOAT)
             {
                 // Note: this loses current rendertarget assignment
-                graphics_->ResetRenderTargets();
-                graphics_->SetRenderTarget(0, newTex2D);
-                graphics_->SetDepthStencil((RenderSurface*)0);
-                graphics_->SetViewport(IntRect(0, 0, width, height));
-                graphics_->Clear(CLEAR_COLOR);
+                commandList_->ResetRenderTargets();
+                commandList_->SetRenderTarget(0, newTex2D);
+                commandList_->SetDepthStencil((RenderSurface*)0);
+                commandList_->SetViewport(IntRect(0, 0, width, height));
+                commandList_->Clear(CLEAR_COLOR);
             }
 #endif
 
@@ -1199,6 +1333,8 @@ void Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows,
         // If instancing is not supported, but was requested, choose static geometry vertex shader instead
         if (batch.geometryType_ == GEOM_INSTANCED && !GetDynamicInstancing())
             batch.geometryType_ = GEOM_STATIC;
+        else if (batch.geometryType_ == GEOM_SKINNED_INSTANCED && !GetDynamicInstancing())
+            batch.geometryType_ = GEOM_SKINNED;
 
         if (batch.geometryType_ == GEOM_STATIC_NOINSTANCING)
             batch.geometryType_ = GEOM_STATIC;
@@ -1280,9 +1416,11 @@ void Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows,
         }
     }
 
-    // Log error if shaders could not be assigned, but only once per technique
+    // Log error if shaders could not be assigned, but only once per technique. Views may set batch shaders from worker
+    // threads, so guard the error set
     if (!batch.vertexShader_ || !batch.pixelShader_)
     {
+        MutexLock lock(rendererMutex_);
         if (!shaderErrorDisplayed_.Contains(tech))
         {
             shaderErrorDisplayed_.Insert(tech);
@@ -1291,6 +1429,14 @@ void Renderer::SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows,
     }
 }
 
+bool Renderer::HasPassShaders(Pass* pass, const BatchQueue& queue) const
+{
+    if (pass->GetShadersLoadedFrameNumber() != shadersChangedFrameNumber_)
+        return false;
+
+    return queue.hasExtraDefines_ ? pass->HasShaders(queue.vsExtraDefinesHash_, queue.psExtraDefinesHash_) : pass->HasShaders();
+}
+
 void Renderer::SetLightVolumeBatchShaders(Batch& batch, Camera* camera, const String& vsName, const String& psName, const String& vsDefines,
     const String& psDefines)
 {
@@ -1357,7 +1503,7 @@ void Renderer::SetCullMode(CullMode mode, Camera* camera)
             mode = CULL_CW;
     }
 
-    graphics_->SetCullMode(mode);
+    commandList_->SetCullMode(mode);
 }
 
 bool Renderer::ResizeInstancingBuffer(unsigned numInstances)
@@ -1400,9 +1546,9 @@ void Renderer::RestoreScreenBufferAllocations()
 void Renderer::OptimizeLightByScissor(Light* light, Camera* camera)
 {
     if (light && light->GetLightType() != LIGHT_DIRECTIONAL)
-        graphics_->SetScissorTest(true, GetLightScissor(light, camera));
+        commandList_->SetScissorTest(true, GetLightScissor(light, camera));
     else
-        graphics_->SetScissorTest(false);
+        commandList_->SetScissorTest(false);
 }
 
 void Renderer::OptimizeLightByStencil(Light* light, Camera* camera)
@@ -1412,7 +1558,7 @@ void Renderer::OptimizeLightByStencil(Light* light, Camera* camera)
         LightType type = light->GetLightType();
         if (type == LIGHT_DIRECTIONAL)
         {
-            graphics_->SetStencilTest(false);
+            commandList_->SetStencilTest(false);
             return;
         }
 
@@ -1430,14 +1576,14 @@ void Renderer::OptimizeLightByStencil(Light* light, Camera* camera)
         // If the camera is actually inside the light volume, do not draw to stencil as it would waste fillrate
         if (lightDist < M_EPSILON)
         {
-            graphics_->SetStencilTest(false);
+            commandList_->SetStencilTest(false);
             return;
         }
 
         // If the stencil value has wrapped, clear the whole stencil first
         if (!lightStencilValue_)
         {
-            graphics_->Clear(CLEAR_STENCIL);
+            commandList_->Clear(CLEAR_STENCIL);
             lightStencilValue_ = 1;
         }
 
@@ -1446,34 +1592,34 @@ void Renderer::OptimizeLightByStencil(Light* light, Camera* camera)
         if (lightDist < camera->GetNearClip() * 2.0f)
         {
             SetCullMode(CULL_CW, camera);
-            graphics_->SetDepthTest(CMP_GREATER);
+            commandList_->SetDepthTest(CMP_GREATER);
         }
         else
         {
             SetCullMode(CULL_CCW, camera);
-            graphics_->SetDepthTest(CMP_LESSEQUAL);
+            commandList_->SetDepthTest(CMP_LESSEQUAL);
         }
 
-        graphics_->SetColorWrite(false);
-        graphics_->SetDepthWrite(false);
-        graphics_->SetStencilTest(true, CMP_ALWAYS, OP_REF, OP_KEEP, OP_KEEP, lightStencilValue_);
-        graphics_->SetShaders(graphics_->GetShader(VS, "Stencil"), graphics_->GetShader(PS, "Stencil"));
-        graphics_->SetShaderParameter(VSP_VIEW, view);
-        graphics_->SetShaderParameter(VSP_VIEWINV, camera->GetEffectiveWorldTransform());
-        graphics_->SetShaderParameter(VSP_VIEWPROJ, projection * view);
-        graphics_->SetShaderParameter(VSP_MODEL, light->GetVolumeTransform(camera));
+        commandList_->SetColorWrite(false);
+        commandList_->SetDepthWrite(false);
+        commandList_->SetStencilTest(true, CMP_ALWAYS, OP_REF, OP_KEEP, OP_KEEP, lightStencilValue_);
+        commandList_->SetShaders(graphics_->GetShader(VS, "Stencil"), graphics_->GetShader(PS, "Stencil"));
+        commandList_->SetShaderParameter(VSP_VIEW, view);
+        commandList_->SetShaderParameter(VSP_VIEWINV, camera->GetEffectiveWorldTransform());
+        commandList_->SetShaderParameter(VSP_VIEWPROJ, projection * view);
+        commandList_->SetShaderParameter(VSP_MODEL, light->GetVolumeTransform(camera));
 
-        geometry->Draw(graphics_);
+        commandList_->Draw(geometry);
 
-        graphics_->ClearTransformSources();
-        graphics_->SetColorWrite(true);
-        graphics_->SetStencilTest(true, CMP_EQUAL, OP_KEEP, OP_KEEP, OP_KEEP, lightStencilValue_);
+        commandList_->ClearTransformSources();
+        commandList_->SetColorWrite(true);
+        commandList_->SetStencilTest(true, CMP_EQUAL, OP_KEEP, OP_KEEP, OP_KEEP, lightStencilValue_);
 
         // Increase stencil value for next light
         ++lightStencilValue_;
     }
     else
-        graphics_->SetStencilTest(false);
+        commandList_->SetStencilTest(false);
 }
 
 const Rect& Renderer::GetLightScissor(Light* light, Camera* camera)
@@ -1614,6 +1760,7 @@ void Renderer::Initialize()
     URHO3D_PROFILE(InitRenderer);
 
     graphics_ = graphics;
+    commandList_ = new RenderCommandList(context_);
 
     if (!graphics_->GetShadowMapFormat())
         drawShadows_ = false;
@@ -1694,6 +1841,13 @@ void Renderer::LoadPassShaders(Pass* pass, Vector<SharedPtr<ShaderVariation> >&
         psDefines += ' ';
     }
 
+    // Add the clustered lights define only if the pass shaders can apply them. Otherwise the pass gets per-light batches
+    if (pass->GetClusteredLights() && queue.clustered_)
+    {
+        vsDefines += "CLUSTERED ";
+        psDefines += "CLUSTERED ";
+    }
+
     // Add defines for VSM in the shadow pass if necessary
     if (pass->GetName() == "shadow"
         && (shadowQuality_ == SHADOWQUALITY_VSM || shadowQuality_ == SHADOWQUALITY_BLUR_VSM))
@@ -1929,6 +2083,8 @@ void Renderer::ResetShadowMaps()
     shadowMaps_.Clear();
     shadowMapAllocations_.Clear();
     colorShadowMaps_.Clear();
+    // Static shadow maps held by lights are recreated on next use
+    ++shadowMapVersion_;
 }
 
 void Renderer::ResetBuffers()
@@ -1990,40 +2146,40 @@ void Renderer::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
 
 void Renderer::BlurShadowMap(View* view, Texture2D* shadowMap, float blurScale)
 {
-    graphics_->SetBlendMode(BLEND_REPLACE);
-    graphics_->SetDepthTest(CMP_ALWAYS);
-    graphics_->SetClipPlane(false);
-    graphics_->SetScissorTest(false);
+    commandList_->SetBlendMode(BLEND_REPLACE);
+    commandList_->SetDepthTest(CMP_ALWAYS);
+    commandList_->SetClipPlane(false);
+    commandList_->SetScissorTest(false);
 
     // Get a temporary render buffer
     Texture2D* tmpBuffer = static_cast<Texture2D*>(GetScreenBuffer(shadowMap->GetWidth(), shadowMap->GetHeight(),
         shadowMap->GetFormat(), 1, false, false, false, false));
-    graphics_->SetRenderTarget(0, tmpBuffer->GetRenderSurface());
-    graphics_->SetDepthStencil(GetDepthStencil(shadowMap->GetWidth(), shadowMap->GetHeight(), shadowMap->GetMultiSample(),
+    commandList_->SetRenderTarget(0, tmpBuffer->GetRenderSurface());
+    commandList_->SetDepthStencil(GetDepthStencil(shadowMap->GetWidth(), shadowMap->GetHeight(), shadowMap->GetMultiSample(),
         shadowMap->GetAutoResolve()));
-    graphics_->SetViewport(IntRect(0, 0, shadowMap->GetWidth(), shadowMap->GetHeight()));
+    commandList_->SetViewport(IntRect(0, 0, shadowMap->GetWidth(), shadowMap->GetHeight()));
 
     // Get shaders
     static const String shaderName("ShadowBlur");
     ShaderVariation* vs = graphics_->GetShader(VS, shaderName);
     ShaderVariation* ps = graphics_->GetShader(PS, shaderName);
-    graphics_->SetShaders(vs, ps);
+    commandList_->SetShaders(vs, ps);
 
     view->SetGBufferShaderParameters(IntVector2(shadowMap->GetWidth(), shadowMap->GetHeight()), IntRect(0, 0, shadowMap->GetWidth(), shadowMap->GetHeight()));
 
     // Horizontal blur of the shadow map
     static const StringHash blurOffsetParam("BlurOffsets");
 
-    graphics_->SetShaderParameter(blurOffsetParam, Vector2(shadowSoftness_ * blurScale / shadowMap->GetWidth(), 0.0f));
-    graphics_->SetTexture(TU_DIFFUSE, shadowMap);
+    commandList_->SetShaderParameter(blurOffsetParam, Vector2(shadowSoftness_ * blurScale / shadowMap->GetWidth(), 0.0f));
+    commandList_->SetTexture(TU_DIFFUSE, shadowMap);
     view->DrawFullscreenQuad(true);
 
     // Vertical blur
-    graphics_->SetRenderTarget(0, shadowMap);
-    graphics_->SetViewport(IntRect(0, 0, shadowMap->GetWidth(), shadowMap->GetHeight()));
-    graphics_->SetShaderParameter(blurOffsetParam, Vector2(0.0f, shadowSoftness_ * blurScale / shadowMap->GetHeight()));
+    commandList_->SetRenderTarget(0, shadowMap);
+    commandList_->SetViewport(IntRect(0, 0, shadowMap->GetWidth(), shadowMap->GetHeight()));
+    commandList_->SetShaderParameter(blurOffsetParam, Vector2(0.0f, shadowSoftness_ * blurScale / shadowMap->GetHeight()));
 
-    graphics_->SetTexture(TU_DIFFUSE, tmpBuffer);
+    commandList_->SetTexture(TU_DIFFUSE, tmpBuffer);
     view->DrawFullscreenQuad(true);
 }
 }
@@ -40,7 +40,9 @@ class Pass;
 class Technique;
 class Octree;
 class Graphics;
+class RenderCommandList;
 class RenderPath;
+class RenderSubmitThread;
 class RenderSurface;
 class ResourceCache;
 class Skeleton;
@@ -237,6 +239,10 @@ public:
     void SetOccluderSizeThreshold(float screenSize);
     /// Set whether to thread occluder rendering. Default false.
     void SetThreadedOcclusion(bool enable);
+    /// Set whether views reuse their octree query and occlusion results from the previous frame for drawables that did not move, as long as the culling camera stays unchanged. Default true.
+    void SetVisibilityCaching(bool enable);
+    /// Set whether to record view and UI rendering into a command list that is replayed on the render submission thread. Only has effect with the null graphics backend. Default false.
+    void SetThreadedSubmission(bool enable);
     /// Set shadow depth bias multiplier for mobile platforms to counteract possible worse shadow map precision. Default 1.0 (no effect.)
     void SetMobileShadowBiasMul(float mul);
     /// Set shadow depth bias addition for mobile platforms to counteract possible worse shadow map precision. Default 0.0 (no effect.)
@@ -325,6 +331,12 @@ public:
     /// Return whether occlusion rendering is threaded.
     bool GetThreadedOcclusion() const { return threadedOcclusion_; }
 
+    /// Return whether views cache their visibility results between frames.
+    bool GetVisibilityCaching() const { return visibilityCaching_; }
+
+    /// Return whether rendering is recorded for threaded submission.
+    bool GetThreadedSubmission() const { return threadedSubmission_; }
+
     /// Return shadow depth bias multiplier for mobile platforms.
     float GetMobileShadowBiasMul() const { return mobileShadowBiasMul_; }
 
@@ -351,6 +363,10 @@ public:
     unsigned GetNumShadowMaps(bool allViews = false) const;
     /// Return number of occluders rendered.
     unsigned GetNumOccluders(bool allViews = false) const;
+    /// Return number of drawables whose visibility was reused from the previous frame.
+    unsigned GetNumVisibilityCacheHits(bool allViews = false) const;
+    /// Return number of drawables whose visibility had to be tested.
+    unsigned GetNumVisibilityCacheMisses(bool allViews = false) const;
 
     /// Return the default zone.
     Zone* GetDefaultZone() const { return defaultZone_; }
@@ -376,10 +392,17 @@ public:
     /// Return the frame update parameters.
     const FrameInfo& GetFrameInfo() const { return frame_; }
 
+    /// Return the command list that views and the UI render through.
+    RenderCommandList* GetCommandList() const { return commandList_; }
+
     /// Update for rendering. Called by HandleRenderUpdate().
     void Update(float timeStep);
     /// Render. Called by Engine.
     void Render();
+    /// Wait until the frame's commands have been replayed on the submission thread, then end the frame. Called by Engine after the frame limiter wait.
+    void FinishSubmission();
+    /// Submit the commands recorded during the frame. Return true if they were handed to the submission thread, in which case ending the frame is deferred to FinishSubmission(). Called by Engine.
+    bool SubmitCommands();
     /// Add debug geometry to the debug renderer.
     void DrawDebugGeometry(bool depthTest);
     /// Queue a render surface's viewports for rendering. Called by the surface, or by View.
@@ -393,6 +416,8 @@ public:
     Geometry* GetQuadGeometry();
     /// Allocate a shadow map. If shadow map reuse is disabled, a different map is returned each time.
     Texture2D* GetShadowMap(Light* light, Camera* camera, unsigned viewWidth, unsigned viewHeight);
+    /// Return the persistent shadow map of a light with static shadows, creating it if necessary.
+    Texture2D* GetStaticShadowMap(Light* light);
     /// Allocate a rendertarget or depth-stencil texture for deferred rendering or postprocessing. Should only be called during actual rendering, not before.
     Texture* GetScreenBuffer
         (int width, int height, unsigned format, int multiSample, bool autoResolve, bool cubemap, bool filtered, bool srgb, unsigned persistentKey = 0);
@@ -408,6 +433,8 @@ public:
     View* GetPreparedView(Camera* cullCamera);
     /// Choose shaders for a forward rendering batch. The related batch queue is provided in case it has extra shader compilation defines.
     void SetBatchShaders(Batch& batch, Technique* tech, bool allowShadows, const BatchQueue& queue);
+    /// Return whether a pass has up to date shaders for a batch queue, so that SetBatchShaders() does not need to load them. Is thread-safe.
+    bool HasPassShaders(Pass* pass, const BatchQueue& queue) const;
     /// Choose shaders for a deferred light volume batch.
     void SetLightVolumeBatchShaders
         (Batch& batch, Camera* camera, const String& vsName, const String& psName, const String& vsDefines, const String& psDefines);
@@ -456,6 +483,8 @@ private:
     void ResetShadowMapAllocations();
     /// Reset screem buffer allocation counts.
     void ResetScreenBufferAllocations();
+    /// Create a shadow map texture with the current shadow quality.
+    SharedPtr<Texture2D> CreateShadowMap(int width, int height);
     /// Remove all shadow maps. Called when global shadow map resolution or format is changed.
     void ResetShadowMaps();
     /// Remove all occlusion and screen buffers.
@@ -471,6 +500,12 @@ private:
 
     /// Graphics subsystem.
     WeakPtr<Graphics> graphics_;
+    /// Command list for view and UI rendering.
+    SharedPtr<RenderCommandList> commandList_;
+#ifdef URHO3D_NULL_GRAPHICS
+    /// Render submission thread. Only the null graphics backend records the commands for it.
+    SharedPtr<RenderSubmitThread> submitThread_;
+#endif
     /// Default renderpath.
     SharedPtr<RenderPath> defaultRenderPath_;
     /// Default non-textured material technique.
@@ -529,7 +564,7 @@ private:
     HashSet<Octree*> updatedOctrees_;
     /// Techniques for which missing shader error has been displayed.
     HashSet<Technique*> shaderErrorDisplayed_;
-    /// Mutex for shadow camera allocation.
+    /// Mutex for shadow camera allocation and shader error reporting.
     Mutex rendererMutex_;
     /// Current variation names for deferred light volume shaders.
     Vector<String> deferredLightPSVariations_;
@@ -545,6 +580,8 @@ private:
     int materialQuality_;
     /// Shadow map resolution.
     int shadowMapSize_;
+    /// Shadow map version. Changes when shadow maps are reset, so that static shadow maps get recreated.
+    unsigned shadowMapVersion_;
     /// Shadow quality.
     ShadowQuality shadowQuality_;
     /// Shadow softness, only works when SHADOWQUALITY_BLUR_VSM is used.
@@ -597,6 +634,12 @@ private:
     int numExtraInstancingBufferElements_;
     /// Threaded occlusion rendering flag.
     bool threadedOcclusion_;
+    /// Visibility caching flag.
+    bool visibilityCaching_;
+    /// Threaded submission flag.
+    bool threadedSubmission_;
+    /// Submitted commands pending on the submission thread flag.
+    bool submitPending_;
     /// Shaders need reloading flag.
     bool shadersDirty_;
     /// Initialized flag.
@@ -0,0 +1,238 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Variant.h"
+#include "../Graphics/Graphics.h"
+#include "../Graphics/ShaderParameterBlock.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static unsigned nextBlockVersion = 1;
+
+ShaderParameterBlock::ShaderParameterBlock() :
+    version_(nextBlockVersion++)
+{
+}
+
+void ShaderParameterBlock::AddParameter(StringHash param, const float* data, unsigned count)
+{
+    AddParameter(param, SPO_FLOATS, data, count);
+}
+
+void ShaderParameterBlock::AddParameter(StringHash param, float value)
+{
+    AddParameter(param, SPO_FLOAT, &value, 1);
+}
+
+void ShaderParameterBlock::AddParameter(StringHash param, int value)
+{
+    float bits;
+    memcpy(&bits, &value, sizeof bits);
+    AddParameter(param, SPO_INT, &bits, 1);
+}
+
+void ShaderParameterBlock::AddParameter(StringHash param, bool value)
+{
+    int intValue = value ? 1 : 0;
+    float bits;
+    memcpy(&bits, &intValue, sizeof bits);
+    AddParameter(param, SPO_BOOL, &bits, 1);
+}
+
+void ShaderParameterBlock::AddParameter(StringHash param, const Color& color)
+{
+    AddParameter(param, SPO_COLOR, color.Data(), 4);
+}
+
+void ShaderParameterBlock::AddParameter(StringHash param, const Vector2& vector)
+{
+    AddParameter(param, SPO_VECTOR2, vector.Data(), 2);
+}
+
+void ShaderParameterBlock::AddParameter(StringHash param, const Matrix3& matrix)
+{
+    AddParameter(param, SPO_MATRIX3, matrix.Data(), 9);
+}
+
+void ShaderParameterBlock::AddParameter(StringHash param, const Vector3& vector)
+{
+    AddParameter(param, SPO_VECTOR3, vector.Data(), 3);
+}
+
+void ShaderParameterBlock::AddParameter(StringHash param, const Matrix4& matrix)
+{
+    AddParameter(param, SPO_MATRIX4, matrix.Data(), 16);
+}
+
+void ShaderParameterBlock::AddParameter(StringHash param, const Vector4& vector)
+{
+    AddParameter(param, SPO_VECTOR4, vector.Data(), 4);
+}
+
+void ShaderParameterBlock::AddParameter(StringHash param, const Matrix3x4& matrix)
+{
+    AddParameter(param, SPO_MATRIX3X4, matrix.Data(), 12);
+}
+
+void ShaderParameterBlock::AddParameter(StringHash param, const Variant& value)
+{
+    // Decompose into the typed overloads the same way Graphics does
+    switch (value.GetType())
+    {
+    case VAR_BOOL:
+        AddParameter(param, value.GetBool());
+        break;
+
+    case VAR_INT:
+        AddParameter(param, value.GetInt());
+        break;
+
+    case VAR_FLOAT:
+    case VAR_DOUBLE:
+        AddParameter(param, value.GetFloat());
+        break;
+
+    case VAR_VECTOR2:
+        AddParameter(param, value.GetVector2());
+        break;
+
+    case VAR_VECTOR3:
+        AddParameter(param, value.GetVector3());
+        break;
+
+    case VAR_VECTOR4:
+        AddParameter(param, value.GetVector4());
+        break;
+
+    case VAR_COLOR:
+        AddParameter(param, value.GetColor());
+        break;
+
+    case VAR_MATRIX3:
+        AddParameter(param, value.GetMatrix3());
+        break;
+
+    case VAR_MATRIX3X4:
+        AddParameter(param, value.GetMatrix3x4());
+        break;
+
+    case VAR_MATRIX4:
+        AddParameter(param, value.GetMatrix4());
+        break;
+
+    case VAR_BUFFER:
+        {
+            const PODVector<unsigned char>& buffer = value.GetBuffer();
+            if (buffer.Size() >= sizeof(float))
+                AddParameter(param, reinterpret_cast<const float*>(&buffer[0]), buffer.Size() / sizeof(float));
+        }
+        break;
+
+    default:
+        // Unsupported parameter type, do nothing
+        break;
+    }
+}
+
+void ShaderParameterBlock::Apply(Graphics* graphics) const
+{
+    for (PODVector<ShaderParameterBlockEntry>::ConstIterator i = parameters_.Begin(); i != parameters_.End(); ++i)
+    {
+        const float* data = &data_[i->start_];
+
+        switch (i->overload_)
+        {
+        case SPO_FLOATS:
+            graphics->SetShaderParameter(i->name_, data, i->count_);
+            break;
+
+        case SPO_FLOAT:
+            graphics->SetShaderParameter(i->name_, data[0]);
+            break;
+
+        case SPO_INT:
+            {
+                int value;
+                memcpy(&value, data, sizeof value);
+                graphics->SetShaderParameter(i->name_, value);
+            }
+            break;
+
+        case SPO_BOOL:
+            {
+                int value;
+                memcpy(&value, data, sizeof value);
+                graphics->SetShaderParameter(i->name_, value != 0);
+            }
+            break;
+
+        case SPO_COLOR:
+            graphics->SetShaderParameter(i->name_, Color(data));
+            break;
+
+        case SPO_VECTOR2:
+            graphics->SetShaderParameter(i->name_, Vector2(data));
+            break;
+
+        case SPO_MATRIX3:
+            graphics->SetShaderParameter(i->name_, Matrix3(data));
+            break;
+
+        case SPO_VECTOR3:
+            graphics->SetShaderParameter(i->name_, Vector3(data));
+            break;
+
+        case SPO_MATRIX4:
+            graphics->SetShaderParameter(i->name_, Matrix4(data));
+            break;
+
+        case SPO_VECTOR4:
+            graphics->SetShaderParameter(i->name_, Vector4(data));
+            break;
+
+        case SPO_MATRIX3X4:
+            graphics->SetShaderParameter(i->name_, Matrix3x4(data));
+            break;
+        }
+    }
+}
+
+void ShaderParameterBlock::AddParameter(StringHash param, ShaderParameterOverload overload, const float* data, unsigned count)
+{
+    ShaderParameterBlockEntry entry;
+    entry.name_ = param;
+    entry.overload_ = overload;
+    entry.start_ = data_.Size();
+    entry.count_ = count;
+    parameters_.Push(entry);
+
+    data_.Resize(entry.start_ + count);
+    if (count)
+        memcpy(&data_[entry.start_], data, count * sizeof(float));
+}
+
+}
@@ -0,0 +1,126 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../Math/StringHash.h"
+
+namespace Urho3D
+{
+
+class Color;
+class Graphics;
+class Matrix3;
+class Matrix3x4;
+class Matrix4;
+class Variant;
+class Vector2;
+class Vector3;
+class Vector4;
+
+/// Graphics::SetShaderParameter overload of a stored or recorded shader parameter.
+enum ShaderParameterOverload
+{
+    SPO_FLOATS = 0,
+    SPO_FLOAT,
+    SPO_INT,
+    SPO_BOOL,
+    SPO_COLOR,
+    SPO_VECTOR2,
+    SPO_MATRIX3,
+    SPO_VECTOR3,
+    SPO_MATRIX4,
+    SPO_VECTOR4,
+    SPO_MATRIX3X4
+};
+
+/// Shader parameter in a shader parameter block.
+struct ShaderParameterBlockEntry
+{
+    /// Parameter name hash.
+    StringHash name_;
+    /// Overload to apply the parameter with.
+    ShaderParameterOverload overload_;
+    /// Start index in the block data.
+    unsigned start_;
+    /// Number of data values.
+    unsigned count_;
+};
+
+/// Prebuilt set of shader parameters, applied to Graphics as a unit. A block is filled once and not modified after it has been used for rendering. Changed parameters go into a new block with a new version stamp, so that comparing the version is enough to skip an unchanged block, and recorded command lists may keep referring to the old block.
+class URHO3D_API ShaderParameterBlock : public RefCounted
+{
+public:
+    /// Construct empty with a new version stamp.
+    ShaderParameterBlock();
+
+    /// Add a float array parameter.
+    void AddParameter(StringHash param, const float* data, unsigned count);
+    /// Add a float parameter.
+    void AddParameter(StringHash param, float value);
+    /// Add an integer parameter.
+    void AddParameter(StringHash param, int value);
+    /// Add a boolean parameter.
+    void AddParameter(StringHash param, bool value);
+    /// Add a color parameter.
+    void AddParameter(StringHash param, const Color& color);
+    /// Add a Vector2 parameter.
+    void AddParameter(StringHash param, const Vector2& vector);
+    /// Add a Matrix3 parameter.
+    void AddParameter(StringHash param, const Matrix3& matrix);
+    /// Add a Vector3 parameter.
+    void AddParameter(StringHash param, const Vector3& vector);
+    /// Add a Matrix4 parameter.
+    void AddParameter(StringHash param, const Matrix4& matrix);
+    /// Add a Vector4 parameter.
+    void AddParameter(StringHash param, const Vector4& vector);
+    /// Add a Matrix3x4 parameter.
+    void AddParameter(StringHash param, const Matrix3x4& matrix);
+    /// Add a parameter from a variant. Unsupported types are ignored like in Graphics.
+    void AddParameter(StringHash param, const Variant& value);
+
+    /// Set all parameters to Graphics.
+    void Apply(Graphics* graphics) const;
+
+    /// Return version stamp. Unique among the blocks created during the application's lifetime.
+    unsigned GetVersion() const { return version_; }
+    /// Return number of parameters.
+    unsigned GetNumParameters() const { return parameters_.Size(); }
+    /// Return the parameters.
+    const PODVector<ShaderParameterBlockEntry>& GetParameters() const { return parameters_; }
+    /// Return the parameter data.
+    const PODVector<float>& GetData() const { return data_; }
+
+private:
+    /// Add a parameter with its data.
+    void AddParameter(StringHash param, ShaderParameterOverload overload, const float* data, unsigned count);
+
+    /// Parameters.
+    PODVector<ShaderParameterBlockEntry> parameters_;
+    /// Parameter data. Integer and boolean values are stored as their bit pattern.
+    PODVector<float> data_;
+    /// Version stamp.
+    unsigned version_;
+};
+
+}
@@ -23,7 +23,9 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
 #include "../Graphics/AnimatedModel.h"
 #include "../Graphics/Batch.h"
 #include "../Graphics/Camera.h"
@@ -44,10 +46,22 @@ namespace Urho3D
 
 extern const char* GEOMETRY_CATEGORY;
 
+/// Model metadata key naming the streamed detail model.
+static const char* DETAIL_MODEL_METADATA = "DetailModel";
+/// LOD distance multiplier beyond which a loaded detail model is released.
+static const float DETAIL_RELEASE_FACTOR = 1.25f;
+/// Default time in seconds after which a loaded detail model is released while not drawn.
+static const float DEFAULT_DETAIL_RELEASE_TIME = 5.0f;
+
 StaticModel::StaticModel(Context* context) :
     Drawable(context, DRAWABLE_GEOMETRY),
     occlusionLodLevel_(M_MAX_UNSIGNED),
-    materialsAttr_(Material::GetTypeStatic())
+    materialsAttr_(Material::GetTypeStatic()),
+    detailDistance_(0.0f),
+    detailReleaseTime_(DEFAULT_DETAIL_RELEASE_TIME),
+    detailOffscreenTime_(0.0f),
+    detailRequested_(false),
+    detailLoading_(false)
 {
 }
 
@@ -71,6 +85,8 @@ void StaticModel::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("LOD Bias", GetLodBias, SetLodBias, float, 1.0f, AM_DEFAULT);
     URHO3D_COPY_BASE_ATTRIBUTES(Drawable);
     URHO3D_ATTRIBUTE("Occlusion LOD Level", int, occlusionLodLevel_, M_MAX_UNSIGNED, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Detail Release Time", GetDetailReleaseTime, SetDetailReleaseTime, float, DEFAULT_DETAIL_RELEASE_TIME,
+        AM_DEFAULT);
 }
 
 void StaticModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQueryResult>& results)
@@ -153,6 +169,57 @@ void StaticModel::UpdateBatches(const FrameInfo& frame)
         lodDistance_ = newLodDistance;
         CalculateLodLevels();
     }
+
+    // Need the streamed detail levels when close enough. Keep them a bit further out to avoid reloading at the boundary
+    if (!detailModelName_.Empty())
+        detailRequested_ = lodDistance_ < detailDistance_ * (detailModel_ ? DETAIL_RELEASE_FACTOR : 1.0f);
+}
+
+void StaticModel::UpdateGeometry(const FrameInfo& frame)
+{
+    if (detailRequested_ && !detailModel_)
+    {
+        ResourceCache* cache = GetSubsystem<ResourceCache>();
+        Model* detailModel = cache->GetExistingResource<Model>(detailModelName_);
+        if (!detailModel)
+        {
+            // Keep drawing the resident levels until the background load finishes. Queue it only once, as the load
+            // result event tells whether to keep waiting
+            if (!detailLoading_)
+            {
+                detailLoading_ = true;
+                SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, URHO3D_HANDLER(StaticModel, HandleDetailModelLoaded));
+                cache->BackgroundLoadResource<Model>(detailModelName_);
+            }
+            return;
+        }
+
+        if (detailLoading_)
+        {
+            detailLoading_ = false;
+            UnsubscribeFromEvent(E_RESOURCEBACKGROUNDLOADED);
+        }
+
+        if (detailModel->GetNumGeometries() != geometries_.Size())
+        {
+            URHO3D_LOGERROR("Detail model " + detailModelName_ + " does not match the geometries of model " + model_->GetName());
+            detailModelName_.Clear();
+            detailRequested_ = false;
+            return;
+        }
+
+        detailModel_ = detailModel;
+        detailOffscreenTime_ = 0.0f;
+        SetLodGeometries(detailModel_);
+
+        // Batches of a frame may still refer to the detail geometries, so check for swapping back only after rendering
+        SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(StaticModel, HandleDetailModelRelease));
+    }
+}
+
+UpdateGeometryType StaticModel::GetUpdateGeometryType()
+{
+    return detailRequested_ && !detailModel_ ? UPDATE_MAIN_THREAD : UPDATE_NONE;
 }
 
 Geometry* StaticModel::GetLodGeometry(unsigned batchIndex, unsigned level)
@@ -245,6 +312,12 @@ void StaticModel::SetModel(Model* model)
         UnsubscribeFromEvent(model_, E_RELOADFINISHED);
 
     model_ = model;
+    detailModelName_.Clear();
+    detailModel_.Reset();
+    detailRequested_ = false;
+    detailLoading_ = false;
+    UnsubscribeFromEvent(E_ENDFRAME);
+    UnsubscribeFromEvent(E_RESOURCEBACKGROUNDLOADED);
 
     if (model)
     {
@@ -264,6 +337,24 @@ void StaticModel::SetModel(Model* model)
 
         SetBoundingBox(model->GetBoundingBox());
         ResetLodLevels();
+
+        // Stream the finer LOD levels from a separate model if the metadata names one. It is needed below the first LOD
+        // distance of the resident levels
+        const String& detailModelName = model->GetMetadata(DETAIL_MODEL_METADATA).GetString();
+        if (!detailModelName.Empty())
+        {
+            detailDistance_ = 0.0f;
+            for (unsigned i = 0; i < geometries_.Size(); ++i)
+            {
+                if (geometries_[i][0])
+                    detailDistance_ = Max(detailDistance_, geometries_[i][0]->GetLodDistance());
+            }
+
+            if (detailDistance_ > 0.0f && GetSubsystem<ResourceCache>()->Exists(detailModelName))
+                detailModelName_ = detailModelName;
+            else
+                URHO3D_LOGWARNING("Detail model " + detailModelName + " of model " + model->GetName() + " not found or not needed");
+        }
     }
     else
     {
@@ -301,6 +392,12 @@ void StaticModel::SetOcclusionLodLevel(unsigned level)
     MarkNetworkUpdate();
 }
 
+void StaticModel::SetDetailReleaseTime(float time)
+{
+    detailReleaseTime_ = Max(time, 0.0f);
+    MarkNetworkUpdate();
+}
+
 void StaticModel::ApplyMaterialList(const String& fileName)
 {
     String useFileName = fileName;
@@ -445,6 +542,21 @@ void StaticModel::CalculateLodLevels()
     }
 }
 
+void StaticModel::SetLodGeometries(Model* model)
+{
+    const Vector<Vector<SharedPtr<Geometry> > >& geometries = model->GetGeometries();
+    for (unsigned i = 0; i < geometries_.Size(); ++i)
+    {
+        geometries_[i] = geometries[i];
+        if (!geometries_[i].Size())
+            geometries_[i].Resize(1);
+        batches_[i].geometry_ = geometries_[i][0];
+        geometryData_[i].lodLevel_ = 0;
+    }
+
+    CalculateLodLevels();
+}
+
 void StaticModel::HandleModelReloadFinished(StringHash eventType, VariantMap& eventData)
 {
     Model* currentModel = model_;
@@ -452,4 +564,56 @@ void StaticModel::HandleModelReloadFinished(StringHash eventType, VariantMap& ev
     SetModel(currentModel);
 }
 
+void StaticModel::HandleDetailModelLoaded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ResourceBackgroundLoaded;
+
+    if (eventData[P_RESOURCENAME].GetString() != detailModelName_)
+        return;
+
+    UnsubscribeFromEvent(E_RESOURCEBACKGROUNDLOADED);
+    detailLoading_ = false;
+
+    // Do not retry a failed load every frame, but keep using the resident levels
+    if (!eventData[P_SUCCESS].GetBool())
+    {
+        URHO3D_LOGERROR("Failed to load detail model " + detailModelName_ + " of model " + model_->GetName());
+        detailModelName_.Clear();
+        detailRequested_ = false;
+    }
+}
+
+void StaticModel::HandleDetailModelRelease(StringHash eventType, VariantMap& eventData)
+{
+    if (!detailModel_ || !model_)
+    {
+        UnsubscribeFromEvent(E_ENDFRAME);
+        return;
+    }
+
+    // The request is only updated while the model is drawn, either in a view or as a shadow caster. Release also when it
+    // has not been drawn for the release time
+    if (detailRequested_)
+    {
+        if (IsInView((Camera*)0))
+        {
+            detailOffscreenTime_ = 0.0f;
+            return;
+        }
+
+        detailOffscreenTime_ += GetSubsystem<Time>()->GetTimeStep();
+        if (detailOffscreenTime_ < detailReleaseTime_)
+            return;
+        detailRequested_ = false;
+    }
+
+    UnsubscribeFromEvent(E_ENDFRAME);
+    SetLodGeometries(model_);
+
+    // Unload the detail model unless other drawables still use it
+    String detailModelName = detailModel_->GetName();
+    detailModel_.Reset();
+    GetSubsystem<ResourceCache>()->ReleaseResource<Model>(detailModelName);
+}
+
 }
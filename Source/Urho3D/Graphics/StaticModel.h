@@ -55,6 +55,10 @@ public:
     virtual void ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQueryResult>& results);
     /// Calculate distance and prepare batches for rendering. May be called from worker thread(s), possibly re-entrantly.
     virtual void UpdateBatches(const FrameInfo& frame);
+    /// Swap between the resident and streamed detail LOD levels when needed. Called from the main thread.
+    virtual void UpdateGeometry(const FrameInfo& frame);
+    /// Return whether a geometry update is necessary, and if it can happen in a worker thread.
+    virtual UpdateGeometryType GetUpdateGeometryType();
     /// Return the geometry for a specific LOD level.
     virtual Geometry* GetLodGeometry(unsigned batchIndex, unsigned level);
     /// Return number of occlusion geometry triangles.
@@ -70,12 +74,17 @@ public:
     virtual bool SetMaterial(unsigned index, Material* material);
     /// Set occlusion LOD level. By default (M_MAX_UNSIGNED) same as visible.
     void SetOcclusionLodLevel(unsigned level);
+    /// Set time in seconds after which a loaded detail model is released while the model is not drawn.
+    void SetDetailReleaseTime(float time);
     /// Apply default materials from a material list file. If filename is empty (default), the model's resource name with extension .txt will be used.
     void ApplyMaterialList(const String& fileName = String::EMPTY);
 
     /// Return model.
     Model* GetModel() const { return model_; }
 
+    /// Return the streamed detail model named by the model's metadata, if currently loaded and in use.
+    Model* GetDetailModel() const { return detailModel_; }
+
     /// Return number of geometries.
     unsigned GetNumGeometries() const { return geometries_.Size(); }
 
@@ -85,6 +94,9 @@ public:
     /// Return occlusion LOD level.
     unsigned GetOcclusionLodLevel() const { return occlusionLodLevel_; }
 
+    /// Return time in seconds after which a loaded detail model is released while the model is not drawn.
+    float GetDetailReleaseTime() const { return detailReleaseTime_; }
+
     /// Determines if the given world space point is within the model geometry.
     bool IsInside(const Vector3& point) const;
     /// Determines if the given local space point is within the model geometry.
@@ -110,6 +122,8 @@ protected:
     void ResetLodLevels();
     /// Choose LOD levels based on distance.
     void CalculateLodLevels();
+    /// Use the LOD levels of a model, which must have the same number of geometries, and choose the level again.
+    void SetLodGeometries(Model* model);
 
     /// Extra per-geometry data.
     PODVector<StaticModelGeometryData> geometryData_;
@@ -121,10 +135,28 @@ protected:
     unsigned occlusionLodLevel_;
     /// Material list attribute.
     mutable ResourceRefList materialsAttr_;
+    /// Streamed detail model resource name from the model's metadata.
+    String detailModelName_;
+    /// LOD distance below which the detail model is needed.
+    float detailDistance_;
+    /// Detail model whose LOD levels are in use.
+    SharedPtr<Model> detailModel_;
+    /// Time after which a loaded detail model is released while not drawn.
+    float detailReleaseTime_;
+    /// Time the loaded detail model has not been drawn.
+    float detailOffscreenTime_;
+    /// Detail model needed flag. Set during batch update.
+    bool detailRequested_;
+    /// Detail model background load queued and not yet finished flag.
+    bool detailLoading_;
 
 private:
     /// Handle model reload finished.
     void HandleModelReloadFinished(StringHash eventType, VariantMap& eventData);
+    /// Handle background load of the detail model finished. Stop requesting the detail model if it failed.
+    void HandleDetailModelLoaded(StringHash eventType, VariantMap& eventData);
+    /// Handle end of frame while the detail model is in use. Release it once no longer requested, or after not being drawn for the release time.
+    void HandleDetailModelRelease(StringHash eventType, VariantMap& eventData);
 };
 
 }
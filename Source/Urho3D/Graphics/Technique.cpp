@@ -80,6 +80,7 @@ Pass::Pass(const String& name) :
     lightingMode_(LIGHTING_UNLIT),
     shadersLoadedFrameNumber_(0),
     alphaToCoverage_(false),
+    clusteredLights_(false),
     depthWrite_(true),
     isDesktop_(false)
 {
@@ -128,6 +129,11 @@ void Pass::SetAlphaToCoverage(bool enable)
     alphaToCoverage_ = enable;
 }
 
+void Pass::SetClusteredLights(bool enable)
+{
+    clusteredLights_ = enable;
+}
+
 
 void Pass::SetIsDesktop(bool enable)
 {
@@ -228,6 +234,18 @@ Vector<SharedPtr<ShaderVariation> >& Pass::GetPixelShaders(const StringHash& ext
         return extraPixelShaders_[extraDefinesHash];
 }
 
+bool Pass::HasShaders(const StringHash& vsExtraDefinesHash, const StringHash& psExtraDefinesHash) const
+{
+    const Vector<SharedPtr<ShaderVariation> >* vertexShaders = &vertexShaders_;
+    const Vector<SharedPtr<ShaderVariation> >* pixelShaders = &pixelShaders_;
+    if (vsExtraDefinesHash.Value())
+        vertexShaders = extraVertexShaders_[vsExtraDefinesHash];
+    if (psExtraDefinesHash.Value())
+        pixelShaders = extraPixelShaders_[psExtraDefinesHash];
+
+    return vertexShaders && pixelShaders && vertexShaders->Size() && pixelShaders->Size();
+}
+
 unsigned Technique::basePassIndex = 0;
 unsigned Technique::alphaPassIndex = 0;
 unsigned Technique::materialPassIndex = 0;
@@ -352,6 +370,9 @@ bool Technique::BeginLoad(Deserializer& source)
 
             if (passElem.HasAttribute("alphatocoverage"))
                 newPass->SetAlphaToCoverage(passElem.GetBool("alphatocoverage"));
+
+            if (passElem.HasAttribute("clusteredlights"))
+                newPass->SetClusteredLights(passElem.GetBool("clusteredlights"));
         }
         else
             URHO3D_LOGERROR("Missing pass name");
@@ -396,6 +417,7 @@ SharedPtr<Technique> Technique::Clone(const String& cloneName) const
         newPass->SetLightingMode(srcPass->GetLightingMode());
         newPass->SetDepthWrite(srcPass->GetDepthWrite());
         newPass->SetAlphaToCoverage(srcPass->GetAlphaToCoverage());
+        newPass->SetClusteredLights(srcPass->GetClusteredLights());
         newPass->SetIsDesktop(srcPass->IsDesktop());
         newPass->SetVertexShader(srcPass->GetVertexShader());
         newPass->SetPixelShader(srcPass->GetPixelShader());
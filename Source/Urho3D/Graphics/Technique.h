@@ -59,6 +59,8 @@ public:
     void SetDepthWrite(bool enable);
     /// Set alpha-to-coverage on/off.
     void SetAlphaToCoverage(bool enable);
+    /// Set whether the pass shaders apply clustered lights under the CLUSTERED define. Other passes get per-light batches for them.
+    void SetClusteredLights(bool enable);
     /// Set whether requires desktop level hardware.
     void SetIsDesktop(bool enable);
     /// Set vertex shader name.
@@ -105,6 +107,9 @@ public:
     /// Return alpha-to-coverage mode.
     bool GetAlphaToCoverage() const { return alphaToCoverage_; }
 
+    /// Return whether the pass shaders apply clustered lights.
+    bool GetClusteredLights() const { return clusteredLights_; }
+
     /// Return whether requires desktop level hardware.
     bool IsDesktop() const { return isDesktop_; }
 
@@ -136,6 +141,8 @@ public:
     Vector<SharedPtr<ShaderVariation> >& GetVertexShaders(const StringHash& extraDefinesHash);
     /// Return pixel shaders with extra defines from the renderpath.
     Vector<SharedPtr<ShaderVariation> >& GetPixelShaders(const StringHash& extraDefinesHash);
+    /// Return whether vertex and pixel shaders have been loaded, optionally with extra defines from the renderpath. Does not modify the pass, so is safe to call from worker threads.
+    bool HasShaders(const StringHash& vsExtraDefinesHash = StringHash::ZERO, const StringHash& psExtraDefinesHash = StringHash::ZERO) const;
     /// Return the effective vertex shader defines, accounting for excludes. Called internally by Renderer.
     String GetEffectiveVertexShaderDefines() const;
     /// Return the effective pixel shader defines, accounting for excludes. Called internally by Renderer.
@@ -158,6 +165,8 @@ private:
     bool depthWrite_;
     /// Alpha-to-coverage mode.
     bool alphaToCoverage_;
+    /// Clustered lights support flag.
+    bool clusteredLights_;
     /// Require desktop level hardware flag.
     bool isDesktop_;
     /// Vertex shader name.
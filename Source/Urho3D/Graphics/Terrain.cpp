@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DrawableEvents.h"
 #include "../Graphics/Geometry.h"
 #include "../Graphics/IndexBuffer.h"
@@ -48,10 +49,12 @@ extern const char* GEOMETRY_CATEGORY;
 
 static const Vector3 DEFAULT_SPACING(1.0f, 0.25f, 1.0f);
 static const unsigned MIN_LOD_LEVELS = 1;
-static const unsigned MAX_LOD_LEVELS = 4;
+static const unsigned MAX_LOD_LEVELS = 7;
 static const int DEFAULT_PATCH_SIZE = 32;
 static const int MIN_PATCH_SIZE = 4;
-static const int MAX_PATCH_SIZE = 128;
+static const int MAX_PATCH_SIZE = 256;
+static const unsigned TERRAIN_VERTEX_FLOATS = 12;
+static const float MORPH_STEPS = 16.0f;
 static const unsigned STITCH_NORTH = 1;
 static const unsigned STITCH_SOUTH = 2;
 static const unsigned STITCH_WEST = 4;
@@ -77,6 +80,58 @@ inline void GrowUpdateRegion(IntRect& updateRegion, int x, int y)
     }
 }
 
+/// Terrain patch vertex data built in a worker thread, to be uploaded in the main thread.
+struct TerrainPatchBuildData
+{
+    /// Patch.
+    TerrainPatch* patch_;
+    /// Interleaved vertex data.
+    SharedArrayPtr<float> vertexData_;
+    /// Positions for raycasts and decals.
+    SharedArrayPtr<unsigned char> cpuVertexData_;
+    /// Positions lowered to the neighborhood minimum for occlusion.
+    SharedArrayPtr<unsigned char> occlusionCpuVertexData_;
+    /// Local-space bounding box.
+    BoundingBox box_;
+    /// Height data vertices to smooth, excluding the last row. The last column is left to the east neighbor if it is rebuilt too.
+    IntRect smoothRect_;
+    /// Height data vertices to smooth on the last row. Left to the north neighbors if they are rebuilt too.
+    IntRect smoothNorthRect_;
+};
+
+inline float QuantizeMorph(float morph)
+{
+    return Round(morph * MORPH_STEPS) / MORPH_STEPS;
+}
+
+void SmoothTerrainPatchesWork(const WorkItem* item, unsigned threadIndex)
+{
+    Terrain* terrain = reinterpret_cast<Terrain*>(item->aux_);
+    TerrainPatchBuildData* start = reinterpret_cast<TerrainPatchBuildData*>(item->start_);
+    TerrainPatchBuildData* end = reinterpret_cast<TerrainPatchBuildData*>(item->end_);
+
+    while (start != end)
+    {
+        terrain->SmoothHeightData(start->smoothRect_);
+        terrain->SmoothHeightData(start->smoothNorthRect_);
+        ++start;
+    }
+}
+
+void BuildTerrainPatchesWork(const WorkItem* item, unsigned threadIndex)
+{
+    Terrain* terrain = reinterpret_cast<Terrain*>(item->aux_);
+    TerrainPatchBuildData* start = reinterpret_cast<TerrainPatchBuildData*>(item->start_);
+    TerrainPatchBuildData* end = reinterpret_cast<TerrainPatchBuildData*>(item->end_);
+
+    while (start != end)
+    {
+        terrain->BuildPatchData(*start);
+        terrain->CalculateLodErrors(start->patch_);
+        ++start;
+    }
+}
+
 Terrain::Terrain(Context* context) :
     Component(context),
     indexBuffer_(new IndexBuffer(context)),
@@ -93,6 +148,7 @@ Terrain::Terrain(Context* context) :
     maxLodLevels_(MAX_LOD_LEVELS),
     occlusionLodLevel_(M_MAX_UNSIGNED),
     smoothing_(false),
+    geomorph_(false),
     visible_(true),
     castShadows_(false),
     occluder_(false),
@@ -136,6 +192,7 @@ void Terrain::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Patch Size", GetPatchSize, SetPatchSizeAttr, int, DEFAULT_PATCH_SIZE, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Max LOD Levels", GetMaxLodLevels, SetMaxLodLevelsAttr, unsigned, MAX_LOD_LEVELS, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Smooth Height Map", bool, smoothing_, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Geomorph", GetGeomorph, SetGeomorphAttr, bool, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Is Occluder", IsOccluder, SetOccluder, bool, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Can Be Occluded", IsOccludee, SetOccludee, bool, true, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Cast Shadows", GetCastShadows, SetCastShadows, bool, false, AM_DEFAULT);
@@ -257,6 +314,18 @@ void Terrain::SetSmoothing(bool enable)
     }
 }
 
+void Terrain::SetGeomorph(bool enable)
+{
+    if (enable != geomorph_)
+    {
+        geomorph_ = enable;
+        lastPatchSize_ = 0; // Force full recreate
+
+        CreateGeometry();
+        MarkNetworkUpdate();
+    }
+}
+
 bool Terrain::SetHeightMap(Image* image)
 {
     bool success = SetHeightMapInternal(image, true);
@@ -668,112 +737,10 @@ void Terrain::CreatePatchGeometry(TerrainPatch* patch)
 {
     URHO3D_PROFILE(CreatePatchGeometry);
 
-    unsigned row = (unsigned)(patchSize_ + 1);
-    VertexBuffer* vertexBuffer = patch->GetVertexBuffer();
-    Geometry* geometry = patch->GetGeometry();
-    Geometry* maxLodGeometry = patch->GetMaxLodGeometry();
-    Geometry* occlusionGeometry = patch->GetOcclusionGeometry();
-
-    if (vertexBuffer->GetVertexCount() != row * row)
-        vertexBuffer->SetSize(row * row, MASK_POSITION | MASK_NORMAL | MASK_TEXCOORD1 | MASK_TANGENT);
-
-    SharedArrayPtr<unsigned char> cpuVertexData(new unsigned char[row * row * sizeof(Vector3)]);
-    SharedArrayPtr<unsigned char> occlusionCpuVertexData(new unsigned char[row * row * sizeof(Vector3)]);
-
-    float* vertexData = (float*)vertexBuffer->Lock(0, vertexBuffer->GetVertexCount());
-    float* positionData = (float*)cpuVertexData.Get();
-    float* occlusionData = (float*)occlusionCpuVertexData.Get();
-    BoundingBox box;
-
-    unsigned occlusionLevel = occlusionLodLevel_;
-    if (occlusionLevel > numLodLevels_ - 1)
-        occlusionLevel = numLodLevels_ - 1;
-
-    if (vertexData)
-    {
-        const IntVector2& coords = patch->GetCoordinates();
-        int lodExpand = (1 << (occlusionLevel)) - 1;
-        int halfLodExpand = (1 << (occlusionLevel)) / 2;
-
-        for (int z = 0; z <= patchSize_; ++z)
-        {
-            for (int x = 0; x <= patchSize_; ++x)
-            {
-                int xPos = coords.x_ * patchSize_ + x;
-                int zPos = coords.y_ * patchSize_ + z;
-
-                // Position
-                Vector3 position((float)x * spacing_.x_, GetRawHeight(xPos, zPos), (float)z * spacing_.z_);
-                *vertexData++ = position.x_;
-                *vertexData++ = position.y_;
-                *vertexData++ = position.z_;
-                *positionData++ = position.x_;
-                *positionData++ = position.y_;
-                *positionData++ = position.z_;
-
-                box.Merge(position);
-
-                // For vertices that are part of the occlusion LOD, calculate the minimum height in the neighborhood
-                // to prevent false positive occlusion due to inaccuracy between occlusion LOD & visible LOD
-                float minHeight = position.y_;
-                if (halfLodExpand > 0 && (x & lodExpand) == 0 && (z & lodExpand) == 0)
-                {
-                    int minX = Max(xPos - halfLodExpand, 0);
-                    int maxX = Min(xPos + halfLodExpand, numVertices_.x_ - 1);
-                    int minZ = Max(zPos - halfLodExpand, 0);
-                    int maxZ = Min(zPos + halfLodExpand, numVertices_.y_ - 1);
-                    for (int nZ = minZ; nZ <= maxZ; ++nZ)
-                    {
-                        for (int nX = minX; nX <= maxX; ++nX)
-                            minHeight = Min(minHeight, GetRawHeight(nX, nZ));
-                    }
-                }
-                *occlusionData++ = position.x_;
-                *occlusionData++ = minHeight;
-                *occlusionData++ = position.z_;
-
-                // Normal
-                Vector3 normal = GetRawNormal(xPos, zPos);
-                *vertexData++ = normal.x_;
-                *vertexData++ = normal.y_;
-                *vertexData++ = normal.z_;
-
-                // Texture coordinate
-                Vector2 texCoord((float)xPos / (float)(numVertices_.x_ - 1), 1.0f - (float)zPos / (float)(numVertices_.y_ - 1));
-                *vertexData++ = texCoord.x_;
-                *vertexData++ = texCoord.y_;
-
-                // Tangent
-                Vector3 xyz = (Vector3::RIGHT - normal * normal.DotProduct(Vector3::RIGHT)).Normalized();
-                *vertexData++ = xyz.x_;
-                *vertexData++ = xyz.y_;
-                *vertexData++ = xyz.z_;
-                *vertexData++ = 1.0f;
-            }
-        }
-
-        vertexBuffer->Unlock();
-        vertexBuffer->ClearDataLost();
-    }
-
-    patch->SetBoundingBox(box);
-
-    if (drawRanges_.Size())
-    {
-        unsigned occlusionDrawRange = occlusionLevel << 4;
-
-        geometry->SetIndexBuffer(indexBuffer_);
-        geometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[0].first_, drawRanges_[0].second_, false);
-        geometry->SetRawVertexData(cpuVertexData, MASK_POSITION);
-        maxLodGeometry->SetIndexBuffer(indexBuffer_);
-        maxLodGeometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[0].first_, drawRanges_[0].second_, false);
-        maxLodGeometry->SetRawVertexData(cpuVertexData, MASK_POSITION);
-        occlusionGeometry->SetIndexBuffer(indexBuffer_);
-        occlusionGeometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[occlusionDrawRange].first_, drawRanges_[occlusionDrawRange].second_, false);
-        occlusionGeometry->SetRawVertexData(occlusionCpuVertexData, MASK_POSITION);
-    }
-
-    patch->ResetLod();
+    TerrainPatchBuildData data;
+    data.patch_ = patch;
+    BuildPatchData(data);
+    UploadPatchData(data);
 }
 
 void Terrain::UpdatePatchLod(TerrainPatch* patch)
@@ -802,6 +769,9 @@ void Terrain::UpdatePatchLod(TerrainPatch* patch)
 
     if (drawRangeIndex < drawRanges_.Size())
         geometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[drawRangeIndex].first_, drawRanges_[drawRangeIndex].second_, false);
+
+    if (geomorph_)
+        UpdatePatchMorph(patch);
 }
 
 void Terrain::SetMaterialAttr(const ResourceRef& value)
@@ -841,6 +811,16 @@ void Terrain::SetMaxLodLevelsAttr(unsigned value)
     }
 }
 
+void Terrain::SetGeomorphAttr(bool value)
+{
+    if (value != geomorph_)
+    {
+        geomorph_ = value;
+        lastPatchSize_ = 0; // Force full recreate
+        recreateTerrain_ = true;
+    }
+}
+
 void Terrain::SetOcclusionLodLevelAttr(unsigned value)
 {
     if (value != occlusionLodLevel_)
@@ -1092,51 +1072,140 @@ void Terrain::CreateGeometry()
         if (updateAll)
             CreateIndexData();
 
-        // Create vertex data for patches. First update smoothing to ensure normals are calculated correctly across patch borders
-        if (smoothing_)
+        // Create vertex data for patches in worker threads, then upload it in the main thread
+        PODVector<TerrainPatch*> buildPatches;
+        for (unsigned i = 0; i < patches_.Size(); ++i)
+        {
+            if (dirtyPatches[i])
+                buildPatches.Push(patches_[i]);
+        }
+
+        if (buildPatches.Size())
         {
-            URHO3D_PROFILE(UpdateSmoothing);
+            WorkQueue* queue = GetSubsystem<WorkQueue>();
 
-            for (unsigned i = 0; i < patches_.Size(); ++i)
+            Vector<TerrainPatchBuildData> buildData(buildPatches.Size());
+            for (unsigned i = 0; i < buildPatches.Size(); ++i)
+                buildData[i].patch_ = buildPatches[i];
+
+            // First update smoothing to ensure normals are calculated correctly across patch borders
+            if (smoothing_)
             {
-                if (dirtyPatches[i])
+                URHO3D_PROFILE(UpdateSmoothing);
+
+                // Rebuilt patches share their edge vertices. Give each shared vertex to the northernmost, then easternmost
+                // rebuilt patch containing it, so that no two patches write the same height data
+                for (unsigned i = 0; i < buildData.Size(); ++i)
                 {
-                    TerrainPatch* patch = patches_[i];
-                    const IntVector2& coords = patch->GetCoordinates();
+                    const IntVector2& coords = buildData[i].patch_->GetCoordinates();
+                    bool eastDirty = coords.x_ < numPatches_.x_ - 1 && dirtyPatches[coords.y_ * numPatches_.x_ + coords.x_ + 1];
+                    bool northDirty = false;
+                    bool northWestDirty = false;
+                    bool northEastDirty = false;
+                    if (coords.y_ < numPatches_.y_ - 1)
+                    {
+                        unsigned northIndex = (unsigned)((coords.y_ + 1) * numPatches_.x_ + coords.x_);
+                        northDirty = dirtyPatches[northIndex];
+                        northWestDirty = coords.x_ > 0 && dirtyPatches[northIndex - 1];
+                        northEastDirty = coords.x_ < numPatches_.x_ - 1 && dirtyPatches[northIndex + 1];
+                    }
+
                     int startX = coords.x_ * patchSize_;
                     int endX = startX + patchSize_;
                     int startZ = coords.y_ * patchSize_;
                     int endZ = startZ + patchSize_;
 
-                    for (int z = startZ; z <= endZ; ++z)
+                    buildData[i].smoothRect_ = IntRect(startX, startZ, eastDirty ? endX - 1 : endX, endZ - 1);
+                    if (northDirty)
+                        buildData[i].smoothNorthRect_ = IntRect(0, endZ, -1, endZ);
+                    else
                     {
-                        for (int x = startX; x <= endX; ++x)
-                        {
-                            float smoothedHeight = (
-                                GetSourceHeight(x - 1, z - 1) + GetSourceHeight(x, z - 1) * 2.0f + GetSourceHeight(x + 1, z - 1) +
-                                GetSourceHeight(x - 1, z) * 2.0f + GetSourceHeight(x, z) * 4.0f + GetSourceHeight(x + 1, z) * 2.0f +
-                                GetSourceHeight(x - 1, z + 1) + GetSourceHeight(x, z + 1) * 2.0f + GetSourceHeight(x + 1, z + 1)
-                            ) / 16.0f;
+                        buildData[i].smoothNorthRect_ = IntRect(northWestDirty ? startX + 1 : startX, endZ,
+                            eastDirty || northEastDirty ? endX - 1 : endX, endZ);
+                    }
+                }
 
-                            heightData_[z * numVertices_.x_ + x] = smoothedHeight;
-                        }
+                if (queue)
+                {
+                    int numWorkItems = Min((int)buildData.Size(), (int)queue->GetNumThreads() + 1); // Worker threads + main thread
+                    int patchesPerItem = (int)buildData.Size() / numWorkItems;
+
+                    TerrainPatchBuildData* start = &buildData[0];
+                    TerrainPatchBuildData* smoothEnd = start + buildData.Size();
+                    for (int i = 0; i < numWorkItems; ++i)
+                    {
+                        SharedPtr<WorkItem> item = queue->GetFreeItem();
+                        item->priority_ = M_MAX_UNSIGNED;
+                        item->workFunction_ = SmoothTerrainPatchesWork;
+                        item->aux_ = this;
+
+                        TerrainPatchBuildData* end = i < numWorkItems - 1 ? start + patchesPerItem : smoothEnd;
+                        item->start_ = start;
+                        item->end_ = end;
+                        queue->AddWorkItem(item);
+
+                        start = end;
+                    }
+
+                    queue->Complete(M_MAX_UNSIGNED);
+                }
+                else
+                {
+                    for (unsigned i = 0; i < buildData.Size(); ++i)
+                    {
+                        SmoothHeightData(buildData[i].smoothRect_);
+                        SmoothHeightData(buildData[i].smoothNorthRect_);
                     }
                 }
             }
-        }
-
-        for (unsigned i = 0; i < patches_.Size(); ++i)
-        {
-            TerrainPatch* patch = patches_[i];
 
-            if (dirtyPatches[i])
             {
-                CreatePatchGeometry(patch);
-                CalculateLodErrors(patch);
+                URHO3D_PROFILE(BuildPatches);
+
+                if (queue)
+                {
+                    int numWorkItems = Min((int)buildData.Size(), (int)queue->GetNumThreads() + 1); // Worker threads + main thread
+                    int patchesPerItem = (int)buildData.Size() / numWorkItems;
+
+                    TerrainPatchBuildData* start = &buildData[0];
+                    TerrainPatchBuildData* buildEnd = start + buildData.Size();
+                    for (int i = 0; i < numWorkItems; ++i)
+                    {
+                        SharedPtr<WorkItem> item = queue->GetFreeItem();
+                        item->priority_ = M_MAX_UNSIGNED;
+                        item->workFunction_ = BuildTerrainPatchesWork;
+                        item->aux_ = this;
+
+                        TerrainPatchBuildData* end = i < numWorkItems - 1 ? start + patchesPerItem : buildEnd;
+                        item->start_ = start;
+                        item->end_ = end;
+                        queue->AddWorkItem(item);
+
+                        start = end;
+                    }
+
+                    queue->Complete(M_MAX_UNSIGNED);
+                }
+                else
+                {
+                    for (unsigned i = 0; i < buildData.Size(); ++i)
+                    {
+                        BuildPatchData(buildData[i]);
+                        CalculateLodErrors(buildData[i].patch_);
+                    }
+                }
             }
 
-            SetPatchNeighbors(patch);
+            {
+                URHO3D_PROFILE(UploadPatches);
+
+                for (unsigned i = 0; i < buildData.Size(); ++i)
+                    UploadPatchData(buildData[i]);
+            }
         }
+
+        for (unsigned i = 0; i < patches_.Size(); ++i)
+            SetPatchNeighbors(patches_[i]);
     }
 
     // Send event only if new geometry was generated, or the old was cleared
@@ -1154,7 +1223,7 @@ void Terrain::CreateIndexData()
 {
     URHO3D_PROFILE(CreateIndexData);
 
-    PODVector<unsigned short> indices;
+    PODVector<unsigned> indices;
     drawRanges_.Clear();
     unsigned row = (unsigned)(patchSize_ + 1);
 
@@ -1197,12 +1266,12 @@ void Terrain::CreateIndexData()
             {
                 for (int x = xStart; x < xEnd; x += skip)
                 {
-                    indices.Push((unsigned short)((z + skip) * row + x));
-                    indices.Push((unsigned short)(z * row + x + skip));
-                    indices.Push((unsigned short)(z * row + x));
-                    indices.Push((unsigned short)((z + skip) * row + x));
-                    indices.Push((unsigned short)((z + skip) * row + x + skip));
-                    indices.Push((unsigned short)(z * row + x + skip));
+                    indices.Push((unsigned)((z + skip) * row + x));
+                    indices.Push((unsigned)(z * row + x + skip));
+                    indices.Push((unsigned)(z * row + x));
+                    indices.Push((unsigned)((z + skip) * row + x));
+                    indices.Push((unsigned)((z + skip) * row + x + skip));
+                    indices.Push((unsigned)(z * row + x + skip));
                 }
             }
 
@@ -1214,18 +1283,18 @@ void Terrain::CreateIndexData()
                 {
                     if (x > 0 || (j & STITCH_WEST) == 0)
                     {
-                        indices.Push((unsigned short)((z + skip) * row + x));
-                        indices.Push((unsigned short)(z * row + x + skip));
-                        indices.Push((unsigned short)(z * row + x));
+                        indices.Push((unsigned)((z + skip) * row + x));
+                        indices.Push((unsigned)(z * row + x + skip));
+                        indices.Push((unsigned)(z * row + x));
                     }
-                    indices.Push((unsigned short)((z + skip) * row + x));
-                    indices.Push((unsigned short)((z + skip) * row + x + 2 * skip));
-                    indices.Push((unsigned short)(z * row + x + skip));
+                    indices.Push((unsigned)((z + skip) * row + x));
+                    indices.Push((unsigned)((z + skip) * row + x + 2 * skip));
+                    indices.Push((unsigned)(z * row + x + skip));
                     if (x < patchSize_ - skip * 2 || (j & STITCH_EAST) == 0)
                     {
-                        indices.Push((unsigned short)((z + skip) * row + x + 2 * skip));
-                        indices.Push((unsigned short)(z * row + x + 2 * skip));
-                        indices.Push((unsigned short)(z * row + x + skip));
+                        indices.Push((unsigned)((z + skip) * row + x + 2 * skip));
+                        indices.Push((unsigned)(z * row + x + 2 * skip));
+                        indices.Push((unsigned)(z * row + x + skip));
                     }
                 }
             }
@@ -1238,18 +1307,18 @@ void Terrain::CreateIndexData()
                 {
                     if (x > 0 || (j & STITCH_WEST) == 0)
                     {
-                        indices.Push((unsigned short)((z + skip) * row + x));
-                        indices.Push((unsigned short)((z + skip) * row + x + skip));
-                        indices.Push((unsigned short)(z * row + x));
+                        indices.Push((unsigned)((z + skip) * row + x));
+                        indices.Push((unsigned)((z + skip) * row + x + skip));
+                        indices.Push((unsigned)(z * row + x));
                     }
-                    indices.Push((unsigned short)(z * row + x));
-                    indices.Push((unsigned short)((z + skip) * row + x + skip));
-                    indices.Push((unsigned short)(z * row + x + 2 * skip));
+                    indices.Push((unsigned)(z * row + x));
+                    indices.Push((unsigned)((z + skip) * row + x + skip));
+                    indices.Push((unsigned)(z * row + x + 2 * skip));
                     if (x < patchSize_ - skip * 2 || (j & STITCH_EAST) == 0)
                     {
-                        indices.Push((unsigned short)((z + skip) * row + x + skip));
-                        indices.Push((unsigned short)((z + skip) * row + x + 2 * skip));
-                        indices.Push((unsigned short)(z * row + x + 2 * skip));
+                        indices.Push((unsigned)((z + skip) * row + x + skip));
+                        indices.Push((unsigned)((z + skip) * row + x + 2 * skip));
+                        indices.Push((unsigned)(z * row + x + 2 * skip));
                     }
                 }
             }
@@ -1262,18 +1331,18 @@ void Terrain::CreateIndexData()
                 {
                     if (z > 0 || (j & STITCH_SOUTH) == 0)
                     {
-                        indices.Push((unsigned short)(z * row + x));
-                        indices.Push((unsigned short)((z + skip) * row + x + skip));
-                        indices.Push((unsigned short)(z * row + x + skip));
+                        indices.Push((unsigned)(z * row + x));
+                        indices.Push((unsigned)((z + skip) * row + x + skip));
+                        indices.Push((unsigned)(z * row + x + skip));
                     }
-                    indices.Push((unsigned short)((z + 2 * skip) * row + x));
-                    indices.Push((unsigned short)((z + skip) * row + x + skip));
-                    indices.Push((unsigned short)(z * row + x));
+                    indices.Push((unsigned)((z + 2 * skip) * row + x));
+                    indices.Push((unsigned)((z + skip) * row + x + skip));
+                    indices.Push((unsigned)(z * row + x));
                     if (z < patchSize_ - skip * 2 || (j & STITCH_NORTH) == 0)
                     {
-                        indices.Push((unsigned short)((z + 2 * skip) * row + x));
-                        indices.Push((unsigned short)((z + 2 * skip) * row + x + skip));
-                        indices.Push((unsigned short)((z + skip) * row + x + skip));
+                        indices.Push((unsigned)((z + 2 * skip) * row + x));
+                        indices.Push((unsigned)((z + 2 * skip) * row + x + skip));
+                        indices.Push((unsigned)((z + skip) * row + x + skip));
                     }
                 }
             }
@@ -1286,18 +1355,18 @@ void Terrain::CreateIndexData()
                 {
                     if (z > 0 || (j & STITCH_SOUTH) == 0)
                     {
-                        indices.Push((unsigned short)(z * row + x));
-                        indices.Push((unsigned short)((z + skip) * row + x));
-                        indices.Push((unsigned short)(z * row + x + skip));
+                        indices.Push((unsigned)(z * row + x));
+                        indices.Push((unsigned)((z + skip) * row + x));
+                        indices.Push((unsigned)(z * row + x + skip));
                     }
-                    indices.Push((unsigned short)((z + skip) * row + x));
-                    indices.Push((unsigned short)((z + 2 * skip) * row + x + skip));
-                    indices.Push((unsigned short)(z * row + x + skip));
+                    indices.Push((unsigned)((z + skip) * row + x));
+                    indices.Push((unsigned)((z + 2 * skip) * row + x + skip));
+                    indices.Push((unsigned)(z * row + x + skip));
                     if (z < patchSize_ - skip * 2 || (j & STITCH_NORTH) == 0)
                     {
-                        indices.Push((unsigned short)((z + skip) * row + x));
-                        indices.Push((unsigned short)((z + 2 * skip) * row + x));
-                        indices.Push((unsigned short)((z + 2 * skip) * row + x + skip));
+                        indices.Push((unsigned)((z + skip) * row + x));
+                        indices.Push((unsigned)((z + 2 * skip) * row + x));
+                        indices.Push((unsigned)((z + 2 * skip) * row + x + skip));
                     }
                 }
             }
@@ -1306,8 +1375,18 @@ void Terrain::CreateIndexData()
         }
     }
 
-    indexBuffer_->SetSize(indices.Size(), false);
-    indexBuffer_->SetData(&indices[0]);
+    // Patches above 128 quads per side need 32-bit indices
+    bool largeIndices = row * row > 65536;
+    indexBuffer_->SetSize(indices.Size(), largeIndices);
+    if (largeIndices)
+        indexBuffer_->SetData(&indices[0]);
+    else
+    {
+        PODVector<unsigned short> shortIndices(indices.Size());
+        for (unsigned i = 0; i < indices.Size(); ++i)
+            shortIndices[i] = (unsigned short)indices[i];
+        indexBuffer_->SetData(&shortIndices[0]);
+    }
 }
 
 float Terrain::GetRawHeight(int x, int z) const
@@ -1420,6 +1499,216 @@ void Terrain::CalculateLodErrors(TerrainPatch* patch)
     }
 }
 
+void Terrain::BuildPatchData(TerrainPatchBuildData& data) const
+{
+    TerrainPatch* patch = data.patch_;
+    unsigned row = (unsigned)(patchSize_ + 1);
+
+    data.vertexData_ = new float[row * row * TERRAIN_VERTEX_FLOATS];
+    data.cpuVertexData_ = new unsigned char[row * row * sizeof(Vector3)];
+    data.occlusionCpuVertexData_ = new unsigned char[row * row * sizeof(Vector3)];
+    data.box_.Clear();
+
+    float* vertexData = data.vertexData_.Get();
+    float* positionData = (float*)data.cpuVertexData_.Get();
+    float* occlusionData = (float*)data.occlusionCpuVertexData_.Get();
+
+    unsigned occlusionLevel = occlusionLodLevel_;
+    if (occlusionLevel > numLodLevels_ - 1)
+        occlusionLevel = numLodLevels_ - 1;
+
+    const IntVector2& coords = patch->GetCoordinates();
+    int lodExpand = (1 << (occlusionLevel)) - 1;
+    int halfLodExpand = (1 << (occlusionLevel)) / 2;
+
+    for (int z = 0; z <= patchSize_; ++z)
+    {
+        for (int x = 0; x <= patchSize_; ++x)
+        {
+            int xPos = coords.x_ * patchSize_ + x;
+            int zPos = coords.y_ * patchSize_ + z;
+
+            // Position
+            Vector3 position((float)x * spacing_.x_, GetRawHeight(xPos, zPos), (float)z * spacing_.z_);
+            *vertexData++ = position.x_;
+            *vertexData++ = position.y_;
+            *vertexData++ = position.z_;
+            *positionData++ = position.x_;
+            *positionData++ = position.y_;
+            *positionData++ = position.z_;
+
+            data.box_.Merge(position);
+
+            // For vertices that are part of the occlusion LOD, calculate the minimum height in the neighborhood
+            // to prevent false positive occlusion due to inaccuracy between occlusion LOD & visible LOD
+            float minHeight = position.y_;
+            if (halfLodExpand > 0 && (x & lodExpand) == 0 && (z & lodExpand) == 0)
+            {
+                int minX = Max(xPos - halfLodExpand, 0);
+                int maxX = Min(xPos + halfLodExpand, numVertices_.x_ - 1);
+                int minZ = Max(zPos - halfLodExpand, 0);
+                int maxZ = Min(zPos + halfLodExpand, numVertices_.y_ - 1);
+                for (int nZ = minZ; nZ <= maxZ; ++nZ)
+                {
+                    for (int nX = minX; nX <= maxX; ++nX)
+                        minHeight = Min(minHeight, GetRawHeight(nX, nZ));
+                }
+            }
+            *occlusionData++ = position.x_;
+            *occlusionData++ = minHeight;
+            *occlusionData++ = position.z_;
+
+            // Normal
+            Vector3 normal = GetRawNormal(xPos, zPos);
+            *vertexData++ = normal.x_;
+            *vertexData++ = normal.y_;
+            *vertexData++ = normal.z_;
+
+            // Texture coordinate
+            Vector2 texCoord((float)xPos / (float)(numVertices_.x_ - 1), 1.0f - (float)zPos / (float)(numVertices_.y_ - 1));
+            *vertexData++ = texCoord.x_;
+            *vertexData++ = texCoord.y_;
+
+            // Tangent
+            Vector3 xyz = (Vector3::RIGHT - normal * normal.DotProduct(Vector3::RIGHT)).Normalized();
+            *vertexData++ = xyz.x_;
+            *vertexData++ = xyz.y_;
+            *vertexData++ = xyz.z_;
+            *vertexData++ = 1.0f;
+        }
+    }
+}
+
+void Terrain::UploadPatchData(const TerrainPatchBuildData& data)
+{
+    TerrainPatch* patch = data.patch_;
+    unsigned row = (unsigned)(patchSize_ + 1);
+    VertexBuffer* vertexBuffer = patch->GetVertexBuffer();
+    Geometry* geometry = patch->GetGeometry();
+    Geometry* maxLodGeometry = patch->GetMaxLodGeometry();
+    Geometry* occlusionGeometry = patch->GetOcclusionGeometry();
+
+    // Geomorphing rewrites the vertex heights from the shadow data, so keep the buffer shadowed and dynamic then
+    if (vertexBuffer->GetVertexCount() != row * row || vertexBuffer->IsDynamic() != geomorph_)
+    {
+        vertexBuffer->SetShadowed(geomorph_);
+        vertexBuffer->SetSize(row * row, MASK_POSITION | MASK_NORMAL | MASK_TEXCOORD1 | MASK_TANGENT, geomorph_);
+    }
+
+    vertexBuffer->SetData(data.vertexData_.Get());
+    vertexBuffer->ClearDataLost();
+
+    patch->SetBoundingBox(data.box_);
+
+    if (drawRanges_.Size())
+    {
+        unsigned occlusionLevel = occlusionLodLevel_;
+        if (occlusionLevel > numLodLevels_ - 1)
+            occlusionLevel = numLodLevels_ - 1;
+        unsigned occlusionDrawRange = occlusionLevel << 4;
+
+        geometry->SetIndexBuffer(indexBuffer_);
+        geometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[0].first_, drawRanges_[0].second_, false);
+        geometry->SetRawVertexData(data.cpuVertexData_, MASK_POSITION);
+        maxLodGeometry->SetIndexBuffer(indexBuffer_);
+        maxLodGeometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[0].first_, drawRanges_[0].second_, false);
+        maxLodGeometry->SetRawVertexData(data.cpuVertexData_, MASK_POSITION);
+        occlusionGeometry->SetIndexBuffer(indexBuffer_);
+        occlusionGeometry->SetDrawRange(TRIANGLE_LIST, drawRanges_[occlusionDrawRange].first_, drawRanges_[occlusionDrawRange].second_, false);
+        occlusionGeometry->SetRawVertexData(data.occlusionCpuVertexData_, MASK_POSITION);
+    }
+
+    patch->ResetLod();
+}
+
+void Terrain::SmoothHeightData(const IntRect& rect)
+{
+    for (int z = rect.top_; z <= rect.bottom_; ++z)
+    {
+        for (int x = rect.left_; x <= rect.right_; ++x)
+        {
+            float smoothedHeight = (
+                GetSourceHeight(x - 1, z - 1) + GetSourceHeight(x, z - 1) * 2.0f + GetSourceHeight(x + 1, z - 1) +
+                GetSourceHeight(x - 1, z) * 2.0f + GetSourceHeight(x, z) * 4.0f + GetSourceHeight(x + 1, z) * 2.0f +
+                GetSourceHeight(x - 1, z + 1) + GetSourceHeight(x, z + 1) * 2.0f + GetSourceHeight(x + 1, z + 1)
+            ) / 16.0f;
+
+            heightData_[z * numVertices_.x_ + x] = smoothedHeight;
+        }
+    }
+}
+
+void Terrain::UpdatePatchMorph(TerrainPatch* patch)
+{
+    VertexBuffer* vertexBuffer = patch->GetVertexBuffer();
+    float* vertexData = (float*)vertexBuffer->GetShadowData();
+    if (!vertexData || !vertexBuffer->IsDynamic())
+        return;
+
+    // Blend the vertices that the next coarser LOD level drops towards its surface. Shared edge vertices use the smaller
+    // blend of the two patches, or none if the neighbor is finer, so that edges match exactly
+    unsigned lodLevel = patch->GetLodLevel();
+    float morph = lodLevel < numLodLevels_ - 1 ? QuantizeMorph(patch->GetMorph()) : 0.0f;
+    TerrainPatch* neighbors[4] = { patch->GetNorthPatch(), patch->GetSouthPatch(), patch->GetWestPatch(), patch->GetEastPatch() };
+    float morphs[6];
+    morphs[0] = (float)lodLevel;
+    morphs[1] = morph;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        TerrainPatch* neighbor = neighbors[i];
+        Terrain* neighborOwner = neighbor ? neighbor->GetOwner() : 0;
+        if (!neighbor)
+            morphs[i + 2] = morph;
+        else if (neighborOwner && neighborOwner->GetGeomorph() && neighbor->GetLodLevel() == lodLevel)
+            morphs[i + 2] = Min(morph, QuantizeMorph(neighbor->GetMorph()));
+        else
+            morphs[i + 2] = 0.0f;
+    }
+
+    PODVector<float>& appliedMorphs = patch->GetAppliedMorphs();
+    if (appliedMorphs.Size() == 6 && !memcmp(&appliedMorphs[0], morphs, sizeof morphs))
+        return;
+    appliedMorphs.Resize(6);
+    memcpy(&appliedMorphs[0], morphs, sizeof morphs);
+
+    URHO3D_PROFILE(UpdatePatchMorph);
+
+    const IntVector2& coords = patch->GetCoordinates();
+    unsigned vertexFloats = vertexBuffer->GetVertexSize() / sizeof(float);
+    int skip = 1 << lodLevel;
+    int coarseSkip = skip << 1;
+
+    for (int z = 0; z <= patchSize_; ++z)
+    {
+        for (int x = 0; x <= patchSize_; ++x)
+        {
+            int xPos = coords.x_ * patchSize_ + x;
+            int zPos = coords.y_ * patchSize_ + z;
+            float height = GetRawHeight(xPos, zPos);
+
+            if (morph > 0.0f && (x % skip) == 0 && (z % skip) == 0 && ((x % coarseSkip) || (z % coarseSkip)))
+            {
+                float t = morph;
+                if (z == patchSize_)
+                    t = morphs[2];
+                else if (z == 0)
+                    t = morphs[3];
+                else if (x == 0)
+                    t = morphs[4];
+                else if (x == patchSize_)
+                    t = morphs[5];
+
+                if (t > 0.0f)
+                    height = Lerp(height, GetLodHeight(xPos, zPos, lodLevel + 1), t);
+            }
+
+            vertexData[(z * (patchSize_ + 1) + x) * vertexFloats + 1] = height;
+        }
+    }
+
+    vertexBuffer->SetData(vertexData);
+}
+
 void Terrain::SetPatchNeighbors(TerrainPatch* patch)
 {
     if (!patch)
@@ -33,6 +33,8 @@ class IndexBuffer;
 class Material;
 class Node;
 class TerrainPatch;
+struct TerrainPatchBuildData;
+struct WorkItem;
 
 /// Heightmap terrain component.
 class URHO3D_API Terrain : public Component
@@ -54,16 +56,18 @@ public:
     /// Handle enabled/disabled state change.
     virtual void OnSetEnabled();
 
-    /// Set patch quads per side. Must be a power of two.
+    /// Set patch quads per side. Must be a power of two between 4-256.
     void SetPatchSize(int size);
     /// Set vertex (XZ) and height (Y) spacing.
     void SetSpacing(const Vector3& spacing);
-    /// Set maximum number of LOD levels for terrain patches. This can be between 1-4.
+    /// Set maximum number of LOD levels for terrain patches. This can be between 1-7.
     void SetMaxLodLevels(unsigned levels);
     /// Set LOD level used for terrain patch occlusion. By default (M_MAX_UNSIGNED) the coarsest. Since the LOD level used needs to be fixed, using finer LOD levels may result in false positive occlusion in cases where the actual rendered geometry is coarser, so use with caution.
     void SetOcclusionLodLevel(unsigned level);
     /// Set smoothing of heightmap.
     void SetSmoothing(bool enable);
+    /// Set geomorphing. When enabled, patches blend towards the next coarser LOD level before switching to it, which hides LOD popping at the cost of keeping a CPU copy of the vertex data and rewriting vertex heights.
+    void SetGeomorph(bool enable);
     /// Set heightmap image. Dimensions should be a power of two + 1. Uses 8-bit grayscale, or optionally red as MSB and green as LSB for 16-bit accuracy. Return true if successful.
     bool SetHeightMap(Image* image);
     /// Set material.
@@ -115,7 +119,7 @@ public:
     /// Return heightmap size in patches.
     const IntVector2& GetNumPatches() const { return numPatches_; }
 
-    /// Return maximum number of LOD levels for terrain patches. This can be between 1-4.
+    /// Return maximum number of LOD levels for terrain patches. This can be between 1-7.
     unsigned GetMaxLodLevels() const { return maxLodLevels_; }
     
     /// Return LOD level used for occlusion.
@@ -124,6 +128,9 @@ public:
     /// Return whether smoothing is in use.
     bool GetSmoothing() const { return smoothing_; }
 
+    /// Return whether geomorphing is in use.
+    bool GetGeomorph() const { return geomorph_; }
+
     /// Return heightmap image.
     Image* GetHeightMap() const;
     /// Return material.
@@ -208,12 +215,17 @@ public:
     void SetMaxLodLevelsAttr(unsigned value);
     /// Set occlusion LOD level attribute.
     void SetOcclusionLodLevelAttr(unsigned value);
+    /// Set geomorph attribute.
+    void SetGeomorphAttr(bool value);
     /// Return heightmap attribute.
     ResourceRef GetHeightMapAttr() const;
     /// Return material attribute.
     ResourceRef GetMaterialAttr() const;
 
 private:
+    friend void SmoothTerrainPatchesWork(const WorkItem* item, unsigned threadIndex);
+    friend void BuildTerrainPatchesWork(const WorkItem* item, unsigned threadIndex);
+
     /// Regenerate terrain geometry.
     void CreateGeometry();
     /// Create index data shared by all patches.
@@ -226,8 +238,16 @@ private:
     float GetLodHeight(int x, int z, unsigned lodLevel) const;
     /// Get slope-based terrain normal at position.
     Vector3 GetRawNormal(int x, int z) const;
-    /// Calculate LOD errors for a patch.
+    /// Calculate LOD errors for a patch. May be called from a worker thread.
     void CalculateLodErrors(TerrainPatch* patch);
+    /// Build vertex data and bounding box for a patch without touching GPU resources. May be called from a worker thread.
+    void BuildPatchData(TerrainPatchBuildData& data) const;
+    /// Upload built vertex data to a patch and set up its geometries.
+    void UploadPatchData(const TerrainPatchBuildData& data);
+    /// Smooth the height data of an inclusive vertex rectangle from the source height data. May be called from a worker thread.
+    void SmoothHeightData(const IntRect& rect);
+    /// Blend patch vertex heights towards the next coarser LOD level.
+    void UpdatePatchMorph(TerrainPatch* patch);
     /// Set neighbors for a patch.
     void SetPatchNeighbors(TerrainPatch* patch);
     /// Set heightmap image and optionally recreate the geometry immediately. Return true if successful.
@@ -287,6 +307,8 @@ private:
     unsigned occlusionLodLevel_;
     /// Smoothing enable flag.
     bool smoothing_;
+    /// Geomorphing enable flag.
+    bool geomorph_;
     /// Visible flag.
     bool visible_;
     /// Shadowcaster flag.
@@ -42,6 +42,7 @@ namespace Urho3D
 {
 
 static const float LOD_CONSTANT = 1.0f / 150.0f;
+static const float MORPH_RANGE = 0.5f;
 
 extern const char* GEOMETRY_CATEGORY;
 
@@ -52,7 +53,8 @@ TerrainPatch::TerrainPatch(Context* context) :
     occlusionGeometry_(new Geometry(context)),
     vertexBuffer_(new VertexBuffer(context)),
     coordinates_(IntVector2::ZERO),
-    lodLevel_(0)
+    lodLevel_(0),
+    morph_(0.0f)
 {
     geometry_->SetVertexBuffer(0, vertexBuffer_);
     maxLodGeometry_->SetVertexBuffer(0, vertexBuffer_);
@@ -138,6 +140,18 @@ void TerrainPatch::UpdateBatches(const FrameInfo& frame)
     }
 
     lodLevel_ = GetCorrectedLodLevel(newLodLevel);
+
+    // Blend towards the next coarser LOD level over the last part of the distance range where this level is used, so that
+    // the vertices it drops are already on the coarser surface when switching
+    morph_ = 0.0f;
+    if (lodLevel_ + 1 < lodErrors_.Size())
+    {
+        float startDistance = lodErrors_[lodLevel_] / LOD_CONSTANT;
+        float switchDistance = lodErrors_[lodLevel_ + 1] / LOD_CONSTANT;
+        float morphStart = Lerp(switchDistance, startDistance, MORPH_RANGE);
+        if (switchDistance > morphStart)
+            morph_ = Clamp((lodDistance_ - morphStart) / (switchDistance - morphStart), 0.0f, 1.0f);
+    }
 }
 
 void TerrainPatch::UpdateGeometry(const FrameInfo& frame)
@@ -245,6 +259,8 @@ void TerrainPatch::SetCoordinates(const IntVector2& coordinates)
 void TerrainPatch::ResetLod()
 {
     lodLevel_ = 0;
+    morph_ = 0.0f;
+    appliedMorphs_.Clear();
 }
 
 Geometry* TerrainPatch::GetGeometry() const
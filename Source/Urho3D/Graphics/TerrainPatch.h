@@ -106,6 +106,12 @@ public:
     /// Return current LOD level.
     unsigned GetLodLevel() const { return lodLevel_; }
 
+    /// Return blend factor towards the next coarser LOD level, used for geomorphing.
+    float GetMorph() const { return morph_; }
+
+    /// Return the LOD level and blend factors last written to the vertex data by geomorphing.
+    PODVector<float>& GetAppliedMorphs() { return appliedMorphs_; }
+
 protected:
     /// Recalculate the world-space bounding box.
     virtual void OnWorldBoundingBoxUpdate();
@@ -136,8 +142,12 @@ private:
     PODVector<float> lodErrors_;
     /// Patch coordinates in the terrain. (0,0) is the northwest corner.
     IntVector2 coordinates_;
+    /// Geomorph state of the vertex data.
+    PODVector<float> appliedMorphs_;
     /// Current LOD level.
     unsigned lodLevel_;
+    /// Blend factor towards the next coarser LOD level.
+    float morph_;
 };
 
 }
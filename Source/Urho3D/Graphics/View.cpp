@@ -30,9 +30,11 @@
 #include "../Graphics/Graphics.h"
 #include "../Graphics/GraphicsEvents.h"
 #include "../Graphics/GraphicsImpl.h"
+#include "../Graphics/LightClusters.h"
 #include "../Graphics/Material.h"
 #include "../Graphics/OcclusionBuffer.h"
 #include "../Graphics/Octree.h"
+#include "../Graphics/RenderCommandList.h"
 #include "../Graphics/Renderer.h"
 #include "../Graphics/RenderPath.h"
 #include "../Graphics/ShaderVariation.h"
@@ -172,7 +174,9 @@ void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
     View* view = reinterpret_cast<View*>(item->aux_);
     Drawable** start = reinterpret_cast<Drawable**>(item->start_);
     Drawable** end = reinterpret_cast<Drawable**>(item->end_);
-    OcclusionBuffer* buffer = view->occlusionBuffer_;
+    // When reusing cached visibility, the drawables have already passed the occlusion test
+    OcclusionBuffer* buffer = view->skipOcclusionTest_ ? 0 : view->occlusionBuffer_;
+    bool collectUnoccluded = buffer && view->visibilityCache_.valid_;
     const Matrix3x4& viewMatrix = view->cullCamera_->GetView();
     Vector3 viewZ = Vector3(viewMatrix.m20_, viewMatrix.m21_, viewMatrix.m22_);
     Vector3 absViewZ = viewZ.Abs();
@@ -186,6 +190,9 @@ void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
 
         if (!buffer || !drawable->IsOccludee() || buffer->IsVisible(drawable->GetWorldBoundingBox()))
         {
+            if (collectUnoccluded)
+                result.unoccluded_.Push(drawable);
+
             drawable->UpdateBatches(view->frame_);
             // If draw distance non-zero, update and check it
             float maxDistance = drawable->GetDrawDistance();
@@ -244,6 +251,25 @@ void ProcessLightWork(const WorkItem* item, unsigned threadIndex)
     view->ProcessLight(*query, threadIndex);
 }
 
+void GetLightBatchesWork(const WorkItem* item, unsigned threadIndex)
+{
+    View* view = reinterpret_cast<View*>(item->aux_);
+    LightQueryResult* query = reinterpret_cast<LightQueryResult*>(item->start_);
+
+    view->GetLightBatches(*query, &view->batchResults_[threadIndex]);
+}
+
+void GetBaseBatchesWork(const WorkItem* item, unsigned threadIndex)
+{
+    View* view = reinterpret_cast<View*>(item->aux_);
+    Drawable** start = reinterpret_cast<Drawable**>(item->start_);
+    Drawable** end = reinterpret_cast<Drawable**>(item->end_);
+    PerThreadBatchResult* result = &view->batchResults_[threadIndex];
+
+    while (start != end)
+        view->GetBaseBatches(*start++, result);
+}
+
 void UpdateDrawableGeometriesWork(const WorkItem* item, unsigned threadIndex)
 {
     const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
@@ -287,12 +313,38 @@ void SortShadowQueueWork(const WorkItem* item, unsigned threadIndex)
         start->shadowSplits_[i].shadowBatches_.SortFrontToBack();
 }
 
+/// Copy the extra shader defines of a batch queue to a per-thread queue.
+static void CopyQueueShaderDefines(BatchQueue& dest, const BatchQueue& src)
+{
+    dest.hasExtraDefines_ = src.hasExtraDefines_;
+    dest.clustered_ = src.clustered_;
+    dest.vsExtraDefines_ = src.vsExtraDefines_;
+    dest.psExtraDefines_ = src.psExtraDefines_;
+    dest.vsExtraDefinesHash_ = src.vsExtraDefinesHash_;
+    dest.psExtraDefinesHash_ = src.psExtraDefinesHash_;
+}
+
+/// Return the material technique that contains a pass. Used to reassign the shaders of merged batch groups.
+static Technique* GetPassTechnique(Material* material, Pass* pass)
+{
+    const Vector<TechniqueEntry>& techniques = material->GetTechniques();
+    for (unsigned i = 0; i < techniques.Size(); ++i)
+    {
+        Technique* tech = techniques[i].technique_;
+        if (tech && tech->GetPass(pass->GetIndex()) == pass)
+            return tech;
+    }
+
+    return techniques.Size() ? techniques[0].technique_.Get() : (Technique*)0;
+}
+
 StringHash ParseTextureTypeXml(ResourceCache* cache, String filename);
 
 View::View(Context* context) :
     Object(context),
     graphics_(GetSubsystem<Graphics>()),
     renderer_(GetSubsystem<Renderer>()),
+    commandList_(0),
     scene_(0),
     octree_(0),
     cullCamera_(0),
@@ -302,12 +354,17 @@ View::View(Context* context) :
     occlusionBuffer_(0),
     renderTarget_(0),
     substituteRenderTarget_(0),
+    activeOccluders_(0),
+    visibilityCacheHits_(0),
+    visibilityCacheMisses_(0),
+    skipOcclusionTest_(false),
     passCommand_(0)
 {
     // Create octree query and scene results vector for each thread
     unsigned numThreads = GetSubsystem<WorkQueue>()->GetNumThreads() + 1; // Worker threads + main thread
     tempDrawables_.Resize(numThreads);
     sceneResults_.Resize(numThreads);
+    batchResults_.Resize(numThreads);
     frame_.camera_ = 0;
 }
 
@@ -367,6 +424,9 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
             deferred_ = sourceView_->deferred_;
             deferredAmbient_ = sourceView_->deferredAmbient_;
             useLitBase_ = sourceView_->useLitBase_;
+            clustered_ = sourceView_->clustered_;
+            if (clustered_ && !lightClusters_)
+                lightClusters_ = new LightClusters(context_);
             hasScenePasses_ = sourceView_->hasScenePasses_;
             noStencil_ = sourceView_->noStencil_;
             lightVolumeCommand_ = sourceView_->lightVolumeCommand_;
@@ -392,6 +452,9 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
     deferred_ = false;
     deferredAmbient_ = false;
     useLitBase_ = false;
+    clustered_ = false;
+    clusteredBasePass_ = false;
+    clusteredAlphaPass_ = false;
     hasScenePasses_ = false;
     noStencil_ = false;
     lightVolumeCommand_ = 0;
@@ -438,6 +501,10 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
             info.allowInstancing_ = command.sortMode_ != SORT_BACKTOFRONT;
             info.markToStencil_ = !noStencil_ && command.markToStencil_;
             info.vertexLights_ = command.vertexLights_;
+#ifndef GL_ES_VERSION_2_0
+            if (command.clusteredLights_)
+                clustered_ = true;
+#endif
 
             // Check scenepass metadata for defining custom passes which interact with lighting
             if (!command.metadata_.Empty())
@@ -517,6 +584,26 @@ bool View::Define(RenderSurface* renderTarget, Viewport* viewport)
         }
     }
 
+    // Clustered lights are applied in the base pass, so the lit base optimization can not be used with them
+    if (clustered_)
+    {
+        // Find whether the base and alpha passes get the clustered lights, now that their pass indices are known
+        for (unsigned i = 0; i < renderPath_->commands_.Size(); ++i)
+        {
+            const RenderPathCommand& command = renderPath_->commands_[i];
+            if (!command.enabled_ || command.type_ != CMD_SCENEPASS || !command.clusteredLights_)
+                continue;
+            if (command.passIndex_ == basePassIndex_)
+                clusteredBasePass_ = true;
+            else if (command.passIndex_ == alphaPassIndex_)
+                clusteredAlphaPass_ = true;
+        }
+
+        if (!lightClusters_)
+            lightClusters_ = new LightClusters(context_);
+        useLitBase_ = false;
+    }
+
     drawShadows_ = renderer_->GetDrawShadows();
     materialQuality_ = renderer_->GetMaterialQuality();
     maxOccluderTriangles_ = renderer_->GetMaxOccluderTriangles();
@@ -565,6 +652,7 @@ void View::Update(const FrameInfo& frame)
     occluders_.Clear();
     activeOccluders_ = 0;
     vertexLightQueues_.Clear();
+    clusteredLights_.Clear();
     for (HashMap<unsigned, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
         i->second_.Clear(maxSortedInstances);
 
@@ -587,6 +675,8 @@ void View::Update(const FrameInfo& frame)
 
 void View::Render()
 {
+    commandList_ = renderer_->GetCommandList();
+
     SendViewEvent(E_BEGINVIEWRENDER);
 
     if (hasScenePasses_ && (!octree_ || !camera_))
@@ -602,7 +692,7 @@ void View::Render()
     SendViewEvent(E_VIEWBUFFERSREADY);
 
     // Forget parameter sources from the previous view
-    graphics_->ClearParameterSources();
+    commandList_->ClearParameterSources();
 
     if (renderer_->GetDynamicInstancing() && graphics_->GetInstancingSupport())
         PrepareInstancingBuffer();
@@ -612,12 +702,20 @@ void View::Render()
     if (camera_ && camera_->GetAutoAspectRatio())
         camera_->SetAspectRatioInternal((float)(viewSize_.x_) / (float)(viewSize_.y_));
 
+    // Bin the clustered lights for the render camera and upload them. A view sharing another view's preparation uses that
+    // view's lights
+    if (clustered_ && lightClusters_ && camera_)
+    {
+        lightClusters_->Update(camera_, sourceView_ ? sourceView_->clusteredLights_ : clusteredLights_);
+        lightClusters_->UpdateTextures();
+    }
+
     // Bind the face selection and indirection cube maps for point light shadows
 #ifndef GL_ES_VERSION_2_0
     if (renderer_->GetDrawShadows())
     {
-        graphics_->SetTexture(TU_FACESELECT, renderer_->GetFaceSelectCubeMap());
-        graphics_->SetTexture(TU_INDIRECTION, renderer_->GetIndirectionCubeMap());
+        commandList_->SetTexture(TU_FACESELECT, renderer_->GetFaceSelectCubeMap());
+        commandList_->SetTexture(TU_INDIRECTION, renderer_->GetIndirectionCubeMap());
     }
 #endif
 
@@ -635,13 +733,13 @@ void View::Render()
     ExecuteRenderPathCommands();
 
     // Reset state after commands
-    graphics_->SetFillMode(FILL_SOLID);
-    graphics_->SetLineAntiAlias(false);
-    graphics_->SetClipPlane(false);
-    graphics_->SetColorWrite(true);
-    graphics_->SetDepthBias(0.0f, 0.0f);
-    graphics_->SetScissorTest(false);
-    graphics_->SetStencilTest(false);
+    commandList_->SetFillMode(FILL_SOLID);
+    commandList_->SetLineAntiAlias(false);
+    commandList_->SetClipPlane(false);
+    commandList_->SetColorWrite(true);
+    commandList_->SetDepthBias(0.0f, 0.0f);
+    commandList_->SetScissorTest(false);
+    commandList_->SetStencilTest(false);
 
     // Draw the associated debug geometry now if enabled
     if (drawDebug_ && octree_ && camera_)
@@ -658,20 +756,24 @@ void View::Render()
                 lastCustomDepthSurface_ = 0;
             }
 
-            graphics_->SetRenderTarget(0, currentRenderTarget_);
+            commandList_->SetRenderTarget(0, currentRenderTarget_);
             for (unsigned i = 1; i < MAX_RENDERTARGETS; ++i)
-                graphics_->SetRenderTarget(i, (RenderSurface*)0);
+                commandList_->SetRenderTarget(i, (RenderSurface*)0);
 
             // If a custom depth surface was used, use it also for debug rendering
-            graphics_->SetDepthStencil(lastCustomDepthSurface_ ? lastCustomDepthSurface_ : GetDepthStencil(currentRenderTarget_));
+            commandList_->SetDepthStencil(lastCustomDepthSurface_ ? lastCustomDepthSurface_ : GetDepthStencil(currentRenderTarget_));
 
-            IntVector2 rtSizeNow = graphics_->GetRenderTargetDimensions();
+            IntVector2 rtSizeNow = commandList_->GetRenderTargetDimensions();
             IntRect viewport = (currentRenderTarget_ == renderTarget_) ? viewRect_ : IntRect(0, 0, rtSizeNow.x_,
                 rtSizeNow.y_);
-            graphics_->SetViewport(viewport);
+            commandList_->SetViewport(viewport);
 
+            // The debug renderer draws directly, so replay the recorded commands before it
+            bool suspended = commandList_->Suspend();
             debug->SetView(camera_);
             debug->Render();
+            if (suspended)
+                commandList_->BeginRecording();
         }
     }
 
@@ -698,6 +800,11 @@ Renderer* View::GetRenderer() const
     return renderer_;
 }
 
+RenderCommandList* View::GetCommandList() const
+{
+    return commandList_;
+}
+
 View* View::GetSourceView() const
 {
     return sourceView_;
@@ -705,14 +812,14 @@ View* View::GetSourceView() const
 
 void View::SetGlobalShaderParameters()
 {
-    graphics_->SetShaderParameter(VSP_DELTATIME, frame_.timeStep_);
-    graphics_->SetShaderParameter(PSP_DELTATIME, frame_.timeStep_);
+    commandList_->SetShaderParameter(VSP_DELTATIME, frame_.timeStep_);
+    commandList_->SetShaderParameter(PSP_DELTATIME, frame_.timeStep_);
 
     if (scene_)
     {
         float elapsedTime = scene_->GetElapsedTime();
-        graphics_->SetShaderParameter(VSP_ELAPSEDTIME, elapsedTime);
-        graphics_->SetShaderParameter(PSP_ELAPSEDTIME, elapsedTime);
+        commandList_->SetShaderParameter(VSP_ELAPSEDTIME, elapsedTime);
+        commandList_->SetShaderParameter(PSP_ELAPSEDTIME, elapsedTime);
     }
 
     SendViewEvent(E_VIEWGLOBALSHADERPARAMETERS);
@@ -725,17 +832,17 @@ void View::SetCameraShaderParameters(Camera* camera)
 
     Matrix3x4 cameraEffectiveTransform = camera->GetEffectiveWorldTransform();
 
-    graphics_->SetShaderParameter(VSP_CAMERAPOS, cameraEffectiveTransform.Translation());
-    graphics_->SetShaderParameter(VSP_VIEWINV, cameraEffectiveTransform);
-    graphics_->SetShaderParameter(VSP_VIEW, camera->GetView());
-    graphics_->SetShaderParameter(PSP_CAMERAPOS, cameraEffectiveTransform.Translation());
+    commandList_->SetShaderParameter(VSP_CAMERAPOS, cameraEffectiveTransform.Translation());
+    commandList_->SetShaderParameter(VSP_VIEWINV, cameraEffectiveTransform);
+    commandList_->SetShaderParameter(VSP_VIEW, camera->GetView());
+    commandList_->SetShaderParameter(PSP_CAMERAPOS, cameraEffectiveTransform.Translation());
 
     float nearClip = camera->GetNearClip();
     float farClip = camera->GetFarClip();
-    graphics_->SetShaderParameter(VSP_NEARCLIP, nearClip);
-    graphics_->SetShaderParameter(VSP_FARCLIP, farClip);
-    graphics_->SetShaderParameter(PSP_NEARCLIP, nearClip);
-    graphics_->SetShaderParameter(PSP_FARCLIP, farClip);
+    commandList_->SetShaderParameter(VSP_NEARCLIP, nearClip);
+    commandList_->SetShaderParameter(VSP_FARCLIP, farClip);
+    commandList_->SetShaderParameter(PSP_NEARCLIP, nearClip);
+    commandList_->SetShaderParameter(PSP_FARCLIP, farClip);
 
     Vector4 depthMode = Vector4::ZERO;
     if (camera->IsOrthographic())
@@ -751,16 +858,27 @@ void View::SetCameraShaderParameters(Camera* camera)
     else
         depthMode.w_ = 1.0f / camera->GetFarClip();
 
-    graphics_->SetShaderParameter(VSP_DEPTHMODE, depthMode);
+    commandList_->SetShaderParameter(VSP_DEPTHMODE, depthMode);
 
     Vector4 depthReconstruct
         (farClip / (farClip - nearClip), -nearClip / (farClip - nearClip), camera->IsOrthographic() ? 1.0f : 0.0f,
             camera->IsOrthographic() ? 0.0f : 1.0f);
-    graphics_->SetShaderParameter(PSP_DEPTHRECONSTRUCT, depthReconstruct);
+    commandList_->SetShaderParameter(PSP_DEPTHRECONSTRUCT, depthReconstruct);
+
+    LightClusters* clusters = GetLightClusters();
+    if (clusters)
+    {
+        // If the projection has been flipped since binning, flip the cluster lookup too
+        Vector4 clusterDepthParams = clusters->GetDepthParams();
+        clusterDepthParams.w_ = camera->GetFlipVertical() != clusters->GetFlipVertical() ? -1.0f : 1.0f;
+        commandList_->SetShaderParameter(PSP_CLUSTERPARAMS, clusters->GetClusterParams());
+        commandList_->SetShaderParameter(PSP_CLUSTERDEPTHPARAMS, clusterDepthParams);
+        commandList_->SetShaderParameter(PSP_CLUSTERINVTEXSIZE, clusters->GetInvTextureSize());
+    }
 
     Vector3 nearVector, farVector;
     camera->GetFrustumSize(nearVector, farVector);
-    graphics_->SetShaderParameter(VSP_FRUSTUMSIZE, farVector);
+    commandList_->SetShaderParameter(VSP_FRUSTUMSIZE, farVector);
 
     Matrix4 projection = camera->GetGPUProjection();
 #ifdef URHO3D_OPENGL
@@ -770,7 +888,7 @@ void View::SetCameraShaderParameters(Camera* camera)
     projection.m23_ += projection.m33_ * constantBias;
 #endif
 
-    graphics_->SetShaderParameter(VSP_VIEWPROJ, projection * camera->GetView());
+    commandList_->SetShaderParameter(VSP_VIEWPROJ, projection * camera->GetView());
 
     // If in a scene pass and the command defines shader parameters, set them now
     if (passCommand_)
@@ -781,7 +899,7 @@ void View::SetCommandShaderParameters(const RenderPathCommand& command)
 {
     const HashMap<StringHash, Variant>& parameters = command.shaderParameters_;
     for (HashMap<StringHash, Variant>::ConstIterator k = parameters.Begin(); k != parameters.End(); ++k)
-        graphics_->SetShaderParameter(k->first_, k->second_);
+        commandList_->SetShaderParameter(k->first_, k->second_);
 }
 
 void View::SetGBufferShaderParameters(const IntVector2& texSize, const IntRect& viewRect)
@@ -799,11 +917,11 @@ void View::SetGBufferShaderParameters(const IntVector2& texSize, const IntRect&
     Vector4 bufferUVOffset((pixelUVOffset.x_ + (float)viewRect.left_) / texWidth + widthRange,
         (pixelUVOffset.y_ + (float)viewRect.top_) / texHeight + heightRange, widthRange, heightRange);
 #endif
-    graphics_->SetShaderParameter(VSP_GBUFFEROFFSETS, bufferUVOffset);
+    commandList_->SetShaderParameter(VSP_GBUFFEROFFSETS, bufferUVOffset);
 
     float invSizeX = 1.0f / texWidth;
     float invSizeY = 1.0f / texHeight;
-    graphics_->SetShaderParameter(PSP_GBUFFERINVSIZE, Vector2(invSizeX, invSizeY));
+    commandList_->SetShaderParameter(PSP_GBUFFERINVSIZE, Vector2(invSizeX, invSizeY));
 }
 
 void View::GetDrawables()
@@ -815,20 +933,44 @@ void View::GetDrawables()
 
     WorkQueue* queue = GetSubsystem<WorkQueue>();
     PODVector<Drawable*>& tempDrawables = tempDrawables_[0];
+    const Frustum& frustum = cullCamera_->GetFrustum();
+    unsigned viewMask = cullCamera_->GetViewMask();
+
+    // Check whether the octree query results of the previous frame can be reused. On a partial hit only the drawables
+    // that were updated in the octree since then need to be tested again
+    VisibilityCacheResult cacheResult = CheckVisibilityCache();
+    ViewVisibilityCache& cache = visibilityCache_;
+    visibilityCacheHits_ = 0;
+    visibilityCacheMisses_ = 0;
+
+    Drawable** movedStart = 0;
+    Drawable** movedEnd = 0;
+    if (cacheResult == VCR_PARTIAL)
+    {
+        const PODVector<Drawable*>& movedDrawables = octree_->GetUpdatedDrawables();
+        movedStart = const_cast<Drawable**>(&movedDrawables[0]);
+        movedEnd = movedStart + movedDrawables.Size();
+    }
 
     // Get zones and occluders first
+    if (cacheResult == VCR_MISS)
     {
-        ZoneOccluderOctreeQuery
-            query(tempDrawables, cullCamera_->GetFrustum(), DRAWABLE_GEOMETRY | DRAWABLE_ZONE, cullCamera_->GetViewMask());
+        ZoneOccluderOctreeQuery query(cache.zonesAndOccluders_, frustum, DRAWABLE_GEOMETRY | DRAWABLE_ZONE, viewMask);
         octree_->GetDrawables(query);
     }
+    else if (cacheResult == VCR_PARTIAL)
+    {
+        RemoveMovedDrawables(cache.zonesAndOccluders_);
+        ZoneOccluderOctreeQuery query(cache.zonesAndOccluders_, frustum, DRAWABLE_GEOMETRY | DRAWABLE_ZONE, viewMask);
+        query.TestDrawables(movedStart, movedEnd, false);
+    }
 
     highestZonePriority_ = M_MIN_INT;
     int bestPriority = M_MIN_INT;
     Node* cameraNode = cullCamera_->GetNode();
     Vector3 cameraPos = cameraNode->GetWorldPosition();
 
-    for (PODVector<Drawable*>::ConstIterator i = tempDrawables.Begin(); i != tempDrawables.End(); ++i)
+    for (PODVector<Drawable*>::ConstIterator i = cache.zonesAndOccluders_.Begin(); i != cache.zonesAndOccluders_.End(); ++i)
     {
         Drawable* drawable = *i;
         unsigned char flags = drawable->GetDrawableFlags();
@@ -870,9 +1012,9 @@ void View::GetDrawables()
     if (farClipZone_ == renderer_->GetDefaultZone())
         farClipZone_ = cameraZone_;
 
-    // If occlusion in use, get & render the occluders
+    // If occlusion in use, get & render the occluders. On a full cache hit the occlusion results are reused as is
     occlusionBuffer_ = 0;
-    if (maxOccluderTriangles_ > 0)
+    if (maxOccluderTriangles_ > 0 && cacheResult != VCR_HIT)
     {
         UpdateOccluders(occluders_, cullCamera_);
         if (occluders_.Size())
@@ -887,16 +1029,49 @@ void View::GetDrawables()
         occluders_.Clear();
 
     // Get lights and geometries. Coarse occlusion for octants is used at this point
-    if (occlusionBuffer_)
+    PODVector<Drawable*>& drawables = cacheResult == VCR_MISS ? tempDrawables : cache.drawables_;
+    if (cacheResult == VCR_MISS)
     {
-        OccludedFrustumOctreeQuery query
-            (tempDrawables, cullCamera_->GetFrustum(), occlusionBuffer_, DRAWABLE_GEOMETRY | DRAWABLE_LIGHT, cullCamera_->GetViewMask());
-        octree_->GetDrawables(query);
+        if (occlusionBuffer_)
+        {
+            OccludedFrustumOctreeQuery query
+                (tempDrawables, frustum, occlusionBuffer_, DRAWABLE_GEOMETRY | DRAWABLE_LIGHT, viewMask);
+            octree_->GetDrawables(query);
+        }
+        else
+        {
+            FrustumOctreeQuery query(tempDrawables, frustum, DRAWABLE_GEOMETRY | DRAWABLE_LIGHT, viewMask);
+            octree_->GetDrawables(query);
+        }
+
+        visibilityCacheMisses_ = tempDrawables.Size();
+        skipOcclusionTest_ = false;
     }
     else
     {
-        FrustumOctreeQuery query(tempDrawables, cullCamera_->GetFrustum(), DRAWABLE_GEOMETRY | DRAWABLE_LIGHT, cullCamera_->GetViewMask());
-        octree_->GetDrawables(query);
+        // Reuse the drawables that passed the visibility tests on the previous frame. On a partial hit, test the moved
+        // drawables against the frustum and the occlusion buffer now, so that the threaded work can skip occlusion
+        if (cacheResult == VCR_PARTIAL)
+        {
+            RemoveMovedDrawables(cache.drawables_);
+            visibilityCacheHits_ = cache.drawables_.Size();
+            visibilityCacheMisses_ = (unsigned)(movedEnd - movedStart);
+
+            tempDrawables.Clear();
+            FrustumOctreeQuery query(tempDrawables, frustum, DRAWABLE_GEOMETRY | DRAWABLE_LIGHT, viewMask);
+            query.TestDrawables(movedStart, movedEnd, false);
+
+            for (PODVector<Drawable*>::ConstIterator i = tempDrawables.Begin(); i != tempDrawables.End(); ++i)
+            {
+                Drawable* drawable = *i;
+                if (!occlusionBuffer_ || !drawable->IsOccludee() || occlusionBuffer_->IsVisible(drawable->GetWorldBoundingBox()))
+                    cache.drawables_.Push(drawable);
+            }
+        }
+        else
+            visibilityCacheHits_ = cache.drawables_.Size();
+
+        skipOcclusionTest_ = true;
     }
 
     // Check drawable occlusion, find zones for moved drawables and collect geometries & lights in worker threads
@@ -907,14 +1082,15 @@ void View::GetDrawables()
 
             result.geometries_.Clear();
             result.lights_.Clear();
+            result.unoccluded_.Clear();
             result.minZ_ = M_INFINITY;
             result.maxZ_ = 0.0f;
         }
 
         int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = tempDrawables.Size() / numWorkItems;
+        int drawablesPerItem = drawables.Size() / numWorkItems;
 
-        PODVector<Drawable*>::Iterator start = tempDrawables.Begin();
+        PODVector<Drawable*>::Iterator start = drawables.Begin();
         // Create a work item for each thread
         for (int i = 0; i < numWorkItems; ++i)
         {
@@ -923,7 +1099,7 @@ void View::GetDrawables()
             item->workFunction_ = CheckVisibilityWork;
             item->aux_ = this;
 
-            PODVector<Drawable*>::Iterator end = tempDrawables.End();
+            PODVector<Drawable*>::Iterator end = drawables.End();
             if (i < numWorkItems - 1 && end - start > drawablesPerItem)
                 end = start + drawablesPerItem;
 
@@ -937,6 +1113,20 @@ void View::GetDrawables()
         queue->Complete(M_MAX_UNSIGNED);
     }
 
+    // Store the drawables that passed the occlusion test for the next frame
+    if (cache.valid_ && cacheResult == VCR_MISS)
+    {
+        if (occlusionBuffer_)
+        {
+            cache.drawables_.Clear();
+            for (unsigned i = 0; i < sceneResults_.Size(); ++i)
+                cache.drawables_.Push(sceneResults_[i].unoccluded_);
+        }
+        else
+            Swap(cache.drawables_, tempDrawables);
+    }
+    skipOcclusionTest_ = false;
+
     // Combine lights, geometries & scene Z range from the threads
     geometries_.Clear();
     lights_.Clear();
@@ -978,6 +1168,71 @@ void View::GetDrawables()
     Sort(lights_.Begin(), lights_.End(), CompareLights);
 }
 
+VisibilityCacheResult View::CheckVisibilityCache()
+{
+    ViewVisibilityCache& cache = visibilityCache_;
+    const Frustum& frustum = cullCamera_->GetFrustum();
+    unsigned structureVersion = octree_->GetStructureVersion();
+    unsigned updateVersion = octree_->GetUpdateVersion();
+
+    bool sameKey = cache.valid_ && cache.octree_.Get() == octree_ && cache.viewMask_ == cullCamera_->GetViewMask() &&
+        cache.maxOccluderTriangles_ == maxOccluderTriangles_ && cache.structureVersion_ == structureVersion;
+    for (unsigned i = 0; sameKey && i < NUM_FRUSTUM_VERTICES; ++i)
+    {
+        if (cache.frustum_.vertices_[i] != frustum.vertices_[i])
+            sameKey = false;
+    }
+    unsigned lastUpdateVersion = cache.updateVersion_;
+
+    cache.octree_ = octree_;
+    cache.frustum_ = frustum;
+    cache.viewMask_ = cullCamera_->GetViewMask();
+    cache.maxOccluderTriangles_ = maxOccluderTriangles_;
+    cache.structureVersion_ = structureVersion;
+    cache.updateVersion_ = updateVersion;
+    cache.valid_ = renderer_->GetVisibilityCaching();
+
+    if (!cache.valid_)
+    {
+        cache.zonesAndOccluders_.Clear();
+        cache.drawables_.Clear();
+        return VCR_MISS;
+    }
+    if (!sameKey)
+        return VCR_MISS;
+    if (updateVersion == lastUpdateVersion)
+        return VCR_HIT;
+    // If more than one octree update happened since, the drawables moved in between are not known
+    if (updateVersion != lastUpdateVersion + 1)
+        return VCR_MISS;
+
+    const PODVector<Drawable*>& movedDrawables = octree_->GetUpdatedDrawables();
+    cache.movedDrawables_.Clear();
+    for (PODVector<Drawable*>::ConstIterator i = movedDrawables.Begin(); i != movedDrawables.End(); ++i)
+    {
+        Drawable* drawable = *i;
+        // A moved occluder changes the occlusion test result of any drawable, so everything needs to be tested again
+        if (maxOccluderTriangles_ > 0 && drawable->IsOccluder())
+            return VCR_MISS;
+        cache.movedDrawables_.Insert(drawable);
+    }
+
+    return VCR_PARTIAL;
+}
+
+void View::RemoveMovedDrawables(PODVector<Drawable*>& drawables)
+{
+    const HashSet<Drawable*>& movedDrawables = visibilityCache_.movedDrawables_;
+
+    PODVector<Drawable*>::Iterator dest = drawables.Begin();
+    for (PODVector<Drawable*>::Iterator i = drawables.Begin(); i != drawables.End(); ++i)
+    {
+        if (!movedDrawables.Contains(*i))
+            *dest++ = *i;
+    }
+    drawables.Resize((unsigned)(dest - drawables.Begin()));
+}
+
 void View::GetBatches()
 {
     if (!octree_ || !cullCamera_)
@@ -1025,11 +1280,13 @@ void View::GetLightBatches()
     {
         URHO3D_PROFILE(GetLightBatches);
 
-        // Preallocate light queues: per-pixel lights which have lit geometries
+        // Preallocate light queues: per-pixel lights which have lit geometries. Lights binned to clusters need them too, for
+        // the passes that can not apply clustered lights
         unsigned numLightQueues = 0;
         unsigned usedLightQueues = 0;
-        for (Vector<LightQueryResult>::ConstIterator i = lightQueryResults_.Begin(); i != lightQueryResults_.End(); ++i)
+        for (Vector<LightQueryResult>::Iterator i = lightQueryResults_.Begin(); i != lightQueryResults_.End(); ++i)
         {
+            i->clustered_ = IsClusteredLight(*i);
             if (!i->light_->GetPerVertex() && i->litGeometries_.Size())
                 ++numLightQueues;
         }
@@ -1048,6 +1305,10 @@ void View::GetLightBatches()
 
             Light* light = query.light_;
 
+            // Clustered light: applied in the base and alpha passes that support it, and per light in the others
+            if (query.clustered_)
+                clusteredLights_.Push(light);
+
             // Per-pixel light
             if (!light->GetPerVertex())
             {
@@ -1058,7 +1319,10 @@ void View::GetLightBatches()
                 light->SetLightQueue(&lightQueue);
                 lightQueue.light_ = light;
                 lightQueue.negative_ = light->IsNegative();
+                lightQueue.clustered_ = query.clustered_;
                 lightQueue.shadowMap_ = 0;
+                lightQueue.shaderParameters_[0].Reset();
+                lightQueue.shaderParameters_[1].Reset();
                 lightQueue.litBaseBatches_.Clear(maxSortedInstances);
                 lightQueue.litBatches_.Clear(maxSortedInstances);
                 if (forwardLightsCommand_)
@@ -1070,13 +1334,18 @@ void View::GetLightBatches()
                 {
                     lightQueue.litBaseBatches_.hasExtraDefines_ = false;
                     lightQueue.litBatches_.hasExtraDefines_ = false;
+                    lightQueue.litBaseBatches_.clustered_ = false;
+                    lightQueue.litBatches_.clustered_ = false;
                 }
                 lightQueue.volumeBatches_.Clear();
 
-                // Allocate shadow map now
+                // Allocate shadow map now. Lights with static shadows keep their own
                 if (shadowSplits > 0)
                 {
-                    lightQueue.shadowMap_ = renderer_->GetShadowMap(light, cullCamera_, (unsigned)viewSize_.x_, (unsigned)viewSize_.y_);
+                    if (query.staticShadows_)
+                        lightQueue.shadowMap_ = renderer_->GetStaticShadowMap(light);
+                    else
+                        lightQueue.shadowMap_ = renderer_->GetShadowMap(light, cullCamera_, (unsigned)viewSize_.x_, (unsigned)viewSize_.y_);
                     // If did not manage to get a shadow map, convert the light to unshadowed
                     if (!lightQueue.shadowMap_)
                         shadowSplits = 0;
@@ -1096,57 +1365,21 @@ void View::GetLightBatches()
                     // Setup the shadow split viewport and finalize shadow camera parameters
                     shadowQueue.shadowViewport_ = GetShadowMapViewport(light, j, lightQueue.shadowMap_);
                     FinalizeShadowCamera(shadowCamera, light, shadowQueue.shadowViewport_, query.shadowCasterBox_[j]);
-
-                    // Loop through shadow casters
-                    for (PODVector<Drawable*>::ConstIterator k = query.shadowCasters_.Begin() + query.shadowCasterBegin_[j];
-                         k < query.shadowCasters_.Begin() + query.shadowCasterEnd_[j]; ++k)
-                    {
-                        Drawable* drawable = *k;
-                        // If drawable is not in actual view frustum, mark it in view here and check its geometry update type
-                        if (!drawable->IsInView(frame_, true))
-                        {
-                            drawable->MarkInView(frame_.frameNumber_);
-                            UpdateGeometryType type = drawable->GetUpdateGeometryType();
-                            if (type == UPDATE_MAIN_THREAD)
-                                nonThreadedGeometries_.Push(drawable);
-                            else if (type == UPDATE_WORKER_THREAD)
-                                threadedGeometries_.Push(drawable);
-                        }
-
-                        const Vector<SourceBatch>& batches = drawable->GetBatches();
-
-                        for (unsigned l = 0; l < batches.Size(); ++l)
-                        {
-                            const SourceBatch& srcBatch = batches[l];
-
-                            Technique* tech = GetTechnique(drawable, srcBatch.material_);
-                            if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
-                                continue;
-
-                            Pass* pass = tech->GetSupportedPass(Technique::shadowPassIndex);
-                            // Skip if material has no shadow pass
-                            if (!pass)
-                                continue;
-
-                            Batch destBatch(srcBatch);
-                            destBatch.pass_ = pass;
-                            destBatch.zone_ = 0;
-
-                            AddBatchToQueue(shadowQueue.shadowBatches_, destBatch, tech);
-                        }
-                    }
                 }
 
-                // Process lit geometries
+                lightQueue.dirtyShadowSplits_ = M_MAX_UNSIGNED;
+                if (shadowSplits > 0 && query.staticShadows_)
+                    lightQueue.dirtyShadowSplits_ = GetStaticShadowSplits(query, lightQueue);
+
+                // Record the light to lit geometries. This decides the first light of each drawable, so it is done for all
+                // lights before generating lit batches
                 for (PODVector<Drawable*>::ConstIterator j = query.litGeometries_.Begin(); j != query.litGeometries_.End(); ++j)
                 {
                     Drawable* drawable = *j;
                     drawable->AddLight(light);
 
                     // If drawable limits maximum lights, only record the light, and check maximum count / build batches later
-                    if (!drawable->GetMaxLights())
-                        GetLitBatches(drawable, lightQueue, alphaQueue);
-                    else
+                    if (drawable->GetMaxLights())
                         maxLightsDrawables_.Insert(drawable);
                 }
 
@@ -1181,6 +1414,74 @@ void View::GetLightBatches()
                 }
             }
         }
+
+        // Get shadow caster and lit batches. With worker threads, process each light in its own work item: the light queues
+        // are only written by their own item, while lit alpha batches and shadow casters outside the view are collected
+        // per thread and combined afterward
+        if (batchResults_.Size() > 1 && lightQueues_.Size())
+        {
+            WorkQueue* queue = GetSubsystem<WorkQueue>();
+
+            for (unsigned i = 0; i < batchResults_.Size(); ++i)
+            {
+                PerThreadBatchResult& result = batchResults_[i];
+                result.alphaQueue_.Clear(maxSortedInstances);
+                if (alphaQueue)
+                    CopyQueueShaderDefines(result.alphaQueue_, *alphaQueue);
+                result.shadowCasters_.Clear();
+                result.deferredBatches_.Clear();
+            }
+
+            for (Vector<LightQueryResult>::Iterator i = lightQueryResults_.Begin(); i != lightQueryResults_.End(); ++i)
+            {
+                if (i->light_->GetPerVertex() || i->litGeometries_.Empty())
+                    continue;
+
+                SharedPtr<WorkItem> item = queue->GetFreeItem();
+                item->priority_ = M_MAX_UNSIGNED;
+                item->workFunction_ = GetLightBatchesWork;
+                item->aux_ = this;
+                item->start_ = &(*i);
+                queue->AddWorkItem(item);
+            }
+
+            queue->Complete(M_MAX_UNSIGNED);
+
+            for (unsigned i = 0; i < batchResults_.Size(); ++i)
+            {
+                PerThreadBatchResult& result = batchResults_[i];
+
+                // If a shadow caster is not in actual view frustum, mark it in view here and check its geometry update type.
+                // The same drawable may have been reported by several lights
+                for (PODVector<Drawable*>::ConstIterator j = result.shadowCasters_.Begin(); j != result.shadowCasters_.End(); ++j)
+                {
+                    Drawable* drawable = *j;
+                    if (!drawable->IsInView(frame_, true))
+                    {
+                        drawable->MarkInView(frame_.frameNumber_);
+                        UpdateGeometryType type = drawable->GetUpdateGeometryType();
+                        if (type == UPDATE_MAIN_THREAD)
+                            nonThreadedGeometries_.Push(drawable);
+                        else if (type == UPDATE_WORKER_THREAD)
+                            threadedGeometries_.Push(drawable);
+                    }
+                }
+
+                if (alphaQueue)
+                    MergeBatchQueue(*alphaQueue, result.alphaQueue_);
+
+                for (PODVector<DeferredBatch>::Iterator j = result.deferredBatches_.Begin(); j != result.deferredBatches_.End(); ++j)
+                    AddBatchToQueue(*j->queue_, j->batch_, j->technique_, j->allowInstancing_, j->allowShadows_);
+            }
+        }
+        else
+        {
+            for (Vector<LightQueryResult>::Iterator i = lightQueryResults_.Begin(); i != lightQueryResults_.End(); ++i)
+            {
+                if (!i->light_->GetPerVertex() && i->litGeometries_.Size())
+                    GetLightBatches(*i, 0);
+            }
+        }
     }
 
     // Process drawables with limited per-pixel light count
@@ -1210,86 +1511,241 @@ void View::GetBaseBatches()
 {
     URHO3D_PROFILE(GetBaseBatches);
 
-    for (PODVector<Drawable*>::ConstIterator i = geometries_.Begin(); i != geometries_.End(); ++i)
+    if (batchResults_.Size() == 1 || geometries_.Empty())
     {
-        Drawable* drawable = *i;
-        UpdateGeometryType type = drawable->GetUpdateGeometryType();
-        if (type == UPDATE_MAIN_THREAD)
-            nonThreadedGeometries_.Push(drawable);
-        else if (type == UPDATE_WORKER_THREAD)
-            threadedGeometries_.Push(drawable);
+        for (PODVector<Drawable*>::ConstIterator i = geometries_.Begin(); i != geometries_.End(); ++i)
+            GetBaseBatches(*i, 0);
+        return;
+    }
 
-        const Vector<SourceBatch>& batches = drawable->GetBatches();
-        bool vertexLightsProcessed = false;
+    // Collect batches in worker threads into per-thread queues for each scene pass
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    int maxSortedInstances = renderer_->GetMaxSortedInstances();
 
-        for (unsigned j = 0; j < batches.Size(); ++j)
+    for (unsigned i = 0; i < batchResults_.Size(); ++i)
+    {
+        PerThreadBatchResult& result = batchResults_[i];
+        result.scenePassQueues_.Resize(scenePasses_.Size());
+        for (unsigned j = 0; j < scenePasses_.Size(); ++j)
         {
-            const SourceBatch& srcBatch = batches[j];
+            result.scenePassQueues_[j].Clear(maxSortedInstances);
+            CopyQueueShaderDefines(result.scenePassQueues_[j], *scenePasses_[j].batchQueue_);
+        }
+        result.nonThreadedGeometries_.Clear();
+        result.threadedGeometries_.Clear();
+        result.deferredDrawables_.Clear();
+        result.auxViewMaterials_.Clear();
+        result.deferredBatches_.Clear();
+    }
 
-            // Check here if the material refers to a rendertarget texture with camera(s) attached
-            // Only check this for backbuffer views (null rendertarget)
-            if (srcBatch.material_ && srcBatch.material_->GetAuxViewFrameNumber() != frame_.frameNumber_ && !renderTarget_)
-                CheckMaterialForAuxView(srcBatch.material_);
+    int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
+    int drawablesPerItem = geometries_.Size() / numWorkItems;
 
-            Technique* tech = GetTechnique(drawable, srcBatch.material_);
-            if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
-                continue;
+    PODVector<Drawable*>::Iterator start = geometries_.Begin();
+    for (int i = 0; i < numWorkItems; ++i)
+    {
+        PODVector<Drawable*>::Iterator end = geometries_.End();
+        if (i < numWorkItems - 1 && end - start > drawablesPerItem)
+            end = start + drawablesPerItem;
 
-            // Check each of the scene passes
-            for (unsigned k = 0; k < scenePasses_.Size(); ++k)
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = GetBaseBatchesWork;
+        item->aux_ = this;
+        item->start_ = &(*start);
+        item->end_ = &(*end);
+        queue->AddWorkItem(item);
+
+        start = end;
+    }
+
+    queue->Complete(M_MAX_UNSIGNED);
+
+    // Combine the per-thread results, then process what had to be left to the main thread
+    for (unsigned i = 0; i < batchResults_.Size(); ++i)
+    {
+        PerThreadBatchResult& result = batchResults_[i];
+
+        nonThreadedGeometries_.Push(result.nonThreadedGeometries_);
+        threadedGeometries_.Push(result.threadedGeometries_);
+
+        for (unsigned j = 0; j < scenePasses_.Size(); ++j)
+            MergeBatchQueue(*scenePasses_[j].batchQueue_, result.scenePassQueues_[j]);
+
+        for (PODVector<Material*>::ConstIterator j = result.auxViewMaterials_.Begin(); j != result.auxViewMaterials_.End(); ++j)
+        {
+            if ((*j)->GetAuxViewFrameNumber() != frame_.frameNumber_)
+                CheckMaterialForAuxView(*j);
+        }
+
+        for (PODVector<Drawable*>::ConstIterator j = result.deferredDrawables_.Begin(); j != result.deferredDrawables_.End(); ++j)
+            GetBaseBatches(*j, 0);
+
+        for (PODVector<DeferredBatch>::Iterator j = result.deferredBatches_.Begin(); j != result.deferredBatches_.End(); ++j)
+            AddBatchToQueue(*j->queue_, j->batch_, j->technique_, j->allowInstancing_, j->allowShadows_);
+    }
+}
+
+void View::GetLightBatches(LightQueryResult& query, PerThreadBatchResult* result)
+{
+    Light* light = query.light_;
+    LightBatchQueue& lightQueue = *light->GetLightQueue();
+    BatchQueue* alphaQueue = batchQueues_.Contains(alphaPassIndex_) ? &batchQueues_[alphaPassIndex_] : (BatchQueue*)0;
+
+    for (unsigned i = 0; i < lightQueue.shadowSplits_.Size(); ++i)
+    {
+        // Static shadow map splits that did not change need no shadow batches
+        if (!(lightQueue.dirtyShadowSplits_ & (1u << i)))
+            continue;
+
+        ShadowBatchQueue& shadowQueue = lightQueue.shadowSplits_[i];
+
+        // Loop through shadow casters
+        for (PODVector<Drawable*>::ConstIterator j = query.shadowCasters_.Begin() + query.shadowCasterBegin_[i];
+             j < query.shadowCasters_.Begin() + query.shadowCasterEnd_[i]; ++j)
+        {
+            Drawable* drawable = *j;
+            // If drawable is not in actual view frustum, mark it in view here and check its geometry update type. Worker
+            // threads leave this to the main thread, as the drawable may be a shadow caster of several lights
+            if (!drawable->IsInView(frame_, true))
+            {
+                if (result)
+                    result->shadowCasters_.Push(drawable);
+                else
+                {
+                    drawable->MarkInView(frame_.frameNumber_);
+                    UpdateGeometryType type = drawable->GetUpdateGeometryType();
+                    if (type == UPDATE_MAIN_THREAD)
+                        nonThreadedGeometries_.Push(drawable);
+                    else if (type == UPDATE_WORKER_THREAD)
+                        threadedGeometries_.Push(drawable);
+                }
+            }
+
+            const Vector<SourceBatch>& batches = drawable->GetBatches();
+
+            for (unsigned k = 0; k < batches.Size(); ++k)
             {
-                ScenePassInfo& info = scenePasses_[k];
-                // Skip forward base pass if the corresponding litbase pass already exists
-                if (info.passIndex_ == basePassIndex_ && j < 32 && drawable->HasBasePass(j))
+                const SourceBatch& srcBatch = batches[k];
+
+                Technique* tech = GetTechnique(drawable, srcBatch.material_);
+                if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
                     continue;
 
-                Pass* pass = tech->GetSupportedPass(info.passIndex_);
+                Pass* pass = tech->GetSupportedPass(Technique::shadowPassIndex);
+                // Skip if material has no shadow pass
                 if (!pass)
                     continue;
 
                 Batch destBatch(srcBatch);
                 destBatch.pass_ = pass;
-                destBatch.zone_ = GetZone(drawable);
-                destBatch.isBase_ = true;
-                destBatch.lightMask_ = (unsigned char)GetLightMask(drawable);
+                destBatch.zone_ = 0;
 
-                if (info.vertexLights_)
+                AddBatchToQueue(shadowQueue.shadowBatches_, shadowQueue.shadowBatches_, destBatch, tech, result);
+            }
+        }
+    }
+
+    // Process lit geometries. Drawables that limit their light count are processed later
+    for (PODVector<Drawable*>::ConstIterator i = query.litGeometries_.Begin(); i != query.litGeometries_.End(); ++i)
+    {
+        Drawable* drawable = *i;
+        if (!drawable->GetMaxLights())
+            GetLitBatches(drawable, lightQueue, alphaQueue, result);
+    }
+}
+
+void View::GetBaseBatches(Drawable* drawable, PerThreadBatchResult* result)
+{
+    // Vertex light queues are shared by all drawables, so vertex lit drawables are processed in the main thread
+    if (result && drawable->GetVertexLights().Size())
+    {
+        result->deferredDrawables_.Push(drawable);
+        return;
+    }
+
+    UpdateGeometryType type = drawable->GetUpdateGeometryType();
+    if (type == UPDATE_MAIN_THREAD)
+        (result ? result->nonThreadedGeometries_ : nonThreadedGeometries_).Push(drawable);
+    else if (type == UPDATE_WORKER_THREAD)
+        (result ? result->threadedGeometries_ : threadedGeometries_).Push(drawable);
+
+    const Vector<SourceBatch>& batches = drawable->GetBatches();
+    bool vertexLightsProcessed = false;
+
+    for (unsigned i = 0; i < batches.Size(); ++i)
+    {
+        const SourceBatch& srcBatch = batches[i];
+
+        // Check here if the material refers to a rendertarget texture with camera(s) attached
+        // Only check this for backbuffer views (null rendertarget). Queuing the rendertarget update is left to the main thread
+        if (srcBatch.material_ && srcBatch.material_->GetAuxViewFrameNumber() != frame_.frameNumber_ && !renderTarget_)
+        {
+            if (!result)
+                CheckMaterialForAuxView(srcBatch.material_);
+            else if (result->auxViewMaterials_.Empty() || result->auxViewMaterials_.Back() != srcBatch.material_)
+                result->auxViewMaterials_.Push(srcBatch.material_);
+        }
+
+        Technique* tech = GetTechnique(drawable, srcBatch.material_);
+        if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
+            continue;
+
+        // Check each of the scene passes
+        for (unsigned j = 0; j < scenePasses_.Size(); ++j)
+        {
+            ScenePassInfo& info = scenePasses_[j];
+            // Skip forward base pass if the corresponding litbase pass already exists
+            if (info.passIndex_ == basePassIndex_ && i < 32 && drawable->HasBasePass(i))
+                continue;
+
+            Pass* pass = tech->GetSupportedPass(info.passIndex_);
+            if (!pass)
+                continue;
+
+            Batch destBatch(srcBatch);
+            destBatch.pass_ = pass;
+            destBatch.zone_ = GetZone(drawable);
+            destBatch.isBase_ = true;
+            destBatch.lightMask_ = (unsigned char)GetLightMask(drawable);
+
+            if (info.vertexLights_)
+            {
+                const PODVector<Light*>& drawableVertexLights = drawable->GetVertexLights();
+                if (drawableVertexLights.Size() && !vertexLightsProcessed)
                 {
-                    const PODVector<Light*>& drawableVertexLights = drawable->GetVertexLights();
-                    if (drawableVertexLights.Size() && !vertexLightsProcessed)
-                    {
-                        // Limit vertex lights. If this is a deferred opaque batch, remove converted per-pixel lights,
-                        // as they will be rendered as light volumes in any case, and drawing them also as vertex lights
-                        // would result in double lighting
-                        drawable->LimitVertexLights(deferred_ && destBatch.pass_->GetBlendMode() == BLEND_REPLACE);
-                        vertexLightsProcessed = true;
-                    }
+                    // Limit vertex lights. If this is a deferred opaque batch, remove converted per-pixel lights,
+                    // as they will be rendered as light volumes in any case, and drawing them also as vertex lights
+                    // would result in double lighting
+                    drawable->LimitVertexLights(deferred_ && destBatch.pass_->GetBlendMode() == BLEND_REPLACE);
+                    vertexLightsProcessed = true;
+                }
 
-                    if (drawableVertexLights.Size())
+                if (drawableVertexLights.Size())
+                {
+                    // Find a vertex light queue. If not found, create new
+                    unsigned long long hash = GetVertexLightQueueHash(drawableVertexLights);
+                    HashMap<unsigned long long, LightBatchQueue>::Iterator k = vertexLightQueues_.Find(hash);
+                    if (k == vertexLightQueues_.End())
                     {
-                        // Find a vertex light queue. If not found, create new
-                        unsigned long long hash = GetVertexLightQueueHash(drawableVertexLights);
-                        HashMap<unsigned long long, LightBatchQueue>::Iterator i = vertexLightQueues_.Find(hash);
-                        if (i == vertexLightQueues_.End())
-                        {
-                            i = vertexLightQueues_.Insert(MakePair(hash, LightBatchQueue()));
-                            i->second_.light_ = 0;
-                            i->second_.shadowMap_ = 0;
-                            i->second_.vertexLights_ = drawableVertexLights;
-                        }
-
-                        destBatch.lightQueue_ = &(i->second_);
+                        k = vertexLightQueues_.Insert(MakePair(hash, LightBatchQueue()));
+                        k->second_.light_ = 0;
+                        k->second_.shadowMap_ = 0;
+                        k->second_.vertexLights_ = drawableVertexLights;
                     }
+
+                    destBatch.lightQueue_ = &(k->second_);
                 }
-                else
-                    destBatch.lightQueue_ = 0;
+            }
+            else
+                destBatch.lightQueue_ = 0;
 
-                bool allowInstancing = info.allowInstancing_;
-                if (allowInstancing && info.markToStencil_ && destBatch.lightMask_ != (destBatch.zone_->GetLightMask() & 0xff))
-                    allowInstancing = false;
+            bool allowInstancing = info.allowInstancing_;
+            if (allowInstancing && info.markToStencil_ && destBatch.lightMask_ != (destBatch.zone_->GetLightMask() & 0xff))
+                allowInstancing = false;
 
-                AddBatchToQueue(*info.batchQueue_, destBatch, tech, allowInstancing);
-            }
+            BatchQueue& finalQueue = *info.batchQueue_;
+            AddBatchToQueue(result ? result->scenePassQueues_[j] : finalQueue, finalQueue, destBatch, tech, result, allowInstancing);
         }
     }
 }
@@ -1393,7 +1849,7 @@ void View::UpdateGeometries()
     geometriesUpdated_ = true;
 }
 
-void View::GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQueue* alphaQueue)
+void View::GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQueue* alphaQueue, PerThreadBatchResult* result)
 {
     Light* light = lightQueue.light_;
     Zone* zone = GetZone(drawable);
@@ -1445,21 +1901,28 @@ void View::GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQ
         if (!destBatch.pass_)
             continue;
 
+        // A clustered light is already applied by the base or alpha pass, if its shaders support it
+        if (lightQueue.clustered_ && (isLitAlpha ? clusteredAlphaPass_ : clusteredBasePass_))
+        {
+            Pass* clusteredPass = tech->GetSupportedPass(isLitAlpha ? alphaPassIndex_ : basePassIndex_);
+            if (clusteredPass && clusteredPass->GetClusteredLights())
+                continue;
+        }
+
         destBatch.lightQueue_ = &lightQueue;
         destBatch.zone_ = zone;
 
         if (!isLitAlpha)
         {
-            if (destBatch.isBase_)
-                AddBatchToQueue(lightQueue.litBaseBatches_, destBatch, tech);
-            else
-                AddBatchToQueue(lightQueue.litBatches_, destBatch, tech);
+            BatchQueue& litQueue = destBatch.isBase_ ? lightQueue.litBaseBatches_ : lightQueue.litBatches_;
+            AddBatchToQueue(litQueue, litQueue, destBatch, tech, result);
         }
         else if (alphaQueue)
         {
             // Transparent batches can not be instanced, and shadows on transparencies can only be rendered if shadow maps are
-            // not reused
-            AddBatchToQueue(*alphaQueue, destBatch, tech, false, !renderer_->GetReuseShadowMaps());
+            // not reused. The alpha queue is shared by all lights, so worker threads use their own
+            AddBatchToQueue(result ? result->alphaQueue_ : *alphaQueue, *alphaQueue, destBatch, tech, result, false,
+                !renderer_->GetReuseShadowMaps());
         }
     }
 }
@@ -1522,7 +1985,7 @@ void View::ExecuteRenderPathCommands()
                 {
                     if (!currentRenderTarget_)
                     {
-                        graphics_->ResolveToTexture(dynamic_cast<Texture2D*>(viewportTextures_[0]), viewRect_);
+                        commandList_->ResolveToTexture(dynamic_cast<Texture2D*>(viewportTextures_[0]), viewRect_);
                         currentViewportTexture_ = viewportTextures_[0];
                         viewportModified = false;
                         usedResolve_ = true;
@@ -1589,7 +2052,7 @@ void View::ExecuteRenderPathCommands()
                         clearColor = actualView->farClipZone_->GetFogColor();
 
                     SetRenderTargets(command);
-                    graphics_->Clear(command.clearFlags_, clearColor, command.clearDepth_, command.clearStencil_);
+                    commandList_->Clear(command.clearFlags_, clearColor, command.clearDepth_, command.clearStencil_);
                 }
                 break;
 
@@ -1602,14 +2065,14 @@ void View::ExecuteRenderPathCommands()
 
                         SetRenderTargets(command);
                         bool allowDepthWrite = SetTextures(command);
-                        graphics_->SetClipPlane(camera_->GetUseClipping(), camera_->GetClipPlane(), camera_->GetView(),
+                        commandList_->SetClipPlane(camera_->GetUseClipping(), camera_->GetClipPlane(), camera_->GetView(),
                             camera_->GetGPUProjection());
 
                         if (command.shaderParameters_.Size())
                         {
                             // If pass defines shader parameters, reset parameter sources now to ensure they all will be set
                             // (will be set after camera shader parameters)
-                            graphics_->ClearParameterSources();
+                            commandList_->ClearParameterSources();
                             passCommand_ = &command;
                         }
 
@@ -1648,12 +2111,12 @@ void View::ExecuteRenderPathCommands()
                         }
 
                         bool allowDepthWrite = SetTextures(command);
-                        graphics_->SetClipPlane(camera_->GetUseClipping(), camera_->GetClipPlane(), camera_->GetView(),
+                        commandList_->SetClipPlane(camera_->GetUseClipping(), camera_->GetClipPlane(), camera_->GetView(),
                             camera_->GetGPUProjection());
 
                         if (command.shaderParameters_.Size())
                         {
-                            graphics_->ClearParameterSources();
+                            commandList_->ClearParameterSources();
                             passCommand_ = &command;
                         }
 
@@ -1672,8 +2135,8 @@ void View::ExecuteRenderPathCommands()
                         passCommand_ = 0;
                     }
 
-                    graphics_->SetScissorTest(false);
-                    graphics_->SetStencilTest(false);
+                    commandList_->SetScissorTest(false);
+                    commandList_->SetStencilTest(false);
                 }
                 break;
 
@@ -1697,7 +2160,7 @@ void View::ExecuteRenderPathCommands()
 
                         if (command.shaderParameters_.Size())
                         {
-                            graphics_->ClearParameterSources();
+                            commandList_->ClearParameterSources();
                             passCommand_ = &command;
                         }
 
@@ -1710,8 +2173,8 @@ void View::ExecuteRenderPathCommands()
                         passCommand_ = 0;
                     }
 
-                    graphics_->SetScissorTest(false);
-                    graphics_->SetStencilTest(false);
+                    commandList_->SetScissorTest(false);
+                    commandList_->SetStencilTest(false);
                 }
                 break;
 
@@ -1728,7 +2191,11 @@ void View::ExecuteRenderPathCommands()
 
                     VariantMap& eventData = GetEventDataMap();
                     eventData[P_NAME] = command.eventName_;
+                    // Handlers may render directly, so the commands recorded so far must be replayed first
+                    bool suspended = commandList_->SuspendForEvent(renderer_, E_RENDERPATHEVENT);
                     renderer_->SendEvent(E_RENDERPATHEVENT, eventData);
+                    if (suspended)
+                        commandList_->BeginRecording();
                 }
                 break;
 
@@ -1754,7 +2221,7 @@ void View::SetRenderTargets(RenderPathCommand& command)
     {
         if (!command.outputs_[index].first_.Compare("viewport", false))
         {
-            graphics_->SetRenderTarget(index, currentRenderTarget_);
+            commandList_->SetRenderTarget(index, currentRenderTarget_);
             useViewportOutput = true;
         }
         else
@@ -1775,11 +2242,11 @@ void View::SetRenderTargets(RenderPathCommand& command)
                         graphics_->GetDummyColorFormat(), texture->GetMultiSample(), texture->GetAutoResolve(), false, false, false);
                 }
 #endif
-                graphics_->SetRenderTarget(0, GetRenderSurfaceFromTexture(depthOnlyDummyTexture_));
-                graphics_->SetDepthStencil(GetRenderSurfaceFromTexture(texture));
+                commandList_->SetRenderTarget(0, GetRenderSurfaceFromTexture(depthOnlyDummyTexture_));
+                commandList_->SetDepthStencil(GetRenderSurfaceFromTexture(texture));
             }
             else
-                graphics_->SetRenderTarget(index, GetRenderSurfaceFromTexture(texture, command.outputs_[index].second_));
+                commandList_->SetRenderTarget(index, GetRenderSurfaceFromTexture(texture, command.outputs_[index].second_));
         }
 
         ++index;
@@ -1787,7 +2254,7 @@ void View::SetRenderTargets(RenderPathCommand& command)
 
     while (index < MAX_RENDERTARGETS)
     {
-        graphics_->SetRenderTarget(index, (RenderSurface*)0);
+        commandList_->SetRenderTarget(index, (RenderSurface*)0);
         ++index;
     }
 
@@ -1798,20 +2265,20 @@ void View::SetRenderTargets(RenderPathCommand& command)
         {
             useCustomDepth = true;
             lastCustomDepthSurface_ = GetRenderSurfaceFromTexture(depthTexture);
-            graphics_->SetDepthStencil(lastCustomDepthSurface_);
+            commandList_->SetDepthStencil(lastCustomDepthSurface_);
         }
     }
 
     // When rendering to the final destination rendertarget, use the actual viewport. Otherwise texture rendertargets should use
     // their full size as the viewport
-    IntVector2 rtSizeNow = graphics_->GetRenderTargetDimensions();
+    IntVector2 rtSizeNow = commandList_->GetRenderTargetDimensions();
     IntRect viewport = (useViewportOutput && currentRenderTarget_ == renderTarget_) ? viewRect_ : IntRect(0, 0, rtSizeNow.x_,
         rtSizeNow.y_);
 
     if (!useCustomDepth)
-        graphics_->SetDepthStencil(GetDepthStencil(graphics_->GetRenderTarget(0)));
-    graphics_->SetViewport(viewport);
-    graphics_->SetColorWrite(useColorWrite);
+        commandList_->SetDepthStencil(GetDepthStencil(commandList_->GetRenderTarget(0)));
+    commandList_->SetViewport(viewport);
+    commandList_->SetColorWrite(useColorWrite);
 }
 
 bool View::SetTextures(RenderPathCommand& command)
@@ -1826,7 +2293,7 @@ bool View::SetTextures(RenderPathCommand& command)
         // Bind the rendered output
         if (!command.textureNames_[i].Compare("viewport", false))
         {
-            graphics_->SetTexture(i, currentViewportTexture_);
+            commandList_->SetTexture(i, currentViewportTexture_);
             continue;
         }
 
@@ -1838,9 +2305,9 @@ bool View::SetTextures(RenderPathCommand& command)
 
         if (texture)
         {
-            graphics_->SetTexture(i, texture);
+            commandList_->SetTexture(i, texture);
             // Check if the current depth stencil is being sampled
-            if (graphics_->GetDepthStencil() && texture == graphics_->GetDepthStencil()->GetParentTexture())
+            if (commandList_->GetDepthStencil() && texture == commandList_->GetDepthStencil()->GetParentTexture())
                 allowDepthWrite = false;
         }
         else
@@ -1867,13 +2334,13 @@ void View::RenderQuad(RenderPathCommand& command)
         command.pixelShaderName_ = String::EMPTY;
 
     // Set shaders & shader parameters and textures
-    graphics_->SetShaders(vs, ps);
+    commandList_->SetShaders(vs, ps);
 
     SetGlobalShaderParameters();
     SetCameraShaderParameters(camera_);
 
     // During renderpath commands the G-Buffer or viewport texture is assumed to always be viewport-sized
-    IntRect viewport = graphics_->GetViewport();
+    IntRect viewport = commandList_->GetViewport();
     IntVector2 viewSize = IntVector2(viewport.Width(), viewport.Height());
     SetGBufferShaderParameters(viewSize, IntRect(0, 0, viewSize.x_, viewSize.y_));
 
@@ -1894,21 +2361,21 @@ void View::RenderQuad(RenderPathCommand& command)
         float height = (float)renderTargets_[nameHash]->GetHeight();
 
         const Vector2& pixelUVOffset = Graphics::GetPixelUVOffset();
-        graphics_->SetShaderParameter(invSizeName, Vector2(1.0f / width, 1.0f / height));
-        graphics_->SetShaderParameter(offsetsName, Vector2(pixelUVOffset.x_ / width, pixelUVOffset.y_ / height));
+        commandList_->SetShaderParameter(invSizeName, Vector2(1.0f / width, 1.0f / height));
+        commandList_->SetShaderParameter(offsetsName, Vector2(pixelUVOffset.x_ / width, pixelUVOffset.y_ / height));
     }
 
     // Set command's shader parameters last to allow them to override any of the above
     SetCommandShaderParameters(command);
 
-    graphics_->SetBlendMode(command.blendMode_);
-    graphics_->SetDepthTest(CMP_ALWAYS);
-    graphics_->SetDepthWrite(false);
-    graphics_->SetFillMode(FILL_SOLID);
-    graphics_->SetLineAntiAlias(false);
-    graphics_->SetClipPlane(false);
-    graphics_->SetScissorTest(false);
-    graphics_->SetStencilTest(false);
+    commandList_->SetBlendMode(command.blendMode_);
+    commandList_->SetDepthTest(CMP_ALWAYS);
+    commandList_->SetDepthWrite(false);
+    commandList_->SetFillMode(FILL_SOLID);
+    commandList_->SetLineAntiAlias(false);
+    commandList_->SetClipPlane(false);
+    commandList_->SetScissorTest(false);
+    commandList_->SetStencilTest(false);
 
     DrawFullscreenQuad(false);
 }
@@ -2132,26 +2599,26 @@ void View::BlitFramebuffer(Texture* source, RenderSurface* destination, bool dep
     IntRect srcRect = (GetRenderSurfaceFromTexture(source) == renderTarget_) ? viewRect_ : IntRect(0, 0, srcSize.x_, srcSize.y_);
     IntRect destRect = (destination == renderTarget_) ? viewRect_ : IntRect(0, 0, destSize.x_, destSize.y_);
 
-    graphics_->SetBlendMode(BLEND_REPLACE);
-    graphics_->SetDepthTest(CMP_ALWAYS);
-    graphics_->SetDepthWrite(depthWrite);
-    graphics_->SetFillMode(FILL_SOLID);
-    graphics_->SetLineAntiAlias(false);
-    graphics_->SetClipPlane(false);
-    graphics_->SetScissorTest(false);
-    graphics_->SetStencilTest(false);
-    graphics_->SetRenderTarget(0, destination);
+    commandList_->SetBlendMode(BLEND_REPLACE);
+    commandList_->SetDepthTest(CMP_ALWAYS);
+    commandList_->SetDepthWrite(depthWrite);
+    commandList_->SetFillMode(FILL_SOLID);
+    commandList_->SetLineAntiAlias(false);
+    commandList_->SetClipPlane(false);
+    commandList_->SetScissorTest(false);
+    commandList_->SetStencilTest(false);
+    commandList_->SetRenderTarget(0, destination);
     for (unsigned i = 1; i < MAX_RENDERTARGETS; ++i)
-        graphics_->SetRenderTarget(i, (RenderSurface*)0);
-    graphics_->SetDepthStencil(GetDepthStencil(destination));
-    graphics_->SetViewport(destRect);
+        commandList_->SetRenderTarget(i, (RenderSurface*)0);
+    commandList_->SetDepthStencil(GetDepthStencil(destination));
+    commandList_->SetViewport(destRect);
 
     static const String shaderName("CopyFramebuffer");
-    graphics_->SetShaders(graphics_->GetShader(VS, shaderName), graphics_->GetShader(PS, shaderName));
+    commandList_->SetShaders(graphics_->GetShader(VS, shaderName), graphics_->GetShader(PS, shaderName));
 
     SetGBufferShaderParameters(srcSize, srcRect);
 
-    graphics_->SetTexture(TU_DIFFUSE, source);
+    commandList_->SetTexture(TU_DIFFUSE, source);
     DrawFullscreenQuad(true);
 }
 
@@ -2175,16 +2642,16 @@ void View::DrawFullscreenQuad(bool setIdentityProjection)
         model.m23_ = 0.5f;
 #endif
 
-        graphics_->SetShaderParameter(VSP_MODEL, model);
-        graphics_->SetShaderParameter(VSP_VIEWPROJ, projection);
+        commandList_->SetShaderParameter(VSP_MODEL, model);
+        commandList_->SetShaderParameter(VSP_VIEWPROJ, projection);
     }
     else
-        graphics_->SetShaderParameter(VSP_MODEL, Light::GetFullscreenQuadTransform(camera_));
+        commandList_->SetShaderParameter(VSP_MODEL, Light::GetFullscreenQuadTransform(camera_));
 
-    graphics_->SetCullMode(CULL_NONE);
-    graphics_->ClearTransformSources();
+    commandList_->SetCullMode(CULL_NONE);
+    commandList_->ClearTransformSources();
 
-    geometry->Draw(graphics_);
+    commandList_->Draw(geometry);
 }
 
 void View::UpdateOccluders(PODVector<Drawable*>& occluders, Camera* camera)
@@ -2350,6 +2817,8 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
         break;
     }
 
+    query.staticShadows_ = false;
+
     // If no lit geometries or not shadowed, no need to process shadow cameras
     if (query.litGeometries_.Empty() || !isShadowed)
     {
@@ -2360,6 +2829,15 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
     // Determine number of shadow cameras and setup their initial positions
     SetupShadowCameras(query);
 
+    // Static shadows do not depend on the camera, so the shadow casters are collected from the whole light volume and kept
+    // until something changes within it. Directional lights are fitted to the view and can not use them
+    if (light->GetStaticShadows() && type != LIGHT_DIRECTIONAL)
+    {
+        query.staticShadows_ = true;
+        ProcessStaticShadowCasters(query, tempDrawables);
+        return;
+    }
+
     // Process each split for shadow casters
     query.shadowCasters_.Clear();
     for (unsigned i = 0; i < query.numSplits_; ++i)
@@ -2395,6 +2873,218 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
         query.numSplits_ = 0;
 }
 
+void View::ProcessStaticShadowCasters(LightQueryResult& query, const PODVector<Drawable*>& drawables)
+{
+    Light* light = query.light_;
+    StaticShadowCache& cache = light->GetStaticShadowCache();
+    LightType type = light->GetLightType();
+    unsigned lightMask = light->GetLightMask();
+    unsigned viewMask = cullCamera_->GetViewMask();
+    unsigned allSplits = (1u << query.numSplits_) - 1;
+    unsigned dirtySplits = 0;
+
+    // If the light moved or its shadow cameras changed, everything needs to be collected and rendered again
+    bool lightChanged = cache.octree_ != octree_ || cache.numSplits_ != query.numSplits_ || cache.lightMask_ != lightMask ||
+        cache.viewMask_ != viewMask;
+    for (unsigned i = 0; i < query.numSplits_ && !lightChanged; ++i)
+    {
+        Camera* shadowCamera = query.shadowCameras_[i];
+        if (shadowCamera->GetView() != cache.shadowViews_[i] || shadowCamera->GetProjection() != cache.shadowProjections_[i])
+            lightChanged = true;
+    }
+
+    if (lightChanged)
+        dirtySplits = allSplits;
+    else if (octree_->GetUpdateVersion() != cache.updateVersion_)
+    {
+        // If the octree was updated more than once since the last check, the moved drawables are no longer known
+        if (octree_->GetUpdateVersion() != cache.updateVersion_ + 1)
+            dirtySplits = allSplits;
+        else
+        {
+            const PODVector<Drawable*>& updatedDrawables = octree_->GetUpdatedDrawables();
+            for (PODVector<Drawable*>::ConstIterator i = updatedDrawables.Begin(); i != updatedDrawables.End(); ++i)
+            {
+                Drawable* drawable = *i;
+
+                // A shadow caster that moved dirties the splits it was rendered to
+                if (cache.shadowCasterSet_.Contains(drawable))
+                {
+                    for (unsigned j = 0; j < query.numSplits_; ++j)
+                    {
+                        for (unsigned k = cache.shadowCasterBegin_[j]; k < cache.shadowCasterEnd_[j]; ++k)
+                        {
+                            if (cache.shadowCasters_[k] == drawable)
+                            {
+                                dirtySplits |= 1u << j;
+                                break;
+                            }
+                        }
+                    }
+                }
+
+                // A shadow caster that moved into a split dirties it as well
+                if ((drawable->GetDrawableFlags() & DRAWABLE_GEOMETRY) && drawable->GetCastShadows() &&
+                    (drawable->GetViewMask() & viewMask) && (GetShadowMask(drawable) & lightMask))
+                {
+                    const BoundingBox& box = drawable->GetWorldBoundingBox();
+                    for (unsigned j = 0; j < query.numSplits_; ++j)
+                    {
+                        if (query.shadowCameras_[j]->GetFrustum().IsInsideFast(box) != OUTSIDE)
+                            dirtySplits |= 1u << j;
+                    }
+                }
+            }
+        }
+    }
+
+    // Collect the shadow casters again if drawables were added or removed, or splits became dirty
+    if (dirtySplits || octree_->GetStructureVersion() != cache.structureVersion_)
+    {
+        query.shadowCasters_.Clear();
+        for (unsigned i = 0; i < query.numSplits_; ++i)
+        {
+            Camera* shadowCamera = query.shadowCameras_[i];
+            const Frustum& shadowCameraFrustum = shadowCamera->GetFrustum();
+            const Matrix3x4& lightView = shadowCamera->GetView();
+            const Matrix4& lightProj = shadowCamera->GetProjection();
+
+            query.shadowCasterBegin_[i] = query.shadowCasters_.Size();
+            query.shadowCasterBox_[i].Clear();
+
+            for (PODVector<Drawable*>::ConstIterator j = drawables.Begin(); j != drawables.End(); ++j)
+            {
+                Drawable* drawable = *j;
+                if (!drawable->GetCastShadows())
+                    continue;
+                if (!(GetShadowMask(drawable) & lightMask))
+                    continue;
+                if (type == LIGHT_POINT && shadowCameraFrustum.IsInsideFast(drawable->GetWorldBoundingBox()) == OUTSIDE)
+                    continue;
+
+                if (type == LIGHT_SPOT && light->GetShadowFocus().focus_)
+                    query.shadowCasterBox_[i].Merge(drawable->GetWorldBoundingBox().Transformed(lightView).Projected(lightProj));
+                query.shadowCasters_.Push(drawable);
+            }
+
+            query.shadowCasterEnd_[i] = query.shadowCasters_.Size();
+
+            // Compare to the previous shadow casters of the split. Removed drawables are only compared by address
+            if (!(dirtySplits & (1u << i)))
+            {
+                unsigned count = query.shadowCasterEnd_[i] - query.shadowCasterBegin_[i];
+                if (count != cache.shadowCasterEnd_[i] - cache.shadowCasterBegin_[i])
+                    dirtySplits |= 1u << i;
+                else
+                {
+                    for (unsigned j = 0; j < count; ++j)
+                    {
+                        if (query.shadowCasters_[query.shadowCasterBegin_[i] + j] !=
+                            cache.shadowCasters_[cache.shadowCasterBegin_[i] + j])
+                        {
+                            dirtySplits |= 1u << i;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        cache.shadowCasters_ = query.shadowCasters_;
+        cache.shadowCasterSet_.Clear();
+        for (PODVector<Drawable*>::ConstIterator i = cache.shadowCasters_.Begin(); i != cache.shadowCasters_.End(); ++i)
+            cache.shadowCasterSet_.Insert(*i);
+        for (unsigned i = 0; i < query.numSplits_; ++i)
+        {
+            cache.shadowCasterBegin_[i] = query.shadowCasterBegin_[i];
+            cache.shadowCasterEnd_[i] = query.shadowCasterEnd_[i];
+            cache.shadowCasterBox_[i] = query.shadowCasterBox_[i];
+            cache.shadowViews_[i] = query.shadowCameras_[i]->GetView();
+            cache.shadowProjections_[i] = query.shadowCameras_[i]->GetProjection();
+        }
+        cache.octree_ = octree_;
+        cache.numSplits_ = query.numSplits_;
+        cache.lightMask_ = lightMask;
+        cache.viewMask_ = viewMask;
+        cache.structureVersion_ = octree_->GetStructureVersion();
+    }
+    else
+    {
+        query.shadowCasters_ = cache.shadowCasters_;
+        for (unsigned i = 0; i < query.numSplits_; ++i)
+        {
+            query.shadowCasterBegin_[i] = cache.shadowCasterBegin_[i];
+            query.shadowCasterEnd_[i] = cache.shadowCasterEnd_[i];
+            query.shadowCasterBox_[i] = cache.shadowCasterBox_[i];
+        }
+    }
+
+    cache.updateVersion_ = octree_->GetUpdateVersion();
+    cache.dirtySplits_ |= dirtySplits;
+    query.dirtyShadowSplits_ = cache.dirtySplits_ & allSplits;
+
+    // Prepare the casters of the splits that will be rendered. Drawables outside the view have not been updated yet
+    for (unsigned i = 0; i < query.numSplits_; ++i)
+    {
+        if (!(query.dirtyShadowSplits_ & (1u << i)))
+            continue;
+
+        for (unsigned j = query.shadowCasterBegin_[i]; j < query.shadowCasterEnd_[i]; ++j)
+        {
+            Drawable* drawable = query.shadowCasters_[j];
+            if (!drawable->IsInView(frame_, true))
+                drawable->UpdateBatches(frame_);
+        }
+    }
+
+    // If no shadow casters, the light can be rendered unshadowed. The shadow map is kept for when casters appear
+    if (query.shadowCasters_.Empty())
+        query.numSplits_ = 0;
+}
+
+unsigned View::GetStaticShadowSplits(const LightQueryResult& query, const LightBatchQueue& lightQueue)
+{
+    Light* light = query.light_;
+    StaticShadowCache& cache = light->GetStaticShadowCache();
+    const BiasParameters& bias = light->GetShadowBias();
+    unsigned numSplits = lightQueue.shadowSplits_.Size();
+    unsigned allSplits = (1u << numSplits) - 1;
+
+    // Depth bias, focusing and the shadow map viewports are only known now, so check them against the shadow map contents
+    if (bias.constantBias_ != cache.shadowBias_.constantBias_ || bias.slopeScaledBias_ != cache.shadowBias_.slopeScaledBias_)
+        cache.dirtySplits_ |= allSplits;
+    cache.shadowBias_ = bias;
+    for (unsigned i = 0; i < numSplits; ++i)
+    {
+        const ShadowBatchQueue& shadowQueue = lightQueue.shadowSplits_[i];
+        if (shadowQueue.shadowCamera_->GetZoom() != cache.shadowZooms_[i] || shadowQueue.shadowViewport_ != cache.shadowViewports_[i])
+            cache.dirtySplits_ |= 1u << i;
+        cache.shadowZooms_[i] = shadowQueue.shadowCamera_->GetZoom();
+        cache.shadowViewports_[i] = shadowQueue.shadowViewport_;
+    }
+
+    unsigned dirtySplits = cache.dirtySplits_ & allSplits;
+    // Variance shadow maps are blurred as a whole, so they can not be rendered partially
+    if (dirtySplits && renderer_->GetShadowQuality() >= SHADOWQUALITY_VSM)
+        dirtySplits = allSplits;
+
+    // Update the casters of splits that became dirty after the shadow casters were processed
+    for (unsigned i = 0; i < numSplits; ++i)
+    {
+        if (!(dirtySplits & ~query.dirtyShadowSplits_ & (1u << i)))
+            continue;
+
+        for (unsigned j = query.shadowCasterBegin_[i]; j < query.shadowCasterEnd_[i]; ++j)
+        {
+            Drawable* drawable = query.shadowCasters_[j];
+            if (!drawable->IsInView(frame_, true))
+                drawable->UpdateBatches(frame_);
+        }
+    }
+
+    return dirtySplits;
+}
+
 void View::ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawable*>& drawables, unsigned splitIndex)
 {
     Light* light = query.light_;
@@ -2471,6 +3161,19 @@ void View::ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawabl
     query.shadowCasterEnd_[splitIndex] = query.shadowCasters_.Size();
 }
 
+bool View::IsClusteredLight(const LightQueryResult& query) const
+{
+    // Only unshadowed point and spot lights using the default ramp and spot textures can be evaluated from the clusters.
+    // Negative lights need the subtractive blending of a separate pass
+    Light* light = query.light_;
+    if (!clustered_ || deferred_ || light->GetPerVertex() || light->GetLightType() == LIGHT_DIRECTIONAL || light->IsNegative())
+        return false;
+    if (query.numSplits_ > 0 || light->GetRampTexture() || light->GetShapeTexture())
+        return false;
+
+    return true;
+}
+
 bool View::IsShadowCasterVisible(Drawable* drawable, BoundingBox lightViewBox, Camera* shadowCamera, const Matrix3x4& lightView,
     const Frustum& lightViewFrustum, const BoundingBox& lightViewFrustumBox)
 {
@@ -2891,13 +3594,20 @@ void View::SetQueueShaderDefines(BatchQueue& queue, const RenderPathCommand& com
 {
     String vsDefines = command.vertexShaderDefines_.Trimmed();
     String psDefines = command.pixelShaderDefines_.Trimmed();
-    if (vsDefines.Length() || psDefines.Length())
+#ifndef GL_ES_VERSION_2_0
+    queue.clustered_ = command.type_ == CMD_SCENEPASS && command.clusteredLights_;
+#else
+    queue.clustered_ = false;
+#endif
+    if (vsDefines.Length() || psDefines.Length() || queue.clustered_)
     {
+        // The CLUSTERED define is added per pass when loading the shaders, but is included in the hashes so that the shaders
+        // are not shared with the queues of unclustered commands
         queue.hasExtraDefines_ = true;
         queue.vsExtraDefines_ = vsDefines;
         queue.psExtraDefines_ = psDefines;
-        queue.vsExtraDefinesHash_ = StringHash(vsDefines);
-        queue.psExtraDefinesHash_ = StringHash(psDefines);
+        queue.vsExtraDefinesHash_ = StringHash(queue.clustered_ ? vsDefines + " CLUSTERED" : vsDefines);
+        queue.psExtraDefinesHash_ = StringHash(queue.clustered_ ? psDefines + " CLUSTERED" : psDefines);
     }
     else
         queue.hasExtraDefines_ = false;
@@ -2908,12 +3618,19 @@ void View::AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, boo
     if (!batch.material_)
         batch.material_ = renderer_->GetDefaultMaterial();
 
-    // Convert to instanced if possible
-    if (allowInstancing && batch.geometryType_ == GEOM_STATIC && batch.geometry_->GetIndexBuffer())
-        batch.geometryType_ = GEOM_INSTANCED;
+    // Convert to instanced if possible. Skinned batches can be instanced if the skin matrices of at least two instances
+    // fit into the shader's bone array
+    if (allowInstancing && batch.geometry_->GetIndexBuffer())
+    {
+        if (batch.geometryType_ == GEOM_STATIC)
+            batch.geometryType_ = GEOM_INSTANCED;
+        else if (batch.geometryType_ == GEOM_SKINNED && batch.numWorldTransforms_ * 2 <= Graphics::GetMaxBones())
+            batch.geometryType_ = GEOM_SKINNED_INSTANCED;
+    }
 
-    if (batch.geometryType_ == GEOM_INSTANCED)
+    if (batch.geometryType_ == GEOM_INSTANCED || batch.geometryType_ == GEOM_SKINNED_INSTANCED)
     {
+        GeometryType instancedType = batch.geometryType_;
         BatchGroupKey key(batch);
 
         HashMap<BatchGroupKey, BatchGroup>::Iterator i = queue.batchGroups_.Find(key);
@@ -2922,7 +3639,7 @@ void View::AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, boo
             // Create a new group based on the batch
             // In case the group remains below the instancing limit, do not enable instancing shaders yet
             BatchGroup newGroup(batch);
-            newGroup.geometryType_ = GEOM_STATIC;
+            newGroup.geometryType_ = instancedType == GEOM_SKINNED_INSTANCED ? GEOM_SKINNED : GEOM_STATIC;
             renderer_->SetBatchShaders(newGroup, tech, allowShadows, queue);
             newGroup.CalculateSortKey();
             i = queue.batchGroups_.Insert(MakePair(key, newGroup));
@@ -2933,7 +3650,7 @@ void View::AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, boo
         // Convert to using instancing shaders when the instancing limit is reached
         if (oldSize < minInstances_ && (int)i->second_.instances_.Size() >= minInstances_)
         {
-            i->second_.geometryType_ = GEOM_INSTANCED;
+            i->second_.geometryType_ = instancedType;
             renderer_->SetBatchShaders(i->second_, tech, allowShadows, queue);
             i->second_.CalculateSortKey();
         }
@@ -2960,6 +3677,65 @@ void View::AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, boo
     }
 }
 
+void View::AddBatchToQueue(BatchQueue& queue, BatchQueue& finalQueue, Batch& batch, Technique* tech, PerThreadBatchResult* result,
+    bool allowInstancing, bool allowShadows)
+{
+    // Shaders can only be loaded in the main thread. If they are missing, defer the batch to be added to the final queue
+    // once the worker threads have finished
+    if (result && !renderer_->HasPassShaders(batch.pass_, finalQueue))
+    {
+        DeferredBatch deferred;
+        deferred.batch_ = batch;
+        deferred.technique_ = tech;
+        deferred.queue_ = &finalQueue;
+        deferred.allowInstancing_ = allowInstancing;
+        deferred.allowShadows_ = allowShadows;
+        result->deferredBatches_.Push(deferred);
+        return;
+    }
+
+    AddBatchToQueue(queue, batch, tech, allowInstancing, allowShadows);
+}
+
+void View::MergeBatchQueue(BatchQueue& queue, BatchQueue& threadQueue)
+{
+    queue.batches_.Push(threadQueue.batches_);
+
+    for (HashMap<BatchGroupKey, BatchGroup>::ConstIterator i = threadQueue.batchGroups_.Begin();
+         i != threadQueue.batchGroups_.End(); ++i)
+    {
+        HashMap<BatchGroupKey, BatchGroup>::Iterator j = queue.batchGroups_.Find(i->first_);
+        if (j == queue.batchGroups_.End())
+        {
+            queue.batchGroups_.Insert(i);
+            continue;
+        }
+
+        BatchGroup& group = j->second_;
+        int oldSize = group.instances_.Size();
+        group.instances_.Push(i->second_.instances_);
+
+        // Convert to using instancing shaders when the combined instance count reaches the instancing limit. If the thread's
+        // group was already converted, its shaders can be used as is
+        if (oldSize < minInstances_ && (int)group.instances_.Size() >= minInstances_)
+        {
+            GeometryType instancedType = group.geometryType_ == GEOM_SKINNED ? GEOM_SKINNED_INSTANCED : GEOM_INSTANCED;
+            if (i->second_.geometryType_ == instancedType)
+            {
+                group.geometryType_ = instancedType;
+                group.vertexShader_ = i->second_.vertexShader_;
+                group.pixelShader_ = i->second_.pixelShader_;
+            }
+            else
+            {
+                group.geometryType_ = instancedType;
+                renderer_->SetBatchShaders(group, GetPassTechnique(group.material_, group.pass_), true, queue);
+            }
+            group.CalculateSortKey();
+        }
+    }
+}
+
 void View::PrepareInstancingBuffer()
 {
     // Prepare instancing buffer from the source view
@@ -3016,12 +3792,12 @@ void View::SetupLightVolumeBatch(Batch& batch)
     Vector3 cameraPos = camera_->GetNode()->GetWorldPosition();
     float lightDist;
 
-    graphics_->SetBlendMode(light->IsNegative() ? BLEND_SUBTRACT : BLEND_ADD);
-    graphics_->SetDepthBias(0.0f, 0.0f);
-    graphics_->SetDepthWrite(false);
-    graphics_->SetFillMode(FILL_SOLID);
-    graphics_->SetLineAntiAlias(false);
-    graphics_->SetClipPlane(false);
+    commandList_->SetBlendMode(light->IsNegative() ? BLEND_SUBTRACT : BLEND_ADD);
+    commandList_->SetDepthBias(0.0f, 0.0f);
+    commandList_->SetDepthWrite(false);
+    commandList_->SetFillMode(FILL_SOLID);
+    commandList_->SetLineAntiAlias(false);
+    commandList_->SetClipPlane(false);
 
     if (type != LIGHT_DIRECTIONAL)
     {
@@ -3034,12 +3810,12 @@ void View::SetupLightVolumeBatch(Batch& batch)
         if (lightDist < camera_->GetNearClip() * 2.0f)
         {
             renderer_->SetCullMode(CULL_CW, camera_);
-            graphics_->SetDepthTest(CMP_GREATER);
+            commandList_->SetDepthTest(CMP_GREATER);
         }
         else
         {
             renderer_->SetCullMode(CULL_CCW, camera_);
-            graphics_->SetDepthTest(CMP_LESSEQUAL);
+            commandList_->SetDepthTest(CMP_LESSEQUAL);
         }
     }
     else
@@ -3047,21 +3823,21 @@ void View::SetupLightVolumeBatch(Batch& batch)
         // In case the same camera is used for multiple views with differing aspect ratios (not recommended)
         // refresh the directional light's model transform before rendering
         light->GetVolumeTransform(camera_);
-        graphics_->SetCullMode(CULL_NONE);
-        graphics_->SetDepthTest(CMP_ALWAYS);
+        commandList_->SetCullMode(CULL_NONE);
+        commandList_->SetDepthTest(CMP_ALWAYS);
     }
 
-    graphics_->SetScissorTest(false);
+    commandList_->SetScissorTest(false);
     if (!noStencil_)
-        graphics_->SetStencilTest(true, CMP_NOTEQUAL, OP_KEEP, OP_KEEP, OP_KEEP, 0, light->GetLightMask());
+        commandList_->SetStencilTest(true, CMP_NOTEQUAL, OP_KEEP, OP_KEEP, OP_KEEP, 0, light->GetLightMask());
     else
-        graphics_->SetStencilTest(false);
+        commandList_->SetStencilTest(false);
 }
 
 bool View::NeedRenderShadowMap(const LightBatchQueue& queue)
 {
-    // Must have a shadow map, and either forward or deferred lit batches
-    return queue.shadowMap_ && (!queue.litBatches_.IsEmpty() || !queue.litBaseBatches_.IsEmpty() ||
+    // Must have a shadow map with splits to render, and either forward or deferred lit batches
+    return queue.shadowMap_ && queue.dirtyShadowSplits_ && (!queue.litBatches_.IsEmpty() || !queue.litBaseBatches_.IsEmpty() ||
         !queue.volumeBatches_.Empty());
 }
 
@@ -3070,38 +3846,50 @@ void View::RenderShadowMap(const LightBatchQueue& queue)
     URHO3D_PROFILE(RenderShadowMap);
 
     Texture2D* shadowMap = queue.shadowMap_;
-    graphics_->SetTexture(TU_SHADOWMAP, 0);
+    commandList_->SetTexture(TU_SHADOWMAP, 0);
 
-    graphics_->SetFillMode(FILL_SOLID);
-    graphics_->SetClipPlane(false);
-    graphics_->SetStencilTest(false);
+    commandList_->SetFillMode(FILL_SOLID);
+    commandList_->SetClipPlane(false);
+    commandList_->SetStencilTest(false);
 
     // Set shadow depth bias
     BiasParameters parameters = queue.light_->GetShadowBias();
 
+    // Static shadow maps may only need some of the splits rendered again. In that case clear just their viewports
+    unsigned allSplits = (1u << queue.shadowSplits_.Size()) - 1;
+    bool clearAll = (queue.dirtyShadowSplits_ & allSplits) == allSplits;
+    unsigned clearFlags = CLEAR_DEPTH;
+
     // The shadow map is a depth stencil texture
     if (shadowMap->GetUsage() == TEXTURE_DEPTHSTENCIL)
     {
-        graphics_->SetColorWrite(false);
-        graphics_->SetDepthStencil(shadowMap);
-        graphics_->SetRenderTarget(0, shadowMap->GetRenderSurface()->GetLinkedRenderTarget());
+        commandList_->SetColorWrite(false);
+        commandList_->SetDepthStencil(shadowMap);
+        commandList_->SetRenderTarget(0, shadowMap->GetRenderSurface()->GetLinkedRenderTarget());
         // Disable other render targets
         for (unsigned i = 1; i < MAX_RENDERTARGETS; ++i)
-            graphics_->SetRenderTarget(i, (RenderSurface*) 0);
-        graphics_->SetViewport(IntRect(0, 0, shadowMap->GetWidth(), shadowMap->GetHeight()));
-        graphics_->Clear(CLEAR_DEPTH);
+            commandList_->SetRenderTarget(i, (RenderSurface*) 0);
+        if (clearAll)
+        {
+            commandList_->SetViewport(IntRect(0, 0, shadowMap->GetWidth(), shadowMap->GetHeight()));
+            commandList_->Clear(CLEAR_DEPTH);
+        }
     }
     else // if the shadow map is a color rendertarget
     {
-        graphics_->SetColorWrite(true);
-        graphics_->SetRenderTarget(0, shadowMap);
+        commandList_->SetColorWrite(true);
+        commandList_->SetRenderTarget(0, shadowMap);
         // Disable other render targets
         for (unsigned i = 1; i < MAX_RENDERTARGETS; ++i)
-            graphics_->SetRenderTarget(i, (RenderSurface*) 0);
-        graphics_->SetDepthStencil(renderer_->GetDepthStencil(shadowMap->GetWidth(), shadowMap->GetHeight(),
+            commandList_->SetRenderTarget(i, (RenderSurface*) 0);
+        commandList_->SetDepthStencil(renderer_->GetDepthStencil(shadowMap->GetWidth(), shadowMap->GetHeight(),
             shadowMap->GetMultiSample(), shadowMap->GetAutoResolve()));
-        graphics_->SetViewport(IntRect(0, 0, shadowMap->GetWidth(), shadowMap->GetHeight()));
-        graphics_->Clear(CLEAR_DEPTH | CLEAR_COLOR, Color::WHITE);
+        clearFlags = CLEAR_DEPTH | CLEAR_COLOR;
+        if (clearAll)
+        {
+            commandList_->SetViewport(IntRect(0, 0, shadowMap->GetWidth(), shadowMap->GetHeight()));
+            commandList_->Clear(clearFlags, Color::WHITE);
+        }
 
         parameters = BiasParameters(0.0f, 0.0f);
     }
@@ -3109,7 +3897,15 @@ void View::RenderShadowMap(const LightBatchQueue& queue)
     // Render each of the splits
     for (unsigned i = 0; i < queue.shadowSplits_.Size(); ++i)
     {
+        if (!(queue.dirtyShadowSplits_ & (1u << i)))
+            continue;
+
         const ShadowBatchQueue& shadowQueue = queue.shadowSplits_[i];
+        if (!clearAll)
+        {
+            commandList_->SetViewport(shadowQueue.shadowViewport_);
+            commandList_->Clear(clearFlags, Color::WHITE);
+        }
 
         float multiplier = 1.0f;
         // For directional light cascade splits, adjust depth bias according to the far clip ratio of the splits
@@ -3129,11 +3925,11 @@ void View::RenderShadowMap(const LightBatchQueue& queue)
         addition = renderer_->GetMobileShadowBiasAdd();
 #endif
 
-        graphics_->SetDepthBias(multiplier * parameters.constantBias_ + addition, multiplier * parameters.slopeScaledBias_);
+        commandList_->SetDepthBias(multiplier * parameters.constantBias_ + addition, multiplier * parameters.slopeScaledBias_);
 
         if (!shadowQueue.shadowBatches_.IsEmpty())
         {
-            graphics_->SetViewport(shadowQueue.shadowViewport_);
+            commandList_->SetViewport(shadowQueue.shadowViewport_);
             shadowQueue.shadowBatches_.Draw(this, shadowQueue.shadowCamera_, false, false, true);
         }
     }
@@ -3143,8 +3939,13 @@ void View::RenderShadowMap(const LightBatchQueue& queue)
     renderer_->ApplyShadowMapFilter(this, shadowMap, blurScale);
 
     // reset some parameters
-    graphics_->SetColorWrite(true);
-    graphics_->SetDepthBias(0.0f, 0.0f);
+    commandList_->SetColorWrite(true);
+    commandList_->SetDepthBias(0.0f, 0.0f);
+
+    // The rendered splits of a static shadow map stay valid until their shadow casters change
+    StaticShadowCache& cache = queue.light_->GetStaticShadowCache();
+    if (shadowMap == cache.shadowMap_)
+        cache.dirtySplits_ &= ~queue.dirtyShadowSplits_;
 }
 
 RenderSurface* View::GetDepthStencil(RenderSurface* renderTarget)
@@ -3186,7 +3987,11 @@ void View::SendViewEvent(StringHash eventType)
     eventData[P_SCENE] = scene_;
     eventData[P_CAMERA] = cullCamera_;
 
+    // Handlers of the render events may render directly, so the commands recorded so far must be replayed first
+    bool suspended = commandList_ && commandList_->SuspendForEvent(renderer_, eventType);
     renderer_->SendEvent(eventType, eventData);
+    if (suspended)
+        commandList_->BeginRecording();
 }
 
 Texture* View::FindNamedTexture(const String& name, bool isRenderTarget, bool isVolumeMap)
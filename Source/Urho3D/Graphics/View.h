@@ -36,11 +36,13 @@ namespace Urho3D
 class Camera;
 class DebugRenderer;
 class Light;
+class LightClusters;
 class Drawable;
 class Graphics;
 class OcclusionBuffer;
 class Octree;
 class Renderer;
+class RenderCommandList;
 class RenderPath;
 class RenderSurface;
 class Technique;
@@ -51,6 +53,14 @@ class Zone;
 struct RenderPathCommand;
 struct WorkItem;
 
+/// Result of checking the visibility cache of a view.
+enum VisibilityCacheResult
+{
+    VCR_MISS = 0,
+    VCR_PARTIAL,
+    VCR_HIT
+};
+
 /// Intermediate light processing result.
 struct LightQueryResult
 {
@@ -74,6 +84,12 @@ struct LightQueryResult
     float shadowFarSplits_[MAX_LIGHT_SPLITS];
     /// Shadow map split count.
     unsigned numSplits_;
+    /// Static shadow map flag.
+    bool staticShadows_;
+    /// Clustered light flag. Clustered lights are binned to the view's light clusters instead of having a light queue.
+    bool clustered_;
+    /// Bitmask of static shadow map splits whose shadow casters have been prepared for rendering.
+    unsigned dirtyShadowSplits_;
 };
 
 /// Scene render pass info.
@@ -98,12 +114,85 @@ struct PerThreadSceneResult
     PODVector<Drawable*> geometries_;
     /// Lights.
     PODVector<Light*> lights_;
+    /// Geometries and lights that passed the occlusion test, collected for the visibility cache.
+    PODVector<Drawable*> unoccluded_;
     /// Scene minimum Z value.
     float minZ_;
     /// Scene maximum Z value.
     float maxZ_;
 };
 
+/// Octree query results of a view kept between frames. Reused while the culling camera and the octree stay unchanged.
+struct ViewVisibilityCache
+{
+    /// Construct.
+    ViewVisibilityCache() :
+        viewMask_(0),
+        maxOccluderTriangles_(0),
+        structureVersion_(0),
+        updateVersion_(0),
+        valid_(false)
+    {
+    }
+
+    /// Octree the results were queried from.
+    WeakPtr<Octree> octree_;
+    /// Culling frustum.
+    Frustum frustum_;
+    /// Culling camera view mask.
+    unsigned viewMask_;
+    /// Maximum number of occluder triangles.
+    int maxOccluderTriangles_;
+    /// Octree structure version.
+    unsigned structureVersion_;
+    /// Octree update version.
+    unsigned updateVersion_;
+    /// Zones and occluders inside the frustum.
+    PODVector<Drawable*> zonesAndOccluders_;
+    /// Geometries and lights inside the frustum that passed the occlusion test.
+    PODVector<Drawable*> drawables_;
+    /// Drawables moved since the results were stored. Used during a partial cache hit.
+    HashSet<Drawable*> movedDrawables_;
+    /// Valid flag.
+    bool valid_;
+};
+
+/// Batch that a worker thread could not queue, because the shaders of its pass were not loaded yet.
+struct DeferredBatch
+{
+    /// Batch.
+    Batch batch_;
+    /// Technique of the batch.
+    Technique* technique_;
+    /// Destination queue.
+    BatchQueue* queue_;
+    /// Allow instancing flag.
+    bool allowInstancing_;
+    /// Allow shadows flag.
+    bool allowShadows_;
+};
+
+/// Per-thread batch collection structure.
+struct PerThreadBatchResult
+{
+    /// Base batches for each scene pass.
+    Vector<BatchQueue> scenePassQueues_;
+    /// Lit alpha batches.
+    BatchQueue alphaQueue_;
+    /// Geometry objects that will be updated in the main thread.
+    PODVector<Drawable*> nonThreadedGeometries_;
+    /// Geometry objects that will be updated in worker threads.
+    PODVector<Drawable*> threadedGeometries_;
+    /// Shadow casters that may be outside the view frustum.
+    PODVector<Drawable*> shadowCasters_;
+    /// Drawables whose base batches are generated in the main thread.
+    PODVector<Drawable*> deferredDrawables_;
+    /// Materials to check for auxiliary views.
+    PODVector<Material*> auxViewMaterials_;
+    /// Batches to queue in the main thread.
+    PODVector<DeferredBatch> deferredBatches_;
+};
+
 static const unsigned MAX_VIEWPORT_TEXTURES = 2;
 
 /// Internal structure for 3D rendering work. Created for each backbuffer and texture viewport, but not for shadow cameras.
@@ -111,6 +200,8 @@ class URHO3D_API View : public Object
 {
     friend void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex);
     friend void ProcessLightWork(const WorkItem* item, unsigned threadIndex);
+    friend void GetLightBatchesWork(const WorkItem* item, unsigned threadIndex);
+    friend void GetBaseBatchesWork(const WorkItem* item, unsigned threadIndex);
 
     URHO3D_OBJECT(View, Object);
 
@@ -131,6 +222,8 @@ public:
     Graphics* GetGraphics() const;
     /// Return renderer subsystem.
     Renderer* GetRenderer() const;
+    /// Return the command list to render through. Valid during Render().
+    RenderCommandList* GetCommandList() const;
 
     /// Return scene.
     Scene* GetScene() const { return scene_; }
@@ -171,12 +264,24 @@ public:
     /// Return light batch queues.
     const Vector<LightBatchQueue>& GetLightQueues() const { return lightQueues_; }
 
+    /// Return light clusters if the renderpath uses clustered forward lighting, or null otherwise.
+    LightClusters* GetLightClusters() const { return clustered_ ? lightClusters_.Get() : 0; }
+
+    /// Return lights binned to the light clusters.
+    const PODVector<Light*>& GetClusteredLights() const { return clusteredLights_; }
+
     /// Return the last used software occlusion buffer.
     OcclusionBuffer* GetOcclusionBuffer() const { return occlusionBuffer_; }
 
     /// Return number of occluders that were actually rendered. Occluders may be rejected if running out of triangles or if behind other occluders.
     unsigned GetNumActiveOccluders() const { return activeOccluders_; }
 
+    /// Return number of drawables whose visibility was reused from the previous frame.
+    unsigned GetNumVisibilityCacheHits() const { return visibilityCacheHits_; }
+
+    /// Return number of drawables whose visibility had to be tested.
+    unsigned GetNumVisibilityCacheMisses() const { return visibilityCacheMisses_; }
+
     /// Return the source view that was already prepared. Used when viewports specify the same culling camera.
     View* GetSourceView() const;
 
@@ -198,6 +303,10 @@ public:
 private:
     /// Query the octree for drawable objects.
     void GetDrawables();
+    /// Check how much of the previous frame's octree query results can be reused and store the new cache key.
+    VisibilityCacheResult CheckVisibilityCache();
+    /// Remove the drawables moved since the previous frame from a cached result list.
+    void RemoveMovedDrawables(PODVector<Drawable*>& drawables);
     /// Construct batches from the drawable objects.
     void GetBatches();
     /// Get lit geometries and shadowcasters for visible lights.
@@ -206,10 +315,14 @@ private:
     void GetLightBatches();
     /// Get unlit batches.
     void GetBaseBatches();
+    /// Get shadow caster and pixel lit batches for a certain light. Called from a worker thread if per-thread result is given.
+    void GetLightBatches(LightQueryResult& query, PerThreadBatchResult* result);
+    /// Get unlit batches for a certain drawable. Called from a worker thread if per-thread result is given.
+    void GetBaseBatches(Drawable* drawable, PerThreadBatchResult* result);
     /// Update geometries and sort batches.
     void UpdateGeometries();
-    /// Get pixel lit batches for a certain light and drawable.
-    void GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQueue* alphaQueue);
+    /// Get pixel lit batches for a certain light and drawable. Called from a worker thread if per-thread result is given.
+    void GetLitBatches(Drawable* drawable, LightBatchQueue& lightQueue, BatchQueue* alphaQueue, PerThreadBatchResult* result = 0);
     /// Execute render commands.
     void ExecuteRenderPathCommands();
     /// Set rendertargets for current render command.
@@ -236,6 +349,10 @@ private:
     void DrawOccluders(OcclusionBuffer* buffer, const PODVector<Drawable*>& occluders);
     /// Query for lit geometries and shadow casters for a light.
     void ProcessLight(LightQueryResult& query, unsigned threadIndex);
+    /// Collect shadow casters of a light with static shadows, reusing the cached casters if nothing changed within the light volume.
+    void ProcessStaticShadowCasters(LightQueryResult& query, const PODVector<Drawable*>& drawables);
+    /// Return the static shadow map splits to render after the shadow cameras have been finalized.
+    unsigned GetStaticShadowSplits(const LightQueryResult& query, const LightBatchQueue& lightQueue);
     /// Process shadow casters' visibilities and build their combined view- or projection-space bounding box.
     void ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawable*>& drawables, unsigned splitIndex);
     /// Set up initial shadow camera view(s).
@@ -248,6 +365,8 @@ private:
     /// Quantize a directional light shadow camera view to eliminate swimming.
     void
         QuantizeDirLightShadowCamera(Camera* shadowCamera, Light* light, const IntRect& shadowViewport, const BoundingBox& viewBox);
+    /// Return whether a light should be binned to the light clusters instead of rendering it in its own passes.
+    bool IsClusteredLight(const LightQueryResult& query) const;
     /// Check visibility of one shadow caster.
     bool IsShadowCasterVisible(Drawable* drawable, BoundingBox lightViewBox, Camera* shadowCamera, const Matrix3x4& lightView,
         const Frustum& lightViewFrustum, const BoundingBox& lightViewFrustumBox);
@@ -263,6 +382,11 @@ private:
     void SetQueueShaderDefines(BatchQueue& queue, const RenderPathCommand& command);
     /// Choose shaders for a batch and add it to queue.
     void AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, bool allowInstancing = true, bool allowShadows = true);
+    /// Choose shaders for a batch and add it to a queue owned by the current thread. In a worker thread, defer the batch to the final queue if its shaders are not loaded yet.
+    void AddBatchToQueue(BatchQueue& queue, BatchQueue& finalQueue, Batch& batch, Technique* tech, PerThreadBatchResult* result,
+        bool allowInstancing = true, bool allowShadows = true);
+    /// Merge batches and instance groups collected by a worker thread into a batch queue.
+    void MergeBatchQueue(BatchQueue& queue, BatchQueue& threadQueue);
     /// Prepare instancing buffer by filling it with all instance transforms.
     void PrepareInstancingBuffer();
     /// Set up a light volume rendering batch.
@@ -312,6 +436,8 @@ private:
     WeakPtr<Graphics> graphics_;
     /// Renderer subsystem.
     WeakPtr<Renderer> renderer_;
+    /// Command list to render through.
+    RenderCommandList* commandList_;
     /// Scene to use.
     Scene* scene_;
     /// Octree to use.
@@ -376,6 +502,12 @@ private:
     bool deferredAmbient_;
     /// Forward light base pass optimization flag. If in use, combine the base pass and first light for all opaque objects.
     bool useLitBase_;
+    /// Clustered forward lighting flag. Inferred from scene passes that use clustered lights in a forward renderpath.
+    bool clustered_;
+    /// Base pass applies clustered lights flag.
+    bool clusteredBasePass_;
+    /// Alpha pass applies clustered lights flag.
+    bool clusteredAlphaPass_;
     /// Has scene passes flag. If no scene passes, view can be defined without a valid scene or camera to only perform quad rendering.
     bool hasScenePasses_;
     /// Whether is using a custom readable depth texture without a stencil channel.
@@ -388,6 +520,8 @@ private:
     Vector<PODVector<Drawable*> > tempDrawables_;
     /// Per-thread geometries, lights and Z range collection results.
     Vector<PerThreadSceneResult> sceneResults_;
+    /// Per-thread batch collection results.
+    Vector<PerThreadBatchResult> batchResults_;
     /// Visible zones.
     PODVector<Zone*> zones_;
     /// Visible geometry objects.
@@ -402,6 +536,14 @@ private:
     PODVector<Light*> lights_;
     /// Number of active occluders.
     unsigned activeOccluders_;
+    /// Number of drawables whose visibility was reused from the previous frame.
+    unsigned visibilityCacheHits_;
+    /// Number of drawables whose visibility was tested.
+    unsigned visibilityCacheMisses_;
+    /// Whether the drawables to process have already passed the occlusion test.
+    bool skipOcclusionTest_;
+    /// Octree query results kept between frames.
+    ViewVisibilityCache visibilityCache_;
 
     /// Drawables that limit their maximum light count.
     HashSet<Drawable*> maxLightsDrawables_;
@@ -413,6 +555,10 @@ private:
     PODVector<ScenePassInfo> scenePasses_;
     /// Per-pixel light queues.
     Vector<LightBatchQueue> lightQueues_;
+    /// Light clusters for clustered forward lighting.
+    SharedPtr<LightClusters> lightClusters_;
+    /// Lights binned to the light clusters.
+    PODVector<Light*> clusteredLights_;
     /// Per-vertex light queues.
     HashMap<unsigned long long, LightBatchQueue> vertexLightQueues_;
     /// Batch queues by pass index.
@@ -95,6 +95,7 @@ void Zone::RegisterObject(Context* context)
 void Zone::OnSetAttribute(const AttributeInfo& attr, const Variant& src)
 {
     Serializable::OnSetAttribute(attr, src);
+    ResetShaderParameterBlocks();
 
     // If bounding box or priority changes, dirty the drawable as applicable
     if ((attr.offset_ >= offsetof(Zone, boundingBox_) && attr.offset_ < (offsetof(Zone, boundingBox_) + sizeof(BoundingBox))) ||
@@ -111,6 +112,7 @@ void Zone::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
 void Zone::SetBoundingBox(const BoundingBox& box)
 {
     boundingBox_ = box;
+    ResetShaderParameterBlocks();
     OnMarkedDirty(node_);
     MarkNetworkUpdate();
 }
@@ -118,12 +120,14 @@ void Zone::SetBoundingBox(const BoundingBox& box)
 void Zone::SetAmbientColor(const Color& color)
 {
     ambientColor_ = color;
+    ResetShaderParameterBlocks();
     MarkNetworkUpdate();
 }
 
 void Zone::SetFogColor(const Color& color)
 {
     fogColor_ = color;
+    ResetShaderParameterBlocks();
     MarkNetworkUpdate();
 }
 
@@ -184,6 +188,7 @@ void Zone::SetOverride(bool enable)
 void Zone::SetAmbientGradient(bool enable)
 {
     ambientGradient_ = enable;
+    ResetShaderParameterBlocks();
     MarkNetworkUpdate();
 }
 
@@ -220,6 +225,34 @@ const Color& Zone::GetAmbientEndColor()
     return ambientEndColor_;
 }
 
+ShaderParameterBlock* Zone::GetShaderParameterBlock(bool blackFog)
+{
+    // Rebuild also if the ambient gradient needs to be recalculated due to a neighbor zone change
+    if (ambientGradient_ && (!lastAmbientStartZone_ || !lastAmbientEndZone_))
+        ResetShaderParameterBlocks();
+
+    SharedPtr<ShaderParameterBlock>& block = shaderParameterBlocks_[blackFog ? 1 : 0];
+    if (!block)
+    {
+        block = new ShaderParameterBlock();
+        block->AddParameter(VSP_AMBIENTSTARTCOLOR, GetAmbientStartColor());
+        block->AddParameter(VSP_AMBIENTENDCOLOR, GetAmbientEndColor().ToVector4() - GetAmbientStartColor().ToVector4());
+
+        Vector3 boxSize = boundingBox_.Size();
+        Matrix3x4 adjust(Matrix3x4::IDENTITY);
+        adjust.SetScale(Vector3(1.0f / boxSize.x_, 1.0f / boxSize.y_, 1.0f / boxSize.z_));
+        adjust.SetTranslation(Vector3(0.5f, 0.5f, 0.5f));
+        block->AddParameter(VSP_ZONE, adjust * GetInverseWorldTransform());
+
+        block->AddParameter(PSP_AMBIENTCOLOR, ambientColor_);
+        block->AddParameter(PSP_FOGCOLOR, blackFog ? Color::BLACK : fogColor_);
+        block->AddParameter(PSP_ZONEMIN, boundingBox_.min_);
+        block->AddParameter(PSP_ZONEMAX, boundingBox_.max_);
+    }
+
+    return block;
+}
+
 bool Zone::IsInside(const Vector3& point) const
 {
     // Use an oriented bounding box test
@@ -254,6 +287,7 @@ void Zone::OnMarkedDirty(Node* node)
     ClearDrawablesZone();
 
     inverseWorldDirty_ = true;
+    ResetShaderParameterBlocks();
 }
 
 void Zone::OnWorldBoundingBoxUpdate()
@@ -362,4 +396,11 @@ void Zone::ClearDrawablesZone()
     lastAmbientEndZone_.Reset();
 }
 
+void Zone::ResetShaderParameterBlocks()
+{
+    // Blocks already used for rendering may still be referenced, so build new ones instead of modifying them
+    shaderParameterBlocks_[0].Reset();
+    shaderParameterBlocks_[1].Reset();
+}
+
 }
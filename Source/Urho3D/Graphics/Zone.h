@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../Graphics/Drawable.h"
+#include "../Graphics/ShaderParameterBlock.h"
 #include "../Graphics/Texture.h"
 #include "../Math/Color.h"
 
@@ -113,6 +114,9 @@ public:
     /// Return zone texture.
     Texture* GetZoneTexture() const { return zoneTexture_; }
 
+    /// Return the camera-independent zone shader parameters baked into a block for rendering. Optionally with black fog color for additive passes. Not safe to call from worker threads due to possible octree query.
+    ShaderParameterBlock* GetShaderParameterBlock(bool blackFog = false);
+
     /// Check whether a point is inside.
     bool IsInside(const Vector3& point) const;
     /// Set zone texture attribute.
@@ -131,7 +135,11 @@ protected:
     void UpdateAmbientGradient();
     /// Clear zone reference from drawables inside the bounding box.
     void ClearDrawablesZone();
+    /// Release the baked shader parameter blocks so that they are rebuilt on next use.
+    void ResetShaderParameterBlocks();
 
+    /// Zone shader parameters baked for rendering, with own and black fog color. Null when needs rebuild.
+    SharedPtr<ShaderParameterBlock> shaderParameterBlocks_[2];
     /// Cached inverse world transform matrix.
     mutable Matrix3x4 inverseWorld_;
     /// Inverse transform dirty flag.
@@ -24,6 +24,7 @@
 #include "../IK/IKConstraint.h"
 #include "../IK/IKEffector.h"
 #include "../IK/IKSolver.h"
+#include "../IK/IKSolverManager.h"
 
 namespace Urho3D
 {
@@ -36,6 +37,7 @@ void RegisterIKLibrary(Context* context)
     //IKConstraint::RegisterObject(context);
     IKEffector::RegisterObject(context);
     IKSolver::RegisterObject(context);
+    IKSolverManager::RegisterObject(context);
 }
 
 } // namespace Urho3D
@@ -248,6 +248,10 @@ void IKEffector::UpdateTargetNodePosition()
 {
     if (targetNode_ == NULL)
     {
+        // Searching the scene is slow, so don't do it when only a target position is used
+        if (targetName_.Empty())
+            return;
+
         SetTargetNode(node_->GetScene()->GetChild(targetName_, true));
         if (targetNode_ == NULL)
             return;
@@ -25,6 +25,7 @@
 #include "../IK/IKEvents.h"
 #include "../IK/IKEffector.h"
 #include "../IK/IKConverters.h"
+#include "../IK/IKSolverManager.h"
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
@@ -32,8 +33,10 @@
 #include "../Graphics/AnimationState.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../IO/Log.h"
+#include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 
+#include <ik/chain_tree.h>
 #include <ik/effector.h>
 #include <ik/node.h>
 #include <ik/solver.h>
@@ -47,6 +50,7 @@ extern const char* IK_CATEGORY;
 // ----------------------------------------------------------------------------
 IKSolver::IKSolver(Context* context) :
     Component(context),
+    numPoseBaseNodes_(0),
     solver_(NULL),
     algorithm_(FABRIK),
     features_(JOINT_ROTATIONS | UPDATE_ACTIVE_POSE | AUTO_SOLVE),
@@ -57,11 +61,6 @@ IKSolver::IKSolver(Context* context) :
     context_->RequireIK();
 
     SetAlgorithm(FABRIK);
-
-    SubscribeToEvent(E_COMPONENTADDED,   URHO3D_HANDLER(IKSolver, HandleComponentAdded));
-    SubscribeToEvent(E_COMPONENTREMOVED, URHO3D_HANDLER(IKSolver, HandleComponentRemoved));
-    SubscribeToEvent(E_NODEADDED,        URHO3D_HANDLER(IKSolver, HandleNodeAdded));
-    SubscribeToEvent(E_NODEREMOVED,      URHO3D_HANDLER(IKSolver, HandleNodeRemoved));
 }
 
 // ----------------------------------------------------------------------------
@@ -72,6 +71,9 @@ IKSolver::~IKSolver()
     for (PODVector<IKEffector*>::ConstIterator it = effectorList_.Begin(); it != effectorList_.End(); ++it)
         (*it)->SetIKEffectorNode(NULL);
 
+    if (manager_ != NULL)
+        manager_->RemoveSolver(this);
+
     ik_solver_destroy(solver_);
     context_->ReleaseIK();
 }
@@ -177,17 +179,8 @@ void IKSolver::SetFeature(Feature feature, bool enable)
                 solver_->flags |= SOLVER_ENABLE_CONSTRAINTS;
         } break;
 
+        // Auto solving is done by the solver manager
         case AUTO_SOLVE:
-        {
-            if (((features_ & AUTO_SOLVE) != 0) == enable)
-                break;
-
-            if (enable)
-                SubscribeToEvent(GetScene(), E_SCENEDRAWABLEUPDATEFINISHED, URHO3D_HANDLER(IKSolver, HandleSceneDrawableUpdateFinished));
-            else
-                UnsubscribeFromEvent(GetScene(), E_SCENEDRAWABLEUPDATEFINISHED);
-        } break;
-
         case UPDATE_ORIGINAL_POSE:
         case UPDATE_ACTIVE_POSE:
         case USE_ORIGINAL_POSE:
@@ -279,6 +272,8 @@ void IKSolver::DestroyTree()
     ik_solver_destroy_tree(solver_);
     effectorList_.Clear();
     constraintList_.Clear();
+    poseNodes_.Clear();
+    numPoseBaseNodes_ = 0;
 }
 
 // ----------------------------------------------------------------------------
@@ -392,6 +387,7 @@ void IKSolver::RebuildChainTrees()
 {
     solverTreeValid_ = (ik_solver_rebuild_chain_trees(solver_) == 0);
     ik_calculate_rotation_weight_decays(&solver_->chain_tree);
+    CollectPoseNodes();
 
     chainTreesNeedUpdating_ = false;
 }
@@ -413,6 +409,16 @@ void IKSolver::Solve()
 {
     URHO3D_PROFILE(IKSolve);
 
+    if (PrepareSolve() == false)
+        return;
+
+    SolveToPoseBuffer();
+    ApplyPoseBufferToScene();
+}
+
+// ----------------------------------------------------------------------------
+bool IKSolver::PrepareSolve()
+{
     if (treeNeedsRebuild)
         RebuildTree();
 
@@ -420,7 +426,7 @@ void IKSolver::Solve()
         RebuildChainTrees();
 
     if (IsSolverTreeValid() == false)
-        return;
+        return false;
 
     if (features_ & UPDATE_ORIGINAL_POSE)
         ApplySceneToOriginalPose();
@@ -436,9 +442,77 @@ void IKSolver::Solve()
         (*it)->UpdateTargetNodePosition();
     }
 
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+void IKSolver::SolveToPoseBuffer()
+{
     ik_solver_solve(solver_);
+    StoreActivePose();
+}
+
+// ----------------------------------------------------------------------------
+static void CollectChainTreeNodes(chain_t* chain, PODVector<ik_node_t*>& dest)
+{
+    // Same order as ik_solver_iterate_chain_tree(): parents before children, excluding the base node of each chain
+    int idx = ordered_vector_count(&chain->nodes) - 1;
+    while (idx--)
+        dest.Push(*(ik_node_t**)ordered_vector_get_element(&chain->nodes, idx));
 
-    ApplyActivePoseToScene();
+    ORDERED_VECTOR_FOR_EACH(&chain->children, chain_t, child)
+        CollectChainTreeNodes(child, dest);
+    ORDERED_VECTOR_END_EACH
+}
+void IKSolver::CollectPoseNodes()
+{
+    poseNodes_.Clear();
+    numPoseBaseNodes_ = 0;
+
+    if (IsSolverTreeValid() == false)
+        return;
+
+    PODVector<ik_node_t*> ikNodes;
+    ORDERED_VECTOR_FOR_EACH(&solver_->chain_tree.islands, chain_island_t, island)
+        ikNodes.Push(*(ik_node_t**)ordered_vector_get_element(&island->base_chain.nodes,
+            ordered_vector_count(&island->base_chain.nodes) - 1));
+    ORDERED_VECTOR_END_EACH
+    numPoseBaseNodes_ = ikNodes.Size();
+
+    ORDERED_VECTOR_FOR_EACH(&solver_->chain_tree.islands, chain_island_t, island)
+        CollectChainTreeNodes(&island->base_chain, ikNodes);
+    ORDERED_VECTOR_END_EACH
+
+    poseNodes_.Resize(ikNodes.Size());
+    for (unsigned i = 0; i < ikNodes.Size(); ++i)
+    {
+        poseNodes_[i].ikNode_ = ikNodes[i];
+        poseNodes_[i].node_ = (Node*)ikNodes[i]->user_data;
+    }
+}
+
+// ----------------------------------------------------------------------------
+void IKSolver::StoreActivePose()
+{
+    for (PODVector<PoseNode>::Iterator it = poseNodes_.Begin(); it != poseNodes_.End(); ++it)
+    {
+        it->position_ = Vec3IK2Urho(&it->ikNode_->position);
+        it->rotation_ = QuatIK2Urho(&it->ikNode_->rotation);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void IKSolver::ApplyPoseBufferToScene()
+{
+    /*
+     * Setting the position and rotation together marks the node's subtree
+     * dirty only once. Parents are applied before children, so marking a
+     * child dirty afterwards returns early.
+     */
+    for (unsigned i = 0; i < numPoseBaseNodes_; ++i)
+        poseNodes_[i].node_->SetWorldTransform(poseNodes_[i].position_, poseNodes_[i].rotation_);
+    for (unsigned i = numPoseBaseNodes_; i < poseNodes_.Size(); ++i)
+        poseNodes_[i].node_->SetTransform(poseNodes_[i].position_, poseNodes_[i].rotation_);
 }
 
 // ----------------------------------------------------------------------------
@@ -466,22 +540,10 @@ void IKSolver::ApplySceneToOriginalPose()
 }
 
 // ----------------------------------------------------------------------------
-static void ApplyBaseNodesToSceneCallback(ik_node_t* ikNode)
-{
-    Node* node = (Node*)ikNode->user_data;
-    node->SetWorldRotation(QuatIK2Urho(&ikNode->rotation));
-    node->SetWorldPosition(Vec3IK2Urho(&ikNode->position));
-}
-static void ApplyActivePoseToSceneCallback(ik_node_t* ikNode)
-{
-    Node* node = (Node*)ikNode->user_data;
-    node->SetRotation(QuatIK2Urho(&ikNode->rotation));
-    node->SetPosition(Vec3IK2Urho(&ikNode->position));
-}
 void IKSolver::ApplyActivePoseToScene()
 {
-    ik_solver_iterate_base_nodes(solver_, ApplyBaseNodesToSceneCallback);
-    ik_solver_iterate_chain_tree(solver_, ApplyActivePoseToSceneCallback);
+    StoreActivePose();
+    ApplyPoseBufferToScene();
 }
 
 // ----------------------------------------------------------------------------
@@ -537,19 +599,36 @@ bool IKSolver::IsSolverTreeValid() const
  * Unfortunately, E_COMPONENTREMOVED and E_COMPONENTADDED do not fire when a
  * parent node is removed/added containing child effector nodes, so we must
  * also monitor E_NODEREMOVED AND E_NODEADDED.
+ *
+ * The events are received by the scene's IKSolverManager, which passes them
+ * to the solvers attached to the changed node or its parent nodes.
  */
 
 // ----------------------------------------------------------------------------
 void IKSolver::OnSceneSet(Scene* scene)
 {
-    if (features_ & AUTO_SOLVE)
-        SubscribeToEvent(scene, E_SCENEDRAWABLEUPDATEFINISHED, URHO3D_HANDLER(IKSolver, HandleSceneDrawableUpdateFinished));
+    if (manager_ != NULL)
+        manager_->RemoveSolver(this);
+
+    if (scene != NULL)
+    {
+        IKSolverManager* manager = scene->GetComponent<IKSolverManager>();
+        if (manager == NULL)
+        {
+            // The manager is recreated whenever needed, so it is not saved with the scene
+            manager = scene->CreateComponent<IKSolverManager>(LOCAL);
+            manager->SetTemporary(true);
+        }
+        manager->AddSolver(this);
+    }
 }
 
 // ----------------------------------------------------------------------------
 void IKSolver::OnNodeSet(Node* node)
 {
-    ApplyOriginalPoseToScene();
+    // The tree is already gone if the solver manager was destroyed first
+    if (solver_->tree != NULL)
+        ApplyOriginalPoseToScene();
     DestroyTree();
 
     if (node != NULL)
@@ -739,16 +818,13 @@ void IKSolver::HandleNodeRemoved(StringHash eventType, VariantMap& eventData)
         else
             ik_node_destroy(ikNode);
 
+        // The pose buffer may refer to destroyed nodes until the chain trees are rebuilt
+        poseNodes_.Clear();
+        numPoseBaseNodes_ = 0;
         MarkChainsNeedUpdating();
     }
 }
 
-// ----------------------------------------------------------------------------
-void IKSolver::HandleSceneDrawableUpdateFinished(StringHash eventType, VariantMap& eventData)
-{
-    Solve();
-}
-
 // ----------------------------------------------------------------------------
 void IKSolver::DrawDebugGeometry(bool depthTest)
 {
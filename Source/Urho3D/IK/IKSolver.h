@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../Math/Quaternion.h"
 #include "../Scene/Component.h"
 
 struct ik_solver_t;
@@ -32,6 +33,8 @@ namespace Urho3D
 class AnimationState;
 class IKConstraint;
 class IKEffector;
+class IKSolverManager;
+struct WorkItem;
 
 /*!
  * @brief Marks the root or "beginning" of an IK chain or multiple IK chains.
@@ -161,6 +164,9 @@ public:
          * will be invoked automatically for you. If you need to do additional
          * calculations before being able to set the effector target data, you will
          * want to disable this and call Solve() manually.
+         *
+         * All solvers of a scene with this feature enabled are solved
+         * together by the scene's IKSolverManager, using the worker threads.
          */
         AUTO_SOLVE = 0x40
     };
@@ -310,6 +316,32 @@ public:
 
 private:
     friend class IKEffector;
+    friend class IKSolverManager;
+    friend void SolveIKWork(const WorkItem* item, unsigned threadIndex);
+
+    /// Solved transform of a scene node, written to the scene graph after solving.
+    struct PoseNode
+    {
+        /// Node of the solver's tree.
+        ik_node_t* ikNode_;
+        /// Scene node.
+        Node* node_;
+        /// Solved position. In world space for the base nodes of the chain trees, otherwise relative to the parent node.
+        Vector3 position_;
+        /// Solved rotation. In world space for the base nodes of the chain trees, otherwise relative to the parent node.
+        Quaternion rotation_;
+    };
+
+    /// Rebuilds the tree and chain trees if necessary and copies the scene graph and the effector targets into the solver's tree. Returns false if the tree cannot be solved.
+    bool PrepareSolve();
+    /// Runs the solver and stores the solution into the pose buffer. Does not access the scene graph, so different solvers can be solved concurrently.
+    void SolveToPoseBuffer();
+    /// Collects the nodes affected by solving from the chain trees into the pose buffer.
+    void CollectPoseNodes();
+    /// Copies the active pose into the pose buffer.
+    void StoreActivePose();
+    /// Copies the pose buffer into the scene graph.
+    void ApplyPoseBufferToScene();
 
     /// Indicates that the internal structures of the IK library need to be updated. See the documentation of ik_solver_rebuild_chain_trees() for more info on when this happens.
     void MarkChainsNeedUpdating();
@@ -318,7 +350,7 @@ private:
     /// Returns false if calling Solve() would cause the IK library to abort. Urho3D's error handling philosophy is to log an error and continue, not crash.
     bool IsSolverTreeValid() const;
 
-    /// Subscribe to drawable update finished event here
+    /// Registers to the scene's solver manager, which solves the solver and passes the scene hierarchy changes to it.
     virtual void OnSceneSet(Scene* scene);
     /// Destroys and creates the tree
     virtual void OnNodeSet(Node* scene);
@@ -345,8 +377,6 @@ private:
     void HandleComponentRemoved(StringHash eventType, VariantMap& eventData);
     void HandleNodeAdded(StringHash eventType, VariantMap& eventData);
     void HandleNodeRemoved(StringHash eventType, VariantMap& eventData);
-    /// Invokes the IK solver
-    void HandleSceneDrawableUpdateFinished(StringHash eventType, VariantMap& eventData);
 
     /// Need these wrapper functions flags of GetFeature/SetFeature can be correctly exposed to the editor and to AngelScript and lua
 public:
@@ -369,6 +399,12 @@ public:
 private:
     PODVector<IKEffector*> effectorList_;
     PODVector<IKConstraint*> constraintList_;
+    /// Nodes affected by solving and their solved transforms. The base nodes of the chain trees come first.
+    PODVector<PoseNode> poseNodes_;
+    /// Number of chain tree base nodes in the pose buffer.
+    unsigned numPoseBaseNodes_;
+    /// Solver manager of the scene.
+    WeakPtr<IKSolverManager> manager_;
     ik_solver_t* solver_;
     Algorithm algorithm_;
     unsigned features_;
@@ -0,0 +1,262 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../IK/IKSolverManager.h"
+#include "../IK/IKSolver.h"
+
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
+
+namespace Urho3D
+{
+
+extern const char* IK_CATEGORY;
+
+/// Solvers per work item at minimum. Solving a typical limb takes a few microseconds, so smaller work items are not worth it.
+static const unsigned MIN_SOLVERS_PER_WORK_ITEM = 4;
+
+// ----------------------------------------------------------------------------
+void SolveIKWork(const WorkItem* item, unsigned threadIndex)
+{
+    IKSolver** start = reinterpret_cast<IKSolver**>(item->start_);
+    IKSolver** end = reinterpret_cast<IKSolver**>(item->end_);
+
+    while (start != end)
+        (*start++)->SolveToPoseBuffer();
+}
+
+// ----------------------------------------------------------------------------
+IKSolverManager::IKSolverManager(Context* context) :
+    Component(context)
+{
+}
+
+// ----------------------------------------------------------------------------
+IKSolverManager::~IKSolverManager()
+{
+    /*
+     * The scene removes its own components before its child nodes, so the
+     * solvers no longer receive hierarchy events from here on. Destroy their
+     * trees now, while the scene nodes they refer to are still valid.
+     */
+    for (PODVector<IKSolver*>::ConstIterator it = solvers_.Begin(); it != solvers_.End(); ++it)
+    {
+        (*it)->manager_ = NULL;
+        (*it)->DestroyTree();
+        (*it)->MarkTreeNeedsRebuild();
+    }
+}
+
+// ----------------------------------------------------------------------------
+void IKSolverManager::RegisterObject(Context* context)
+{
+    context->RegisterFactory<IKSolverManager>(IK_CATEGORY);
+}
+
+// ----------------------------------------------------------------------------
+void IKSolverManager::Solve()
+{
+    URHO3D_PROFILE(IKSolveAll);
+
+    /*
+     * A solver attached to a node in the tree of another solver uses the
+     * solution of that solver as its starting point, so solve the solvers in
+     * order of depth, and each depth level as one parallel batch.
+     */
+    unsigned maxDepth = 0;
+    solverDepths_.Resize(solvers_.Size());
+    for (unsigned i = 0; i < solvers_.Size(); ++i)
+    {
+        unsigned depth = 0;
+        for (Node* iterNode = solvers_[i]->GetNode()->GetParent(); iterNode != NULL; iterNode = iterNode->GetParent())
+        {
+            if (iterNode->HasComponent<IKSolver>())
+                ++depth;
+        }
+        solverDepths_[i] = depth;
+        maxDepth = Max(maxDepth, depth);
+    }
+
+    for (unsigned depth = 0; depth <= maxDepth; ++depth)
+    {
+        batch_.Clear();
+        for (unsigned i = 0; i < solvers_.Size(); ++i)
+        {
+            if (solverDepths_[i] == depth && solvers_[i]->GetFeature(IKSolver::AUTO_SOLVE))
+                batch_.Push(solvers_[i]);
+        }
+
+        SolveBatch();
+    }
+}
+
+// ----------------------------------------------------------------------------
+void IKSolverManager::SolveBatch()
+{
+    // Read the scene graph and the effector targets into the solver trees. This must happen in the main thread
+    unsigned numSolvers = 0;
+    for (unsigned i = 0; i < batch_.Size(); ++i)
+    {
+        if (batch_[i]->PrepareSolve())
+            batch_[numSolvers++] = batch_[i];
+    }
+    if (numSolvers == 0)
+        return;
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned numWorkItems = queue ? queue->GetNumThreads() + 1 : 1; // Worker threads + main thread
+
+    if (numWorkItems == 1 || numSolvers < MIN_SOLVERS_PER_WORK_ITEM * 2)
+    {
+        for (unsigned i = 0; i < numSolvers; ++i)
+            batch_[i]->SolveToPoseBuffer();
+    }
+    else
+    {
+        numWorkItems = Min(numWorkItems, numSolvers / MIN_SOLVERS_PER_WORK_ITEM);
+        unsigned solversPerItem = numSolvers / numWorkItems;
+
+        IKSolver** start = &batch_[0];
+        for (unsigned i = 0; i < numWorkItems; ++i)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = SolveIKWork;
+
+            IKSolver** end = i < numWorkItems - 1 ? start + solversPerItem : &batch_[0] + numSolvers;
+            item->start_ = start;
+            item->end_ = end;
+            queue->AddWorkItem(item);
+
+            start = end;
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+
+    // Write the solved poses back to the scene graph
+    for (unsigned i = 0; i < numSolvers; ++i)
+        batch_[i]->ApplyPoseBufferToScene();
+}
+
+// ----------------------------------------------------------------------------
+void IKSolverManager::AddSolver(IKSolver* solver)
+{
+    solvers_.Push(solver);
+    solver->manager_ = this;
+}
+
+// ----------------------------------------------------------------------------
+void IKSolverManager::RemoveSolver(IKSolver* solver)
+{
+    solvers_.RemoveSwap(solver);
+    solver->manager_ = NULL;
+}
+
+// ----------------------------------------------------------------------------
+void IKSolverManager::CollectSolversAbove(Node* node)
+{
+    dispatch_.Clear();
+
+    for (Node* iterNode = node; iterNode != NULL; iterNode = iterNode->GetParent())
+    {
+        const Vector<SharedPtr<Component> >& components = iterNode->GetComponents();
+        for (Vector<SharedPtr<Component> >::ConstIterator it = components.Begin(); it != components.End(); ++it)
+        {
+            if ((*it)->GetType() == IKSolver::GetTypeStatic())
+                dispatch_.Push(static_cast<IKSolver*>(it->Get()));
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+void IKSolverManager::OnSceneSet(Scene* scene)
+{
+    if (scene != NULL)
+    {
+        SubscribeToEvent(scene, E_COMPONENTADDED,   URHO3D_HANDLER(IKSolverManager, HandleComponentAdded));
+        SubscribeToEvent(scene, E_COMPONENTREMOVED, URHO3D_HANDLER(IKSolverManager, HandleComponentRemoved));
+        SubscribeToEvent(scene, E_NODEADDED,        URHO3D_HANDLER(IKSolverManager, HandleNodeAdded));
+        SubscribeToEvent(scene, E_NODEREMOVED,      URHO3D_HANDLER(IKSolverManager, HandleNodeRemoved));
+        SubscribeToEvent(scene, E_SCENEDRAWABLEUPDATEFINISHED, URHO3D_HANDLER(IKSolverManager, HandleSceneDrawableUpdateFinished));
+    }
+    else
+        UnsubscribeFromAllEvents();
+}
+
+// ----------------------------------------------------------------------------
+/*
+ * Only the solvers above the changed node can have the node or its
+ * components in their tree, so the events are passed to those only.
+ */
+
+// ----------------------------------------------------------------------------
+void IKSolverManager::HandleComponentAdded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ComponentAdded;
+
+    CollectSolversAbove(static_cast<Node*>(eventData[P_NODE].GetPtr()));
+    for (PODVector<IKSolver*>::ConstIterator it = dispatch_.Begin(); it != dispatch_.End(); ++it)
+        (*it)->HandleComponentAdded(eventType, eventData);
+}
+
+// ----------------------------------------------------------------------------
+void IKSolverManager::HandleComponentRemoved(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ComponentRemoved;
+
+    CollectSolversAbove(static_cast<Node*>(eventData[P_NODE].GetPtr()));
+    for (PODVector<IKSolver*>::ConstIterator it = dispatch_.Begin(); it != dispatch_.End(); ++it)
+        (*it)->HandleComponentRemoved(eventType, eventData);
+}
+
+// ----------------------------------------------------------------------------
+void IKSolverManager::HandleNodeAdded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace NodeAdded;
+
+    CollectSolversAbove(static_cast<Node*>(eventData[P_NODE].GetPtr()));
+    for (PODVector<IKSolver*>::ConstIterator it = dispatch_.Begin(); it != dispatch_.End(); ++it)
+        (*it)->HandleNodeAdded(eventType, eventData);
+}
+
+// ----------------------------------------------------------------------------
+void IKSolverManager::HandleNodeRemoved(StringHash eventType, VariantMap& eventData)
+{
+    using namespace NodeRemoved;
+
+    CollectSolversAbove(static_cast<Node*>(eventData[P_NODE].GetPtr()));
+    for (PODVector<IKSolver*>::ConstIterator it = dispatch_.Begin(); it != dispatch_.End(); ++it)
+        (*it)->HandleNodeRemoved(eventType, eventData);
+}
+
+// ----------------------------------------------------------------------------
+void IKSolverManager::HandleSceneDrawableUpdateFinished(StringHash eventType, VariantMap& eventData)
+{
+    Solve();
+}
+
+} // namespace Urho3D
@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2008-2016 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Scene/Component.h"
+
+namespace Urho3D
+{
+
+class IKSolver;
+
+/*!
+ * @brief Solves all IKSolver components of a scene together. Created
+ * automatically in the scene when the first IKSolver is added.
+ *
+ * The solvers with the feature flag AUTO_SOLVE are solved in response to
+ * E_SCENEDRAWABLEUPDATEFINISHED. The scene graph is read into the solver trees
+ * in the main thread, the solvers are then solved in parallel using the worker
+ * threads (solvers never share nodes), and finally the solved poses are
+ * written back to the scene graph in one pass. A solver located in the tree of
+ * another solver is solved after it, as it depends on its result.
+ *
+ * The manager also receives the scene hierarchy change events and passes each
+ * of them to only the solvers above the changed node, instead of every solver
+ * handling every change in the scene.
+ */
+class URHO3D_API IKSolverManager : public Component
+{
+    URHO3D_OBJECT(IKSolverManager, Component)
+
+public:
+    /// Construct.
+    IKSolverManager(Context* context);
+    /// Destruct.
+    virtual ~IKSolverManager();
+    /// Registers this class to the context.
+    static void RegisterObject(Context* context);
+
+    /*!
+     * @brief Solves all solvers that have the feature flag AUTO_SOLVE set.
+     * @note This gets called automatically in response to
+     * E_SCENEDRAWABLEUPDATEFINISHED.
+     */
+    void Solve();
+
+    /// Returns the number of solvers in the scene.
+    unsigned GetNumSolvers() const { return solvers_.Size(); }
+
+private:
+    friend class IKSolver;
+
+    /// Adds a solver of the scene.
+    void AddSolver(IKSolver* solver);
+    /// Removes a solver of the scene.
+    void RemoveSolver(IKSolver* solver);
+    /// Solves the solvers in the batch list. The solvers are independent of each other.
+    void SolveBatch();
+    /// Collects the solvers attached to the specified node or to any of its parent nodes into the dispatch list.
+    void CollectSolversAbove(Node* node);
+
+    /// Subscribe to the scene events here.
+    virtual void OnSceneSet(Scene* scene);
+
+    void HandleComponentAdded(StringHash eventType, VariantMap& eventData);
+    void HandleComponentRemoved(StringHash eventType, VariantMap& eventData);
+    void HandleNodeAdded(StringHash eventType, VariantMap& eventData);
+    void HandleNodeRemoved(StringHash eventType, VariantMap& eventData);
+    /// Invokes the IK solvers.
+    void HandleSceneDrawableUpdateFinished(StringHash eventType, VariantMap& eventData);
+
+    /// All solvers of the scene.
+    PODVector<IKSolver*> solvers_;
+    /// Number of parent solvers of each solver. Recalculated before solving.
+    PODVector<unsigned> solverDepths_;
+    /// Solvers being solved together.
+    PODVector<IKSolver*> batch_;
+    /// Solvers to pass a scene hierarchy change event to.
+    PODVector<IKSolver*> dispatch_;
+};
+
+} // namespace Urho3D
@@ -619,6 +619,11 @@ void CrowdAgent::OnSceneSet(Scene* scene)
 
 void CrowdAgent::OnMarkedDirty(Node* node)
 {
+    // Interpolated transforms between scene fixed updates do not move the agent
+    Scene* scene = GetScene();
+    if (scene && scene->IsUpdatingInterpolation())
+        return;
+
     if (!ignoreTransformChanges_ && IsEnabledEffective())
     {
         dtCrowdAgent* agent = const_cast<dtCrowdAgent*>(GetDetourCrowdAgent());
@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../IO/Log.h"
 #include "../Navigation/CrowdAgent.h"
@@ -45,6 +46,8 @@ extern const char* NAVIGATION_CATEGORY;
 
 static const unsigned DEFAULT_MAX_AGENTS = 512;
 static const float DEFAULT_MAX_AGENT_RADIUS = 0.f;
+static const unsigned DEFAULT_LOD_UPDATE_INTERVAL = 4;
+static const int MIN_AGENTS_PER_WORK_ITEM = 64;
 
 const char* filterTypesStructureElementNames[] =
 {
@@ -76,6 +79,49 @@ void CrowdAgentUpdateCallback(dtCrowdAgent* ag, float dt)
     static_cast<CrowdAgent*>(ag->params.userData)->OnCrowdUpdate(ag, dt);
 }
 
+void CrowdUpdateWork(const WorkItem* item, unsigned threadIndex)
+{
+    dtCrowd* crowd = reinterpret_cast<dtCrowd*>(item->aux_);
+    dtCrowdAgent** start = reinterpret_cast<dtCrowdAgent**>(item->start_);
+    dtCrowdAgent** end = reinterpret_cast<dtCrowdAgent**>(item->end_);
+    crowd->updateAgents(start, end, threadIndex);
+}
+
+void CrowdParallelUpdateCallback(dtCrowd* crowd, dtCrowdAgent** agents, const int nagents, void* userData)
+{
+    WorkQueue* queue = static_cast<CrowdManager*>(userData)->GetSubsystem<WorkQueue>();
+    int numWorkItems = queue ? (int)queue->GetNumThreads() + 1 : 1; // Worker threads + main thread
+
+    // Run small crowds in the main thread only, as the phases are too short to benefit from splitting. Also do so
+    // if the worker thread count has grown beyond what the crowd has per-thread query objects for
+    if (numWorkItems == 1 || numWorkItems > crowd->getMaxThreads() || nagents < MIN_AGENTS_PER_WORK_ITEM * 2)
+    {
+        crowd->updateAgents(agents, agents + nagents, 0);
+        return;
+    }
+
+    numWorkItems = Min(numWorkItems, nagents / MIN_AGENTS_PER_WORK_ITEM);
+    int agentsPerItem = nagents / numWorkItems;
+
+    dtCrowdAgent** start = agents;
+    for (int i = 0; i < numWorkItems; ++i)
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = CrowdUpdateWork;
+        item->aux_ = crowd;
+
+        dtCrowdAgent** end = i < numWorkItems - 1 ? start + agentsPerItem : agents + nagents;
+        item->start_ = start;
+        item->end_ = end;
+        queue->AddWorkItem(item);
+
+        start = end;
+    }
+
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
 CrowdManager::CrowdManager(Context* context) :
     Component(context),
     crowd_(0),
@@ -83,7 +129,13 @@ CrowdManager::CrowdManager(Context* context) :
     maxAgents_(DEFAULT_MAX_AGENTS),
     maxAgentRadius_(DEFAULT_MAX_AGENT_RADIUS),
     numQueryFilterTypes_(0),
-    numObstacleAvoidanceTypes_(0)
+    numObstacleAvoidanceTypes_(0),
+    lodDistance_(0.0f),
+    lodObstacleAvoidanceType_(0),
+    lodUpdateInterval_(DEFAULT_LOD_UPDATE_INTERVAL),
+    lodUpdateCount_(0),
+    numLodAgents_(0),
+    lodApplied_(false)
 {
     // The actual buffer is allocated inside dtCrowd, we only track the number of "slots" being configured explicitly
     numAreas_.Reserve(DT_CROWD_MAX_QUERY_FILTER_TYPE);
@@ -110,6 +162,9 @@ void CrowdManager::RegisterObject(Context* context)
     URHO3D_MIXED_ACCESSOR_VARIANT_VECTOR_STRUCTURE_ATTRIBUTE("Obstacle Avoidance Types", GetObstacleAvoidanceTypesAttr, SetObstacleAvoidanceTypesAttr,
                                                              VariantVector, Variant::emptyVariantVector,
                                                              obstacleAvoidanceTypesStructureElementNames, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("LOD Distance", float, lodDistance_, 0.0f, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("LOD Obstacle Avoidance Type", unsigned, lodObstacleAvoidanceType_, 0, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("LOD Update Interval", unsigned, lodUpdateInterval_, DEFAULT_LOD_UPDATE_INTERVAL, AM_DEFAULT);
 }
 
 void CrowdManager::ApplyAttributes()
@@ -117,6 +172,9 @@ void CrowdManager::ApplyAttributes()
     // Values from Editor, saved-file, or network must be checked before applying
     maxAgents_ = Max(1U, maxAgents_);
     maxAgentRadius_ = Max(0.f, maxAgentRadius_);
+    lodDistance_ = Max(0.f, lodDistance_);
+    lodObstacleAvoidanceType_ = Min(lodObstacleAvoidanceType_, (unsigned)DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS - 1);
+    lodUpdateInterval_ = Max(1U, lodUpdateInterval_);
 
     bool navMeshChange = false;
     Scene* scene = GetScene();
@@ -393,6 +451,51 @@ void CrowdManager::SetObstacleAvoidanceParams(unsigned obstacleAvoidanceType, co
     }
 }
 
+void CrowdManager::AddLodObserver(Node* node)
+{
+    if (!node)
+        return;
+
+    WeakPtr<Node> nodeWeak(node);
+    if (!lodObservers_.Contains(nodeWeak))
+        lodObservers_.Push(nodeWeak);
+}
+
+void CrowdManager::RemoveLodObserver(Node* node)
+{
+    lodObservers_.Remove(WeakPtr<Node>(node));
+}
+
+void CrowdManager::RemoveAllLodObservers()
+{
+    lodObservers_.Clear();
+}
+
+void CrowdManager::SetLodDistance(float distance)
+{
+    lodDistance_ = Max(distance, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void CrowdManager::SetLodObstacleAvoidanceType(unsigned obstacleAvoidanceType)
+{
+    if (obstacleAvoidanceType >= DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS)
+    {
+        URHO3D_LOGERRORF("The specified obstacle avoidance type index (%d) exceeds the maximum allowed value (%d)",
+            obstacleAvoidanceType, DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS);
+        return;
+    }
+
+    lodObstacleAvoidanceType_ = obstacleAvoidanceType;
+    MarkNetworkUpdate();
+}
+
+void CrowdManager::SetLodUpdateInterval(unsigned interval)
+{
+    lodUpdateInterval_ = Max(interval, 1U);
+    MarkNetworkUpdate();
+}
+
 Vector3 CrowdManager::FindNearestPoint(const Vector3& point, int queryFilterType, dtPolyRef* nearestRef)
 {
     if (nearestRef)
@@ -596,6 +699,15 @@ bool CrowdManager::CreateCrowd()
         return false;
     }
 
+    // Allocate per-thread query objects so that the per-agent update phases can run in the worker threads
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned numThreads = queue ? queue->GetNumThreads() : 0;
+    if (numThreads && !crowd_->initThreads(numThreads + 1, CrowdParallelUpdateCallback, this))
+    {
+        URHO3D_LOGWARNING("Could not initialize DetourCrowd for threaded update, updating in the main thread");
+        crowd_->initThreads(1, 0, 0);
+    }
+
     if (recreate)
     {
         // Reconfigure the newly initialized crowd
@@ -685,9 +797,76 @@ void CrowdManager::Update(float delta)
 {
     assert(crowd_ && navigationMesh_);
     URHO3D_PROFILE(UpdateCrowd);
+    UpdateLod();
     crowd_->update(delta, 0);
 }
 
+void CrowdManager::UpdateLod()
+{
+    bool lodActive = lodDistance_ > 0.0f && !lodObservers_.Empty();
+    if (!lodActive && !lodApplied_)
+        return;
+
+    URHO3D_PROFILE(UpdateCrowdLod);
+
+    PODVector<Vector3> observerPositions;
+    for (Vector<WeakPtr<Node> >::Iterator i = lodObservers_.Begin(); i != lodObservers_.End();)
+    {
+        if (*i)
+        {
+            observerPositions.Push((*i)->GetWorldPosition());
+            ++i;
+        }
+        else
+            i = lodObservers_.Erase(i);
+    }
+    if (observerPositions.Empty())
+        lodActive = false;
+
+    const float lodDistanceSquared = lodDistance_ * lodDistance_;
+    ++lodUpdateCount_;
+    numLodAgents_ = 0;
+
+    for (int i = 0; i < crowd_->getAgentCount(); ++i)
+    {
+        dtCrowdAgent* ag = crowd_->getEditableAgent(i);
+        if (!ag->active || !ag->params.userData)
+            continue;
+
+        bool distant = lodActive;
+        if (distant)
+        {
+            Vector3 position(ag->npos);
+            for (unsigned j = 0; j < observerPositions.Size(); ++j)
+            {
+                if ((position - observerPositions[j]).LengthSquared() <= lodDistanceSquared)
+                {
+                    distant = false;
+                    break;
+                }
+            }
+        }
+
+        if (distant)
+        {
+            // Stagger the avoidance updates of distant agents so that the sampling cost is spread evenly over frames
+            ag->params.obstacleAvoidanceType = (unsigned char)lodObstacleAvoidanceType_;
+            if ((lodUpdateCount_ + i) % lodUpdateInterval_)
+                ag->params.updateFlags |= DT_CROWD_SKIP_AVOIDANCE;
+            else
+                ag->params.updateFlags &= ~DT_CROWD_SKIP_AVOIDANCE;
+            ++numLodAgents_;
+        }
+        else
+        {
+            ag->params.obstacleAvoidanceType = (unsigned char)static_cast<CrowdAgent*>(ag->params.userData)->GetObstacleAvoidanceType();
+            ag->params.updateFlags &= ~DT_CROWD_SKIP_AVOIDANCE;
+        }
+    }
+
+    lodApplied_ = lodActive;
+}
+
 const dtCrowdAgent* CrowdManager::GetDetourCrowdAgent(int agent) const
 {
     return crowd_ ? crowd_->getAgent(agent) : 0;
@@ -101,6 +101,18 @@ public:
     void SetObstacleAvoidanceTypesAttr(const VariantVector& value);
     /// Set the params for the specified obstacle avoidance type.
     void SetObstacleAvoidanceParams(unsigned obstacleAvoidanceType, const CrowdObstacleAvoidanceParams& params);
+    /// Add a node, such as a player or camera, near which agents are simulated at full quality. Agents further than the LOD distance from all observers use reduced quality avoidance.
+    void AddLodObserver(Node* node);
+    /// Remove a LOD observer node.
+    void RemoveLodObserver(Node* node);
+    /// Remove all LOD observer nodes.
+    void RemoveAllLodObservers();
+    /// Set distance from the nearest LOD observer beyond which agents use reduced quality avoidance. Zero (default) disables.
+    void SetLodDistance(float distance);
+    /// Set the obstacle avoidance type used by agents beyond the LOD distance, typically configured with fewer samples.
+    void SetLodObstacleAvoidanceType(unsigned obstacleAvoidanceType);
+    /// Set how often, in crowd updates, agents beyond the LOD distance sample a new avoidance velocity. In between they keep the previous one.
+    void SetLodUpdateInterval(unsigned interval);
 
     /// Get all the crowd agent components in the specified node hierarchy. If the node is not specified then use scene node. When inCrowdFilter is set to true then only get agents that are in the crowd.
     PODVector<CrowdAgent*> GetAgents(Node* node = 0, bool inCrowdFilter = true) const;
@@ -150,6 +162,21 @@ public:
     /// Get the params for the specified obstacle avoidance type.
     const CrowdObstacleAvoidanceParams& GetObstacleAvoidanceParams(unsigned obstacleAvoidanceType) const;
 
+    /// Return number of LOD observer nodes.
+    unsigned GetNumLodObservers() const { return lodObservers_.Size(); }
+
+    /// Return LOD distance.
+    float GetLodDistance() const { return lodDistance_; }
+
+    /// Return obstacle avoidance type used by agents beyond the LOD distance.
+    unsigned GetLodObstacleAvoidanceType() const { return lodObstacleAvoidanceType_; }
+
+    /// Return LOD avoidance update interval.
+    unsigned GetLodUpdateInterval() const { return lodUpdateInterval_; }
+
+    /// Return number of agents that were beyond the LOD distance in the last update.
+    unsigned GetNumLodAgents() const { return numLodAgents_; }
+
 protected:
     /// Create and initialized internal Detour crowd object. When it is a recreate, it preserves the configuration and attempts to re-add existing agents in the previous crowd back to the newly created crowd.
     bool CreateCrowd();
@@ -163,6 +190,8 @@ protected:
     virtual void OnSceneSet(Scene* scene);
     /// Update the crowd simulation.
     void Update(float delta);
+    /// Apply reduced quality avoidance to agents beyond the LOD distance, and restore full quality to the rest.
+    void UpdateLod();
     /// Get the detour crowd agent.
     const dtCrowdAgent* GetDetourCrowdAgent(int agent) const;
     /// Get the detour query filter.
@@ -195,6 +224,20 @@ private:
     PODVector<unsigned> numAreas_;
     /// Number of obstacle avoidance types configured in the crowd. Limit to DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS.
     unsigned numObstacleAvoidanceTypes_;
+    /// LOD observer nodes.
+    Vector<WeakPtr<Node> > lodObservers_;
+    /// Distance from the nearest LOD observer beyond which agents use reduced quality avoidance.
+    float lodDistance_;
+    /// Obstacle avoidance type used by agents beyond the LOD distance.
+    unsigned lodObstacleAvoidanceType_;
+    /// Avoidance update interval of agents beyond the LOD distance.
+    unsigned lodUpdateInterval_;
+    /// Number of LOD updates performed, used to stagger the avoidance updates of distant agents.
+    unsigned lodUpdateCount_;
+    /// Number of agents beyond the LOD distance in the last update.
+    unsigned numLodAgents_;
+    /// Whether LOD was applied to the agents' parameters in the last update.
+    bool lodApplied_;
 };
 
 }
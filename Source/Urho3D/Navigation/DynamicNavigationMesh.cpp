@@ -25,6 +25,8 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
@@ -58,6 +60,7 @@ extern const char* NAVIGATION_CATEGORY;
 
 static const int DEFAULT_MAX_OBSTACLES = 1024;
 static const int DEFAULT_MAX_LAYERS = 16;
+static const int DEFAULT_TILE_UPDATE_MS = 2;
 
 struct DynamicNavigationMesh::TileCacheData
 {
@@ -65,6 +68,14 @@ struct DynamicNavigationMesh::TileCacheData
     int dataSize;
 };
 
+struct DynamicNavigationMesh::TileUpdate
+{
+    dtCompressedTileRef ref;
+    unsigned char* data;
+    int dataSize;
+    dtStatus status;
+};
+
 struct TileCompressor : public dtTileCacheCompressor
 {
     virtual int maxCompressedSize(const int bufferSize)
@@ -95,9 +106,11 @@ struct MeshProcess : public dtTileCacheMeshProcess
     PODVector<unsigned short> offMeshFlags_;
     PODVector<unsigned char> offMeshAreas_;
     PODVector<unsigned char> offMeshDir_;
+    bool collectConnections_;
 
     inline MeshProcess(DynamicNavigationMesh* owner) :
-        owner_(owner)
+        owner_(owner),
+        collectConnections_(true)
     {
     }
 
@@ -111,33 +124,12 @@ struct MeshProcess : public dtTileCacheMeshProcess
                 polyFlags[i] = RC_WALKABLE_AREA;
         }
 
-        BoundingBox bounds;
-        rcVcopy(&bounds.min_.x_, params->bmin);
-        rcVcopy(&bounds.max_.x_, params->bmin);
-
-        // collect off-mesh connections
-        PODVector<OffMeshConnection*> offMeshConnections = owner_->CollectOffMeshConnections(bounds);
+        // Collecting accesses the scene, so when tiles are built in worker threads it has been done beforehand
+        if (collectConnections_)
+            CollectConnectionData();
 
-        if (offMeshConnections.Size() > 0)
+        if (offMeshRadii_.Size() > 0)
         {
-            if (offMeshConnections.Size() != offMeshRadii_.Size())
-            {
-                Matrix3x4 inverse = owner_->GetNode()->GetWorldTransform().Inverse();
-                ClearConnectionData();
-                for (unsigned i = 0; i < offMeshConnections.Size(); ++i)
-                {
-                    OffMeshConnection* connection = offMeshConnections[i];
-                    Vector3 start = inverse * connection->GetNode()->GetWorldPosition();
-                    Vector3 end = inverse * connection->GetEndPoint()->GetWorldPosition();
-
-                    offMeshVertices_.Push(start);
-                    offMeshVertices_.Push(end);
-                    offMeshRadii_.Push(connection->GetRadius());
-                    offMeshFlags_.Push((unsigned short)connection->GetMask());
-                    offMeshAreas_.Push((unsigned char)connection->GetAreaID());
-                    offMeshDir_.Push((unsigned char)(connection->IsBidirectional() ? DT_OFFMESH_CON_BIDIR : 0));
-                }
-            }
             params->offMeshConCount = offMeshRadii_.Size();
             params->offMeshConVerts = &offMeshVertices_[0].x_;
             params->offMeshConRad = &offMeshRadii_[0];
@@ -147,6 +139,31 @@ struct MeshProcess : public dtTileCacheMeshProcess
         }
     }
 
+    void CollectConnectionData()
+    {
+        // collect off-mesh connections
+        PODVector<OffMeshConnection*> offMeshConnections = owner_->CollectOffMeshConnections(BoundingBox());
+
+        if (offMeshConnections.Size() != offMeshRadii_.Size())
+        {
+            Matrix3x4 inverse = owner_->GetNode()->GetWorldTransform().Inverse();
+            ClearConnectionData();
+            for (unsigned i = 0; i < offMeshConnections.Size(); ++i)
+            {
+                OffMeshConnection* connection = offMeshConnections[i];
+                Vector3 start = inverse * connection->GetNode()->GetWorldPosition();
+                Vector3 end = inverse * connection->GetEndPoint()->GetWorldPosition();
+
+                offMeshVertices_.Push(start);
+                offMeshVertices_.Push(end);
+                offMeshRadii_.Push(connection->GetRadius());
+                offMeshFlags_.Push((unsigned short)connection->GetMask());
+                offMeshAreas_.Push((unsigned char)connection->GetAreaID());
+                offMeshDir_.Push((unsigned char)(connection->IsBidirectional() ? DT_OFFMESH_CON_BIDIR : 0));
+            }
+        }
+    }
+
     void ClearConnectionData()
     {
         offMeshVertices_.Clear();
@@ -159,20 +176,20 @@ struct MeshProcess : public dtTileCacheMeshProcess
 
 
 // From the Detour/Recast Sample_TempObstacles.cpp
-struct LinearAllocator : public dtTileCacheAlloc
+struct TileCacheLinearAllocator : public dtTileCacheAlloc
 {
     unsigned char* buffer;
     int capacity;
     int top;
     int high;
 
-    LinearAllocator(const int cap) :
+    TileCacheLinearAllocator(const int cap) :
         buffer(0), capacity(0), top(0), high(0)
     {
         resize(cap);
     }
 
-    ~LinearAllocator()
+    ~TileCacheLinearAllocator()
     {
         dtFree(buffer);
     }
@@ -211,6 +228,8 @@ struct LinearAllocator : public dtTileCacheAlloc
 DynamicNavigationMesh::DynamicNavigationMesh(Context* context) :
     NavigationMesh(context),
     tileCache_(0),
+    tileUpdateMs_(DEFAULT_TILE_UPDATE_MS),
+    numUpdatedTiles_(0),
     maxObstacles_(1024),
     maxLayers_(DEFAULT_MAX_LAYERS),
     drawObstacles_(false)
@@ -218,7 +237,7 @@ DynamicNavigationMesh::DynamicNavigationMesh(Context* context) :
     //64 is the largest tile-size that DetourTileCache will tolerate without silently failing
     tileSize_ = 64;
     partitionType_ = NAVMESH_PARTITION_MONOTONE;
-    allocator_ = new LinearAllocator(32000); //32kb to start
+    allocator_ = new TileCacheLinearAllocator(32000); //32kb to start
     compressor_ = new TileCompressor();
     meshProcessor_ = new MeshProcess(this);
 }
@@ -233,9 +252,15 @@ void DynamicNavigationMesh::RegisterObject(Context* context)
     context->RegisterFactory<DynamicNavigationMesh>(NAVIGATION_CATEGORY);
 
     URHO3D_COPY_BASE_ATTRIBUTES(NavigationMesh);
+    // Tile region streaming is not supported, as the tile cache needs the data of all tiles
+    URHO3D_REMOVE_ATTRIBUTE("Tile Region Pattern");
+    URHO3D_REMOVE_ATTRIBUTE("Tile Region Size");
+    URHO3D_REMOVE_ATTRIBUTE("Streaming Load Distance");
+    URHO3D_REMOVE_ATTRIBUTE("Streaming Unload Distance");
     URHO3D_ACCESSOR_ATTRIBUTE("Max Obstacles", GetMaxObstacles, SetMaxObstacles, unsigned, DEFAULT_MAX_OBSTACLES, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Max Layers", GetMaxLayers, SetMaxLayers, unsigned, DEFAULT_MAX_LAYERS, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Draw Obstacles", GetDrawObstacles, SetDrawObstacles, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Tile Update Ms", GetTileUpdateMs, SetTileUpdateMs, int, DEFAULT_TILE_UPDATE_MS, AM_DEFAULT);
 }
 
 bool DynamicNavigationMesh::Build()
@@ -665,11 +690,22 @@ void DynamicNavigationMesh::SetMaxLayers(unsigned maxLayers)
     maxLayers_ = Max(3U, Min(maxLayers, TILECACHE_MAXLAYERS));
 }
 
+unsigned DynamicNavigationMesh::GetNumPendingTiles() const
+{
+    return tileCache_ ? (unsigned)tileCache_->getUpdateCount() : 0;
+}
+
+unsigned DynamicNavigationMesh::GetNumPendingObstacleRequests() const
+{
+    return tileCache_ ? (unsigned)tileCache_->getRequestCount() : 0;
+}
+
 int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z, TileCacheData* tiles)
 {
     URHO3D_PROFILE(BuildNavigationMeshTile);
 
     tileCache_->removeTile(navMesh_->getTileRefAt(x, z, 0), 0, 0);
+    clusterGraphDirty_ = true;
 
     float tileEdgeLength = (float)tileSize_ * cellSize_;
 
@@ -881,10 +917,16 @@ void DynamicNavigationMesh::ReleaseTileCache()
 {
     dtFreeTileCache(tileCache_);
     tileCache_ = 0;
+
+    for (unsigned i = 0; i < threadAllocators_.Size(); ++i)
+        delete threadAllocators_[i];
+    threadAllocators_.Clear();
 }
 
 void DynamicNavigationMesh::OnSceneSet(Scene* scene)
 {
+    NavigationMesh::OnSceneSet(scene);
+
     // Subscribe to the scene subsystem update, which will trigger the tile cache to update the nav mesh
     if (scene)
         SubscribeToEvent(scene, E_SCENESUBSYSTEMUPDATE, URHO3D_HANDLER(DynamicNavigationMesh, HandleSceneSubsystemUpdate));
@@ -901,12 +943,16 @@ void DynamicNavigationMesh::AddObstacle(Obstacle* obstacle, bool silent)
         rcVcopy(pos, &obsPos.x_);
         dtObstacleRef refHolder;
 
-        // Because dtTileCache doesn't process obstacle requests while updating tiles
-        // it's necessary update until sufficient request space is available
-        while (tileCache_->isObstacleQueueFull())
-            tileCache_->update(1, navMesh_);
+        FlushObstacleRequests();
 
-        if (dtStatusFailed(tileCache_->addObstacle(pos, obstacle->GetRadius(), obstacle->GetHeight(), &refHolder)))
+        dtStatus status = tileCache_->addObstacle(pos, obstacle->GetRadius(), obstacle->GetHeight(), &refHolder);
+        // Removed obstacles are recycled only after their tiles have been rebuilt, so rebuild tiles if out of obstacles
+        while (dtStatusFailed(status) && !tileCache_->isUpToDate())
+        {
+            UpdateTiles(0);
+            status = tileCache_->addObstacle(pos, obstacle->GetRadius(), obstacle->GetHeight(), &refHolder);
+        }
+        if (dtStatusFailed(status))
         {
             URHO3D_LOGERROR("Failed to add obstacle");
             return;
@@ -941,10 +987,7 @@ void DynamicNavigationMesh::RemoveObstacle(Obstacle* obstacle, bool silent)
 {
     if (tileCache_ && obstacle->obstacleId_ > 0)
     {
-        // Because dtTileCache doesn't process obstacle requests while updating tiles
-        // it's necessary update until sufficient request space is available
-        while (tileCache_->isObstacleQueueFull())
-            tileCache_->update(1, navMesh_);
+        FlushObstacleRequests();
 
         if (dtStatusFailed(tileCache_->removeObstacle(obstacle->obstacleId_)))
         {
@@ -967,12 +1010,96 @@ void DynamicNavigationMesh::RemoveObstacle(Obstacle* obstacle, bool silent)
     }
 }
 
+void TileUpdateWork(const WorkItem* item, unsigned threadIndex)
+{
+    const DynamicNavigationMesh* navMesh = reinterpret_cast<DynamicNavigationMesh*>(item->aux_);
+    DynamicNavigationMesh::TileUpdate* update = reinterpret_cast<DynamicNavigationMesh::TileUpdate*>(item->start_);
+
+    // Thread index 0 is the main thread, which uses the allocator of the tile cache itself
+    dtTileCacheAlloc* allocator = threadIndex ? navMesh->threadAllocators_[threadIndex - 1] : navMesh->allocator_.Get();
+    update->status = navMesh->tileCache_->buildNavMeshTileData(update->ref, allocator, &update->data, &update->dataSize);
+}
+
+void DynamicNavigationMesh::UpdateTiles(int maxMs)
+{
+    URHO3D_PROFILE(UpdateNavigationMeshTiles);
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned numThreads = queue->GetNumThreads();
+    while (threadAllocators_.Size() < numThreads)
+        threadAllocators_.Push(new TileCacheLinearAllocator(32000));
+
+    // Off-mesh connections can not be collected from the worker threads, so collect them once for the whole update
+    MeshProcess* meshProcess = static_cast<MeshProcess*>(meshProcessor_.Get());
+    meshProcess->CollectConnectionData();
+    meshProcess->collectConnections_ = false;
+
+    HiresTimer timer;
+    long long maxUSec = (long long)maxMs * 1000;
+
+    for (;;)
+    {
+        // Turn obstacle requests into tile updates, so that tiles touched by several obstacles are rebuilt only once
+        tileCache_->processObstacleRequests();
+
+        unsigned batchSize = Min((unsigned)tileCache_->getUpdateCount(), numThreads + 1);
+        if (!batchSize)
+            break;
+
+        // The tile cache must not be modified while the tiles are being built, which is guaranteed by waiting for
+        // completion here in the main thread
+        tileUpdates_.Resize(batchSize);
+        for (unsigned i = 0; i < batchSize; ++i)
+        {
+            TileUpdate& update = tileUpdates_[i];
+            update.ref = tileCache_->getUpdate(i);
+            update.data = 0;
+            update.dataSize = 0;
+
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = TileUpdateWork;
+            item->aux_ = this;
+            item->start_ = &update;
+            queue->AddWorkItem(item);
+        }
+        queue->Complete(M_MAX_UNSIGNED);
+
+        for (unsigned i = 0; i < batchSize; ++i)
+        {
+            const TileUpdate& update = tileUpdates_[i];
+            if (dtStatusFailed(update.status) ||
+                dtStatusFailed(tileCache_->addNavMeshTileData(update.ref, update.data, update.dataSize, navMesh_)))
+                URHO3D_LOGERROR("Failed to rebuild navigation mesh tile");
+        }
+        tileCache_->completeUpdates(batchSize);
+        numUpdatedTiles_ += batchSize;
+        clusterGraphDirty_ = true;
+
+        if (timer.GetUSec(false) >= maxUSec)
+            break;
+    }
+
+    meshProcess->collectConnections_ = true;
+}
+
+void DynamicNavigationMesh::FlushObstacleRequests()
+{
+    // Assign the queued obstacle requests to tiles. Tiles need to be rebuilt only if there are too many pending already
+    while (tileCache_->isObstacleQueueFull())
+    {
+        tileCache_->processObstacleRequests();
+        if (tileCache_->isObstacleQueueFull())
+            UpdateTiles(0);
+    }
+}
+
 void DynamicNavigationMesh::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData)
 {
-    using namespace SceneSubsystemUpdate;
+    numUpdatedTiles_ = 0;
 
-    if (tileCache_ && navMesh_ && IsEnabledEffective())
-        tileCache_->update(eventData[P_TIMESTEP].GetFloat(), navMesh_);
+    if (tileCache_ && navMesh_ && IsEnabledEffective() && !tileCache_->isUpToDate())
+        UpdateTiles(tileUpdateMs_);
 }
 
 }
@@ -44,6 +44,7 @@ class URHO3D_API DynamicNavigationMesh : public NavigationMesh
 
     friend class Obstacle;
     friend struct MeshProcess;
+    friend void TileUpdateWork(const WorkItem* item, unsigned threadIndex);
 
 public:
     /// Constructor.
@@ -67,6 +68,8 @@ public:
     virtual void SetNavigationDataAttr(const PODVector<unsigned char>& value);
     /// Return navigation data attribute.
     virtual PODVector<unsigned char> GetNavigationDataAttr() const;
+    /// Return whether tile regions can be streamed. Always false, as the obstacles need the tile cache data of all tiles.
+    virtual bool SupportsTileRegions() const { return false; }
 
     /// Set the maximum number of obstacles allowed.
     void SetMaxObstacles(unsigned maxObstacles) { maxObstacles_ = maxObstacles; }
@@ -84,14 +87,30 @@ public:
     /// Return whether to draw Obstacles.
     bool GetDrawObstacles() const { return drawObstacles_; }
 
+    /// Set the time budget in milliseconds for rebuilding tiles affected by obstacle changes each frame. At least one batch of tiles is always rebuilt.
+    void SetTileUpdateMs(int ms) { tileUpdateMs_ = Max(ms, 0); }
+    /// Return the time budget in milliseconds for rebuilding tiles affected by obstacle changes each frame.
+    int GetTileUpdateMs() const { return tileUpdateMs_; }
+    /// Return number of tiles waiting to be rebuilt because of obstacle changes.
+    unsigned GetNumPendingTiles() const;
+    /// Return number of obstacle additions and removals not yet assigned to tiles.
+    unsigned GetNumPendingObstacleRequests() const;
+    /// Return number of tiles rebuilt because of obstacle changes on the last update.
+    unsigned GetNumUpdatedTiles() const { return numUpdatedTiles_; }
+
 protected:
     struct TileCacheData;
+    struct TileUpdate;
 
     /// Subscribe to events when assigned to a scene.
     virtual void OnSceneSet(Scene* scene);
     /// Trigger the tile cache to make updates to the nav mesh if necessary.
     void HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData);
 
+    /// Rebuild tiles affected by obstacle changes in batches using the worker threads until the time budget is exceeded. At least one batch is rebuilt.
+    void UpdateTiles(int maxMs);
+    /// Make room in the obstacle request queue, rebuilding tiles if necessary.
+    void FlushObstacleRequests();
     /// Used by Obstacle class to add itself to the tile cache, if 'silent' an event will not be raised.
     void AddObstacle(Obstacle* obstacle, bool silent = false);
     /// Used by Obstacle class to update itself.
@@ -118,6 +137,14 @@ private:
     UniquePtr<dtTileCacheCompressor> compressor_;
     /// Mesh processor used by Detour, in this case a 'pass-through' processor.
     UniquePtr<dtTileCacheMeshProcess> meshProcessor_;
+    /// Tile cache allocators of the worker threads.
+    PODVector<dtTileCacheAlloc*> threadAllocators_;
+    /// Tiles of the batch being rebuilt.
+    PODVector<TileUpdate> tileUpdates_;
+    /// Time budget in milliseconds for rebuilding tiles each frame.
+    int tileUpdateMs_;
+    /// Number of tiles rebuilt on the last update.
+    unsigned numUpdatedTiles_;
     /// Maximum number of obstacle objects allowed.
     unsigned maxObstacles_;
     /// Maximum number of layers that are allowed to be constructed.
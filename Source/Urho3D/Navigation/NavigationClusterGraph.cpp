@@ -0,0 +1,413 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Container/HashSet.h"
+#include "../Navigation/NavigationClusterGraph.h"
+
+#include <Detour/DetourNavMesh.h>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned char NO_CLUSTER = 0xff;
+static const int MAX_LAYERS_PER_TILE = 32;
+
+/// A* open list entry.
+struct ClusterSearchOpen
+{
+    /// Cost so far plus the heuristic to the goal.
+    float total_;
+    /// Cluster ID.
+    unsigned id_;
+};
+
+static inline unsigned MakeClusterID(unsigned tileIndex, unsigned cluster)
+{
+    return (tileIndex << 8) | cluster;
+}
+
+static void PushOpen(PODVector<ClusterSearchOpen>& heap, const ClusterSearchOpen& entry)
+{
+    heap.Push(entry);
+    unsigned i = heap.Size() - 1;
+    while (i)
+    {
+        unsigned parent = (i - 1) / 2;
+        if (heap[parent].total_ <= heap[i].total_)
+            break;
+        Swap(heap[parent], heap[i]);
+        i = parent;
+    }
+}
+
+static ClusterSearchOpen PopOpen(PODVector<ClusterSearchOpen>& heap)
+{
+    ClusterSearchOpen top = heap[0];
+    heap[0] = heap.Back();
+    heap.Pop();
+
+    unsigned i = 0;
+    for (;;)
+    {
+        unsigned smallest = i;
+        unsigned left = i * 2 + 1;
+        unsigned right = left + 1;
+        if (left < heap.Size() && heap[left].total_ < heap[smallest].total_)
+            smallest = left;
+        if (right < heap.Size() && heap[right].total_ < heap[smallest].total_)
+            smallest = right;
+        if (smallest == i)
+            break;
+        Swap(heap[smallest], heap[i]);
+        i = smallest;
+    }
+
+    return top;
+}
+
+static void AddNeighbourTiles(HashSet<unsigned>& dest, const dtNavMesh* navMesh, int x, int y)
+{
+    const dtMeshTile* tiles[MAX_LAYERS_PER_TILE];
+
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            int numTiles = navMesh->getTilesAt(x + dx, y + dy, tiles, MAX_LAYERS_PER_TILE);
+            for (int i = 0; i < numTiles; ++i)
+                dest.Insert(navMesh->decodePolyIdTile(navMesh->getTileRef(tiles[i])));
+        }
+    }
+}
+
+NavigationClusterGraph::NavigationClusterGraph(const dtNavMesh* navMesh) :
+    navMesh_(navMesh),
+    numSearches_(0)
+{
+}
+
+unsigned NavigationClusterGraph::Update()
+{
+    unsigned maxTiles = (unsigned)navMesh_->getMaxTiles();
+    if (tiles_.Size() != maxTiles)
+    {
+        tiles_.Clear();
+        tiles_.Resize(maxTiles);
+    }
+
+    // Tile salt is incremented whenever a tile is removed, so compare it to detect rebuilt tiles
+    PODVector<unsigned> changedTiles;
+    for (unsigned i = 0; i < maxTiles; ++i)
+    {
+        const dtMeshTile* tile = navMesh_->getTile(i);
+        unsigned salt = tile->header ? tile->salt : 0;
+        if (salt != tiles_[i].salt_)
+            changedTiles.Push(i);
+    }
+
+    if (changedTiles.Empty())
+        return 0;
+
+    // The connections of the neighbour tiles must also be rebuilt, both at the old and the new tile location
+    HashSet<unsigned> edgeTiles;
+    for (unsigned i = 0; i < changedTiles.Size(); ++i)
+    {
+        TileClusters& tileClusters = tiles_[changedTiles[i]];
+        if (tileClusters.salt_)
+            AddNeighbourTiles(edgeTiles, navMesh_, tileClusters.x_, tileClusters.y_);
+
+        BuildClusters(changedTiles[i]);
+
+        if (tileClusters.salt_)
+            AddNeighbourTiles(edgeTiles, navMesh_, tileClusters.x_, tileClusters.y_);
+        edgeTiles.Insert(changedTiles[i]);
+    }
+
+    for (HashSet<unsigned>::ConstIterator i = edgeTiles.Begin(); i != edgeTiles.End(); ++i)
+        BuildEdges(*i);
+
+    // Reassign the search state array, clearing any stale state
+    unsigned numClusters = 0;
+    for (unsigned i = 0; i < maxTiles; ++i)
+    {
+        tiles_[i].firstIndex_ = numClusters;
+        numClusters += tiles_[i].clusters_.Size();
+    }
+    searchNodes_.Resize(numClusters);
+    for (unsigned i = 0; i < numClusters; ++i)
+        searchNodes_[i].search_ = 0;
+    numSearches_ = 0;
+
+    return changedTiles.Size();
+}
+
+bool NavigationClusterGraph::FindPath(PODVector<unsigned>& clusters, PODVector<Vector3>& portals, unsigned startCluster,
+    unsigned endCluster)
+{
+    clusters.Clear();
+    portals.Clear();
+
+    const NavigationCluster* start = GetCluster(startCluster);
+    const NavigationCluster* end = GetCluster(endCluster);
+    if (!start || !end)
+        return false;
+
+    const Vector3& goal = end->center_;
+    PODVector<ClusterSearchOpen> open;
+    ++numSearches_;
+
+    SearchNode& startNode = searchNodes_[GetSearchIndex(startCluster)];
+    startNode.parent_ = M_MAX_UNSIGNED;
+    startNode.cost_ = 0.0f;
+    startNode.search_ = numSearches_;
+    startNode.closed_ = false;
+
+    ClusterSearchOpen startEntry;
+    startEntry.total_ = (start->center_ - goal).Length();
+    startEntry.id_ = startCluster;
+    PushOpen(open, startEntry);
+
+    bool found = false;
+    while (!open.Empty())
+    {
+        ClusterSearchOpen current = PopOpen(open);
+        SearchNode& currentNode = searchNodes_[GetSearchIndex(current.id_)];
+        // Skip stale open list entries of clusters that were reached more cheaply since
+        if (currentNode.closed_)
+            continue;
+        currentNode.closed_ = true;
+
+        if (current.id_ == endCluster)
+        {
+            found = true;
+            break;
+        }
+
+        const NavigationCluster* cluster = GetCluster(current.id_);
+        for (unsigned i = 0; i < cluster->edges_.Size(); ++i)
+        {
+            const NavigationClusterEdge& edge = cluster->edges_[i];
+            float cost = currentNode.cost_ + edge.cost_;
+
+            SearchNode& node = searchNodes_[GetSearchIndex(edge.target_)];
+            if (node.search_ == numSearches_ && (node.closed_ || cost >= node.cost_))
+                continue;
+            node.parent_ = current.id_;
+            node.cost_ = cost;
+            node.search_ = numSearches_;
+            node.closed_ = false;
+
+            ClusterSearchOpen entry;
+            entry.total_ = cost + (GetCluster(edge.target_)->center_ - goal).Length();
+            entry.id_ = edge.target_;
+            PushOpen(open, entry);
+        }
+    }
+
+    if (!found)
+        return false;
+
+    for (unsigned id = endCluster; id != M_MAX_UNSIGNED; id = searchNodes_[GetSearchIndex(id)].parent_)
+        clusters.Push(id);
+    for (unsigned i = 0; i < clusters.Size() / 2; ++i)
+        Swap(clusters[i], clusters[clusters.Size() - 1 - i]);
+
+    for (unsigned i = 0; i + 1 < clusters.Size(); ++i)
+    {
+        const NavigationCluster* cluster = GetCluster(clusters[i]);
+        for (unsigned j = 0; j < cluster->edges_.Size(); ++j)
+        {
+            if (cluster->edges_[j].target_ == clusters[i + 1])
+            {
+                portals.Push(cluster->edges_[j].portal_);
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+unsigned NavigationClusterGraph::GetClusterID(dtPolyRef polyRef) const
+{
+    unsigned salt, tileIndex, polyIndex;
+    navMesh_->decodePolyId(polyRef, salt, tileIndex, polyIndex);
+    if (tileIndex >= tiles_.Size())
+        return M_MAX_UNSIGNED;
+
+    const TileClusters& tileClusters = tiles_[tileIndex];
+    if (tileClusters.salt_ != salt || polyIndex >= tileClusters.polyClusters_.Size() ||
+        tileClusters.polyClusters_[polyIndex] == NO_CLUSTER)
+        return M_MAX_UNSIGNED;
+
+    return MakeClusterID(tileIndex, tileClusters.polyClusters_[polyIndex]);
+}
+
+const NavigationCluster* NavigationClusterGraph::GetCluster(unsigned id) const
+{
+    unsigned tileIndex = id >> 8;
+    unsigned cluster = id & 0xff;
+    return tileIndex < tiles_.Size() && cluster < tiles_[tileIndex].clusters_.Size() ? &tiles_[tileIndex].clusters_[cluster] : 0;
+}
+
+unsigned NavigationClusterGraph::GetNumClusters() const
+{
+    unsigned numClusters = 0;
+    for (unsigned i = 0; i < tiles_.Size(); ++i)
+        numClusters += tiles_[i].clusters_.Size();
+    return numClusters;
+}
+
+void NavigationClusterGraph::BuildClusters(unsigned tileIndex)
+{
+    TileClusters& tileClusters = tiles_[tileIndex];
+    tileClusters.clusters_.Clear();
+    tileClusters.polyClusters_.Clear();
+
+    const dtMeshTile* tile = navMesh_->getTile(tileIndex);
+    if (!tile->header)
+    {
+        tileClusters.salt_ = 0;
+        return;
+    }
+
+    tileClusters.salt_ = tile->salt;
+    tileClusters.x_ = tile->header->x;
+    tileClusters.y_ = tile->header->y;
+
+    int polyCount = tile->header->polyCount;
+    tileClusters.polyClusters_.Resize(polyCount);
+    for (int i = 0; i < polyCount; ++i)
+        tileClusters.polyClusters_[i] = NO_CLUSTER;
+
+    // Flood fill the polygons through the links inside the tile. Polygons beyond the cluster limit are left out of the
+    // graph, and paths starting or ending in them fall back to a polygon search
+    PODVector<unsigned> stack;
+    for (int i = 0; i < polyCount && tileClusters.clusters_.Size() < NO_CLUSTER; ++i)
+    {
+        if (tileClusters.polyClusters_[i] != NO_CLUSTER)
+            continue;
+
+        unsigned char clusterIndex = (unsigned char)tileClusters.clusters_.Size();
+        Vector3 centerSum;
+        unsigned numPolys = 0;
+
+        tileClusters.polyClusters_[i] = clusterIndex;
+        stack.Push((unsigned)i);
+        while (!stack.Empty())
+        {
+            unsigned polyIndex = stack.Back();
+            stack.Pop();
+
+            const dtPoly& poly = tile->polys[polyIndex];
+            Vector3 polyCenter;
+            for (unsigned j = 0; j < poly.vertCount; ++j)
+                polyCenter += Vector3(&tile->verts[poly.verts[j] * 3]);
+            centerSum += polyCenter / (float)poly.vertCount;
+            ++numPolys;
+
+            for (unsigned k = poly.firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+            {
+                unsigned salt, neighbourTile, neighbourPoly;
+                navMesh_->decodePolyId(tile->links[k].ref, salt, neighbourTile, neighbourPoly);
+                if (neighbourTile == tileIndex && tileClusters.polyClusters_[neighbourPoly] == NO_CLUSTER)
+                {
+                    tileClusters.polyClusters_[neighbourPoly] = clusterIndex;
+                    stack.Push(neighbourPoly);
+                }
+            }
+        }
+
+        NavigationCluster cluster;
+        cluster.center_ = centerSum / (float)numPolys;
+        tileClusters.clusters_.Push(cluster);
+    }
+}
+
+void NavigationClusterGraph::BuildEdges(unsigned tileIndex)
+{
+    TileClusters& tileClusters = tiles_[tileIndex];
+    for (unsigned i = 0; i < tileClusters.clusters_.Size(); ++i)
+        tileClusters.clusters_[i].edges_.Clear();
+
+    const dtMeshTile* tile = navMesh_->getTile(tileIndex);
+    if (!tile->header)
+        return;
+
+    for (unsigned i = 0; i < tileClusters.polyClusters_.Size(); ++i)
+    {
+        unsigned char clusterIndex = tileClusters.polyClusters_[i];
+        if (clusterIndex == NO_CLUSTER)
+            continue;
+
+        NavigationCluster& cluster = tileClusters.clusters_[clusterIndex];
+        const dtPoly& poly = tile->polys[i];
+
+        for (unsigned k = poly.firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+        {
+            const dtLink& link = tile->links[k];
+            unsigned salt, neighbourTile, neighbourPoly;
+            navMesh_->decodePolyId(link.ref, salt, neighbourTile, neighbourPoly);
+            if (neighbourTile == tileIndex || neighbourTile >= tiles_.Size())
+                continue;
+
+            const TileClusters& neighbourClusters = tiles_[neighbourTile];
+            if (neighbourPoly >= neighbourClusters.polyClusters_.Size() ||
+                neighbourClusters.polyClusters_[neighbourPoly] == NO_CLUSTER)
+                continue;
+
+            unsigned target = MakeClusterID(neighbourTile, neighbourClusters.polyClusters_[neighbourPoly]);
+            bool exists = false;
+            for (unsigned j = 0; j < cluster.edges_.Size(); ++j)
+            {
+                if (cluster.edges_[j].target_ == target)
+                {
+                    exists = true;
+                    break;
+                }
+            }
+            if (exists)
+                continue;
+
+            // The portal is the middle of the shared polygon edge, or the connection end point for off-mesh connections
+            NavigationClusterEdge edge;
+            edge.target_ = target;
+            if (poly.getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+                edge.portal_ = Vector3(&tile->verts[poly.verts[link.edge] * 3]);
+            else
+            {
+                Vector3 v0(&tile->verts[poly.verts[link.edge] * 3]);
+                Vector3 v1(&tile->verts[poly.verts[(link.edge + 1) % poly.vertCount] * 3]);
+                edge.portal_ = (v0 + v1) * 0.5f;
+            }
+            const Vector3& targetCenter = neighbourClusters.clusters_[neighbourClusters.polyClusters_[neighbourPoly]].center_;
+            edge.cost_ = (edge.portal_ - cluster.center_).Length() + (targetCenter - edge.portal_).Length();
+            cluster.edges_.Push(edge);
+        }
+    }
+}
+
+}
@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Math/Vector3.h"
+
+#ifdef DT_POLYREF64
+typedef uint64_t dtPolyRef;
+#else
+typedef unsigned int dtPolyRef;
+#endif
+
+class dtNavMesh;
+
+namespace Urho3D
+{
+
+/// Connection from a navigation cluster to a cluster in a neighbouring tile.
+struct URHO3D_API NavigationClusterEdge
+{
+    /// Target cluster ID.
+    unsigned target_;
+    /// Portal point between the clusters in navigation mesh local space.
+    Vector3 portal_;
+    /// Estimated cost of moving from the cluster center through the portal to the target cluster center.
+    float cost_;
+};
+
+/// Connected group of polygons within one navigation mesh tile.
+struct URHO3D_API NavigationCluster
+{
+    /// Average of the polygon centers in navigation mesh local space.
+    Vector3 center_;
+    /// Connections to clusters in neighbouring tiles.
+    PODVector<NavigationClusterEdge> edges_;
+};
+
+/// Abstract graph of the polygon clusters of a tiled navigation mesh for hierarchical path finding. Each tile is split into its connected polygon groups, which are linked to the groups of the neighbouring tiles they connect to.
+class URHO3D_API NavigationClusterGraph
+{
+public:
+    /// Construct for a Detour navigation mesh.
+    NavigationClusterGraph(const dtNavMesh* navMesh);
+
+    /// Rebuild the clusters of tiles that have been added, removed or rebuilt since the last update, and the connections of their neighbours. Return number of tiles rebuilt.
+    unsigned Update();
+    /// Find a cluster path using A*. Return the clusters from start to end, and the portal points between consecutive clusters. Return true if a path was found.
+    bool FindPath(PODVector<unsigned>& clusters, PODVector<Vector3>& portals, unsigned startCluster, unsigned endCluster);
+
+    /// Return cluster ID of a polygon, or M_MAX_UNSIGNED if it does not belong to a cluster.
+    unsigned GetClusterID(dtPolyRef polyRef) const;
+    /// Return cluster by ID, or null if not found.
+    const NavigationCluster* GetCluster(unsigned id) const;
+    /// Return total number of clusters.
+    unsigned GetNumClusters() const;
+
+private:
+    /// Clusters of one tile.
+    struct TileClusters
+    {
+        /// Construct.
+        TileClusters() :
+            salt_(0),
+            x_(0),
+            y_(0),
+            firstIndex_(0)
+        {
+        }
+
+        /// Tile salt at the time the clusters were built, or zero if the tile was empty.
+        unsigned salt_;
+        /// Tile X coordinate.
+        int x_;
+        /// Tile Y coordinate.
+        int y_;
+        /// Index of the first cluster in the search state array.
+        unsigned firstIndex_;
+        /// Clusters.
+        Vector<NavigationCluster> clusters_;
+        /// Cluster index of each polygon.
+        PODVector<unsigned char> polyClusters_;
+    };
+
+    /// Rebuild the clusters of a tile.
+    void BuildClusters(unsigned tileIndex);
+    /// Rebuild the connections from the clusters of a tile.
+    void BuildEdges(unsigned tileIndex);
+    /// Return index of a cluster in the search state array.
+    unsigned GetSearchIndex(unsigned id) const { return tiles_[id >> 8].firstIndex_ + (id & 0xff); }
+
+    /// A* state of a cluster.
+    struct SearchNode
+    {
+        /// Parent cluster ID.
+        unsigned parent_;
+        /// Cost so far.
+        float cost_;
+        /// Number of the search that last visited the cluster. The state is stale if it differs from the current search.
+        unsigned search_;
+        /// Closed flag.
+        bool closed_;
+    };
+
+    /// Detour navigation mesh.
+    const dtNavMesh* navMesh_;
+    /// Clusters per tile, indexed like the navigation mesh tiles.
+    Vector<TileClusters> tiles_;
+    /// A* state of all clusters, reused between searches.
+    PODVector<SearchNode> searchNodes_;
+    /// Number of searches performed.
+    unsigned numSearches_;
+};
+
+}
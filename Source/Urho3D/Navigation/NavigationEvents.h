@@ -43,6 +43,15 @@ URHO3D_EVENT(E_NAVIGATION_AREA_REBUILT, NavigationAreaRebuilt)
     URHO3D_PARAM(P_BOUNDSMAX, BoundsMax); // Vector3
 }
 
+/// Batch of asynchronous navigation queries has been executed.
+URHO3D_EVENT(E_NAVIGATION_QUERIES_COMPLETED, NavigationQueriesCompleted)
+{
+    URHO3D_PARAM(P_NODE, Node); // Node pointer
+    URHO3D_PARAM(P_MESH, Mesh); // NavigationMesh pointer
+    URHO3D_PARAM(P_FIRSTID, FirstID); // unsigned
+    URHO3D_PARAM(P_NUMQUERIES, NumQueries); // unsigned
+}
+
 /// Crowd agent formation.
 URHO3D_EVENT(E_CROWD_AGENT_FORMATION, CrowdAgentFormation)
 {
@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/Geometry.h"
@@ -31,6 +32,7 @@
 #include "../Graphics/StaticModel.h"
 #include "../Graphics/TerrainPatch.h"
 #include "../Graphics/VertexBuffer.h"
+#include "../IO/File.h"
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
 #include "../Navigation/CrowdAgent.h"
@@ -38,14 +40,19 @@
 #include "../Navigation/NavArea.h"
 #include "../Navigation/NavBuildData.h"
 #include "../Navigation/Navigable.h"
+#include "../Navigation/NavigationClusterGraph.h"
 #include "../Navigation/NavigationEvents.h"
 #include "../Navigation/NavigationMesh.h"
+#include "../Navigation/NavigationTileRegion.h"
 #include "../Navigation/Obstacle.h"
 #include "../Navigation/OffMeshConnection.h"
 #ifdef URHO3D_PHYSICS
 #include "../Physics/CollisionShape.h"
 #endif
+#include "../Resource/ResourceCache.h"
+#include "../Resource/ResourceEvents.h"
 #include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
 
 #include <cfloat>
 #include <Detour/DetourNavMesh.h>
@@ -80,8 +87,12 @@ static const float DEFAULT_EDGE_MAX_LENGTH = 12.0f;
 static const float DEFAULT_EDGE_MAX_ERROR = 1.3f;
 static const float DEFAULT_DETAIL_SAMPLE_DISTANCE = 6.0f;
 static const float DEFAULT_DETAIL_SAMPLE_MAX_ERROR = 1.0f;
+static const int DEFAULT_TILE_REGION_SIZE = 4;
+static const float DEFAULT_STREAMING_LOAD_DISTANCE = 100.0f;
+static const float DEFAULT_STREAMING_UNLOAD_DISTANCE = 150.0f;
 
 static const int MAX_POLYS = 2048;
+static const int MAX_TILE_LAYERS = 255;
 
 
 /// Temporary data for finding a path.
@@ -103,6 +114,9 @@ NavigationMesh::NavigationMesh(Context* context) :
     navMeshQuery_(0),
     queryFilter_(new dtQueryFilter()),
     pathData_(new FindPathData()),
+    clusterGraphDirty_(true),
+    pendingQueriesID_(1),
+    completedQueriesID_(1),
     tileSize_(DEFAULT_TILE_SIZE),
     cellSize_(DEFAULT_CELL_SIZE),
     cellHeight_(DEFAULT_CELL_HEIGHT),
@@ -122,7 +136,10 @@ NavigationMesh::NavigationMesh(Context* context) :
     partitionType_(NAVMESH_PARTITION_WATERSHED),
     keepInterResults_(false),
     drawOffMeshConnections_(false),
-    drawNavAreas_(false)
+    drawNavAreas_(false),
+    tileRegionSize_(DEFAULT_TILE_REGION_SIZE),
+    streamingLoadDistance_(DEFAULT_STREAMING_LOAD_DISTANCE),
+    streamingUnloadDistance_(DEFAULT_STREAMING_UNLOAD_DISTANCE)
 {
 }
 
@@ -157,6 +174,12 @@ void NavigationMesh::RegisterObject(Context* context)
         NAVMESH_PARTITION_WATERSHED, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Draw OffMeshConnections", GetDrawOffMeshConnections, SetDrawOffMeshConnections, bool, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Draw NavAreas", GetDrawNavAreas, SetDrawNavAreas, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Tile Region Pattern", GetTileRegionPattern, SetTileRegionPattern, String, String::EMPTY, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Tile Region Size", GetTileRegionSize, SetTileRegionSize, int, DEFAULT_TILE_REGION_SIZE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Streaming Load Distance", GetStreamingLoadDistance, SetStreamingLoadDistance, float,
+        DEFAULT_STREAMING_LOAD_DISTANCE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Streaming Unload Distance", GetStreamingUnloadDistance, SetStreamingUnloadDistance, float,
+        DEFAULT_STREAMING_UNLOAD_DISTANCE, AM_DEFAULT);
 }
 
 void NavigationMesh::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
@@ -600,6 +623,426 @@ void NavigationMesh::FindPath(PODVector<NavigationPathPoint>& dest, const Vector
     }
 }
 
+void NavigationMesh::FindHierarchicalPath(PODVector<Vector3>& dest, const Vector3& start, const Vector3& end,
+    const Vector3& extents, const dtQueryFilter* filter, unsigned refineClusters)
+{
+    URHO3D_PROFILE(FindHierarchicalPath);
+    dest.Clear();
+
+    if (!InitializeQuery())
+        return;
+
+    const Matrix3x4& transform = node_->GetWorldTransform();
+    Matrix3x4 inverse = transform.Inverse();
+
+    Vector3 localStart = inverse * start;
+    Vector3 localEnd = inverse * end;
+    Vector3 nearestLocalEnd;
+
+    const dtQueryFilter* queryFilter = filter ? filter : queryFilter_.Get();
+    dtPolyRef startRef;
+    dtPolyRef endRef;
+    navMeshQuery_->findNearestPoly(&localStart.x_, &extents.x_, queryFilter, &startRef, 0);
+    navMeshQuery_->findNearestPoly(&localEnd.x_, &extents.x_, queryFilter, &endRef, &nearestLocalEnd.x_);
+
+    if (!startRef || !endRef)
+        return;
+
+    // Bring the cluster graph up to date with tiles rebuilt since the last query
+    if (!clusterGraph_)
+    {
+        clusterGraph_ = new NavigationClusterGraph(navMesh_);
+        clusterGraphDirty_ = true;
+    }
+    if (clusterGraphDirty_)
+    {
+        clusterGraph_->Update();
+        clusterGraphDirty_ = false;
+    }
+
+    // If the path does not extend beyond the clusters to refine, or the cluster search fails, use a normal polygon search
+    PODVector<unsigned> clusters;
+    PODVector<Vector3> portals;
+    refineClusters = Max(refineClusters, 1U);
+    unsigned startCluster = clusterGraph_->GetClusterID(startRef);
+    unsigned endCluster = clusterGraph_->GetClusterID(endRef);
+    if (startCluster == M_MAX_UNSIGNED || endCluster == M_MAX_UNSIGNED || startCluster == endCluster ||
+        !clusterGraph_->FindPath(clusters, portals, startCluster, endCluster) || clusters.Size() <= refineClusters)
+    {
+        FindPath(dest, start, end, extents, filter);
+        return;
+    }
+
+    // Refine the path to the portal leaving the last refined cluster, then continue through the remaining portals
+    FindPath(dest, start, transform * portals[refineClusters - 1], extents, filter);
+    if (dest.Empty())
+        return;
+
+    for (unsigned i = refineClusters; i < portals.Size(); ++i)
+        dest.Push(transform * portals[i]);
+    dest.Push(transform * nearestLocalEnd);
+}
+
+void NavigationQueryWork(const WorkItem* item, unsigned threadIndex)
+{
+    const NavigationMesh* navMesh = reinterpret_cast<NavigationMesh*>(item->aux_);
+    NavigationQuery* start = reinterpret_cast<NavigationQuery*>(item->start_);
+    NavigationQuery* end = reinterpret_cast<NavigationQuery*>(item->end_);
+
+    // Thread index 0 is the main thread, which uses the query object of the navigation mesh itself
+    dtNavMeshQuery* navMeshQuery = threadIndex ? navMesh->threadQueries_[threadIndex - 1] : navMesh->navMeshQuery_;
+    FindPathData* pathData = threadIndex ? navMesh->threadPathData_[threadIndex - 1] : navMesh->pathData_.Get();
+
+    while (start != end)
+        navMesh->ExecuteQuery(*start++, navMeshQuery, pathData);
+}
+
+void NavigationMesh::ExecuteQueries(Vector<NavigationQuery>& queries)
+{
+    URHO3D_PROFILE(ExecuteNavigationQueries);
+
+    if (queries.Empty())
+        return;
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned numThreads = queue->GetNumThreads();
+
+    if (!InitializeQuery() || !InitializeThreadQueries(numThreads))
+    {
+        for (unsigned i = 0; i < queries.Size(); ++i)
+        {
+            queries[i].success_ = false;
+            queries[i].path_.Clear();
+        }
+        return;
+    }
+
+    // The navigation mesh must not be modified while the queries are executing, which is guaranteed by waiting for
+    // completion here in the main thread
+    queryTransform_ = node_->GetWorldTransform();
+    queryInverseTransform_ = queryTransform_.Inverse();
+
+    int numWorkItems = numThreads + 1; // Worker threads + main thread
+    int queriesPerItem = queries.Size() / numWorkItems;
+
+    Vector<NavigationQuery>::Iterator start = queries.Begin();
+    for (int i = 0; i < numWorkItems; ++i)
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = NavigationQueryWork;
+        item->aux_ = this;
+
+        Vector<NavigationQuery>::Iterator end = queries.End();
+        if (i < numWorkItems - 1 && end - start > queriesPerItem)
+            end = start + queriesPerItem;
+
+        item->start_ = &(*start);
+        item->end_ = &(*end);
+        queue->AddWorkItem(item);
+
+        start = end;
+    }
+
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
+unsigned NavigationMesh::SubmitQuery(const NavigationQuery& query)
+{
+    pendingQueries_.Push(query);
+    UpdateEventSubscription();
+    return pendingQueriesID_ + pendingQueries_.Size() - 1;
+}
+
+const NavigationQuery* NavigationMesh::GetQueryResult(unsigned id) const
+{
+    unsigned index = id - completedQueriesID_;
+    return index < completedQueries_.Size() ? &completedQueries_[index] : 0;
+}
+
+static String GetTileRegionName(const String& pattern, const IntVector2& region)
+{
+    return pattern.Replaced("{x}", String(region.x_)).Replaced("{z}", String(region.y_));
+}
+
+static float GetTileRegionDistance(const IntVector2& region, const Vector3& position, float regionEdgeLength)
+{
+    Vector2 offset(
+        Max(Max(region.x_ * regionEdgeLength - position.x_, position.x_ - (region.x_ + 1) * regionEdgeLength), 0.0f),
+        Max(Max(region.y_ * regionEdgeLength - position.z_, position.z_ - (region.y_ + 1) * regionEdgeLength), 0.0f));
+    return offset.Length();
+}
+
+void NavigationMesh::SetTileRegionPattern(const String& pattern)
+{
+    if (pattern == tileRegionPattern_)
+        return;
+    if (!pattern.Empty() && !SupportsTileRegions())
+    {
+        URHO3D_LOGERROR(GetTypeName() + " does not support tile region streaming");
+        return;
+    }
+
+    UnloadAllTileRegions();
+    tileRegionPattern_ = pattern;
+    MarkNetworkUpdate();
+}
+
+void NavigationMesh::SetTileRegionSize(int size)
+{
+    size = Max(size, 1);
+    if (size == tileRegionSize_)
+        return;
+
+    UnloadAllTileRegions();
+    tileRegionSize_ = size;
+    MarkNetworkUpdate();
+}
+
+void NavigationMesh::SetStreamingLoadDistance(float distance)
+{
+    streamingLoadDistance_ = Max(distance, 0.0f);
+    streamingUnloadDistance_ = Max(streamingUnloadDistance_, streamingLoadDistance_);
+    MarkNetworkUpdate();
+}
+
+void NavigationMesh::SetStreamingUnloadDistance(float distance)
+{
+    streamingUnloadDistance_ = Max(distance, streamingLoadDistance_);
+    MarkNetworkUpdate();
+}
+
+void NavigationMesh::AddStreamingObserver(Node* node)
+{
+    if (!node)
+        return;
+    if (!SupportsTileRegions())
+    {
+        URHO3D_LOGERROR(GetTypeName() + " does not support tile region streaming");
+        return;
+    }
+
+    WeakPtr<Node> nodeWeak(node);
+    if (!streamingObservers_.Contains(nodeWeak))
+        streamingObservers_.Push(nodeWeak);
+
+    UpdateEventSubscription();
+}
+
+void NavigationMesh::RemoveStreamingObserver(Node* node)
+{
+    streamingObservers_.Remove(WeakPtr<Node>(node));
+    UpdateEventSubscription();
+}
+
+void NavigationMesh::RemoveAllStreamingObservers()
+{
+    streamingObservers_.Clear();
+    UpdateEventSubscription();
+}
+
+void NavigationMesh::UpdateTileRegions(const PODVector<Vector3>& worldPositions)
+{
+    if (!navMesh_ || !node_ || tileRegionPattern_.Empty() || !SupportsTileRegions())
+        return;
+
+    URHO3D_PROFILE(UpdateNavigationTileRegions);
+
+    // Use positions relative to the corner of the first tile in navigation mesh space
+    Matrix3x4 inverse = node_->GetWorldTransform().Inverse();
+    PODVector<Vector3> positions(worldPositions.Size());
+    for (unsigned i = 0; i < worldPositions.Size(); ++i)
+        positions[i] = inverse * worldPositions[i] - boundingBox_.min_;
+
+    float regionEdgeLength = (float)(tileSize_ * tileRegionSize_) * cellSize_;
+    IntVector2 numRegions = GetNumTileRegions();
+
+    // Unload tile regions beyond the unload distance from all positions
+    PODVector<IntVector2> unloadRegions;
+    for (HashMap<IntVector2, NavigationTileRegionState>::ConstIterator i = tileRegions_.Begin(); i != tileRegions_.End(); ++i)
+    {
+        if (i->second_.unloaded_)
+            continue;
+
+        float distance = M_INFINITY;
+        for (unsigned j = 0; j < positions.Size(); ++j)
+            distance = Min(distance, GetTileRegionDistance(i->first_, positions[j], regionEdgeLength));
+        if (distance > streamingUnloadDistance_)
+            unloadRegions.Push(i->first_);
+    }
+    for (unsigned i = 0; i < unloadRegions.Size(); ++i)
+        UnloadTileRegion(unloadRegions[i]);
+
+    // Load tile regions within the load distance
+    for (unsigned i = 0; i < positions.Size(); ++i)
+    {
+        const Vector3& position = positions[i];
+        int minX = Max(FloorToInt((position.x_ - streamingLoadDistance_) / regionEdgeLength), 0);
+        int maxX = Min(FloorToInt((position.x_ + streamingLoadDistance_) / regionEdgeLength), numRegions.x_ - 1);
+        int minZ = Max(FloorToInt((position.z_ - streamingLoadDistance_) / regionEdgeLength), 0);
+        int maxZ = Min(FloorToInt((position.z_ + streamingLoadDistance_) / regionEdgeLength), numRegions.y_ - 1);
+
+        for (int z = minZ; z <= maxZ; ++z)
+        {
+            for (int x = minX; x <= maxX; ++x)
+            {
+                IntVector2 region(x, z);
+                if (GetTileRegionDistance(region, position, regionEdgeLength) <= streamingLoadDistance_)
+                    LoadTileRegion(region);
+            }
+        }
+    }
+}
+
+bool NavigationMesh::LoadTileRegion(const IntVector2& region)
+{
+    if (!navMesh_ || tileRegionPattern_.Empty() || !SupportsTileRegions())
+        return false;
+
+    HashMap<IntVector2, NavigationTileRegionState>::Iterator i = tileRegions_.Find(region);
+    if (i != tileRegions_.End())
+    {
+        // If the region was unloaded during the background load, keep the tiles after all
+        i->second_.unloaded_ = false;
+        return true;
+    }
+
+    // A region whose resource fails to load stays in the map without tiles, so that loading is not retried until it has
+    // been unloaded
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    String name = GetTileRegionName(tileRegionPattern_, region);
+    NavigationTileRegionState& state = tileRegions_[region];
+
+    NavigationTileRegion* tileRegion = cache->GetExistingResource<NavigationTileRegion>(name);
+    if (!tileRegion && cache->BackgroundLoadResource<NavigationTileRegion>(name, true, 0))
+    {
+        // If threading is not available, the resource was loaded immediately
+        tileRegion = cache->GetExistingResource<NavigationTileRegion>(name);
+        if (!tileRegion)
+        {
+            state.loading_ = true;
+            SubscribeToEvent(cache, E_RESOURCEBACKGROUNDLOADED, URHO3D_HANDLER(NavigationMesh, HandleResourceBackgroundLoaded));
+            return true;
+        }
+    }
+
+    if (!tileRegion)
+        return false;
+
+    AddTileRegion(region, tileRegion);
+    return true;
+}
+
+void NavigationMesh::UnloadTileRegion(const IntVector2& region)
+{
+    HashMap<IntVector2, NavigationTileRegionState>::Iterator i = tileRegions_.Find(region);
+    if (i == tileRegions_.End())
+        return;
+
+    if (i->second_.loading_)
+        i->second_.unloaded_ = true;
+    else
+    {
+        tileRegions_.Erase(i);
+        RemoveTileRegion(region);
+    }
+}
+
+void NavigationMesh::UnloadAllTileRegions()
+{
+    Vector<IntVector2> regions = tileRegions_.Keys();
+    for (unsigned i = 0; i < regions.Size(); ++i)
+        UnloadTileRegion(regions[i]);
+}
+
+bool NavigationMesh::SaveTileRegions(const String& fileNamePattern) const
+{
+    if (!navMesh_)
+    {
+        URHO3D_LOGERROR("Navigation mesh must first be built before saving tile regions");
+        return false;
+    }
+
+    URHO3D_PROFILE(SaveNavigationTileRegions);
+
+    const dtNavMesh* navMesh = navMesh_;
+    const dtMeshTile* tiles[MAX_TILE_LAYERS];
+    IntVector2 numRegions = GetNumTileRegions();
+
+    // Also regions without tiles are saved, so that there are no missing resources when streaming
+    for (int rz = 0; rz < numRegions.y_; ++rz)
+    {
+        for (int rx = 0; rx < numRegions.x_; ++rx)
+        {
+            SharedPtr<NavigationTileRegion> tileRegion(new NavigationTileRegion(context_));
+
+            for (int z = rz * tileRegionSize_; z < Min((rz + 1) * tileRegionSize_, numTilesZ_); ++z)
+            {
+                for (int x = rx * tileRegionSize_; x < Min((rx + 1) * tileRegionSize_, numTilesX_); ++x)
+                {
+                    int numTiles = navMesh->getTilesAt(x, z, tiles, MAX_TILE_LAYERS);
+                    for (int i = 0; i < numTiles; ++i)
+                        tileRegion->AddTile(IntVector2(x, z), tiles[i]->data, (unsigned)tiles[i]->dataSize);
+                }
+            }
+
+            File file(context_, GetTileRegionName(fileNamePattern, IntVector2(rx, rz)), FILE_WRITE);
+            if (!file.IsOpen() || !tileRegion->Save(file))
+            {
+                URHO3D_LOGERROR("Failed to save navigation tile region " + file.GetName());
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+IntVector2 NavigationMesh::GetNumTileRegions() const
+{
+    return IntVector2((numTilesX_ + tileRegionSize_ - 1) / tileRegionSize_, (numTilesZ_ + tileRegionSize_ - 1) / tileRegionSize_);
+}
+
+IntVector2 NavigationMesh::GetTileRegion(const Vector3& position) const
+{
+    if (!node_)
+        return IntVector2::ZERO;
+
+    Vector3 localPosition = node_->GetWorldTransform().Inverse() * position - boundingBox_.min_;
+    float regionEdgeLength = (float)(tileSize_ * tileRegionSize_) * cellSize_;
+    return IntVector2(FloorToInt(localPosition.x_ / regionEdgeLength), FloorToInt(localPosition.z_ / regionEdgeLength));
+}
+
+bool NavigationMesh::IsTileRegionLoaded(const IntVector2& region) const
+{
+    HashMap<IntVector2, NavigationTileRegionState>::ConstIterator i = tileRegions_.Find(region);
+    return i != tileRegions_.End() && !i->second_.loading_;
+}
+
+unsigned NavigationMesh::GetNumLoadedTileRegions() const
+{
+    unsigned num = 0;
+    for (HashMap<IntVector2, NavigationTileRegionState>::ConstIterator i = tileRegions_.Begin(); i != tileRegions_.End(); ++i)
+    {
+        if (!i->second_.loading_)
+            ++num;
+    }
+
+    return num;
+}
+
+unsigned NavigationMesh::GetNumLoadingTileRegions() const
+{
+    unsigned num = 0;
+    for (HashMap<IntVector2, NavigationTileRegionState>::ConstIterator i = tileRegions_.Begin(); i != tileRegions_.End(); ++i)
+    {
+        if (i->second_.loading_ && !i->second_.unloaded_)
+            ++num;
+    }
+
+    return num;
+}
+
 Vector3 NavigationMesh::GetRandomPoint(const dtQueryFilter* filter, dtPolyRef* randomRef)
 {
     if (!InitializeQuery())
@@ -821,7 +1264,8 @@ PODVector<unsigned char> NavigationMesh::GetNavigationDataAttr() const
 
         const dtNavMesh* navMesh = navMesh_;
 
-        for (int z = 0; z < numTilesZ_; ++z)
+        // When streaming, the tiles are stored in the tile region resources instead
+        for (int z = 0; z < numTilesZ_ && tileRegionPattern_.Empty(); ++z)
         {
             for (int x = 0; x < numTilesX_; ++x)
             {
@@ -1147,6 +1591,7 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
 
     // Remove previous tile (if any)
     navMesh_->removeTile(navMesh_->getTileRefAt(x, z, 0), 0, 0);
+    clusterGraphDirty_ = true;
 
     float tileEdgeLength = (float)tileSize_ * cellSize_;
 
@@ -1380,6 +1825,252 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
     return true;
 }
 
+void NavigationMesh::OnSceneSet(Scene* scene)
+{
+    if (scene)
+        UpdateEventSubscription();
+    else
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+}
+
+void NavigationMesh::UpdateEventSubscription()
+{
+    // Subscribe only while there are queries to execute or tile regions to stream
+    Scene* scene = GetScene();
+    bool needUpdate = scene && (!pendingQueries_.Empty() || !streamingObservers_.Empty());
+
+    if (needUpdate && !HasSubscribedToEvent(scene, E_SCENEPOSTUPDATE))
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(NavigationMesh, HandleScenePostUpdate));
+    else if (!needUpdate && HasSubscribedToEvent(E_SCENEPOSTUPDATE))
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+}
+
+void NavigationMesh::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    if (!streamingObservers_.Empty())
+    {
+        PODVector<Vector3> positions;
+        for (Vector<WeakPtr<Node> >::Iterator i = streamingObservers_.Begin(); i != streamingObservers_.End();)
+        {
+            if (*i)
+            {
+                positions.Push((*i)->GetWorldPosition());
+                ++i;
+            }
+            else
+                i = streamingObservers_.Erase(i);
+        }
+
+        if (!positions.Empty())
+            UpdateTileRegions(positions);
+    }
+
+    if (!pendingQueries_.Empty())
+    {
+        // Move the pending queries to the completed list before executing, so that queries submitted from the event
+        // handlers below go to the next batch
+        completedQueries_.Clear();
+        completedQueries_.Swap(pendingQueries_);
+        completedQueriesID_ = pendingQueriesID_;
+        pendingQueriesID_ += completedQueries_.Size();
+
+        ExecuteQueries(completedQueries_);
+
+        using namespace NavigationQueriesCompleted;
+
+        VariantMap& completedData = GetEventDataMap();
+        completedData[P_NODE] = GetNode();
+        completedData[P_MESH] = this;
+        completedData[P_FIRSTID] = completedQueriesID_;
+        completedData[P_NUMQUERIES] = completedQueries_.Size();
+        SendEvent(E_NAVIGATION_QUERIES_COMPLETED, completedData);
+    }
+
+    UpdateEventSubscription();
+}
+
+void NavigationMesh::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ResourceBackgroundLoaded;
+
+    const String& name = eventData[P_RESOURCENAME].GetString();
+    bool loading = false;
+
+    for (HashMap<IntVector2, NavigationTileRegionState>::Iterator i = tileRegions_.Begin(); i != tileRegions_.End();)
+    {
+        NavigationTileRegionState& state = i->second_;
+        if (!state.loading_ || GetTileRegionName(tileRegionPattern_, i->first_) != name)
+        {
+            loading |= state.loading_;
+            ++i;
+            continue;
+        }
+
+        Resource* resource = static_cast<Resource*>(eventData[P_RESOURCE].GetPtr());
+        state.loading_ = false;
+
+        if (state.unloaded_)
+        {
+            i = tileRegions_.Erase(i);
+            GetSubsystem<ResourceCache>()->ReleaseResource<NavigationTileRegion>(name);
+        }
+        else
+        {
+            if (eventData[P_SUCCESS].GetBool() && resource && resource->GetType() == NavigationTileRegion::GetTypeStatic())
+                AddTileRegion(i->first_, static_cast<NavigationTileRegion*>(resource));
+            ++i;
+        }
+    }
+
+    if (!loading)
+        UnsubscribeFromEvent(GetSubsystem<ResourceCache>(), E_RESOURCEBACKGROUNDLOADED);
+}
+
+void NavigationMesh::AddTileRegion(const IntVector2& region, NavigationTileRegion* tileRegion)
+{
+    if (!navMesh_)
+        return;
+
+    URHO3D_PROFILE(AddNavigationTileRegion);
+
+    for (unsigned i = 0; i < tileRegion->GetNumTiles(); ++i)
+    {
+        const PODVector<unsigned char>& data = tileRegion->GetTileData(i);
+        const dtMeshHeader* header = reinterpret_cast<const dtMeshHeader*>(data.Buffer());
+        if (data.Size() < sizeof(dtMeshHeader) || header->magic != DT_NAVMESH_MAGIC || header->version != DT_NAVMESH_VERSION)
+        {
+            URHO3D_LOGERROR("Invalid navigation mesh tile in " + tileRegion->GetName());
+            continue;
+        }
+
+        unsigned char* navData = (unsigned char*)dtAlloc(data.Size(), DT_ALLOC_PERM);
+        if (!navData)
+        {
+            URHO3D_LOGERROR("Could not allocate data for navigation mesh tile");
+            break;
+        }
+        memcpy(navData, data.Buffer(), data.Size());
+
+        // Replace an existing tile, for example one from a full build
+        navMesh_->removeTile(navMesh_->getTileRefAt(header->x, header->y, header->layer), 0, 0);
+        if (dtStatusFailed(navMesh_->addTile(navData, data.Size(), DT_TILE_FREE_DATA, 0, 0)))
+        {
+            URHO3D_LOGERROR("Failed to add navigation mesh tile");
+            dtFree(navData);
+        }
+    }
+
+    clusterGraphDirty_ = true;
+
+    // The navigation mesh has its own copy of the tiles, so the resource is no longer needed
+    GetSubsystem<ResourceCache>()->ReleaseResource<NavigationTileRegion>(tileRegion->GetName());
+}
+
+void NavigationMesh::RemoveTileRegion(const IntVector2& region)
+{
+    if (!navMesh_)
+        return;
+
+    const dtMeshTile* tiles[MAX_TILE_LAYERS];
+
+    for (int z = region.y_ * tileRegionSize_; z < Min((region.y_ + 1) * tileRegionSize_, numTilesZ_); ++z)
+    {
+        for (int x = region.x_ * tileRegionSize_; x < Min((region.x_ + 1) * tileRegionSize_, numTilesX_); ++x)
+        {
+            int numTiles = navMesh_->getTilesAt(x, z, tiles, MAX_TILE_LAYERS);
+            for (int i = 0; i < numTiles; ++i)
+                navMesh_->removeTile(navMesh_->getTileRef(tiles[i]), 0, 0);
+        }
+    }
+
+    clusterGraphDirty_ = true;
+}
+
+void NavigationMesh::ExecuteQuery(NavigationQuery& query, dtNavMeshQuery* navMeshQuery, FindPathData* pathData) const
+{
+    query.success_ = false;
+    query.position_ = query.type_ == NAVQUERY_NEARESTPOINT ? query.start_ : query.end_;
+    query.normal_ = Vector3::DOWN;
+    query.path_.Clear();
+
+    Vector3 localStart = queryInverseTransform_ * query.start_;
+    Vector3 localEnd = queryInverseTransform_ * query.end_;
+
+    const dtQueryFilter* queryFilter = query.filter_ ? query.filter_ : queryFilter_.Get();
+    dtPolyRef startRef;
+    Vector3 nearestPoint;
+    navMeshQuery->findNearestPoly(&localStart.x_, &query.extents_.x_, queryFilter, &startRef, &nearestPoint.x_);
+    if (!startRef)
+        return;
+
+    switch (query.type_)
+    {
+    case NAVQUERY_FINDPATH:
+        {
+            dtPolyRef endRef;
+            navMeshQuery->findNearestPoly(&localEnd.x_, &query.extents_.x_, queryFilter, &endRef, 0);
+            if (!endRef)
+                return;
+
+            int numPolys = 0;
+            int numPathPoints = 0;
+
+            navMeshQuery->findPath(startRef, endRef, &localStart.x_, &localEnd.x_, queryFilter, pathData->polys_, &numPolys,
+                MAX_POLYS);
+            if (!numPolys)
+                return;
+
+            // If full path was not found, clamp end point to the end polygon
+            Vector3 actualLocalEnd = localEnd;
+            if (pathData->polys_[numPolys - 1] != endRef)
+                navMeshQuery->closestPointOnPoly(pathData->polys_[numPolys - 1], &localEnd.x_, &actualLocalEnd.x_, 0);
+
+            navMeshQuery->findStraightPath(&localStart.x_, &actualLocalEnd.x_, pathData->polys_, numPolys,
+                &pathData->pathPoints_[0].x_, pathData->pathFlags_, pathData->pathPolys_, &numPathPoints, MAX_POLYS);
+
+            query.path_.Resize((unsigned)numPathPoints);
+            for (int i = 0; i < numPathPoints; ++i)
+                query.path_[i] = queryTransform_ * pathData->pathPoints_[i];
+            query.success_ = numPathPoints > 0;
+        }
+        return;
+
+    case NAVQUERY_RAYCAST:
+        {
+            Vector3 normal;
+            float t;
+            int numPolys;
+
+            navMeshQuery->raycast(startRef, &localStart.x_, &localEnd.x_, queryFilter, &t, &normal.x_, pathData->polys_,
+                &numPolys, MAX_POLYS);
+            if (t == FLT_MAX)
+                t = 1.0f;
+            else
+                query.normal_ = (queryTransform_ * Vector4(normal, 0.0f)).Normalized();
+
+            query.position_ = query.start_.Lerp(query.end_, t);
+        }
+        break;
+
+    case NAVQUERY_NEARESTPOINT:
+        query.position_ = queryTransform_ * nearestPoint;
+        break;
+
+    case NAVQUERY_MOVEALONGSURFACE:
+        {
+            Vector3 resultPos;
+            int visitedCount = 0;
+
+            navMeshQuery->moveAlongSurface(startRef, &localStart.x_, &localEnd.x_, queryFilter, &resultPos.x_, pathData->polys_,
+                &visitedCount, MAX_POLYS);
+            query.position_ = queryTransform_ * resultPos;
+        }
+        break;
+    }
+
+    query.success_ = true;
+}
+
 bool NavigationMesh::InitializeQuery()
 {
     if (!navMesh_ || !node_)
@@ -1404,6 +2095,25 @@ bool NavigationMesh::InitializeQuery()
     return true;
 }
 
+bool NavigationMesh::InitializeThreadQueries(unsigned numThreads)
+{
+    while (threadQueries_.Size() < numThreads)
+    {
+        dtNavMeshQuery* navMeshQuery = dtAllocNavMeshQuery();
+        if (!navMeshQuery || dtStatusFailed(navMeshQuery->init(navMesh_, MAX_POLYS)))
+        {
+            dtFreeNavMeshQuery(navMeshQuery);
+            URHO3D_LOGERROR("Could not create navigation mesh query for worker thread");
+            return false;
+        }
+
+        threadQueries_.Push(navMeshQuery);
+        threadPathData_.Push(new FindPathData());
+    }
+
+    return true;
+}
+
 void NavigationMesh::ReleaseNavigationMesh()
 {
     dtFreeNavMesh(navMesh_);
@@ -1412,9 +2122,31 @@ void NavigationMesh::ReleaseNavigationMesh()
     dtFreeNavMeshQuery(navMeshQuery_);
     navMeshQuery_ = 0;
 
+    clusterGraph_.Reset();
+
+    for (unsigned i = 0; i < threadQueries_.Size(); ++i)
+    {
+        dtFreeNavMeshQuery(threadQueries_[i]);
+        delete threadPathData_[i];
+    }
+    threadQueries_.Clear();
+    threadPathData_.Clear();
+
     numTilesX_ = 0;
     numTilesZ_ = 0;
     boundingBox_.Clear();
+
+    // Tile regions still loading are kept, so that their resources can be released when the load finishes
+    for (HashMap<IntVector2, NavigationTileRegionState>::Iterator i = tileRegions_.Begin(); i != tileRegions_.End();)
+    {
+        if (i->second_.loading_)
+        {
+            i->second_.unloaded_ = true;
+            ++i;
+        }
+        else
+            i = tileRegions_.Erase(i);
+    }
 }
 
 void NavigationMesh::SetPartitionType(NavmeshPartitionType ptype)
@@ -1433,6 +2165,7 @@ void RegisterNavigationLibrary(Context* context)
     DynamicNavigationMesh::RegisterObject(context);
     Obstacle::RegisterObject(context);
     NavArea::RegisterObject(context);
+    NavigationTileRegion::RegisterObject(context);
 }
 
 }
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "../Container/ArrayPtr.h"
+#include "../Container/HashMap.h"
 #include "../Container/HashSet.h"
 #include "../Math/BoundingBox.h"
 #include "../Math/Matrix3x4.h"
@@ -49,9 +50,12 @@ enum NavmeshPartitionType
 
 class Geometry;
 class NavArea;
+class NavigationClusterGraph;
+class NavigationTileRegion;
 
 struct FindPathData;
 struct NavBuildData;
+struct WorkItem;
 
 /// Description of a navigation mesh geometry component, with transform and bounds information.
 struct NavigationGeometryInfo
@@ -86,12 +90,74 @@ struct URHO3D_API NavigationPathPoint
     unsigned char areaID_;
 };
 
+/// Type of a batched or asynchronous navigation query.
+enum NavigationQueryType
+{
+    NAVQUERY_FINDPATH = 0,
+    NAVQUERY_RAYCAST,
+    NAVQUERY_NEARESTPOINT,
+    NAVQUERY_MOVEALONGSURFACE
+};
+
+/// Batched or asynchronous navigation query, holding both the request and its result.
+struct URHO3D_API NavigationQuery
+{
+    /// Construct.
+    NavigationQuery() :
+        type_(NAVQUERY_FINDPATH),
+        start_(Vector3::ZERO),
+        end_(Vector3::ZERO),
+        extents_(Vector3::ONE),
+        filter_(0),
+        position_(Vector3::ZERO),
+        normal_(Vector3::DOWN),
+        success_(false)
+    {
+    }
+
+    /// Query type.
+    NavigationQueryType type_;
+    /// World-space start point, or the point for a nearest point query.
+    Vector3 start_;
+    /// World-space end point.
+    Vector3 end_;
+    /// How far off the navigation mesh the points can be.
+    Vector3 extents_;
+    /// Detour query filter, or null to use the default. Must not be modified while queries execute.
+    const dtQueryFilter* filter_;
+    /// Result position: raycast hit point, nearest point or position reached by moving along the surface.
+    Vector3 position_;
+    /// Result wall normal of a raycast.
+    Vector3 normal_;
+    /// Result path points of a path query.
+    PODVector<Vector3> path_;
+    /// Whether the query found its start point on the navigation mesh, and for a path query, a non-empty path.
+    bool success_;
+};
+
+/// Streaming state of a navigation mesh tile region.
+struct NavigationTileRegionState
+{
+    /// Construct.
+    NavigationTileRegionState() :
+        loading_(false),
+        unloaded_(false)
+    {
+    }
+
+    /// Background load in progress flag.
+    bool loading_;
+    /// Unloaded during the background load flag. The tiles are discarded when the load finishes.
+    bool unloaded_;
+};
+
 /// Navigation mesh component. Collects the navigation geometry from child nodes with the Navigable component and responds to path queries.
 class URHO3D_API NavigationMesh : public Component
 {
     URHO3D_OBJECT(NavigationMesh, Component);
 
     friend class CrowdManager;
+    friend void NavigationQueryWork(const WorkItem* item, unsigned threadIndex);
 
 public:
     /// Construct.
@@ -151,6 +217,9 @@ public:
     void FindPath
         (PODVector<NavigationPathPoint>& dest, const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE,
             const dtQueryFilter* filter = 0);
+    /// Find a long distance path between world space points by searching the graph of connected polygon clusters within tiles, and refining only the part through the first clusters to polygons. The rest of the path is returned as the portal points between clusters; query again as the near part is consumed. Return non-empty list of points if successful.
+    void FindHierarchicalPath(PODVector<Vector3>& dest, const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE,
+        const dtQueryFilter* filter = 0, unsigned refineClusters = 4);
     /// Return a random point on the navigation mesh.
     Vector3 GetRandomPoint(const dtQueryFilter* filter = 0, dtPolyRef* randomRef = 0);
     /// Return a random point on the navigation mesh within a circle. The circle radius is only a guideline and in practice the returned point may be further away.
@@ -165,6 +234,38 @@ public:
     Vector3 Raycast
         (const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE, const dtQueryFilter* filter = 0,
             Vector3* hitNormal = 0);
+    /// Execute a batch of queries, distributing them across the work queue threads with a Detour query object for each thread. Return when all have completed.
+    void ExecuteQueries(Vector<NavigationQuery>& queries);
+    /// Submit a query for asynchronous execution. Pending queries are executed as one batch on the next scene post-update, after which E_NAVIGATION_QUERIES_COMPLETED is sent. Return an ID for retrieving the result.
+    unsigned SubmitQuery(const NavigationQuery& query);
+    /// Return the result of an asynchronously executed query, or null if not executed yet. Results are kept until the next batch is executed.
+    const NavigationQuery* GetQueryResult(unsigned id) const;
+    /// Return number of submitted queries waiting for execution.
+    unsigned GetNumPendingQueries() const { return pendingQueries_.Size(); }
+    /// Set tile region resource name pattern for streaming. The strings {x} and {z} are replaced with the region coordinates. When set, the navigation data attribute stores only the navigation mesh parameters and the tiles are loaded by region.
+    void SetTileRegionPattern(const String& pattern);
+    /// Set number of tiles per tile region side. Unloads the loaded tile regions.
+    void SetTileRegionSize(int size);
+    /// Set distance from the streaming observers within which tile regions are loaded.
+    void SetStreamingLoadDistance(float distance);
+    /// Set distance from the streaming observers beyond which tile regions are unloaded. Is clamped to be at least the load distance.
+    void SetStreamingUnloadDistance(float distance);
+    /// Add a node around which tile regions are loaded.
+    void AddStreamingObserver(Node* node);
+    /// Remove a streaming observer node.
+    void RemoveStreamingObserver(Node* node);
+    /// Remove all streaming observer nodes. Loaded tile regions stay loaded.
+    void RemoveAllStreamingObservers();
+    /// Load and unload tile regions around positions given in world space. Called automatically on scene post-update when there are streaming observers.
+    void UpdateTileRegions(const PODVector<Vector3>& worldPositions);
+    /// Start loading a tile region in the background. Its tiles are added to the navigation mesh when loaded. Return true if the region is loaded or loading.
+    bool LoadTileRegion(const IntVector2& region);
+    /// Remove the tiles of a loaded tile region from the navigation mesh.
+    void UnloadTileRegion(const IntVector2& region);
+    /// Unload all tile regions.
+    void UnloadAllTileRegions();
+    /// Write the tiles of the navigation mesh into one file per tile region. The strings {x} and {z} in the file name pattern are replaced with the region coordinates. Return true if successful.
+    bool SaveTileRegions(const String& fileNamePattern) const;
     /// Add debug geometry to the debug renderer.
     void DrawDebugGeometry(bool depthTest);
 
@@ -231,6 +332,34 @@ public:
     /// Return number of tiles.
     IntVector2 GetNumTiles() const { return IntVector2(numTilesX_, numTilesZ_); }
 
+    /// Return tile region resource name pattern.
+    const String& GetTileRegionPattern() const { return tileRegionPattern_; }
+
+    /// Return number of tiles per tile region side.
+    int GetTileRegionSize() const { return tileRegionSize_; }
+
+    /// Return distance within which tile regions are loaded.
+    float GetStreamingLoadDistance() const { return streamingLoadDistance_; }
+
+    /// Return distance beyond which tile regions are unloaded.
+    float GetStreamingUnloadDistance() const { return streamingUnloadDistance_; }
+
+    /// Return number of streaming observer nodes.
+    unsigned GetNumStreamingObservers() const { return streamingObservers_.Size(); }
+
+    /// Return number of tile regions.
+    IntVector2 GetNumTileRegions() const;
+    /// Return tile region that contains a world space position.
+    IntVector2 GetTileRegion(const Vector3& position) const;
+    /// Return whether a tile region has been loaded.
+    bool IsTileRegionLoaded(const IntVector2& region) const;
+    /// Return number of loaded tile regions.
+    unsigned GetNumLoadedTileRegions() const;
+    /// Return number of tile regions still loading.
+    unsigned GetNumLoadingTileRegions() const;
+    /// Return whether tile regions can be streamed. False for navigation meshes that must keep the data of all tiles.
+    virtual bool SupportsTileRegions() const { return true; }
+
     /// Set the partition type used for polygon generation.
     void SetPartitionType(NavmeshPartitionType aType);
 
@@ -255,6 +384,20 @@ public:
     bool GetDrawNavAreas() const { return drawNavAreas_; }
 
 protected:
+    /// Handle scene being assigned.
+    virtual void OnSceneSet(Scene* scene);
+    /// Subscribe to scene post-update when there are pending queries or streaming observers, otherwise unsubscribe.
+    void UpdateEventSubscription();
+    /// Handle scene post-update to stream tile regions and execute the pending asynchronous queries.
+    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle resource background loading finished event.
+    void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
+    /// Add the tiles of a loaded tile region to the navigation mesh and release the region resource.
+    void AddTileRegion(const IntVector2& region, NavigationTileRegion* tileRegion);
+    /// Remove the tiles of a tile region from the navigation mesh.
+    void RemoveTileRegion(const IntVector2& region);
+    /// Execute one query with the Detour query object and temporary data of a thread.
+    void ExecuteQuery(NavigationQuery& query, dtNavMeshQuery* navMeshQuery, FindPathData* pathData) const;
     /// Collect geometry from under Navigable components.
     void CollectGeometries(Vector<NavigationGeometryInfo>& geometryList);
     /// Visit nodes and collect navigable geometry.
@@ -268,6 +411,8 @@ protected:
     virtual bool BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z);
     /// Ensure that the navigation mesh query is initialized. Return true if successful.
     bool InitializeQuery();
+    /// Ensure that the navigation mesh query of each worker thread is initialized. Return true if successful.
+    bool InitializeThreadQueries(unsigned numThreads);
     /// Release the navigation mesh and the query.
     virtual void ReleaseNavigationMesh();
 
@@ -281,6 +426,26 @@ protected:
     UniquePtr<dtQueryFilter> queryFilter_;
     /// Temporary data for finding a path.
     UniquePtr<FindPathData> pathData_;
+    /// Polygon cluster graph for hierarchical path finding. Created on first use.
+    UniquePtr<NavigationClusterGraph> clusterGraph_;
+    /// Whether tiles may have changed since the cluster graph was last updated.
+    bool clusterGraphDirty_;
+    /// Detour navigation mesh queries of the worker threads.
+    PODVector<dtNavMeshQuery*> threadQueries_;
+    /// Temporary data for finding a path in the worker threads.
+    PODVector<FindPathData*> threadPathData_;
+    /// World transform used by the executing batch of queries.
+    Matrix3x4 queryTransform_;
+    /// Inverse world transform used by the executing batch of queries.
+    Matrix3x4 queryInverseTransform_;
+    /// Queries waiting for asynchronous execution.
+    Vector<NavigationQuery> pendingQueries_;
+    /// Results of the last executed asynchronous batch.
+    Vector<NavigationQuery> completedQueries_;
+    /// ID of the first pending query.
+    unsigned pendingQueriesID_;
+    /// ID of the first completed query.
+    unsigned completedQueriesID_;
     /// Tile size.
     int tileSize_;
     /// Cell size.
@@ -325,6 +490,18 @@ protected:
     bool drawNavAreas_;
     /// NavAreas for this NavMesh
     Vector<WeakPtr<NavArea> > areas_;
+    /// Streaming observer nodes.
+    Vector<WeakPtr<Node> > streamingObservers_;
+    /// Loaded and loading tile regions.
+    HashMap<IntVector2, NavigationTileRegionState> tileRegions_;
+    /// Tile region resource name pattern.
+    String tileRegionPattern_;
+    /// Number of tiles per tile region side.
+    int tileRegionSize_;
+    /// Tile region load distance.
+    float streamingLoadDistance_;
+    /// Tile region unload distance.
+    float streamingUnloadDistance_;
 };
 
 /// Register Navigation library objects.
@@ -0,0 +1,124 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../IO/Deserializer.h"
+#include "../IO/Log.h"
+#include "../IO/Serializer.h"
+#include "../Navigation/NavigationTileRegion.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+NavigationTileRegion::NavigationTileRegion(Context* context) :
+    Resource(context)
+{
+}
+
+NavigationTileRegion::~NavigationTileRegion()
+{
+}
+
+void NavigationTileRegion::RegisterObject(Context* context)
+{
+    context->RegisterFactory<NavigationTileRegion>();
+}
+
+bool NavigationTileRegion::BeginLoad(Deserializer& source)
+{
+    Clear();
+
+    // Check ID
+    if (source.ReadFileID() != "UNTR")
+    {
+        URHO3D_LOGERROR(source.GetName() + " is not a valid navigation tile region file");
+        return false;
+    }
+
+    unsigned memoryUse = sizeof(NavigationTileRegion);
+    unsigned numTiles = source.ReadUInt();
+    tileIndices_.Reserve(numTiles);
+    tileData_.Reserve(numTiles);
+
+    for (unsigned i = 0; i < numTiles; ++i)
+    {
+        IntVector2 index = source.ReadIntVector2();
+        unsigned dataSize = source.ReadUInt();
+        if (source.GetSize() - source.GetPosition() < dataSize)
+        {
+            URHO3D_LOGERROR("Navigation tile region " + source.GetName() + " is truncated");
+            Clear();
+            return false;
+        }
+
+        tileIndices_.Push(index);
+        tileData_.Resize(tileData_.Size() + 1);
+        PODVector<unsigned char>& data = tileData_.Back();
+        data.Resize(dataSize);
+        if (dataSize)
+            source.Read(&data[0], dataSize);
+        memoryUse += dataSize;
+    }
+
+    SetMemoryUse(memoryUse);
+    return true;
+}
+
+bool NavigationTileRegion::Save(Serializer& dest) const
+{
+    if (!dest.WriteFileID("UNTR"))
+    {
+        URHO3D_LOGERROR("Can not save navigation tile region " + GetName());
+        return false;
+    }
+
+    dest.WriteUInt(tileIndices_.Size());
+    for (unsigned i = 0; i < tileIndices_.Size(); ++i)
+    {
+        const PODVector<unsigned char>& data = tileData_[i];
+        dest.WriteIntVector2(tileIndices_[i]);
+        dest.WriteUInt(data.Size());
+        if (data.Size())
+            dest.Write(&data[0], data.Size());
+    }
+
+    return true;
+}
+
+void NavigationTileRegion::AddTile(const IntVector2& index, const unsigned char* data, unsigned dataSize)
+{
+    tileIndices_.Push(index);
+    tileData_.Push(PODVector<unsigned char>(data, dataSize));
+}
+
+void NavigationTileRegion::Clear()
+{
+    tileIndices_.Clear();
+    tileData_.Clear();
+}
+
+}
@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Math/Vector2.h"
+#include "../Resource/Resource.h"
+
+namespace Urho3D
+{
+
+/// Serialized navigation mesh tiles of one tile region, used for streaming the navigation mesh.
+class URHO3D_API NavigationTileRegion : public Resource
+{
+    URHO3D_OBJECT(NavigationTileRegion, Resource);
+
+public:
+    /// Construct.
+    NavigationTileRegion(Context* context);
+    /// Destruct.
+    virtual ~NavigationTileRegion();
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Load resource from stream. May be called from a worker thread. Return true if successful.
+    virtual bool BeginLoad(Deserializer& source);
+    /// Save resource. Return true if successful.
+    virtual bool Save(Serializer& dest) const;
+
+    /// Add a tile with its Detour tile data.
+    void AddTile(const IntVector2& index, const unsigned char* data, unsigned dataSize);
+    /// Remove all tiles.
+    void Clear();
+
+    /// Return number of tiles.
+    unsigned GetNumTiles() const { return tileIndices_.Size(); }
+
+    /// Return tile index by tile number.
+    const IntVector2& GetTileIndex(unsigned index) const { return tileIndices_[index]; }
+
+    /// Return Detour tile data by tile number.
+    const PODVector<unsigned char>& GetTileData(unsigned index) const { return tileData_[index]; }
+
+private:
+    /// Tile indices.
+    PODVector<IntVector2> tileIndices_;
+    /// Detour tile data.
+    Vector<PODVector<unsigned char> > tileData_;
+};
+
+}
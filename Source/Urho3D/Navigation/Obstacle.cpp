@@ -124,6 +124,10 @@ void Obstacle::OnMarkedDirty(Node* node)
         if (!scene || scene->Refs() == 0)
             return;
 
+        // Interpolated transforms between scene fixed updates do not move the obstacle
+        if (scene->IsUpdatingInterpolation())
+            return;
+
         // If within threaded update, update later
         if (scene->IsThreadedUpdate())
         {
@@ -240,9 +240,13 @@ void PhysicsWorld::Update(float timeStep)
 {
     URHO3D_PROFILE(UpdatePhysics);
 
+    // When the scene runs fixed updates, step once per fixed update. The scene also does the interpolation, so Bullet's
+    // interpolation, which lags one step behind, is not used
+    bool sceneFixedUpdate = scene_ && scene_->GetFixedUpdateFps();
+
     float internalTimeStep = 1.0f / fps_;
     int maxSubSteps = (int)(timeStep * fps_) + 1;
-    if (maxSubSteps_ < 0)
+    if (maxSubSteps_ < 0 || sceneFixedUpdate)
     {
         internalTimeStep = timeStep;
         maxSubSteps = 1;
@@ -253,7 +257,7 @@ void PhysicsWorld::Update(float timeStep)
     delayedWorldTransforms_.Clear();
     simulating_ = true;
 
-    if (interpolation_)
+    if (interpolation_ && !sceneFixedUpdate)
         world_->stepSimulation(timeStep, maxSubSteps, internalTimeStep);
     else
     {
@@ -893,8 +893,12 @@ void RigidBody::OnMarkedDirty(Node* node)
     // (exception: initial setting of transform)
     if ((!kinematic_ || !hasSimulated_) && (!physicsWorld_ || !physicsWorld_->IsApplyingTransforms()) && !smoothedTransform_)
     {
-        // Physics operations are not safe from worker threads
+        // Interpolated transforms between scene fixed updates are not physical states either
         Scene* scene = GetScene();
+        if (scene && scene->IsUpdatingInterpolation())
+            return;
+
+        // Physics operations are not safe from worker threads
         if (scene && scene->IsThreadedUpdate())
         {
             scene->DelayedMarkedDirty(this);
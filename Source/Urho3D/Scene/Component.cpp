@@ -56,7 +56,8 @@ Component::Component(Context* context) :
     node_(0),
     id_(0),
     networkUpdate_(false),
-    enabled_(true)
+    enabled_(true),
+    typeIndex_(M_MAX_UNSIGNED)
 {
 }
 
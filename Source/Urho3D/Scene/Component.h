@@ -138,6 +138,10 @@ protected:
     bool networkUpdate_;
     /// Enabled flag.
     bool enabled_;
+
+private:
+    /// Index in the scene's array of components of the same type.
+    unsigned typeIndex_;
 };
 
 template <class T> T* Component::GetComponent() const { return static_cast<T*>(GetComponent(T::GetTypeStatic())); }
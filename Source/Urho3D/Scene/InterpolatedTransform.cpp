@@ -0,0 +1,167 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Scene/InterpolatedTransform.h"
+#include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* LOGIC_CATEGORY;
+
+InterpolatedTransform::InterpolatedTransform(Context* context) :
+    Component(context),
+    previousPosition_(Vector3::ZERO),
+    previousRotation_(Quaternion::IDENTITY),
+    currentPosition_(Vector3::ZERO),
+    currentRotation_(Quaternion::IDENTITY),
+    appliedPosition_(Vector3::ZERO),
+    appliedRotation_(Quaternion::IDENTITY),
+    interpolated_(false)
+{
+}
+
+InterpolatedTransform::~InterpolatedTransform()
+{
+}
+
+void InterpolatedTransform::RegisterObject(Context* context)
+{
+    context->RegisterFactory<InterpolatedTransform>(LOGIC_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, bool, true, AM_DEFAULT);
+}
+
+void InterpolatedTransform::OnSetEnabled()
+{
+    if (!IsEnabledEffective())
+        Restore();
+}
+
+void InterpolatedTransform::Store()
+{
+    if (!node_)
+        return;
+
+    Restore();
+
+    previousPosition_ = node_->GetPosition();
+    previousRotation_ = node_->GetRotation();
+}
+
+void InterpolatedTransform::Update(float factor)
+{
+    if (!node_)
+        return;
+
+    if (!interpolated_)
+    {
+        // The node has the simulated transform of the last fixed update
+        currentPosition_ = node_->GetPosition();
+        currentRotation_ = node_->GetRotation();
+    }
+    else if (!HasAppliedTransform())
+    {
+        // The node has been moved since it was interpolated, so snap to the new transform
+        previousPosition_ = currentPosition_ = node_->GetPosition();
+        previousRotation_ = currentRotation_ = node_->GetRotation();
+    }
+
+    if (factor >= 1.0f)
+    {
+        appliedPosition_ = currentPosition_;
+        appliedRotation_ = currentRotation_;
+    }
+    else
+    {
+        appliedPosition_ = previousPosition_.Lerp(currentPosition_, factor);
+        appliedRotation_ = previousRotation_.Slerp(currentRotation_, factor);
+    }
+
+    if (!HasAppliedTransform())
+        node_->SetTransform(appliedPosition_, appliedRotation_);
+    interpolated_ = true;
+}
+
+void InterpolatedTransform::Restore()
+{
+    if (!interpolated_)
+        return;
+
+    // Unless the node has been moved since it was interpolated, move it back to the simulated transform
+    if (node_ && HasAppliedTransform() && (currentPosition_ != appliedPosition_ || currentRotation_ != appliedRotation_))
+        node_->SetTransform(currentPosition_, currentRotation_);
+    interpolated_ = false;
+}
+
+void InterpolatedTransform::OnNodeSet(Node* node)
+{
+    if (node)
+    {
+        // Copy initial simulated transform
+        previousPosition_ = currentPosition_ = node->GetPosition();
+        previousRotation_ = currentRotation_ = node->GetRotation();
+    }
+    interpolated_ = false;
+}
+
+void InterpolatedTransform::OnSceneSet(Scene* scene)
+{
+    if (scene)
+    {
+        SubscribeToEvent(scene, E_STOREINTERPOLATION, URHO3D_HANDLER(InterpolatedTransform, HandleStoreInterpolation));
+        SubscribeToEvent(scene, E_UPDATEINTERPOLATION, URHO3D_HANDLER(InterpolatedTransform, HandleUpdateInterpolation));
+    }
+    else
+    {
+        UnsubscribeFromEvent(E_STOREINTERPOLATION);
+        UnsubscribeFromEvent(E_UPDATEINTERPOLATION);
+    }
+}
+
+bool InterpolatedTransform::HasAppliedTransform() const
+{
+    return node_->GetPosition() == appliedPosition_ && node_->GetRotation() == appliedRotation_;
+}
+
+void InterpolatedTransform::HandleStoreInterpolation(StringHash eventType, VariantMap& eventData)
+{
+    if (IsEnabledEffective())
+        Store();
+}
+
+void InterpolatedTransform::HandleUpdateInterpolation(StringHash eventType, VariantMap& eventData)
+{
+    using namespace UpdateInterpolation;
+
+    if (IsEnabledEffective())
+        Update(eventData[P_FACTOR].GetFloat());
+}
+
+}
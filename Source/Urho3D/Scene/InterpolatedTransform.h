@@ -0,0 +1,99 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Scene/Component.h"
+
+namespace Urho3D
+{
+
+/// Transform interpolation component for rendering between scene fixed updates.
+class URHO3D_API InterpolatedTransform : public Component
+{
+    URHO3D_OBJECT(InterpolatedTransform, Component);
+
+public:
+    /// Construct.
+    InterpolatedTransform(Context* context);
+    /// Destruct.
+    ~InterpolatedTransform();
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Handle enabled/disabled state change.
+    virtual void OnSetEnabled();
+
+    /// Restore the simulated transform and store it as the previous state. Called before each fixed update.
+    void Store();
+    /// Move the node between the previous and the current simulated transform. Called after the fixed updates of a frame.
+    void Update(float factor);
+    /// Move the node to the current simulated transform.
+    void Restore();
+
+    /// Return simulated position in parent space before the last fixed update.
+    const Vector3& GetPreviousPosition() const { return previousPosition_; }
+
+    /// Return simulated rotation in parent space before the last fixed update.
+    const Quaternion& GetPreviousRotation() const { return previousRotation_; }
+
+    /// Return simulated position in parent space after the last fixed update.
+    const Vector3& GetCurrentPosition() const { return currentPosition_; }
+
+    /// Return simulated rotation in parent space after the last fixed update.
+    const Quaternion& GetCurrentRotation() const { return currentRotation_; }
+
+    /// Return whether the node currently has an interpolated transform.
+    bool IsInterpolated() const { return interpolated_; }
+
+protected:
+    /// Handle scene node being assigned at creation.
+    virtual void OnNodeSet(Node* node);
+    /// Handle scene being assigned.
+    virtual void OnSceneSet(Scene* scene);
+
+private:
+    /// Return whether the node still has the interpolated transform, ie. it has not been moved by others since.
+    bool HasAppliedTransform() const;
+    /// Handle interpolation store event.
+    void HandleStoreInterpolation(StringHash eventType, VariantMap& eventData);
+    /// Handle interpolation update event.
+    void HandleUpdateInterpolation(StringHash eventType, VariantMap& eventData);
+
+    /// Simulated position before the last fixed update.
+    Vector3 previousPosition_;
+    /// Simulated rotation before the last fixed update.
+    Quaternion previousRotation_;
+    /// Simulated position after the last fixed update.
+    Vector3 currentPosition_;
+    /// Simulated rotation after the last fixed update.
+    Quaternion currentRotation_;
+    /// Last interpolated position set to the node.
+    Vector3 appliedPosition_;
+    /// Last interpolated rotation set to the node.
+    Quaternion appliedRotation_;
+    /// Node has an interpolated transform flag.
+    bool interpolated_;
+};
+
+}
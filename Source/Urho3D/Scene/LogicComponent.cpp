@@ -28,7 +28,6 @@
 #endif
 #include "../Scene/LogicComponent.h"
 #include "../Scene/Scene.h"
-#include "../Scene/SceneEvents.h"
 
 namespace Urho3D
 {
@@ -37,7 +36,8 @@ LogicComponent::LogicComponent(Context* context) :
     Component(context),
     updateEventMask_(USE_UPDATE | USE_POSTUPDATE | USE_FIXEDUPDATE | USE_FIXEDPOSTUPDATE),
     currentEventMask_(0),
-    delayedStartCalled_(false)
+    delayedStartCalled_(false),
+    sceneIndex_(M_MAX_UNSIGNED)
 {
 }
 
@@ -95,8 +95,7 @@ void LogicComponent::OnSceneSet(Scene* scene)
         UpdateEventSubscription();
     else
     {
-        UnsubscribeFromEvent(E_SCENEUPDATE);
-        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+        // The scene has already removed this component from its update array
 #if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
         UnsubscribeFromEvent(E_PHYSICSPRESTEP);
         UnsubscribeFromEvent(E_PHYSICSPOSTSTEP);
@@ -113,29 +112,23 @@ void LogicComponent::UpdateEventSubscription()
 
     bool enabled = IsEnabledEffective();
 
+    // Instead of subscribing to the scene update events, register to the scene's logic component update array
     bool needUpdate = enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_);
-    if (needUpdate && !(currentEventMask_ & USE_UPDATE))
-    {
-        SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_HANDLER(LogicComponent, HandleSceneUpdate));
+    if (needUpdate)
         currentEventMask_ |= USE_UPDATE;
-    }
-    else if (!needUpdate && (currentEventMask_ & USE_UPDATE))
-    {
-        UnsubscribeFromEvent(scene, E_SCENEUPDATE);
+    else
         currentEventMask_ &= ~USE_UPDATE;
-    }
 
     bool needPostUpdate = enabled && (updateEventMask_ & USE_POSTUPDATE);
-    if (needPostUpdate && !(currentEventMask_ & USE_POSTUPDATE))
-    {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(LogicComponent, HandleScenePostUpdate));
+    if (needPostUpdate)
         currentEventMask_ |= USE_POSTUPDATE;
-    }
-    else if (!needPostUpdate && (currentEventMask_ & USE_POSTUPDATE))
-    {
-        UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
+    else
         currentEventMask_ &= ~USE_POSTUPDATE;
-    }
+
+    if (currentEventMask_ & (USE_UPDATE | USE_POSTUPDATE))
+        scene->AddLogicComponent(this);
+    else
+        scene->RemoveLogicComponent(this);
 
 #if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
     Component* world = GetFixedUpdateSource();
@@ -168,35 +161,39 @@ void LogicComponent::UpdateEventSubscription()
 #endif
 }
 
-void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::DoUpdate(float timeStep)
 {
-    using namespace SceneUpdate;
+    if (!(currentEventMask_ & USE_UPDATE))
+        return;
 
     // Execute user-defined delayed start function before first update
     if (!delayedStartCalled_)
     {
         DelayedStart();
         delayedStartCalled_ = true;
+    }
 
-        // If did not need actual update events, unsubscribe now
-        if (!(updateEventMask_ & USE_UPDATE))
-        {
-            UnsubscribeFromEvent(GetScene(), E_SCENEUPDATE);
-            currentEventMask_ &= ~USE_UPDATE;
-            return;
-        }
+    // If did not need actual update calls, stop updating now
+    if (!(updateEventMask_ & USE_UPDATE))
+    {
+        currentEventMask_ &= ~USE_UPDATE;
+        Scene* scene = GetScene();
+        if (scene && !(currentEventMask_ & USE_POSTUPDATE))
+            scene->RemoveLogicComponent(this);
+        return;
     }
 
     // Then execute user-defined update function
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(timeStep);
 }
 
-void LogicComponent::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::DoPostUpdate(float timeStep)
 {
-    using namespace ScenePostUpdate;
+    if (!(currentEventMask_ & USE_POSTUPDATE))
+        return;
 
     // Execute user-defined post-update function
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
+    PostUpdate(timeStep);
 }
 
 #if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
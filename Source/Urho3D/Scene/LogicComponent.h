@@ -41,6 +41,8 @@ class URHO3D_API LogicComponent : public Component
 {
     URHO3D_OBJECT(LogicComponent, Component);
 
+    friend class Scene;
+
     /// Construct.
     LogicComponent(Context* context);
     /// Destruct.
@@ -83,12 +85,12 @@ protected:
     virtual void OnSceneSet(Scene* scene);
 
 private:
-    /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
+    /// Subscribe/unsubscribe to update events based on current enabled state and update event mask. Scene update and post-update are called by the scene directly.
     void UpdateEventSubscription();
-    /// Handle scene update event.
-    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
-    /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    /// Execute scene update. Called by Scene.
+    void DoUpdate(float timeStep);
+    /// Execute scene post-update. Called by Scene.
+    void DoPostUpdate(float timeStep);
 #if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
     /// Handle physics pre-step event.
     void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
@@ -101,6 +103,8 @@ private:
     unsigned char currentEventMask_;
     /// Flag for delayed start.
     bool delayedStartCalled_;
+    /// Index in the scene's logic component update array.
+    unsigned sceneIndex_;
 };
 
 }
@@ -51,6 +51,7 @@ Node::Node(Context* context) :
     dirty_(false),
     enabled_(true),
     enabledPrev_(true),
+    transformQueued_(false),
     networkUpdate_(false),
     parent_(0),
     scene_(0),
@@ -735,6 +736,10 @@ void Node::SetOwner(Connection* owner)
 
 void Node::MarkDirty()
 {
+    // Register the topmost node of a new dirty subtree for the scene's batched transform update
+    if (!dirty_ && scene_ && scene_->GetBatchedTransformUpdate() && (!parent_ || parent_ == scene_ || !parent_->dirty_))
+        scene_->MarkTransformDirty(this);
+
     Node *cur = this;
     for (;;)
     {
@@ -1431,6 +1436,8 @@ void Node::SetID(unsigned id)
 void Node::SetScene(Scene* scene)
 {
     scene_ = scene;
+    // A node removed while queued for the batched transform update is no longer found by the old scene to clear the flag
+    transformQueued_ = false;
 }
 
 void Node::ResetScene()
@@ -75,6 +75,7 @@ class URHO3D_API Node : public Animatable
     URHO3D_OBJECT(Node, Animatable);
 
     friend class Connection;
+    friend class Scene;
 
 public:
     /// Construct.
@@ -667,6 +668,8 @@ private:
     bool enabled_;
     /// Last SetEnabled flag before any SetDeepEnabled.
     bool enabledPrev_;
+    /// Queued for the scene's batched transform update flag. Also used as a collected mark during the update.
+    bool transformQueued_;
 
 protected:
     /// Network update queued flag.
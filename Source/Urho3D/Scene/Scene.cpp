@@ -34,6 +34,8 @@
 #include "../Resource/XMLFile.h"
 #include "../Resource/JSONFile.h"
 #include "../Scene/Component.h"
+#include "../Scene/InterpolatedTransform.h"
+#include "../Scene/LogicComponent.h"
 #include "../Scene/ObjectAnimation.h"
 #include "../Scene/ReplicationState.h"
 #include "../Scene/Scene.h"
@@ -54,6 +56,14 @@ const char* SUBSYSTEM_CATEGORY = "Subsystem";
 
 static const float DEFAULT_SMOOTHING_CONSTANT = 50.0f;
 static const float DEFAULT_SNAP_THRESHOLD = 5.0f;
+static const int DEFAULT_MAX_FIXED_UPDATES = 5;
+static const unsigned MIN_TRANSFORMS_PER_WORK_ITEM = 256;
+
+void UpdateTransformsWork(const WorkItem* item, unsigned threadIndex)
+{
+    Scene* scene = reinterpret_cast<Scene*>(item->aux_);
+    scene->UpdateTransforms((unsigned)(size_t)item->start_, (unsigned)(size_t)item->end_);
+}
 
 Scene::Scene(Context* context) :
     Node(context),
@@ -67,9 +77,17 @@ Scene::Scene(Context* context) :
     elapsedTime_(0),
     smoothingConstant_(DEFAULT_SMOOTHING_CONSTANT),
     snapThreshold_(DEFAULT_SNAP_THRESHOLD),
+    fixedUpdateFps_(0),
+    maxFixedUpdates_(DEFAULT_MAX_FIXED_UPDATES),
+    fixedUpdateAcc_(0.0f),
+    fixedUpdateInterpolation_(true),
+    batchedTransformUpdate_(false),
+    updatingInterpolation_(false),
     updateEnabled_(true),
     asyncLoading_(false),
-    threadedUpdate_(false)
+    threadedUpdate_(false),
+    updatingLogicComponents_(false),
+    logicComponentsDirty_(false)
 {
     // Assign an ID to self so that nodes can refer to this node as a parent
     SetID(GetFreeNodeID(REPLICATED));
@@ -102,6 +120,11 @@ void Scene::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Smoothing Constant", GetSmoothingConstant, SetSmoothingConstant, float, DEFAULT_SMOOTHING_CONSTANT,
         AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Snap Threshold", GetSnapThreshold, SetSnapThreshold, float, DEFAULT_SNAP_THRESHOLD, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Fixed Update FPS", GetFixedUpdateFps, SetFixedUpdateFps, int, 0, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Max Fixed Updates", GetMaxFixedUpdates, SetMaxFixedUpdates, int, DEFAULT_MAX_FIXED_UPDATES, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Fixed Update Interpolation", GetFixedUpdateInterpolation, SetFixedUpdateInterpolation, bool, true,
+        AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Batched Transform Update", GetBatchedTransformUpdate, SetBatchedTransformUpdate, bool, false, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Elapsed Time", GetElapsedTime, SetElapsedTime, float, 0.0f, AM_FILE);
     URHO3D_ATTRIBUTE("Next Replicated Node ID", unsigned, replicatedNodeID_, FIRST_REPLICATED_ID, AM_FILE | AM_NOEDIT);
     URHO3D_ATTRIBUTE("Next Replicated Component ID", unsigned, replicatedComponentID_, FIRST_REPLICATED_ID, AM_FILE | AM_NOEDIT);
@@ -664,6 +687,49 @@ void Scene::SetSnapThreshold(float threshold)
     Node::MarkNetworkUpdate();
 }
 
+void Scene::SetFixedUpdateFps(int fps)
+{
+    fps = Clamp(fps, 0, 1000);
+    if (fps == fixedUpdateFps_)
+        return;
+
+    // When fixed updates are turned off, move interpolated transforms to the latest fixed update for good
+    if (!fps && fixedUpdateFps_)
+        UpdateInterpolation(1.0f);
+
+    fixedUpdateFps_ = fps;
+    fixedUpdateAcc_ = 0.0f;
+    Node::MarkNetworkUpdate();
+}
+
+void Scene::SetMaxFixedUpdates(int num)
+{
+    maxFixedUpdates_ = Max(num, 1);
+    Node::MarkNetworkUpdate();
+}
+
+void Scene::SetFixedUpdateInterpolation(bool enable)
+{
+    fixedUpdateInterpolation_ = enable;
+    Node::MarkNetworkUpdate();
+}
+
+void Scene::SetBatchedTransformUpdate(bool enable)
+{
+    batchedTransformUpdate_ = enable;
+    if (!enable)
+    {
+        for (PODVector<unsigned>::ConstIterator i = dirtyTransformRoots_.Begin(); i != dirtyTransformRoots_.End(); ++i)
+        {
+            Node* node = GetNode(*i);
+            if (node)
+                node->transformQueued_ = false;
+        }
+        dirtyTransformRoots_.Clear();
+    }
+    Node::MarkNetworkUpdate();
+}
+
 void Scene::SetAsyncLoadingMs(int ms)
 {
     asyncLoadingMs_ = Max(ms, 1);
@@ -730,6 +796,33 @@ bool Scene::GetNodesWithTag(PODVector<Node*>& dest, const String& tag) const
         return false;
 }
 
+const PODVector<Component*>& Scene::GetComponentsByType(StringHash type) const
+{
+    static const PODVector<Component*> noComponents;
+
+    HashMap<StringHash, PODVector<Component*> >::ConstIterator i = componentsByType_.Find(type);
+    return i != componentsByType_.End() ? i->second_ : noComponents;
+}
+
+void Scene::GetComponentsByType(PODVector<Component*>& dest, StringHash type, bool derived) const
+{
+    dest.Clear();
+
+    if (!derived)
+    {
+        dest = GetComponentsByType(type);
+        return;
+    }
+
+    // All components in one array share the type, so checking the first is enough
+    for (HashMap<StringHash, PODVector<Component*> >::ConstIterator i = componentsByType_.Begin(); i != componentsByType_.End(); ++i)
+    {
+        const PODVector<Component*>& components = i->second_;
+        if (!components.Empty() && components.Front()->GetTypeInfo()->IsTypeOf(type))
+            dest.Push(components);
+    }
+}
+
 Component* Scene::GetComponent(unsigned id) const
 {
     if (id < FIRST_LOCAL_ID)
@@ -779,12 +872,41 @@ void Scene::Update(float timeStep)
 
     // Update variable timestep logic
     SendEvent(E_SCENEUPDATE, eventData);
+    UpdateLogicComponents(false, timeStep);
 
     // Update scene attribute animation.
     SendEvent(E_ATTRIBUTEANIMATIONUPDATE, eventData);
 
-    // Update scene subsystems. If a physics world is present, it will be updated, triggering fixed timestep logic updates
-    SendEvent(E_SCENESUBSYSTEMUPDATE, eventData);
+    if (!fixedUpdateFps_)
+    {
+        // Update scene subsystems. If a physics world is present, it will be updated, triggering fixed timestep logic updates
+        SendEvent(E_SCENESUBSYSTEMUPDATE, eventData);
+    }
+    else
+    {
+        // Run fixed updates to catch up with the frame time, then show the state between the last two of them
+        float fixedTimeStep = 1.0f / fixedUpdateFps_;
+        fixedUpdateAcc_ += timeStep;
+        // Allow for a little float inaccuracy so that a frame rate equal to the fixed update rate gives one update per frame
+        int numUpdates = (int)(fixedUpdateAcc_ * fixedUpdateFps_ + 0.001f);
+        if (numUpdates > maxFixedUpdates_)
+        {
+            fixedUpdateAcc_ -= (numUpdates - maxFixedUpdates_) * fixedTimeStep;
+            numUpdates = maxFixedUpdates_;
+        }
+
+        for (int i = 0; i < numUpdates; ++i)
+        {
+            FixedUpdate(fixedTimeStep);
+            fixedUpdateAcc_ -= fixedTimeStep;
+        }
+
+        UpdateInterpolation(fixedUpdateInterpolation_ ? GetFixedUpdateFactor() : 1.0f);
+
+        // The fixed updates reused the event data map
+        eventData[P_SCENE] = this;
+        eventData[P_TIMESTEP] = timeStep;
+    }
 
     // Update transform smoothing
     {
@@ -802,6 +924,7 @@ void Scene::Update(float timeStep)
 
     // Post-update variable timestep logic
     SendEvent(E_SCENEPOSTUPDATE, eventData);
+    UpdateLogicComponents(true, timeStep);
 
     // Note: using a float for elapsed time accumulation is inherently inaccurate. The purpose of this value is
     // primarily to update material animation effects, as it is available to shaders. It can be reset by calling
@@ -809,6 +932,38 @@ void Scene::Update(float timeStep)
     elapsedTime_ += timeStep;
 }
 
+void Scene::FixedUpdate(float timeStep)
+{
+    URHO3D_PROFILE(FixedUpdateScene);
+
+    // Restore the simulated transforms and store them as the previous state
+    updatingInterpolation_ = true;
+    SendEvent(E_STOREINTERPOLATION);
+    updatingInterpolation_ = false;
+
+    using namespace SceneFixedUpdate;
+
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_SCENE] = this;
+    eventData[P_TIMESTEP] = timeStep;
+
+    // Update fixed timestep logic, then the scene subsystems with the same timestep
+    SendEvent(E_SCENEFIXEDUPDATE, eventData);
+    SendEvent(E_SCENESUBSYSTEMUPDATE, eventData);
+}
+
+void Scene::UpdateInterpolation(float factor)
+{
+    URHO3D_PROFILE(UpdateInterpolation);
+
+    using namespace UpdateInterpolation;
+
+    interpolationData_[P_FACTOR] = factor;
+    updatingInterpolation_ = true;
+    SendEvent(E_UPDATEINTERPOLATION, interpolationData_);
+    updatingInterpolation_ = false;
+}
+
 void Scene::BeginThreadedUpdate()
 {
     // Check the work queue subsystem whether it actually has created worker threads. If not, do not enter threaded mode.
@@ -839,6 +994,142 @@ void Scene::DelayedMarkedDirty(Component* component)
     delayedDirtyComponents_.Push(component);
 }
 
+void Scene::MarkTransformDirty(Node* node)
+{
+    // Store the ID instead of a pointer, as the node may be destroyed before the update. A node that becomes dirty again
+    // after an on-demand update is only queued once
+    if (threadedUpdate_)
+    {
+        MutexLock lock(sceneMutex_);
+        if (!node->transformQueued_)
+        {
+            node->transformQueued_ = true;
+            dirtyTransformRoots_.Push(node->GetID());
+        }
+    }
+    else if (!node->transformQueued_)
+    {
+        node->transformQueued_ = true;
+        dirtyTransformRoots_.Push(node->GetID());
+    }
+}
+
+void Scene::UpdateTransforms()
+{
+    if (dirtyTransformRoots_.Empty())
+        return;
+
+    URHO3D_PROFILE(UpdateTransforms);
+
+    transformNodes_.Clear();
+    transformParents_.Clear();
+
+    // Unqueue the nodes first, so that the flag can mark the collected roots below
+    for (PODVector<unsigned>::ConstIterator i = dirtyTransformRoots_.Begin(); i != dirtyTransformRoots_.End(); ++i)
+    {
+        Node* node = GetNode(*i);
+        if (node)
+            node->transformQueued_ = false;
+    }
+
+    // Collect the roots of the dirty subtrees. A root may have become clean since, or have got a dirty parent, in which
+    // case it is collected as part of the parent's subtree. The scene's own transform does not affect its children, so
+    // when the scene is queued its dirty children are collected, and they may be queued themselves as well
+    for (PODVector<unsigned>::ConstIterator i = dirtyTransformRoots_.Begin(); i != dirtyTransformRoots_.End(); ++i)
+    {
+        Node* node = GetNode(*i);
+        if (!node || !node->dirty_)
+            continue;
+
+        if (node == this)
+        {
+            for (Vector<SharedPtr<Node> >::ConstIterator j = children_.Begin(); j != children_.End(); ++j)
+            {
+                Node* child = *j;
+                if (child->dirty_ && !child->transformQueued_)
+                {
+                    child->transformQueued_ = true;
+                    transformNodes_.Push(child);
+                }
+            }
+        }
+        else if ((node->parent_ == this || !node->parent_->dirty_) && !node->transformQueued_)
+        {
+            node->transformQueued_ = true;
+            transformNodes_.Push(node);
+        }
+    }
+    dirtyTransformRoots_.Clear();
+
+    transformWorldTransforms_.Resize(transformNodes_.Size());
+    transformWorldRotations_.Resize(transformNodes_.Size());
+    transformParents_.Resize(transformNodes_.Size());
+    for (unsigned i = 0; i < transformNodes_.Size(); ++i)
+    {
+        transformNodes_[i]->transformQueued_ = false;
+        transformWorldTransforms_[i] = transformNodes_[i]->GetWorldTransform();
+        transformWorldRotations_[i] = transformNodes_[i]->worldRotation_;
+        transformParents_[i] = M_MAX_UNSIGNED;
+    }
+
+    // Add the rest of the subtrees one depth level at a time, so that parents always come before their children. All
+    // children of a dirty node are dirty as well
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    unsigned levelStart = 0;
+    while (levelStart < transformNodes_.Size())
+    {
+        unsigned levelEnd = transformNodes_.Size();
+        for (unsigned i = levelStart; i < levelEnd; ++i)
+        {
+            const Vector<SharedPtr<Node> >& children = transformNodes_[i]->children_;
+            for (Vector<SharedPtr<Node> >::ConstIterator j = children.Begin(); j != children.End(); ++j)
+            {
+                if ((*j)->dirty_)
+                {
+                    transformNodes_.Push(*j);
+                    transformParents_.Push(i);
+                }
+            }
+        }
+
+        unsigned numNodes = transformNodes_.Size() - levelEnd;
+        if (!numNodes)
+            break;
+        transformWorldTransforms_.Resize(transformNodes_.Size());
+        transformWorldRotations_.Resize(transformNodes_.Size());
+
+        // The nodes of one level are independent of each other, so split large levels between the worker threads
+        unsigned numWorkItems = queue ? queue->GetNumThreads() + 1 : 1; // Worker threads + main thread
+        if (numWorkItems == 1 || numNodes < MIN_TRANSFORMS_PER_WORK_ITEM * 2)
+            UpdateTransforms(levelEnd, transformNodes_.Size());
+        else
+        {
+            numWorkItems = Min(numWorkItems, numNodes / MIN_TRANSFORMS_PER_WORK_ITEM);
+            unsigned nodesPerItem = numNodes / numWorkItems;
+
+            unsigned start = levelEnd;
+            for (unsigned i = 0; i < numWorkItems; ++i)
+            {
+                SharedPtr<WorkItem> item = queue->GetFreeItem();
+                item->priority_ = M_MAX_UNSIGNED;
+                item->workFunction_ = UpdateTransformsWork;
+                item->aux_ = this;
+
+                unsigned end = i < numWorkItems - 1 ? start + nodesPerItem : transformNodes_.Size();
+                item->start_ = (void*)(size_t)start;
+                item->end_ = (void*)(size_t)end;
+                queue->AddWorkItem(item);
+
+                start = end;
+            }
+
+            queue->Complete(M_MAX_UNSIGNED);
+        }
+
+        levelStart = levelEnd;
+    }
+}
+
 unsigned Scene::GetFreeNodeID(CreateMode mode)
 {
     if (mode == REPLICATED)
@@ -1046,6 +1337,13 @@ void Scene::ComponentAdded(Component* component)
         localComponents_[id] = component;
     }
 
+    if (component->typeIndex_ == M_MAX_UNSIGNED)
+    {
+        PODVector<Component*>& components = componentsByType_[component->GetType()];
+        component->typeIndex_ = components.Size();
+        components.Push(component);
+    }
+
     component->OnSceneSet(this);
 }
 
@@ -1060,10 +1358,106 @@ void Scene::ComponentRemoved(Component* component)
     else
         localComponents_.Erase(id);
 
+    // Swap the last component of the same type into the removed component's place
+    unsigned index = component->typeIndex_;
+    if (index != M_MAX_UNSIGNED)
+    {
+        PODVector<Component*>& components = componentsByType_[component->GetType()];
+        if (index < components.Size() && components[index] == component)
+        {
+            Component* last = components.Back();
+            components[index] = last;
+            last->typeIndex_ = index;
+            components.Pop();
+        }
+        component->typeIndex_ = M_MAX_UNSIGNED;
+    }
+
+    // The component can no longer find its scene through the node, so remove it from the logic update here
+    if (component->IsInstanceOf<LogicComponent>())
+        RemoveLogicComponent(static_cast<LogicComponent*>(component));
+
     component->SetID(0);
     component->OnSceneSet(0);
 }
 
+void Scene::AddLogicComponent(LogicComponent* component)
+{
+    if (!component || component->sceneIndex_ != M_MAX_UNSIGNED)
+        return;
+
+    // Components added during the update are appended, and will be updated from the next frame on
+    component->sceneIndex_ = logicComponents_.Size();
+    logicComponents_.Push(component);
+}
+
+void Scene::RemoveLogicComponent(LogicComponent* component)
+{
+    if (!component || component->sceneIndex_ == M_MAX_UNSIGNED)
+        return;
+
+    unsigned index = component->sceneIndex_;
+
+    // During the update only leave an empty slot so that the update loop does not skip components
+    if (updatingLogicComponents_)
+    {
+        logicComponents_[index] = 0;
+        logicComponentsDirty_ = true;
+    }
+    else
+    {
+        LogicComponent* last = logicComponents_.Back();
+        logicComponents_[index] = last;
+        last->sceneIndex_ = index;
+        logicComponents_.Pop();
+    }
+
+    component->sceneIndex_ = M_MAX_UNSIGNED;
+}
+
+void Scene::UpdateLogicComponents(bool postUpdate, float timeStep)
+{
+    if (logicComponents_.Empty())
+        return;
+
+    URHO3D_PROFILE(UpdateLogicComponents);
+
+    updatingLogicComponents_ = true;
+
+    unsigned numComponents = logicComponents_.Size();
+    for (unsigned i = 0; i < numComponents; ++i)
+    {
+        // The array may be reallocated by components being added during the update, so index it each time
+        LogicComponent* component = logicComponents_[i];
+        if (!component)
+            continue;
+
+        if (!postUpdate)
+            component->DoUpdate(timeStep);
+        else
+            component->DoPostUpdate(timeStep);
+    }
+
+    updatingLogicComponents_ = false;
+
+    // Compact the empty slots left by components removed during the update
+    if (logicComponentsDirty_)
+    {
+        unsigned dest = 0;
+        for (unsigned i = 0; i < logicComponents_.Size(); ++i)
+        {
+            LogicComponent* component = logicComponents_[i];
+            if (component)
+            {
+                component->sceneIndex_ = dest;
+                logicComponents_[dest++] = component;
+            }
+        }
+        logicComponents_.Resize(dest);
+        logicComponentsDirty_ = false;
+    }
+}
+
 void Scene::SetVarNamesAttr(const String& value)
 {
     Vector<String> varNames = value.Split(';');
@@ -1186,6 +1580,21 @@ void Scene::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eve
     }
 }
 
+void Scene::UpdateTransforms(unsigned start, unsigned end)
+{
+    for (unsigned i = start; i < end; ++i)
+    {
+        Node* node = transformNodes_[i];
+        unsigned parentIndex = transformParents_[i];
+
+        transformWorldTransforms_[i] = transformWorldTransforms_[parentIndex] * node->GetTransform();
+        transformWorldRotations_[i] = transformWorldRotations_[parentIndex] * node->rotation_;
+        node->worldTransform_ = transformWorldTransforms_[i];
+        node->worldRotation_ = transformWorldRotations_[i];
+        node->dirty_ = false;
+    }
+}
+
 void Scene::UpdateAsyncLoading()
 {
     URHO3D_PROFILE(UpdateAsyncLoading);
@@ -1535,6 +1944,7 @@ void RegisterSceneLibrary(Context* context)
     Node::RegisterObject(context);
     Scene::RegisterObject(context);
     SmoothedTransform::RegisterObject(context);
+    InterpolatedTransform::RegisterObject(context);
     UnknownComponent::RegisterObject(context);
     SplinePath::RegisterObject(context);
 }
@@ -33,7 +33,9 @@ namespace Urho3D
 {
 
 class File;
+class LogicComponent;
 class PackageFile;
+struct WorkItem;
 
 static const unsigned FIRST_REPLICATED_ID = 0x1;
 static const unsigned LAST_REPLICATED_ID = 0xffffff;
@@ -90,6 +92,8 @@ class URHO3D_API Scene : public Node
     using Node::SaveXML;
     using Node::SaveJSON;
 
+    friend void UpdateTransformsWork(const WorkItem* item, unsigned threadIndex);
+
 public:
     /// Construct.
     Scene(Context* context);
@@ -152,6 +156,14 @@ public:
     void SetSmoothingConstant(float constant);
     /// Set network client motion smoothing snap threshold.
     void SetSnapThreshold(float threshold);
+    /// Set fixed update rate per second. 0 (default) disables fixed updates and updates the scene subsystems with the frame timestep.
+    void SetFixedUpdateFps(int fps);
+    /// Set maximum fixed updates per frame. Time in excess of this is dropped to avoid falling further behind.
+    void SetMaxFixedUpdates(int num);
+    /// Set whether to interpolate node transforms between fixed updates for rendering. If disabled, the latest fixed update is shown.
+    void SetFixedUpdateInterpolation(bool enable);
+    /// Set whether to update the world transforms of moved nodes in one batched pass per frame, instead of on demand.
+    void SetBatchedTransformUpdate(bool enable);
     /// Set maximum milliseconds per frame to spend on async scene loading.
     void SetAsyncLoadingMs(int ms);
     /// Add a required package file for networking. To be called on the server.
@@ -171,6 +183,12 @@ public:
     Component* GetComponent(unsigned id) const;
     /// Get nodes with specific tag from the whole scene, return false if empty.
     bool GetNodesWithTag(PODVector<Node*>& dest, const String& tag)  const;
+    /// Return all components of exactly the specified type from the whole scene as a contiguous array, in no particular order.
+    const PODVector<Component*>& GetComponentsByType(StringHash type) const;
+    /// Return components of the specified type from the whole scene, optionally including types derived from it.
+    void GetComponentsByType(PODVector<Component*>& dest, StringHash type, bool derived = false) const;
+    /// Template version of returning components by type from the whole scene.
+    template <class T> void GetComponentsByType(PODVector<T*>& dest, bool derived = false) const;
 
     /// Return whether updates are enabled.
     bool IsUpdateEnabled() const { return updateEnabled_; }
@@ -202,6 +220,21 @@ public:
     /// Return motion smoothing snap threshold.
     float GetSnapThreshold() const { return snapThreshold_; }
 
+    /// Return fixed update rate per second, or 0 if fixed updates are disabled.
+    int GetFixedUpdateFps() const { return fixedUpdateFps_; }
+
+    /// Return maximum fixed updates per frame.
+    int GetMaxFixedUpdates() const { return maxFixedUpdates_; }
+
+    /// Return whether node transforms are interpolated between fixed updates.
+    bool GetFixedUpdateInterpolation() const { return fixedUpdateInterpolation_; }
+
+    /// Return whether world transforms are updated in one batched pass per frame.
+    bool GetBatchedTransformUpdate() const { return batchedTransformUpdate_; }
+
+    /// Return interpolation factor between the last two fixed updates.
+    float GetFixedUpdateFactor() const { return fixedUpdateFps_ ? Clamp(fixedUpdateAcc_ * fixedUpdateFps_, 0.0f, 1.0f) : 1.0f; }
+
     /// Return maximum milliseconds per frame to spend on async loading.
     int GetAsyncLoadingMs() const { return asyncLoadingMs_; }
 
@@ -217,12 +250,23 @@ public:
     void BeginThreadedUpdate();
     /// End a threaded update. Notify components that marked themselves for delayed dirty processing.
     void EndThreadedUpdate();
+    /// Run one fixed update. Called by Update when fixed updates are enabled. Can also be called manually with scene update disabled, for example to run server ticks decoupled from the frame rate.
+    void FixedUpdate(float timeStep);
+    /// Move node transforms to the given point between the last two fixed updates. Called by Update when fixed updates are enabled.
+    void UpdateInterpolation(float factor);
     /// Add a component to the delayed dirty notify queue. Is thread-safe.
     void DelayedMarkedDirty(Component* component);
+    /// Add a node whose subtree has become dirty to the batched transform update. Is thread-safe.
+    void MarkTransformDirty(Node* node);
+    /// Update the world transforms of all dirty nodes in one pass, parents first. Called by Octree before updating the drawables when batched transform update is enabled.
+    void UpdateTransforms();
 
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
 
+    /// Return whether node transforms are being moved to or from interpolated states. Physics components ignore these changes.
+    bool IsUpdatingInterpolation() const { return updatingInterpolation_; }
+
     /// Get free node ID, either non-local or local.
     unsigned GetFreeNodeID(CreateMode mode);
     /// Get free component ID, either non-local or local.
@@ -255,6 +299,10 @@ public:
     void MarkNetworkUpdate(Component* component);
     /// Mark a node dirty in scene replication states. The node does not need to have own replication state yet.
     void MarkReplicationDirty(Node* node);
+    /// Add a logic component to the scene update and post-update. Called by LogicComponent.
+    void AddLogicComponent(LogicComponent* component);
+    /// Remove a logic component from the scene update and post-update. Called by LogicComponent.
+    void RemoveLogicComponent(LogicComponent* component);
 
 private:
     /// Handle the logic update event to update the scene, if active.
@@ -275,6 +323,10 @@ private:
     void PreloadResourcesXML(const XMLElement& element);
     /// Preload resources from a JSON scene or object prefab file.
     void PreloadResourcesJSON(const JSONValue& value);
+    /// Calculate world transforms of a range of batched transform update nodes.
+    void UpdateTransforms(unsigned start, unsigned end);
+    /// Call scene update or post-update of the registered logic components.
+    void UpdateLogicComponents(bool postUpdate, float timeStep);
 
     /// Replicated scene nodes by ID.
     HashMap<unsigned, Node*> replicatedNodes_;
@@ -286,6 +338,10 @@ private:
     HashMap<unsigned, Component*> localComponents_;
     /// Cached tagged nodes by tag.
     HashMap<StringHash, PODVector<Node*> > taggedNodes_;
+    /// Components by exact type.
+    HashMap<StringHash, PODVector<Component*> > componentsByType_;
+    /// Logic components that need scene update or post-update.
+    PODVector<LogicComponent*> logicComponents_;
     /// Asynchronous loading progress.
     AsyncProgress asyncProgress_;
     /// Node and component ID resolver for asynchronous loading.
@@ -302,10 +358,22 @@ private:
     HashSet<unsigned> networkUpdateComponents_;
     /// Delayed dirty notification queue for components.
     PODVector<Component*> delayedDirtyComponents_;
+    /// IDs of the topmost nodes of dirty subtrees for the batched transform update.
+    PODVector<unsigned> dirtyTransformRoots_;
+    /// Dirty nodes of the batched transform update, sorted by depth.
+    PODVector<Node*> transformNodes_;
+    /// Parent indices of the batched transform update nodes. The first level has its world transform already calculated.
+    PODVector<unsigned> transformParents_;
+    /// World transforms of the batched transform update nodes.
+    PODVector<Matrix3x4> transformWorldTransforms_;
+    /// World rotations of the batched transform update nodes.
+    PODVector<Quaternion> transformWorldRotations_;
     /// Mutex for the delayed dirty notification queue.
     Mutex sceneMutex_;
     /// Preallocated event data map for smoothing update events.
     VariantMap smoothingData_;
+    /// Preallocated event data map for interpolation update events.
+    VariantMap interpolationData_;
     /// Next free non-local node ID.
     unsigned replicatedNodeID_;
     /// Next free non-local component ID.
@@ -326,14 +394,40 @@ private:
     float smoothingConstant_;
     /// Motion smoothing snap threshold.
     float snapThreshold_;
+    /// Fixed update rate per second.
+    int fixedUpdateFps_;
+    /// Maximum fixed updates per frame.
+    int maxFixedUpdates_;
+    /// Fixed update time accumulator.
+    float fixedUpdateAcc_;
+    /// Fixed update interpolation flag.
+    bool fixedUpdateInterpolation_;
+    /// Batched transform update flag.
+    bool batchedTransformUpdate_;
+    /// Interpolation update in progress flag.
+    bool updatingInterpolation_;
     /// Update enabled flag.
     bool updateEnabled_;
     /// Asynchronous loading flag.
     bool asyncLoading_;
     /// Threaded update flag.
     bool threadedUpdate_;
+    /// Logic component update in progress flag.
+    bool updatingLogicComponents_;
+    /// Logic components removed during update flag. The update array has null entries to compact.
+    bool logicComponentsDirty_;
 };
 
+template <class T> void Scene::GetComponentsByType(PODVector<T*>& dest, bool derived) const
+{
+    PODVector<Component*> components;
+    GetComponentsByType(components, T::GetTypeStatic(), derived);
+
+    dest.Resize(components.Size());
+    for (unsigned i = 0; i < components.Size(); ++i)
+        dest[i] = static_cast<T*>(components[i]);
+}
+
 /// Register Scene library objects.
 void URHO3D_API RegisterSceneLibrary(Context* context);
 
@@ -34,6 +34,13 @@ URHO3D_EVENT(E_SCENEUPDATE, SceneUpdate)
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Fixed timestep scene update.
+URHO3D_EVENT(E_SCENEFIXEDUPDATE, SceneFixedUpdate)
+{
+    URHO3D_PARAM(P_SCENE, Scene);                  // Scene pointer
+    URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
+}
+
 /// Scene subsystem update.
 URHO3D_EVENT(E_SCENESUBSYSTEMUPDATE, SceneSubsystemUpdate)
 {
@@ -48,6 +55,17 @@ URHO3D_EVENT(E_UPDATESMOOTHING, UpdateSmoothing)
     URHO3D_PARAM(P_SQUAREDSNAPTHRESHOLD, SquaredSnapThreshold);  // float
 }
 
+/// Scene transform interpolation: restore and store simulated transforms before a fixed update.
+URHO3D_EVENT(E_STOREINTERPOLATION, StoreInterpolation)
+{
+}
+
+/// Scene transform interpolation update after fixed updates.
+URHO3D_EVENT(E_UPDATEINTERPOLATION, UpdateInterpolation)
+{
+    URHO3D_PARAM(P_FACTOR, Factor);                // float
+}
+
 /// Scene drawable update finished. Custom animation (eg. IK) can be done at this point.
 URHO3D_EVENT(E_SCENEDRAWABLEUPDATEFINISHED, SceneDrawableUpdateFinished)
 {
@@ -28,6 +28,8 @@
 #include "../Container/Sort.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/GraphicsEvents.h"
+#include "../Graphics/RenderCommandList.h"
+#include "../Graphics/Renderer.h"
 #include "../Graphics/Shader.h"
 #include "../Graphics/ShaderVariation.h"
 #include "../Graphics/Texture2D.h"
@@ -847,10 +849,20 @@ void UI::Render(bool resetRenderTargets, VertexBuffer* buffer, const PODVector<U
     if (batches.Empty())
         return;
 
+    // Render through the renderer's command list, so that the UI is recorded along with the views when threaded submission is used
+    Renderer* renderer = GetSubsystem<Renderer>();
+    RenderCommandList* commandList = renderer ? renderer->GetCommandList() : 0;
+    if (!commandList)
+    {
+        if (!commandList_)
+            commandList_ = new RenderCommandList(context_);
+        commandList = commandList_;
+    }
+
     if (resetRenderTargets)
-        graphics_->ResetRenderTargets();
+        commandList->ResetRenderTargets();
 
-    IntVector2 viewSize = graphics_->GetViewport().Size();
+    IntVector2 viewSize = commandList->GetViewport().Size();
     Vector2 invScreenSize(1.0f / (float)viewSize.x_, 1.0f / (float)viewSize.y_);
     Vector2 scale(2.0f * invScreenSize.x_, -2.0f * invScreenSize.y_);
     Vector2 offset(-1.0f, 1.0f);
@@ -864,14 +876,14 @@ void UI::Render(bool resetRenderTargets, VertexBuffer* buffer, const PODVector<U
     projection.m23_ = 0.0f;
     projection.m33_ = 1.0f;
 
-    graphics_->ClearParameterSources();
-    graphics_->SetColorWrite(true);
-    graphics_->SetCullMode(CULL_CCW);
-    graphics_->SetDepthTest(CMP_ALWAYS);
-    graphics_->SetDepthWrite(false);
-    graphics_->SetFillMode(FILL_SOLID);
-    graphics_->SetStencilTest(false);
-    graphics_->SetVertexBuffer(buffer);
+    commandList->ClearParameterSources();
+    commandList->SetColorWrite(true);
+    commandList->SetCullMode(CULL_CCW);
+    commandList->SetDepthTest(CMP_ALWAYS);
+    commandList->SetDepthWrite(false);
+    commandList->SetFillMode(FILL_SOLID);
+    commandList->SetStencilTest(false);
+    commandList->SetVertexBuffer(buffer);
 
     ShaderVariation* noTextureVS = graphics_->GetShader(VS, "Basic", "VERTEXCOLOR");
     ShaderVariation* diffTextureVS = graphics_->GetShader(VS, "Basic", "DIFFMAP VERTEXCOLOR");
@@ -909,17 +921,17 @@ void UI::Render(bool resetRenderTargets, VertexBuffer* buffer, const PODVector<U
                 ps = diffTexturePS;
         }
 
-        graphics_->SetShaders(vs, ps);
-        if (graphics_->NeedParameterUpdate(SP_OBJECT, this))
-            graphics_->SetShaderParameter(VSP_MODEL, Matrix3x4::IDENTITY);
-        if (graphics_->NeedParameterUpdate(SP_CAMERA, this))
-            graphics_->SetShaderParameter(VSP_VIEWPROJ, projection);
-        if (graphics_->NeedParameterUpdate(SP_MATERIAL, this))
-            graphics_->SetShaderParameter(PSP_MATDIFFCOLOR, Color(1.0f, 1.0f, 1.0f, 1.0f));
+        commandList->SetShaders(vs, ps);
+        if (commandList->NeedParameterUpdate(SP_OBJECT, this))
+            commandList->SetShaderParameter(VSP_MODEL, Matrix3x4::IDENTITY);
+        if (commandList->NeedParameterUpdate(SP_CAMERA, this))
+            commandList->SetShaderParameter(VSP_VIEWPROJ, projection);
+        if (commandList->NeedParameterUpdate(SP_MATERIAL, this))
+            commandList->SetShaderParameter(PSP_MATDIFFCOLOR, Color(1.0f, 1.0f, 1.0f, 1.0f));
 
         float elapsedTime = GetSubsystem<Time>()->GetElapsedTime();
-        graphics_->SetShaderParameter(VSP_ELAPSEDTIME, elapsedTime);
-        graphics_->SetShaderParameter(PSP_ELAPSEDTIME, elapsedTime);
+        commandList->SetShaderParameter(VSP_ELAPSEDTIME, elapsedTime);
+        commandList->SetShaderParameter(PSP_ELAPSEDTIME, elapsedTime);
 
         IntRect scissor = batch.scissor_;
         scissor.left_ = (int)(scissor.left_ * uiScale_);
@@ -927,10 +939,10 @@ void UI::Render(bool resetRenderTargets, VertexBuffer* buffer, const PODVector<U
         scissor.right_ = (int)(scissor.right_ * uiScale_);
         scissor.bottom_ = (int)(scissor.bottom_ * uiScale_);
 
-        graphics_->SetBlendMode(batch.blendMode_);
-        graphics_->SetScissorTest(true, scissor);
-        graphics_->SetTexture(0, batch.texture_);
-        graphics_->Draw(TRIANGLE_LIST, batch.vertexStart_ / UI_VERTEX_SIZE,
+        commandList->SetBlendMode(batch.blendMode_);
+        commandList->SetScissorTest(true, scissor);
+        commandList->SetTexture(0, batch.texture_);
+        commandList->Draw(TRIANGLE_LIST, batch.vertexStart_ / UI_VERTEX_SIZE,
             (batch.vertexEnd_ - batch.vertexStart_) / UI_VERTEX_SIZE);
     }
 }
@@ -44,6 +44,7 @@ enum FontHintLevel
 
 class Cursor;
 class Graphics;
+class RenderCommandList;
 class ResourceCache;
 class Timer;
 class UIBatch;
@@ -305,6 +306,8 @@ private:
 
     /// Graphics subsystem.
     WeakPtr<Graphics> graphics_;
+    /// Command list for rendering immediately when there is no renderer.
+    SharedPtr<RenderCommandList> commandList_;
     /// UI root element.
     SharedPtr<UIElement> rootElement_;
     /// UI root modal element.
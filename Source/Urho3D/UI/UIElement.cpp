@@ -1142,11 +1142,18 @@ void UIElement::UpdateLayout()
     // Prevent further updates while this update happens
     DisableLayoutUpdate();
 
-    PODVector<int> positions;
-    PODVector<int> sizes;
-    PODVector<int> minSizes;
-    PODVector<int> maxSizes;
-    PODVector<float> flexScales;
+    // Reuse the memory of the temporary arrays from the previous update. They can not be in use by an outer update of this
+    // element, as the layout update is disabled now
+    PODVector<int>& positions = layoutPositions_;
+    PODVector<int>& sizes = layoutSizes_;
+    PODVector<int>& minSizes = layoutMinSizes_;
+    PODVector<int>& maxSizes = layoutMaxSizes_;
+    PODVector<float>& flexScales = layoutFlexScales_;
+    positions.Clear();
+    sizes.Clear();
+    minSizes.Clear();
+    maxSizes.Clear();
+    flexScales.Clear();
 
     int baseIndentWidth = GetIndentWidth();
 
@@ -2146,6 +2153,7 @@ void UIElement::CalculateLayout(PODVector<int>& positions, PODVector<int>& sizes
     }
 
     // Error correction passes
+    PODVector<unsigned>& resizable = layoutResizable_;
     for (;;)
     {
         int actualTotalSize = 0;
@@ -2157,7 +2165,7 @@ void UIElement::CalculateLayout(PODVector<int>& positions, PODVector<int>& sizes
             break;
 
         // Check which of the children can be resized to correct the error. If none, must break
-        PODVector<unsigned> resizable;
+        resizable.Clear();
         for (unsigned i = 0; i < numChildren; ++i)
         {
             if (error < 0 && sizes[i] > minSizes[i])
@@ -759,6 +759,18 @@ private:
     IntVector2 childOffset_;
     /// Parent's minimum size calculated by layout. Used internally.
     IntVector2 layoutMinSize_;
+    /// Child positions during layout update. Used internally.
+    PODVector<int> layoutPositions_;
+    /// Child sizes during layout update. Used internally.
+    PODVector<int> layoutSizes_;
+    /// Child minimum sizes during layout update. Used internally.
+    PODVector<int> layoutMinSizes_;
+    /// Child maximum sizes during layout update. Used internally.
+    PODVector<int> layoutMaxSizes_;
+    /// Child flex scales during layout update. Used internally.
+    PODVector<float> layoutFlexScales_;
+    /// Indices of resizable children during layout update. Used internally.
+    PODVector<unsigned> layoutResizable_;
     /// Minimum offset.
     IntVector2 minOffset_;
     /// Maximum offset.
@@ -589,8 +589,12 @@ void RigidBody2D::OnMarkedDirty(Node* node)
     if (physicsWorld_ && physicsWorld_->IsApplyingTransforms())
         return;
 
-    // Physics operations are not safe from worker threads
+    // Interpolated transforms between scene fixed updates are not physical states
     Scene* scene = GetScene();
+    if (scene && scene->IsUpdatingInterpolation())
+        return;
+
+    // Physics operations are not safe from worker threads
     if (scene && scene->IsThreadedUpdate())
     {
         scene->DelayedMarkedDirty(this);
@@ -0,0 +1,201 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Graphics/Material.h"
+#include "../Scene/Node.h"
+#include "../Urho2D/Renderer2D.h"
+#include "../Urho2D/Sprite2D.h"
+#include "../Urho2D/TileMap2D.h"
+#include "../Urho2D/TileMapChunk2D.h"
+#include "../Urho2D/TileMapLayer2D.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+TileMapChunk2D::TileMapChunk2D(Context* context) :
+    Drawable2D(context),
+    tileRange_(IntRect::ZERO),
+    numTiles_(0)
+{
+}
+
+TileMapChunk2D::~TileMapChunk2D()
+{
+}
+
+void TileMapChunk2D::RegisterObject(Context* context)
+{
+    context->RegisterFactory<TileMapChunk2D>();
+}
+
+void TileMapChunk2D::SetTileRange(TileMapLayer2D* layer, const IntRect& tileRange)
+{
+    layer_ = layer;
+    tileRange_ = tileRange;
+
+    UpdateTiles();
+}
+
+void TileMapChunk2D::UpdateTiles()
+{
+    sourceBatches_.Clear();
+    localVertices_.Clear();
+    numTiles_ = 0;
+
+    TileMap2D* tileMap = layer_ ? layer_->GetTileMap() : 0;
+    if (tileMap && renderer_)
+    {
+        const TileMapInfo2D& info = tileMap->GetInfo();
+        Rect drawRect;
+        Rect textureRect;
+
+        // Go through the tiles in row order so that overlapping tiles are drawn in the same order as before chunking
+        for (int y = tileRange_.top_; y < tileRange_.bottom_; ++y)
+        {
+            for (int x = tileRange_.left_; x < tileRange_.right_; ++x)
+            {
+                Tile2D* tile = layer_->GetTile(x, y);
+                Sprite2D* sprite = tile ? tile->GetSprite() : 0;
+                if (!sprite || !sprite->GetDrawRectangle(drawRect) || !sprite->GetTextureRectangle(textureRect))
+                    continue;
+
+                // Tiles sharing a texture go to the same source batch
+                Material* material = renderer_->GetMaterial(sprite->GetTexture(), BLEND_ALPHA);
+                unsigned index = 0;
+                while (index < sourceBatches_.Size() && sourceBatches_[index].material_ != material)
+                    ++index;
+
+                if (index == sourceBatches_.Size())
+                {
+                    sourceBatches_.Resize(index + 1);
+                    sourceBatches_[index].owner_ = this;
+                    sourceBatches_[index].drawOrder_ = GetDrawOrder();
+                    sourceBatches_[index].material_ = material;
+                    localVertices_.Resize(index + 1);
+                }
+
+                Vector2 position = info.TileIndexToPosition(x, y);
+                Vector2 min = position + drawRect.min_;
+                Vector2 max = position + drawRect.max_;
+
+                Vertex2D vertex0;
+                Vertex2D vertex1;
+                Vertex2D vertex2;
+                Vertex2D vertex3;
+
+                vertex0.position_ = Vector3(min.x_, min.y_, 0.0f);
+                vertex1.position_ = Vector3(min.x_, max.y_, 0.0f);
+                vertex2.position_ = Vector3(max.x_, max.y_, 0.0f);
+                vertex3.position_ = Vector3(max.x_, min.y_, 0.0f);
+
+                vertex0.uv_ = textureRect.min_;
+                vertex1.uv_ = Vector2(textureRect.min_.x_, textureRect.max_.y_);
+                vertex2.uv_ = textureRect.max_;
+                vertex3.uv_ = Vector2(textureRect.max_.x_, textureRect.min_.y_);
+
+                vertex0.color_ = vertex1.color_ = vertex2.color_ = vertex3.color_ = Color::WHITE.ToUInt();
+
+                Vector<Vertex2D>& vertices = localVertices_[index];
+                vertices.Push(vertex0);
+                vertices.Push(vertex1);
+                vertices.Push(vertex2);
+                vertices.Push(vertex3);
+
+                ++numTiles_;
+            }
+        }
+    }
+
+    sourceBatchesDirty_ = true;
+    worldBoundingBoxDirty_ = true;
+}
+
+TileMapLayer2D* TileMapChunk2D::GetLayer() const
+{
+    return layer_;
+}
+
+void TileMapChunk2D::OnSceneSet(Scene* scene)
+{
+    Drawable2D::OnSceneSet(scene);
+
+    // Materials are owned by Renderer2D, so rebuild when it changes
+    UpdateTiles();
+}
+
+void TileMapChunk2D::OnWorldBoundingBoxUpdate()
+{
+    boundingBox_.Clear();
+    worldBoundingBox_.Clear();
+
+    const Vector<SourceBatch2D>& sourceBatches = GetSourceBatches();
+    for (unsigned i = 0; i < sourceBatches.Size(); ++i)
+    {
+        const Vector<Vertex2D>& vertices = sourceBatches[i].vertices_;
+        for (unsigned j = 0; j < vertices.Size(); ++j)
+            worldBoundingBox_.Merge(vertices[j].position_);
+    }
+
+    for (unsigned i = 0; i < localVertices_.Size(); ++i)
+    {
+        const Vector<Vertex2D>& vertices = localVertices_[i];
+        for (unsigned j = 0; j < vertices.Size(); ++j)
+            boundingBox_.Merge(vertices[j].position_);
+    }
+}
+
+void TileMapChunk2D::OnDrawOrderChanged()
+{
+    int drawOrder = GetDrawOrder();
+    for (unsigned i = 0; i < sourceBatches_.Size(); ++i)
+        sourceBatches_[i].drawOrder_ = drawOrder;
+}
+
+void TileMapChunk2D::UpdateSourceBatches()
+{
+    if (!sourceBatchesDirty_)
+        return;
+
+    // Only the transform to world space is redone here, the tile quads themselves are cached in localVertices_
+    const Matrix3x4& worldTransform = node_->GetWorldTransform();
+    for (unsigned i = 0; i < sourceBatches_.Size(); ++i)
+    {
+        const Vector<Vertex2D>& source = localVertices_[i];
+        Vector<Vertex2D>& dest = sourceBatches_[i].vertices_;
+        dest.Resize(source.Size());
+
+        for (unsigned j = 0; j < source.Size(); ++j)
+        {
+            dest[j] = source[j];
+            dest[j].position_ = worldTransform * source[j].position_;
+        }
+    }
+
+    sourceBatchesDirty_ = false;
+}
+
+}
@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2008-2017 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Urho2D/Drawable2D.h"
+
+namespace Urho3D
+{
+
+class TileMapLayer2D;
+
+/// Drawable for a rectangular chunk of a tile map layer. Created by TileMapLayer2D, not meant to be used directly.
+class URHO3D_API TileMapChunk2D : public Drawable2D
+{
+    URHO3D_OBJECT(TileMapChunk2D, Drawable2D);
+
+public:
+    /// Construct.
+    TileMapChunk2D(Context* context);
+    /// Destruct.
+    ~TileMapChunk2D();
+    /// Register object factory. Drawable2D must be registered first.
+    static void RegisterObject(Context* context);
+
+    /// Set owner layer and the range of tiles covered by the chunk. Right and bottom are exclusive.
+    void SetTileRange(TileMapLayer2D* layer, const IntRect& tileRange);
+    /// Rebuild vertices after tiles in the chunk have changed. Must be called from the main thread.
+    void UpdateTiles();
+
+    /// Return owner layer.
+    TileMapLayer2D* GetLayer() const;
+
+    /// Return range of tiles covered by the chunk.
+    const IntRect& GetTileRange() const { return tileRange_; }
+
+    /// Return number of non-empty tiles in the chunk.
+    unsigned GetNumTiles() const { return numTiles_; }
+
+protected:
+    /// Handle scene being assigned.
+    virtual void OnSceneSet(Scene* scene);
+    /// Recalculate the world-space bounding box.
+    virtual void OnWorldBoundingBoxUpdate();
+    /// Handle draw order changed.
+    virtual void OnDrawOrderChanged();
+    /// Update source batches.
+    virtual void UpdateSourceBatches();
+
+private:
+    /// Owner layer.
+    WeakPtr<TileMapLayer2D> layer_;
+    /// Range of tiles covered by the chunk.
+    IntRect tileRange_;
+    /// Node-local vertices per source batch, rebuilt only when tiles change.
+    Vector<Vector<Vertex2D> > localVertices_;
+    /// Number of non-empty tiles.
+    unsigned numTiles_;
+};
+
+}
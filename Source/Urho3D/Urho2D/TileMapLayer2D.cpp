@@ -28,6 +28,7 @@
 #include "../Scene/Node.h"
 #include "../Urho2D/StaticSprite2D.h"
 #include "../Urho2D/TileMap2D.h"
+#include "../Urho2D/TileMapChunk2D.h"
 #include "../Urho2D/TileMapLayer2D.h"
 #include "../Urho2D/TmxFile2D.h"
 
@@ -36,11 +37,15 @@
 namespace Urho3D
 {
 
+/// Width and height of a drawable tile chunk in tiles.
+static const int TILE_CHUNK_SIZE = 16;
+
 TileMapLayer2D::TileMapLayer2D(Context* context) :
     Component(context),
     tmxLayer_(0),
     drawOrder_(0),
-    visible_(true)
+    visible_(true),
+    numChunksX_(0)
 {
 }
 
@@ -183,6 +188,13 @@ void TileMapLayer2D::Initialize(TileMap2D* tileMap, const TmxLayer2D* tmxLayer)
         }
 
         nodes_.Clear();
+
+        for (unsigned i = 0; i < chunks_.Size(); ++i)
+            chunks_[i]->Remove();
+
+        chunks_.Clear();
+        tiles_.Clear();
+        numChunksX_ = 0;
     }
 
     tileLayer_ = 0;
@@ -232,6 +244,9 @@ void TileMapLayer2D::SetDrawOrder(int drawOrder)
         if (staticSprite)
             staticSprite->SetLayer(drawOrder_);
     }
+
+    for (unsigned i = 0; i < chunks_.Size(); ++i)
+        chunks_[i]->SetLayer(drawOrder_);
 }
 
 void TileMapLayer2D::SetVisible(bool visible)
@@ -246,6 +261,25 @@ void TileMapLayer2D::SetVisible(bool visible)
         if (nodes_[i])
             nodes_[i]->SetEnabled(visible_);
     }
+
+    for (unsigned i = 0; i < chunks_.Size(); ++i)
+        chunks_[i]->SetEnabled(visible_);
+}
+
+void TileMapLayer2D::SetTile(int x, int y, Tile2D* tile)
+{
+    if (!tileLayer_)
+        return;
+
+    if (x < 0 || x >= tileLayer_->GetWidth() || y < 0 || y >= tileLayer_->GetHeight())
+        return;
+
+    SharedPtr<Tile2D>& dest = tiles_[y * tileLayer_->GetWidth() + x];
+    if (dest == tile)
+        return;
+
+    dest = tile;
+    GetTileChunk(x, y)->UpdateTiles();
 }
 
 TileMap2D* TileMapLayer2D::GetTileMap() const
@@ -288,10 +322,13 @@ Tile2D* TileMapLayer2D::GetTile(int x, int y) const
     if (!tileLayer_)
         return 0;
 
-    return tileLayer_->GetTile(x, y);
+    if (x < 0 || x >= tileLayer_->GetWidth() || y < 0 || y >= tileLayer_->GetHeight())
+        return 0;
+
+    return tiles_[y * tileLayer_->GetWidth() + x];
 }
 
-Node* TileMapLayer2D::GetTileNode(int x, int y) const
+TileMapChunk2D* TileMapLayer2D::GetTileChunk(int x, int y) const
 {
     if (!tileLayer_)
         return 0;
@@ -299,7 +336,7 @@ Node* TileMapLayer2D::GetTileNode(int x, int y) const
     if (x < 0 || x >= tileLayer_->GetWidth() || y < 0 || y >= tileLayer_->GetHeight())
         return 0;
 
-    return nodes_[y * tileLayer_->GetWidth() + x];
+    return chunks_[(y / TILE_CHUNK_SIZE) * numChunksX_ + x / TILE_CHUNK_SIZE];
 }
 
 unsigned TileMapLayer2D::GetNumObjects() const
@@ -343,26 +380,32 @@ void TileMapLayer2D::SetTileLayer(const TmxTileLayer2D* tileLayer)
 
     int width = tileLayer->GetWidth();
     int height = tileLayer->GetHeight();
-    nodes_.Resize((unsigned)(width * height));
+    tiles_.Resize((unsigned)(width * height));
 
-    const TileMapInfo2D& info = tileMap_->GetInfo();
     for (int y = 0; y < height; ++y)
     {
         for (int x = 0; x < width; ++x)
-        {
-            const Tile2D* tile = tileLayer->GetTile(x, y);
-            if (!tile)
-                continue;
-
-            SharedPtr<Node> tileNode(GetNode()->CreateTemporaryChild("Tile"));
-            tileNode->SetPosition(info.TileIndexToPosition(x, y));
+            tiles_[y * width + x] = tileLayer->GetTile(x, y);
+    }
 
-            StaticSprite2D* staticSprite = tileNode->CreateComponent<StaticSprite2D>();
-            staticSprite->SetSprite(tile->GetSprite());
-            staticSprite->SetLayer(drawOrder_);
-            staticSprite->SetOrderInLayer(y * width + x);
+    // Draw the tiles through one drawable per chunk instead of a node per tile, so that visibility is checked and
+    // vertices are cached per chunk
+    numChunksX_ = (width + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+    int numChunksY = (height + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+    chunks_.Resize((unsigned)(numChunksX_ * numChunksY));
 
-            nodes_[y * width + x] = tileNode;
+    for (int y = 0; y < numChunksY; ++y)
+    {
+        for (int x = 0; x < numChunksX_; ++x)
+        {
+            SharedPtr<TileMapChunk2D> chunk(GetNode()->CreateComponent<TileMapChunk2D>(LOCAL));
+            chunk->SetTemporary(true);
+            chunk->SetLayer(drawOrder_);
+            chunk->SetOrderInLayer(y * numChunksX_ + x);
+            chunk->SetTileRange(this, IntRect(x * TILE_CHUNK_SIZE, y * TILE_CHUNK_SIZE, Min((x + 1) * TILE_CHUNK_SIZE, width),
+                Min((y + 1) * TILE_CHUNK_SIZE, height)));
+
+            chunks_[y * numChunksX_ + x] = chunk;
         }
     }
 }
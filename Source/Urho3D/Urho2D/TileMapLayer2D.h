@@ -35,6 +35,7 @@ namespace Urho3D
 class DebugRenderer;
 class Node;
 class TileMap2D;
+class TileMapChunk2D;
 class TmxImageLayer2D;
 class TmxLayer2D;
 class TmxObjectGroup2D;
@@ -62,6 +63,8 @@ public:
     void SetDrawOrder(int drawOrder);
     /// Set visible.
     void SetVisible(bool visible);
+    /// Set tile, or null to clear it (for tile layer only). Only the chunk containing the tile is rebuilt.
+    void SetTile(int x, int y, Tile2D* tile);
 
     /// Return tile map.
     TileMap2D* GetTileMap() const;
@@ -86,10 +89,12 @@ public:
     int GetWidth() const;
     /// Return height (for tile layer only).
     int GetHeight() const;
-    /// Return tile node (for tile layer only).
-    Node* GetTileNode(int x, int y) const;
     /// Return tile (for tile layer only).
     Tile2D* GetTile(int x, int y) const;
+    /// Return number of drawable chunks (for tile layer only).
+    unsigned GetNumChunks() const { return chunks_.Size(); }
+    /// Return drawable chunk containing a tile (for tile layer only).
+    TileMapChunk2D* GetTileChunk(int x, int y) const;
 
     /// Return number of tile map objects (for object group only).
     unsigned GetNumObjects() const;
@@ -123,8 +128,14 @@ private:
     int drawOrder_;
     /// Visible.
     bool visible_;
-    /// Tile node or image nodes.
+    /// Object nodes or image node.
     Vector<SharedPtr<Node> > nodes_;
+    /// Tiles in row order (for tile layer only).
+    Vector<SharedPtr<Tile2D> > tiles_;
+    /// Drawable chunks in row order (for tile layer only).
+    Vector<SharedPtr<TileMapChunk2D> > chunks_;
+    /// Number of chunks on the X axis.
+    int numChunksX_;
 };
 
 }
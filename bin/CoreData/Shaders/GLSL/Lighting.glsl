@@ -174,6 +174,63 @@ float GetIntensity(vec3 color)
     return dot(color, vec3(0.299, 0.587, 0.114));
 }
 
+#ifdef CLUSTERED
+#define MAXCLUSTERLIGHTS 64
+
+vec2 GetClusterTexCoord(float index)
+{
+    float row = floor(index * cClusterInvTexSize.x);
+    return vec2(index - row * cClusterParams.w + 0.5, row + 0.5) * cClusterInvTexSize.xy;
+}
+
+vec3 GetClusteredLight(vec4 clusterPos, vec3 worldPos, vec3 normal, vec3 eyeVec, vec3 diffColor, vec3 specColor, float specPower)
+{
+    // Find the cluster from the normalized device coordinates and view depth
+    vec2 ndc = clusterPos.xy / clusterPos.z;
+    ndc.y *= cClusterDepthParams.w;
+    float slice = cClusterDepthParams.z > 0.5 ? (clusterPos.w - cClusterDepthParams.x) * cClusterDepthParams.y :
+        log(max(clusterPos.w, cClusterDepthParams.x) / cClusterDepthParams.x) * cClusterDepthParams.y;
+    vec3 cluster = clamp(floor(vec3((ndc * 0.5 + 0.5) * cClusterParams.xy, slice)), vec3(0.0), cClusterParams.xyz - 1.0);
+    vec2 range = texture2D(sClusterMap, GetClusterTexCoord((cluster.z * cClusterParams.y + cluster.y) * cClusterParams.x +
+        cluster.x)).rg;
+
+    vec3 result = vec3(0.0, 0.0, 0.0);
+    for (int i = 0; i < MAXCLUSTERLIGHTS; ++i)
+    {
+        if (float(i) >= range.y)
+            break;
+
+        float lightIndex = texture2D(sClusterMap, GetClusterTexCoord(range.x + float(i))).r;
+        float v = (lightIndex + 0.5) * cClusterInvTexSize.w;
+        vec4 lightPos = texture2D(sClusterLightMap, vec2(0.5 * cClusterInvTexSize.z, v));
+        vec4 lightColor = texture2D(sClusterLightMap, vec2(1.5 * cClusterInvTexSize.z, v));
+        vec4 lightDir = texture2D(sClusterLightMap, vec2(2.5 * cClusterInvTexSize.z, v));
+
+        vec3 lightVec = (lightPos.xyz - worldPos) * lightPos.w;
+        float lightDist = length(lightVec);
+        vec3 localDir = lightVec / max(lightDist, 0.0001);
+        float atten = clamp(1.0 - lightDist * lightDist, 0.0, 1.0);
+        // Point lights have a cutoff below -1
+        if (lightDir.w >= -1.0)
+            atten *= clamp((dot(localDir, lightDir.xyz) - lightDir.w) / (1.0 - lightDir.w), 0.0, 1.0);
+
+        #ifdef TRANSLUCENT
+            float diff = abs(dot(normal, localDir)) * atten;
+        #else
+            float diff = max(dot(normal, localDir), 0.0) * atten;
+        #endif
+        #ifdef SPECULAR
+            float spec = GetSpecular(normal, eyeVec, localDir, specPower);
+            result += diff * lightColor.rgb * (diffColor + spec * specColor * lightColor.a);
+        #else
+            result += diff * lightColor.rgb * diffColor;
+        #endif
+    }
+
+    return result;
+}
+#endif
+
 #ifdef SHADOW
 
 #if defined(DIRLIGHT) && (!defined(GL_ES) || defined(WEBGL))
@@ -33,6 +33,9 @@ varying vec4 vWorldPos;
 #else
     varying vec3 vVertexLight;
     varying vec4 vScreenPos;
+    #ifdef CLUSTERED
+        varying vec4 vClusterPos;
+    #endif
     #ifdef ENVCUBEMAP
         varying vec3 vReflectionVec;
     #endif
@@ -98,6 +101,11 @@ void VS()
         
         vScreenPos = GetScreenPos(gl_Position);
 
+        #ifdef CLUSTERED
+            // Clip-space position and view depth for finding the light cluster
+            vClusterPos = vec4(gl_Position.xyw, (vec4(worldPos, 1.0) * cView).z);
+        #endif
+
         #ifdef ENVCUBEMAP
             vReflectionVec = worldPos - cCameraPos;
         #endif
@@ -228,6 +236,12 @@ void PS()
             finalColor += lightInput.rgb * diffColor.rgb + lightSpecColor * specColor;
         #endif
 
+        #ifdef CLUSTERED
+            // Add the point and spot lights of the light cluster
+            finalColor += GetClusteredLight(vClusterPos, vWorldPos.xyz, normal, cCameraPosPS - vWorldPos.xyz, diffColor.rgb,
+                specColor, cMatSpecColor.a);
+        #endif
+
         #ifdef ENVCUBEMAP
             finalColor += cMatEnvMapColor * textureCube(sEnvCubeMap, reflect(vReflectionVec, normal)).rgb;
         #endif
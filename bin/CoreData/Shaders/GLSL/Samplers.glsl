@@ -24,6 +24,8 @@ uniform samplerCube sLightCubeMap;
     uniform samplerCube sIndirectionCubeMap;
     uniform samplerCube sZoneCubeMap;
     uniform sampler3D sZoneVolumeMap;
+    uniform sampler2D sClusterMap;
+    uniform sampler2D sClusterLightMap;
 #else
     uniform highp sampler2D sShadowMap;
 #endif
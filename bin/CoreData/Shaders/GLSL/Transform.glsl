@@ -144,7 +144,10 @@ vec3 GetTrailNormal(vec4 iPos, vec3 iParentPos, vec3 iForward)
 }
 #endif
 
-#if defined(SKINNED)
+#if defined(SKINNED) && defined(INSTANCED)
+    // Instanced skinning: the instance's offset into the packed skin matrices is stored in the instance stream
+    #define iModelMatrix GetSkinMatrix(iBlendWeights, iBlendIndices + iTexCoord4.x)
+#elif defined(SKINNED)
     #define iModelMatrix GetSkinMatrix(iBlendWeights, iBlendIndices)
 #elif defined(INSTANCED)
     #define iModelMatrix GetInstanceMatrix()
@@ -78,6 +78,11 @@ uniform vec3 cZoneMin;
 uniform vec3 cZoneMax;
 uniform float cNearClipPS;
 uniform float cFarClipPS;
+#ifdef CLUSTERED
+    uniform vec4 cClusterParams;
+    uniform vec4 cClusterDepthParams;
+    uniform vec4 cClusterInvTexSize;
+#endif
 uniform vec4 cShadowCubeAdjust;
 uniform vec4 cShadowDepthFade;
 uniform vec2 cShadowIntensity;
@@ -171,6 +176,11 @@ uniform CameraPS
     vec2 cGBufferInvSize;
     float cNearClipPS;
     float cFarClipPS;
+#ifdef CLUSTERED
+    vec4 cClusterParams;
+    vec4 cClusterDepthParams;
+    vec4 cClusterInvTexSize;
+#endif
 };
 
 uniform ZonePS
@@ -187,6 +187,64 @@ float GetIntensity(float3 color)
     return dot(color, float3(0.299, 0.587, 0.114));
 }
 
+#ifdef CLUSTERED
+#define MAXCLUSTERLIGHTS 64
+
+float2 GetClusterTexCoord(float index)
+{
+    float row = floor(index * cClusterInvTexSize.x);
+    return float2(index - row * cClusterParams.w + 0.5, row + 0.5) * cClusterInvTexSize.xy;
+}
+
+float3 GetClusteredLight(float4 clusterPos, float3 worldPos, float3 normal, float3 eyeVec, float3 diffColor, float3 specColor,
+    float specPower)
+{
+    // Find the cluster from the normalized device coordinates and view depth
+    float2 ndc = clusterPos.xy / clusterPos.z;
+    ndc.y *= cClusterDepthParams.w;
+    float slice = cClusterDepthParams.z > 0.5 ? (clusterPos.w - cClusterDepthParams.x) * cClusterDepthParams.y :
+        log(max(clusterPos.w, cClusterDepthParams.x) / cClusterDepthParams.x) * cClusterDepthParams.y;
+    float3 cluster = clamp(floor(float3((ndc * 0.5 + 0.5) * cClusterParams.xy, slice)), 0.0, cClusterParams.xyz - 1.0);
+    float2 range = Sample2DLod0(ClusterMap, GetClusterTexCoord((cluster.z * cClusterParams.y + cluster.y) * cClusterParams.x +
+        cluster.x)).rg;
+
+    float3 result = 0.0;
+    [loop] for (int i = 0; i < MAXCLUSTERLIGHTS; ++i)
+    {
+        if (float(i) >= range.y)
+            break;
+
+        float lightIndex = Sample2DLod0(ClusterMap, GetClusterTexCoord(range.x + float(i))).r;
+        float v = (lightIndex + 0.5) * cClusterInvTexSize.w;
+        float4 lightPos = Sample2DLod0(ClusterLightMap, float2(0.5 * cClusterInvTexSize.z, v));
+        float4 lightColor = Sample2DLod0(ClusterLightMap, float2(1.5 * cClusterInvTexSize.z, v));
+        float4 lightDir = Sample2DLod0(ClusterLightMap, float2(2.5 * cClusterInvTexSize.z, v));
+
+        float3 lightVec = (lightPos.xyz - worldPos) * lightPos.w;
+        float lightDist = length(lightVec);
+        float3 localDir = lightVec / max(lightDist, 0.0001);
+        float atten = saturate(1.0 - lightDist * lightDist);
+        // Point lights have a cutoff below -1
+        if (lightDir.w >= -1.0)
+            atten *= saturate((dot(localDir, lightDir.xyz) - lightDir.w) / (1.0 - lightDir.w));
+
+        #ifdef TRANSLUCENT
+            float diff = abs(dot(normal, localDir)) * atten;
+        #else
+            float diff = saturate(dot(normal, localDir)) * atten;
+        #endif
+        #ifdef SPECULAR
+            float spec = GetSpecular(normal, eyeVec, localDir, specPower);
+            result += diff * lightColor.rgb * (diffColor + spec * specColor * lightColor.a);
+        #else
+            result += diff * lightColor.rgb * diffColor;
+        #endif
+    }
+
+    return result;
+}
+#endif
+
 #ifdef SHADOW
 
 #ifdef DIRLIGHT
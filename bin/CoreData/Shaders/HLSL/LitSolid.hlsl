@@ -52,6 +52,9 @@ void VS(float4 iPos : POSITION,
     #else
         out float3 oVertexLight : TEXCOORD4,
         out float4 oScreenPos : TEXCOORD5,
+        #ifdef CLUSTERED
+            out float4 oClusterPos : TEXCOORD8,
+        #endif
         #ifdef ENVCUBEMAP
             out float3 oReflectionVec : TEXCOORD6,
         #endif
@@ -130,6 +133,11 @@ void VS(float4 iPos : POSITION,
         
         oScreenPos = GetScreenPos(oPos);
 
+        #ifdef CLUSTERED
+            // Clip-space position and view depth for finding the light cluster
+            oClusterPos = float4(oPos.xyw, mul(float4(worldPos, 1.0), cView).z);
+        #endif
+
         #ifdef ENVCUBEMAP
             oReflectionVec = worldPos - cCameraPos;
         #endif
@@ -158,6 +166,9 @@ void PS(
     #else
         float3 iVertexLight : TEXCOORD4,
         float4 iScreenPos : TEXCOORD5,
+        #ifdef CLUSTERED
+            float4 iClusterPos : TEXCOORD8,
+        #endif
         #ifdef ENVCUBEMAP
             float3 iReflectionVec : TEXCOORD6,
         #endif
@@ -302,6 +313,12 @@ void PS(
             finalColor += lightInput.rgb * diffColor.rgb + lightSpecColor * specColor;
         #endif
 
+        #ifdef CLUSTERED
+            // Add the point and spot lights of the light cluster
+            finalColor += GetClusteredLight(iClusterPos, iWorldPos.xyz, normal, cCameraPosPS - iWorldPos.xyz, diffColor.rgb,
+                specColor, cMatSpecColor.a);
+        #endif
+
         #ifdef ENVCUBEMAP
             finalColor += cMatEnvMapColor * SampleCube(EnvCubeMap, reflect(iReflectionVec, normal)).rgb;
         #endif
@@ -27,6 +27,8 @@ samplerCUBE sEnvCubeMap : register(s4);
 sampler2D sLightRampMap : register(s8);
 sampler2D sLightSpotMap : register(s9);
 samplerCUBE sLightCubeMap : register(s9);
+sampler2D sClusterMap : register(s8);
+sampler2D sClusterLightMap : register(s9);
 sampler2D sShadowMap : register(s10);
 samplerCUBE sFaceSelectCubeMap : register(s11);
 samplerCUBE sIndirectionCubeMap : register(s12);
@@ -60,6 +62,8 @@ TextureCube tEnvCubeMap : register(t4);
 Texture2D tLightRampMap : register(t8);
 Texture2D tLightSpotMap : register(t9);
 TextureCube tLightCubeMap : register(t9);
+Texture2D tClusterMap : register(t8);
+Texture2D tClusterLightMap : register(t9);
 Texture2D tShadowMap : register(t10);
 TextureCube tFaceSelectCubeMap : register(t11);
 TextureCube tIndirectionCubeMap : register(t12);
@@ -82,6 +86,8 @@ SamplerState sEnvCubeMap : register(s4);
 SamplerState sLightRampMap : register(s8);
 SamplerState sLightSpotMap : register(s9);
 SamplerState sLightCubeMap : register(s9);
+SamplerState sClusterMap : register(s8);
+SamplerState sClusterLightMap : register(s9);
 #ifdef VSM_SHADOW
     SamplerState sShadowMap : register(s10);
 #else
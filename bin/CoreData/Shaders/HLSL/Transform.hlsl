@@ -105,7 +105,10 @@ float3 GetTrailNormal(float4 iPos, float3 iParentPos, float3 iForward)
 }
 #endif
 
-#if defined(SKINNED)
+#if defined(SKINNED) && defined(INSTANCED)
+    // Instanced skinning: the instance's offset into the packed skin matrices is stored in the instance stream
+    #define iModelMatrix GetSkinMatrix(iBlendWeights, iBlendIndices + (int)iModelInstance._m00)
+#elif defined(SKINNED)
     #define iModelMatrix GetSkinMatrix(iBlendWeights, iBlendIndices)
 #elif defined(INSTANCED)
     #define iModelMatrix iModelInstance
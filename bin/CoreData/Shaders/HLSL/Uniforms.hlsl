@@ -67,6 +67,11 @@ uniform float3 cZoneMin;
 uniform float3 cZoneMax;
 uniform float cNearClipPS;
 uniform float cFarClipPS;
+#ifdef CLUSTERED
+    uniform float4 cClusterParams;
+    uniform float4 cClusterDepthParams;
+    uniform float4 cClusterInvTexSize;
+#endif
 uniform float4 cShadowCubeAdjust;
 uniform float4 cShadowDepthFade;
 uniform float2 cShadowIntensity;
@@ -160,6 +165,11 @@ cbuffer CameraPS : register(b1)
     float2 cGBufferInvSize;
     float cNearClipPS;
     float cFarClipPS;
+#ifdef CLUSTERED
+    float4 cClusterParams;
+    float4 cClusterDepthParams;
+    float4 cClusterInvTexSize;
+#endif
 }
 
 cbuffer ZonePS : register(b2)
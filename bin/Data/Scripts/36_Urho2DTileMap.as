@@ -155,20 +155,19 @@ void HandleMouseButtonDown(StringHash eventType, VariantMap& eventData)
     int x, y;
     if (map.PositionToTileIndex(x, y, pos))
     {
-        // Get tile's sprite. Note that layer.GetTile(x, y).sprite is read-only, so we get the sprite through tile's node
-        Node@ n = layer.GetTileNode(x, y);
-        if (n is null)
+        // Tiles are drawn in chunks rather than through a node per tile, so they are replaced through the layer
+        Tile2D@ tile = layer.GetTile(x, y);
+        if (tile is null)
             return;
-        StaticSprite2D@ sprite = n.GetComponent("StaticSprite2D");
 
         if (input.mouseButtonDown[MOUSEB_RIGHT])
         {
             // Swap grass and water
-            if (layer.GetTile(x, y).gid < 9) // First 8 sprites in the "isometric_grass_and_water.png" tileset are mostly grass and from 9 to 24 they are mostly water
-                sprite.sprite = layer.GetTile(0, 0).sprite; // Replace grass by water sprite used in top tile
-            else sprite.sprite = layer.GetTile(24, 24).sprite; // Replace water by grass sprite used in bottom tile
+            if (tile.gid < 9) // First 8 sprites in the "isometric_grass_and_water.png" tileset are mostly grass and from 9 to 24 they are mostly water
+                layer.SetTile(x, y, layer.GetTile(0, 0)); // Replace grass by water tile used in top tile
+            else layer.SetTile(x, y, layer.GetTile(24, 24)); // Replace water by grass tile used in bottom tile
         }
-        else sprite.sprite = null; // 'Remove' sprite
+        else layer.SetTile(x, y, null); // Remove tile
     }
 }
 
@@ -0,0 +1,46 @@
+// Animation LOD tier selection test.
+// When running headless the animation LOD distance of a model stays 0, so the first tier's distance can be placed exactly
+// at and just above it. A mismatch is logged as an error, which fails the test.
+
+Scene@ scene_;
+AnimatedModel@ atThreshold;
+AnimatedModel@ belowThreshold;
+
+void Start()
+{
+    scene_ = Scene();
+    scene_.CreateComponent("Octree");
+
+    atThreshold = CreateModel(0.0f);
+    belowThreshold = CreateModel(0.001f);
+
+    // The octree updates the models during the first frame's render update
+    SubscribeToEvent("PostRenderUpdate", "HandlePostRenderUpdate");
+}
+
+AnimatedModel@ CreateModel(float firstTierDistance)
+{
+    Node@ node = scene_.CreateChild("Jack");
+    AnimatedModel@ model = node.CreateComponent("AnimatedModel");
+    model.model = cache.GetResource("Model", "Models/Jack.mdl");
+    model.AddAnimationLodTier(firstTierDistance, 0.0f, 2);
+    model.AddAnimationLodTier(100.0f, 0.5f, 1);
+
+    AnimationState@ state = model.AddAnimationState(cache.GetResource("Animation", "Models/Jack_Walk.ani"));
+    state.weight = 1.0f;
+    state.time = 0.5f;
+    return model;
+}
+
+void HandlePostRenderUpdate(StringHash eventType, VariantMap& eventData)
+{
+    // At the first tier's distance the first tier is used
+    if (atThreshold.animationLodTier != 0)
+        log.Error("Expected tier 0 at the first tier's distance, got " + atThreshold.animationLodTier);
+
+    // Just below the first tier's distance no tier is used
+    if (belowThreshold.animationLodTier != M_MAX_UNSIGNED)
+        log.Error("Expected no tier below the first tier's distance, got " + belowThreshold.animationLodTier);
+
+    engine.Exit();
+}